@@ -0,0 +1,186 @@
+#include "benchmark.h"
+
+#include "../src/asset/asset_manager.h"
+#include "../src/asset/asset_pack.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr std::size_t assetCount = 1024;
+    constexpr std::size_t assetSize  = 4096;
+
+
+
+    // Writes every asset both as a loose file and into a pack, and deletes them again
+    class AssetFiles
+    {
+    public:
+
+        AssetFiles()
+        {
+            m_directory = std::filesystem::temp_directory_path() / "cedar_asset_bench";
+            std::filesystem::create_directories(m_directory);
+
+            std::vector<std::byte>         data(assetSize);
+            Cedar::Asset::AssetPackBuilder builder;
+
+            for (std::size_t i = 0; i < assetCount; i++)
+            {
+                for (std::size_t j = 0; j < assetSize; j++)
+                    data[j] = static_cast<std::byte>(i + j);
+
+                names.push_back("textures/asset_" + std::to_string(i) + ".bin");
+                paths.push_back(m_directory / ("asset_" + std::to_string(i) + ".bin"));
+
+                std::ofstream(paths.back(), std::ios::binary).write(reinterpret_cast<const char*>(data.data()), assetSize);
+                builder.add(names.back(), data);
+            }
+
+            packPath = m_directory / "assets.pak";
+            builder.write(packPath);
+        }
+
+        ~AssetFiles()
+        {
+            std::error_code error;
+            std::filesystem::remove_all(m_directory, error);
+        }
+
+
+        std::vector<std::string>           names;
+        std::vector<std::filesystem::path> paths;
+        std::filesystem::path              packPath;
+
+    private:
+
+        std::filesystem::path m_directory;
+    };
+
+
+
+    void packLookup(Cedar::Bench::State& state)
+    {
+        AssetFiles              files;
+        Cedar::Asset::AssetPack pack(files.packPath);
+
+        for (auto _ : state)
+        {
+            for (const std::string& name : files.names)
+            {
+                std::span<const std::byte> data;
+                bool                       found = pack.tryGet(name, data);
+
+                Cedar::Bench::doNotOptimize(found);
+                Cedar::Bench::doNotOptimize(data);
+            }
+        }
+
+        state.setItemsProcessed(state.getIterations() * assetCount);
+    }
+
+
+
+    // Both read every byte, so the pack pays for its page faults like the files do for
+    // their reads
+    void packRead(Cedar::Bench::State& state)
+    {
+        AssetFiles files;
+
+        for (auto _ : state)
+        {
+            Cedar::Asset::AssetPack pack(files.packPath);
+            std::uint32_t           sum = 0;
+
+            for (const std::string& name : files.names)
+            {
+                for (std::byte byte : pack.get(name))
+                    sum += static_cast<std::uint32_t>(byte);
+            }
+
+            Cedar::Bench::doNotOptimize(sum);
+        }
+
+        state.setItemsProcessed(state.getIterations() * assetCount);
+    }
+
+
+
+    void fileRead(Cedar::Bench::State& state)
+    {
+        AssetFiles             files;
+        std::vector<std::byte> data(assetSize);
+
+        for (auto _ : state)
+        {
+            std::uint32_t sum = 0;
+
+            for (const std::filesystem::path& path : files.paths)
+            {
+                std::ifstream file(path, std::ios::binary);
+                file.read(reinterpret_cast<char*>(data.data()), assetSize);
+
+                for (std::byte byte : data)
+                    sum += static_cast<std::uint32_t>(byte);
+            }
+
+            Cedar::Bench::doNotOptimize(sum);
+        }
+
+        state.setItemsProcessed(state.getIterations() * assetCount);
+    }
+
+
+
+    // Every asset is resident, so this is the cost of a cache hit and a handle
+    void managerLoadResident(Cedar::Bench::State& state)
+    {
+        AssetFiles                             files;
+        Cedar::Asset::AssetManager             manager(files.paths[0].parent_path(), assetCount * assetSize);
+        std::vector<std::string>               names;
+        std::vector<Cedar::Asset::AssetHandle> handles;
+
+        for (const std::filesystem::path& path : files.paths)
+        {
+            names.push_back(path.filename().string());
+            handles.push_back(manager.load(names.back()));
+        }
+
+        auto isLoaded = [](const Cedar::Asset::AssetHandle& handle) { return handle.isLoaded(); };
+
+        while (!std::all_of(handles.begin(), handles.end(), isLoaded))
+        {
+            manager.update();
+            std::this_thread::yield();
+        }
+
+        for (auto _ : state)
+        {
+            for (const std::string& name : names)
+            {
+                Cedar::Asset::AssetHandle handle = manager.load(name);
+                Cedar::Bench::doNotOptimize(handle);
+            }
+        }
+
+        handles.clear();
+        state.setItemsProcessed(state.getIterations() * assetCount);
+    }
+}
+
+
+
+CEDAR_BENCHMARK("Asset pack lookup 1024 assets", packLookup);
+CEDAR_BENCHMARK("Asset pack open and read 1024 x 4 KB", packRead);
+CEDAR_BENCHMARK("Asset files open and read 1024 x 4 KB", fileRead);
+CEDAR_BENCHMARK("AssetManager::load 1024 resident assets", managerLoadResident);
\ No newline at end of file
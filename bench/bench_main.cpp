@@ -0,0 +1,79 @@
+//
+// Entry point of the benchmark executable.
+//
+// Usage: cedar-bench [--filter <substring>] [--repetitions <count>] [--warmup <count>]
+//                    [--min-time <milliseconds>] [--json <path>]
+//
+
+#include "benchmark.h"
+
+#include "../src/io/log.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        Cedar::Bench::Options options;
+        std::string jsonPath;
+
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view arg = argv[i];
+
+            if (i + 1 >= argc)
+            {
+                std::fprintf(stderr, "Missing value for argument \"%s\"\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+
+            if (arg == "--filter")
+                options.filter = argv[++i];
+            else if (arg == "--repetitions")
+                options.repetitions = std::stoul(argv[++i]);
+            else if (arg == "--warmup")
+                options.warmupRepetitions = std::stoul(argv[++i]);
+            else if (arg == "--min-time")
+                options.minRepetitionTime = std::stoull(argv[++i]) * 1'000'000;
+            else if (arg == "--json")
+                jsonPath = argv[++i];
+            else
+            {
+                std::fprintf(stderr, "Unknown argument \"%s\"\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        }
+
+        if (options.repetitions == 0)
+            options.repetitions = 1;
+
+        std::vector<Cedar::Bench::Result> results = Cedar::Bench::runBenchmarks(options);
+
+        if (!jsonPath.empty())
+        {
+            std::ofstream file(jsonPath);
+            file << Cedar::Bench::resultsToJson(results);
+
+            if (!file)
+            {
+                std::fprintf(stderr, "Failed to write \"%s\"\n", jsonPath.c_str());
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        Cedar::Log::fatal(e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,276 @@
+#include "benchmark.h"
+
+#include "../src/debug/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+
+namespace
+{
+    struct Benchmark;
+
+
+
+    struct Benchmark
+    {
+        std::string                 name;
+        Cedar::Bench::BenchmarkFunc function;
+    };
+
+
+
+    std::vector<Benchmark>& getBenchmarks();
+
+    std::uint64_t calibrateIterations(const Benchmark& benchmark, std::uint64_t minRepetitionTime);
+
+    Cedar::Bench::Result runBenchmark(const Benchmark& benchmark, const Cedar::Bench::Options& options);
+
+    std::string escapeJsonString(std::string_view str);
+
+
+
+    // Function-local static so registration from other translation units' static
+    // initializers doesn't depend on initialization order.
+    std::vector<Benchmark>& getBenchmarks()
+    {
+        static std::vector<Benchmark> benchmarks;
+        return benchmarks;
+    }
+
+
+
+    std::uint64_t calibrateIterations(const Benchmark& benchmark, std::uint64_t minRepetitionTime)
+    {
+        std::uint64_t iterations = 1;
+
+        while (true)
+        {
+            Cedar::Bench::State state(iterations);
+            benchmark.function(state);
+
+            std::uint64_t elapsed = std::max<std::uint64_t>(state.getElapsedTime(), 1);
+
+            if (elapsed >= minRepetitionTime)
+                return iterations;
+
+            // Aim slightly past the target, but don't grow by more than 10x per step in
+            // case the first iterations were unrepresentatively fast
+            double scale = std::min(10.0, 1.4 * minRepetitionTime / elapsed);
+            iterations   = std::max(iterations + 1, static_cast<std::uint64_t>(iterations * scale));
+        }
+    }
+
+
+
+    Cedar::Bench::Result runBenchmark(const Benchmark& benchmark, const Cedar::Bench::Options& options)
+    {
+        std::uint64_t iterations = calibrateIterations(benchmark, options.minRepetitionTime);
+
+        for (std::size_t i = 0; i < options.warmupRepetitions; i++)
+        {
+            Cedar::Bench::State state(iterations);
+            benchmark.function(state);
+        }
+
+        std::vector<double> times;
+        double itemsPerSecond = 0.0;
+
+        for (std::size_t i = 0; i < options.repetitions; i++)
+        {
+            Cedar::Bench::State state(iterations);
+            benchmark.function(state);
+
+            double elapsed = static_cast<double>(std::max<std::uint64_t>(state.getElapsedTime(), 1));
+
+            times.push_back(elapsed / iterations);
+            itemsPerSecond += state.getItemsProcessed() * 1e9 / elapsed;
+        }
+
+        Cedar::Bench::Result result;
+        result.name           = benchmark.name;
+        result.iterations     = iterations;
+        result.repetitions    = times.size();
+        result.itemsPerSecond = itemsPerSecond / times.size();
+
+        std::sort(times.begin(), times.end());
+
+        double sum = 0.0;
+
+        for (double time : times)
+            sum += time;
+
+        result.mean   = sum / times.size();
+        result.min    = times.front();
+        result.max    = times.back();
+        result.median = (times.size() % 2 == 1) ? times[times.size() / 2]
+                                                : (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2.0;
+
+        double variance = 0.0;
+
+        for (double time : times)
+            variance += (time - result.mean) * (time - result.mean);
+
+        result.standardDeviation = (times.size() > 1) ? std::sqrt(variance / (times.size() - 1)) : 0.0;
+
+        return result;
+    }
+
+
+
+    std::string escapeJsonString(std::string_view str)
+    {
+        std::string result;
+
+        for (char character : str)
+        {
+            if (character == '"' || character == '\\')
+                result += '\\';
+
+            result += character;
+        }
+
+        return result;
+    }
+}
+
+
+
+namespace Cedar::Bench
+{
+    void State::startTimer()
+    {
+        m_begin = Profiler::getTimestamp();
+    }
+
+
+
+    void State::stopTimer()
+    {
+        m_end = Profiler::getTimestamp();
+    }
+
+
+
+    bool registerBenchmark(std::string_view name, BenchmarkFunc function)
+    {
+        getBenchmarks().push_back({ std::string(name), function });
+        return true;
+    }
+
+
+
+    std::vector<Result> runBenchmarks(const Options& options)
+    {
+        std::vector<Result> results;
+
+        std::printf("%-48s %14s %14s %10s %14s %16s\n", "Benchmark", "Mean", "Median", "StdDev %", "Iterations", "Items/s");
+        std::printf("%s\n", std::string(121, '-').c_str());
+        std::fflush(stdout);
+
+        for (const Benchmark& benchmark : getBenchmarks())
+        {
+            if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos)
+                continue;
+
+            Result result = runBenchmark(benchmark, options);
+
+            std::string itemsPerSecond = (result.itemsPerSecond > 0.0) ? std::format("{:.4e}", result.itemsPerSecond) : "-";
+
+            std::printf("%-48s %11.2f ns %11.2f ns %9.2f%% %14llu %16s\n",
+                        result.name.c_str(), result.mean, result.median,
+                        (result.mean > 0.0) ? 100.0 * result.standardDeviation / result.mean : 0.0,
+                        static_cast<unsigned long long>(result.iterations),
+                        itemsPerSecond.c_str());
+            std::fflush(stdout);
+
+            results.push_back(result);
+        }
+
+        return results;
+    }
+
+
+
+    std::string resultsToJson(const std::vector<Result>& results)
+    {
+        std::string json = "{\n  \"benchmarks\": [";
+
+        for (std::size_t i = 0; i < results.size(); i++)
+        {
+            const Result& result = results[i];
+
+            json += std::format("{}\n    {{\"name\": \"{}\", \"iterations\": {}, \"repetitions\": {}, "
+                                "\"mean_ns\": {:.3f}, \"median_ns\": {:.3f}, \"stddev_ns\": {:.3f}, "
+                                "\"min_ns\": {:.3f}, \"max_ns\": {:.3f}, \"items_per_second\": {:.3f}}}",
+                                (i == 0) ? "" : ",",
+                                escapeJsonString(result.name), result.iterations, result.repetitions,
+                                result.mean, result.median, result.standardDeviation,
+                                result.min, result.max, result.itemsPerSecond);
+        }
+
+        json += "\n  ]\n}\n";
+
+        return json;
+    }
+}
+
+
+
+// OS-specific implementation
+#if defined(CEDAR_OS_WINDOWS) // vvv Windows vvv
+
+namespace Cedar::Bench
+{
+    StdoutSuppressor::StdoutSuppressor() {}
+
+    StdoutSuppressor::~StdoutSuppressor() {}
+}
+
+#elif defined(CEDAR_OS_LINUX) // vvv Linux vvv // ^^^ Windows ^^^
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+
+namespace Cedar::Bench
+{
+    StdoutSuppressor::StdoutSuppressor()
+    {
+        std::fflush(stdout);
+
+        int nullDevice = ::open("/dev/null", O_WRONLY);
+
+        if (nullDevice < 0)
+            return;
+
+        m_originalStdout = ::dup(STDOUT_FILENO);
+        (void)::dup2(nullDevice, STDOUT_FILENO);
+        (void)::close(nullDevice);
+    }
+
+
+
+    StdoutSuppressor::~StdoutSuppressor()
+    {
+        if (m_originalStdout < 0)
+            return;
+
+        std::fflush(stdout);
+
+        (void)::dup2(m_originalStdout, STDOUT_FILENO);
+        (void)::close(m_originalStdout);
+    }
+}
+
+#endif // ^^^ Linux ^^^
+// OS-specific implementation
\ No newline at end of file
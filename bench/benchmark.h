@@ -0,0 +1,297 @@
+//
+// Micro-benchmark framework.
+//
+// Benchmarks are free functions taking a State and timing the body of a range-based for
+// loop over it:
+//
+//     void logMessageFiltered(Cedar::Bench::State& state)
+//     {
+//         for (auto _ : state)
+//             Cedar::Log::trace("filtered");
+//     }
+//
+//     CEDAR_BENCHMARK("Log::message (filtered)", logMessageFiltered);
+//
+// The runner picks an iteration count that makes one repetition last at least the
+// minimum repetition time, runs warmup repetitions, then reports the mean, median,
+// standard deviation, minimum and maximum time per iteration over the measured
+// repetitions. Anything before the loop is setup and isn't timed.
+//
+
+#ifndef CEDAR_BENCH_BENCHMARK_H
+#define CEDAR_BENCH_BENCHMARK_H
+
+#include "../src/core.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(CEDAR_COMPILER_MSVC)
+    #include <intrin.h>
+#endif
+
+
+
+namespace Cedar::Bench
+{
+    class State;
+
+    struct Options;
+
+    struct Result;
+
+    class StdoutSuppressor;
+
+
+
+    typedef void (*BenchmarkFunc)(State& state);
+
+
+
+    class State
+    {
+    public:
+
+        class Iterator;
+
+
+        inline State(std::uint64_t iterations) : m_iterations(iterations) {}
+
+
+        inline Iterator begin();
+
+        inline Iterator end();
+
+
+        inline std::uint64_t getIterations() const;
+
+        // Elapsed time of the timed loop in nanoseconds.
+        inline std::uint64_t getElapsedTime() const;
+
+        // Total number of items (bytes, triangles, operations, ...) processed by the
+        // whole loop. Reported as items per second.
+        inline void setItemsProcessed(std::uint64_t items);
+
+        inline std::uint64_t getItemsProcessed() const;
+
+    private:
+
+        std::uint64_t m_iterations;
+        std::uint64_t m_begin          = 0;
+        std::uint64_t m_end            = 0;
+        std::uint64_t m_itemsProcessed = 0;
+
+
+        void startTimer();
+
+        void stopTimer();
+    };
+
+
+
+    class State::Iterator
+    {
+    public:
+
+        // Has a user provided destructor so "for (auto _ : state)" doesn't trigger unused
+        // variable warnings
+        struct Value
+        {
+            inline ~Value() {}
+        };
+
+
+        inline Iterator(State* state, std::uint64_t remaining) : m_state(state), m_remaining(remaining) {}
+
+
+        inline Value operator*() const { return Value(); }
+
+        inline Iterator& operator++();
+
+        inline bool operator!=(const Iterator& other) const;
+
+    private:
+
+        State*        m_state;
+        std::uint64_t m_remaining;
+    };
+
+
+
+    struct Options
+    {
+        std::string   filter;                        // Only run benchmarks whose name contains this
+        std::uint64_t minRepetitionTime = 20'000'000; // Nanoseconds
+        std::size_t   warmupRepetitions = 2;
+        std::size_t   repetitions       = 10;
+    };
+
+
+
+    struct Result
+    {
+        std::string   name;
+        std::uint64_t iterations;  // Per repetition
+        std::size_t   repetitions;
+
+        // Nanoseconds per iteration
+        double mean;
+        double median;
+        double standardDeviation;
+        double min;
+        double max;
+
+        double itemsPerSecond; // 0 if the benchmark doesn't report processed items
+    };
+
+
+
+    // Redirects standard output to the null device for as long as it's alive, so
+    // benchmarks of code that writes to the terminal don't flood it. Only implemented on
+    // Linux, output is left alone on other platforms.
+    class StdoutSuppressor
+    {
+    public:
+
+        StdoutSuppressor();
+
+        ~StdoutSuppressor();
+
+
+        StdoutSuppressor(const StdoutSuppressor&) = delete;
+
+        StdoutSuppressor& operator=(const StdoutSuppressor&) = delete;
+
+    private:
+
+        int m_originalStdout = -1;
+    };
+
+
+
+    bool registerBenchmark(std::string_view name, BenchmarkFunc function);
+
+    std::vector<Result> runBenchmarks(const Options& options);
+
+    std::string resultsToJson(const std::vector<Result>& results);
+
+
+
+    // Forces the compiler to assume value is read and may be modified, so computing it
+    // can't be optimized away.
+    template <typename T>
+    CEDAR_FORCE_INLINE void doNotOptimize(T& value);
+
+    // Forces the compiler to assume all memory may have been read or written.
+    CEDAR_FORCE_INLINE void clobberMemory();
+
+
+
+    // vvv State function definitions vvv
+
+    inline State::Iterator State::begin()
+    {
+        startTimer();
+        return Iterator(this, m_iterations);
+    }
+
+
+
+    inline State::Iterator State::end()
+    {
+        return Iterator(this, 0);
+    }
+
+
+
+    inline std::uint64_t State::getIterations() const
+    {
+        return m_iterations;
+    }
+
+
+
+    inline std::uint64_t State::getElapsedTime() const
+    {
+        return m_end - m_begin;
+    }
+
+
+
+    inline void State::setItemsProcessed(std::uint64_t items)
+    {
+        m_itemsProcessed = items;
+    }
+
+
+
+    inline std::uint64_t State::getItemsProcessed() const
+    {
+        return m_itemsProcessed;
+    }
+
+
+
+    inline State::Iterator& State::Iterator::operator++()
+    {
+        m_remaining--;
+        return *this;
+    }
+
+
+
+    inline bool State::Iterator::operator!=(const Iterator& other) const
+    {
+        if (m_remaining != 0)
+            return true;
+
+        m_state->stopTimer();
+        return false;
+    }
+
+    // ^^^ State function definitions ^^^
+
+
+
+#if defined(CEDAR_COMPILER_MSVC)
+
+    template <typename T>
+    CEDAR_FORCE_INLINE void doNotOptimize(T& value)
+    {
+        // MSVC has no inline assembly on x64, escaping the address through a volatile
+        // pointer has the same effect
+        static const void* volatile sink;
+        sink = &value;
+        _ReadWriteBarrier();
+    }
+
+    CEDAR_FORCE_INLINE void clobberMemory()
+    {
+        _ReadWriteBarrier();
+    }
+
+#else
+
+    template <typename T>
+    CEDAR_FORCE_INLINE void doNotOptimize(T& value)
+    {
+        asm volatile("" : "+m,r"(value) : : "memory");
+    }
+
+    CEDAR_FORCE_INLINE void clobberMemory()
+    {
+        asm volatile("" : : : "memory");
+    }
+
+#endif
+}
+
+
+
+#define CEDAR_BENCHMARK(name, function) \
+    static const bool CEDAR_CONCAT_MACRO(cedarBenchmarkRegistered, __LINE__) = Cedar::Bench::registerBenchmark(name, function)
+
+#endif // CEDAR_BENCH_BENCHMARK_H
\ No newline at end of file
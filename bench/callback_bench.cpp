@@ -0,0 +1,87 @@
+#include "benchmark.h"
+
+#include "../src/callback.h"
+
+#include <cstdint>
+
+
+
+namespace
+{
+    std::uint64_t g_counter = 0;
+
+
+
+    void increment(std::uint64_t amount)
+    {
+        g_counter += amount;
+    }
+
+
+
+    std::uint64_t add(std::uint64_t a, std::uint64_t b)
+    {
+        return a + b;
+    }
+
+
+
+    void functionPointerCall(Cedar::Bench::State& state)
+    {
+        void (*function)(std::uint64_t) = increment;
+        Cedar::Bench::doNotOptimize(function);
+
+        for (auto _ : state)
+            function(1);
+
+        Cedar::Bench::doNotOptimize(g_counter);
+    }
+
+
+
+    void callbackCall(Cedar::Bench::State& state)
+    {
+        Cedar::Callback<void (*)(std::uint64_t)> callback(increment);
+        Cedar::Bench::doNotOptimize(callback);
+
+        for (auto _ : state)
+            callback.call(1);
+
+        Cedar::Bench::doNotOptimize(g_counter);
+    }
+
+
+
+    void callbackTryCall(Cedar::Bench::State& state)
+    {
+        Cedar::Callback<void (*)(std::uint64_t)> callback(increment);
+        Cedar::Bench::doNotOptimize(callback);
+
+        for (auto _ : state)
+            (void)callback.tryCall(1);
+
+        Cedar::Bench::doNotOptimize(g_counter);
+    }
+
+
+
+    void callbackCallWithReturn(Cedar::Bench::State& state)
+    {
+        Cedar::Callback<std::uint64_t (*)(std::uint64_t, std::uint64_t)> callback(add);
+        Cedar::Bench::doNotOptimize(callback);
+
+        std::uint64_t sum = 0;
+
+        for (auto _ : state)
+            sum = callback.call(sum, 1);
+
+        Cedar::Bench::doNotOptimize(sum);
+    }
+}
+
+
+
+CEDAR_BENCHMARK("Function pointer call", functionPointerCall);
+CEDAR_BENCHMARK("Callback::call", callbackCall);
+CEDAR_BENCHMARK("Callback::tryCall", callbackTryCall);
+CEDAR_BENCHMARK("Callback::call (with return value)", callbackCallWithReturn);
@@ -0,0 +1,267 @@
+#include "benchmark.h"
+
+#include "../src/containers/flat_hash_map.h"
+#include "../src/containers/ring_buffer.h"
+#include "../src/containers/small_vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr std::size_t keyCount  = 100000;
+    constexpr std::size_t listCount = 10000;
+
+
+
+    std::vector<std::uint64_t> makeKeys(std::uint32_t seed)
+    {
+        std::mt19937_64            random(seed);
+        std::vector<std::uint64_t> keys(keyCount);
+
+        for (std::uint64_t& key : keys)
+            key = random();
+
+        return keys;
+    }
+
+
+
+    std::vector<std::string> makeNames()
+    {
+        std::vector<std::string> names(keyCount);
+
+        for (std::size_t i = 0; i < keyCount; i++)
+            names[i] = "textures/level_" + std::to_string(i % 64) + "/sprite_" + std::to_string(i) + ".png";
+
+        return names;
+    }
+
+
+
+    struct FlatMap
+    {
+        template <typename TKey>
+        using Type = Cedar::FlatHashMap<TKey, std::uint64_t>;
+
+        template <typename TMap, typename TKey>
+        static inline void insert(TMap& map, const TKey& key, std::uint64_t value) { map.tryEmplace(key, value); }
+    };
+
+
+
+    struct StdMap
+    {
+        template <typename TKey>
+        using Type = std::unordered_map<TKey, std::uint64_t>;
+
+        template <typename TMap, typename TKey>
+        static inline void insert(TMap& map, const TKey& key, std::uint64_t value) { map.try_emplace(key, value); }
+    };
+
+
+
+    // 100k random 64-bit keys into an empty map, growing as it goes.
+    template <typename TMap>
+    void mapInsert(Cedar::Bench::State& state)
+    {
+        std::vector<std::uint64_t> keys = makeKeys(1);
+
+        for (auto _ : state)
+        {
+            typename TMap::template Type<std::uint64_t> map;
+
+            for (std::uint64_t key : keys)
+                TMap::insert(map, key, key);
+
+            Cedar::Bench::doNotOptimize(map);
+        }
+
+        state.setItemsProcessed(state.getIterations() * keyCount);
+    }
+
+
+
+    // 100k asset path like strings into an empty map, so every growth moves them all.
+    template <typename TMap>
+    void mapInsertString(Cedar::Bench::State& state)
+    {
+        std::vector<std::string> names = makeNames();
+
+        for (auto _ : state)
+        {
+            typename TMap::template Type<std::string> map;
+
+            for (std::size_t i = 0; i < names.size(); i++)
+                TMap::insert(map, names[i], i);
+
+            Cedar::Bench::doNotOptimize(map);
+        }
+
+        state.setItemsProcessed(state.getIterations() * keyCount);
+    }
+
+
+
+    // 100k lookups of keys that are in the map, or that aren't.
+    template <typename TMap, bool THits>
+    void mapFind(Cedar::Bench::State& state)
+    {
+        std::vector<std::uint64_t> keys    = makeKeys(1);
+        std::vector<std::uint64_t> lookups = THits ? keys : makeKeys(2);
+
+        std::shuffle(lookups.begin(), lookups.end(), std::mt19937(3));
+
+        typename TMap::template Type<std::uint64_t> map;
+
+        for (std::uint64_t key : keys)
+            TMap::insert(map, key, key);
+
+        for (auto _ : state)
+        {
+            std::uint64_t found = 0;
+
+            for (std::uint64_t key : lookups)
+                found += map.find(key) != map.end();
+
+            Cedar::Bench::doNotOptimize(found);
+        }
+
+        state.setItemsProcessed(state.getIterations() * keyCount);
+    }
+
+
+
+    // 100k lookups of asset path like strings that are in the map.
+    template <typename TMap>
+    void mapFindString(Cedar::Bench::State& state)
+    {
+        std::vector<std::string> names   = makeNames();
+        std::vector<std::string> lookups = names;
+
+        std::shuffle(lookups.begin(), lookups.end(), std::mt19937(3));
+
+        typename TMap::template Type<std::string> map;
+
+        for (std::size_t i = 0; i < names.size(); i++)
+            TMap::insert(map, names[i], i);
+
+        for (auto _ : state)
+        {
+            std::uint64_t found = 0;
+
+            for (const std::string& name : lookups)
+                found += map.find(name) != map.end();
+
+            Cedar::Bench::doNotOptimize(found);
+        }
+
+        state.setItemsProcessed(state.getIterations() * keyCount);
+    }
+
+
+
+    // 10k lists of 1 to 8 elements built, summed and thrown away, as a per object scratch
+    // list would be.
+    template <typename TList>
+    void shortLists(Cedar::Bench::State& state)
+    {
+        std::mt19937              random(4);
+        std::vector<std::uint8_t> lengths(listCount);
+
+        for (std::uint8_t& length : lengths)
+            length = static_cast<std::uint8_t>(random() % 8 + 1);
+
+        for (auto _ : state)
+        {
+            std::uint64_t sum = 0;
+
+            for (std::uint8_t length : lengths)
+            {
+                TList list;
+
+                for (std::uint32_t i = 0; i < length; i++)
+                    list.push_back(i);
+
+                sum += std::accumulate(list.begin(), list.end(), std::uint64_t(0));
+            }
+
+            Cedar::Bench::doNotOptimize(sum);
+        }
+
+        state.setItemsProcessed(state.getIterations() * listCount);
+    }
+
+
+
+    // SmallVector's names differ from std::vector's.
+    struct SmallList : Cedar::SmallVector<std::uint32_t, 8>
+    {
+        inline void push_back(std::uint32_t value) { pushBack(value); }
+    };
+
+
+
+    // A queue of the last 256 values, pushed and popped 100k times.
+    template <typename TQueue>
+    void slidingWindow(Cedar::Bench::State& state)
+    {
+        for (auto _ : state)
+        {
+            TQueue        queue;
+            std::uint64_t sum = 0;
+
+            for (std::uint64_t i = 0; i < keyCount; i++)
+            {
+                if (queue.size() == 256)
+                {
+                    sum += queue.front();
+                    queue.pop_front();
+                }
+
+                queue.push_back(i);
+            }
+
+            Cedar::Bench::doNotOptimize(sum);
+        }
+
+        state.setItemsProcessed(state.getIterations() * keyCount);
+    }
+
+
+
+    struct RingQueue : Cedar::RingBuffer<std::uint64_t, 256>
+    {
+        inline std::size_t size() const { return getSize(); }
+
+        inline void push_back(std::uint64_t value) { pushBack(value); }
+
+        inline void pop_front() { popFront(); }
+    };
+}
+
+
+
+CEDAR_BENCHMARK("FlatHashMap insert 100k ints", mapInsert<FlatMap>);
+CEDAR_BENCHMARK("std::unordered_map insert 100k ints", mapInsert<StdMap>);
+CEDAR_BENCHMARK("FlatHashMap insert 100k strings", mapInsertString<FlatMap>);
+CEDAR_BENCHMARK("std::unordered_map insert 100k strings", mapInsertString<StdMap>);
+CEDAR_BENCHMARK("FlatHashMap find 100k ints (hits)", (mapFind<FlatMap, true>));
+CEDAR_BENCHMARK("std::unordered_map find 100k ints (hits)", (mapFind<StdMap, true>));
+CEDAR_BENCHMARK("FlatHashMap find 100k ints (misses)", (mapFind<FlatMap, false>));
+CEDAR_BENCHMARK("std::unordered_map find 100k ints (misses)", (mapFind<StdMap, false>));
+CEDAR_BENCHMARK("FlatHashMap find 100k strings", mapFindString<FlatMap>);
+CEDAR_BENCHMARK("std::unordered_map find 100k strings", mapFindString<StdMap>);
+CEDAR_BENCHMARK("SmallVector<uint32, 8> 10k short lists", shortLists<SmallList>);
+CEDAR_BENCHMARK("std::vector<uint32> 10k short lists", shortLists<std::vector<std::uint32_t>>);
+CEDAR_BENCHMARK("RingBuffer<uint64, 256> sliding window 100k", slidingWindow<RingQueue>);
+CEDAR_BENCHMARK("std::deque<uint64> sliding window 100k", slidingWindow<std::deque<std::uint64_t>>);
\ No newline at end of file
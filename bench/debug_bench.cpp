@@ -0,0 +1,62 @@
+#include "benchmark.h"
+
+#include "../src/debug/frame_stats.h"
+#include "../src/debug/profiler.h"
+
+#include <cstdint>
+
+
+
+namespace
+{
+    void profilerGetTimestamp(Cedar::Bench::State& state)
+    {
+        for (auto _ : state)
+        {
+            std::uint64_t timestamp = Cedar::Profiler::getTimestamp();
+            Cedar::Bench::doNotOptimize(timestamp);
+        }
+    }
+
+
+
+    void profilerScopedZone(Cedar::Bench::State& state)
+    {
+        std::uint64_t zoneCount = 0;
+
+        for (auto _ : state)
+        {
+            {
+                Cedar::Profiler::ScopedZone zone("Benchmark zone");
+            }
+
+            // Drain regularly so the thread buffer never fills up and drops zones. The
+            // amortized cost of draining is part of the measurement.
+            if ((++zoneCount & 0x3FF) == 0)
+                Cedar::Profiler::endFrame();
+        }
+
+        Cedar::Profiler::endFrame();
+    }
+
+
+
+    void frameStatsRecordFrame(Cedar::Bench::State& state)
+    {
+        std::uint64_t frameTime = 16'000'000;
+
+        for (auto _ : state)
+        {
+            Cedar::FrameStats::recordFrame(frameTime);
+            frameTime = (frameTime * 7 + 1'000'003) % 40'000'000;
+        }
+
+        Cedar::FrameStats::reset();
+    }
+}
+
+
+
+CEDAR_BENCHMARK("Profiler::getTimestamp", profilerGetTimestamp);
+CEDAR_BENCHMARK("Profiler::ScopedZone", profilerScopedZone);
+CEDAR_BENCHMARK("FrameStats::recordFrame", frameStatsRecordFrame);
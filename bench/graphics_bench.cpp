@@ -0,0 +1,104 @@
+#include "benchmark.h"
+
+#include "../src/graphics/dirty_region.h"
+#include "../src/graphics/rect.h"
+#include "../src/graphics/surface.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr Cedar::Size2D<int> frameSize = { 1920, 1080 };
+
+
+
+    // A frame of a mostly static tool UI: a blinking cursor, a few changed labels and a
+    // redrawn list row
+    Cedar::Graphics::DirtyRegion makeUiDamage()
+    {
+        Cedar::Graphics::DirtyRegion region(frameSize);
+
+        region.add({ { 412, 96 }, { 2, 18 } });
+        region.add({ { 24, 300 }, { 160, 20 } });
+        region.add({ { 184, 300 }, { 96, 20 } });
+        region.add({ { 24, 620 }, { 640, 22 } });
+        region.add({ { 1700, 1050 }, { 200, 24 } });
+
+        return region;
+    }
+
+
+
+    void copyFrame(Cedar::Bench::State& state, const Cedar::Graphics::DirtyRegion& region)
+    {
+        std::vector<Cedar::Graphics::Pixel> source(static_cast<std::size_t>(frameSize.width) * frameSize.height, 0xFF202020);
+        std::vector<Cedar::Graphics::Pixel> destination(source.size());
+
+        Cedar::Graphics::Surface sourceSurface      = { source.data(), frameSize, frameSize.width };
+        Cedar::Graphics::Surface destinationSurface = { destination.data(), frameSize, frameSize.width };
+
+        for (auto _ : state)
+        {
+            Cedar::Graphics::copyRegion(sourceSurface, destinationSurface, region);
+            Cedar::Bench::clobberMemory();
+        }
+
+        state.setItemsProcessed(state.getIterations() * region.getArea() * sizeof(Cedar::Graphics::Pixel));
+    }
+
+
+
+    void dirtyRegionAdd(Cedar::Bench::State& state)
+    {
+        constexpr std::size_t rectCount = 256;
+
+        std::vector<Cedar::Graphics::Rect> rects(rectCount);
+        std::uint32_t seed = 1;
+
+        for (Cedar::Graphics::Rect& rect : rects)
+        {
+            seed = seed * 1664525 + 1013904223;
+            rect = { { static_cast<int>(seed % frameSize.width), static_cast<int>((seed >> 11) % frameSize.height) },
+                     { static_cast<int>(seed >> 27) + 4, static_cast<int>((seed >> 22) % 32) + 4 } };
+        }
+
+        for (auto _ : state)
+        {
+            Cedar::Graphics::DirtyRegion region(frameSize);
+
+            for (const Cedar::Graphics::Rect& rect : rects)
+                region.add(rect);
+
+            Cedar::Bench::doNotOptimize(region);
+        }
+
+        state.setItemsProcessed(state.getIterations() * rectCount);
+    }
+
+
+
+    void copyFullFrame(Cedar::Bench::State& state)
+    {
+        Cedar::Graphics::DirtyRegion region(frameSize);
+        region.addAll();
+
+        copyFrame(state, region);
+    }
+
+
+
+    void copyUiDamage(Cedar::Bench::State& state)
+    {
+        copyFrame(state, makeUiDamage());
+    }
+}
+
+
+
+CEDAR_BENCHMARK("DirtyRegion::add (256 rects)", dirtyRegionAdd);
+CEDAR_BENCHMARK("copyRegion (full 1080p frame)", copyFullFrame);
+CEDAR_BENCHMARK("copyRegion (UI damage)", copyUiDamage);
\ No newline at end of file
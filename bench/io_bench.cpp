@@ -0,0 +1,192 @@
+#include "benchmark.h"
+
+#include "../src/io/file_io.h"
+#include "../src/io/log.h"
+#include "../src/io/terminal.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr std::size_t fileChunkCount = 256;
+    constexpr std::size_t fileChunkSize  = 64 * 1024;
+
+
+
+    std::filesystem::path makeBenchFile()
+    {
+        std::filesystem::path  path = std::filesystem::temp_directory_path() / "cedar_io_bench.bin";
+        std::vector<std::byte> data(fileChunkCount * fileChunkSize, std::byte(0x5A));
+
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+        return path;
+    }
+
+
+
+    void logMessageFiltered(Cedar::Bench::State& state)
+    {
+        Cedar::Log::Level originalLevel = Cedar::Log::getMinLevel();
+        Cedar::Log::setMinLevel(Cedar::Log::Level::Info);
+
+        for (auto _ : state)
+            Cedar::Log::trace("Filtered log message");
+
+        Cedar::Log::setMinLevel(originalLevel);
+    }
+
+
+
+    void logMessageWritten(Cedar::Bench::State& state)
+    {
+        Cedar::Bench::StdoutSuppressor suppressor;
+
+        Cedar::Log::Level originalLevel = Cedar::Log::getMinLevel();
+        Cedar::Log::setMinLevel(Cedar::Log::Level::Info);
+
+        for (auto _ : state)
+            Cedar::Log::info("Written log message");
+
+        Cedar::Log::setMinLevel(originalLevel);
+    }
+
+
+
+    // A category enabled at Info, so the trace message is skipped after one atomic load.
+    void logCategoryFiltered(Cedar::Bench::State& state)
+    {
+        Cedar::Log::windowCategory.setLevel(Cedar::Log::Level::Info);
+
+        for (auto _ : state)
+            CEDAR_LOG(Cedar::Log::windowCategory, Trace, "Filtered log message");
+
+        Cedar::Log::windowCategory.resetLevel();
+    }
+
+
+
+    // A message repeated past its category's limit, so it's dropped before being formatted.
+    void logMessageDropped(Cedar::Bench::State& state)
+    {
+        Cedar::Bench::StdoutSuppressor suppressor;
+
+        Cedar::Log::windowCategory.setLevel(Cedar::Log::Level::Info);
+        Cedar::Log::windowCategory.setRepeatLimit(1, 60'000'000'000);
+
+        for (auto _ : state)
+            CEDAR_LOG(Cedar::Log::windowCategory, Info, "Repeated log message");
+
+        Cedar::Log::windowCategory.setRepeatLimit(0);
+        Cedar::Log::windowCategory.resetLevel();
+    }
+
+
+
+    void terminalWriteString(Cedar::Bench::State& state)
+    {
+        Cedar::Bench::StdoutSuppressor suppressor;
+
+        for (auto _ : state)
+            Cedar::Terminal::write("The quick brown fox jumps over the lazy dog");
+
+        state.setItemsProcessed(state.getIterations() * 43);
+    }
+
+
+
+    void terminalWriteColoredString(Cedar::Bench::State& state)
+    {
+        Cedar::Bench::StdoutSuppressor suppressor;
+
+        for (auto _ : state)
+            Cedar::Terminal::write("The quick brown fox jumps over the lazy dog", Cedar::Terminal::Color::Green, Cedar::Terminal::Color::Black);
+
+        state.setItemsProcessed(state.getIterations() * 43);
+    }
+
+
+
+    void terminalWriteCharacter(Cedar::Bench::State& state)
+    {
+        Cedar::Bench::StdoutSuppressor suppressor;
+
+        for (auto _ : state)
+            Cedar::Terminal::write('x');
+    }
+
+
+
+    // Every chunk is queued before waiting, so the backend gets the whole batch at once
+    void fileReadAsync(Cedar::Bench::State& state)
+    {
+        std::filesystem::path               path = makeBenchFile();
+        std::vector<std::byte>              buffer(fileChunkCount * fileChunkSize);
+        std::vector<Cedar::FileIO::Request> requests(fileChunkCount);
+
+        {
+            Cedar::FileIO::File file(path, Cedar::FileIO::OpenMode::Read);
+
+            for (auto _ : state)
+            {
+                for (std::size_t i = 0; i < fileChunkCount; i++)
+                {
+                    Cedar::FileIO::read(file, i * fileChunkSize, std::span(buffer).subspan(i * fileChunkSize, fileChunkSize),
+                                        requests[i]);
+                }
+
+                for (const Cedar::FileIO::Request& request : requests)
+                    Cedar::FileIO::wait(request);
+            }
+        }
+
+        std::filesystem::remove(path);
+        state.setItemsProcessed(state.getIterations() * fileChunkCount);
+    }
+
+
+
+    void fileReadBlocking(Cedar::Bench::State& state)
+    {
+        std::filesystem::path  path = makeBenchFile();
+        std::vector<std::byte> buffer(fileChunkCount * fileChunkSize);
+
+        {
+            std::ifstream file(path, std::ios::binary);
+
+            for (auto _ : state)
+            {
+                for (std::size_t i = 0; i < fileChunkCount; i++)
+                {
+                    file.seekg(static_cast<std::streamoff>(i * fileChunkSize));
+                    file.read(reinterpret_cast<char*>(buffer.data() + i * fileChunkSize), fileChunkSize);
+                }
+
+                Cedar::Bench::clobberMemory();
+            }
+        }
+
+        std::filesystem::remove(path);
+        state.setItemsProcessed(state.getIterations() * fileChunkCount);
+    }
+}
+
+
+
+CEDAR_BENCHMARK("Log::message (filtered)", logMessageFiltered);
+CEDAR_BENCHMARK("Log::message (written)", logMessageWritten);
+CEDAR_BENCHMARK("CEDAR_LOG (category filtered)", logCategoryFiltered);
+CEDAR_BENCHMARK("CEDAR_LOG (repeat dropped)", logMessageDropped);
+CEDAR_BENCHMARK("Terminal::write (string)", terminalWriteString);
+CEDAR_BENCHMARK("Terminal::write (colored string)", terminalWriteColoredString);
+CEDAR_BENCHMARK("Terminal::write (character)", terminalWriteCharacter);
+CEDAR_BENCHMARK("FileIO::read 256 x 64 KB (batched)", fileReadAsync);
+CEDAR_BENCHMARK("std::ifstream::read 256 x 64 KB", fileReadBlocking);
@@ -0,0 +1,85 @@
+#include "benchmark.h"
+
+#include "../src/math.h"
+
+#include <cstddef>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr std::size_t elementCount = 4096;
+
+
+
+    template <typename T>
+    void compareElements(Cedar::Bench::State& state, const std::vector<T>& a, const std::vector<T>& b)
+    {
+        for (auto _ : state)
+        {
+            std::size_t equalCount = 0;
+
+            for (std::size_t i = 0; i < elementCount; i++)
+                equalCount += (a[i] == b[i]) ? 1 : 0;
+
+            Cedar::Bench::doNotOptimize(equalCount);
+        }
+
+        state.setItemsProcessed(state.getIterations() * elementCount);
+    }
+
+
+
+    void point2DEquality(Cedar::Bench::State& state)
+    {
+        std::vector<Cedar::Point2D<int>> a(elementCount);
+        std::vector<Cedar::Point2D<int>> b(elementCount);
+
+        for (std::size_t i = 0; i < elementCount; i++)
+        {
+            a[i] = { static_cast<int>(i), static_cast<int>(i * 3) };
+            b[i] = { static_cast<int>(i), static_cast<int>(i * 3 + i % 2) };
+        }
+
+        compareElements(state, a, b);
+    }
+
+
+
+    void size2DEquality(Cedar::Bench::State& state)
+    {
+        std::vector<Cedar::Size2D<int>> a(elementCount);
+        std::vector<Cedar::Size2D<int>> b(elementCount);
+
+        for (std::size_t i = 0; i < elementCount; i++)
+        {
+            a[i] = { static_cast<int>(i), static_cast<int>(i * 2) };
+            b[i] = { static_cast<int>(i + i % 3), static_cast<int>(i * 2) };
+        }
+
+        compareElements(state, a, b);
+    }
+
+
+
+    void vector3DEquality(Cedar::Bench::State& state)
+    {
+        std::vector<Cedar::Vector3D<float>> a(elementCount);
+        std::vector<Cedar::Vector3D<float>> b(elementCount);
+
+        for (std::size_t i = 0; i < elementCount; i++)
+        {
+            a[i] = { i * 0.5f, i * 1.5f, i * 2.5f };
+            b[i] = { i * 0.5f, i * 1.5f, i * 2.5f + (i % 4) };
+        }
+
+        compareElements(state, a, b);
+    }
+}
+
+
+
+CEDAR_BENCHMARK("Point2D<int> equality", point2DEquality);
+CEDAR_BENCHMARK("Size2D<int> equality", size2DEquality);
+CEDAR_BENCHMARK("Vector3D<float> equality", vector3DEquality);
@@ -0,0 +1,133 @@
+#include "benchmark.h"
+
+#include "../src/memory/memory_tracker.h"
+#include "../src/memory/pool_allocator.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr std::size_t churnThreadCount = 4;
+    constexpr std::size_t churnBatchSize   = 256;
+    constexpr std::size_t churnRounds      = 64;
+
+
+
+    struct Object
+    {
+        std::array<std::uint64_t, 8> data;
+    };
+
+
+
+    struct MallocAllocator
+    {
+        static inline Object* allocate() { return static_cast<Object*>(std::malloc(sizeof(Object))); }
+
+        static inline void deallocate(Object* object) { std::free(object); }
+    };
+
+
+
+    struct NewAllocator
+    {
+        static inline Object* allocate() { return new Object; }
+
+        static inline void deallocate(Object* object) { delete object; }
+    };
+
+
+
+    struct PoolAllocator
+    {
+        static inline Object* allocate() { return Cedar::Memory::ObjectPool<Object>::create(); }
+
+        static inline void deallocate(Object* object) { Cedar::Memory::ObjectPool<Object>::destroy(object); }
+    };
+
+
+
+    struct TrackedAllocator
+    {
+        static inline Object* allocate() { return static_cast<Object*>(Cedar::Memory::allocate(Cedar::Memory::Tag::User, sizeof(Object), alignof(Object))); }
+
+        static inline void deallocate(Object* object) { Cedar::Memory::deallocate(Cedar::Memory::Tag::User, object, sizeof(Object), alignof(Object)); }
+    };
+
+
+
+    // Allocates a batch, frees every other object, refills the holes and frees the rest,
+    // so the free lists don't simply return blocks in allocation order.
+    template <typename TAllocator>
+    void churn(std::size_t rounds)
+    {
+        std::array<Object*, churnBatchSize> objects;
+
+        for (std::size_t round = 0; round < rounds; round++)
+        {
+            for (Object*& object : objects)
+            {
+                object = TAllocator::allocate();
+                object->data[0] = round;
+            }
+
+            for (std::size_t i = 0; i < churnBatchSize; i += 2)
+                TAllocator::deallocate(objects[i]);
+
+            for (std::size_t i = 0; i < churnBatchSize; i += 2)
+                objects[i] = TAllocator::allocate();
+
+            Cedar::Bench::clobberMemory();
+
+            for (Object* object : objects)
+                TAllocator::deallocate(object);
+        }
+    }
+
+
+
+    template <typename TAllocator>
+    void singleThreadedChurn(Cedar::Bench::State& state)
+    {
+        for (auto _ : state)
+            churn<TAllocator>(1);
+
+        state.setItemsProcessed(state.getIterations() * churnBatchSize * 3 / 2);
+    }
+
+
+
+    template <typename TAllocator>
+    void multiThreadedChurn(Cedar::Bench::State& state)
+    {
+        for (auto _ : state)
+        {
+            std::vector<std::thread> threads;
+
+            for (std::size_t i = 0; i < churnThreadCount; i++)
+                threads.emplace_back(churn<TAllocator>, churnRounds);
+
+            for (std::thread& thread : threads)
+                thread.join();
+        }
+
+        state.setItemsProcessed(state.getIterations() * churnThreadCount * churnRounds * churnBatchSize * 3 / 2);
+    }
+}
+
+
+
+CEDAR_BENCHMARK("Churn 64B (malloc)", singleThreadedChurn<MallocAllocator>);
+CEDAR_BENCHMARK("Churn 64B (new)", singleThreadedChurn<NewAllocator>);
+CEDAR_BENCHMARK("Churn 64B (ObjectPool)", singleThreadedChurn<PoolAllocator>);
+CEDAR_BENCHMARK("Churn 64B (Memory::allocate)", singleThreadedChurn<TrackedAllocator>);
+CEDAR_BENCHMARK("Churn 64B x4 threads (malloc)", multiThreadedChurn<MallocAllocator>);
+CEDAR_BENCHMARK("Churn 64B x4 threads (new)", multiThreadedChurn<NewAllocator>);
+CEDAR_BENCHMARK("Churn 64B x4 threads (ObjectPool)", multiThreadedChurn<PoolAllocator>);
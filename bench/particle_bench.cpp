@@ -0,0 +1,140 @@
+#include "benchmark.h"
+
+#include "../src/graphics/particle_system.h"
+#include "../src/graphics/surface.h"
+#include "../src/jobs/job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr std::size_t particleCount = 100000;
+    constexpr float       timestep      = 1.0f / 60.0f;
+
+    constexpr Cedar::Graphics::ColorKey colorCurve[] = {
+        { 0.0f, Cedar::Graphics::makePixel(0xFF, 0xF0, 0x80) },
+        { 0.3f, Cedar::Graphics::makePixel(0xFF, 0x80, 0x20) },
+        { 1.0f, Cedar::Graphics::makePixel(0x40, 0x40, 0x40, 0x00) }
+    };
+
+
+
+    // 100k sparks living 0.5 to 2 seconds, topped back up every frame as they die.
+    void particleSystemUpdate(Cedar::Bench::State& state)
+    {
+        Cedar::Graphics::ParticleSystem particles(particleCount);
+
+        particles.setGravity({ 0.0f, 200.0f });
+        particles.setDrag(0.5f);
+        particles.setSizes(6.0f, 1.0f);
+        particles.setColorCurve(colorCurve);
+
+        Cedar::Graphics::ParticleEmission emission;
+        emission.position    = { 960.0f, 540.0f };
+        emission.radius      = 20.0f;
+        emission.direction   = -1.5707963f;
+        emission.spread      = 1.0f;
+        emission.minSpeed    = 100.0f;
+        emission.maxSpeed    = 400.0f;
+        emission.minLifetime = 0.5f;
+        emission.maxLifetime = 2.0f;
+
+        particles.emit(particleCount, emission);
+
+        // Starts the workers outside of the timed loop
+        (void)Cedar::Jobs::getWorkerCount();
+
+        for (auto _ : state)
+        {
+            particles.update(timestep);
+            particles.emit(particleCount - particles.getCount(), emission);
+
+            std::size_t count = particles.getCount();
+            Cedar::Bench::doNotOptimize(count);
+        }
+
+        state.setItemsProcessed(state.getIterations() * particleCount);
+    }
+
+
+
+    // The same simulation with a struct per particle, updated by a plain loop and erased with
+    // std::erase_if, to compare with.
+    void particleStructUpdate(Cedar::Bench::State& state)
+    {
+        struct Particle
+        {
+            float                  positionX;
+            float                  positionY;
+            float                  velocityX;
+            float                  velocityY;
+            float                  age;
+            float                  lifetime;
+            float                  size;
+            Cedar::Graphics::Pixel color;
+        };
+
+        Cedar::Graphics::Pixel colorTable[Cedar::Graphics::ParticleSystem::colorTableSize];
+
+        for (std::size_t i = 0; i < std::size(colorTable); i++)
+            colorTable[i] = Cedar::Graphics::makePixel(0xFF, static_cast<std::uint8_t>(i), 0x40);
+
+        std::mt19937                          random(42);
+        std::uniform_real_distribution<float> angles(-2.5707963f, -0.5707963f);
+        std::uniform_real_distribution<float> speeds(100.0f, 400.0f);
+        std::uniform_real_distribution<float> lifetimes(0.5f, 2.0f);
+
+        std::vector<Particle> particles;
+        particles.reserve(particleCount);
+
+        auto spawn = [&]() {
+            while (particles.size() < particleCount)
+            {
+                float angle = angles(random);
+                float speed = speeds(random);
+
+                particles.push_back({ 960.0f, 540.0f, speed * std::cos(angle), speed * std::sin(angle), 0.0f, lifetimes(random), 6.0f, colorTable[0] });
+            }
+        };
+
+        spawn();
+
+        for (auto _ : state)
+        {
+            for (Particle& particle : particles)
+            {
+                particle.velocityX  = particle.velocityX * (1.0f - 0.5f * timestep);
+                particle.velocityY  = particle.velocityY * (1.0f - 0.5f * timestep) + 200.0f * timestep;
+                particle.positionX += particle.velocityX * timestep;
+                particle.positionY += particle.velocityY * timestep;
+                particle.age       += timestep;
+
+                float life = std::min(particle.age / particle.lifetime, 1.0f);
+
+                particle.size  = 6.0f - 5.0f * life;
+                particle.color = colorTable[static_cast<std::size_t>(life * 255.0f)];
+            }
+
+            std::erase_if(particles, [](const Particle& particle) { return particle.age >= particle.lifetime; });
+
+            spawn();
+
+            Cedar::Bench::clobberMemory();
+        }
+
+        state.setItemsProcessed(state.getIterations() * particleCount);
+    }
+}
+
+
+
+CEDAR_BENCHMARK("ParticleSystem::update 100k particles", particleSystemUpdate);
+CEDAR_BENCHMARK("Particle structs update and erase_if 100k particles", particleStructUpdate);
\ No newline at end of file
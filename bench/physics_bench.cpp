@@ -0,0 +1,406 @@
+#include "benchmark.h"
+
+#include "../src/math/aabb.h"
+#include "../src/math/vector.h"
+#include "../src/physics/dynamic_aabb_tree.h"
+#include "../src/physics/physics_world_2d.h"
+#include "../src/physics/spatial_hash_grid.h"
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr std::size_t proxyCount = 10'000;
+    constexpr std::size_t queryCount = 1'000;
+    constexpr float       worldSize  = 1'000.0f;
+    constexpr float       maxSize    = 4.0f;
+    constexpr float       cellSize   = 4.0f;
+
+    constexpr std::size_t treeProxyCount = 100'000;
+    constexpr std::size_t rayCount       = 10'000;
+    constexpr std::size_t bruteRayCount  = 100;
+
+    constexpr std::size_t bodyCount     = 4'000;
+    constexpr float       containerSize = 80.0f;
+
+
+
+    // Boxes of up to maxSize spread over a square world, the density of a busy 2D scene
+    std::vector<Cedar::AABB2D<float>> makeBoxes(std::size_t count, unsigned int seed)
+    {
+        std::mt19937                          random(seed);
+        std::uniform_real_distribution<float> position(0.0f, worldSize);
+        std::uniform_real_distribution<float> size(0.5f, maxSize);
+
+        std::vector<Cedar::AABB2D<float>> boxes;
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            float x = position(random);
+            float y = position(random);
+
+            boxes.push_back({ { x, y }, { x + size(random), y + size(random) } });
+        }
+
+        return boxes;
+    }
+
+
+
+    // Boxes of up to maxSize spread over a cube the size of the world
+    std::vector<Cedar::AABB3D<float>> makeBoxes3D(std::size_t count, unsigned int seed)
+    {
+        std::mt19937                          random(seed);
+        std::uniform_real_distribution<float> position(0.0f, worldSize);
+        std::uniform_real_distribution<float> size(0.5f, maxSize);
+
+        std::vector<Cedar::AABB3D<float>> boxes;
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            Cedar::Vector3D<float> min = { position(random), position(random), position(random) };
+            boxes.push_back({ min, { min.x + size(random), min.y + size(random), min.z + size(random) } });
+        }
+
+        return boxes;
+    }
+
+
+
+    // Rays from random points in random directions, each crossing a third of the world
+    std::vector<Cedar::Physics::Ray> makeRays(std::size_t count, unsigned int seed)
+    {
+        std::mt19937                          random(seed);
+        std::uniform_real_distribution<float> position(0.0f, worldSize);
+        std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+        std::vector<Cedar::Physics::Ray> rays;
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            Cedar::Vector3D<float> d      = { direction(random), direction(random), direction(random) };
+            float                  length = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z) + 1e-6f;
+
+            rays.push_back({ { position(random), position(random), position(random) }, { d.x / length, d.y / length, d.z / length }, worldSize / 3.0f });
+        }
+
+        return rays;
+    }
+
+
+
+    void bruteForcePairs(Cedar::Bench::State& state)
+    {
+        std::vector<Cedar::AABB2D<float>>      boxes = makeBoxes(proxyCount, 1);
+        std::vector<Cedar::Physics::ProxyPair> pairs;
+
+        for (auto _ : state)
+        {
+            pairs.clear();
+
+            for (std::size_t i = 0; i < boxes.size(); i++)
+            {
+                for (std::size_t j = i + 1; j < boxes.size(); j++)
+                {
+                    if (Cedar::overlaps(boxes[i], boxes[j]))
+                        pairs.push_back({ static_cast<Cedar::Physics::ProxyId>(i), static_cast<Cedar::Physics::ProxyId>(j) });
+                }
+            }
+
+            Cedar::Bench::doNotOptimize(pairs);
+        }
+
+        state.setItemsProcessed(state.getIterations() * proxyCount);
+    }
+
+
+
+    void gridPairs(Cedar::Bench::State& state)
+    {
+        std::vector<Cedar::AABB2D<float>>      boxes = makeBoxes(proxyCount, 1);
+        std::vector<Cedar::Physics::ProxyPair> pairs;
+        Cedar::Physics::SpatialHashGrid2D      grid(cellSize);
+
+        for (const Cedar::AABB2D<float>& box : boxes)
+            grid.create(box);
+
+        for (auto _ : state)
+        {
+            grid.findPairs(pairs);
+            Cedar::Bench::doNotOptimize(pairs);
+        }
+
+        state.setItemsProcessed(state.getIterations() * proxyCount);
+    }
+
+
+
+    void gridMoveAndPairs(Cedar::Bench::State& state)
+    {
+        std::vector<Cedar::AABB2D<float>>      boxes = makeBoxes(proxyCount, 1);
+        std::vector<Cedar::Physics::ProxyPair> pairs;
+        Cedar::Physics::SpatialHashGrid2D      grid(cellSize);
+
+        for (const Cedar::AABB2D<float>& box : boxes)
+            grid.create(box);
+
+        // Everything moves a little every frame, like a physics step would
+        float offset = 0.1f;
+
+        for (auto _ : state)
+        {
+            for (std::size_t i = 0; i < boxes.size(); i++)
+            {
+                Cedar::AABB2D<float>& box = boxes[i];
+
+                box.min.x += offset;
+                box.max.x += offset;
+
+                grid.move(static_cast<Cedar::Physics::ProxyId>(i), box);
+            }
+
+            offset = -offset;
+
+            grid.findPairs(pairs);
+            Cedar::Bench::doNotOptimize(pairs);
+        }
+
+        state.setItemsProcessed(state.getIterations() * proxyCount);
+    }
+
+
+
+    void bruteForceQueries(Cedar::Bench::State& state)
+    {
+        std::vector<Cedar::AABB2D<float>> boxes   = makeBoxes(proxyCount, 1);
+        std::vector<Cedar::AABB2D<float>> queries = makeBoxes(queryCount, 2);
+        std::size_t                       found   = 0;
+
+        for (auto _ : state)
+        {
+            for (const Cedar::AABB2D<float>& query : queries)
+            {
+                for (const Cedar::AABB2D<float>& box : boxes)
+                    found += Cedar::overlaps(box, query) ? 1 : 0;
+            }
+
+            Cedar::Bench::doNotOptimize(found);
+        }
+
+        state.setItemsProcessed(state.getIterations() * queryCount);
+    }
+
+
+
+    void gridQueryBatch(Cedar::Bench::State& state)
+    {
+        std::vector<Cedar::AABB2D<float>>   boxes   = makeBoxes(proxyCount, 1);
+        std::vector<Cedar::AABB2D<float>>   queries = makeBoxes(queryCount, 2);
+        Cedar::Physics::SpatialHashGrid2D   grid(cellSize);
+        Cedar::Physics::SpatialQueryResults results;
+
+        for (const Cedar::AABB2D<float>& box : boxes)
+            grid.create(box);
+
+        for (auto _ : state)
+        {
+            grid.queryBatch(queries, results);
+            Cedar::Bench::clobberMemory();
+        }
+
+        state.setItemsProcessed(state.getIterations() * queryCount);
+    }
+
+
+
+    void bruteForceRaycasts(Cedar::Bench::State& state)
+    {
+        std::vector<Cedar::AABB3D<float>> boxes = makeBoxes3D(treeProxyCount, 1);
+        std::vector<Cedar::Physics::Ray>  rays  = makeRays(bruteRayCount, 2);
+
+        for (auto _ : state)
+        {
+            for (const Cedar::Physics::Ray& ray : rays)
+            {
+                float closest = ray.maxDistance;
+
+                for (const Cedar::AABB3D<float>& box : boxes)
+                {
+                    float x1 = (box.min.x - ray.origin.x) / ray.direction.x, x2 = (box.max.x - ray.origin.x) / ray.direction.x;
+                    float y1 = (box.min.y - ray.origin.y) / ray.direction.y, y2 = (box.max.y - ray.origin.y) / ray.direction.y;
+                    float z1 = (box.min.z - ray.origin.z) / ray.direction.z, z2 = (box.max.z - ray.origin.z) / ray.direction.z;
+
+                    float enter = std::fmax(std::fmax(std::fmin(x1, x2), std::fmin(y1, y2)), std::fmax(std::fmin(z1, z2), 0.0f));
+                    float exit  = std::fmin(std::fmin(std::fmax(x1, x2), std::fmax(y1, y2)), std::fmin(std::fmax(z1, z2), closest));
+
+                    closest = (enter <= exit) ? enter : closest;
+                }
+
+                Cedar::Bench::doNotOptimize(closest);
+            }
+        }
+
+        state.setItemsProcessed(state.getIterations() * bruteRayCount);
+    }
+
+
+
+    void treeRaycastBatch(Cedar::Bench::State& state)
+    {
+        std::vector<Cedar::AABB3D<float>>   boxes = makeBoxes3D(treeProxyCount, 1);
+        std::vector<Cedar::Physics::Ray>    rays  = makeRays(rayCount, 2);
+        std::vector<Cedar::Physics::RayHit> hits(rayCount);
+        Cedar::Physics::DynamicAABBTree     tree;
+
+        for (const Cedar::AABB3D<float>& box : boxes)
+            tree.create(box);
+
+        for (auto _ : state)
+        {
+            tree.raycastBatch(rays, hits);
+            Cedar::Bench::clobberMemory();
+        }
+
+        state.setItemsProcessed(state.getIterations() * rayCount);
+    }
+
+
+
+    void treeCull(Cedar::Bench::State& state)
+    {
+        std::vector<Cedar::AABB3D<float>> boxes = makeBoxes3D(treeProxyCount, 1);
+        Cedar::Physics::DynamicAABBTree   tree;
+
+        for (const Cedar::AABB3D<float>& box : boxes)
+            tree.create(box);
+
+        // A 90 degree view along x from the middle of a face of the world, far plane halfway
+        // through, which sees a sixth of it
+        Cedar::Physics::Frustum frustum = { {
+            { 1.0f, -1.0f, 0.0f, worldSize * 0.5f }, { 1.0f, 1.0f, 0.0f, -worldSize * 0.5f },
+            { 1.0f, 0.0f, -1.0f, worldSize * 0.5f }, { 1.0f, 0.0f, 1.0f, -worldSize * 0.5f },
+            { 1.0f, 0.0f, 0.0f, 0.0f },              { -1.0f, 0.0f, 0.0f, worldSize * 0.5f }
+        } };
+
+        std::size_t visible = 0;
+
+        for (auto _ : state)
+        {
+            tree.cull(frustum, [&](Cedar::Physics::ProxyId) { visible++; });
+            Cedar::Bench::doNotOptimize(visible);
+        }
+
+        state.setItemsProcessed(state.getIterations() * treeProxyCount);
+    }
+
+
+
+    void treeMove(Cedar::Bench::State& state)
+    {
+        std::vector<Cedar::AABB3D<float>>    boxes = makeBoxes3D(treeProxyCount, 1);
+        std::vector<Cedar::Physics::ProxyId> ids;
+        Cedar::Physics::DynamicAABBTree      tree(0.5f);
+
+        for (const Cedar::AABB3D<float>& box : boxes)
+            ids.push_back(tree.create(box));
+
+        // Steps of 0.2 with a margin of 0.5 leave the fat box every few frames
+        std::mt19937                          random(3);
+        std::uniform_real_distribution<float> step(-0.2f, 0.2f);
+
+        for (auto _ : state)
+        {
+            for (std::size_t i = 0; i < boxes.size(); i++)
+            {
+                Cedar::AABB3D<float>& box = boxes[i];
+                float                 dx  = step(random);
+
+                box.min.x += dx;
+                box.max.x += dx;
+
+                tree.move(ids[i], box);
+            }
+
+            Cedar::Bench::clobberMemory();
+        }
+
+        state.setItemsProcessed(state.getIterations() * treeProxyCount);
+    }
+
+
+
+    // Boxes and circles piled in a closed square container whose gravity turns a full
+    // circle every 4 seconds, so the pile keeps tumbling over the walls and never sleeps
+    void physicsWorldStep(Cedar::Bench::State& state)
+    {
+        Cedar::Physics::PhysicsWorld2D world;
+
+        Cedar::Physics::BodyDef wall;
+        wall.density = 0.0f;
+
+        float half = containerSize * 0.5f;
+
+        for (int side = 0; side < 4; side++)
+        {
+            bool  vertical = (side >= 2);
+            float offset  = (side % 2 == 0) ? -half - 0.5f : half + 0.5f;
+
+            wall.halfExtents = vertical ? Cedar::Vector2D<float>{ 0.5f, half + 1.0f } : Cedar::Vector2D<float>{ half + 1.0f, 0.5f };
+            wall.position    = vertical ? Cedar::Vector2D<float>{ offset, 0.0f } : Cedar::Vector2D<float>{ 0.0f, offset };
+
+            world.createBody(wall);
+        }
+
+        std::mt19937                          random(4);
+        std::uniform_real_distribution<float> size(0.3f, 0.5f);
+
+        std::size_t columns = static_cast<std::size_t>(containerSize) - 2;
+
+        for (std::size_t i = 0; i < bodyCount; i++)
+        {
+            Cedar::Physics::BodyDef body;
+
+            body.shape       = (i % 2 == 0) ? Cedar::Physics::ShapeType::Box : Cedar::Physics::ShapeType::Circle;
+            body.radius      = size(random);
+            body.halfExtents = { size(random), size(random) };
+            body.position    = { -half + 1.5f + static_cast<float>(i % columns), -half + 1.5f + static_cast<float>(i / columns) };
+
+            world.createBody(body);
+        }
+
+        float time = 0.0f;
+
+        auto step = [&]() {
+            time += world.getTimestep();
+            world.setGravity({ 10.0f * std::sin(time * 1.5708f), -10.0f * std::cos(time * 1.5708f) });
+            world.step();
+        };
+
+        // Let the pile land first
+        for (int i = 0; i < 120; i++)
+            step();
+
+        for (auto _ : state)
+            step();
+
+        state.setItemsProcessed(state.getIterations() * bodyCount);
+    }
+}
+
+
+
+CEDAR_BENCHMARK("Brute force pairs 10k boxes", bruteForcePairs);
+CEDAR_BENCHMARK("SpatialHashGrid2D::findPairs 10k boxes", gridPairs);
+CEDAR_BENCHMARK("SpatialHashGrid2D move and findPairs 10k boxes", gridMoveAndPairs);
+CEDAR_BENCHMARK("Brute force box queries 1k over 10k boxes", bruteForceQueries);
+CEDAR_BENCHMARK("SpatialHashGrid2D::queryBatch 1k over 10k boxes", gridQueryBatch);
+CEDAR_BENCHMARK("Brute force raycasts 100 over 100k boxes", bruteForceRaycasts);
+CEDAR_BENCHMARK("DynamicAABBTree::raycastBatch 10k over 100k boxes", treeRaycastBatch);
+CEDAR_BENCHMARK("DynamicAABBTree::cull 100k boxes", treeCull);
+CEDAR_BENCHMARK("DynamicAABBTree::move 100k boxes", treeMove);
+CEDAR_BENCHMARK("PhysicsWorld2D::step 4k bodies", physicsWorldStep);
\ No newline at end of file
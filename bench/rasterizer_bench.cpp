@@ -0,0 +1,140 @@
+#include "benchmark.h"
+
+#include "../src/graphics/rasterizer.h"
+#include "../src/graphics/surface.h"
+#include "../src/jobs/job_system.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr Cedar::Size2D<int> targetSize = { 1920, 1080 };
+
+
+
+    struct Mesh;
+
+
+
+    struct Mesh
+    {
+        std::vector<Cedar::Graphics::Vertex> vertices;
+        std::vector<std::uint32_t>           indices;
+    };
+
+
+
+    // A grid of quads covering the target, each split into two triangles, tilted away
+    // from the viewer so depth and w vary across it.
+    Mesh makeGrid(int quadsPerRow, int quadsPerColumn)
+    {
+        Mesh mesh;
+
+        for (int y = 0; y <= quadsPerColumn; y++)
+        {
+            for (int x = 0; x <= quadsPerRow; x++)
+            {
+                float u = static_cast<float>(x) / quadsPerRow;
+                float v = static_cast<float>(y) / quadsPerColumn;
+                float w = 1.0f + v;
+
+                mesh.vertices.push_back({ { (u * 2.0f - 1.0f) * w, (v * 2.0f - 1.0f) * w, 0.5f * w, w },
+                                          { u * 8.0f, v * 8.0f },
+                                          Cedar::Graphics::makePixel(static_cast<std::uint8_t>(x * 7), static_cast<std::uint8_t>(y * 5), 200) });
+            }
+        }
+
+        for (int y = 0; y < quadsPerColumn; y++)
+        {
+            for (int x = 0; x < quadsPerRow; x++)
+            {
+                std::uint32_t bottomLeft = static_cast<std::uint32_t>(y * (quadsPerRow + 1) + x);
+                std::uint32_t topLeft    = bottomLeft + quadsPerRow + 1;
+
+                mesh.indices.insert(mesh.indices.end(), { bottomLeft, bottomLeft + 1, topLeft + 1,
+                                                          bottomLeft, topLeft + 1, topLeft });
+            }
+        }
+
+        return mesh;
+    }
+
+
+
+    void renderGrid(Cedar::Bench::State& state, int quadsPerRow, int quadsPerColumn, Cedar::Graphics::Shading shading)
+    {
+        std::vector<Cedar::Graphics::Pixel> pixels(static_cast<std::size_t>(targetSize.width) * targetSize.height);
+        Cedar::Graphics::Surface target = { pixels.data(), targetSize, targetSize.width };
+
+        std::vector<Cedar::Graphics::Pixel> texels(256 * 256);
+
+        for (std::size_t i = 0; i < texels.size(); i++)
+            texels[i] = (((i % 256) / 16 + (i / 256) / 16) % 2 == 0) ? 0xFFFFFFFF : 0xFF3050C0;
+
+        Cedar::Graphics::Surface texture = { texels.data(), { 256, 256 }, 256 };
+
+        Mesh mesh = makeGrid(quadsPerRow, quadsPerColumn);
+
+        Cedar::Graphics::DrawCall drawCall;
+        drawCall.vertices = mesh.vertices;
+        drawCall.indices  = mesh.indices;
+        drawCall.shading  = shading;
+        drawCall.texture  = &texture;
+
+        // Starts the workers outside of the timed loop
+        (void)Cedar::Jobs::getWorkerCount();
+
+        Cedar::Graphics::Rasterizer rasterizer;
+
+        for (auto _ : state)
+        {
+            rasterizer.beginFrame(target);
+            rasterizer.clear(0xFF000000);
+            rasterizer.draw(drawCall);
+            rasterizer.endFrame();
+
+            Cedar::Bench::clobberMemory();
+        }
+
+        state.setItemsProcessed(state.getIterations() * mesh.indices.size() / 3);
+    }
+
+
+
+    void flatLargeTriangles(Cedar::Bench::State& state)
+    {
+        renderGrid(state, 32, 18, Cedar::Graphics::Shading::Flat);
+    }
+
+
+
+    void flatSmallTriangles(Cedar::Bench::State& state)
+    {
+        renderGrid(state, 320, 180, Cedar::Graphics::Shading::Flat);
+    }
+
+
+
+    void texturedLargeTriangles(Cedar::Bench::State& state)
+    {
+        renderGrid(state, 32, 18, Cedar::Graphics::Shading::Textured);
+    }
+
+
+
+    void texturedSmallTriangles(Cedar::Bench::State& state)
+    {
+        renderGrid(state, 320, 180, Cedar::Graphics::Shading::Textured);
+    }
+}
+
+
+
+CEDAR_BENCHMARK("Rasterizer flat, 1152 large triangles", flatLargeTriangles);
+CEDAR_BENCHMARK("Rasterizer flat, 115200 small triangles", flatSmallTriangles);
+CEDAR_BENCHMARK("Rasterizer textured, 1152 large triangles", texturedLargeTriangles);
+CEDAR_BENCHMARK("Rasterizer textured, 115200 small triangles", texturedSmallTriangles);
\ No newline at end of file
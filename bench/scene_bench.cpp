@@ -0,0 +1,260 @@
+#include "benchmark.h"
+
+#include "../src/math/vector.h"
+#include "../src/scene/command_buffer.h"
+#include "../src/scene/transform_hierarchy.h"
+#include "../src/scene/world.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr std::size_t entityCount = 1'000'000;
+    constexpr std::size_t spawnCount  = 10'000;
+    constexpr float       timeStep    = 1.0f / 60.0f;
+
+    constexpr std::size_t rootCount   = 1'000;
+    constexpr std::size_t branchCount = 10;   // Children of each node above the leaves
+    constexpr std::size_t treeDepth   = 4;
+
+
+
+    struct Position
+    {
+        Cedar::Vector3D<float> value;
+    };
+
+
+
+    struct Velocity
+    {
+        Cedar::Vector3D<float> value;
+    };
+
+
+
+    struct Health
+    {
+        float value;
+    };
+
+
+
+    // What a scene of individually allocated objects looks like, for comparison
+    struct GameObject
+    {
+        Position position;
+        Velocity velocity;
+        Health   health;
+        char     otherState[84];
+    };
+
+
+
+    // A million moving entities spread over four archetypes
+    void fillWorld(Cedar::Scene::World& world)
+    {
+        for (std::size_t i = 0; i < entityCount; i++)
+        {
+            float                x      = static_cast<float>(i);
+            Cedar::Scene::Entity entity = world.create(Position{ { x, 0.0f, 0.0f } }, Velocity{ { 1.0f, 2.0f, 3.0f } });
+
+            if (i % 2 == 0)
+                world.add<Health>(entity, 100.0f);
+        }
+    }
+
+
+
+    // rootCount trees of treeDepth levels, 1.1M nodes. Returns the leaves.
+    std::vector<Cedar::Scene::TransformId> fillHierarchy(Cedar::Scene::TransformHierarchy& hierarchy)
+    {
+        std::vector<Cedar::Scene::TransformId> level;
+        std::vector<Cedar::Scene::TransformId> next;
+
+        for (std::size_t i = 0; i < rootCount; i++)
+            level.push_back(hierarchy.create(Cedar::Scene::noTransform, { { static_cast<float>(i), 0.0f, 0.0f } }));
+
+        for (std::size_t depth = 1; depth < treeDepth; depth++)
+        {
+            next.clear();
+
+            for (Cedar::Scene::TransformId parent : level)
+            {
+                for (std::size_t i = 0; i < branchCount; i++)
+                    next.push_back(hierarchy.create(parent, { { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.3826834f, 0.9238795f } }));
+            }
+
+            level.swap(next);
+        }
+
+        hierarchy.update();
+
+        return level;
+    }
+
+
+
+    inline void integrate(Position& position, const Velocity& velocity)
+    {
+        position.value.x += velocity.value.x * timeStep;
+        position.value.y += velocity.value.y * timeStep;
+        position.value.z += velocity.value.z * timeStep;
+    }
+
+
+
+    void worldEach(Cedar::Bench::State& state)
+    {
+        Cedar::Scene::World world;
+        fillWorld(world);
+
+        for (auto _ : state)
+        {
+            world.each<Position, const Velocity>(integrate);
+            Cedar::Bench::clobberMemory();
+        }
+
+        state.setItemsProcessed(state.getIterations() * entityCount);
+    }
+
+
+
+    void worldParallelEach(Cedar::Bench::State& state)
+    {
+        Cedar::Scene::World world;
+        fillWorld(world);
+
+        for (auto _ : state)
+        {
+            world.parallelEach<Position, const Velocity>(integrate);
+            Cedar::Bench::clobberMemory();
+        }
+
+        state.setItemsProcessed(state.getIterations() * entityCount);
+    }
+
+
+
+    void objectPointers(Cedar::Bench::State& state)
+    {
+        std::vector<std::unique_ptr<GameObject>> objects;
+
+        for (std::size_t i = 0; i < entityCount; i++)
+        {
+            objects.push_back(std::make_unique<GameObject>());
+            objects.back()->position = { { static_cast<float>(i), 0.0f, 0.0f } };
+            objects.back()->velocity = { { 1.0f, 2.0f, 3.0f } };
+        }
+
+        // Objects that were spawned and despawned over time end up scattered over the heap
+        std::shuffle(objects.begin(), objects.end(), std::mt19937(1234));
+
+        for (auto _ : state)
+        {
+            for (const std::unique_ptr<GameObject>& object : objects)
+                integrate(object->position, object->velocity);
+
+            Cedar::Bench::clobberMemory();
+        }
+
+        state.setItemsProcessed(state.getIterations() * entityCount);
+    }
+
+
+
+    void commandBufferSpawn(Cedar::Bench::State& state)
+    {
+        Cedar::Scene::World         world;
+        Cedar::Scene::CommandBuffer commands;
+
+        std::vector<Cedar::Scene::Entity> spawned;
+
+        for (auto _ : state)
+        {
+            for (std::size_t i = 0; i < spawnCount; i++)
+            {
+                Cedar::Scene::Entity entity = commands.create();
+
+                commands.add<Position>(entity, Position{ { 0.0f, 0.0f, 0.0f } });
+                commands.add<Velocity>(entity, Velocity{ { 1.0f, 0.0f, 0.0f } });
+            }
+
+            commands.playback(world);
+
+            spawned.clear();
+            world.each<Position>([&](Cedar::Scene::Entity entity, Position&) { spawned.push_back(entity); });
+
+            for (Cedar::Scene::Entity entity : spawned)
+                commands.destroy(entity);
+
+            commands.playback(world);
+        }
+
+        state.setItemsProcessed(state.getIterations() * spawnCount);
+    }
+
+
+
+    void transformUpdateAll(Cedar::Bench::State& state)
+    {
+        Cedar::Scene::TransformHierarchy hierarchy;
+        fillHierarchy(hierarchy);
+
+        float x = 0.0f;
+
+        for (auto _ : state)
+        {
+            // Moving every root moves every node
+            for (Cedar::Scene::TransformId id = 0; id < rootCount; id++)
+                hierarchy.setPosition(id, { x, 0.0f, 0.0f });
+
+            x += 1.0f;
+
+            std::size_t updated = hierarchy.update();
+            Cedar::Bench::doNotOptimize(updated);
+        }
+
+        state.setItemsProcessed(state.getIterations() * hierarchy.getCount());
+    }
+
+
+
+    void transformUpdateFewLeaves(Cedar::Bench::State& state)
+    {
+        Cedar::Scene::TransformHierarchy       hierarchy;
+        std::vector<Cedar::Scene::TransformId> leaves = fillHierarchy(hierarchy);
+
+        float x = 0.0f;
+
+        for (auto _ : state)
+        {
+            // One leaf in a hundred moves, the rest of the hierarchy is skipped
+            for (std::size_t i = 0; i < leaves.size(); i += 100)
+                hierarchy.setPosition(leaves[i], { x, 0.0f, 0.0f });
+
+            x += 1.0f;
+
+            std::size_t updated = hierarchy.update();
+            Cedar::Bench::doNotOptimize(updated);
+        }
+
+        state.setItemsProcessed(state.getIterations() * hierarchy.getCount());
+    }
+}
+
+
+
+CEDAR_BENCHMARK("World::each 1M entities", worldEach);
+CEDAR_BENCHMARK("World::parallelEach 1M entities", worldParallelEach);
+CEDAR_BENCHMARK("Object pointers 1M objects", objectPointers);
+CEDAR_BENCHMARK("CommandBuffer spawn and destroy 10k entities", commandBufferSpawn);
+CEDAR_BENCHMARK("TransformHierarchy::update 1.1M nodes, all moved", transformUpdateAll);
+CEDAR_BENCHMARK("TransformHierarchy::update 1.1M nodes, 1% of leaves moved", transformUpdateFewLeaves);
\ No newline at end of file
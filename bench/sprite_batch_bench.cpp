@@ -0,0 +1,127 @@
+#include "benchmark.h"
+
+#include "../src/graphics/rect.h"
+#include "../src/graphics/sprite_batch.h"
+#include "../src/graphics/surface.h"
+#include "../src/jobs/job_system.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr Cedar::Size2D<int> targetSize  = { 1920, 1080 };
+    constexpr std::size_t        spriteCount = 100000;
+
+
+
+    // 100k commands scattered over the target and a bit past its edges, on 4 layers and
+    // with 8 textures, in random order.
+    void drawScattered(Cedar::Bench::State& state, int spriteSize, bool sprites)
+    {
+        std::vector<Cedar::Graphics::Pixel> pixels(static_cast<std::size_t>(targetSize.width) * targetSize.height);
+        Cedar::Graphics::Surface target = { pixels.data(), targetSize, targetSize.width };
+
+        std::vector<std::vector<Cedar::Graphics::Pixel>> texels(8);
+        std::vector<Cedar::Graphics::Surface>            textures;
+
+        for (std::size_t i = 0; i < texels.size(); i++)
+        {
+            texels[i].resize(static_cast<std::size_t>(spriteSize) * spriteSize);
+
+            // Opaque in the middle, translucent towards the edges
+            for (int y = 0; y < spriteSize; y++)
+            {
+                for (int x = 0; x < spriteSize; x++)
+                {
+                    bool         edge  = x < 2 || y < 2 || x >= spriteSize - 2 || y >= spriteSize - 2;
+                    std::uint8_t alpha = edge ? 0x60 : 0xFF;
+
+                    texels[i][y * spriteSize + x] = Cedar::Graphics::premultiply(
+                        Cedar::Graphics::makePixel(static_cast<std::uint8_t>(i * 30), static_cast<std::uint8_t>(x * 8),
+                                                   static_cast<std::uint8_t>(y * 8), alpha));
+                }
+            }
+
+            textures.push_back({ texels[i].data(), { spriteSize, spriteSize }, spriteSize });
+        }
+
+        struct Placement
+        {
+            Cedar::Point2D<int> position;
+            std::size_t         texture;
+            int                 layer;
+        };
+
+        std::mt19937           random(42);
+        std::vector<Placement> placements(spriteCount);
+
+        for (Placement& placement : placements)
+        {
+            placement.position = { static_cast<int>(random() % (targetSize.width + spriteSize)) - spriteSize,
+                                   static_cast<int>(random() % (targetSize.height + spriteSize)) - spriteSize };
+            placement.texture  = random() % textures.size();
+            placement.layer    = static_cast<int>(random() % 4);
+        }
+
+        // Starts the workers outside of the timed loop
+        (void)Cedar::Jobs::getWorkerCount();
+
+        Cedar::Graphics::SpriteBatch batch;
+
+        for (auto _ : state)
+        {
+            batch.begin(target);
+
+            for (const Placement& placement : placements)
+            {
+                if (sprites)
+                {
+                    batch.drawSprite(textures[placement.texture], placement.position, placement.layer);
+                }
+                else
+                {
+                    batch.fillRect({ placement.position, { spriteSize, spriteSize } }, textures[placement.texture].pixels[0],
+                                   placement.layer);
+                }
+            }
+
+            batch.end();
+
+            Cedar::Bench::clobberMemory();
+        }
+
+        state.setItemsProcessed(state.getIterations() * spriteCount);
+    }
+
+
+
+    void smallSprites(Cedar::Bench::State& state)
+    {
+        drawScattered(state, 16, true);
+    }
+
+
+
+    void largeSprites(Cedar::Bench::State& state)
+    {
+        drawScattered(state, 64, true);
+    }
+
+
+
+    void translucentRects(Cedar::Bench::State& state)
+    {
+        drawScattered(state, 16, false);
+    }
+}
+
+
+
+CEDAR_BENCHMARK("SpriteBatch 100k 16x16 sprites", smallSprites);
+CEDAR_BENCHMARK("SpriteBatch 100k 64x64 sprites", largeSprites);
+CEDAR_BENCHMARK("SpriteBatch 100k 16x16 translucent rects", translucentRects);
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "benchmark.h"
+
+#include "../src/containers/flat_hash_map.h"
+#include "../src/string_id.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr std::size_t nameCount   = 256;
+    constexpr std::size_t lookupCount = 100000;
+
+
+
+    std::vector<std::string> makeNames()
+    {
+        std::vector<std::string> names(nameCount);
+
+        for (std::size_t i = 0; i < nameCount; i++)
+            names[i] = "events/gameplay/player_" + std::to_string(i) + "_state_changed";
+
+        return names;
+    }
+
+
+
+    std::vector<std::size_t> makeLookups()
+    {
+        std::mt19937             random(1);
+        std::vector<std::size_t> lookups(lookupCount);
+
+        for (std::size_t& lookup : lookups)
+            lookup = random() % nameCount;
+
+        return lookups;
+    }
+
+
+
+    // 100k lookups of event handlers by name, with the names kept as strings.
+    void stringLookup(Cedar::Bench::State& state)
+    {
+        std::vector<std::string> names   = makeNames();
+        std::vector<std::size_t> lookups = makeLookups();
+
+        std::unordered_map<std::string, std::uint64_t> handlers;
+
+        for (std::size_t i = 0; i < names.size(); i++)
+            handlers.emplace(names[i], i);
+
+        for (auto _ : state)
+        {
+            std::uint64_t sum = 0;
+
+            for (std::size_t lookup : lookups)
+                sum += handlers.find(names[lookup])->second;
+
+            Cedar::Bench::doNotOptimize(sum);
+        }
+
+        state.setItemsProcessed(state.getIterations() * lookupCount);
+    }
+
+
+
+    // The same lookups with the names interned once up front.
+    void stringIdLookup(Cedar::Bench::State& state)
+    {
+        std::vector<std::string> names   = makeNames();
+        std::vector<std::size_t> lookups = makeLookups();
+
+        std::vector<Cedar::StringId>                       ids;
+        Cedar::FlatHashMap<Cedar::StringId, std::uint64_t> handlers;
+
+        for (std::size_t i = 0; i < names.size(); i++)
+        {
+            ids.push_back(Cedar::StringId::intern(names[i]));
+            handlers.tryEmplace(ids.back(), i);
+        }
+
+        for (auto _ : state)
+        {
+            std::uint64_t sum = 0;
+
+            for (std::size_t lookup : lookups)
+                sum += handlers.find(ids[lookup])->second;
+
+            Cedar::Bench::doNotOptimize(sum);
+        }
+
+        state.setItemsProcessed(state.getIterations() * lookupCount);
+    }
+
+
+
+    // 100k interns of names that are already in the table, the cost of making an id from
+    // a runtime string.
+    void stringIdIntern(Cedar::Bench::State& state)
+    {
+        std::vector<std::string> names   = makeNames();
+        std::vector<std::size_t> lookups = makeLookups();
+
+        for (const std::string& name : names)
+            (void)Cedar::StringId::intern(name);
+
+        for (auto _ : state)
+        {
+            std::uint64_t sum = 0;
+
+            for (std::size_t lookup : lookups)
+                sum += Cedar::StringId::intern(names[lookup]).getHash();
+
+            Cedar::Bench::doNotOptimize(sum);
+        }
+
+        state.setItemsProcessed(state.getIterations() * lookupCount);
+    }
+}
+
+
+
+CEDAR_BENCHMARK("std::unordered_map<std::string> find 100k names", stringLookup);
+CEDAR_BENCHMARK("FlatHashMap<StringId> find 100k names", stringIdLookup);
+CEDAR_BENCHMARK("StringId::intern 100k interned names", stringIdIntern);
\ No newline at end of file
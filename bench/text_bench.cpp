@@ -0,0 +1,71 @@
+#include "benchmark.h"
+
+#include "../src/graphics/surface.h"
+#include "../src/graphics/text_renderer.h"
+
+#include <cstddef>
+#include <format>
+#include <string>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr Cedar::Size2D<int> targetSize = { 1920, 1080 };
+    constexpr std::size_t        lineCount  = 2000;
+
+
+
+    // 2000 log-like lines of about 80 characters, in three columns that wrap around the
+    // target vertically.
+    void drawLines(Cedar::Bench::State& state, bool cached)
+    {
+        std::vector<Cedar::Graphics::Pixel> pixels(static_cast<std::size_t>(targetSize.width) * targetSize.height);
+        Cedar::Graphics::Surface target = { pixels.data(), targetSize, targetSize.width };
+
+        std::vector<std::string> lines;
+
+        for (std::size_t i = 0; i < lineCount; i++)
+            lines.push_back(std::format("[12:34:{:02}.{:03}] [Info] Loaded asset {} from pack 'textures' in {} us", i % 60, i % 1000, i, i * 37 % 5000));
+
+        Cedar::Graphics::TextRenderer renderer;
+
+        for (auto _ : state)
+        {
+            if (!cached)
+                renderer.clearCache();
+
+            for (std::size_t i = 0; i < lines.size(); i++)
+            {
+                Cedar::Point2D<int> position = { static_cast<int>(i % 3) * 640,
+                                                 static_cast<int>(i / 3) * renderer.getLineHeight() % targetSize.height };
+
+                renderer.drawText(target, lines[i], position, 0xFFE0E0E0);
+            }
+
+            Cedar::Bench::clobberMemory();
+        }
+
+        state.setItemsProcessed(state.getIterations() * lineCount);
+    }
+
+
+
+    void cachedLines(Cedar::Bench::State& state)
+    {
+        drawLines(state, true);
+    }
+
+
+
+    void uncachedLines(Cedar::Bench::State& state)
+    {
+        drawLines(state, false);
+    }
+}
+
+
+
+CEDAR_BENCHMARK("TextRenderer 2000 lines, cached layouts", cachedLines);
+CEDAR_BENCHMARK("TextRenderer 2000 lines, laid out every frame", uncachedLines);
\ No newline at end of file
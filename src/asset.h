@@ -0,0 +1,14 @@
+//
+// A collection of header files located in the "asset" directory.
+//
+
+#ifndef CEDAR_ASSET_H
+#define CEDAR_ASSET_H
+
+#include "asset/asset_manager.h"
+#include "asset/asset_pack.h"
+#include "asset/hot_reload.h"
+#include "asset/image.h"
+#include "asset/inflate.h"
+
+#endif // CEDAR_ASSET_H
\ No newline at end of file
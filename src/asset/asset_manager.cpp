@@ -0,0 +1,469 @@
+#include "asset_manager.h"
+
+#include "../debug/profiler.h"
+#include "../io/file_io.h"
+#include "../io/log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+
+
+namespace Cedar::Asset
+{
+    AssetHandle::AssetHandle(const AssetHandle& other) : m_entry(other.m_entry)
+    {
+        if (m_entry != nullptr)
+            m_entry->manager->acquire(*m_entry);
+    }
+
+
+
+    AssetHandle::AssetHandle(AssetEntry& entry) : m_entry(&entry)
+    {
+        entry.manager->acquire(entry);
+    }
+
+
+
+    AssetHandle::~AssetHandle()
+    {
+        release();
+    }
+
+
+
+    AssetHandle& AssetHandle::operator=(AssetHandle other) noexcept
+    {
+        std::swap(m_entry, other.m_entry);
+        return *this;
+    }
+
+
+
+    std::string_view AssetHandle::getName() const
+    {
+        if (m_entry == nullptr)
+            throw std::logic_error("Asset handle is invalid");
+
+        return m_entry->name;
+    }
+
+
+
+    void AssetHandle::release()
+    {
+        if (m_entry != nullptr)
+            m_entry->manager->release(*m_entry);
+
+        m_entry = nullptr;
+    }
+
+
+
+    AssetManager::AssetManager(const std::filesystem::path& root, std::size_t budget) : m_root(root), m_budget(budget)
+    {
+        if (budget == 0)
+            throw std::invalid_argument("Asset budget must be positive");
+    }
+
+
+
+    AssetManager::~AssetManager()
+    {
+        // The reads write into the entries' buffers
+        for (AssetEntry* entry : m_loading)
+            FileIO::wait(entry->request);
+    }
+
+
+
+    AssetHandle AssetManager::load(std::string_view name)
+    {
+        if (name.empty())
+            throw std::invalid_argument("Asset name is empty");
+
+        m_stats.requestCount++;
+
+        auto it = m_entries.find(name);
+
+        if (it == m_entries.end())
+        {
+            it = m_entries.try_emplace(std::string(name)).first;
+
+            it->second.manager = this;
+            it->second.name    = it->first;
+        }
+
+        AssetEntry& entry = it->second;
+        entry.requestFrame = m_frame;
+
+        if (entry.state == AssetState::Loaded)
+            m_stats.hitCount++;
+        else if (entry.state == AssetState::Unloaded)
+        {
+            entry.state = AssetState::Queued;
+            m_queued.push_back(&entry);
+        }
+
+        return AssetHandle(entry);
+    }
+
+
+
+    void AssetManager::update()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        for (std::size_t i = 0; i < m_loading.size();)
+        {
+            if (!m_loading[i]->request.isDone())
+            {
+                i++;
+                continue;
+            }
+
+            if (m_loading[i]->reloading)
+                finishReload(*m_loading[i]);
+            else
+                finishLoad(*m_loading[i]);
+
+            m_loading[i] = m_loading.back();
+            m_loading.pop_back();
+        }
+
+        // Nobody is waiting for these anymore
+        std::erase_if(m_queued, [](AssetEntry* entry) {
+            if (entry->refCount != 0)
+                return false;
+
+            entry->state = AssetState::Unloaded;
+            return true;
+        });
+
+        // Reloads go first, they're for assets that are already in use
+        for (std::size_t i = 0; i < m_reloads.size() && m_loading.size() < m_maxConcurrentLoads;)
+        {
+            AssetEntry* entry = m_reloads[i];
+
+            // The read in progress may have started before the change
+            if (entry->state == AssetState::Loading || entry->reloading)
+            {
+                i++;
+                continue;
+            }
+
+            m_reloads[i] = m_reloads.back();
+            m_reloads.pop_back();
+
+            entry->reloadQueued = false;
+
+            // Evicted assets read the new file whenever they're loaded again
+            if (entry->state == AssetState::Loaded || entry->state == AssetState::Failed)
+                startLoad(*entry);
+        }
+
+        if (m_loading.size() < m_maxConcurrentLoads && !m_queued.empty())
+        {
+            // Most recently requested first, the back is taken first
+            std::stable_sort(m_queued.begin(), m_queued.end(), [](const AssetEntry* a, const AssetEntry* b) {
+                return a->requestFrame < b->requestFrame;
+            });
+
+            while (m_loading.size() < m_maxConcurrentLoads && !m_queued.empty())
+            {
+                AssetEntry* entry = m_queued.back();
+                m_queued.pop_back();
+
+                startLoad(*entry);
+            }
+        }
+
+        evictToBudget();
+
+        m_frame++;
+    }
+
+
+
+    bool AssetManager::reload(std::string_view name)
+    {
+        auto it = m_entries.find(name);
+
+        if (it == m_entries.end())
+            return false;
+
+        AssetEntry& entry = it->second;
+
+        if (!entry.reloadQueued && entry.state != AssetState::Unloaded && entry.state != AssetState::Queued)
+        {
+            entry.reloadQueued = true;
+            m_reloads.push_back(&entry);
+        }
+
+        return true;
+    }
+
+
+
+    void AssetManager::setBudget(std::size_t budget)
+    {
+        if (budget == 0)
+            throw std::invalid_argument("Asset budget must be positive");
+
+        m_budget = budget;
+        evictToBudget();
+    }
+
+
+
+    void AssetManager::setMaxConcurrentLoads(std::size_t count)
+    {
+        m_maxConcurrentLoads = std::max<std::size_t>(count, 1);
+    }
+
+
+
+    void AssetManager::evictUnused()
+    {
+        while (m_lruTail != nullptr)
+            evict(*m_lruTail);
+    }
+
+
+
+    AssetManagerStats AssetManager::getStats() const
+    {
+        AssetManagerStats stats = m_stats;
+        stats.assetCount = m_entries.size();
+        stats.budget     = m_budget;
+
+        return stats;
+    }
+
+
+
+    void AssetManager::logStats() const
+    {
+        AssetManagerStats stats = getStats();
+
+        auto toMegabytes = [](std::size_t bytes) { return bytes / (1024.0 * 1024.0); };
+
+        double hitRate = (stats.requestCount != 0) ? 100.0 * stats.hitCount / stats.requestCount : 0.0;
+
+        CEDAR_LOG(Cedar::Log::assetCategory, Info,
+                  std::format("Assets: {} of {} resident, {:.2f} MB of {:.2f} MB budget (peak {:.2f} MB), "
+                              "hit rate {:.1f}% of {} request(s), {} load(s), {} reload(s), {} eviction(s), {} failure(s)",
+                              stats.residentCount, stats.assetCount,
+                              toMegabytes(stats.residentBytes),
+                              toMegabytes(stats.budget),
+                              toMegabytes(stats.peakResidentBytes),
+                              hitRate, stats.requestCount,
+                              stats.loadCount,
+                              stats.reloadCount,
+                              stats.evictionCount,
+                              stats.failureCount));
+    }
+
+
+
+    void AssetManager::acquire(AssetEntry& entry)
+    {
+        if (entry.refCount == 0 && entry.state == AssetState::Loaded && !entry.reloading)
+            unlinkLru(entry);
+
+        entry.refCount++;
+    }
+
+
+
+    void AssetManager::release(AssetEntry& entry)
+    {
+        entry.refCount--;
+
+        if (entry.refCount == 0 && entry.state == AssetState::Loaded && !entry.reloading)
+        {
+            linkLru(entry);
+            evictToBudget();
+        }
+    }
+
+
+
+    void AssetManager::startLoad(AssetEntry& entry)
+    {
+        bool reloading = (entry.state == AssetState::Loaded);
+
+        try
+        {
+            entry.file.open(m_root / entry.name, FileIO::OpenMode::Read);
+            entry.loadBuffer.resize(static_cast<std::size_t>(entry.file.getSize()));
+
+            // Whatever was asked for this frame is what's on screen next
+            FileIO::Priority priority = (entry.requestFrame == m_frame) ? FileIO::Priority::High : FileIO::Priority::Normal;
+
+            FileIO::read(entry.file, 0, entry.loadBuffer, entry.request, priority);
+        }
+        catch (const std::system_error& e) {
+            entry.file.close();
+            entry.loadBuffer = Vector<std::byte>();
+
+            m_stats.failureCount++;
+
+            if (reloading)
+            {
+                CEDAR_LOG(Cedar::Log::assetCategory, Warning, std::format("Failed to reload asset \"{}\", keeping the old data: {}", entry.name, e.what()));
+                return;
+            }
+
+            entry.state = AssetState::Failed;
+            CEDAR_LOG(Cedar::Log::assetCategory, Warning, std::format("Failed to load asset \"{}\": {}", entry.name, e.what()));
+
+            return;
+        }
+
+        // A reloading asset keeps its data, and can't be evicted from under the read
+        if (reloading)
+        {
+            if (entry.refCount == 0)
+                unlinkLru(entry);
+
+            entry.reloading = true;
+        }
+        else
+            entry.state = AssetState::Loading;
+
+        m_loading.push_back(&entry);
+    }
+
+
+
+    void AssetManager::finishLoad(AssetEntry& entry)
+    {
+        entry.file.close();
+
+        const FileIO::Result& result = entry.request.getResult();
+
+        if (result.status != FileIO::Status::Completed || result.bytes != entry.loadBuffer.size())
+        {
+            entry.loadBuffer = Vector<std::byte>();
+            entry.state      = AssetState::Failed;
+
+            m_stats.failureCount++;
+
+            std::string reason = result.error ? result.error.message() : "the file changed while it was read";
+            CEDAR_LOG(Cedar::Log::assetCategory, Warning, std::format("Failed to load asset \"{}\": {}", entry.name, reason));
+
+            return;
+        }
+
+        entry.data.swap(entry.loadBuffer);
+        entry.loadBuffer = Vector<std::byte>();
+        entry.state      = AssetState::Loaded;
+        entry.version++;
+
+        m_stats.loadCount++;
+        m_stats.residentCount++;
+        m_stats.residentBytes     += entry.data.size();
+        m_stats.peakResidentBytes  = std::max(m_stats.peakResidentBytes, m_stats.residentBytes);
+
+        if (entry.refCount == 0)
+            linkLru(entry);
+    }
+
+
+
+    void AssetManager::finishReload(AssetEntry& entry)
+    {
+        entry.file.close();
+        entry.reloading = false;
+
+        const FileIO::Result& result = entry.request.getResult();
+
+        if (result.status != FileIO::Status::Completed || result.bytes != entry.loadBuffer.size())
+        {
+            entry.loadBuffer = Vector<std::byte>();
+
+            m_stats.failureCount++;
+
+            std::string reason = result.error ? result.error.message() : "the file changed while it was read";
+            CEDAR_LOG(Cedar::Log::assetCategory, Warning, std::format("Failed to reload asset \"{}\", keeping the old data: {}", entry.name, reason));
+        }
+        else
+        {
+            m_stats.residentBytes     = m_stats.residentBytes - entry.data.size() + entry.loadBuffer.size();
+            m_stats.peakResidentBytes = std::max(m_stats.peakResidentBytes, m_stats.residentBytes);
+            m_stats.reloadCount++;
+
+            entry.data.swap(entry.loadBuffer);
+            entry.loadBuffer = Vector<std::byte>();
+            entry.version++;
+        }
+
+        if (entry.refCount == 0)
+            linkLru(entry);
+    }
+
+
+
+    void AssetManager::evict(AssetEntry& entry)
+    {
+        unlinkLru(entry);
+
+        m_stats.evictionCount++;
+        m_stats.residentCount--;
+        m_stats.residentBytes -= entry.data.size();
+
+        entry.data  = Vector<std::byte>();
+        entry.state = AssetState::Unloaded;
+    }
+
+
+
+    void AssetManager::evictToBudget()
+    {
+        while (m_stats.residentBytes > m_budget && m_lruTail != nullptr)
+            evict(*m_lruTail);
+    }
+
+
+
+    void AssetManager::linkLru(AssetEntry& entry)
+    {
+        entry.lruPrevious = nullptr;
+        entry.lruNext     = m_lruHead;
+
+        if (m_lruHead != nullptr)
+            m_lruHead->lruPrevious = &entry;
+        else
+            m_lruTail = &entry;
+
+        m_lruHead = &entry;
+    }
+
+
+
+    void AssetManager::unlinkLru(AssetEntry& entry)
+    {
+        if (entry.lruPrevious != nullptr)
+            entry.lruPrevious->lruNext = entry.lruNext;
+        else
+            m_lruHead = entry.lruNext;
+
+        if (entry.lruNext != nullptr)
+            entry.lruNext->lruPrevious = entry.lruPrevious;
+        else
+            m_lruTail = entry.lruPrevious;
+
+        entry.lruPrevious = nullptr;
+        entry.lruNext     = nullptr;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,347 @@
+//
+// Streaming asset manager.
+//
+// Assets are files under a root directory, named by their path relative to it with '/'
+// separators. Asking for an asset returns a reference counted handle right away; the
+// file is read in the background with FileIO and the handle's data becomes available a
+// few frames later. update, called once per frame, starts queued loads, most recently
+// requested first, and publishes finished ones, so loaded data only ever changes at a
+// frame boundary.
+//
+// Assets can be reloaded when their files change, which reads the file again while the
+// old data stays in use and swaps the new data in at a frame boundary, see HotReloader.
+//
+// Loaded assets nobody holds a handle to stay cached until the resident data exceeds the
+// memory budget, at which point the least recently released are evicted. Assets that
+// are referenced are never evicted, so the budget can be exceeded while they are.
+//
+// The manager and its handles belong to the main thread.
+//
+
+#ifndef CEDAR_ASSET_ASSET_MANAGER_H
+#define CEDAR_ASSET_ASSET_MANAGER_H
+
+#include "asset_pack.h"
+#include "../io/file_io.h"
+#include "../memory/memory_tracker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+
+namespace Cedar::Asset
+{
+    enum class AssetState;
+
+    struct AssetManagerStats;
+
+    struct AssetEntry;
+
+    class AssetHandle;
+
+    class AssetManager;
+
+
+
+    enum class AssetState {
+        Unloaded,
+        Queued,
+        Loading,
+        Loaded,
+        Failed
+    };
+
+
+
+    struct AssetManagerStats
+    {
+        std::size_t   assetCount;        // Known to the manager, loaded or not
+        std::size_t   residentCount;
+        std::size_t   residentBytes;
+        std::size_t   peakResidentBytes;
+        std::size_t   budget;
+        std::uint64_t requestCount;
+        std::uint64_t hitCount;          // Requests for assets that were already loaded
+        std::uint64_t loadCount;
+        std::uint64_t reloadCount;
+        std::uint64_t evictionCount;
+        std::uint64_t failureCount;
+    };
+
+
+
+    // For internal use only.
+    struct AssetEntry
+    {
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Asset>>;
+
+
+        AssetManager*     manager      = nullptr;
+        std::string_view  name;                   // The key in the manager's map
+        AssetState        state        = AssetState::Unloaded;
+        std::size_t       refCount     = 0;
+        std::uint64_t     requestFrame = 0;       // Last frame the asset was asked for
+        std::uint64_t     version      = 0;       // Bumped every time the data is replaced
+        Vector<std::byte> data;
+
+        FileIO::File      file;
+        FileIO::Request   request;
+        Vector<std::byte> loadBuffer;
+
+        bool reloadQueued = false;
+        bool reloading    = false; // The old data stays loaded until the read finishes
+
+        // Least recently used list of loaded assets without handles, the next to evict
+        // is at the tail
+        AssetEntry* lruPrevious = nullptr;
+        AssetEntry* lruNext     = nullptr;
+    };
+
+
+
+    class AssetHandle
+    {
+    public:
+
+        inline AssetHandle() {}
+
+        AssetHandle(const AssetHandle& other);
+
+        inline AssetHandle(AssetHandle&& other) noexcept;
+
+        ~AssetHandle();
+
+
+        AssetHandle& operator=(AssetHandle other) noexcept;
+
+
+        inline bool isValid() const;
+
+        // Throws std::logic_error if the handle is invalid.
+        std::string_view getName() const;
+
+        // Unloaded for an invalid handle.
+        inline AssetState getState() const;
+
+        inline bool isLoaded() const;
+
+        // Empty unless the asset is loaded. Stays valid while the handle is held, but an
+        // asset that is reloaded gets new data at a frame boundary.
+        inline std::span<const std::byte> getData() const;
+
+        // Changes whenever the data does, so anything decoded from it can tell when to
+        // decode again. Zero until the asset first loads.
+        inline std::uint64_t getVersion() const;
+
+
+        // Drops the reference, leaving the handle invalid.
+        void release();
+
+    private:
+
+        friend class AssetManager;
+
+
+        AssetEntry* m_entry = nullptr;
+
+
+        // Adds a reference.
+        explicit AssetHandle(AssetEntry& entry);
+    };
+
+
+
+    class AssetManager
+    {
+    public:
+
+        // Throws std::invalid_argument if the budget is zero.
+        AssetManager(const std::filesystem::path& root, std::size_t budget);
+
+        // Waits for the loads in progress. Every handle must have been released.
+        ~AssetManager();
+
+
+        AssetManager(const AssetManager&) = delete;
+
+        AssetManager& operator=(const AssetManager&) = delete;
+
+
+        // Returns a handle to the asset, queueing it to load if it isn't loaded or on its
+        // way. Asking for an asset every frame it's needed keeps it ahead of assets that
+        // were asked for earlier. Throws std::invalid_argument if the name is empty.
+        AssetHandle load(std::string_view name);
+
+        // Starts queued loads and reloads, publishes finished ones and evicts down to the
+        // budget. Call once per frame. Queued assets that lost all their handles are
+        // dropped without loading.
+        void update();
+
+        // Reads a loaded or failed asset again, swapping the new data in at a frame
+        // boundary once it's read. Handles keep seeing the old data until then, and keep
+        // it if the read fails. Returns false if the asset was never asked for.
+        bool reload(std::string_view name);
+
+
+        inline const std::filesystem::path& getRoot() const;
+
+        inline std::size_t getBudget() const;
+
+        // Evicts right away if the new budget is lower. Throws std::invalid_argument if
+        // the budget is zero.
+        void setBudget(std::size_t budget);
+
+        inline std::size_t getMaxConcurrentLoads() const;
+
+        void setMaxConcurrentLoads(std::size_t count);
+
+        // Evicts every loaded asset without handles, regardless of the budget.
+        void evictUnused();
+
+
+        AssetManagerStats getStats() const;
+
+        void logStats() const;
+
+    private:
+
+        friend class AssetHandle;
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Asset>>;
+
+        struct NameHash
+        {
+            using is_transparent = void;
+
+            inline std::size_t operator()(std::string_view name) const;
+        };
+
+        using EntryMap = std::unordered_map<std::string, AssetEntry, NameHash, std::equal_to<>,
+                                            Memory::TrackedAllocator<std::pair<const std::string, AssetEntry>, Memory::Tag::Asset>>;
+
+
+        std::filesystem::path m_root;
+        std::size_t           m_budget;
+        std::size_t           m_maxConcurrentLoads = 8;
+        std::uint64_t         m_frame              = 0;
+
+        EntryMap            m_entries;
+        Vector<AssetEntry*> m_queued;
+        Vector<AssetEntry*> m_loading;
+        Vector<AssetEntry*> m_reloads;
+        AssetEntry*         m_lruHead = nullptr; // Most recently released
+        AssetEntry*         m_lruTail = nullptr;
+
+        AssetManagerStats m_stats = {};
+
+
+        void acquire(AssetEntry& entry);
+
+        void release(AssetEntry& entry);
+
+        void startLoad(AssetEntry& entry);
+
+        void finishLoad(AssetEntry& entry);
+
+        void finishReload(AssetEntry& entry);
+
+        void evict(AssetEntry& entry);
+
+        void evictToBudget();
+
+        void linkLru(AssetEntry& entry);
+
+        void unlinkLru(AssetEntry& entry);
+    };
+
+
+
+    // vvv AssetHandle function definitions vvv
+
+    inline AssetHandle::AssetHandle(AssetHandle&& other) noexcept : m_entry(std::exchange(other.m_entry, nullptr)) {}
+
+
+
+    inline bool AssetHandle::isValid() const
+    {
+        return m_entry != nullptr;
+    }
+
+
+
+    inline AssetState AssetHandle::getState() const
+    {
+        return (m_entry != nullptr) ? m_entry->state : AssetState::Unloaded;
+    }
+
+
+
+    inline bool AssetHandle::isLoaded() const
+    {
+        return getState() == AssetState::Loaded;
+    }
+
+
+
+    inline std::span<const std::byte> AssetHandle::getData() const
+    {
+        if (!isLoaded())
+            return {};
+
+        return m_entry->data;
+    }
+
+
+
+    inline std::uint64_t AssetHandle::getVersion() const
+    {
+        return (m_entry != nullptr) ? m_entry->version : 0;
+    }
+
+    // ^^^ AssetHandle function definitions ^^^
+
+
+
+    // vvv AssetManager function definitions vvv
+
+    inline const std::filesystem::path& AssetManager::getRoot() const
+    {
+        return m_root;
+    }
+
+
+
+    inline std::size_t AssetManager::getBudget() const
+    {
+        return m_budget;
+    }
+
+
+
+    inline std::size_t AssetManager::getMaxConcurrentLoads() const
+    {
+        return m_maxConcurrentLoads;
+    }
+
+
+
+    inline std::size_t AssetManager::NameHash::operator()(std::string_view name) const
+    {
+        return static_cast<std::size_t>(hashAssetName(name));
+    }
+
+    // ^^^ AssetManager function definitions ^^^
+}
+
+#endif // CEDAR_ASSET_ASSET_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,524 @@
+#include "asset_pack.h"
+
+#include "../core.h"
+#include "../debug/profiler.h"
+#include "../memory/memory_tracker.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+
+
+namespace
+{
+    struct PackHeader;
+
+    template <typename T>
+    using Vector = std::vector<T, Cedar::Memory::TrackedAllocator<T, Cedar::Memory::Tag::Asset>>;
+
+
+
+    // The format is written and read by memcpy and pointer casts
+    static_assert(std::endian::native == std::endian::little, "Asset packs are little endian");
+
+    constexpr std::array<char, 8> packMagic = { 'C', 'E', 'D', 'A', 'R', 'P', 'A', 'K' };
+
+
+
+    struct PackHeader
+    {
+        std::array<char, 8> magic;
+        std::uint32_t       version;
+        std::uint32_t       assetCount;
+        std::uint32_t       slotCount;  // Power of two, the slots follow the header
+        std::uint32_t       alignment;
+        std::uint64_t       namesOffset;
+    };
+
+    static_assert(sizeof(PackHeader) == 32);
+
+
+
+    // Maps the whole file read-only. Throws std::system_error on failure.
+    const std::byte* mapFile(const std::filesystem::path& path, std::size_t& size);
+
+    void unmapFile(const std::byte* data, std::size_t size);
+
+    [[noreturn]] void throwInvalidPack(const std::filesystem::path& path, const char* reason);
+}
+
+
+
+namespace Cedar::Asset
+{
+    struct AssetPack::Slot
+    {
+        std::uint64_t nameHash;
+        std::uint64_t dataOffset;
+        std::uint64_t dataSize;
+        std::uint32_t nameOffset; // Relative to the name block
+        std::uint32_t nameLength; // 0 for an empty slot
+    };
+}
+
+
+
+// OS-agnostic implementation
+namespace
+{
+    [[noreturn]] void throwInvalidPack(const std::filesystem::path& path, const char* reason)
+    {
+        throw std::runtime_error("Invalid asset pack " + path.string() + ": " + reason);
+    }
+}
+
+
+
+namespace Cedar::Asset
+{
+    AssetPack::AssetPack() = default;
+
+
+
+    AssetPack::AssetPack(const std::filesystem::path& path)
+    {
+        open(path);
+    }
+
+
+
+    AssetPack::~AssetPack()
+    {
+        close();
+    }
+
+
+
+    void AssetPack::open(const std::filesystem::path& path)
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        close();
+
+        std::size_t      size = 0;
+        const std::byte* data = mapFile(path, size);
+
+        m_data = data;
+        m_size = size;
+
+        try
+        {
+            validate();
+        }
+        catch (const std::runtime_error& e) {
+            close();
+            throwInvalidPack(path, e.what());
+        }
+    }
+
+
+
+    void AssetPack::close()
+    {
+        if (m_data != nullptr)
+            unmapFile(m_data, m_size);
+
+        m_data       = nullptr;
+        m_size       = 0;
+        m_slots      = nullptr;
+        m_slotMask   = 0;
+        m_names      = nullptr;
+        m_assetCount = 0;
+    }
+
+
+
+    bool AssetPack::contains(std::string_view name) const
+    {
+        return findSlot(name) != nullptr;
+    }
+
+
+
+    bool AssetPack::tryGet(std::string_view name, std::span<const std::byte>& data) const
+    {
+        const Slot* slot = findSlot(name);
+
+        if (slot == nullptr)
+            return false;
+
+        data = std::span<const std::byte>(m_data + slot->dataOffset, static_cast<std::size_t>(slot->dataSize));
+
+        return true;
+    }
+
+
+
+    std::span<const std::byte> AssetPack::get(std::string_view name) const
+    {
+        std::span<const std::byte> data;
+
+        if (!tryGet(name, data))
+            throw std::out_of_range("Asset pack has no asset named \"" + std::string(name) + '"');
+
+        return data;
+    }
+
+
+
+    // Checks every offset once, so lookups can trust them
+    void AssetPack::validate()
+    {
+        static_assert(sizeof(Slot) == 32);
+
+        if (m_size < sizeof(PackHeader))
+            throw std::runtime_error("file is too small");
+
+        PackHeader header;
+        std::memcpy(&header, m_data, sizeof(header));
+
+        if (header.magic != packMagic)
+            throw std::runtime_error("wrong magic");
+
+        if (header.version != packVersion)
+            throw std::runtime_error("unsupported version " + std::to_string(header.version));
+
+        if (!std::has_single_bit(header.slotCount) || header.assetCount >= header.slotCount)
+            throw std::runtime_error("bad table of contents size");
+
+        if (!std::has_single_bit(header.alignment))
+            throw std::runtime_error("bad alignment");
+
+        std::uint64_t slotsEnd = sizeof(PackHeader) + std::uint64_t(header.slotCount) * sizeof(Slot);
+
+        if (slotsEnd > m_size || header.namesOffset < slotsEnd || header.namesOffset > m_size)
+            throw std::runtime_error("table of contents is out of bounds");
+
+        // The header is 32 bytes and mappings are page aligned, so the slots are aligned
+        const Slot*   slots     = reinterpret_cast<const Slot*>(m_data + sizeof(PackHeader));
+        std::uint64_t namesSize = m_size - header.namesOffset;
+        std::size_t   usedSlots = 0;
+
+        for (std::size_t i = 0; i < header.slotCount; i++)
+        {
+            const Slot& slot = slots[i];
+
+            if (slot.nameLength == 0)
+                continue;
+
+            usedSlots++;
+
+            if (slot.nameOffset > namesSize || slot.nameLength > namesSize - slot.nameOffset)
+                throw std::runtime_error("asset name is out of bounds");
+
+            if (slot.dataOffset > m_size || slot.dataSize > m_size - slot.dataOffset)
+                throw std::runtime_error("asset data is out of bounds");
+
+            std::string_view name(reinterpret_cast<const char*>(m_data + header.namesOffset + slot.nameOffset), slot.nameLength);
+
+            if (slot.nameHash != hashAssetName(name))
+                throw std::runtime_error("asset name hash mismatch");
+        }
+
+        if (usedSlots != header.assetCount)
+            throw std::runtime_error("asset count mismatch");
+
+        m_slots      = slots;
+        m_slotMask   = header.slotCount - 1;
+        m_names      = reinterpret_cast<const char*>(m_data + header.namesOffset);
+        m_assetCount = header.assetCount;
+    }
+
+
+
+    const AssetPack::Slot* AssetPack::findSlot(std::string_view name) const
+    {
+        if (m_slots == nullptr || name.empty())
+            return nullptr;
+
+        std::uint64_t hash = hashAssetName(name);
+
+        // At most half full, so the probe always reaches an empty slot
+        for (std::size_t i = static_cast<std::size_t>(hash) & m_slotMask;; i = (i + 1) & m_slotMask)
+        {
+            const Slot& slot = m_slots[i];
+
+            if (slot.nameLength == 0)
+                return nullptr;
+
+            if (slot.nameHash == hash && std::string_view(m_names + slot.nameOffset, slot.nameLength) == name)
+                return &slot;
+        }
+    }
+
+
+
+    AssetPackBuilder::AssetPackBuilder() = default;
+
+    AssetPackBuilder::~AssetPackBuilder() = default;
+
+
+
+    void AssetPackBuilder::add(std::string_view name, std::span<const std::byte> data)
+    {
+        if (name.empty())
+            throw std::invalid_argument("Asset name is empty");
+
+        if (name.size() > UINT32_MAX)
+            throw std::invalid_argument("Asset name is too long");
+
+        std::uint64_t hash  = hashAssetName(name);
+        auto          range = m_entryIndices.equal_range(hash);
+
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (m_entries[it->second].name == name)
+                throw std::invalid_argument("Asset pack already has an asset named \"" + std::string(name) + '"');
+        }
+
+        m_entries.push_back({ std::string(name), Vector<std::byte>(data.begin(), data.end()) });
+        m_entryIndices.emplace(hash, m_entries.size() - 1);
+    }
+
+
+
+    void AssetPackBuilder::addFile(std::string_view name, const std::filesystem::path& path)
+    {
+        Vector<std::byte> data;
+
+        {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+            if (!file)
+                throw std::system_error(errno, std::generic_category(), "Failed to open asset file " + path.string());
+
+            data.resize(static_cast<std::size_t>(file.tellg()));
+            file.seekg(0);
+
+            if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())))
+                throw std::system_error(errno, std::generic_category(), "Failed to read asset file " + path.string());
+        }
+
+        add(name, data);
+    }
+
+
+
+    void AssetPackBuilder::write(const std::filesystem::path& path, std::size_t alignment) const
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        if (!std::has_single_bit(alignment) || alignment > UINT32_MAX)
+            throw std::invalid_argument("Asset pack alignment must be a power of two");
+
+        // At least twice the asset count keeps probes short and guarantees an empty slot
+        std::size_t slotCount = std::bit_ceil(std::max<std::size_t>(m_entries.size() * 2, 1));
+
+        if (slotCount > UINT32_MAX)
+            throw std::invalid_argument("Too many assets for an asset pack");
+
+        Vector<AssetPack::Slot> slots(slotCount, AssetPack::Slot{});
+        Vector<char>            names;
+
+        std::uint64_t namesOffset = sizeof(PackHeader) + slotCount * sizeof(AssetPack::Slot);
+
+        for (const Entry& entry : m_entries)
+            names.insert(names.end(), entry.name.begin(), entry.name.end());
+
+        if (names.size() > UINT32_MAX)
+            throw std::invalid_argument("Asset names are too long for an asset pack");
+
+        std::uint64_t dataOffset = (namesOffset + names.size() + alignment - 1) & ~std::uint64_t(alignment - 1);
+        std::uint32_t nameOffset = 0;
+
+        for (const Entry& entry : m_entries)
+        {
+            std::uint64_t hash = hashAssetName(entry.name);
+            std::size_t   i    = static_cast<std::size_t>(hash) & (slotCount - 1);
+
+            while (slots[i].nameLength != 0)
+                i = (i + 1) & (slotCount - 1);
+
+            slots[i] = { hash, dataOffset, entry.data.size(), nameOffset, static_cast<std::uint32_t>(entry.name.size()) };
+
+            nameOffset += static_cast<std::uint32_t>(entry.name.size());
+            dataOffset  = (dataOffset + entry.data.size() + alignment - 1) & ~std::uint64_t(alignment - 1);
+        }
+
+        PackHeader header = {
+            packMagic,
+            packVersion,
+            static_cast<std::uint32_t>(m_entries.size()),
+            static_cast<std::uint32_t>(slotCount),
+            static_cast<std::uint32_t>(alignment),
+            namesOffset
+        };
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+        if (!file)
+            throw std::system_error(errno, std::generic_category(), "Failed to open asset pack " + path.string());
+
+        const std::array<char, 4096> padding = {};
+        std::uint64_t                position = 0;
+
+        auto writeBytes = [&](const void* bytes, std::size_t size) {
+            file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+            position += size;
+        };
+
+        auto writePadding = [&]() {
+            std::size_t size = static_cast<std::size_t>((alignment - position % alignment) % alignment);
+
+            for (; size > 0; size -= std::min(size, padding.size()))
+                writeBytes(padding.data(), std::min(size, padding.size()));
+        };
+
+        writeBytes(&header, sizeof(header));
+        writeBytes(slots.data(), slots.size() * sizeof(AssetPack::Slot));
+        writeBytes(names.data(), names.size());
+
+        for (const Entry& entry : m_entries)
+        {
+            writePadding();
+            writeBytes(entry.data.data(), entry.data.size());
+        }
+
+        if (!file.flush())
+            throw std::system_error(errno, std::generic_category(), "Failed to write asset pack " + path.string());
+    }
+}
+// OS-agnostic implementation
+
+
+
+// OS-specific implementation
+#if defined(CEDAR_OS_WINDOWS) // vvv Windows vvv
+
+#include "../platform/windows.h"
+
+
+
+namespace
+{
+    const std::byte* mapFile(const std::filesystem::path& path, std::size_t& size)
+    {
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::system_error(GetLastError(), std::system_category(), "Failed to open asset pack " + path.string());
+
+        LARGE_INTEGER fileSize;
+
+        if (!GetFileSizeEx(file, &fileSize))
+        {
+            DWORD error = GetLastError();
+            (void)CloseHandle(file);
+            throw std::system_error(error, std::system_category(), "Failed to get the size of asset pack " + path.string());
+        }
+
+        // Empty files can't be mapped, validation rejects them anyway
+        if (fileSize.QuadPart == 0)
+        {
+            (void)CloseHandle(file);
+            throwInvalidPack(path, "file is too small");
+        }
+
+        // The view keeps the mapping and file open
+        HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        DWORD  error   = GetLastError();
+        (void)CloseHandle(file);
+
+        if (mapping == NULL)
+            throw std::system_error(error, std::system_category(), "Failed to map asset pack " + path.string());
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        error      = GetLastError();
+        (void)CloseHandle(mapping);
+
+        if (view == NULL)
+            throw std::system_error(error, std::system_category(), "Failed to map asset pack " + path.string());
+
+        size = static_cast<std::size_t>(fileSize.QuadPart);
+
+        return static_cast<const std::byte*>(view);
+    }
+
+
+
+    void unmapFile(const std::byte* data, std::size_t)
+    {
+        (void)UnmapViewOfFile(data);
+    }
+}
+
+#elif defined(CEDAR_OS_LINUX) // vvv Linux vvv // ^^^ Windows ^^^
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+
+namespace
+{
+    const std::byte* mapFile(const std::filesystem::path& path, std::size_t& size)
+    {
+        int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (file == -1)
+            throw std::system_error(errno, std::generic_category(), "Failed to open asset pack " + path.string());
+
+        struct stat status;
+
+        if (::fstat(file, &status) == -1)
+        {
+            int error = errno;
+            (void)::close(file);
+            throw std::system_error(error, std::generic_category(), "Failed to get the size of asset pack " + path.string());
+        }
+
+        // Empty files can't be mapped, validation rejects them anyway
+        if (status.st_size == 0)
+        {
+            (void)::close(file);
+            throwInvalidPack(path, "file is too small");
+        }
+
+        // The mapping keeps the file open
+        void* data  = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        int   error = errno;
+        (void)::close(file);
+
+        if (data == MAP_FAILED)
+            throw std::system_error(error, std::generic_category(), "Failed to map asset pack " + path.string());
+
+        size = static_cast<std::size_t>(status.st_size);
+
+        return static_cast<const std::byte*>(data);
+    }
+
+
+
+    void unmapFile(const std::byte* data, std::size_t size)
+    {
+        (void)::munmap(const_cast<std::byte*>(data), size);
+    }
+}
+
+#endif // ^^^ Linux ^^^
+// OS-specific implementation
\ No newline at end of file
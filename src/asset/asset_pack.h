@@ -0,0 +1,197 @@
+//
+// Asset packs.
+//
+// A pack is a single file holding many assets, so loading them costs one open and a
+// memory mapping instead of an open and a read per asset. Assets are returned as views
+// straight into the mapping, and only the pages that are actually touched are read from
+// disk.
+//
+// The file starts with a header, followed by the table of contents: an open addressing
+// hash table (linear probing, at most half full) of slots keyed by the FNV-1a hash of
+// each asset's name. Slots hold the name's position in the name block that follows, and
+// the position and size of the asset's data. The data of each asset starts at a multiple
+// of the pack's alignment. All values are little endian. A pack is validated once when
+// it's opened, so a lookup is a hash, a short probe and a name comparison.
+//
+// Packs are made with AssetPackBuilder, or the pack builder tool (make pack-builder).
+//
+
+#ifndef CEDAR_ASSET_ASSET_PACK_H
+#define CEDAR_ASSET_ASSET_PACK_H
+
+#include "../memory/memory_tracker.h"
+#include "../string_id.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace Cedar::Asset
+{
+    class AssetPack;
+
+    class AssetPackBuilder;
+
+
+
+    constexpr std::uint32_t packVersion          = 1;
+    constexpr std::size_t   defaultPackAlignment = 64; // Cache line, also enough for any SIMD load
+
+
+
+    // 64-bit FNV-1a, so the same as StringId(name).getHash().
+    constexpr std::uint64_t hashAssetName(std::string_view name);
+
+
+
+    // A read-only memory mapped pack. Lookups may be made from any thread.
+    class AssetPack
+    {
+    public:
+
+        AssetPack();
+
+        // Opens the pack, see open.
+        explicit AssetPack(const std::filesystem::path& path);
+
+        ~AssetPack();
+
+
+        AssetPack(const AssetPack&) = delete;
+
+        AssetPack& operator=(const AssetPack&) = delete;
+
+
+        // Maps the pack into memory, closing the one that was open. Throws
+        // std::system_error if the file can't be opened or mapped and std::runtime_error
+        // if it isn't a valid pack.
+        void open(const std::filesystem::path& path);
+
+        // Unmaps the pack. Views of its assets become invalid.
+        void close();
+
+        inline bool isOpen() const;
+
+
+        inline std::size_t getAssetCount() const;
+
+        bool contains(std::string_view name) const;
+
+        // Sets data to a view of the asset and returns true if the pack has it.
+        bool tryGet(std::string_view name, std::span<const std::byte>& data) const;
+
+        // Throws std::out_of_range if the pack doesn't have the asset.
+        std::span<const std::byte> get(std::string_view name) const;
+
+    private:
+
+        friend class AssetPackBuilder;
+
+        struct Slot;
+
+
+        const std::byte* m_data       = nullptr; // The whole file
+        std::size_t      m_size       = 0;
+        const Slot*      m_slots      = nullptr;
+        std::size_t      m_slotMask   = 0;
+        const char*      m_names      = nullptr;
+        std::size_t      m_assetCount = 0;
+
+
+        void validate();
+
+        const Slot* findSlot(std::string_view name) const;
+    };
+
+
+
+    // Collects assets and writes them out as a pack.
+    class AssetPackBuilder
+    {
+    public:
+
+        AssetPackBuilder();
+
+        ~AssetPackBuilder();
+
+
+        // Copies the data. Throws std::invalid_argument if the name is empty or already
+        // taken.
+        void add(std::string_view name, std::span<const std::byte> data);
+
+        // Reads the file's contents. Throws std::system_error if it can't be read, and
+        // std::invalid_argument like add.
+        void addFile(std::string_view name, const std::filesystem::path& path);
+
+        inline std::size_t getAssetCount() const;
+
+
+        // Writes the pack. The alignment must be a power of two. Throws
+        // std::system_error if the file can't be written.
+        void write(const std::filesystem::path& path, std::size_t alignment = defaultPackAlignment) const;
+
+    private:
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Asset>>;
+
+        struct Entry
+        {
+            std::string       name;
+            Vector<std::byte> data;
+        };
+
+        using IndexMap = std::unordered_multimap<std::uint64_t, std::size_t, std::hash<std::uint64_t>, std::equal_to<std::uint64_t>,
+                                                 Memory::TrackedAllocator<std::pair<const std::uint64_t, std::size_t>, Memory::Tag::Asset>>;
+
+
+        Vector<Entry> m_entries;
+        IndexMap      m_entryIndices; // By name hash
+    };
+
+
+
+    constexpr std::uint64_t hashAssetName(std::string_view name)
+    {
+        return hashString(name);
+    }
+
+
+
+    // vvv AssetPack function definitions vvv
+
+    inline bool AssetPack::isOpen() const
+    {
+        return m_data != nullptr;
+    }
+
+
+
+    inline std::size_t AssetPack::getAssetCount() const
+    {
+        return m_assetCount;
+    }
+
+    // ^^^ AssetPack function definitions ^^^
+
+
+
+    // vvv AssetPackBuilder function definitions vvv
+
+    inline std::size_t AssetPackBuilder::getAssetCount() const
+    {
+        return m_entries.size();
+    }
+
+    // ^^^ AssetPackBuilder function definitions ^^^
+}
+
+#endif // CEDAR_ASSET_ASSET_PACK_H
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "hot_reload.h"
+
+#include "../debug/profiler.h"
+#include "../io/log.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+
+
+
+namespace Cedar::Asset
+{
+    HotReloader::HotReloader(AssetManager& manager, std::uint64_t debounceTime) :
+        m_manager(manager),
+        m_watcher(manager.getRoot(), debounceTime)
+    {}
+
+
+
+    std::size_t HotReloader::update()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        m_changes.clear();
+
+        if (m_watcher.takeChanges(m_changes) == 0)
+            return 0;
+
+        std::size_t count = 0;
+
+        for (const std::string& name : m_changes)
+        {
+            if (m_manager.reload(name))
+            {
+                CEDAR_LOG(Cedar::Log::assetCategory, Debug, std::format("Reloading asset \"{}\"", name));
+                count++;
+            }
+        }
+
+        return count;
+    }
+}
\ No newline at end of file
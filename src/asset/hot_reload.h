@@ -0,0 +1,57 @@
+//
+// Hot reloading of assets.
+//
+// Watches the asset manager's root directory and reloads the assets whose files change.
+// The watcher debounces bursts of changes on its own thread and the manager reads the
+// changed files with FileIO in the background, swapping the new data in during its
+// update, so the main loop never waits on either.
+//
+// Only assets the manager already knows are reloaded, anything else that changes is
+// ignored until it's asked for.
+//
+
+#ifndef CEDAR_ASSET_HOT_RELOAD_H
+#define CEDAR_ASSET_HOT_RELOAD_H
+
+#include "asset_manager.h"
+#include "../io/file_watcher.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+
+namespace Cedar::Asset
+{
+    class HotReloader;
+
+
+
+    class HotReloader
+    {
+    public:
+
+        // Throws std::system_error if the manager's root can't be watched.
+        explicit HotReloader(AssetManager& manager, std::uint64_t debounceTime = FileIO::defaultDebounceTime);
+
+
+        HotReloader(const HotReloader&) = delete;
+
+        HotReloader& operator=(const HotReloader&) = delete;
+
+
+        // Queues reloads for the assets whose changes have settled. Call once per frame,
+        // before the manager's update. Returns how many were queued.
+        std::size_t update();
+
+    private:
+
+        AssetManager&            m_manager;
+        FileIO::FileWatcher      m_watcher;
+        std::vector<std::string> m_changes; // Reused between updates
+    };
+}
+
+#endif // CEDAR_ASSET_HOT_RELOAD_H
\ No newline at end of file
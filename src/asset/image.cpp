@@ -0,0 +1,1097 @@
+#include "image.h"
+
+#include "inflate.h"
+#include "../core.h"
+#include "../debug/profiler.h"
+#include "../graphics/pixel_convert.h"
+#include "../graphics/surface.h"
+#include "../jobs/job_system.h"
+#include "../math/size.h"
+#include "../memory/memory_tracker.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(CEDAR_SIMD_SSE2)
+    #include <emmintrin.h>
+#endif
+
+
+
+namespace
+{
+    using Cedar::Graphics::Pixel;
+
+    template <typename T>
+    using Vector = std::vector<T, Cedar::Memory::TrackedAllocator<T, Cedar::Memory::Tag::Asset>>;
+
+    typedef std::span<const std::uint8_t> Bytes;
+
+
+
+    // Guards against allocating for bogus headers, 1 GB of Pixels
+    constexpr std::size_t maxPixelCount = std::size_t(1) << 28;
+
+    constexpr std::array<std::uint8_t, 8> pngSignature = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+
+
+    enum class TexelFormat {
+        Gray,
+        Rgb,
+        Bgr,
+        Rgba,
+        Bgra,
+        Bgrx  // BGRA with an unused fourth byte
+    };
+
+
+
+    struct PngHeader;
+
+    struct PngPass;
+
+
+
+    struct PngHeader
+    {
+        int  width;
+        int  height;
+        int  bitDepth;
+        int  colorType;
+        bool interlaced;
+
+        std::array<std::uint8_t, 256 * 4> palette; // RGBA
+        int                               paletteSize = 0;
+
+        bool                         hasColorKey = false; // Color that is fully transparent
+        std::array<std::uint16_t, 3> colorKey;            // Gray, or red, green and blue
+    };
+
+
+
+    struct PngPass
+    {
+        int xStart;
+        int yStart;
+        int xStep;
+        int yStep;
+    };
+
+
+
+    // Adam7, passes of an interlaced image
+    constexpr std::array<PngPass, 7> adam7Passes = { {
+        { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 }
+    } };
+
+    constexpr PngPass wholeImagePass = { 0, 0, 1, 1 };
+
+
+
+    std::uint32_t readLittleEndian(Bytes data, std::size_t offset, int size);
+
+    std::uint32_t readBigEndian32(Bytes data, std::size_t offset);
+
+    [[noreturn]] void throwTruncated(const char* format);
+
+    Cedar::Asset::Image createImage(std::int64_t width, std::int64_t height, const Cedar::Asset::ImageOptions& options);
+
+    void convertRow(Pixel* destination, const std::uint8_t* texels, TexelFormat format, int count);
+
+    void finishImage(Cedar::Asset::Image& image, const Cedar::Asset::ImageOptions& options);
+
+    Cedar::Asset::Image decodeTga(Bytes data, const Cedar::Asset::ImageOptions& options);
+
+    Cedar::Asset::Image decodeBmp(Bytes data, const Cedar::Asset::ImageOptions& options);
+
+    Cedar::Asset::Image decodePnm(Bytes data, const Cedar::Asset::ImageOptions& options);
+
+    Cedar::Asset::Image decodePng(Bytes data, const Cedar::Asset::ImageOptions& options);
+
+    PngHeader readPngChunks(Bytes data, Bytes& compressed, Vector<std::uint8_t>& compressedCopy);
+
+    void unfilterPngRow(std::uint8_t filter, std::uint8_t* row, const std::uint8_t* prior, std::size_t rowSize, std::size_t pixelSize);
+
+    void convertPngRow(const PngHeader& header, const std::uint8_t* row, Pixel* destination, int count, Vector<std::uint8_t>& scratch);
+}
+
+
+
+namespace
+{
+    std::uint32_t readLittleEndian(Bytes data, std::size_t offset, int size)
+    {
+        if (offset + size > data.size())
+            throw std::runtime_error("Image header is truncated");
+
+        std::uint32_t value = 0;
+
+        for (int i = size - 1; i >= 0; i--)
+            value = value << 8 | data[offset + i];
+
+        return value;
+    }
+
+
+
+    std::uint32_t readBigEndian32(Bytes data, std::size_t offset)
+    {
+        if (offset + 4 > data.size())
+            throw std::runtime_error("Image header is truncated");
+
+        return std::uint32_t(data[offset]) << 24 | data[offset + 1] << 16 | data[offset + 2] << 8 | data[offset + 3];
+    }
+
+
+
+    void throwTruncated(const char* format)
+    {
+        throw std::runtime_error(std::string(format) + " image data is truncated");
+    }
+
+
+
+    Cedar::Asset::Image createImage(std::int64_t width, std::int64_t height, const Cedar::Asset::ImageOptions& options)
+    {
+        if (width <= 0 || height <= 0)
+            throw std::runtime_error("Image size is invalid");
+
+        if (static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height) > maxPixelCount)
+            throw std::runtime_error("Image is too large");
+
+        return Cedar::Asset::Image({ static_cast<int>(width), static_cast<int>(height) }, options.generateMips);
+    }
+
+
+
+    void convertRow(Pixel* destination, const std::uint8_t* texels, TexelFormat format, int count)
+    {
+        switch (format) {
+            case TexelFormat::Gray: {
+                for (int x = 0; x < count; x++)
+                    destination[x] = Cedar::Graphics::makePixel(texels[x], texels[x], texels[x]);
+                break;
+            }
+            case TexelFormat::Rgb:
+                Cedar::Graphics::convertRgbRow(destination, texels, count); break;
+            case TexelFormat::Bgr:
+                Cedar::Graphics::convertBgrRow(destination, texels, count); break;
+            case TexelFormat::Rgba:
+                Cedar::Graphics::convertRgbaRow(destination, texels, count); break;
+            case TexelFormat::Bgra:
+                Cedar::Graphics::convertBgraRow(destination, texels, count); break;
+            case TexelFormat::Bgrx: {
+                Cedar::Graphics::convertBgraRow(destination, texels, count);
+
+                for (int x = 0; x < count; x++)
+                    destination[x] |= 0xFF000000;
+                break;
+            }
+        }
+    }
+
+
+
+    void finishImage(Cedar::Asset::Image& image, const Cedar::Asset::ImageOptions& options)
+    {
+        Cedar::Graphics::Surface surface = image.getSurface();
+
+        if (options.linearize || options.premultiply)
+        {
+            CEDAR_PROFILE_SCOPE("Image::convert");
+
+            // sRGB to linear first, so colors are premultiplied in linear space
+            for (int y = 0; y < surface.size.height; y++)
+            {
+                if (options.linearize)
+                    Cedar::Graphics::linearizeRow(surface.getRow(y), surface.size.width);
+
+                if (options.premultiply)
+                    Cedar::Graphics::premultiplyRow(surface.getRow(y), surface.size.width);
+            }
+        }
+
+        if (image.getMipCount() > 1)
+            image.updateMips();
+    }
+
+
+
+    Cedar::Asset::Image decodeTga(Bytes data, const Cedar::Asset::ImageOptions& options)
+    {
+        constexpr std::size_t headerSize = 18;
+
+        if (data.size() < headerSize)
+            throwTruncated("TGA");
+
+        int idLength     = data[0];
+        int colorMapType = data[1];
+        int imageType    = data[2];
+        int width        = readLittleEndian(data, 12, 2);
+        int height       = readLittleEndian(data, 14, 2);
+        int depth        = data[16];
+        int descriptor   = data[17];
+
+        bool runLengthEncoded = (imageType & 8) != 0;
+        bool gray             = (imageType & ~8) == 3;
+
+        if (colorMapType != 0 || (imageType & ~8) == 1)
+            throw std::runtime_error("Color-mapped TGA images are not supported");
+
+        if ((imageType & ~8) != 2 && !gray)
+            throw std::runtime_error("Unsupported TGA image type");
+
+        if (gray ? depth != 8 : (depth != 24 && depth != 32))
+            throw std::runtime_error("Unsupported TGA pixel depth");
+
+        if ((descriptor & 0x10) != 0)
+            throw std::runtime_error("Right-to-left TGA images are not supported");
+
+        TexelFormat format = TexelFormat::Gray;
+
+        if (depth == 24)
+            format = TexelFormat::Bgr;
+        else if (depth == 32)
+            format = ((descriptor & 0x0F) != 0) ? TexelFormat::Bgra : TexelFormat::Bgrx; // No alpha bits, no alpha
+
+        Cedar::Asset::Image image = createImage(width, height, options);
+
+        std::size_t texelSize = depth / 8;
+        std::size_t rowSize   = width * texelSize;
+        std::size_t dataSize  = rowSize * height;
+        std::size_t offset    = headerSize + idLength;
+
+        Bytes                texels;
+        Vector<std::uint8_t> decoded;
+
+        if (runLengthEncoded)
+        {
+            decoded.resize(dataSize);
+
+            // Packets of up to 128 texels, either repeating one texel or copied as is.
+            // They may cross rows
+            std::size_t position = 0;
+
+            while (position < dataSize)
+            {
+                if (offset >= data.size())
+                    throwTruncated("TGA");
+
+                int         packet    = data[offset++];
+                std::size_t count     = std::min<std::size_t>((packet & 0x7F) + 1, (dataSize - position) / texelSize);
+                bool        repeating = (packet & 0x80) != 0;
+                std::size_t readSize  = repeating ? texelSize : count * texelSize;
+
+                if (readSize > data.size() - offset)
+                    throwTruncated("TGA");
+
+                if (repeating)
+                {
+                    for (std::size_t i = 0; i < count; i++)
+                        std::memcpy(decoded.data() + position + i * texelSize, data.data() + offset, texelSize);
+                }
+                else
+                {
+                    std::memcpy(decoded.data() + position, data.data() + offset, readSize);
+                }
+
+                offset   += readSize;
+                position += count * texelSize;
+            }
+
+            texels = decoded;
+        }
+        else
+        {
+            if (offset > data.size() || dataSize > data.size() - offset)
+                throwTruncated("TGA");
+
+            texels = data.subspan(offset, dataSize);
+        }
+
+        bool                     topToBottom = (descriptor & 0x20) != 0;
+        Cedar::Graphics::Surface surface     = image.getSurface();
+
+        for (int y = 0; y < height; y++)
+            convertRow(surface.getRow(topToBottom ? y : height - 1 - y), texels.data() + y * rowSize, format, width);
+
+        finishImage(image, options);
+
+        return image;
+    }
+
+
+
+    Cedar::Asset::Image decodeBmp(Bytes data, const Cedar::Asset::ImageOptions& options)
+    {
+        constexpr std::size_t fileHeaderSize = 14;
+
+        std::size_t   dataOffset  = readLittleEndian(data, 10, 4);
+        std::size_t   infoSize    = readLittleEndian(data, 14, 4);
+        std::int32_t  width       = static_cast<std::int32_t>(readLittleEndian(data, 18, 4));
+        std::int32_t  height      = static_cast<std::int32_t>(readLittleEndian(data, 22, 4));
+        int           bitCount    = readLittleEndian(data, 28, 2);
+        std::uint32_t compression = readLittleEndian(data, 30, 4);
+
+        constexpr std::uint32_t uncompressed = 0; // BI_RGB
+        constexpr std::uint32_t bitFields    = 3; // BI_BITFIELDS
+        constexpr std::uint32_t alphaFields  = 6; // BI_ALPHABITFIELDS
+
+        if (infoSize < 40)
+            throw std::runtime_error("Unsupported BMP header");
+
+        // Negative heights are stored top to bottom
+        bool topToBottom = height < 0;
+        height           = topToBottom ? -height : height;
+
+        TexelFormat format;
+
+        if (bitCount == 24 && compression == uncompressed)
+        {
+            format = TexelFormat::Bgr;
+        }
+        else if (bitCount == 32 && compression == uncompressed)
+        {
+            format = TexelFormat::Bgrx;
+        }
+        else if (bitCount == 32 && (compression == bitFields || compression == alphaFields))
+        {
+            // Masks follow the 40-byte header, or are part of the larger ones
+            std::uint32_t redMask   = readLittleEndian(data, fileHeaderSize + 40, 4);
+            std::uint32_t greenMask = readLittleEndian(data, fileHeaderSize + 44, 4);
+            std::uint32_t blueMask  = readLittleEndian(data, fileHeaderSize + 48, 4);
+            std::uint32_t alphaMask = (infoSize >= 56 || compression == alphaFields) ? readLittleEndian(data, fileHeaderSize + 52, 4) : 0;
+
+            if (redMask != 0x00FF0000 || greenMask != 0x0000FF00 || blueMask != 0x000000FF || (alphaMask != 0 && alphaMask != 0xFF000000))
+                throw std::runtime_error("Unsupported BMP channel masks");
+
+            format = (alphaMask != 0) ? TexelFormat::Bgra : TexelFormat::Bgrx;
+        }
+        else if (bitCount == 8 && compression == uncompressed)
+        {
+            format = TexelFormat::Bgrx; // Of the palette, indices are looked up below
+        }
+        else
+        {
+            throw std::runtime_error("Unsupported BMP format, only uncompressed 8, 24 and 32-bit images are");
+        }
+
+        Cedar::Asset::Image image = createImage(width, height, options);
+
+        // Rows are padded to 4 bytes
+        std::size_t rowSize = (static_cast<std::size_t>(width) * bitCount + 31) / 32 * 4;
+
+        if (dataOffset > data.size() || rowSize * height > data.size() - dataOffset)
+            throwTruncated("BMP");
+
+        Cedar::Graphics::Surface surface = image.getSurface();
+
+        if (bitCount == 8)
+        {
+            std::size_t paletteOffset = fileHeaderSize + infoSize;
+            std::size_t paletteSize   = readLittleEndian(data, 46, 4);
+
+            if (paletteSize == 0 || paletteSize > 256)
+                paletteSize = 256;
+
+            if (paletteOffset > data.size() || paletteSize * 4 > data.size() - paletteOffset)
+                throwTruncated("BMP");
+
+            std::array<Pixel, 256> palette = {};
+
+            // Entries are blue, green, red and an unused byte
+            convertRow(palette.data(), data.data() + paletteOffset, TexelFormat::Bgrx, static_cast<int>(paletteSize));
+
+            for (int y = 0; y < height; y++)
+            {
+                const std::uint8_t* indices = data.data() + dataOffset + y * rowSize;
+                Pixel*              row     = surface.getRow(topToBottom ? y : height - 1 - y);
+
+                for (int x = 0; x < width; x++)
+                    row[x] = palette[indices[x]];
+            }
+        }
+        else
+        {
+            for (int y = 0; y < height; y++)
+                convertRow(surface.getRow(topToBottom ? y : height - 1 - y), data.data() + dataOffset + y * rowSize, format, width);
+        }
+
+        finishImage(image, options);
+
+        return image;
+    }
+
+
+
+    // Binary PGM (P5) and PPM (P6)
+    Cedar::Asset::Image decodePnm(Bytes data, const Cedar::Asset::ImageOptions& options)
+    {
+        std::size_t position = 2;
+
+        // Width, height and maximum value, separated by whitespace and comments
+        auto readNumber = [&data, &position]() {
+            while (position < data.size())
+            {
+                if (data[position] == '#')
+                {
+                    while (position < data.size() && data[position] != '\n')
+                        position++;
+                }
+                else if (data[position] == ' ' || (data[position] >= '\t' && data[position] <= '\r'))
+                {
+                    position++;
+                }
+                else
+                {
+                    break;
+                }
+            }
+
+            std::int64_t value  = 0;
+            std::size_t  digits = 0;
+
+            for (; position < data.size() && data[position] >= '0' && data[position] <= '9' && digits < 9; position++, digits++)
+                value = value * 10 + (data[position] - '0');
+
+            if (digits == 0)
+                throw std::runtime_error("PNM header is malformed");
+
+            return value;
+        };
+
+        bool         color    = data[1] == '6';
+        std::int64_t width    = readNumber();
+        std::int64_t height   = readNumber();
+        std::int64_t maxValue = readNumber();
+
+        if (maxValue < 1 || maxValue > 65535)
+            throw std::runtime_error("PNM maximum value is invalid");
+
+        position++; // A single whitespace character before the data
+
+        Cedar::Asset::Image image = createImage(width, height, options);
+
+        std::size_t sampleCount = static_cast<std::size_t>(width) * (color ? 3 : 1);
+        std::size_t sampleSize  = (maxValue > 255) ? 2 : 1;
+        std::size_t rowSize     = sampleCount * sampleSize;
+
+        if (position > data.size() || rowSize * height > data.size() - position)
+            throwTruncated("PNM");
+
+        TexelFormat              format  = color ? TexelFormat::Rgb : TexelFormat::Gray;
+        Cedar::Graphics::Surface surface = image.getSurface();
+        Vector<std::uint8_t>     scaled;
+
+        if (maxValue != 255)
+            scaled.resize(sampleCount);
+
+        for (int y = 0; y < height; y++)
+        {
+            const std::uint8_t* samples = data.data() + position + y * rowSize;
+
+            // Samples are big endian when they take two bytes
+            if (maxValue != 255)
+            {
+                for (std::size_t i = 0; i < sampleCount; i++)
+                {
+                    std::uint32_t value = (sampleSize == 2) ? (samples[i * 2] << 8 | samples[i * 2 + 1]) : samples[i];
+                    scaled[i] = static_cast<std::uint8_t>((std::min<std::uint32_t>(value, maxValue) * 255 + maxValue / 2) / maxValue);
+                }
+
+                samples = scaled.data();
+            }
+
+            convertRow(surface.getRow(y), samples, format, static_cast<int>(width));
+        }
+
+        finishImage(image, options);
+
+        return image;
+    }
+
+
+
+    Cedar::Asset::Image decodePng(Bytes data, const Cedar::Asset::ImageOptions& options)
+    {
+        Bytes                compressed;
+        Vector<std::uint8_t> compressedCopy;
+
+        PngHeader header = readPngChunks(data, compressed, compressedCopy);
+
+        Cedar::Asset::Image image = createImage(header.width, header.height, options);
+
+        static constexpr std::array<int, 7> channelCounts = { 1, 0, 3, 1, 2, 0, 4 }; // By color type
+
+        std::size_t pixelBits = static_cast<std::size_t>(channelCounts[header.colorType]) * header.bitDepth;
+        std::size_t pixelSize = std::max<std::size_t>(pixelBits / 8, 1); // Distance to the byte filters use as left
+
+        std::span<const PngPass> passes = header.interlaced ? std::span<const PngPass>(adam7Passes)
+                                                            : std::span<const PngPass>(&wholeImagePass, 1);
+
+        auto getPassSize = [&header](const PngPass& pass) {
+            return Cedar::Size2D<int>{ (header.width - pass.xStart + pass.xStep - 1) / pass.xStep,
+                                       (header.height - pass.yStart + pass.yStep - 1) / pass.yStep };
+        };
+
+        // Every row of every pass starts with its filter type
+        std::size_t rawSize = 0;
+
+        for (const PngPass& pass : passes)
+        {
+            Cedar::Size2D<int> size = getPassSize(pass);
+
+            if (size.width > 0 && size.height > 0)
+                rawSize += (1 + (size.width * pixelBits + 7) / 8) * size.height;
+        }
+
+        Vector<std::uint8_t> raw(rawSize);
+
+        {
+            CEDAR_PROFILE_SCOPE("Image::inflate");
+
+            if (Cedar::Asset::inflateZlib(compressed, raw) != rawSize)
+                throwTruncated("PNG");
+        }
+
+        CEDAR_PROFILE_SCOPE("Image::unfilter");
+
+        Cedar::Graphics::Surface surface = image.getSurface();
+        Vector<std::uint8_t>     zeroRow((header.width * pixelBits + 7) / 8);
+        Vector<std::uint8_t>     scratch;
+        Vector<Pixel>            passPixels;
+        std::uint8_t*            row = raw.data();
+
+        for (const PngPass& pass : passes)
+        {
+            Cedar::Size2D<int> size = getPassSize(pass);
+
+            if (size.width <= 0 || size.height <= 0)
+                continue;
+
+            std::size_t         rowSize = (size.width * pixelBits + 7) / 8;
+            const std::uint8_t* prior   = zeroRow.data();
+
+            if (header.interlaced)
+                passPixels.resize(size.width);
+
+            for (int y = 0; y < size.height; y++)
+            {
+                unfilterPngRow(row[0], row + 1, prior, rowSize, pixelSize);
+
+                int imageY = pass.yStart + y * pass.yStep;
+
+                if (header.interlaced)
+                {
+                    convertPngRow(header, row + 1, passPixels.data(), size.width, scratch);
+
+                    Pixel* imageRow = surface.getRow(imageY);
+
+                    for (int x = 0; x < size.width; x++)
+                        imageRow[pass.xStart + x * pass.xStep] = passPixels[x];
+                }
+                else
+                {
+                    convertPngRow(header, row + 1, surface.getRow(imageY), size.width, scratch);
+                }
+
+                prior  = row + 1;
+                row   += 1 + rowSize;
+            }
+        }
+
+        finishImage(image, options);
+
+        return image;
+    }
+
+
+
+    // Reads the header and the chunks that matter for decoding. The compressed data is
+    // viewed in place when it's in a single chunk, as it usually is, and otherwise
+    // copied together.
+    PngHeader readPngChunks(Bytes data, Bytes& compressed, Vector<std::uint8_t>& compressedCopy)
+    {
+        PngHeader   header;
+        bool        headerRead     = false;
+        bool        ended          = false;
+        std::size_t dataChunkCount = 0;
+        std::size_t position       = pngSignature.size();
+
+        while (!ended)
+        {
+            if (position + 8 > data.size())
+                throwTruncated("PNG");
+
+            std::size_t length = readBigEndian32(data, position);
+            Bytes       type   = data.subspan(position + 4, 4);
+
+            if (length > data.size() - position - 12)
+                throwTruncated("PNG");
+
+            Bytes chunk = data.subspan(position + 8, length);
+            position   += 12 + length; // Length, type, data and CRC
+
+            auto isType = [&type](const char* name) { return std::memcmp(type.data(), name, 4) == 0; };
+
+            if (!headerRead)
+            {
+                if (!isType("IHDR") || length < 13)
+                    throw std::runtime_error("PNG header is malformed");
+
+                std::uint32_t width  = readBigEndian32(chunk, 0);
+                std::uint32_t height = readBigEndian32(chunk, 4);
+
+                if (width == 0 || height == 0 || width > 0x7FFFFFFF || height > 0x7FFFFFFF ||
+                    static_cast<std::uint64_t>(width) * height > maxPixelCount)
+                {
+                    throw std::runtime_error("PNG image size is invalid or too large");
+                }
+
+                header.width      = static_cast<int>(width);
+                header.height     = static_cast<int>(height);
+                header.bitDepth   = chunk[8];
+                header.colorType  = chunk[9];
+                header.interlaced = chunk[12] == 1;
+
+                bool validDepth = false;
+
+                switch (header.colorType) {
+                    case 0: // Gray
+                        validDepth = header.bitDepth == 1 || header.bitDepth == 2 || header.bitDepth == 4 ||
+                                     header.bitDepth == 8 || header.bitDepth == 16;
+                        break;
+                    case 3: // Palette
+                        validDepth = header.bitDepth == 1 || header.bitDepth == 2 || header.bitDepth == 4 || header.bitDepth == 8;
+                        break;
+                    case 2: // RGB
+                    case 4: // Gray and alpha
+                    case 6: // RGBA
+                        validDepth = header.bitDepth == 8 || header.bitDepth == 16;
+                        break;
+                }
+
+                if (!validDepth || chunk[10] != 0 || chunk[11] != 0 || chunk[12] > 1)
+                    throw std::runtime_error("Unsupported PNG format");
+
+                headerRead = true;
+            }
+            else if (isType("PLTE"))
+            {
+                if (length % 3 != 0 || length > 256 * 3)
+                    throw std::runtime_error("PNG palette is malformed");
+
+                header.paletteSize = static_cast<int>(length / 3);
+
+                for (int i = 0; i < header.paletteSize; i++)
+                {
+                    header.palette[i * 4]     = chunk[i * 3];
+                    header.palette[i * 4 + 1] = chunk[i * 3 + 1];
+                    header.palette[i * 4 + 2] = chunk[i * 3 + 2];
+                    header.palette[i * 4 + 3] = 255;
+                }
+            }
+            else if (isType("tRNS"))
+            {
+                if (header.colorType == 3)
+                {
+                    // Alpha of the first palette entries
+                    for (std::size_t i = 0; i < std::min<std::size_t>(length, header.paletteSize); i++)
+                        header.palette[i * 4 + 3] = chunk[i];
+                }
+                else if (header.colorType == 0 && length >= 2)
+                {
+                    header.hasColorKey = true;
+                    header.colorKey[0] = static_cast<std::uint16_t>(chunk[0] << 8 | chunk[1]);
+                }
+                else if (header.colorType == 2 && length >= 6)
+                {
+                    header.hasColorKey = true;
+
+                    for (int i = 0; i < 3; i++)
+                        header.colorKey[i] = static_cast<std::uint16_t>(chunk[i * 2] << 8 | chunk[i * 2 + 1]);
+                }
+            }
+            else if (isType("IDAT"))
+            {
+                if (dataChunkCount == 1)
+                    compressedCopy.assign(compressed.begin(), compressed.end());
+
+                if (dataChunkCount == 0)
+                    compressed = chunk;
+                else
+                    compressedCopy.insert(compressedCopy.end(), chunk.begin(), chunk.end());
+
+                dataChunkCount++;
+            }
+            else if (isType("IEND"))
+            {
+                ended = true;
+            }
+        }
+
+        if (header.colorType == 3 && header.paletteSize == 0)
+            throw std::runtime_error("PNG palette is missing");
+
+        if (dataChunkCount == 0)
+            throw std::runtime_error("PNG image data is missing");
+
+        if (dataChunkCount > 1)
+            compressed = compressedCopy;
+
+        return header;
+    }
+
+
+
+    void unfilterPngRow(std::uint8_t filter, std::uint8_t* row, const std::uint8_t* prior, std::size_t rowSize, std::size_t pixelSize)
+    {
+        switch (filter) {
+            case 0: // None
+                break;
+            case 1: { // Sub
+                for (std::size_t i = pixelSize; i < rowSize; i++)
+                    row[i] = static_cast<std::uint8_t>(row[i] + row[i - pixelSize]);
+                break;
+            }
+            case 2: { // Up
+                for (std::size_t i = 0; i < rowSize; i++)
+                    row[i] = static_cast<std::uint8_t>(row[i] + prior[i]);
+                break;
+            }
+            case 3: { // Average
+                for (std::size_t i = 0; i < pixelSize && i < rowSize; i++)
+                    row[i] = static_cast<std::uint8_t>(row[i] + prior[i] / 2);
+
+                for (std::size_t i = pixelSize; i < rowSize; i++)
+                    row[i] = static_cast<std::uint8_t>(row[i] + (row[i - pixelSize] + prior[i]) / 2);
+                break;
+            }
+            case 4: { // Paeth
+                for (std::size_t i = 0; i < pixelSize && i < rowSize; i++)
+                    row[i] = static_cast<std::uint8_t>(row[i] + prior[i]);
+
+                std::size_t i = pixelSize;
+
+#if defined(CEDAR_SIMD_SSE2)
+                // Each pixel depends on the one to its left, so this is only parallel
+                // across the channels of RGBA pixels
+                if (pixelSize == 4)
+                {
+                    const __m128i zero = _mm_setzero_si128();
+
+                    auto load = [&zero](const std::uint8_t* pixel) {
+                        std::int32_t value;
+                        std::memcpy(&value, pixel, 4);
+                        return _mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero);
+                    };
+
+                    auto absolute = [&zero](__m128i value) { return _mm_max_epi16(value, _mm_sub_epi16(zero, value)); };
+
+                    __m128i left = load(row);
+
+                    for (; i + 4 <= rowSize; i += 4)
+                    {
+                        __m128i up        = load(prior + i);
+                        __m128i upperLeft = load(prior + i - 4);
+
+                        // Distances of the estimate left + up - upperLeft to each
+                        __m128i leftDistance      = absolute(_mm_sub_epi16(up, upperLeft));
+                        __m128i upDistance        = absolute(_mm_sub_epi16(left, upperLeft));
+                        __m128i upperLeftDistance = absolute(_mm_sub_epi16(_mm_add_epi16(left, up), _mm_add_epi16(upperLeft, upperLeft)));
+
+                        __m128i notLeft = _mm_or_si128(_mm_cmpgt_epi16(leftDistance, upDistance),
+                                                       _mm_cmpgt_epi16(leftDistance, upperLeftDistance));
+                        __m128i notUp   = _mm_cmpgt_epi16(upDistance, upperLeftDistance);
+
+                        __m128i upOrUpperLeft = _mm_or_si128(_mm_andnot_si128(notUp, up), _mm_and_si128(notUp, upperLeft));
+                        __m128i predictor     = _mm_or_si128(_mm_andnot_si128(notLeft, left), _mm_and_si128(notLeft, upOrUpperLeft));
+
+                        left = _mm_and_si128(_mm_add_epi16(load(row + i), predictor), _mm_set1_epi16(0xFF));
+
+                        std::int32_t value = _mm_cvtsi128_si32(_mm_packus_epi16(left, zero));
+                        std::memcpy(row + i, &value, 4);
+                    }
+                }
+#endif
+
+                for (; i < rowSize; i++)
+                {
+                    int left      = row[i - pixelSize];
+                    int up        = prior[i];
+                    int upperLeft = prior[i - pixelSize];
+
+                    // Distances of the estimate left + up - upperLeft to each
+                    int leftDistance      = std::abs(up - upperLeft);
+                    int upDistance        = std::abs(left - upperLeft);
+                    int upperLeftDistance = std::abs(left + up - 2 * upperLeft);
+
+                    int predictor = (leftDistance <= upDistance && leftDistance <= upperLeftDistance) ? left
+                                  : (upDistance <= upperLeftDistance) ? up : upperLeft;
+
+                    row[i] = static_cast<std::uint8_t>(row[i] + predictor);
+                }
+                break;
+            }
+            default:
+                throw std::runtime_error("PNG row filter is invalid");
+        }
+    }
+
+
+
+    void convertPngRow(const PngHeader& header, const std::uint8_t* row, Pixel* destination, int count, Vector<std::uint8_t>& scratch)
+    {
+        // The common formats convert straight from the row
+        if (header.bitDepth == 8 && header.colorType == 2 && !header.hasColorKey)
+        {
+            Cedar::Graphics::convertRgbRow(destination, row, count);
+            return;
+        }
+
+        if (header.bitDepth == 8 && header.colorType == 6)
+        {
+            Cedar::Graphics::convertRgbaRow(destination, row, count);
+            return;
+        }
+
+        // Everything else is expanded to RGBA first
+        scratch.resize(static_cast<std::size_t>(count) * 4);
+
+        int           depth    = header.bitDepth;
+        std::uint32_t maxValue = (1u << depth) - 1;
+
+        auto getSample = [row, depth](std::size_t index) -> std::uint32_t {
+            if (depth == 8)
+                return row[index];
+
+            if (depth == 16)
+                return row[index * 2] << 8 | row[index * 2 + 1];
+
+            std::size_t bit = index * depth;
+            return (row[bit / 8] >> (8 - depth - bit % 8)) & ((1u << depth) - 1);
+        };
+
+        auto to8Bits = [depth, maxValue](std::uint32_t sample) -> std::uint8_t {
+            if (depth == 16)
+                return static_cast<std::uint8_t>(sample >> 8);
+
+            return static_cast<std::uint8_t>(sample * 255 / maxValue);
+        };
+
+        std::uint8_t* rgba = scratch.data();
+
+        for (int x = 0; x < count; x++, rgba += 4)
+        {
+            switch (header.colorType) {
+                case 0: { // Gray
+                    std::uint32_t gray = getSample(x);
+
+                    rgba[0] = rgba[1] = rgba[2] = to8Bits(gray);
+                    rgba[3] = (header.hasColorKey && gray == header.colorKey[0]) ? 0 : 255;
+                    break;
+                }
+                case 2: { // RGB
+                    std::uint32_t red   = getSample(x * 3);
+                    std::uint32_t green = getSample(x * 3 + 1);
+                    std::uint32_t blue  = getSample(x * 3 + 2);
+
+                    rgba[0] = to8Bits(red);
+                    rgba[1] = to8Bits(green);
+                    rgba[2] = to8Bits(blue);
+                    rgba[3] = (header.hasColorKey && red == header.colorKey[0] && green == header.colorKey[1] && blue == header.colorKey[2]) ? 0 : 255;
+                    break;
+                }
+                case 3: { // Palette
+                    std::uint32_t index = getSample(x);
+
+                    if (index >= static_cast<std::uint32_t>(header.paletteSize))
+                        throw std::runtime_error("PNG palette index is out of range");
+
+                    std::memcpy(rgba, header.palette.data() + index * 4, 4);
+                    break;
+                }
+                case 4: { // Gray and alpha
+                    rgba[0] = rgba[1] = rgba[2] = to8Bits(getSample(x * 2));
+                    rgba[3] = to8Bits(getSample(x * 2 + 1));
+                    break;
+                }
+                default: { // RGBA
+                    for (int channel = 0; channel < 4; channel++)
+                        rgba[channel] = to8Bits(getSample(x * 4 + channel));
+                    break;
+                }
+            }
+        }
+
+        Cedar::Graphics::convertRgbaRow(destination, scratch.data(), count);
+    }
+}
+
+
+
+namespace Cedar::Asset
+{
+    Image::Image() {}
+
+
+
+    Image::Image(Size2D<int> size, bool withMips)
+    {
+        if (size.width <= 0 || size.height <= 0)
+            throw std::invalid_argument("Image size must be positive");
+
+        m_size     = size;
+        m_mipCount = 1;
+
+        std::size_t pixelCount = static_cast<std::size_t>(size.width) * size.height;
+
+        while (withMips && (size.width > 1 || size.height > 1))
+        {
+            size        = { std::max(size.width / 2, 1), std::max(size.height / 2, 1) };
+            pixelCount += static_cast<std::size_t>(size.width) * size.height;
+            m_mipCount++;
+        }
+
+        m_pixels.resize(pixelCount);
+    }
+
+
+
+    Graphics::Surface Image::getMip(std::size_t level)
+    {
+        if (level >= m_mipCount)
+            throw std::out_of_range("Image has no such mip level");
+
+        Size2D<int> size   = m_size;
+        std::size_t offset = 0;
+
+        for (std::size_t i = 0; i < level; i++)
+        {
+            offset += static_cast<std::size_t>(size.width) * size.height;
+            size    = { std::max(size.width / 2, 1), std::max(size.height / 2, 1) };
+        }
+
+        return { m_pixels.data() + offset, size, size.width };
+    }
+
+
+
+    void Image::updateMips()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        for (std::size_t level = 1; level < m_mipCount; level++)
+        {
+            Graphics::Surface source      = getMip(level - 1);
+            Graphics::Surface destination = getMip(level);
+
+            // A 1 pixel wide or tall level is averaged with itself along that axis, an odd
+            // last row or column is dropped
+            if (source.size.width == 1)
+            {
+                for (int y = 0; y < destination.size.height; y++)
+                {
+                    Pixel pair[2] = { source.getRow(y * 2)[0], source.getRow(std::min(y * 2 + 1, source.size.height - 1))[0] };
+                    Graphics::downsampleRow(destination.getRow(y), pair, pair, 1);
+                }
+
+                continue;
+            }
+
+            for (int y = 0; y < destination.size.height; y++)
+            {
+                const Pixel* row0 = source.getRow(std::min(y * 2, source.size.height - 1));
+                const Pixel* row1 = source.getRow(std::min(y * 2 + 1, source.size.height - 1));
+
+                Graphics::downsampleRow(destination.getRow(y), row0, row1, destination.size.width);
+            }
+        }
+    }
+
+
+
+    Image decodeImage(std::span<const std::byte> data, const ImageOptions& options)
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        Bytes bytes(reinterpret_cast<const std::uint8_t*>(data.data()), data.size());
+
+        if (bytes.size() >= pngSignature.size() && std::equal(pngSignature.begin(), pngSignature.end(), bytes.begin()))
+            return decodePng(bytes, options);
+
+        if (bytes.size() >= 2 && bytes[0] == 'B' && bytes[1] == 'M')
+            return decodeBmp(bytes, options);
+
+        if (bytes.size() >= 2 && bytes[0] == 'P' && (bytes[1] == '5' || bytes[1] == '6'))
+            return decodePnm(bytes, options);
+
+        // TGA has no signature, only a header that has to make sense
+        if (bytes.size() >= 18 && bytes[1] <= 1 && (bytes[2] & ~8) >= 1 && (bytes[2] & ~8) <= 3)
+            return decodeTga(bytes, options);
+
+        throw std::runtime_error("Unknown image format");
+    }
+
+
+
+    Image loadImage(const std::filesystem::path& path, const ImageOptions& options)
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        Vector<std::byte> data;
+
+        {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+            if (!file)
+                throw std::runtime_error("Failed to open image file " + path.string());
+
+            data.resize(static_cast<std::size_t>(file.tellg()));
+            file.seekg(0);
+
+            if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())))
+                throw std::runtime_error("Failed to read image file " + path.string());
+        }
+
+        try
+        {
+            return decodeImage(data, options);
+        }
+        catch (const std::runtime_error& e) {
+            throw std::runtime_error(path.string() + ": " + e.what());
+        }
+    }
+
+
+
+    void loadImagesAsync(std::span<ImageLoadRequest> requests, Jobs::Counter& counter)
+    {
+        for (ImageLoadRequest& request : requests)
+        {
+            // Jobs must not throw
+            Jobs::run([&request]() {
+                try
+                {
+                    request.image = loadImage(request.path, request.options);
+                }
+                catch (const std::exception& e) {
+                    request.image = Image();
+                    request.error = e.what();
+                }
+            }, &counter);
+        }
+    }
+}
\ No newline at end of file
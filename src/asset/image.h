@@ -0,0 +1,150 @@
+//
+// Image loading.
+//
+// Decodes uncompressed TGA, BMP (24 and 32-bit, or 8-bit with a palette), binary PPM/PGM
+// and PNG (every color type and bit depth, interlaced or not, with the engine's own
+// inflate, see inflate.h) into Pixels, the framebuffer's native layout. Texels are
+// converted a row at a time with the functions in graphics/pixel_convert.h, then
+// optionally converted from sRGB to linear and premultiplied. A full mip chain can be
+// generated along with the image, each level a 2x2 box filter of the one above it.
+//
+// Decoding is independent per image and never touches shared state, so images can be
+// loaded on any thread. loadImagesAsync loads each image in its own job on the job
+// system, so loading many images doesn't stall the thread that asked for them.
+//
+
+#ifndef CEDAR_ASSET_IMAGE_H
+#define CEDAR_ASSET_IMAGE_H
+
+#include "../graphics/surface.h"
+#include "../jobs/job_system.h"
+#include "../math/size.h"
+#include "../memory/memory_tracker.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+
+
+namespace Cedar::Asset
+{
+    struct ImageOptions;
+
+    class Image;
+
+    struct ImageLoadRequest;
+
+
+
+    struct ImageOptions
+    {
+        bool linearize    = false; // Converts the color channels from sRGB to linear
+        bool premultiply  = true;  // As expected by the blending functions
+        bool generateMips = false;
+    };
+
+
+
+    // An image and its mips, stored one after the other.
+    class Image
+    {
+    public:
+
+        Image();
+
+        // Allocates the image and its mips without initializing them. Throws
+        // std::invalid_argument if the size isn't positive.
+        Image(Size2D<int> size, bool withMips);
+
+
+        inline bool isEmpty() const;
+
+        inline Size2D<int> getSize() const;
+
+        // 1 without mips, otherwise down to and including 1x1.
+        inline std::size_t getMipCount() const;
+
+        // Throws std::out_of_range if there is no such level.
+        Graphics::Surface getMip(std::size_t level);
+
+        inline Graphics::Surface getSurface();
+
+
+        // Recomputes every mip from the one above it.
+        void updateMips();
+
+    private:
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Asset>>;
+
+
+        Vector<Graphics::Pixel> m_pixels;
+        Size2D<int>             m_size     = { 0, 0 };
+        std::size_t             m_mipCount = 0;
+    };
+
+
+
+    struct ImageLoadRequest
+    {
+        std::filesystem::path path;
+        ImageOptions          options;
+
+        // Set when the request's job has run. The image is empty if loading failed, and
+        // the error says why.
+        Image       image;
+        std::string error;
+    };
+
+
+
+    // Decodes an image, detecting its format from the data. Throws std::runtime_error if
+    // the format is unknown or unsupported, or the data is malformed.
+    Image decodeImage(std::span<const std::byte> data, const ImageOptions& options = ImageOptions());
+
+    // Reads and decodes an image file. Throws std::runtime_error if the file can't be read
+    // or decoded.
+    Image loadImage(const std::filesystem::path& path, const ImageOptions& options = ImageOptions());
+
+    // Queues a job per request that loads its image. The counter is done once every
+    // image is loaded; the requests must stay alive and untouched until then.
+    void loadImagesAsync(std::span<ImageLoadRequest> requests, Jobs::Counter& counter);
+
+
+
+    // vvv Image function definitions vvv
+
+    inline bool Image::isEmpty() const
+    {
+        return m_mipCount == 0;
+    }
+
+
+
+    inline Size2D<int> Image::getSize() const
+    {
+        return m_size;
+    }
+
+
+
+    inline std::size_t Image::getMipCount() const
+    {
+        return m_mipCount;
+    }
+
+
+
+    inline Graphics::Surface Image::getSurface()
+    {
+        return getMip(0);
+    }
+
+    // ^^^ Image function definitions ^^^
+}
+
+#endif // CEDAR_ASSET_IMAGE_H
\ No newline at end of file
@@ -0,0 +1,531 @@
+#include "inflate.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+
+
+namespace
+{
+    constexpr int fastBits        = 10; // Codes up to this long are decoded with one lookup
+    constexpr int maxCodeLength   = 15;
+    constexpr int maxSymbolCount  = 288;
+    constexpr int maxPaddingBytes = 8;  // Zero bytes the bit reader may read past the end
+
+
+
+    constexpr std::array<std::uint16_t, 29> lengthBases = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+
+    constexpr std::array<std::uint8_t, 29> lengthExtraBits = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+
+    constexpr std::array<std::uint16_t, 30> distanceBases = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+        6145, 8193, 12289, 16385, 24577
+    };
+
+    constexpr std::array<std::uint8_t, 30> distanceExtraBits = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+
+    // Order the code length code lengths are stored in
+    constexpr std::array<std::uint8_t, 19> codeLengthOrder = {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+    };
+
+
+
+    class BitReader;
+
+    struct Huffman;
+
+
+
+    // Reads bits least significant first, as DEFLATE stores them. Reads past the end of
+    // the input give zero bytes, up to a limit, so refilling doesn't need a bounds check
+    // per bit; streams that actually use those bits are reported as truncated.
+    class BitReader
+    {
+    public:
+
+        inline explicit BitReader(std::span<const std::uint8_t> input) : m_input(input) {}
+
+
+        inline void refill();
+
+        inline std::uint32_t peek(int count) const;
+
+        inline void consume(int count);
+
+        inline std::uint32_t read(int count);
+
+        // Drops the bits up to the next byte boundary.
+        void alignToByte();
+
+        // Copies whole bytes, only valid when aligned to a byte.
+        void copyBytes(std::uint8_t* destination, std::size_t count);
+
+        // Throws if bits past the end of the input were used.
+        void checkNotTruncated() const;
+
+    private:
+
+        std::span<const std::uint8_t> m_input;
+        std::size_t                   m_position     = 0;
+        std::uint64_t                 m_buffer       = 0;
+        int                           m_bitCount     = 0;
+        int                           m_paddingBytes = 0;
+    };
+
+
+
+    struct Huffman
+    {
+        std::array<std::uint16_t, 1 << fastBits>         fast;             // symbol << 4 | length, 0 for longer codes
+        std::array<std::uint32_t, maxCodeLength + 2>     maxCode;          // Exclusive, left aligned to 16 bits
+        std::array<std::uint16_t, maxCodeLength + 1>     firstCode;
+        std::array<std::uint16_t, maxCodeLength + 1>     firstSymbolIndex;
+        std::array<std::uint16_t, maxSymbolCount>        symbols;          // Ordered by code
+        int                                              symbolCount;
+
+
+        void build(const std::uint8_t* lengths, int count);
+
+        inline int decode(BitReader& reader) const;
+    };
+
+
+
+    inline std::uint32_t reverseBits(std::uint32_t value, int count);
+
+    [[noreturn]] void throwMalformed();
+
+    void buildFixedCodes(Huffman& literalLengths, Huffman& distances);
+
+    void readDynamicCodes(BitReader& reader, Huffman& literalLengths, Huffman& distances);
+
+    void inflateBlock(BitReader& reader, const Huffman& literalLengths, const Huffman& distances,
+                      std::span<std::uint8_t> output, std::size_t& written);
+
+
+
+    // vvv BitReader function definitions vvv
+
+    inline void BitReader::refill()
+    {
+        while (m_bitCount <= 56)
+        {
+            std::uint64_t byte = 0;
+
+            if (m_position < m_input.size())
+                byte = m_input[m_position++];
+            else if (++m_paddingBytes > maxPaddingBytes)
+                throw std::runtime_error("Compressed data is truncated");
+
+            m_buffer   |= byte << m_bitCount;
+            m_bitCount += 8;
+        }
+    }
+
+
+
+    inline std::uint32_t BitReader::peek(int count) const
+    {
+        return static_cast<std::uint32_t>(m_buffer & ((std::uint64_t(1) << count) - 1));
+    }
+
+
+
+    inline void BitReader::consume(int count)
+    {
+        m_buffer   >>= count;
+        m_bitCount  -= count;
+    }
+
+
+
+    inline std::uint32_t BitReader::read(int count)
+    {
+        if (m_bitCount < count)
+            refill();
+
+        std::uint32_t value = peek(count);
+        consume(count);
+
+        return value;
+    }
+
+
+
+    void BitReader::alignToByte()
+    {
+        consume(m_bitCount % 8);
+    }
+
+
+
+    void BitReader::copyBytes(std::uint8_t* destination, std::size_t count)
+    {
+        // Hand the whole bytes still in the buffer back to the input first
+        std::size_t bufferedBytes = m_bitCount / 8;
+
+        if (bufferedBytes < static_cast<std::size_t>(m_paddingBytes))
+            throw std::runtime_error("Compressed data is truncated");
+
+        m_position     -= bufferedBytes - m_paddingBytes;
+        m_buffer        = 0;
+        m_bitCount      = 0;
+        m_paddingBytes  = 0;
+
+        if (count > m_input.size() - m_position)
+            throw std::runtime_error("Compressed data is truncated");
+
+        std::memcpy(destination, m_input.data() + m_position, count);
+        m_position += count;
+    }
+
+
+
+    void BitReader::checkNotTruncated() const
+    {
+        if (m_bitCount < m_paddingBytes * 8)
+            throw std::runtime_error("Compressed data is truncated");
+    }
+
+    // ^^^ BitReader function definitions ^^^
+
+
+
+    // vvv Huffman function definitions vvv
+
+    void Huffman::build(const std::uint8_t* lengths, int count)
+    {
+        std::array<int, maxCodeLength + 1> lengthCounts = {};
+
+        for (int i = 0; i < count; i++)
+            lengthCounts[lengths[i]]++;
+
+        lengthCounts[0] = 0;
+
+        std::array<std::uint32_t, maxCodeLength + 1> nextCode;
+        std::uint32_t code        = 0;
+        int           symbolIndex = 0;
+
+        for (int length = 1; length <= maxCodeLength; length++)
+        {
+            nextCode[length]         = code;
+            firstCode[length]        = static_cast<std::uint16_t>(code);
+            firstSymbolIndex[length] = static_cast<std::uint16_t>(symbolIndex);
+
+            code        += lengthCounts[length];
+            symbolIndex += lengthCounts[length];
+
+            if (code > (1u << length))
+                throwMalformed(); // Oversubscribed
+
+            maxCode[length] = code << (16 - length);
+            code <<= 1;
+        }
+
+        maxCode[maxCodeLength + 1] = 0x10000; // Stops the search
+        symbolCount                = symbolIndex;
+        fast.fill(0);
+
+        for (int symbol = 0; symbol < count; symbol++)
+        {
+            int length = lengths[symbol];
+
+            if (length == 0)
+                continue;
+
+            symbols[nextCode[length] - firstCode[length] + firstSymbolIndex[length]] = static_cast<std::uint16_t>(symbol);
+
+            // Every index whose low bits are this code, codes are stored bit reversed
+            if (length <= fastBits)
+            {
+                for (std::uint32_t index = reverseBits(nextCode[length], length); index < fast.size(); index += 1u << length)
+                    fast[index] = static_cast<std::uint16_t>(symbol << 4 | length);
+            }
+
+            nextCode[length]++;
+        }
+    }
+
+
+
+    inline int Huffman::decode(BitReader& reader) const
+    {
+        reader.refill();
+
+        std::uint16_t entry = fast[reader.peek(fastBits)];
+
+        if (entry != 0)
+        {
+            reader.consume(entry & 0xF);
+            return entry >> 4;
+        }
+
+        // Codes are assigned in increasing order within a length, so reversed back to
+        // normal order and left aligned, the code length is the first whose range ends
+        // past them
+        std::uint32_t code   = reverseBits(reader.peek(16), 16);
+        int           length = fastBits + 1;
+
+        while (code >= maxCode[length])
+            length++;
+
+        if (length > maxCodeLength)
+            throwMalformed();
+
+        int index = (code >> (16 - length)) - firstCode[length] + firstSymbolIndex[length];
+
+        if (index >= symbolCount)
+            throwMalformed();
+
+        reader.consume(length);
+
+        return symbols[index];
+    }
+
+    // ^^^ Huffman function definitions ^^^
+
+
+
+    inline std::uint32_t reverseBits(std::uint32_t value, int count)
+    {
+        value = ((value & 0xAAAA) >> 1) | ((value & 0x5555) << 1);
+        value = ((value & 0xCCCC) >> 2) | ((value & 0x3333) << 2);
+        value = ((value & 0xF0F0) >> 4) | ((value & 0x0F0F) << 4);
+        value = ((value & 0xFF00) >> 8) | ((value & 0x00FF) << 8);
+
+        return value >> (16 - count);
+    }
+
+
+
+    void throwMalformed()
+    {
+        throw std::runtime_error("Compressed data is malformed");
+    }
+
+
+
+    void buildFixedCodes(Huffman& literalLengths, Huffman& distances)
+    {
+        std::array<std::uint8_t, maxSymbolCount> lengths;
+
+        std::fill(lengths.begin(),       lengths.begin() + 144, std::uint8_t(8));
+        std::fill(lengths.begin() + 144, lengths.begin() + 256, std::uint8_t(9));
+        std::fill(lengths.begin() + 256, lengths.begin() + 280, std::uint8_t(7));
+        std::fill(lengths.begin() + 280, lengths.end(),         std::uint8_t(8));
+
+        literalLengths.build(lengths.data(), maxSymbolCount);
+
+        std::fill(lengths.begin(), lengths.begin() + 30, std::uint8_t(5));
+
+        distances.build(lengths.data(), 30);
+    }
+
+
+
+    void readDynamicCodes(BitReader& reader, Huffman& literalLengths, Huffman& distances)
+    {
+        int literalLengthCount = reader.read(5) + 257;
+        int distanceCount      = reader.read(5) + 1;
+        int codeLengthCount    = reader.read(4) + 4;
+
+        std::array<std::uint8_t, 19> codeLengthLengths = {};
+
+        for (int i = 0; i < codeLengthCount; i++)
+            codeLengthLengths[codeLengthOrder[i]] = static_cast<std::uint8_t>(reader.read(3));
+
+        Huffman codeLengths;
+        codeLengths.build(codeLengthLengths.data(), 19);
+
+        // Both sets of lengths are one sequence, repeats may run from one into the other
+        std::array<std::uint8_t, maxSymbolCount + 32> lengths;
+        int                                total = literalLengthCount + distanceCount;
+        int                                count = 0;
+
+        while (count < total)
+        {
+            int symbol = codeLengths.decode(reader);
+
+            if (symbol < 16)
+            {
+                lengths[count++] = static_cast<std::uint8_t>(symbol);
+                continue;
+            }
+
+            std::uint8_t value  = 0;
+            int          repeat = 0;
+
+            if (symbol == 16)
+            {
+                if (count == 0)
+                    throwMalformed();
+
+                value  = lengths[count - 1];
+                repeat = reader.read(2) + 3;
+            }
+            else if (symbol == 17)
+            {
+                repeat = reader.read(3) + 3;
+            }
+            else
+            {
+                repeat = reader.read(7) + 11;
+            }
+
+            if (repeat > total - count)
+                throwMalformed();
+
+            std::fill_n(lengths.begin() + count, repeat, value);
+            count += repeat;
+        }
+
+        if (lengths[256] == 0) // No end of block code
+            throwMalformed();
+
+        literalLengths.build(lengths.data(), literalLengthCount);
+        distances.build(lengths.data() + literalLengthCount, distanceCount);
+    }
+
+
+
+    void inflateBlock(BitReader& reader, const Huffman& literalLengths, const Huffman& distances,
+                      std::span<std::uint8_t> output, std::size_t& written)
+    {
+        std::uint8_t* data = output.data();
+        std::size_t   size = output.size();
+        std::size_t   end  = written;
+
+        while (true)
+        {
+            int symbol = literalLengths.decode(reader);
+
+            if (symbol < 256)
+            {
+                if (end == size)
+                    throw std::runtime_error("Decompressed data is larger than expected");
+
+                data[end++] = static_cast<std::uint8_t>(symbol);
+                continue;
+            }
+
+            if (symbol == 256)
+                break;
+
+            symbol -= 257;
+
+            if (symbol >= 29)
+                throwMalformed();
+
+            std::size_t length = lengthBases[symbol] + reader.read(lengthExtraBits[symbol]);
+
+            int distanceSymbol = distances.decode(reader);
+
+            if (distanceSymbol >= 30)
+                throwMalformed();
+
+            std::size_t distance = distanceBases[distanceSymbol] + reader.read(distanceExtraBits[distanceSymbol]);
+
+            if (distance > end)
+                throwMalformed();
+
+            if (length > size - end)
+                throw std::runtime_error("Decompressed data is larger than expected");
+
+            const std::uint8_t* source      = data + end - distance;
+            std::uint8_t*       destination = data + end;
+
+            // Overlapping copies repeat the last distance bytes, so they go byte by byte
+            if (distance >= length)
+                std::memcpy(destination, source, length);
+            else if (distance == 1)
+                std::memset(destination, *source, length);
+            else
+                for (std::size_t i = 0; i < length; i++)
+                    destination[i] = source[i];
+
+            end += length;
+        }
+
+        written = end;
+    }
+}
+
+
+
+namespace Cedar::Asset
+{
+    std::size_t inflateZlib(std::span<const std::uint8_t> input, std::span<std::uint8_t> output)
+    {
+        if (input.size() < 2)
+            throw std::runtime_error("Compressed data is truncated");
+
+        std::uint32_t header = input[0] << 8 | input[1];
+
+        // Compression method 8 (deflate), window of at most 32 KB, no preset dictionary
+        if ((input[0] & 0x0F) != 8 || (input[0] >> 4) > 7 || header % 31 != 0 || (input[1] & 0x20) != 0)
+            throw std::runtime_error("Unsupported zlib stream");
+
+        BitReader   reader(input.subspan(2));
+        std::size_t written   = 0;
+        bool        lastBlock = false;
+
+        Huffman literalLengths;
+        Huffman distances;
+
+        while (!lastBlock)
+        {
+            lastBlock     = reader.read(1) != 0;
+            int blockType = reader.read(2);
+
+            if (blockType == 0)
+            {
+                reader.alignToByte();
+
+                std::uint32_t length        = reader.read(16);
+                std::uint32_t inverseLength = reader.read(16);
+
+                if ((length ^ 0xFFFF) != inverseLength)
+                    throwMalformed();
+
+                if (length > output.size() - written)
+                    throw std::runtime_error("Decompressed data is larger than expected");
+
+                reader.copyBytes(output.data() + written, length);
+                written += length;
+
+                continue;
+            }
+            else if (blockType == 1)
+            {
+                buildFixedCodes(literalLengths, distances);
+            }
+            else if (blockType == 2)
+            {
+                readDynamicCodes(reader, literalLengths, distances);
+            }
+            else
+            {
+                throwMalformed();
+            }
+
+            inflateBlock(reader, literalLengths, distances, output, written);
+        }
+
+        reader.checkNotTruncated();
+
+        return written;
+    }
+}
\ No newline at end of file
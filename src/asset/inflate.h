@@ -0,0 +1,28 @@
+//
+// zlib (RFC 1950) / DEFLATE (RFC 1951) decompression.
+//
+// A small decoder for the compressed data in PNG files. Huffman codes of up to 10 bits
+// are decoded with a single table lookup and longer ones with a search over the
+// canonical code ranges. The output size has to be known up front, as it is for images,
+// so the output is written straight into a caller-provided buffer without any growing or
+// copying. The Adler-32 checksum is not verified.
+//
+
+#ifndef CEDAR_ASSET_INFLATE_H
+#define CEDAR_ASSET_INFLATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+
+
+namespace Cedar::Asset
+{
+    // Decompresses the zlib stream into the output and returns the number of bytes
+    // written. Throws std::runtime_error if the stream is malformed or truncated, or if
+    // its data doesn't fit in the output.
+    std::size_t inflateZlib(std::span<const std::uint8_t> input, std::span<std::uint8_t> output);
+}
+
+#endif // CEDAR_ASSET_INFLATE_H
\ No newline at end of file
@@ -0,0 +1,14 @@
+//
+// A collection of header files located in the "containers" directory.
+//
+
+#ifndef CEDAR_CONTAINERS_H
+#define CEDAR_CONTAINERS_H
+
+#include "containers/flat_hash_map.h"
+#include "containers/flat_hash_set.h"
+#include "containers/flat_hash_table.h"
+#include "containers/ring_buffer.h"
+#include "containers/small_vector.h"
+
+#endif // CEDAR_CONTAINERS_H
\ No newline at end of file
@@ -0,0 +1,212 @@
+//
+// Open addressing hash map, see flat_hash_table.h.
+//
+// Mostly a drop-in replacement for std::unordered_map, with camelCase names and without
+// buckets or node handles. Elements are std::pairs of a const key and a value.
+//
+
+#ifndef CEDAR_CONTAINERS_FLAT_HASH_MAP_H
+#define CEDAR_CONTAINERS_FLAT_HASH_MAP_H
+
+#include "../memory/memory_tracker.h"
+#include "flat_hash_table.h"
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+
+
+namespace Cedar
+{
+    template <typename TKey, typename TValue>
+    struct FlatHashMapPolicy;
+
+    template <typename TKey, typename TValue, typename THash = std::hash<TKey>, typename TEqual = std::equal_to<TKey>,
+              typename TAllocator = Memory::TrackedAllocator<std::pair<const TKey, TValue>>>
+    class FlatHashMap;
+
+
+
+    template <typename TKey, typename TValue>
+    struct FlatHashMapPolicy
+    {
+        typedef TKey                           KeyType;
+        typedef std::pair<const TKey, TValue>  ValueType;
+
+        // Elements are only ever reached as a const key and a value, but growing the table
+        // moves them through the same pair with a mutable key, so keys are moved rather
+        // than copied. std::unordered_map's nodes do the same.
+        union SlotType
+        {
+            ValueType                 value;
+            std::pair<TKey, TValue>   mutableValue;
+
+            inline SlotType() {}
+
+            inline ~SlotType() {}
+        };
+
+        static constexpr bool mutableElements = true;
+
+        static inline const TKey& getKey(const ValueType& value) { return value.first; }
+
+        static inline ValueType& getValue(SlotType& slot) { return slot.value; }
+
+        static inline const ValueType& getValue(const SlotType& slot) { return slot.value; }
+
+        // Moves the element of one slot into another, uninitialized one, and destroys it.
+        template <typename TAllocator>
+        static inline void transfer(TAllocator& allocator, SlotType* to, SlotType* from) {
+            std::allocator_traits<TAllocator>::construct(allocator, &to->mutableValue, std::move(from->mutableValue));
+            std::allocator_traits<TAllocator>::destroy(allocator, &from->mutableValue);
+        }
+    };
+
+
+
+    template <typename TKey, typename TValue, typename THash, typename TEqual, typename TAllocator>
+    class FlatHashMap : public FlatHashTable<FlatHashMapPolicy<TKey, TValue>, THash, TEqual, TAllocator>
+    {
+    private:
+
+        typedef FlatHashTable<FlatHashMapPolicy<TKey, TValue>, THash, TEqual, TAllocator> Table;
+
+    public:
+
+        typedef TValue                          mapped_type;
+        typedef typename Table::iterator       iterator;
+        typedef typename Table::const_iterator const_iterator;
+
+
+        using Table::Table;
+
+
+        // Returns the key's value, inserting a value-initialized one first if there's none.
+        inline TValue& operator[](const TKey& key);
+
+        inline TValue& operator[](TKey&& key);
+
+        // Throw std::out_of_range if there's no value for the key.
+        inline TValue& at(const TKey& key);
+
+        inline const TValue& at(const TKey& key) const;
+
+
+        // Constructs a value from the arguments only if there's none for the key yet, and
+        // returns the key's element and whether it was inserted.
+        template <typename... TArgs>
+        inline std::pair<iterator, bool> tryEmplace(const TKey& key, TArgs&&... args);
+
+        template <typename... TArgs>
+        inline std::pair<iterator, bool> tryEmplace(TKey&& key, TArgs&&... args);
+
+        // Assigns the value to the key's element, or inserts one.
+        template <typename V>
+        std::pair<iterator, bool> insertOrAssign(const TKey& key, V&& value);
+
+        template <typename V>
+        std::pair<iterator, bool> insertOrAssign(TKey&& key, V&& value);
+    };
+
+
+
+    // vvv FlatHashMap function definitions vvv
+
+    template <typename TKey, typename TValue, typename THash, typename TEqual, typename TAllocator>
+    inline TValue& FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>::operator[](const TKey& key)
+    {
+        return tryEmplace(key).first->second;
+    }
+
+
+
+    template <typename TKey, typename TValue, typename THash, typename TEqual, typename TAllocator>
+    inline TValue& FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>::operator[](TKey&& key)
+    {
+        return tryEmplace(std::move(key)).first->second;
+    }
+
+
+
+    template <typename TKey, typename TValue, typename THash, typename TEqual, typename TAllocator>
+    inline TValue& FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>::at(const TKey& key)
+    {
+        iterator element = this->find(key);
+
+        if (element == this->end())
+            throw std::out_of_range("Key isn't in the map");
+
+        return element->second;
+    }
+
+
+
+    template <typename TKey, typename TValue, typename THash, typename TEqual, typename TAllocator>
+    inline const TValue& FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>::at(const TKey& key) const
+    {
+        const_iterator element = this->find(key);
+
+        if (element == this->end())
+            throw std::out_of_range("Key isn't in the map");
+
+        return element->second;
+    }
+
+
+
+    template <typename TKey, typename TValue, typename THash, typename TEqual, typename TAllocator>
+    template <typename... TArgs>
+    inline std::pair<typename FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>::iterator, bool>
+        FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>::tryEmplace(const TKey& key, TArgs&&... args)
+    {
+        return this->emplaceKey(key, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<TArgs>(args)...));
+    }
+
+
+
+    template <typename TKey, typename TValue, typename THash, typename TEqual, typename TAllocator>
+    template <typename... TArgs>
+    inline std::pair<typename FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>::iterator, bool>
+        FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>::tryEmplace(TKey&& key, TArgs&&... args)
+    {
+        // The key is only moved from once it's known to be missing
+        return this->emplaceKey(key, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<TArgs>(args)...));
+    }
+
+
+
+    template <typename TKey, typename TValue, typename THash, typename TEqual, typename TAllocator>
+    template <typename V>
+    std::pair<typename FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>::iterator, bool>
+        FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>::insertOrAssign(const TKey& key, V&& value)
+    {
+        std::pair<iterator, bool> result = tryEmplace(key, std::forward<V>(value));
+
+        if (!result.second)
+            result.first->second = std::forward<V>(value);
+
+        return result;
+    }
+
+
+
+    template <typename TKey, typename TValue, typename THash, typename TEqual, typename TAllocator>
+    template <typename V>
+    std::pair<typename FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>::iterator, bool>
+        FlatHashMap<TKey, TValue, THash, TEqual, TAllocator>::insertOrAssign(TKey&& key, V&& value)
+    {
+        std::pair<iterator, bool> result = tryEmplace(std::move(key), std::forward<V>(value));
+
+        if (!result.second)
+            result.first->second = std::forward<V>(value);
+
+        return result;
+    }
+
+    // ^^^ FlatHashMap function definitions ^^^
+}
+
+#endif // CEDAR_CONTAINERS_FLAT_HASH_MAP_H
\ No newline at end of file
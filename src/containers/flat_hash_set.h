@@ -0,0 +1,69 @@
+//
+// Open addressing hash set, see flat_hash_table.h.
+//
+// Mostly a drop-in replacement for std::unordered_set, with camelCase names and without
+// buckets or node handles.
+//
+
+#ifndef CEDAR_CONTAINERS_FLAT_HASH_SET_H
+#define CEDAR_CONTAINERS_FLAT_HASH_SET_H
+
+#include "../memory/memory_tracker.h"
+#include "flat_hash_table.h"
+
+#include <functional>
+#include <memory>
+#include <utility>
+
+
+
+namespace Cedar
+{
+    template <typename TKey>
+    struct FlatHashSetPolicy;
+
+    template <typename TKey, typename THash = std::hash<TKey>, typename TEqual = std::equal_to<TKey>,
+              typename TAllocator = Memory::TrackedAllocator<TKey>>
+    class FlatHashSet;
+
+
+
+    template <typename TKey>
+    struct FlatHashSetPolicy
+    {
+        typedef TKey KeyType;
+        typedef TKey ValueType;
+        typedef TKey SlotType;
+
+        static constexpr bool mutableElements = false;
+
+        static inline const TKey& getKey(const TKey& value) { return value; }
+
+        static inline TKey& getValue(TKey& slot) { return slot; }
+
+        static inline const TKey& getValue(const TKey& slot) { return slot; }
+
+        // Moves the element of one slot into another, uninitialized one, and destroys it.
+        template <typename TAllocator>
+        static inline void transfer(TAllocator& allocator, TKey* to, TKey* from) {
+            std::allocator_traits<TAllocator>::construct(allocator, to, std::move(*from));
+            std::allocator_traits<TAllocator>::destroy(allocator, from);
+        }
+    };
+
+
+
+    template <typename TKey, typename THash, typename TEqual, typename TAllocator>
+    class FlatHashSet : public FlatHashTable<FlatHashSetPolicy<TKey>, THash, TEqual, TAllocator>
+    {
+    private:
+
+        typedef FlatHashTable<FlatHashSetPolicy<TKey>, THash, TEqual, TAllocator> Table;
+
+    public:
+
+        using Table::Table;
+    };
+}
+
+#endif // CEDAR_CONTAINERS_FLAT_HASH_SET_H
\ No newline at end of file
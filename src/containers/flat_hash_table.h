@@ -0,0 +1,968 @@
+//
+// Open addressing hash table, the implementation of FlatHashMap and FlatHashSet.
+//
+// Elements are kept directly in one array of slots, with no node per element, next to an
+// array of one control byte per slot. A control byte says whether its slot is empty,
+// deleted (a tombstone left by erase) or in use, and for a slot in use holds the low 7
+// bits of its element's hash. A lookup starts at the slot picked by the rest of the hash
+// and compares the control bytes of a group of 16 slots at once (with SSE2, see core.h),
+// so only the elements whose 7 bits match are compared, which is almost always just the
+// one looked for. It stops at the first group with an empty slot; groups are probed
+// quadratically. Tables grow once they're 7/8 full.
+//
+// The capacity is always a power of two minus one. The control bytes of the first group
+// are mirrored past the last slot, so a group can be loaded starting at any slot without
+// wrapping around, and a sentinel byte right after the last slot ends iteration.
+//
+// Inserting invalidates iterators and references when the table grows. Erasing
+// invalidates only the erased element's. Growing moves elements, keys included, through
+// TPolicy::transfer.
+//
+
+#ifndef CEDAR_CONTAINERS_FLAT_HASH_TABLE_H
+#define CEDAR_CONTAINERS_FLAT_HASH_TABLE_H
+
+#include "../core.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#if defined(CEDAR_SIMD_SSE2)
+    #include <emmintrin.h>
+#endif
+
+
+
+namespace Cedar
+{
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    class FlatHashTable;
+
+
+
+    // TPolicy describes the elements:
+    // * KeyType and ValueType, the type of the keys and of the elements.
+    // * SlotType, what the slots hold, which may be ValueType itself.
+    // * static const KeyType& getKey(const ValueType&).
+    // * static ValueType& getValue(SlotType&), and its const overload, the slot's element.
+    // * static void transfer(Allocator&, SlotType* to, SlotType* from), which moves the
+    //   element of a slot into an uninitialized one and destroys it.
+    // * static constexpr bool mutableElements, whether iterators give access to modify
+    //   the elements (the values of a map) or only to read them (the keys of a set).
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    class FlatHashTable
+    {
+    public:
+
+        template <bool TConst>
+        class Iterator;
+
+
+        typedef typename TPolicy::KeyType   key_type;
+        typedef typename TPolicy::ValueType value_type;
+        typedef std::size_t                 size_type;
+        typedef std::ptrdiff_t              difference_type;
+        typedef THash                       hasher;
+        typedef TEqual                      key_equal;
+        typedef TAllocator                  allocator_type;
+        typedef value_type&                 reference;
+        typedef const value_type&           const_reference;
+
+        typedef Iterator<!TPolicy::mutableElements> iterator;
+        typedef Iterator<true>                      const_iterator;
+
+
+        // Slots whose control bytes are compared at once.
+        static constexpr std::size_t groupWidth = 16;
+
+        static constexpr bool transparentLookup = requires { typename THash::is_transparent; typename TEqual::is_transparent; };
+
+
+        inline FlatHashTable() = default;
+
+        inline explicit FlatHashTable(const TAllocator& allocator);
+
+        FlatHashTable(std::initializer_list<value_type> values, const TAllocator& allocator = TAllocator());
+
+        FlatHashTable(const FlatHashTable& other);
+
+        FlatHashTable(FlatHashTable&& other) noexcept;
+
+        ~FlatHashTable();
+
+
+        FlatHashTable& operator=(const FlatHashTable& other);
+
+        FlatHashTable& operator=(FlatHashTable&& other) noexcept(std::allocator_traits<TAllocator>::is_always_equal::value);
+
+
+        inline iterator begin();
+
+        inline const_iterator begin() const;
+
+        inline iterator end();
+
+        inline const_iterator end() const;
+
+
+        inline std::size_t getSize() const;
+
+        inline bool isEmpty() const;
+
+        // Slots, up to 7/8 of which are used before the table grows.
+        inline std::size_t getCapacity() const;
+
+        inline TAllocator getAllocator() const;
+
+
+        // Makes room for the count of elements without growing again.
+        void reserve(std::size_t count);
+
+        // Destroys the elements but keeps the memory.
+        void clear();
+
+
+        inline iterator find(const key_type& key);
+
+        inline const_iterator find(const key_type& key) const;
+
+        inline bool contains(const key_type& key) const;
+
+        // With hash and equality functions that both define is_transparent, lookups also
+        // take the other types they accept, such as std::string_view for std::string keys.
+        template <typename K>
+        inline iterator find(const K& key) requires transparentLookup;
+
+        template <typename K>
+        inline const_iterator find(const K& key) const requires transparentLookup;
+
+        template <typename K>
+        inline bool contains(const K& key) const requires transparentLookup;
+
+
+        // Returns the element with the value's key and whether it was inserted, which it
+        // isn't if there already was one.
+        inline std::pair<iterator, bool> insert(const value_type& value);
+
+        inline std::pair<iterator, bool> insert(value_type&& value);
+
+        template <typename TIterator>
+        void insert(TIterator first, TIterator last);
+
+        // Constructs the element before looking its key up, so it's constructed even if
+        // it isn't inserted.
+        template <typename... TArgs>
+        std::pair<iterator, bool> emplace(TArgs&&... args);
+
+
+        void erase(const_iterator position);
+
+        // Returns the number of elements erased, 0 or 1.
+        std::size_t erase(const key_type& key);
+
+        template <typename K>
+        std::size_t erase(const K& key) requires transparentLookup && (!std::is_convertible_v<const K&, const_iterator>);
+
+
+        void swap(FlatHashTable& other) noexcept;
+
+    protected:
+
+        // Inserts an element constructed from the arguments if there's none with the key.
+        template <typename K, typename... TArgs>
+        std::pair<iterator, bool> emplaceKey(const K& key, TArgs&&... args);
+
+    private:
+
+        typedef typename TPolicy::SlotType Slot;
+
+        typedef typename std::allocator_traits<TAllocator>::template rebind_alloc<Slot> SlotAllocator;
+        typedef std::allocator_traits<SlotAllocator>                                   SlotTraits;
+
+        typedef std::int8_t Control;
+
+        static constexpr Control emptyControl    = -128;
+        static constexpr Control deletedControl  = -2;
+        static constexpr Control sentinelControl = -1;  // Empty and deleted are below it, slots in use above
+
+        // The control bytes of tables with no slots, so lookups need no special case.
+        alignas(groupWidth) static constexpr Control emptyGroup[groupWidth] = {
+            sentinelControl, emptyControl, emptyControl, emptyControl, emptyControl, emptyControl, emptyControl, emptyControl,
+            emptyControl,    emptyControl, emptyControl, emptyControl, emptyControl, emptyControl, emptyControl, emptyControl
+        };
+
+        [[no_unique_address]] SlotAllocator m_allocator;
+        [[no_unique_address]] THash         m_hash;
+        [[no_unique_address]] TEqual        m_equal;
+
+        Control*    m_control    = const_cast<Control*>(emptyGroup); // Never written while it's the empty group
+        Slot*       m_slots      = nullptr;
+        std::size_t m_capacity   = 0;
+        std::size_t m_size       = 0;
+        std::size_t m_growthLeft = 0;                                // Empty slots that may be used before growing
+
+
+        // Bit i of the result is set if control byte i of the group matches.
+        static inline std::uint32_t matchControl(const Control* group, Control control);
+
+        static inline std::uint32_t matchEmpty(const Control* group);
+
+        static inline std::uint32_t matchEmptyOrDeleted(const Control* group);
+
+
+        // The smallest capacity that fits the count of elements.
+        static inline std::size_t getCapacityFor(std::size_t count);
+
+        static inline std::size_t getMaxLoad(std::size_t capacity);
+
+        // Slots allocated for a capacity, enough to also hold the control bytes after them.
+        static inline std::size_t getAllocationCount(std::size_t capacity);
+
+
+        template <typename K>
+        inline std::size_t hashKey(const K& key) const;
+
+        // Returns the capacity if there's no element with the key.
+        template <typename K>
+        std::size_t findIndex(const K& key, std::size_t hash) const;
+
+        // The first empty or deleted slot on the hash's probe sequence.
+        std::size_t findInsertIndex(std::size_t hash) const;
+
+        // Also sets the mirrored byte if the slot is in the first group.
+        inline void setControl(std::size_t index, Control control);
+
+        inline iterator makeIterator(std::size_t index);
+
+        // Moves the elements into a new array of slots.
+        void rehash(std::size_t capacity);
+
+        void destroyAndDeallocate();
+    };
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    template <bool TConst>
+    class FlatHashTable<TPolicy, THash, TEqual, TAllocator>::Iterator
+    {
+    public:
+
+        typedef std::forward_iterator_tag                                    iterator_category;
+        typedef typename TPolicy::ValueType                                  value_type;
+        typedef std::ptrdiff_t                                               difference_type;
+        typedef std::conditional_t<TConst, const value_type*, value_type*> pointer;
+        typedef std::conditional_t<TConst, const value_type&, value_type&> reference;
+
+
+        inline Iterator() = default;
+
+        // Converts iterators to const iterators.
+        template <bool TOtherConst>
+        inline Iterator(const Iterator<TOtherConst>& other) requires (TConst && !TOtherConst) : m_control(other.m_control), m_slot(other.m_slot) {}
+
+
+        inline reference operator*() const { return TPolicy::getValue(*m_slot); }
+
+        inline pointer operator->() const { return &TPolicy::getValue(*m_slot); }
+
+
+        inline Iterator& operator++() {
+            m_control++;
+            m_slot++;
+            skipUnused();
+
+            return *this;
+        }
+
+        inline Iterator operator++(int) {
+            Iterator previous = *this;
+            operator++();
+
+            return previous;
+        }
+
+
+        inline bool operator==(const Iterator& other) const { return m_control == other.m_control; }
+
+        inline bool operator!=(const Iterator& other) const { return m_control != other.m_control; }
+
+    private:
+
+        friend class FlatHashTable;
+
+        friend class Iterator<!TConst>;
+
+
+        typedef std::conditional_t<TConst, const Slot*, Slot*> SlotPointer;
+
+
+        const Control* m_control = nullptr;
+        SlotPointer    m_slot    = nullptr;
+
+
+        inline Iterator(const Control* control, SlotPointer slot) : m_control(control), m_slot(slot) {}
+
+        // Stops at the sentinel at the latest.
+        inline void skipUnused() {
+            while (*m_control < sentinelControl)
+            {
+                std::size_t skipped = static_cast<std::size_t>(std::countr_one(matchEmptyOrDeleted(m_control)));
+                m_control += skipped;
+                m_slot    += skipped;
+            }
+        }
+    };
+
+
+
+    // vvv FlatHashTable function definitions vvv
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline FlatHashTable<TPolicy, THash, TEqual, TAllocator>::FlatHashTable(const TAllocator& allocator) :
+        m_allocator(allocator)
+    {}
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    FlatHashTable<TPolicy, THash, TEqual, TAllocator>::FlatHashTable(std::initializer_list<value_type> values, const TAllocator& allocator) :
+        m_allocator(allocator)
+    {
+        reserve(values.size());
+        insert(values.begin(), values.end());
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    FlatHashTable<TPolicy, THash, TEqual, TAllocator>::FlatHashTable(const FlatHashTable& other) :
+        m_allocator(SlotTraits::select_on_container_copy_construction(other.m_allocator)),
+        m_hash(other.m_hash),
+        m_equal(other.m_equal)
+    {
+        reserve(other.m_size);
+        insert(other.begin(), other.end());
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    FlatHashTable<TPolicy, THash, TEqual, TAllocator>::FlatHashTable(FlatHashTable&& other) noexcept :
+        m_allocator(std::move(other.m_allocator)),
+        m_hash(std::move(other.m_hash)),
+        m_equal(std::move(other.m_equal))
+    {
+        swap(other);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    FlatHashTable<TPolicy, THash, TEqual, TAllocator>::~FlatHashTable()
+    {
+        destroyAndDeallocate();
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    FlatHashTable<TPolicy, THash, TEqual, TAllocator>& FlatHashTable<TPolicy, THash, TEqual, TAllocator>::operator=(const FlatHashTable& other)
+    {
+        if (this == &other)
+            return *this;
+
+        if constexpr (SlotTraits::propagate_on_container_copy_assignment::value)
+        {
+            if (m_allocator != other.m_allocator)
+            {
+                destroyAndDeallocate();
+                m_control    = const_cast<Control*>(emptyGroup);
+                m_slots      = nullptr;
+                m_capacity   = 0;
+                m_size       = 0;
+                m_growthLeft = 0;
+            }
+
+            m_allocator = other.m_allocator;
+        }
+
+        m_hash  = other.m_hash;
+        m_equal = other.m_equal;
+
+        clear();
+        reserve(other.m_size);
+        insert(other.begin(), other.end());
+
+        return *this;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    FlatHashTable<TPolicy, THash, TEqual, TAllocator>& FlatHashTable<TPolicy, THash, TEqual, TAllocator>::operator=(FlatHashTable&& other)
+        noexcept(std::allocator_traits<TAllocator>::is_always_equal::value)
+    {
+        if (this == &other)
+            return *this;
+
+        m_hash  = std::move(other.m_hash);
+        m_equal = std::move(other.m_equal);
+
+        if constexpr (SlotTraits::propagate_on_container_move_assignment::value)
+        {
+            destroyAndDeallocate();
+            m_allocator  = std::move(other.m_allocator);
+            m_control    = std::exchange(other.m_control, const_cast<Control*>(emptyGroup));
+            m_slots      = std::exchange(other.m_slots, nullptr);
+            m_capacity   = std::exchange(other.m_capacity, 0);
+            m_size       = std::exchange(other.m_size, 0);
+            m_growthLeft = std::exchange(other.m_growthLeft, 0);
+        }
+        else if (m_allocator == other.m_allocator)
+        {
+            FlatHashTable stolen(std::move(other));
+            swap(stolen);
+        }
+        else
+        {
+            // The memory can't change hands, so the elements are moved one by one
+            clear();
+            reserve(other.m_size);
+
+            for (value_type& value : other)
+                emplaceKey(TPolicy::getKey(value), std::move(value));
+
+            other.clear();
+        }
+
+        return *this;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::iterator FlatHashTable<TPolicy, THash, TEqual, TAllocator>::begin()
+    {
+        iterator iterator(m_control, m_slots);
+        iterator.skipUnused();
+
+        return iterator;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::const_iterator FlatHashTable<TPolicy, THash, TEqual, TAllocator>::begin() const
+    {
+        const_iterator iterator(m_control, m_slots);
+        iterator.skipUnused();
+
+        return iterator;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::iterator FlatHashTable<TPolicy, THash, TEqual, TAllocator>::end()
+    {
+        return iterator(m_control + m_capacity, m_slots + m_capacity);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::const_iterator FlatHashTable<TPolicy, THash, TEqual, TAllocator>::end() const
+    {
+        return const_iterator(m_control + m_capacity, m_slots + m_capacity);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline std::size_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::getSize() const
+    {
+        return m_size;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline bool FlatHashTable<TPolicy, THash, TEqual, TAllocator>::isEmpty() const
+    {
+        return m_size == 0;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline std::size_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::getCapacity() const
+    {
+        return m_capacity;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline TAllocator FlatHashTable<TPolicy, THash, TEqual, TAllocator>::getAllocator() const
+    {
+        return TAllocator(m_allocator);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    void FlatHashTable<TPolicy, THash, TEqual, TAllocator>::reserve(std::size_t count)
+    {
+        if (count > getMaxLoad(m_capacity))
+            rehash(getCapacityFor(count));
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    void FlatHashTable<TPolicy, THash, TEqual, TAllocator>::clear()
+    {
+        if (m_capacity == 0)
+            return;
+
+        if constexpr (!std::is_trivially_destructible_v<value_type>)
+        {
+            for (std::size_t i = 0; i < m_capacity; i++)
+            {
+                if (m_control[i] >= 0)
+                    SlotTraits::destroy(m_allocator, &TPolicy::getValue(m_slots[i]));
+            }
+        }
+
+        std::memset(m_control, emptyControl, m_capacity + groupWidth);
+        m_control[m_capacity] = sentinelControl;
+
+        m_size       = 0;
+        m_growthLeft = getMaxLoad(m_capacity);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::iterator FlatHashTable<TPolicy, THash, TEqual, TAllocator>::find(const key_type& key)
+    {
+        std::size_t index = findIndex(key, hashKey(key));
+
+        return index == m_capacity ? end() : makeIterator(index);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::const_iterator FlatHashTable<TPolicy, THash, TEqual, TAllocator>::find(const key_type& key) const
+    {
+        std::size_t index = findIndex(key, hashKey(key));
+
+        return const_iterator(m_control + index, m_slots + index);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline bool FlatHashTable<TPolicy, THash, TEqual, TAllocator>::contains(const key_type& key) const
+    {
+        return findIndex(key, hashKey(key)) != m_capacity;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    template <typename K>
+    inline typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::iterator FlatHashTable<TPolicy, THash, TEqual, TAllocator>::find(const K& key) requires transparentLookup
+    {
+        std::size_t index = findIndex(key, hashKey(key));
+
+        return index == m_capacity ? end() : makeIterator(index);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    template <typename K>
+    inline typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::const_iterator FlatHashTable<TPolicy, THash, TEqual, TAllocator>::find(const K& key) const requires transparentLookup
+    {
+        std::size_t index = findIndex(key, hashKey(key));
+
+        return const_iterator(m_control + index, m_slots + index);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    template <typename K>
+    inline bool FlatHashTable<TPolicy, THash, TEqual, TAllocator>::contains(const K& key) const requires transparentLookup
+    {
+        return findIndex(key, hashKey(key)) != m_capacity;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline std::pair<typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::iterator, bool>
+        FlatHashTable<TPolicy, THash, TEqual, TAllocator>::insert(const value_type& value)
+    {
+        return emplaceKey(TPolicy::getKey(value), value);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline std::pair<typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::iterator, bool>
+        FlatHashTable<TPolicy, THash, TEqual, TAllocator>::insert(value_type&& value)
+    {
+        return emplaceKey(TPolicy::getKey(value), std::move(value));
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    template <typename TIterator>
+    void FlatHashTable<TPolicy, THash, TEqual, TAllocator>::insert(TIterator first, TIterator last)
+    {
+        for (; first != last; ++first)
+            emplaceKey(TPolicy::getKey(*first), *first);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    template <typename... TArgs>
+    std::pair<typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::iterator, bool>
+        FlatHashTable<TPolicy, THash, TEqual, TAllocator>::emplace(TArgs&&... args)
+    {
+        value_type value(std::forward<TArgs>(args)...);
+
+        return emplaceKey(TPolicy::getKey(value), std::move(value));
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    void FlatHashTable<TPolicy, THash, TEqual, TAllocator>::erase(const_iterator position)
+    {
+        std::size_t index = static_cast<std::size_t>(position.m_slot - m_slots);
+
+        SlotTraits::destroy(m_allocator, &TPolicy::getValue(m_slots[index]));
+        m_size--;
+
+        // The slot can be made empty again, rather than deleted, if no lookup can have
+        // gone past it: that is if every group holding it also has an empty slot
+        std::uint32_t emptyAfter  = matchEmpty(m_control + index);
+        std::uint32_t emptyBefore = matchEmpty(m_control + ((index - groupWidth) & m_capacity));
+
+        bool wasNeverFull = emptyAfter != 0 && emptyBefore != 0 &&
+                            static_cast<std::size_t>(std::countr_zero(emptyAfter) + std::countl_zero(static_cast<std::uint16_t>(emptyBefore))) < groupWidth;
+
+        if (wasNeverFull)
+        {
+            setControl(index, emptyControl);
+            m_growthLeft++;
+        }
+        else
+        {
+            setControl(index, deletedControl);
+        }
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    std::size_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::erase(const key_type& key)
+    {
+        std::size_t index = findIndex(key, hashKey(key));
+
+        if (index == m_capacity)
+            return 0;
+
+        erase(const_iterator(m_control + index, m_slots + index));
+
+        return 1;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    template <typename K>
+    std::size_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::erase(const K& key) requires transparentLookup && (!std::is_convertible_v<const K&, const_iterator>)
+    {
+        std::size_t index = findIndex(key, hashKey(key));
+
+        if (index == m_capacity)
+            return 0;
+
+        erase(const_iterator(m_control + index, m_slots + index));
+
+        return 1;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    void FlatHashTable<TPolicy, THash, TEqual, TAllocator>::swap(FlatHashTable& other) noexcept
+    {
+        using std::swap;
+
+        if constexpr (SlotTraits::propagate_on_container_swap::value)
+            swap(m_allocator, other.m_allocator);
+
+        swap(m_hash, other.m_hash);
+        swap(m_equal, other.m_equal);
+        swap(m_control, other.m_control);
+        swap(m_slots, other.m_slots);
+        swap(m_capacity, other.m_capacity);
+        swap(m_size, other.m_size);
+        swap(m_growthLeft, other.m_growthLeft);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    template <typename K, typename... TArgs>
+    std::pair<typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::iterator, bool>
+        FlatHashTable<TPolicy, THash, TEqual, TAllocator>::emplaceKey(const K& key, TArgs&&... args)
+    {
+        std::size_t hash  = hashKey(key);
+        std::size_t index = findIndex(key, hash);
+
+        if (index != m_capacity)
+            return { makeIterator(index), false };
+
+        index = findInsertIndex(hash);
+
+        // Reusing a deleted slot doesn't take up an empty one
+        if (m_growthLeft == 0 && m_control[index] != deletedControl)
+        {
+            // If deleted slots take up much of the table, cleaning them up is enough
+            if (m_capacity != 0 && m_size * 32 <= m_capacity * 25)
+                rehash(m_capacity);
+            else
+                rehash(getCapacityFor(m_size + 1));
+
+            index = findInsertIndex(hash);
+        }
+
+        SlotTraits::construct(m_allocator, &TPolicy::getValue(m_slots[index]), std::forward<TArgs>(args)...);
+
+        if (m_control[index] == emptyControl)
+            m_growthLeft--;
+
+        setControl(index, static_cast<Control>(hash & 0x7F));
+        m_size++;
+
+        return { makeIterator(index), true };
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline std::uint32_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::matchControl(const Control* group, Control control)
+    {
+#if defined(CEDAR_SIMD_SSE2)
+        __m128i controls = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8(control))));
+#else
+        std::uint32_t matches = 0;
+
+        for (std::size_t i = 0; i < groupWidth; i++)
+            matches |= static_cast<std::uint32_t>(group[i] == control) << i;
+
+        return matches;
+#endif
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline std::uint32_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::matchEmpty(const Control* group)
+    {
+        return matchControl(group, emptyControl);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline std::uint32_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::matchEmptyOrDeleted(const Control* group)
+    {
+#if defined(CEDAR_SIMD_SSE2)
+        __m128i controls = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(sentinelControl), controls)));
+#else
+        std::uint32_t matches = 0;
+
+        for (std::size_t i = 0; i < groupWidth; i++)
+            matches |= static_cast<std::uint32_t>(group[i] < sentinelControl) << i;
+
+        return matches;
+#endif
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline std::size_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::getCapacityFor(std::size_t count)
+    {
+        std::size_t capacity = groupWidth - 1;
+
+        while (getMaxLoad(capacity) < count)
+            capacity = capacity * 2 + 1;
+
+        return capacity;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline std::size_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::getMaxLoad(std::size_t capacity)
+    {
+        return capacity - capacity / 8;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline std::size_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::getAllocationCount(std::size_t capacity)
+    {
+        return capacity + (capacity + groupWidth + sizeof(Slot) - 1) / sizeof(Slot);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    template <typename K>
+    inline std::size_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::hashKey(const K& key) const
+    {
+        // Standard hashes of integers are often the integer itself, so the bits are mixed
+        // for both the low 7 and the rest to be spread out
+        std::uint64_t hash = static_cast<std::uint64_t>(m_hash(key)) * 0x9E37'79B9'7F4A'7C15ull;
+
+        return static_cast<std::size_t>(hash ^ (hash >> 32));
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    template <typename K>
+    std::size_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::findIndex(const K& key, std::size_t hash) const
+    {
+        Control     control  = static_cast<Control>(hash & 0x7F);
+        std::size_t position = (hash >> 7) & m_capacity;
+
+        for (std::size_t step = groupWidth;; step += groupWidth)
+        {
+            const Control* group = m_control + position;
+
+            for (std::uint32_t matches = matchControl(group, control); matches != 0; matches &= matches - 1)
+            {
+                std::size_t index = (position + static_cast<std::size_t>(std::countr_zero(matches))) & m_capacity;
+
+                if (m_equal(TPolicy::getKey(TPolicy::getValue(m_slots[index])), key))
+                    return index;
+            }
+
+            if (matchEmpty(group) != 0)
+                return m_capacity;
+
+            position = (position + step) & m_capacity;
+        }
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    std::size_t FlatHashTable<TPolicy, THash, TEqual, TAllocator>::findInsertIndex(std::size_t hash) const
+    {
+        std::size_t position = (hash >> 7) & m_capacity;
+
+        for (std::size_t step = groupWidth;; step += groupWidth)
+        {
+            std::uint32_t available = matchEmptyOrDeleted(m_control + position);
+
+            if (available != 0)
+                return (position + static_cast<std::size_t>(std::countr_zero(available))) & m_capacity;
+
+            position = (position + step) & m_capacity;
+        }
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline void FlatHashTable<TPolicy, THash, TEqual, TAllocator>::setControl(std::size_t index, Control control)
+    {
+        m_control[index] = control;
+        m_control[((index - (groupWidth - 1)) & m_capacity) + (groupWidth - 1)] = control;
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    inline typename FlatHashTable<TPolicy, THash, TEqual, TAllocator>::iterator FlatHashTable<TPolicy, THash, TEqual, TAllocator>::makeIterator(std::size_t index)
+    {
+        return iterator(m_control + index, m_slots + index);
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    void FlatHashTable<TPolicy, THash, TEqual, TAllocator>::rehash(std::size_t capacity)
+    {
+        Control*    oldControl  = m_control;
+        Slot*       oldSlots    = m_slots;
+        std::size_t oldCapacity = m_capacity;
+
+        m_slots    = SlotTraits::allocate(m_allocator, getAllocationCount(capacity));
+        m_control  = reinterpret_cast<Control*>(m_slots + capacity);
+        m_capacity = capacity;
+
+        std::memset(m_control, emptyControl, capacity + groupWidth);
+        m_control[capacity] = sentinelControl;
+
+        m_growthLeft = getMaxLoad(capacity) - m_size;
+
+        for (std::size_t i = 0; i < oldCapacity; i++)
+        {
+            if (oldControl[i] < 0)
+                continue;
+
+            std::size_t hash  = hashKey(TPolicy::getKey(TPolicy::getValue(oldSlots[i])));
+            std::size_t index = findInsertIndex(hash);
+
+            setControl(index, static_cast<Control>(hash & 0x7F));
+            TPolicy::transfer(m_allocator, m_slots + index, oldSlots + i);
+        }
+
+        if (oldCapacity != 0)
+            SlotTraits::deallocate(m_allocator, oldSlots, getAllocationCount(oldCapacity));
+    }
+
+
+
+    template <typename TPolicy, typename THash, typename TEqual, typename TAllocator>
+    void FlatHashTable<TPolicy, THash, TEqual, TAllocator>::destroyAndDeallocate()
+    {
+        if (m_capacity == 0)
+            return;
+
+        clear();
+        SlotTraits::deallocate(m_allocator, m_slots, getAllocationCount(m_capacity));
+    }
+
+    // ^^^ FlatHashTable function definitions ^^^
+}
+
+#endif // CEDAR_CONTAINERS_FLAT_HASH_TABLE_H
\ No newline at end of file
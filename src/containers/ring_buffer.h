@@ -0,0 +1,506 @@
+//
+// Fixed capacity ring buffer.
+//
+// RingBuffer keeps up to TCapacity elements inside itself, in a circular array, and never
+// allocates. Elements are pushed at the back and popped from either end; when it's full,
+// pushBack throws while pushBackEvicting drops the oldest element to make room, which is
+// what a history of the last N frames, messages or samples wants. A power of two capacity
+// turns the index wrapping into a mask.
+//
+
+#ifndef CEDAR_CONTAINERS_RING_BUFFER_H
+#define CEDAR_CONTAINERS_RING_BUFFER_H
+
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+
+
+namespace Cedar
+{
+    template <typename T, std::size_t TCapacity>
+    class RingBuffer;
+
+
+
+    template <typename T, std::size_t TCapacity>
+    class RingBuffer
+    {
+    public:
+
+        template <bool TConst>
+        class Iterator;
+
+
+        typedef T                 value_type;
+        typedef std::size_t       size_type;
+        typedef std::ptrdiff_t    difference_type;
+        typedef T&                reference;
+        typedef const T&          const_reference;
+        typedef Iterator<false>   iterator;
+        typedef Iterator<true>    const_iterator;
+
+
+        static constexpr std::size_t capacity = TCapacity;
+
+        static_assert(TCapacity > 0, "Ring buffers need a capacity");
+
+
+        inline RingBuffer() = default;
+
+        RingBuffer(const RingBuffer& other);
+
+        RingBuffer(RingBuffer&& other) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+        inline ~RingBuffer();
+
+
+        RingBuffer& operator=(const RingBuffer& other);
+
+        RingBuffer& operator=(RingBuffer&& other) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+
+        // From the oldest element to the newest.
+        inline iterator begin();
+
+        inline const_iterator begin() const;
+
+        inline iterator end();
+
+        inline const_iterator end() const;
+
+
+        // Index 0 is the oldest element.
+        inline T& operator[](std::size_t index);
+
+        inline const T& operator[](std::size_t index) const;
+
+        inline T& front();
+
+        inline const T& front() const;
+
+        inline T& back();
+
+        inline const T& back() const;
+
+
+        inline std::size_t getSize() const;
+
+        inline bool isEmpty() const;
+
+        inline bool isFull() const;
+
+        static constexpr std::size_t getCapacity() { return TCapacity; }
+
+
+        // Throw std::length_error if the buffer is full.
+        inline void pushBack(const T& value);
+
+        inline void pushBack(T&& value);
+
+        template <typename... TArgs>
+        T& emplaceBack(TArgs&&... args);
+
+        // Drop the oldest element first if the buffer is full.
+        inline void pushBackEvicting(const T& value);
+
+        inline void pushBackEvicting(T&& value);
+
+        template <typename... TArgs>
+        T& emplaceBackEvicting(TArgs&&... args);
+
+        inline void popFront();
+
+        inline void popBack();
+
+        void clear();
+
+    private:
+
+        alignas(T) unsigned char m_storage[TCapacity * sizeof(T)];
+
+        std::size_t m_head = 0; // Slot of the oldest element
+        std::size_t m_size = 0;
+
+
+        // The slot of the element at the index from the oldest.
+        inline T* getSlot(std::size_t index);
+
+        inline const T* getSlot(std::size_t index) const;
+    };
+
+
+
+    template <typename T, std::size_t TCapacity>
+    template <bool TConst>
+    class RingBuffer<T, TCapacity>::Iterator
+    {
+    public:
+
+        typedef std::random_access_iterator_tag                    iterator_category;
+        typedef T                                                  value_type;
+        typedef std::ptrdiff_t                                     difference_type;
+        typedef std::conditional_t<TConst, const T*, T*>           pointer;
+        typedef std::conditional_t<TConst, const T&, T&>           reference;
+        typedef std::conditional_t<TConst, const RingBuffer*, RingBuffer*> Buffer;
+
+
+        inline Iterator() = default;
+
+        // Converts iterators to const iterators.
+        template <bool TOtherConst>
+        inline Iterator(const Iterator<TOtherConst>& other) requires (TConst && !TOtherConst) : m_buffer(other.m_buffer), m_index(other.m_index) {}
+
+
+        inline reference operator*() const { return *m_buffer->getSlot(m_index); }
+
+        inline pointer operator->() const { return m_buffer->getSlot(m_index); }
+
+        inline reference operator[](difference_type offset) const { return *m_buffer->getSlot(m_index + offset); }
+
+
+        inline Iterator& operator++() { m_index++; return *this; }
+
+        inline Iterator operator++(int) { Iterator previous = *this; m_index++; return previous; }
+
+        inline Iterator& operator--() { m_index--; return *this; }
+
+        inline Iterator operator--(int) { Iterator previous = *this; m_index--; return previous; }
+
+        inline Iterator& operator+=(difference_type offset) { m_index += offset; return *this; }
+
+        inline Iterator& operator-=(difference_type offset) { m_index -= offset; return *this; }
+
+        inline Iterator operator+(difference_type offset) const { return Iterator(m_buffer, m_index + offset); }
+
+        inline Iterator operator-(difference_type offset) const { return Iterator(m_buffer, m_index - offset); }
+
+        friend inline Iterator operator+(difference_type offset, const Iterator& iterator) { return iterator + offset; }
+
+        inline difference_type operator-(const Iterator& other) const {
+            return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index);
+        }
+
+
+        inline bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+
+        inline auto operator<=>(const Iterator& other) const { return m_index <=> other.m_index; }
+
+    private:
+
+        friend class RingBuffer;
+
+        friend class Iterator<!TConst>;
+
+
+        Buffer      m_buffer = nullptr;
+        std::size_t m_index  = 0;   // From the oldest element
+
+
+        inline Iterator(Buffer buffer, std::size_t index) : m_buffer(buffer), m_index(index) {}
+    };
+
+
+
+    // vvv RingBuffer function definitions vvv
+
+    template <typename T, std::size_t TCapacity>
+    RingBuffer<T, TCapacity>::RingBuffer(const RingBuffer& other)
+    {
+        for (const T& value : other)
+            emplaceBack(value);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    RingBuffer<T, TCapacity>::RingBuffer(RingBuffer&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        for (T& value : other)
+            emplaceBack(std::move(value));
+
+        other.clear();
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline RingBuffer<T, TCapacity>::~RingBuffer()
+    {
+        clear();
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    RingBuffer<T, TCapacity>& RingBuffer<T, TCapacity>::operator=(const RingBuffer& other)
+    {
+        if (this == &other)
+            return *this;
+
+        clear();
+
+        for (const T& value : other)
+            emplaceBack(value);
+
+        return *this;
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    RingBuffer<T, TCapacity>& RingBuffer<T, TCapacity>::operator=(RingBuffer&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        if (this == &other)
+            return *this;
+
+        clear();
+
+        for (T& value : other)
+            emplaceBack(std::move(value));
+
+        other.clear();
+
+        return *this;
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline typename RingBuffer<T, TCapacity>::iterator RingBuffer<T, TCapacity>::begin()
+    {
+        return iterator(this, 0);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline typename RingBuffer<T, TCapacity>::const_iterator RingBuffer<T, TCapacity>::begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline typename RingBuffer<T, TCapacity>::iterator RingBuffer<T, TCapacity>::end()
+    {
+        return iterator(this, m_size);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline typename RingBuffer<T, TCapacity>::const_iterator RingBuffer<T, TCapacity>::end() const
+    {
+        return const_iterator(this, m_size);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline T& RingBuffer<T, TCapacity>::operator[](std::size_t index)
+    {
+        return *getSlot(index);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline const T& RingBuffer<T, TCapacity>::operator[](std::size_t index) const
+    {
+        return *getSlot(index);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline T& RingBuffer<T, TCapacity>::front()
+    {
+        return *getSlot(0);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline const T& RingBuffer<T, TCapacity>::front() const
+    {
+        return *getSlot(0);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline T& RingBuffer<T, TCapacity>::back()
+    {
+        return *getSlot(m_size - 1);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline const T& RingBuffer<T, TCapacity>::back() const
+    {
+        return *getSlot(m_size - 1);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline std::size_t RingBuffer<T, TCapacity>::getSize() const
+    {
+        return m_size;
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline bool RingBuffer<T, TCapacity>::isEmpty() const
+    {
+        return m_size == 0;
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline bool RingBuffer<T, TCapacity>::isFull() const
+    {
+        return m_size == TCapacity;
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline void RingBuffer<T, TCapacity>::pushBack(const T& value)
+    {
+        emplaceBack(value);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline void RingBuffer<T, TCapacity>::pushBack(T&& value)
+    {
+        emplaceBack(std::move(value));
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    template <typename... TArgs>
+    T& RingBuffer<T, TCapacity>::emplaceBack(TArgs&&... args)
+    {
+        if (m_size == TCapacity)
+            throw std::length_error("Ring buffer is full");
+
+        T* element = std::construct_at(getSlot(m_size), std::forward<TArgs>(args)...);
+        m_size++;
+
+        return *element;
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline void RingBuffer<T, TCapacity>::pushBackEvicting(const T& value)
+    {
+        emplaceBackEvicting(value);
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline void RingBuffer<T, TCapacity>::pushBackEvicting(T&& value)
+    {
+        emplaceBackEvicting(std::move(value));
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    template <typename... TArgs>
+    T& RingBuffer<T, TCapacity>::emplaceBackEvicting(TArgs&&... args)
+    {
+        if (m_size < TCapacity)
+            return emplaceBack(std::forward<TArgs>(args)...);
+
+        // The new element takes the oldest one's slot. It's built before the oldest is
+        // destroyed, as the arguments may refer to it
+        T value(std::forward<TArgs>(args)...);
+        T* slot = getSlot(0);
+
+        std::destroy_at(slot);
+        std::construct_at(slot, std::move(value));
+
+        m_head = m_head + 1 == TCapacity ? 0 : m_head + 1;
+
+        return *slot;
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline void RingBuffer<T, TCapacity>::popFront()
+    {
+        std::destroy_at(getSlot(0));
+
+        m_head = m_head + 1 == TCapacity ? 0 : m_head + 1;
+        m_size--;
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline void RingBuffer<T, TCapacity>::popBack()
+    {
+        std::destroy_at(getSlot(m_size - 1));
+        m_size--;
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    void RingBuffer<T, TCapacity>::clear()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            for (std::size_t i = 0; i < m_size; i++)
+                std::destroy_at(getSlot(i));
+        }
+
+        m_head = 0;
+        m_size = 0;
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline T* RingBuffer<T, TCapacity>::getSlot(std::size_t index)
+    {
+        return const_cast<T*>(static_cast<const RingBuffer*>(this)->getSlot(index));
+    }
+
+
+
+    template <typename T, std::size_t TCapacity>
+    inline const T* RingBuffer<T, TCapacity>::getSlot(std::size_t index) const
+    {
+        std::size_t slot = m_head + index;
+
+        if constexpr ((TCapacity & (TCapacity - 1)) == 0)
+            slot &= TCapacity - 1;
+        else if (slot >= TCapacity)
+            slot -= TCapacity;
+
+        return reinterpret_cast<const T*>(m_storage) + slot;
+    }
+
+    // ^^^ RingBuffer function definitions ^^^
+}
+
+#endif // CEDAR_CONTAINERS_RING_BUFFER_H
\ No newline at end of file
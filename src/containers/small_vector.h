@@ -0,0 +1,729 @@
+//
+// Vector with inline storage.
+//
+// SmallVector keeps up to TInlineCapacity elements inside itself and only allocates once
+// it grows past them, so short lists (the children of a node, the contacts of a body,
+// the arguments of a command) cost no allocation and sit next to the data that owns
+// them. Past the inline capacity it behaves like std::vector, growing by doubling.
+//
+// Moving a SmallVector whose elements are inline moves them one by one, so unlike
+// std::vector it invalidates pointers to them.
+//
+
+#ifndef CEDAR_CONTAINERS_SMALL_VECTOR_H
+#define CEDAR_CONTAINERS_SMALL_VECTOR_H
+
+#include "../memory/memory_tracker.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+
+
+namespace Cedar
+{
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator = Memory::TrackedAllocator<T>>
+    class SmallVector;
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    class SmallVector
+    {
+    public:
+
+        typedef T                                     value_type;
+        typedef std::size_t                           size_type;
+        typedef std::ptrdiff_t                        difference_type;
+        typedef TAllocator                            allocator_type;
+        typedef T&                                    reference;
+        typedef const T&                              const_reference;
+        typedef T*                                    pointer;
+        typedef const T*                              const_pointer;
+        typedef T*                                    iterator;
+        typedef const T*                              const_iterator;
+        typedef std::reverse_iterator<T*>             reverse_iterator;
+        typedef std::reverse_iterator<const T*>       const_reverse_iterator;
+
+
+        static constexpr std::size_t inlineCapacity = TInlineCapacity;
+
+        static_assert(TInlineCapacity > 0, "Small vectors need an inline capacity, use std::vector otherwise");
+
+
+        inline SmallVector() noexcept(std::is_nothrow_default_constructible_v<TAllocator>) {}
+
+        inline explicit SmallVector(const TAllocator& allocator) noexcept;
+
+        SmallVector(std::initializer_list<T> values, const TAllocator& allocator = TAllocator());
+
+        SmallVector(const SmallVector& other);
+
+        SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+        ~SmallVector();
+
+
+        SmallVector& operator=(const SmallVector& other);
+
+        SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T> &&
+                                                             std::allocator_traits<TAllocator>::is_always_equal::value);
+
+
+        inline T* begin();
+
+        inline const T* begin() const;
+
+        inline T* end();
+
+        inline const T* end() const;
+
+        inline reverse_iterator rbegin();
+
+        inline const_reverse_iterator rbegin() const;
+
+        inline reverse_iterator rend();
+
+        inline const_reverse_iterator rend() const;
+
+
+        inline T& operator[](std::size_t index);
+
+        inline const T& operator[](std::size_t index) const;
+
+        // Throw std::out_of_range if the index is past the end.
+        inline T& at(std::size_t index);
+
+        inline const T& at(std::size_t index) const;
+
+        inline T& front();
+
+        inline const T& front() const;
+
+        inline T& back();
+
+        inline const T& back() const;
+
+        inline T* data();
+
+        inline const T* data() const;
+
+
+        inline std::size_t getSize() const;
+
+        inline bool isEmpty() const;
+
+        inline std::size_t getCapacity() const;
+
+        // Whether the elements are in the inline storage.
+        inline bool isInline() const;
+
+        inline TAllocator getAllocator() const;
+
+
+        void reserve(std::size_t capacity);
+
+        // New elements are value-initialized, or copies of the value.
+        void resize(std::size_t size);
+
+        void resize(std::size_t size, const T& value);
+
+        // Destroys the elements but keeps the memory.
+        void clear();
+
+
+        inline void pushBack(const T& value);
+
+        inline void pushBack(T&& value);
+
+        // Returns the new element.
+        template <typename... TArgs>
+        T& emplaceBack(TArgs&&... args);
+
+        inline void popBack();
+
+
+        // Shifts the elements after the position up by one. Returns the new element.
+        template <typename... TArgs>
+        T* emplace(const T* position, TArgs&&... args);
+
+        inline T* insert(const T* position, const T& value);
+
+        inline T* insert(const T* position, T&& value);
+
+        // Shifts the elements after the erased ones down. Returns the element after them.
+        T* erase(const T* position);
+
+        T* erase(const T* first, const T* last);
+
+        // Moves the last element into the erased one's place, which doesn't keep the order
+        // but doesn't shift anything.
+        void eraseUnordered(const T* position);
+
+    private:
+
+        typedef std::allocator_traits<TAllocator> Traits;
+
+
+        [[no_unique_address]] TAllocator m_allocator;
+
+        T*          m_data     = reinterpret_cast<T*>(m_storage);
+        std::size_t m_size     = 0;
+        std::size_t m_capacity = TInlineCapacity;
+
+        alignas(T) unsigned char m_storage[TInlineCapacity * sizeof(T)];
+
+
+        // Moves the elements to a new allocation of the capacity.
+        void reallocate(std::size_t capacity);
+
+        inline std::size_t getGrownCapacity(std::size_t size) const;
+
+        // Moves the other vector's elements in, or takes its allocation over.
+        void takeFrom(SmallVector& other);
+
+        void destroyAndDeallocate();
+    };
+
+
+
+    // vvv SmallVector function definitions vvv
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline SmallVector<T, TInlineCapacity, TAllocator>::SmallVector(const TAllocator& allocator) noexcept :
+        m_allocator(allocator)
+    {}
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    SmallVector<T, TInlineCapacity, TAllocator>::SmallVector(std::initializer_list<T> values, const TAllocator& allocator) :
+        m_allocator(allocator)
+    {
+        reserve(values.size());
+
+        for (const T& value : values)
+            Traits::construct(m_allocator, m_data + m_size++, value);
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    SmallVector<T, TInlineCapacity, TAllocator>::SmallVector(const SmallVector& other) :
+        m_allocator(Traits::select_on_container_copy_construction(other.m_allocator))
+    {
+        reserve(other.m_size);
+
+        for (const T& value : other)
+            Traits::construct(m_allocator, m_data + m_size++, value);
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    SmallVector<T, TInlineCapacity, TAllocator>::SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) :
+        m_allocator(std::move(other.m_allocator))
+    {
+        takeFrom(other);
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    SmallVector<T, TInlineCapacity, TAllocator>::~SmallVector()
+    {
+        destroyAndDeallocate();
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    SmallVector<T, TInlineCapacity, TAllocator>& SmallVector<T, TInlineCapacity, TAllocator>::operator=(const SmallVector& other)
+    {
+        if (this == &other)
+            return *this;
+
+        if constexpr (Traits::propagate_on_container_copy_assignment::value)
+        {
+            if (m_allocator != other.m_allocator)
+            {
+                destroyAndDeallocate();
+                m_data     = reinterpret_cast<T*>(m_storage);
+                m_size     = 0;
+                m_capacity = TInlineCapacity;
+            }
+
+            m_allocator = other.m_allocator;
+        }
+
+        clear();
+        reserve(other.m_size);
+
+        for (const T& value : other)
+            Traits::construct(m_allocator, m_data + m_size++, value);
+
+        return *this;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    SmallVector<T, TInlineCapacity, TAllocator>& SmallVector<T, TInlineCapacity, TAllocator>::operator=(SmallVector&& other)
+        noexcept(std::is_nothrow_move_constructible_v<T> && std::allocator_traits<TAllocator>::is_always_equal::value)
+    {
+        if (this == &other)
+            return *this;
+
+        destroyAndDeallocate();
+        m_data     = reinterpret_cast<T*>(m_storage);
+        m_size     = 0;
+        m_capacity = TInlineCapacity;
+
+        if constexpr (Traits::propagate_on_container_move_assignment::value)
+            m_allocator = std::move(other.m_allocator);
+
+        takeFrom(other);
+
+        return *this;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline T* SmallVector<T, TInlineCapacity, TAllocator>::begin()
+    {
+        return m_data;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline const T* SmallVector<T, TInlineCapacity, TAllocator>::begin() const
+    {
+        return m_data;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline T* SmallVector<T, TInlineCapacity, TAllocator>::end()
+    {
+        return m_data + m_size;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline const T* SmallVector<T, TInlineCapacity, TAllocator>::end() const
+    {
+        return m_data + m_size;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline typename SmallVector<T, TInlineCapacity, TAllocator>::reverse_iterator SmallVector<T, TInlineCapacity, TAllocator>::rbegin()
+    {
+        return reverse_iterator(end());
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline typename SmallVector<T, TInlineCapacity, TAllocator>::const_reverse_iterator SmallVector<T, TInlineCapacity, TAllocator>::rbegin() const
+    {
+        return const_reverse_iterator(end());
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline typename SmallVector<T, TInlineCapacity, TAllocator>::reverse_iterator SmallVector<T, TInlineCapacity, TAllocator>::rend()
+    {
+        return reverse_iterator(begin());
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline typename SmallVector<T, TInlineCapacity, TAllocator>::const_reverse_iterator SmallVector<T, TInlineCapacity, TAllocator>::rend() const
+    {
+        return const_reverse_iterator(begin());
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline T& SmallVector<T, TInlineCapacity, TAllocator>::operator[](std::size_t index)
+    {
+        return m_data[index];
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline const T& SmallVector<T, TInlineCapacity, TAllocator>::operator[](std::size_t index) const
+    {
+        return m_data[index];
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline T& SmallVector<T, TInlineCapacity, TAllocator>::at(std::size_t index)
+    {
+        if (index >= m_size)
+            throw std::out_of_range("Small vector index out of range");
+
+        return m_data[index];
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline const T& SmallVector<T, TInlineCapacity, TAllocator>::at(std::size_t index) const
+    {
+        if (index >= m_size)
+            throw std::out_of_range("Small vector index out of range");
+
+        return m_data[index];
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline T& SmallVector<T, TInlineCapacity, TAllocator>::front()
+    {
+        return m_data[0];
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline const T& SmallVector<T, TInlineCapacity, TAllocator>::front() const
+    {
+        return m_data[0];
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline T& SmallVector<T, TInlineCapacity, TAllocator>::back()
+    {
+        return m_data[m_size - 1];
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline const T& SmallVector<T, TInlineCapacity, TAllocator>::back() const
+    {
+        return m_data[m_size - 1];
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline T* SmallVector<T, TInlineCapacity, TAllocator>::data()
+    {
+        return m_data;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline const T* SmallVector<T, TInlineCapacity, TAllocator>::data() const
+    {
+        return m_data;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline std::size_t SmallVector<T, TInlineCapacity, TAllocator>::getSize() const
+    {
+        return m_size;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline bool SmallVector<T, TInlineCapacity, TAllocator>::isEmpty() const
+    {
+        return m_size == 0;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline std::size_t SmallVector<T, TInlineCapacity, TAllocator>::getCapacity() const
+    {
+        return m_capacity;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline bool SmallVector<T, TInlineCapacity, TAllocator>::isInline() const
+    {
+        return m_data == reinterpret_cast<const T*>(m_storage);
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline TAllocator SmallVector<T, TInlineCapacity, TAllocator>::getAllocator() const
+    {
+        return m_allocator;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    void SmallVector<T, TInlineCapacity, TAllocator>::reserve(std::size_t capacity)
+    {
+        if (capacity > m_capacity)
+            reallocate(capacity);
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    void SmallVector<T, TInlineCapacity, TAllocator>::resize(std::size_t size)
+    {
+        if (size <= m_size)
+        {
+            erase(m_data + size, m_data + m_size);
+            return;
+        }
+
+        reserve(size);
+
+        while (m_size < size)
+            Traits::construct(m_allocator, m_data + m_size++);
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    void SmallVector<T, TInlineCapacity, TAllocator>::resize(std::size_t size, const T& value)
+    {
+        if (size <= m_size)
+        {
+            erase(m_data + size, m_data + m_size);
+            return;
+        }
+
+        // Copied first in case it's one of the elements and they move
+        T copy = value;
+
+        reserve(size);
+
+        while (m_size < size)
+            Traits::construct(m_allocator, m_data + m_size++, copy);
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    void SmallVector<T, TInlineCapacity, TAllocator>::clear()
+    {
+        std::destroy(m_data, m_data + m_size);
+        m_size = 0;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline void SmallVector<T, TInlineCapacity, TAllocator>::pushBack(const T& value)
+    {
+        emplaceBack(value);
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline void SmallVector<T, TInlineCapacity, TAllocator>::pushBack(T&& value)
+    {
+        emplaceBack(std::move(value));
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    template <typename... TArgs>
+    T& SmallVector<T, TInlineCapacity, TAllocator>::emplaceBack(TArgs&&... args)
+    {
+        if (m_size < m_capacity)
+        {
+            Traits::construct(m_allocator, m_data + m_size, std::forward<TArgs>(args)...);
+            return m_data[m_size++];
+        }
+
+        // The new element is constructed before the old ones move, as the arguments may
+        // refer to them
+        std::size_t capacity = getGrownCapacity(m_size + 1);
+        T*          data     = Traits::allocate(m_allocator, capacity);
+
+        try {
+            Traits::construct(m_allocator, data + m_size, std::forward<TArgs>(args)...);
+        }
+        catch (...) {
+            Traits::deallocate(m_allocator, data, capacity);
+            throw;
+        }
+
+        std::uninitialized_move(m_data, m_data + m_size, data);
+        std::destroy(m_data, m_data + m_size);
+
+        if (!isInline())
+            Traits::deallocate(m_allocator, m_data, m_capacity);
+
+        m_data     = data;
+        m_capacity = capacity;
+
+        return m_data[m_size++];
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline void SmallVector<T, TInlineCapacity, TAllocator>::popBack()
+    {
+        Traits::destroy(m_allocator, m_data + --m_size);
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    template <typename... TArgs>
+    T* SmallVector<T, TInlineCapacity, TAllocator>::emplace(const T* position, TArgs&&... args)
+    {
+        std::size_t index = static_cast<std::size_t>(position - m_data);
+
+        emplaceBack(std::forward<TArgs>(args)...);
+        std::rotate(m_data + index, m_data + m_size - 1, m_data + m_size);
+
+        return m_data + index;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline T* SmallVector<T, TInlineCapacity, TAllocator>::insert(const T* position, const T& value)
+    {
+        return emplace(position, value);
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline T* SmallVector<T, TInlineCapacity, TAllocator>::insert(const T* position, T&& value)
+    {
+        return emplace(position, std::move(value));
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    T* SmallVector<T, TInlineCapacity, TAllocator>::erase(const T* position)
+    {
+        return erase(position, position + 1);
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    T* SmallVector<T, TInlineCapacity, TAllocator>::erase(const T* first, const T* last)
+    {
+        T* begin = m_data + (first - m_data);
+        T* end   = std::move(m_data + (last - m_data), m_data + m_size, begin);
+
+        std::destroy(end, m_data + m_size);
+        m_size = static_cast<std::size_t>(end - m_data);
+
+        return begin;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    void SmallVector<T, TInlineCapacity, TAllocator>::eraseUnordered(const T* position)
+    {
+        T* element = m_data + (position - m_data);
+
+        if (element != m_data + m_size - 1)
+            *element = std::move(m_data[m_size - 1]);
+
+        popBack();
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    void SmallVector<T, TInlineCapacity, TAllocator>::reallocate(std::size_t capacity)
+    {
+        T* data = Traits::allocate(m_allocator, capacity);
+
+        std::uninitialized_move(m_data, m_data + m_size, data);
+        std::destroy(m_data, m_data + m_size);
+
+        if (!isInline())
+            Traits::deallocate(m_allocator, m_data, m_capacity);
+
+        m_data     = data;
+        m_capacity = capacity;
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    inline std::size_t SmallVector<T, TInlineCapacity, TAllocator>::getGrownCapacity(std::size_t size) const
+    {
+        return std::max(m_capacity * 2, size);
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    void SmallVector<T, TInlineCapacity, TAllocator>::takeFrom(SmallVector& other)
+    {
+        // An allocation can only change hands between equal allocators
+        if (!other.isInline() && m_allocator == other.m_allocator)
+        {
+            m_data     = std::exchange(other.m_data, reinterpret_cast<T*>(other.m_storage));
+            m_size     = std::exchange(other.m_size, 0);
+            m_capacity = std::exchange(other.m_capacity, TInlineCapacity);
+
+            return;
+        }
+
+        reserve(other.m_size);
+
+        std::uninitialized_move(other.m_data, other.m_data + other.m_size, m_data);
+        m_size = other.m_size;
+
+        other.clear();
+    }
+
+
+
+    template <typename T, std::size_t TInlineCapacity, typename TAllocator>
+    void SmallVector<T, TInlineCapacity, TAllocator>::destroyAndDeallocate()
+    {
+        std::destroy(m_data, m_data + m_size);
+
+        if (!isInline())
+            Traits::deallocate(m_allocator, m_data, m_capacity);
+    }
+
+    // ^^^ SmallVector function definitions ^^^
+}
+
+#endif // CEDAR_CONTAINERS_SMALL_VECTOR_H
\ No newline at end of file
@@ -11,6 +11,9 @@
 #define CEDAR_STRINGIFY_MACRO(macro) CEDAR_STRINGIFY(macro)
 #define CEDAR_STRINGIFY(x)           #x
 
+#define CEDAR_CONCAT_MACRO(a, b) CEDAR_CONCAT(a, b)
+#define CEDAR_CONCAT(a, b)       a##b
+
 // OS
 #if defined(__linux__)
     #define CEDAR_OS_LINUX
@@ -25,6 +28,18 @@
     #define CEDAR_DEBUG
 #endif
 
+// Memory tracking (always on in debug builds, can be enabled for release builds by
+// defining CEDAR_MEMORY_TRACKING)
+#if defined(CEDAR_DEBUG) && !defined(CEDAR_MEMORY_TRACKING)
+    #define CEDAR_MEMORY_TRACKING
+#endif
+
+// Profiling (always on in debug builds, can be enabled for release builds by defining
+// CEDAR_PROFILE)
+#if defined(CEDAR_DEBUG) && !defined(CEDAR_PROFILE)
+    #define CEDAR_PROFILE
+#endif
+
 // Compiler
 #if defined(_MSC_VER)
     #define CEDAR_COMPILER_MSVC _MSC_VER
@@ -40,4 +55,14 @@
     #define CEDAR_FORCE_INLINE_SUPPORTED CEDAR_FALSE
 #endif
 
+// SIMD instruction sets enabled for the target (e.g. with -mavx2 or /arch:AVX2). Code
+// using them must keep a scalar fallback for targets without them
+#if defined(__AVX2__)
+    #define CEDAR_SIMD_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #define CEDAR_SIMD_SSE2
+#endif
+
 #endif // CEDAR_CORE_H
\ No newline at end of file
@@ -0,0 +1,12 @@
+//
+// A collection of header files located in the "debug" directory.
+//
+
+#ifndef CEDAR_DEBUG_H
+#define CEDAR_DEBUG_H
+
+#include "debug/frame_stats.h"
+#include "debug/log_console.h"
+#include "debug/profiler.h"
+
+#endif // CEDAR_DEBUG_H
\ No newline at end of file
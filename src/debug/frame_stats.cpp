@@ -0,0 +1,223 @@
+#include "frame_stats.h"
+
+#include "profiler.h"
+#include "../io/log.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+
+
+
+namespace
+{
+    constexpr std::uint64_t histogramBucketWidth = 50'000; // Nanoseconds
+    constexpr std::size_t   histogramBucketCount = 4000;   // Covers up to 200 ms, the last bucket counts everything longer
+
+
+
+    struct FrameStatsData;
+
+
+
+    // Constant initialized, so the module is usable during static initialization and
+    // doesn't need a nifty counter.
+    struct FrameStatsData
+    {
+        std::array<std::uint64_t, Cedar::FrameStats::windowSize> frameTimes = {};
+        std::array<std::uint32_t, histogramBucketCount>          histogram  = {};
+
+        std::size_t   nextIndex       = 0;
+        std::size_t   frameCount      = 0;
+        std::uint64_t totalFrameCount = 0;
+        std::uint64_t totalTime       = 0; // Sum of the frames in the window
+        std::uint64_t maxTime         = 0; // Longest frame in the window
+        std::size_t   hitchCount      = 0;
+
+        std::uint64_t hitchThreshold = Cedar::FrameStats::defaultHitchThreshold;
+        std::uint64_t lastTimestamp  = 0;
+    };
+
+
+
+    FrameStatsData g_frameStats;
+
+
+
+    inline std::size_t getHistogramBucket(std::uint64_t frameTime);
+
+    std::uint64_t getPercentile(std::size_t percentile);
+
+    void recalculateMax();
+
+
+
+    inline std::size_t getHistogramBucket(std::uint64_t frameTime) {
+        return static_cast<std::size_t>(std::min<std::uint64_t>(frameTime / histogramBucketWidth, histogramBucketCount - 1));
+    }
+
+
+
+    std::uint64_t getPercentile(std::size_t percentile)
+    {
+        if (g_frameStats.frameCount == 0)
+            return 0;
+
+        // Nearest-rank method
+        std::size_t rank       = (g_frameStats.frameCount * percentile + 99) / 100;
+        std::size_t cumulative = 0;
+
+        for (std::size_t bucket = 0; bucket < histogramBucketCount; bucket++)
+        {
+            cumulative += g_frameStats.histogram[bucket];
+
+            if (cumulative < rank)
+                continue;
+
+            // The last bucket is open-ended, so only the longest frame bounds it
+            if (bucket == histogramBucketCount - 1)
+                return g_frameStats.maxTime;
+
+            // Report the bucket's upper edge, which can't exceed the longest frame
+            return std::min((bucket + 1) * histogramBucketWidth, g_frameStats.maxTime);
+        }
+
+        return g_frameStats.maxTime;
+    }
+
+
+
+    void recalculateMax()
+    {
+        g_frameStats.maxTime = 0;
+
+        for (std::size_t i = 0; i < g_frameStats.frameCount; i++)
+            g_frameStats.maxTime = std::max(g_frameStats.maxTime, g_frameStats.frameTimes[i]);
+    }
+}
+
+
+
+namespace Cedar::FrameStats
+{
+    void markFrame()
+    {
+        std::uint64_t timestamp = Profiler::getTimestamp();
+
+        if (g_frameStats.lastTimestamp != 0)
+            recordFrame(timestamp - g_frameStats.lastTimestamp);
+
+        g_frameStats.lastTimestamp = timestamp;
+    }
+
+
+
+    void recordFrame(std::uint64_t frameTime)
+    {
+        std::uint64_t& slot = g_frameStats.frameTimes[g_frameStats.nextIndex];
+        bool maxEvicted     = false;
+
+        // Evict the oldest frame once the window is full
+        if (g_frameStats.frameCount == windowSize)
+        {
+            g_frameStats.totalTime -= slot;
+            g_frameStats.histogram[getHistogramBucket(slot)]--;
+
+            if (slot > g_frameStats.hitchThreshold)
+                g_frameStats.hitchCount--;
+
+            maxEvicted = (slot == g_frameStats.maxTime);
+        }
+        else
+            g_frameStats.frameCount++;
+
+        slot = frameTime;
+
+        g_frameStats.totalTime += frameTime;
+        g_frameStats.histogram[getHistogramBucket(frameTime)]++;
+
+        if (frameTime > g_frameStats.hitchThreshold)
+            g_frameStats.hitchCount++;
+
+        // Only rescan the window when the longest frame fell out of it and the new frame
+        // doesn't replace it
+        if (frameTime >= g_frameStats.maxTime)
+            g_frameStats.maxTime = frameTime;
+        else if (maxEvicted)
+            recalculateMax();
+
+        g_frameStats.nextIndex = (g_frameStats.nextIndex + 1) % windowSize;
+        g_frameStats.totalFrameCount++;
+    }
+
+
+
+    Summary getSummary()
+    {
+        Summary summary;
+        summary.frameCount      = g_frameStats.frameCount;
+        summary.totalFrameCount = g_frameStats.totalFrameCount;
+        summary.average         = (g_frameStats.frameCount != 0) ? g_frameStats.totalTime / g_frameStats.frameCount : 0;
+        summary.p50             = getPercentile(50);
+        summary.p95             = getPercentile(95);
+        summary.p99             = getPercentile(99);
+        summary.max             = g_frameStats.maxTime;
+        summary.hitchCount      = g_frameStats.hitchCount;
+
+        return summary;
+    }
+
+
+
+    void logSummary()
+    {
+        Summary summary = getSummary();
+
+        auto toMilliseconds = [](std::uint64_t nanoseconds) { return nanoseconds / 1'000'000.0; };
+
+        Cedar::Log::info(std::format("Frame times over the last {} of {} frames: avg {:.2f} ms, p50 {:.2f} ms, "
+                                     "p95 {:.2f} ms, p99 {:.2f} ms, max {:.2f} ms, {} hitch(es) over {:.2f} ms",
+                                     summary.frameCount, summary.totalFrameCount,
+                                     toMilliseconds(summary.average),
+                                     toMilliseconds(summary.p50),
+                                     toMilliseconds(summary.p95),
+                                     toMilliseconds(summary.p99),
+                                     toMilliseconds(summary.max),
+                                     summary.hitchCount,
+                                     toMilliseconds(g_frameStats.hitchThreshold)));
+    }
+
+
+
+    std::uint64_t getHitchThreshold()
+    {
+        return g_frameStats.hitchThreshold;
+    }
+
+
+
+    void setHitchThreshold(std::uint64_t threshold)
+    {
+        g_frameStats.hitchThreshold = threshold;
+        g_frameStats.hitchCount     = 0;
+
+        for (std::size_t i = 0; i < g_frameStats.frameCount; i++)
+        {
+            if (g_frameStats.frameTimes[i] > threshold)
+                g_frameStats.hitchCount++;
+        }
+    }
+
+
+
+    void reset()
+    {
+        std::uint64_t hitchThreshold = g_frameStats.hitchThreshold;
+
+        g_frameStats = FrameStatsData();
+        g_frameStats.hitchThreshold = hitchThreshold;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+//
+// Frame-time statistics.
+//
+// Keeps the durations of the most recent frames in a fixed-size ring along with a
+// histogram of the same frames, both updated in constant time as frames are recorded.
+// Percentiles are read off the histogram, so they're accurate to the width of a
+// histogram bucket (50 microseconds).
+//
+// Unlike the profiler this module is always compiled in; recording a frame only costs a
+// timestamp and a handful of array updates.
+//
+
+#ifndef CEDAR_DEBUG_FRAME_STATS_H
+#define CEDAR_DEBUG_FRAME_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+
+namespace Cedar::FrameStats
+{
+    // Number of most recent frames the statistics are computed over.
+    constexpr std::size_t windowSize = 1024;
+
+    constexpr std::uint64_t defaultHitchThreshold = 33'333'333; // Nanoseconds (30 FPS)
+
+
+
+    struct Summary;
+
+
+
+    // All durations are in nanoseconds.
+    struct Summary
+    {
+        std::size_t   frameCount;      // Frames in the window
+        std::uint64_t totalFrameCount; // Frames recorded since startup
+        std::uint64_t average;
+        std::uint64_t p50;
+        std::uint64_t p95;
+        std::uint64_t p99;
+        std::uint64_t max;
+        std::size_t   hitchCount;      // Frames in the window longer than the hitch threshold
+    };
+
+
+
+    // Records the time elapsed since the previous call as a frame. Should be called once
+    // per iteration of the main loop. The first call only starts the clock.
+    void markFrame();
+
+    // Records a frame with the given duration.
+    void recordFrame(std::uint64_t frameTime);
+
+
+    Summary getSummary();
+
+    void logSummary();
+
+
+    std::uint64_t getHitchThreshold();
+
+    void setHitchThreshold(std::uint64_t threshold);
+
+
+    // Forgets every recorded frame.
+    void reset();
+}
+
+#endif // CEDAR_DEBUG_FRAME_STATS_H
\ No newline at end of file
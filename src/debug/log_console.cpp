@@ -0,0 +1,369 @@
+#include "log_console.h"
+
+#include "profiler.h"
+#include "../graphics/blend.h"
+#include "../graphics/rect.h"
+#include "../graphics/surface.h"
+#include "../graphics/text_renderer.h"
+#include "../input.h"
+#include "../io/log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr std::size_t layoutCacheCapacity = 256; // A few screens of lines
+    constexpr int         margin              = 4;   // In pixels
+
+    constexpr Cedar::Graphics::Pixel backgroundColor = Cedar::Graphics::makePixel(0x0D, 0x0D, 0x0D, 0xD0); // Premultiplied
+    constexpr Cedar::Graphics::Pixel statusColor     = Cedar::Graphics::makePixel(0x80, 0xC0, 0xFF);
+
+
+
+    struct VisibleLine;
+
+    struct ConsoleData;
+
+
+
+    // A shown record's first line, copied out of the history so it's drawn without holding
+    // the history's lock.
+    struct VisibleLine
+    {
+        Cedar::Log::Level level;
+        std::size_t       textOffset; // Into ConsoleData::visibleText
+        std::size_t       textLength;
+    };
+
+
+
+    // Constant initialized, so the module is usable during static initialization and
+    // doesn't need a nifty counter.
+    struct ConsoleData
+    {
+        bool              visible     = false;
+        Cedar::Log::Level levelFilter = Cedar::Log::Level::Trace;
+        std::string       search;
+        int               scrollOffset = 0; // Matching records skipped from the newest
+        int               pageLines    = 1; // Lines that fit when last drawn
+
+        // Matching records, recounted when records are added or the filters change
+        std::size_t   matchCount      = 0;
+        std::uint64_t countedSequence = std::numeric_limits<std::uint64_t>::max();
+
+        std::unique_ptr<Cedar::Graphics::TextRenderer> textRenderer;
+
+        // The lines shown by the last draw, newest first, kept for their memory
+        std::vector<VisibleLine> visibleLines;
+        std::string              visibleText;
+    };
+
+
+
+    ConsoleData g_console;
+
+
+
+    inline char toLowerAscii(char c);
+
+    bool matchesSearch(std::string_view text);
+
+    const char* getLevelName(Cedar::Log::Level level);
+
+    Cedar::Graphics::Pixel getLevelColor(Cedar::Log::Level level);
+
+    void invalidateCount();
+
+
+
+    inline char toLowerAscii(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+
+
+    bool matchesSearch(std::string_view text)
+    {
+        if (g_console.search.empty())
+            return true;
+
+        // The search is stored lowercase
+        auto match = std::search(text.begin(), text.end(), g_console.search.begin(), g_console.search.end(),
+                                 [](char textChar, char searchChar) { return toLowerAscii(textChar) == searchChar; });
+
+        return match != text.end();
+    }
+
+
+
+    const char* getLevelName(Cedar::Log::Level level)
+    {
+        switch (level) {
+            case Cedar::Log::Level::Trace:
+                return "TRACE";
+            case Cedar::Log::Level::Debug:
+                return "DEBUG";
+            case Cedar::Log::Level::Info:
+                return "INFO";
+            case Cedar::Log::Level::Warning:
+                return "WARN";
+            case Cedar::Log::Level::Error:
+                return "ERROR";
+            case Cedar::Log::Level::Critical:
+                return "CRIT";
+            default: // Level::Fatal
+                return "FATAL";
+        }
+    }
+
+
+
+    // Matches the terminal colors used by Log::message
+    Cedar::Graphics::Pixel getLevelColor(Cedar::Log::Level level)
+    {
+        using Cedar::Graphics::makePixel;
+
+        switch (level) {
+            case Cedar::Log::Level::Trace:
+                return makePixel(0xC0, 0xC0, 0xC0);
+            case Cedar::Log::Level::Debug:
+                return makePixel(0xFF, 0x60, 0xFF);
+            case Cedar::Log::Level::Info:
+                return makePixel(0x40, 0xC0, 0x40);
+            case Cedar::Log::Level::Warning:
+                return makePixel(0xFF, 0xFF, 0x40);
+            case Cedar::Log::Level::Error:
+                return makePixel(0xE0, 0x30, 0x30);
+            default: // Level::Critical and Level::Fatal
+                return makePixel(0xFF, 0x30, 0x30);
+        }
+    }
+
+
+
+    void invalidateCount()
+    {
+        g_console.countedSequence = std::numeric_limits<std::uint64_t>::max();
+    }
+}
+
+
+
+namespace Cedar::LogConsole
+{
+    bool isVisible()
+    {
+        return g_console.visible;
+    }
+
+
+
+    void setVisible(bool visible)
+    {
+        if (visible == g_console.visible)
+            return;
+
+        g_console.visible = visible;
+
+        if (visible)
+        {
+            g_console.textRenderer = std::make_unique<Graphics::TextRenderer>(Graphics::getDefaultFont(), 1, layoutCacheCapacity);
+            g_console.scrollOffset = 0;
+            invalidateCount();
+        }
+        else
+        {
+            g_console.textRenderer.reset();
+            g_console.visibleLines = {};
+            g_console.visibleText  = {};
+        }
+    }
+
+
+
+    void toggle()
+    {
+        setVisible(!g_console.visible);
+    }
+
+
+
+    Log::Level getLevelFilter()
+    {
+        return g_console.levelFilter;
+    }
+
+
+
+    void setLevelFilter(Log::Level level)
+    {
+        g_console.levelFilter  = level;
+        g_console.scrollOffset = 0;
+        invalidateCount();
+    }
+
+
+
+    std::string_view getSearch()
+    {
+        return g_console.search;
+    }
+
+
+
+    void setSearch(std::string_view search)
+    {
+        g_console.search.resize(search.size());
+        std::transform(search.begin(), search.end(), g_console.search.begin(), toLowerAscii);
+
+        g_console.scrollOffset = 0;
+        invalidateCount();
+    }
+
+
+
+    void scroll(int lines)
+    {
+        // Saturated, Home scrolls by the largest int
+        long long offset = static_cast<long long>(g_console.scrollOffset) + lines;
+
+        g_console.scrollOffset = static_cast<int>(std::clamp<long long>(offset, 0, std::numeric_limits<int>::max()));
+    }
+
+
+
+    bool handleKey(Key key)
+    {
+        if (key == toggleKey)
+        {
+            toggle();
+            return true;
+        }
+
+        if (!g_console.visible)
+            return false;
+
+        switch (key) {
+            case Key::Page_Up:
+                scroll(g_console.pageLines); break;
+            case Key::Page_Down:
+                scroll(-g_console.pageLines); break;
+            case Key::Home:
+                scroll(std::numeric_limits<int>::max()); break;
+            case Key::End:
+                g_console.scrollOffset = 0; break;
+            case Key::Tab: {
+                int next = (static_cast<int>(g_console.levelFilter) + 1) % (CEDAR_LOG_LEVEL_FATAL + 1);
+                setLevelFilter(static_cast<Log::Level>(next));
+                break;
+            }
+            case Key::Escape: {
+                if (!g_console.search.empty())
+                    setSearch("");
+                else
+                    setVisible(false);
+                break;
+            }
+            default:
+                return false;
+        }
+
+        return true;
+    }
+
+
+
+    void draw(const Graphics::Surface& target)
+    {
+        if (!g_console.visible || target.isEmpty())
+            return;
+
+        CEDAR_PROFILE_FUNCTION();
+
+        Graphics::TextRenderer& textRenderer = *g_console.textRenderer;
+        int                     lineHeight   = textRenderer.getLineHeight();
+
+        int            height = std::max(target.size.height / 2, std::min(target.size.height, lineHeight * 4));
+        Graphics::Rect area   = { { 0, 0 }, { target.size.width, height } };
+
+        for (int y = 0; y < area.size.height; y++)
+            Graphics::blendSolidRow(target.getRow(y), backgroundColor, area.size.width);
+
+        // Records from the bottom up, above the status line
+        Graphics::Rect recordArea = { { margin, margin },
+                                      { area.size.width - 2 * margin, area.size.height - 2 * margin - lineHeight } };
+        int            bottom     = recordArea.position.y + recordArea.size.height;
+
+        g_console.pageLines = std::max(recordArea.size.height / lineHeight, 1);
+
+        // Clamped to the last count, which may be a few records out of date
+        if (static_cast<std::size_t>(g_console.scrollOffset) >= g_console.matchCount)
+            g_console.scrollOffset = static_cast<int>(g_console.matchCount > 0 ? g_console.matchCount - 1 : 0);
+
+        // The count is only needed again when records were added or the filters changed,
+        // otherwise the visit stops once the page is full
+        std::uint64_t sequence     = Log::getNextSequence();
+        bool          countIsKnown = (sequence == g_console.countedSequence);
+
+        std::size_t firstShown = static_cast<std::size_t>(g_console.scrollOffset);
+        std::size_t endShown   = firstShown + g_console.pageLines;
+        std::size_t matchIndex = 0;
+
+        g_console.visibleLines.clear();
+        g_console.visibleText.clear();
+
+        // Loggers wait on the history while it's visited, so the shown lines are only
+        // copied here and drawn once the visit is over
+        Log::visitHistory([&](const Log::Record& record) {
+            if (record.level < g_console.levelFilter || !matchesSearch(record.text))
+                return true;
+
+            if (matchIndex >= firstShown && matchIndex < endShown)
+            {
+                std::string_view line = record.text.substr(0, record.text.find('\n'));
+
+                g_console.visibleLines.push_back({ record.level, g_console.visibleText.size(), line.size() });
+                g_console.visibleText.append(line);
+            }
+
+            matchIndex++;
+
+            return !countIsKnown || matchIndex < endShown;
+        });
+
+        for (std::size_t i = 0; i < g_console.visibleLines.size(); i++)
+        {
+            const VisibleLine& line = g_console.visibleLines[i];
+
+            int              y    = bottom - static_cast<int>(i + 1) * lineHeight;
+            std::string_view text = std::string_view(g_console.visibleText).substr(line.textOffset, line.textLength);
+
+            textRenderer.drawText(target, text, { recordArea.position.x, y }, getLevelColor(line.level), recordArea);
+        }
+
+        if (!countIsKnown)
+        {
+            g_console.matchCount      = matchIndex;
+            g_console.countedSequence = sequence;
+        }
+
+        std::size_t shownCount = (g_console.matchCount > firstShown)
+                                     ? std::min<std::size_t>(g_console.matchCount - firstShown, g_console.pageLines) : 0;
+
+        std::string status = std::format("Log  level >= {}  search \"{}\"  records {}-{} of {} from the newest",
+                                         getLevelName(g_console.levelFilter), g_console.search,
+                                         (shownCount > 0) ? firstShown + 1 : 0, firstShown + shownCount, g_console.matchCount);
+
+        textRenderer.drawText(target, status, { margin, bottom + margin }, statusColor, area);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+//
+// In-window log console.
+//
+// Draws the most recent log records (see the history in io/log.h) over the top half of a
+// surface, newest at the bottom. Records can be filtered by minimum level and by a
+// case-insensitive search string, both matched against the records in place in the log's
+// ring, so nothing is copied and the console keeps no records of its own. Only the
+// records that fit on screen are drawn, and only their first line.
+//
+// While hidden the console doesn't draw or hold any memory, its text renderer is created
+// when it's shown and released when it's hidden.
+//
+// Only to be used from the main thread.
+//
+
+#ifndef CEDAR_DEBUG_LOG_CONSOLE_H
+#define CEDAR_DEBUG_LOG_CONSOLE_H
+
+#include "../graphics/surface.h"
+#include "../input.h"
+#include "../io/log.h"
+
+#include <string_view>
+
+
+
+namespace Cedar::LogConsole
+{
+    constexpr Key toggleKey = Key::F1;
+
+
+
+    bool isVisible();
+
+    void setVisible(bool visible);
+
+    void toggle();
+
+
+    // Records below the level are hidden.
+    Log::Level getLevelFilter();
+
+    void setLevelFilter(Log::Level level);
+
+    std::string_view getSearch();
+
+    // Only records containing the text, ignoring ASCII case, are shown. An empty search
+    // shows every record.
+    void setSearch(std::string_view search);
+
+
+    // Scrolls by the number of lines, positive values towards older records. The scroll
+    // position is clamped when the console is drawn; at 0 the newest records are shown.
+    void scroll(int lines);
+
+    // Handles the console's keys: the toggle key, and while visible Page Up/Page Down to
+    // scroll by a page, Home/End to jump to the oldest/newest records, Tab to cycle the
+    // level filter and Escape to clear the search or else hide the console. Returns true
+    // if the key was used.
+    bool handleKey(Key key);
+
+
+    // Draws the console over the target if it's visible.
+    void draw(const Graphics::Surface& target);
+}
+
+#endif // CEDAR_DEBUG_LOG_CONSOLE_H
\ No newline at end of file
@@ -0,0 +1,532 @@
+#include "profiler.h"
+
+#include "../core.h"
+#include "../io/log.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+
+namespace
+{
+    struct ZoneEvent;
+
+    struct CapturedZone;
+
+    class ThreadBuffer;
+
+    struct ProfilerData;
+
+
+
+    struct ZoneEvent
+    {
+        const char*   name;
+        std::uint64_t begin;
+        std::uint64_t end;
+        std::uint32_t depth;
+    };
+
+
+
+    struct CapturedZone
+    {
+        ZoneEvent     event;
+        std::uint32_t threadIndex;
+    };
+
+
+
+    // Single producer (the owning thread), single consumer (the thread calling endFrame)
+    // ring of completed zones.
+    class ThreadBuffer
+    {
+    public:
+
+        static constexpr std::size_t capacity = 16384;
+
+        static_assert((capacity & (capacity - 1)) == 0, "Thread buffer capacity must be a power of two");
+
+
+        const std::uint32_t index;
+
+        // Guarded by ProfilerData::mutex
+        std::string name;
+
+        // Only touched by the consumer. Time spent in completed child zones, indexed by
+        // the depth of the child.
+        std::vector<std::uint64_t> childTime;
+
+
+        inline ThreadBuffer(std::uint32_t threadIndex) : index(threadIndex) {}
+
+
+        inline bool push(const ZoneEvent& event);
+
+        template <typename TFunction>
+        inline void drain(TFunction function);
+
+
+        inline std::size_t takeDroppedCount();
+
+    private:
+
+        std::array<ZoneEvent, capacity> m_events;
+
+        std::atomic<std::uint64_t> m_writeIndex   = 0;
+        std::atomic<std::uint64_t> m_readIndex    = 0;
+        std::atomic<std::size_t>   m_droppedCount = 0;
+    };
+
+
+
+    struct ProfilerData
+    {
+        std::mutex mutex; // Guards threadBuffers against concurrent registration
+
+        std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+
+        std::vector<Cedar::Profiler::ZoneStats>         frameStats;
+        std::unordered_map<std::string_view, std::size_t> frameStatIndices;
+
+        std::uint64_t frameBegin        = 0;
+        std::uint64_t frameTime         = 0;
+        std::size_t   droppedZoneCount  = 0;
+
+        bool                      capturing = false;
+        std::vector<CapturedZone> capturedZones;
+
+
+        inline ProfilerData() {}
+
+        inline ~ProfilerData() {}
+    };
+
+
+
+    thread_local ThreadBuffer* t_threadBuffer = nullptr;
+
+    thread_local std::uint32_t t_depth = 0;
+
+
+
+    ThreadBuffer& getThreadBuffer();
+
+    void aggregateZone(ThreadBuffer& threadBuffer, const ZoneEvent& event);
+
+    std::string escapeJsonString(std::string_view str);
+
+
+
+    inline bool ThreadBuffer::push(const ZoneEvent& event)
+    {
+        std::uint64_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+
+        if (writeIndex - m_readIndex.load(std::memory_order_acquire) >= capacity)
+        {
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_events[writeIndex & (capacity - 1)] = event;
+        m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+
+        return true;
+    }
+
+
+
+    template <typename TFunction>
+    inline void ThreadBuffer::drain(TFunction function)
+    {
+        std::uint64_t readIndex  = m_readIndex.load(std::memory_order_relaxed);
+        std::uint64_t writeIndex = m_writeIndex.load(std::memory_order_acquire);
+
+        for (; readIndex != writeIndex; readIndex++)
+            function(m_events[readIndex & (capacity - 1)]);
+
+        m_readIndex.store(readIndex, std::memory_order_release);
+    }
+
+
+
+    inline std::size_t ThreadBuffer::takeDroppedCount()
+    {
+        return m_droppedCount.exchange(0, std::memory_order_relaxed);
+    }
+}
+
+
+
+// Nifty counter internal details
+namespace
+{
+    static typename std::aligned_storage<sizeof(ProfilerData), alignof(ProfilerData)>::type g_profilerDataBuffer;
+
+    ProfilerData& g_profilerData = reinterpret_cast<ProfilerData&>(g_profilerDataBuffer);
+}
+
+
+
+namespace Cedar::Profiler
+{
+    std::size_t ProfilerInitializer::s_counter = 0;
+
+
+
+    ProfilerInitializer::ProfilerInitializer()
+    {
+        if (s_counter == 0)
+            new (&g_profilerData)ProfilerData();
+
+        s_counter++;
+    }
+
+
+
+    ProfilerInitializer::~ProfilerInitializer()
+    {
+        s_counter--;
+
+        if (s_counter == 0)
+            g_profilerData.~ProfilerData();
+    }
+}
+// Nifty counter internal details
+
+
+
+// OS-agnostic implementation
+namespace
+{
+    ThreadBuffer& getThreadBuffer()
+    {
+        if (t_threadBuffer == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(g_profilerData.mutex);
+
+            std::uint32_t index = static_cast<std::uint32_t>(g_profilerData.threadBuffers.size());
+            g_profilerData.threadBuffers.push_back(std::make_unique<ThreadBuffer>(index));
+
+            t_threadBuffer = g_profilerData.threadBuffers.back().get();
+        }
+
+        return *t_threadBuffer;
+    }
+
+
+
+    void aggregateZone(ThreadBuffer& threadBuffer, const ZoneEvent& event)
+    {
+        // Zones are pushed when they end, so a zone's children are always drained before
+        // the zone itself.
+        if (threadBuffer.childTime.size() < event.depth + 2)
+            threadBuffer.childTime.resize(event.depth + 2, 0);
+
+        std::uint64_t duration  = event.end - event.begin;
+        std::uint64_t childTime = std::exchange(threadBuffer.childTime[event.depth + 1], 0);
+
+        threadBuffer.childTime[event.depth] += duration;
+
+        auto [iterator, inserted] = g_profilerData.frameStatIndices.try_emplace(event.name, g_profilerData.frameStats.size());
+
+        if (inserted)
+            g_profilerData.frameStats.push_back({ event.name, 0, 0, 0 });
+
+        Cedar::Profiler::ZoneStats& stats = g_profilerData.frameStats[iterator->second];
+        stats.callCount++;
+        stats.inclusiveTime += duration;
+        stats.exclusiveTime += (childTime < duration) ? duration - childTime : 0;
+    }
+
+
+
+    std::string escapeJsonString(std::string_view str)
+    {
+        std::string result;
+        result.reserve(str.length());
+
+        for (char character : str)
+        {
+            switch (character) {
+                case '"':
+                    result += "\\\""; break;
+                case '\\':
+                    result += "\\\\"; break;
+                default:
+                {
+                    if (static_cast<unsigned char>(character) < 0x20)
+                        result += std::format("\\u{:04x}", static_cast<unsigned int>(character));
+                    else
+                        result += character;
+
+                    break;
+                }
+            }
+        }
+
+        return result;
+    }
+}
+
+
+
+namespace Cedar::Profiler
+{
+    void setThreadName(const char* name)
+    {
+        ThreadBuffer& threadBuffer = getThreadBuffer();
+
+        std::lock_guard<std::mutex> lock(g_profilerData.mutex);
+        threadBuffer.name = name;
+    }
+
+
+
+    std::uint64_t beginZone()
+    {
+        t_depth++;
+        return getTimestamp();
+    }
+
+
+
+    void endZone(const char* name, std::uint64_t begin)
+    {
+        std::uint64_t end = getTimestamp();
+        t_depth--;
+
+        (void)getThreadBuffer().push({ name, begin, end, t_depth });
+    }
+
+
+
+    void endFrame()
+    {
+        std::uint64_t frameEnd = getTimestamp();
+
+        if (g_profilerData.frameBegin != 0)
+            g_profilerData.frameTime = frameEnd - g_profilerData.frameBegin;
+
+        g_profilerData.frameStats.clear();
+        g_profilerData.frameStatIndices.clear();
+
+        // Fetched before locking since registering the calling thread takes the lock
+        std::uint32_t frameThreadIndex = getThreadBuffer().index;
+
+        std::lock_guard<std::mutex> lock(g_profilerData.mutex);
+
+        for (const std::unique_ptr<ThreadBuffer>& threadBuffer : g_profilerData.threadBuffers)
+        {
+            threadBuffer->drain([&](const ZoneEvent& event) {
+                aggregateZone(*threadBuffer, event);
+
+                if (g_profilerData.capturing)
+                    g_profilerData.capturedZones.push_back({ event, threadBuffer->index });
+            });
+
+            g_profilerData.droppedZoneCount += threadBuffer->takeDroppedCount();
+        }
+
+        if (g_profilerData.capturing && g_profilerData.frameBegin != 0)
+            g_profilerData.capturedZones.push_back({ { "Frame", g_profilerData.frameBegin, frameEnd, 0 }, frameThreadIndex });
+
+        std::sort(g_profilerData.frameStats.begin(), g_profilerData.frameStats.end(),
+                  [](const ZoneStats& a, const ZoneStats& b) { return a.inclusiveTime > b.inclusiveTime; });
+
+        g_profilerData.frameBegin = frameEnd;
+    }
+
+
+
+    const std::vector<ZoneStats>& getFrameStats()
+    {
+        return g_profilerData.frameStats;
+    }
+
+
+
+    std::uint64_t getFrameTime()
+    {
+        return g_profilerData.frameTime;
+    }
+
+
+
+    std::size_t getDroppedZoneCount()
+    {
+        return g_profilerData.droppedZoneCount;
+    }
+
+
+
+    void logFrameReport()
+    {
+        std::string report = std::format("Profiler frame report ({:.3f} ms):", g_profilerData.frameTime / 1'000'000.0);
+
+        for (const ZoneStats& stats : g_profilerData.frameStats)
+        {
+            report += std::format("\n    {:<32} {:>6} calls {:>10.3f} ms incl {:>10.3f} ms excl",
+                                  stats.name, stats.callCount,
+                                  stats.inclusiveTime / 1'000'000.0,
+                                  stats.exclusiveTime / 1'000'000.0);
+        }
+
+        if (g_profilerData.droppedZoneCount != 0)
+            report += std::format("\n    {} zone(s) dropped due to full thread buffers", g_profilerData.droppedZoneCount);
+
+        Cedar::Log::info(report);
+    }
+
+
+
+    bool isCapturing()
+    {
+        return g_profilerData.capturing;
+    }
+
+
+
+    void startCapture()
+    {
+        g_profilerData.capturedZones.clear();
+        g_profilerData.capturing = true;
+    }
+
+
+
+    void stopCapture(std::string_view path)
+    {
+        g_profilerData.capturing = false;
+
+        std::ofstream file{ std::string(path) };
+
+        if (!file)
+            throw std::runtime_error("Failed to open profiler capture file \"" + std::string(path) + '"');
+
+        std::uint64_t origin = g_profilerData.capturedZones.empty() ? 0 : g_profilerData.capturedZones.front().event.begin;
+
+        for (const CapturedZone& zone : g_profilerData.capturedZones)
+            origin = std::min(origin, zone.event.begin);
+
+        file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+        bool first = true;
+
+        {
+            std::lock_guard<std::mutex> lock(g_profilerData.mutex);
+
+            for (const std::unique_ptr<ThreadBuffer>& threadBuffer : g_profilerData.threadBuffers)
+            {
+                if (threadBuffer->name.empty())
+                    continue;
+
+                file << (first ? "" : ",")
+                     << std::format("\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+                                    threadBuffer->index, escapeJsonString(threadBuffer->name));
+                first = false;
+            }
+        }
+
+        for (const CapturedZone& zone : g_profilerData.capturedZones)
+        {
+            // Trace event timestamps are in microseconds
+            file << (first ? "" : ",")
+                 << std::format("\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                                escapeJsonString(zone.event.name), zone.threadIndex,
+                                (zone.event.begin - origin) / 1000.0,
+                                (zone.event.end - zone.event.begin) / 1000.0);
+            first = false;
+        }
+
+        file << "\n]}\n";
+
+        if (!file)
+            throw std::runtime_error("Failed to write profiler capture file \"" + std::string(path) + '"');
+
+        Cedar::Log::info(std::format("Wrote {} profiler zone(s) to \"{}\"", g_profilerData.capturedZones.size(), path));
+
+        g_profilerData.capturedZones.clear();
+        g_profilerData.capturedZones.shrink_to_fit();
+    }
+}
+// OS-agnostic implementation
+
+
+
+// OS-specific implementation
+#if defined(CEDAR_OS_WINDOWS) // vvv Windows vvv
+
+#include "../platform/windows.h"
+
+
+
+namespace
+{
+    LARGE_INTEGER getPerformanceFrequency();
+
+
+
+    LARGE_INTEGER getPerformanceFrequency()
+    {
+        LARGE_INTEGER frequency;
+        (void)QueryPerformanceFrequency(&frequency);
+
+        return frequency;
+    }
+}
+
+
+
+namespace Cedar::Profiler
+{
+    std::uint64_t getTimestamp()
+    {
+        static const LARGE_INTEGER frequency = getPerformanceFrequency();
+
+        LARGE_INTEGER counter;
+        (void)QueryPerformanceCounter(&counter);
+
+        // Split into whole seconds and remainder to avoid overflowing the multiplication
+        std::uint64_t seconds   = counter.QuadPart / frequency.QuadPart;
+        std::uint64_t remainder = counter.QuadPart % frequency.QuadPart;
+
+        return seconds * 1'000'000'000 + remainder * 1'000'000'000 / frequency.QuadPart;
+    }
+}
+
+#elif defined(CEDAR_OS_LINUX) // vvv Linux vvv // ^^^ Windows ^^^
+
+#include <time.h>
+
+
+
+namespace Cedar::Profiler
+{
+    std::uint64_t getTimestamp()
+    {
+        timespec time;
+        (void)clock_gettime(CLOCK_MONOTONIC, &time);
+
+        return static_cast<std::uint64_t>(time.tv_sec) * 1'000'000'000 + static_cast<std::uint64_t>(time.tv_nsec);
+    }
+}
+
+#endif // ^^^ Linux ^^^
+// OS-specific implementation
\ No newline at end of file
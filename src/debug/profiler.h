@@ -0,0 +1,151 @@
+//
+// Hierarchical CPU profiler.
+//
+// Zones are marked with CEDAR_PROFILE_SCOPE("name") (or CEDAR_PROFILE_FUNCTION()) and
+// record their begin and end timestamps into a buffer owned by the calling thread. The
+// buffers are single producer, single consumer rings, so recording a zone never takes a
+// lock. CEDAR_PROFILE_END_FRAME() drains every thread's buffer on the calling thread,
+// aggregates the zones into per-frame statistics and, while a capture is running, keeps
+// them around for export to the Chrome trace event format (which Perfetto also reads).
+//
+// Zone names must be string literals or otherwise outlive the profiler.
+//
+// Profiling is only compiled in when CEDAR_PROFILE is defined (see core.h). When it
+// isn't, the macros expand to nothing.
+//
+
+#ifndef CEDAR_DEBUG_PROFILER_H
+#define CEDAR_DEBUG_PROFILER_H
+
+#include "../core.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+
+namespace Cedar::Profiler
+{
+    // Nifty counter. For internal use only
+    class ProfilerInitializer
+    {
+    public:
+
+        ProfilerInitializer();
+
+        ~ProfilerInitializer();
+
+    private:
+
+        static std::size_t s_counter;
+    };
+
+
+
+    // Nifty counter. For internal use only
+    static ProfilerInitializer profilerInitializer;
+
+
+
+    struct ZoneStats;
+
+    class ScopedZone;
+
+
+
+    struct ZoneStats
+    {
+        std::string_view name;
+        std::size_t      callCount;
+        std::uint64_t    inclusiveTime; // Nanoseconds
+        std::uint64_t    exclusiveTime; // Nanoseconds
+    };
+
+
+
+    class ScopedZone
+    {
+    public:
+
+        inline ScopedZone(const char* name);
+
+        inline ~ScopedZone();
+
+
+        ScopedZone(const ScopedZone&) = delete;
+
+        ScopedZone& operator=(const ScopedZone&) = delete;
+
+    private:
+
+        const char*   m_name;
+        std::uint64_t m_begin;
+    };
+
+
+
+    // Monotonic timestamp in nanoseconds.
+    std::uint64_t getTimestamp();
+
+
+    // Names the calling thread in exported traces.
+    void setThreadName(const char* name);
+
+
+    // For internal use only, use ScopedZone or the CEDAR_PROFILE_* macros instead.
+    std::uint64_t beginZone();
+
+    // For internal use only, use ScopedZone or the CEDAR_PROFILE_* macros instead.
+    void endZone(const char* name, std::uint64_t begin);
+
+
+    // Drains every thread's zone buffer and aggregates the zones recorded since the
+    // previous call. Should be called once per iteration of the main loop.
+    void endFrame();
+
+    // Zones recorded during the last completed frame, sorted by inclusive time.
+    const std::vector<ZoneStats>& getFrameStats();
+
+    // Duration of the last completed frame in nanoseconds.
+    std::uint64_t getFrameTime();
+
+    // Number of zones dropped because a thread's buffer was full.
+    std::size_t getDroppedZoneCount();
+
+    void logFrameReport();
+
+
+    bool isCapturing();
+
+    void startCapture();
+
+    // Writes every zone recorded since startCapture to path as a Chrome trace event JSON
+    // file. Throws std::runtime_error if the file can't be written.
+    void stopCapture(std::string_view path);
+
+
+
+    inline ScopedZone::ScopedZone(const char* name) : m_name(name), m_begin(beginZone()) {}
+
+
+
+    inline ScopedZone::~ScopedZone() {
+        endZone(m_name, m_begin);
+    }
+}
+
+
+
+#if defined(CEDAR_PROFILE)
+    #define CEDAR_PROFILE_SCOPE(name)  Cedar::Profiler::ScopedZone CEDAR_CONCAT_MACRO(cedarProfileZone, __LINE__)(name)
+    #define CEDAR_PROFILE_FUNCTION()   CEDAR_PROFILE_SCOPE(__func__)
+    #define CEDAR_PROFILE_END_FRAME()  Cedar::Profiler::endFrame()
+#else
+    #define CEDAR_PROFILE_SCOPE(name)  ((void)0)
+    #define CEDAR_PROFILE_FUNCTION()   ((void)0)
+    #define CEDAR_PROFILE_END_FRAME()  ((void)0)
+#endif
+
+#endif // CEDAR_DEBUG_PROFILER_H
\ No newline at end of file
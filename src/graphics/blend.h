@@ -0,0 +1,205 @@
+//
+// Premultiplied alpha blending.
+//
+// Every function draws a premultiplied source over the destination:
+// source + destination * (255 - source alpha) / 255 per channel. Divisions by 255 are
+// rounded, identically in the scalar and the AVX2 versions (see CEDAR_SIMD_AVX2 in
+// core.h), so both produce the same image.
+//
+
+#ifndef CEDAR_GRAPHICS_BLEND_H
+#define CEDAR_GRAPHICS_BLEND_H
+
+#include "surface.h"
+#include "../core.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(CEDAR_SIMD_AVX2)
+    #include <immintrin.h>
+#endif
+
+
+
+namespace Cedar::Graphics
+{
+    constexpr std::uint32_t divideBy255(std::uint32_t value);
+
+    // Every channel of the pixel multiplied by coverage / 255.
+    constexpr Pixel scalePixel(Pixel pixel, std::uint8_t coverage);
+
+    constexpr Pixel blendPixel(Pixel source, Pixel destination);
+
+#if defined(CEDAR_SIMD_AVX2)
+    CEDAR_FORCE_INLINE __m256i multiplyBytes(__m256i pixels, __m256i factors);
+
+    inline __m256i scalePixels(__m256i pixels, __m256i coverage);
+
+    inline __m256i blendPixels(__m256i source, __m256i destination);
+#endif
+
+
+    inline void blendRow(Pixel* destination, const Pixel* source, int count);
+
+    inline void blendSolidRow(Pixel* destination, Pixel color, int count);
+
+    // The color scaled by the coverage of each pixel (0 to 255, e.g. a glyph mask).
+    inline void blendMaskRow(Pixel* destination, const std::uint8_t* coverage, Pixel color, int count);
+
+
+
+    // Exact for products of two 8-bit values
+    constexpr std::uint32_t divideBy255(std::uint32_t value)
+    {
+        value += 128;
+        return (value + (value >> 8)) >> 8;
+    }
+
+
+
+    constexpr Pixel scalePixel(Pixel pixel, std::uint8_t coverage)
+    {
+        Pixel result = 0;
+
+        for (int shift = 0; shift < 32; shift += 8)
+            result |= divideBy255(((pixel >> shift) & 0xFF) * coverage) << shift;
+
+        return result;
+    }
+
+
+
+    constexpr Pixel blendPixel(Pixel source, Pixel destination)
+    {
+        std::uint32_t inverseAlpha = 255 - (source >> 24);
+        Pixel         result       = 0;
+
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            std::uint32_t channel = ((source >> shift) & 0xFF) + divideBy255(((destination >> shift) & 0xFF) * inverseAlpha);
+            result |= std::min<std::uint32_t>(channel, 255) << shift;
+        }
+
+        return result;
+    }
+
+
+
+#if defined(CEDAR_SIMD_AVX2)
+
+    // Multiplies the bytes of the pixels by the bytes of the factors, dividing by 255
+    CEDAR_FORCE_INLINE __m256i multiplyBytes(__m256i pixels, __m256i factors)
+    {
+        const __m256i zero     = _mm256_setzero_si256();
+        const __m256i rounding = _mm256_set1_epi16(128);
+
+        // Widened to 16 bits, two pixels per half of each 128-bit lane
+        __m256i low  = _mm256_mullo_epi16(_mm256_unpacklo_epi8(pixels, zero), _mm256_unpacklo_epi8(factors, zero));
+        __m256i high = _mm256_mullo_epi16(_mm256_unpackhi_epi8(pixels, zero), _mm256_unpackhi_epi8(factors, zero));
+
+        low  = _mm256_add_epi16(low, rounding);
+        high = _mm256_add_epi16(high, rounding);
+        low  = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+        high = _mm256_srli_epi16(_mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+
+        return _mm256_packus_epi16(low, high);
+    }
+
+
+
+    // Coverage is one value from 0 to 255 per 32-bit lane
+    inline __m256i scalePixels(__m256i pixels, __m256i coverage)
+    {
+        const __m256i coverageShuffle = _mm256_setr_epi8(0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12,
+                                                         0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12);
+
+        return multiplyBytes(pixels, _mm256_shuffle_epi8(coverage, coverageShuffle));
+    }
+
+
+
+    inline __m256i blendPixels(__m256i source, __m256i destination)
+    {
+        const __m256i alphaShuffle = _mm256_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15,
+                                                      3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15);
+
+        // 255 - alpha in every byte of each pixel
+        __m256i inverseAlpha = _mm256_shuffle_epi8(_mm256_xor_si256(source, _mm256_set1_epi32(-1)), alphaShuffle);
+
+        return _mm256_adds_epu8(multiplyBytes(destination, inverseAlpha), source);
+    }
+
+#endif
+
+
+
+    inline void blendRow(Pixel* destination, const Pixel* source, int count)
+    {
+        int x = 0;
+
+#if defined(CEDAR_SIMD_AVX2)
+        for (; x + 8 <= count; x += 8)
+        {
+            __m256i sourcePixels      = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + x));
+            __m256i destinationPixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(destination + x));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + x), blendPixels(sourcePixels, destinationPixels));
+        }
+#endif
+
+        for (; x < count; x++)
+            destination[x] = blendPixel(source[x], destination[x]);
+    }
+
+
+
+    inline void blendSolidRow(Pixel* destination, Pixel color, int count)
+    {
+        int x = 0;
+
+#if defined(CEDAR_SIMD_AVX2)
+        const __m256i colors = _mm256_set1_epi32(static_cast<int>(color));
+
+        for (; x + 8 <= count; x += 8)
+        {
+            __m256i destinationPixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(destination + x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + x), blendPixels(colors, destinationPixels));
+        }
+#endif
+
+        for (; x < count; x++)
+            destination[x] = blendPixel(color, destination[x]);
+    }
+
+
+
+    inline void blendMaskRow(Pixel* destination, const std::uint8_t* coverage, Pixel color, int count)
+    {
+        int x = 0;
+
+#if defined(CEDAR_SIMD_AVX2)
+        const __m256i colors = _mm256_set1_epi32(static_cast<int>(color));
+
+        for (; x + 8 <= count; x += 8)
+        {
+            __m128i coverageBytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(coverage + x));
+
+            // Masks like glyphs are mostly empty
+            if (_mm_cvtsi128_si64(coverageBytes) == 0)
+                continue;
+
+            __m256i coverages         = _mm256_cvtepu8_epi32(coverageBytes);
+            __m256i destinationPixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(destination + x));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + x),
+                                blendPixels(scalePixels(colors, coverages), destinationPixels));
+        }
+#endif
+
+        for (; x < count; x++)
+            destination[x] = blendPixel(scalePixel(color, coverage[x]), destination[x]);
+    }
+}
+
+#endif // CEDAR_GRAPHICS_BLEND_H
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "dirty_region.h"
+
+#include "rect.h"
+#include "surface.h"
+#include "../math/size.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+
+
+namespace Cedar::Graphics
+{
+    void DirtyRegion::setBounds(Size2D<int> bounds)
+    {
+        m_bounds    = bounds;
+        m_rectCount = 0;
+    }
+
+
+
+    void DirtyRegion::add(Rect rect)
+    {
+        rect = intersect(rect, { { 0, 0 }, m_bounds });
+
+        if (Graphics::isEmpty(rect))
+            return;
+
+        // Every merge removes a rectangle and grows the new one, which can make it overlap
+        // rectangles that were checked earlier, so start over after each merge
+        std::size_t i = 0;
+
+        while (i < m_rectCount)
+        {
+            const Rect& existing = m_rects[i];
+
+            if (contains(existing, rect))
+                return;
+
+            Rect united = unite(existing, rect);
+
+            if (overlaps(existing, rect) || Graphics::getArea(united) <= Graphics::getArea(existing) + Graphics::getArea(rect))
+            {
+                rect = united;
+                removeRect(i);
+                i = 0;
+            }
+            else
+                i++;
+
+            // Out of room, merge with the rectangle whose bounding box grows the least
+            if (i == m_rectCount && m_rectCount == maxRectCount)
+            {
+                std::size_t  bestIndex  = 0;
+                std::int64_t bestGrowth = std::numeric_limits<std::int64_t>::max();
+
+                for (std::size_t j = 0; j < m_rectCount; j++)
+                {
+                    std::int64_t growth = Graphics::getArea(unite(m_rects[j], rect)) - Graphics::getArea(m_rects[j]);
+
+                    if (growth < bestGrowth)
+                    {
+                        bestIndex  = j;
+                        bestGrowth = growth;
+                    }
+                }
+
+                rect = unite(m_rects[bestIndex], rect);
+                removeRect(bestIndex);
+                i = 0;
+            }
+        }
+
+        m_rects[m_rectCount++] = rect;
+    }
+
+
+
+    void DirtyRegion::addAll()
+    {
+        m_rectCount = 0;
+
+        if (m_bounds.width > 0 && m_bounds.height > 0)
+            m_rects[m_rectCount++] = { { 0, 0 }, m_bounds };
+    }
+
+
+
+    bool DirtyRegion::isFull() const
+    {
+        return m_rectCount == 1 && m_rects[0] == Rect{ { 0, 0 }, m_bounds };
+    }
+
+
+
+    std::int64_t DirtyRegion::getArea() const
+    {
+        std::int64_t area = 0;
+
+        for (std::size_t i = 0; i < m_rectCount; i++)
+            area += Graphics::getArea(m_rects[i]);
+
+        return area;
+    }
+
+
+
+    void copyRegion(const Surface& source, const Surface& destination, const DirtyRegion& region)
+    {
+        if (source.isEmpty() || destination.isEmpty())
+            return;
+
+        Rect surfaceBounds = intersect({ { 0, 0 }, source.size }, { { 0, 0 }, destination.size });
+
+        for (Rect rect : region.getRects())
+        {
+            rect = intersect(rect, surfaceBounds);
+
+            if (isEmpty(rect))
+                continue;
+
+            std::size_t rowSize = static_cast<std::size_t>(rect.size.width) * sizeof(Pixel);
+
+            for (int y = rect.position.y; y < rect.position.y + rect.size.height; y++)
+                std::memcpy(destination.getRow(y) + rect.position.x, source.getRow(y) + rect.position.x, rowSize);
+        }
+    }
+}
\ No newline at end of file
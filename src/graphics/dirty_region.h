@@ -0,0 +1,126 @@
+//
+// Damaged area tracking for partial framebuffer presents.
+//
+// A dirty region collects the rectangles that changed during a frame and keeps them as a
+// small set of non-overlapping rectangles clipped to its bounds. Rectangles that overlap
+// are merged into their bounding box, as are rectangles whose bounding box wastes no area
+// (e.g. neighbouring strips of the same row). Once the set is full, a new rectangle is
+// merged with whichever existing one grows the least, so the region never allocates and
+// always stays cheap to present, at worst covering somewhat more than what changed.
+//
+
+#ifndef CEDAR_GRAPHICS_DIRTY_REGION_H
+#define CEDAR_GRAPHICS_DIRTY_REGION_H
+
+#include "rect.h"
+#include "surface.h"
+#include "../math/size.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+
+
+namespace Cedar::Graphics
+{
+    class DirtyRegion;
+
+
+
+    class DirtyRegion
+    {
+    public:
+
+        static constexpr std::size_t maxRectCount = 16;
+
+
+        inline DirtyRegion() {}
+
+        inline explicit DirtyRegion(Size2D<int> bounds) : m_bounds(bounds) {}
+
+
+        inline Size2D<int> getBounds() const;
+
+        // Clears the region.
+        void setBounds(Size2D<int> bounds);
+
+
+        void add(Rect rect);
+
+        // Marks everything inside the bounds as damaged.
+        void addAll();
+
+        inline void clear();
+
+
+        inline bool isEmpty() const;
+
+        // True if the region covers its whole bounds.
+        bool isFull() const;
+
+        inline std::span<const Rect> getRects() const;
+
+        // Number of pixels covered. Rectangles never overlap, so nothing is counted twice.
+        std::int64_t getArea() const;
+
+    private:
+
+        std::array<Rect, maxRectCount> m_rects;
+        std::size_t                    m_rectCount = 0;
+        Size2D<int>                    m_bounds    = { 0, 0 };
+
+
+        inline void removeRect(std::size_t index);
+    };
+
+
+
+    // Copies the pixels covered by the region from one surface to another. The rectangles
+    // are clipped to both surfaces.
+    void copyRegion(const Surface& source, const Surface& destination, const DirtyRegion& region);
+
+
+
+    // vvv DirtyRegion function definitions vvv
+
+    inline Size2D<int> DirtyRegion::getBounds() const
+    {
+        return m_bounds;
+    }
+
+
+
+    inline void DirtyRegion::clear()
+    {
+        m_rectCount = 0;
+    }
+
+
+
+    inline bool DirtyRegion::isEmpty() const
+    {
+        return m_rectCount == 0;
+    }
+
+
+
+    inline std::span<const Rect> DirtyRegion::getRects() const
+    {
+        return { m_rects.data(), m_rectCount };
+    }
+
+
+
+    inline void DirtyRegion::removeRect(std::size_t index)
+    {
+        // Order doesn't matter, swap with the last rectangle
+        m_rects[index] = m_rects[m_rectCount - 1];
+        m_rectCount--;
+    }
+
+    // ^^^ DirtyRegion function definitions ^^^
+}
+
+#endif // CEDAR_GRAPHICS_DIRTY_REGION_H
\ No newline at end of file
@@ -0,0 +1,42 @@
+//
+// Bitmap fonts.
+//
+// A bitmap font is a run of fixed-size glyphs for consecutive code points, stored one bit
+// per pixel. The engine has a built-in 8x8 font covering printable ASCII.
+//
+
+#ifndef CEDAR_GRAPHICS_FONT_H
+#define CEDAR_GRAPHICS_FONT_H
+
+#include "../math/size.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+
+
+namespace Cedar::Graphics
+{
+    struct BitmapFont;
+
+
+
+    struct BitmapFont
+    {
+        Size2D<int> glyphSize;         // At most 8 pixels wide
+        char32_t    firstCodePoint;
+        std::size_t glyphCount;
+        char32_t    fallbackCodePoint; // Drawn for code points without a glyph
+
+        // glyphSize.height bytes per glyph, one per row from the top. Bit 0 is the
+        // leftmost pixel.
+        std::span<const std::uint8_t> rows;
+    };
+
+
+
+    const BitmapFont& getDefaultFont();
+}
+
+#endif // CEDAR_GRAPHICS_FONT_H
\ No newline at end of file
@@ -0,0 +1,452 @@
+#include "particle_system.h"
+
+#include "rect.h"
+#include "sprite_batch.h"
+#include "surface.h"
+#include "../core.h"
+#include "../debug/profiler.h"
+#include "../jobs/job_system.h"
+#include "../math/vector.h"
+#include "../memory/memory_tracker.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+
+#if defined(CEDAR_SIMD_AVX2)
+    #include <immintrin.h>
+#elif defined(CEDAR_SIMD_SSE2)
+    #include <emmintrin.h>
+#endif
+
+
+
+namespace Cedar::Graphics
+{
+    namespace
+    {
+        // Floats per vector of the widest instruction set, which the arrays are aligned and
+        // padded to
+        constexpr std::size_t vectorWidth = 8;
+        constexpr std::size_t alignment   = vectorWidth * sizeof(float);
+
+        // Drawn positions are clamped to this so they convert to int
+        constexpr float maxDrawPosition = 1e9f;
+
+
+#if defined(CEDAR_SIMD_AVX2)
+        // The lanes to gather, in order, to move the lanes set in a mask to the front
+        struct alignas(32) PackPermutation
+        {
+            std::int32_t lanes[8];
+        };
+
+        constexpr std::array<PackPermutation, 256> makePackPermutations();
+
+
+
+        constexpr std::array<PackPermutation, 256> makePackPermutations()
+        {
+            std::array<PackPermutation, 256> permutations = {};
+
+            for (std::uint32_t mask = 0; mask < 256; mask++)
+            {
+                std::int32_t packed = 0;
+
+                for (std::int32_t lane = 0; lane < 8; lane++)
+                {
+                    if (mask & (1u << lane))
+                        permutations[mask].lanes[packed++] = lane;
+                }
+            }
+
+            return permutations;
+        }
+
+
+
+        constexpr std::array<PackPermutation, 256> packPermutations = makePackPermutations();
+#endif
+    }
+
+
+
+    ParticleSystem::ParticleSystem(std::size_t capacity)
+    {
+        if (capacity == 0)
+            throw std::invalid_argument("Particle capacity must be positive");
+
+        constexpr std::size_t particleSize = AttributeCount * sizeof(float) + sizeof(Pixel);
+
+        if (capacity > std::numeric_limits<std::size_t>::max() / particleSize - vectorWidth)
+            throw std::length_error("Particle capacity is too large");
+
+        m_capacity       = capacity;
+        m_paddedCapacity = (capacity + vectorWidth - 1) / vectorWidth * vectorWidth;
+
+        m_survivors.resize((capacity + chunkSize - 1) / chunkSize);
+
+        // Zeroed so the padding past the last particle holds finite numbers
+        m_memory = Memory::allocate(Memory::Tag::Render, m_paddedCapacity * particleSize, alignment);
+        std::memset(m_memory, 0, m_paddedCapacity * particleSize);
+
+        float* attributes = static_cast<float*>(m_memory);
+
+        for (std::size_t i = 0; i < AttributeCount; i++)
+            m_attributes[i] = attributes + i * m_paddedCapacity;
+
+        m_colors = reinterpret_cast<Pixel*>(attributes + AttributeCount * m_paddedCapacity);
+
+        std::fill_n(m_colorTable, colorTableSize, makePixel(0xFF, 0xFF, 0xFF));
+    }
+
+
+
+    ParticleSystem::~ParticleSystem()
+    {
+        Memory::deallocate(Memory::Tag::Render, m_memory, m_paddedCapacity * (AttributeCount * sizeof(float) + sizeof(Pixel)), alignment);
+    }
+
+
+
+    void ParticleSystem::setDrag(float drag)
+    {
+        if (!(drag >= 0.0f) || !std::isfinite(drag))
+            throw std::invalid_argument("Drag must be positive or zero and finite");
+
+        m_drag = drag;
+    }
+
+
+
+    void ParticleSystem::setSizes(float birthSize, float deathSize)
+    {
+        if (!(birthSize >= 0.0f) || !(deathSize >= 0.0f) || !std::isfinite(birthSize) || !std::isfinite(deathSize))
+            throw std::invalid_argument("Particle sizes must be positive or zero and finite");
+
+        m_birthSize = birthSize;
+        m_deathSize = deathSize;
+    }
+
+
+
+    void ParticleSystem::setColorCurve(std::span<const ColorKey> keys)
+    {
+        if (keys.empty())
+            throw std::invalid_argument("Color curve must have at least one key");
+
+        for (std::size_t i = 0; i < keys.size(); i++)
+        {
+            if (!(keys[i].time >= 0.0f && keys[i].time <= 1.0f) || (i > 0 && keys[i].time < keys[i - 1].time))
+                throw std::invalid_argument("Color key times must be between 0 and 1 in increasing order");
+        }
+
+        std::size_t next = 0; // First key at or after the entry's time
+
+        for (std::size_t entry = 0; entry < colorTableSize; entry++)
+        {
+            float time = static_cast<float>(entry) / (colorTableSize - 1);
+
+            while (next < keys.size() && keys[next].time < time)
+                next++;
+
+            Pixel color;
+
+            if (next == 0)
+            {
+                color = keys.front().color;
+            }
+            else if (next == keys.size())
+            {
+                color = keys.back().color;
+            }
+            else
+            {
+                const ColorKey& from     = keys[next - 1];
+                const ColorKey& to       = keys[next];
+                float           fraction = (time - from.time) / (to.time - from.time);
+
+                color = 0;
+
+                for (int shift = 0; shift < 32; shift += 8)
+                {
+                    float start = static_cast<float>((from.color >> shift) & 0xFF);
+                    float end   = static_cast<float>((to.color >> shift) & 0xFF);
+
+                    color |= static_cast<Pixel>(std::lround(start + (end - start) * fraction)) << shift;
+                }
+            }
+
+            m_colorTable[entry] = premultiply(color);
+        }
+    }
+
+
+
+    std::size_t ParticleSystem::emit(std::size_t count, const ParticleEmission& emission)
+    {
+        const ParticleEmission& e = emission;
+
+        if (!std::isfinite(e.position.x) || !std::isfinite(e.position.y) || !std::isfinite(e.radius) || !std::isfinite(e.direction) ||
+            !std::isfinite(e.spread) || !std::isfinite(e.minSpeed) || !std::isfinite(e.maxSpeed) || !std::isfinite(e.minLifetime) ||
+            !std::isfinite(e.maxLifetime))
+            throw std::invalid_argument("Emission values must be finite");
+
+        if (e.radius < 0.0f || e.minSpeed > e.maxSpeed || e.minLifetime > e.maxLifetime || !(e.minLifetime > 0.0f))
+            throw std::invalid_argument("Emission radius must be positive or zero, ranges must have their minimum at most their maximum and lifetimes must be positive");
+
+        std::size_t spawned = std::min(count, m_capacity - m_count);
+
+        for (std::size_t i = m_count; i < m_count + spawned; i++)
+        {
+            // Uniform over the disc, hence the square root
+            float angle    = 6.28318531f * random();
+            float distance = e.radius * std::sqrt(random());
+            float heading  = e.direction + e.spread * (2.0f * random() - 1.0f);
+            float speed    = e.minSpeed + (e.maxSpeed - e.minSpeed) * random();
+            float lifetime = e.minLifetime + (e.maxLifetime - e.minLifetime) * random();
+
+            m_attributes[PositionX][i]       = e.position.x + distance * std::cos(angle);
+            m_attributes[PositionY][i]       = e.position.y + distance * std::sin(angle);
+            m_attributes[VelocityX][i]       = speed * std::cos(heading);
+            m_attributes[VelocityY][i]       = speed * std::sin(heading);
+            m_attributes[Age][i]             = 0.0f;
+            m_attributes[InverseLifetime][i] = 1.0f / lifetime;
+            m_attributes[Size][i]            = m_birthSize;
+            m_colors[i]                      = m_colorTable[0];
+        }
+
+        m_count += spawned;
+
+        return spawned;
+    }
+
+
+
+    void ParticleSystem::update(float elapsed)
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        if (!(elapsed >= 0.0f) || !std::isfinite(elapsed))
+            throw std::invalid_argument("Elapsed time must be positive or zero and finite");
+
+        std::size_t chunkCount = (m_count + chunkSize - 1) / chunkSize;
+
+        Jobs::parallelFor(chunkCount, 1, [this, elapsed](std::size_t begin, std::size_t end) {
+            for (std::size_t chunk = begin; chunk < end; chunk++)
+                m_survivors[chunk] = updateChunk(chunk * chunkSize, std::min((chunk + 1) * chunkSize, m_count), elapsed);
+        });
+
+        // Moves each chunk's survivors down against the previous chunk's
+        std::size_t count = 0;
+
+        for (std::size_t chunk = 0; chunk < chunkCount; chunk++)
+        {
+            std::size_t start     = chunk * chunkSize;
+            std::size_t survivors = m_survivors[chunk];
+
+            if (count != start)
+            {
+                for (float* attribute : m_attributes)
+                    std::copy(attribute + start, attribute + start + survivors, attribute + count);
+
+                std::copy(m_colors + start, m_colors + start + survivors, m_colors + count);
+            }
+
+            count += survivors;
+        }
+
+        m_count = count;
+    }
+
+
+
+    void ParticleSystem::clear()
+    {
+        m_count = 0;
+    }
+
+
+
+    void ParticleSystem::draw(SpriteBatch& batch, int layer) const
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        const float* positionsX = m_attributes[PositionX];
+        const float* positionsY = m_attributes[PositionY];
+        const float* sizes      = m_attributes[Size];
+
+        for (std::size_t i = 0; i < m_count; i++)
+        {
+            float size = sizes[i];
+            float x    = std::clamp(positionsX[i] - 0.5f * size, -maxDrawPosition, maxDrawPosition);
+            float y    = std::clamp(positionsY[i] - 0.5f * size, -maxDrawPosition, maxDrawPosition);
+            int   side = static_cast<int>(std::lround(std::min(size, maxDrawPosition)));
+
+            batch.fillRect({ { static_cast<int>(std::lround(x)), static_cast<int>(std::lround(y)) }, { side, side } }, m_colors[i], layer);
+        }
+    }
+
+
+
+    std::size_t ParticleSystem::updateChunk(std::size_t begin, std::size_t end, float elapsed)
+    {
+        float* positionsX       = m_attributes[PositionX];
+        float* positionsY       = m_attributes[PositionY];
+        float* velocitiesX      = m_attributes[VelocityX];
+        float* velocitiesY      = m_attributes[VelocityY];
+        float* ages             = m_attributes[Age];
+        float* inverseLifetimes = m_attributes[InverseLifetime];
+        float* sizes            = m_attributes[Size];
+
+        // Drag scales the velocity rather than subtracting from it, so a large drag times a
+        // long step stops particles instead of reversing them
+        float damping    = std::max(1.0f - m_drag * elapsed, 0.0f);
+        float gravityX   = m_gravity.x * elapsed;
+        float gravityY   = m_gravity.y * elapsed;
+        float birthSize  = m_birthSize;
+        float sizeRange  = m_deathSize - m_birthSize;
+        float tableScale = static_cast<float>(colorTableSize - 1);
+
+        // Whole vectors: the chunk starts on a vector boundary, and the arrays are padded so
+        // the last vector can run past the end. Survivors are packed at the start of the
+        // chunk; particles are only ever moved down, onto slots already read.
+        std::size_t survivor = begin;
+
+#if defined(CEDAR_SIMD_AVX2)
+        const __m256 dampings     = _mm256_set1_ps(damping);
+        const __m256 gravitiesX   = _mm256_set1_ps(gravityX);
+        const __m256 gravitiesY   = _mm256_set1_ps(gravityY);
+        const __m256 elapsedTimes = _mm256_set1_ps(elapsed);
+        const __m256 birthSizes   = _mm256_set1_ps(birthSize);
+        const __m256 sizeRanges   = _mm256_set1_ps(sizeRange);
+        const __m256 tableScales  = _mm256_set1_ps(tableScale);
+        const __m256 ones         = _mm256_set1_ps(1.0f);
+
+        // Updates and packs in the same pass, so each particle is loaded and stored once
+        for (std::size_t i = begin; i < end; i += 8)
+        {
+            __m256 velocityX = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(velocitiesX + i), dampings), gravitiesX);
+            __m256 velocityY = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(velocitiesY + i), dampings), gravitiesY);
+            __m256 positionX = _mm256_add_ps(_mm256_load_ps(positionsX + i), _mm256_mul_ps(velocityX, elapsedTimes));
+            __m256 positionY = _mm256_add_ps(_mm256_load_ps(positionsY + i), _mm256_mul_ps(velocityY, elapsedTimes));
+            __m256 age       = _mm256_add_ps(_mm256_load_ps(ages + i), elapsedTimes);
+            __m256 inverse   = _mm256_load_ps(inverseLifetimes + i);
+            __m256 life      = _mm256_min_ps(_mm256_mul_ps(age, inverse), ones);
+            __m256 size      = _mm256_add_ps(birthSizes, _mm256_mul_ps(sizeRanges, life));
+
+            __m256i entries = _mm256_cvttps_epi32(_mm256_mul_ps(life, tableScales));
+            __m256i colors  = _mm256_i32gather_epi32(reinterpret_cast<const int*>(m_colorTable), entries, 4);
+
+            int mask = _mm256_movemask_ps(_mm256_cmp_ps(life, ones, _CMP_LT_OQ));
+
+            // The padding past the end isn't particles
+            if (end - i < 8)
+                mask &= (1 << (end - i)) - 1;
+
+            const __m256i permutation = _mm256_load_si256(reinterpret_cast<const __m256i*>(packPermutations[mask].lanes));
+
+            // Whole vectors are stored, of which the lanes past the survivors are junk that
+            // later survivors overwrite or nothing reads
+            _mm256_storeu_ps(positionsX + survivor, _mm256_permutevar8x32_ps(positionX, permutation));
+            _mm256_storeu_ps(positionsY + survivor, _mm256_permutevar8x32_ps(positionY, permutation));
+            _mm256_storeu_ps(velocitiesX + survivor, _mm256_permutevar8x32_ps(velocityX, permutation));
+            _mm256_storeu_ps(velocitiesY + survivor, _mm256_permutevar8x32_ps(velocityY, permutation));
+            _mm256_storeu_ps(ages + survivor, _mm256_permutevar8x32_ps(age, permutation));
+            _mm256_storeu_ps(inverseLifetimes + survivor, _mm256_permutevar8x32_ps(inverse, permutation));
+            _mm256_storeu_ps(sizes + survivor, _mm256_permutevar8x32_ps(size, permutation));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_colors + survivor), _mm256_permutevar8x32_epi32(colors, permutation));
+
+            survivor += static_cast<std::size_t>(std::popcount(static_cast<unsigned int>(mask)));
+        }
+#else
+        std::size_t i = begin;
+
+    #if defined(CEDAR_SIMD_SSE2)
+        {
+            const __m128 dampings     = _mm_set1_ps(damping);
+            const __m128 gravitiesX   = _mm_set1_ps(gravityX);
+            const __m128 gravitiesY   = _mm_set1_ps(gravityY);
+            const __m128 elapsedTimes = _mm_set1_ps(elapsed);
+            const __m128 birthSizes   = _mm_set1_ps(birthSize);
+            const __m128 sizeRanges   = _mm_set1_ps(sizeRange);
+            const __m128 tableScales  = _mm_set1_ps(tableScale);
+            const __m128 ones         = _mm_set1_ps(1.0f);
+
+            alignas(16) std::int32_t entries[4];
+
+            for (; i < end; i += 4)
+            {
+                __m128 velocityX = _mm_add_ps(_mm_mul_ps(_mm_load_ps(velocitiesX + i), dampings), gravitiesX);
+                __m128 velocityY = _mm_add_ps(_mm_mul_ps(_mm_load_ps(velocitiesY + i), dampings), gravitiesY);
+                __m128 age       = _mm_add_ps(_mm_load_ps(ages + i), elapsedTimes);
+                __m128 life      = _mm_min_ps(_mm_mul_ps(age, _mm_load_ps(inverseLifetimes + i)), ones);
+
+                _mm_store_ps(velocitiesX + i, velocityX);
+                _mm_store_ps(velocitiesY + i, velocityY);
+                _mm_store_ps(positionsX + i, _mm_add_ps(_mm_load_ps(positionsX + i), _mm_mul_ps(velocityX, elapsedTimes)));
+                _mm_store_ps(positionsY + i, _mm_add_ps(_mm_load_ps(positionsY + i), _mm_mul_ps(velocityY, elapsedTimes)));
+                _mm_store_ps(ages + i, age);
+                _mm_store_ps(sizes + i, _mm_add_ps(birthSizes, _mm_mul_ps(sizeRanges, life)));
+
+                // SSE2 has no gather
+                _mm_store_si128(reinterpret_cast<__m128i*>(entries), _mm_cvttps_epi32(_mm_mul_ps(life, tableScales)));
+
+                m_colors[i]     = m_colorTable[entries[0]];
+                m_colors[i + 1] = m_colorTable[entries[1]];
+                m_colors[i + 2] = m_colorTable[entries[2]];
+                m_colors[i + 3] = m_colorTable[entries[3]];
+            }
+        }
+    #else
+        for (; i < end; i++)
+        {
+            velocitiesX[i] = velocitiesX[i] * damping + gravityX;
+            velocitiesY[i] = velocitiesY[i] * damping + gravityY;
+            positionsX[i] += velocitiesX[i] * elapsed;
+            positionsY[i] += velocitiesY[i] * elapsed;
+            ages[i]       += elapsed;
+
+            float life = std::min(ages[i] * inverseLifetimes[i], 1.0f);
+
+            sizes[i]    = birthSize + sizeRange * life;
+            m_colors[i] = m_colorTable[static_cast<std::size_t>(life * tableScale)];
+        }
+    #endif
+
+        // Without a permute to pack with, every particle is written and the position only
+        // advances past living ones
+        for (i = begin; i < end; i++)
+        {
+            bool alive = ages[i] * inverseLifetimes[i] < 1.0f;
+
+            for (float* attribute : m_attributes)
+                attribute[survivor] = attribute[i];
+
+            m_colors[survivor] = m_colors[i];
+            survivor += alive;
+        }
+#endif
+
+        return survivor - begin;
+    }
+
+
+
+    float ParticleSystem::random()
+    {
+        // xorshift64*, the top 24 bits of which fill a float's mantissa
+        m_random ^= m_random >> 12;
+        m_random ^= m_random << 25;
+        m_random ^= m_random >> 27;
+
+        return static_cast<float>((m_random * 0x2545'F491'4F6C'DD1Dull) >> 40) * (1.0f / 16777216.0f);
+    }
+}
\ No newline at end of file
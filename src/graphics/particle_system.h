@@ -0,0 +1,269 @@
+//
+// 2D particle system.
+//
+// Particles live in one array per attribute (positions, velocities, age and so on), each
+// aligned and padded to a whole number of SIMD vectors, so update runs its kernels eight
+// particles at a time with AVX2 or four with SSE2 (see core.h) and never needs a scalar
+// tail. An update applies gravity and drag, moves the particles, ages them, and looks
+// their size and color up on curves over their life; then the dead ones are squeezed out
+// without a branch per particle, by left-packing each vector of survivors with a
+// permutation picked by its alive mask (or, without AVX2, by writing every particle and
+// only advancing past the living ones).
+//
+// Particles are updated in chunks of chunkSize spread over the job system. Each chunk
+// packs its survivors at its own start, and the chunks are then moved together.
+//
+// Positions and sizes are in pixels, for drawing with a SpriteBatch.
+//
+
+#ifndef CEDAR_GRAPHICS_PARTICLE_SYSTEM_H
+#define CEDAR_GRAPHICS_PARTICLE_SYSTEM_H
+
+#include "sprite_batch.h"
+#include "surface.h"
+#include "../math/vector.h"
+#include "../memory/memory_tracker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+
+namespace Cedar::Graphics
+{
+    struct ColorKey;
+
+    struct ParticleEmission;
+
+    class ParticleSystem;
+
+
+
+    // A particle's color at a point of its life, from 0 at birth to 1 at death. Straight
+    // alpha.
+    struct ColorKey
+    {
+        float time;
+        Pixel color;
+    };
+
+
+
+    struct ParticleEmission
+    {
+        Vector2D<float> position    = { 0.0f, 0.0f };
+        float           radius      = 0.0f;        // Particles start anywhere within it
+        float           direction   = 0.0f;        // Radians
+        float           spread      = 3.14159265f; // Particles head up to this far either side of the direction
+        float           minSpeed    = 0.0f;        // Pixels per second
+        float           maxSpeed    = 100.0f;
+        float           minLifetime = 1.0f;        // Seconds
+        float           maxLifetime = 1.0f;
+    };
+
+
+
+    class ParticleSystem
+    {
+    public:
+
+        // Particles per job.
+        static constexpr std::size_t chunkSize = 4096;
+
+        // Entries the color curve is sampled into.
+        static constexpr std::size_t colorTableSize = 256;
+
+
+        // Throws std::invalid_argument if the capacity is 0.
+        explicit ParticleSystem(std::size_t capacity);
+
+        ~ParticleSystem();
+
+
+        ParticleSystem(const ParticleSystem&) = delete;
+
+        ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+
+        inline std::size_t getCapacity() const;
+
+        inline std::size_t getCount() const;
+
+
+        inline const Vector2D<float>& getGravity() const;
+
+        inline void setGravity(const Vector2D<float>& gravity);
+
+        inline float getDrag() const;
+
+        // Fraction of their velocity particles lose per second. Throws
+        // std::invalid_argument if it's negative or not finite.
+        void setDrag(float drag);
+
+        // Sizes are interpolated linearly over the particles' life. Throws
+        // std::invalid_argument if either is negative or not finite.
+        void setSizes(float birthSize, float deathSize);
+
+        // Colors are interpolated linearly between the keys, and held before the first and
+        // after the last. Throws std::invalid_argument if there are no keys, or their times
+        // aren't between 0 and 1 in increasing order.
+        void setColorCurve(std::span<const ColorKey> keys);
+
+
+        // Spawns as many of the particles as fit. Returns how many were spawned. Throws
+        // std::invalid_argument if a value isn't finite, the radius or a speed or lifetime
+        // range is negative, or a lifetime isn't positive.
+        std::size_t emit(std::size_t count, const ParticleEmission& emission);
+
+        // Advances the particles by the time and removes those that died. Throws
+        // std::invalid_argument if the time is negative or not finite.
+        void update(float elapsed);
+
+        void clear();
+
+
+        // Particle attributes, getCount() long. Sizes and colors are as of the last update
+        // or emission; colors are premultiplied.
+        inline std::span<const float> getPositionsX() const;
+
+        inline std::span<const float> getPositionsY() const;
+
+        inline std::span<const float> getVelocitiesX() const;
+
+        inline std::span<const float> getVelocitiesY() const;
+
+        inline std::span<const float> getSizes() const;
+
+        inline std::span<const Pixel> getColors() const;
+
+
+        // Draws every particle as a square of its size centered on its position.
+        void draw(SpriteBatch& batch, int layer = 0) const;
+
+    private:
+
+        enum Attribute
+        {
+            PositionX,
+            PositionY,
+            VelocityX,
+            VelocityY,
+            Age,
+            InverseLifetime,
+            Size,
+
+            AttributeCount
+        };
+
+
+        std::size_t m_capacity;
+        std::size_t m_paddedCapacity;     // A whole number of vectors
+        std::size_t m_count = 0;
+        void*       m_memory;
+        float*      m_attributes[AttributeCount];
+        Pixel*      m_colors;
+
+        Vector2D<float> m_gravity   = { 0.0f, 0.0f };
+        float           m_drag      = 0.0f;
+        float           m_birthSize = 4.0f;
+        float           m_deathSize = 4.0f;
+        Pixel           m_colorTable[colorTableSize];
+
+        std::uint64_t m_random = 0x9E37'79B9'7F4A'7C15;
+
+        std::vector<std::size_t, Memory::TrackedAllocator<std::size_t, Memory::Tag::Render>> m_survivors; // Per chunk
+
+
+        // Updates the particles of the chunk and packs the survivors at its start. Returns
+        // how many survived.
+        std::size_t updateChunk(std::size_t begin, std::size_t end, float elapsed);
+
+        // Returns a random number in [0, 1).
+        float random();
+    };
+
+
+
+    // vvv ParticleSystem function definitions vvv
+
+    inline std::size_t ParticleSystem::getCapacity() const
+    {
+        return m_capacity;
+    }
+
+
+
+    inline std::size_t ParticleSystem::getCount() const
+    {
+        return m_count;
+    }
+
+
+
+    inline const Vector2D<float>& ParticleSystem::getGravity() const
+    {
+        return m_gravity;
+    }
+
+
+
+    inline void ParticleSystem::setGravity(const Vector2D<float>& gravity)
+    {
+        m_gravity = gravity;
+    }
+
+
+
+    inline float ParticleSystem::getDrag() const
+    {
+        return m_drag;
+    }
+
+
+
+    inline std::span<const float> ParticleSystem::getPositionsX() const
+    {
+        return { m_attributes[PositionX], m_count };
+    }
+
+
+
+    inline std::span<const float> ParticleSystem::getPositionsY() const
+    {
+        return { m_attributes[PositionY], m_count };
+    }
+
+
+
+    inline std::span<const float> ParticleSystem::getVelocitiesX() const
+    {
+        return { m_attributes[VelocityX], m_count };
+    }
+
+
+
+    inline std::span<const float> ParticleSystem::getVelocitiesY() const
+    {
+        return { m_attributes[VelocityY], m_count };
+    }
+
+
+
+    inline std::span<const float> ParticleSystem::getSizes() const
+    {
+        return { m_attributes[Size], m_count };
+    }
+
+
+
+    inline std::span<const Pixel> ParticleSystem::getColors() const
+    {
+        return { m_colors, m_count };
+    }
+
+    // ^^^ ParticleSystem function definitions ^^^
+}
+
+#endif // CEDAR_GRAPHICS_PARTICLE_SYSTEM_H
\ No newline at end of file
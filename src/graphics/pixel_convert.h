@@ -0,0 +1,244 @@
+//
+// Pixel format conversion.
+//
+// Rows of 8-bit RGB, BGR, RGBA and BGRA texels are converted into Pixels, the
+// framebuffer's native layout (see surface.h), and Pixels are premultiplied, converted
+// from sRGB to linear and downsampled for mips in place. The AVX2 versions (see
+// CEDAR_SIMD_AVX2 in core.h) convert 8 pixels at a time and produce exactly the same
+// values as the scalar ones.
+//
+
+#ifndef CEDAR_GRAPHICS_PIXEL_CONVERT_H
+#define CEDAR_GRAPHICS_PIXEL_CONVERT_H
+
+#include "blend.h"
+#include "surface.h"
+#include "../core.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(CEDAR_SIMD_AVX2) || defined(CEDAR_SIMD_SSE2)
+    #include <immintrin.h>
+#endif
+
+
+
+namespace Cedar::Graphics
+{
+    // Bytes R, G, B per texel, made opaque.
+    inline void convertRgbRow(Pixel* destination, const std::uint8_t* source, int count);
+
+    // Bytes B, G, R per texel, made opaque.
+    inline void convertBgrRow(Pixel* destination, const std::uint8_t* source, int count);
+
+    // Bytes R, G, B, A per texel.
+    inline void convertRgbaRow(Pixel* destination, const std::uint8_t* source, int count);
+
+    // Bytes B, G, R, A per texel, which is already the layout of a Pixel.
+    inline void convertBgraRow(Pixel* destination, const std::uint8_t* source, int count);
+
+
+    inline void premultiplyRow(Pixel* pixels, int count);
+
+    // Converts the color channels from sRGB to linear, alpha is left as is.
+    inline void linearizeRow(Pixel* pixels, int count);
+
+    // Averages each 2x2 block of the two source rows (2 * count pixels each) into one
+    // destination pixel.
+    inline void downsampleRow(Pixel* destination, const Pixel* sourceRow0, const Pixel* sourceRow1, int count);
+
+
+    // 8-bit sRGB to 8-bit linear, rounded.
+    inline const std::array<std::uint8_t, 256>& getSrgbToLinearTable();
+
+
+
+    inline void convertRgbRow(Pixel* destination, const std::uint8_t* source, int count)
+    {
+        int x = 0;
+
+#if defined(CEDAR_SIMD_AVX2)
+        const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+                                                 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+        const __m256i opaque  = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+        // Each half loads 16 bytes for 4 texels, so the last 2 texels are left to the
+        // scalar loop rather than reading past the end of the row
+        for (; x + 10 <= count; x += 8)
+        {
+            const std::uint8_t* texels = source + x * 3;
+
+            __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(texels))),
+                                                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + 12)), 1);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + x), _mm256_or_si256(_mm256_shuffle_epi8(bytes, shuffle), opaque));
+        }
+#endif
+
+        for (; x < count; x++)
+            destination[x] = makePixel(source[x * 3], source[x * 3 + 1], source[x * 3 + 2]);
+    }
+
+
+
+    inline void convertBgrRow(Pixel* destination, const std::uint8_t* source, int count)
+    {
+        int x = 0;
+
+#if defined(CEDAR_SIMD_AVX2)
+        const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                                 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m256i opaque  = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+        for (; x + 10 <= count; x += 8)
+        {
+            const std::uint8_t* texels = source + x * 3;
+
+            __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(texels))),
+                                                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + 12)), 1);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + x), _mm256_or_si256(_mm256_shuffle_epi8(bytes, shuffle), opaque));
+        }
+#endif
+
+        for (; x < count; x++)
+            destination[x] = makePixel(source[x * 3 + 2], source[x * 3 + 1], source[x * 3]);
+    }
+
+
+
+    inline void convertRgbaRow(Pixel* destination, const std::uint8_t* source, int count)
+    {
+        int x = 0;
+
+#if defined(CEDAR_SIMD_AVX2)
+        const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                                 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+        for (; x + 8 <= count; x += 8)
+        {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + x * 4));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + x), _mm256_shuffle_epi8(bytes, shuffle));
+        }
+#endif
+
+        for (; x < count; x++)
+            destination[x] = makePixel(source[x * 4], source[x * 4 + 1], source[x * 4 + 2], source[x * 4 + 3]);
+    }
+
+
+
+    inline void convertBgraRow(Pixel* destination, const std::uint8_t* source, int count)
+    {
+        std::memcpy(destination, source, static_cast<std::size_t>(count) * sizeof(Pixel));
+    }
+
+
+
+    inline void premultiplyRow(Pixel* pixels, int count)
+    {
+        int x = 0;
+
+#if defined(CEDAR_SIMD_AVX2)
+        const __m256i alphaShuffle = _mm256_setr_epi8(3, 3, 3, -1, 7, 7, 7, -1, 11, 11, 11, -1, 15, 15, 15, -1,
+                                                      3, 3, 3, -1, 7, 7, 7, -1, 11, 11, 11, -1, 15, 15, 15, -1);
+        const __m256i alphaMask    = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+        for (; x + 8 <= count; x += 8)
+        {
+            __m256i source = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + x));
+
+            // Alpha multiplies the color channels and is kept as is
+            __m256i colors = multiplyBytes(source, _mm256_shuffle_epi8(source, alphaShuffle));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + x), _mm256_or_si256(colors, _mm256_and_si256(source, alphaMask)));
+        }
+#endif
+
+        for (; x < count; x++)
+            pixels[x] = premultiply(pixels[x]);
+    }
+
+
+
+    // A table lookup per channel, gathers aren't faster than that
+    inline void linearizeRow(Pixel* pixels, int count)
+    {
+        const std::array<std::uint8_t, 256>& table = getSrgbToLinearTable();
+
+        for (int x = 0; x < count; x++)
+        {
+            Pixel pixel = pixels[x];
+            pixels[x]   = makePixel(table[getRed(pixel)], table[getGreen(pixel)], table[getBlue(pixel)], getAlpha(pixel));
+        }
+    }
+
+
+
+    inline void downsampleRow(Pixel* destination, const Pixel* sourceRow0, const Pixel* sourceRow1, int count)
+    {
+        int x = 0;
+
+#if defined(CEDAR_SIMD_SSE2)
+        const __m128i zero     = _mm_setzero_si128();
+        const __m128i rounding = _mm_set1_epi16(2);
+
+        // 4 source pixels of each row into 2 destination pixels
+        for (; x + 2 <= count; x += 2)
+        {
+            __m128i row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sourceRow0 + x * 2));
+            __m128i row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sourceRow1 + x * 2));
+
+            // Channels widened to 16 bits, the left pair of each block in the low half
+            __m128i left  = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+            __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+
+            __m128i sums = _mm_add_epi16(_mm_unpacklo_epi64(left, right), _mm_unpackhi_epi64(left, right));
+            __m128i mean = _mm_srli_epi16(_mm_add_epi16(sums, rounding), 2);
+
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(destination + x), _mm_packus_epi16(mean, zero));
+        }
+#endif
+
+        for (; x < count; x++)
+        {
+            Pixel result = 0;
+
+            for (int shift = 0; shift < 32; shift += 8)
+            {
+                std::uint32_t sum = ((sourceRow0[x * 2] >> shift) & 0xFF) + ((sourceRow0[x * 2 + 1] >> shift) & 0xFF) +
+                                    ((sourceRow1[x * 2] >> shift) & 0xFF) + ((sourceRow1[x * 2 + 1] >> shift) & 0xFF);
+
+                result |= ((sum + 2) >> 2) << shift;
+            }
+
+            destination[x] = result;
+        }
+    }
+
+
+
+    inline const std::array<std::uint8_t, 256>& getSrgbToLinearTable()
+    {
+        static const std::array<std::uint8_t, 256> table = []() {
+            std::array<std::uint8_t, 256> values;
+
+            for (int i = 0; i < 256; i++)
+            {
+                double srgb   = i / 255.0;
+                double linear = (srgb <= 0.04045) ? srgb / 12.92 : std::pow((srgb + 0.055) / 1.055, 2.4);
+
+                values[i] = static_cast<std::uint8_t>(std::lround(linear * 255.0));
+            }
+
+            return values;
+        }();
+
+        return table;
+    }
+}
+
+#endif // CEDAR_GRAPHICS_PIXEL_CONVERT_H
\ No newline at end of file
@@ -0,0 +1,842 @@
+#include "rasterizer.h"
+
+#include "surface.h"
+#include "../core.h"
+#include "../debug/profiler.h"
+#include "../io/log.h"
+#include "../jobs/job_system.h"
+#include "../math/size.h"
+#include "../math/vector.h"
+#include "../memory/memory_tracker.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+#if defined(CEDAR_SIMD_AVX2)
+    #include <immintrin.h>
+#endif
+
+
+
+namespace
+{
+    constexpr int         subpixelBits       = 4;
+    constexpr int         subpixelScale      = 1 << subpixelBits;
+    constexpr float       guardBand          = 8192.0f; // Pixels from the center of the target
+    constexpr std::size_t chunkTriangleCount = 2048;
+    constexpr float       farDepth           = 1.0f;    // Depth buffer clear value
+
+    // Edge function values are clamped to this at the start of a row before being stepped
+    // across it. Stepping across a whole tile changes them by less than half of it, so
+    // clamping never changes which side of an edge a pixel is on.
+    constexpr std::int64_t edgeClamp = std::int64_t(1) << 30;
+
+
+
+    struct ClipVertex;
+
+    struct AttributePlane;
+
+    struct TriangleSetup;
+
+    struct Viewport;
+
+
+
+    struct ClipVertex
+    {
+        Cedar::Vector4D<float> position;
+        Cedar::Vector2D<float> texCoord;
+        Cedar::Vector3D<float> color; // 0 to 255 per channel
+    };
+
+
+
+    // Value of an attribute across the screen, for the center of the pixel at (x, y):
+    // stepX * x + stepY * y + offset.
+    struct AttributePlane
+    {
+        float stepX;
+        float stepY;
+        float offset;
+    };
+
+
+
+    struct TriangleSetup
+    {
+        // Edge functions of the edges 0-1, 1-2 and 2-0 in 28.4 fixed point, for the
+        // center of the pixel at (x, y): stepX * x + stepY * y + offset. A pixel is
+        // covered if all three are zero or more, the fill rule's bias is already in the
+        // offsets.
+        std::array<std::int32_t, 3> edgeStepX;
+        std::array<std::int32_t, 3> edgeStepY;
+        std::array<std::int64_t, 3> edgeOffset;
+
+        // Pixel bounds, max exclusive
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+
+        AttributePlane depth;
+
+        // Perspective-correct attributes are interpolated divided by w, then multiplied by
+        // the interpolated w. Unused by flat shading.
+        AttributePlane inverseW;
+        AttributePlane uOverW;
+        AttributePlane vOverW;
+        AttributePlane redOverW;
+        AttributePlane greenOverW;
+        AttributePlane blueOverW;
+
+        Cedar::Graphics::Pixel          flatColor;
+        const Cedar::Graphics::Surface* texture; // Null for flat shading
+    };
+
+
+
+    struct Viewport
+    {
+        Cedar::Size2D<int>     size;
+        Cedar::Vector2D<float> guardBandScale; // Guard band edges in NDC
+    };
+
+
+
+    template <typename T>
+    using Vector = std::vector<T, Cedar::Memory::TrackedAllocator<T, Cedar::Memory::Tag::Render>>;
+
+
+
+    ClipVertex toClipVertex(const Cedar::Graphics::Vertex& vertex);
+
+    ClipVertex lerp(const ClipVertex& first, const ClipVertex& second, float t);
+
+    std::array<float, 5> getClipDistances(const ClipVertex& vertex, Cedar::Vector2D<float> guardBandScale);
+
+    bool isOutsideFrustum(const std::array<ClipVertex, 3>& vertices);
+
+    void clipTriangle(Vector<TriangleSetup>& triangles, const Viewport& viewport, const Cedar::Graphics::DrawCall& drawCall,
+                      const std::array<ClipVertex, 3>& vertices, Cedar::Graphics::Pixel flatColor);
+
+    void setupTriangle(Vector<TriangleSetup>& triangles, const Viewport& viewport, const Cedar::Graphics::DrawCall& drawCall,
+                       std::array<ClipVertex, 3> vertices, Cedar::Graphics::Pixel flatColor);
+
+    AttributePlane makePlane(const std::array<float, 3>& values, const std::array<float, 3>& x, const std::array<float, 3>& y);
+
+    inline float evaluatePlane(const AttributePlane& plane, int x, int y);
+
+    inline std::int32_t clampEdge(std::int64_t value);
+
+    inline Cedar::Graphics::Pixel sampleTexture(const Cedar::Graphics::Surface& texture, float u, float v);
+
+    void rasterizeTriangle(const TriangleSetup& triangle, const Cedar::Graphics::Surface& target, float* depthBuffer,
+                           int depthStride, int minX, int minY, int maxX, int maxY);
+
+
+
+    ClipVertex toClipVertex(const Cedar::Graphics::Vertex& vertex)
+    {
+        return { vertex.position, vertex.texCoord,
+                 { static_cast<float>(Cedar::Graphics::getRed(vertex.color)),
+                   static_cast<float>(Cedar::Graphics::getGreen(vertex.color)),
+                   static_cast<float>(Cedar::Graphics::getBlue(vertex.color)) } };
+    }
+
+
+
+    ClipVertex lerp(const ClipVertex& first, const ClipVertex& second, float t)
+    {
+        auto mix = [t](float a, float b) { return a + (b - a) * t; };
+
+        return { { mix(first.position.x, second.position.x), mix(first.position.y, second.position.y),
+                   mix(first.position.z, second.position.z), mix(first.position.w, second.position.w) },
+                 { mix(first.texCoord.x, second.texCoord.x), mix(first.texCoord.y, second.texCoord.y) },
+                 { mix(first.color.x, second.color.x), mix(first.color.y, second.color.y), mix(first.color.z, second.color.z) } };
+    }
+
+
+
+    // Signed distances to the clipping planes, negative outside: the near plane, then
+    // the left, right, bottom and top edges of the guard band.
+    std::array<float, 5> getClipDistances(const ClipVertex& vertex, Cedar::Vector2D<float> guardBandScale)
+    {
+        const Cedar::Vector4D<float>& position = vertex.position;
+
+        return { position.z,
+                 guardBandScale.x * position.w + position.x,
+                 guardBandScale.x * position.w - position.x,
+                 guardBandScale.y * position.w + position.y,
+                 guardBandScale.y * position.w - position.y };
+    }
+
+
+
+    // True if all vertices are outside the same plane of the view frustum.
+    bool isOutsideFrustum(const std::array<ClipVertex, 3>& vertices)
+    {
+        auto allOutside = [&vertices](auto isOutside) {
+            return isOutside(vertices[0].position) && isOutside(vertices[1].position) && isOutside(vertices[2].position);
+        };
+
+        return allOutside([](const Cedar::Vector4D<float>& p) { return p.x < -p.w; }) ||
+               allOutside([](const Cedar::Vector4D<float>& p) { return p.x > p.w; }) ||
+               allOutside([](const Cedar::Vector4D<float>& p) { return p.y < -p.w; }) ||
+               allOutside([](const Cedar::Vector4D<float>& p) { return p.y > p.w; }) ||
+               allOutside([](const Cedar::Vector4D<float>& p) { return p.z < 0.0f; }) ||
+               allOutside([](const Cedar::Vector4D<float>& p) { return p.z > p.w; });
+    }
+
+
+
+    void clipTriangle(Vector<TriangleSetup>& triangles, const Viewport& viewport, const Cedar::Graphics::DrawCall& drawCall,
+                      const std::array<ClipVertex, 3>& vertices, Cedar::Graphics::Pixel flatColor)
+    {
+        if (isOutsideFrustum(vertices))
+            return;
+
+        bool needsClipping = false;
+
+        for (const ClipVertex& vertex : vertices)
+        {
+            for (float distance : getClipDistances(vertex, viewport.guardBandScale))
+                needsClipping |= (distance < 0.0f);
+        }
+
+        // Almost every triangle is fully inside the guard band
+        if (!needsClipping)
+        {
+            setupTriangle(triangles, viewport, drawCall, vertices, flatColor);
+            return;
+        }
+
+        // Sutherland-Hodgman, each plane can add at most one vertex
+        constexpr std::size_t maxPolygonSize = 3 + 5;
+
+        std::array<ClipVertex, maxPolygonSize> polygon;
+        std::array<ClipVertex, maxPolygonSize> clipped;
+        std::size_t polygonSize = 3;
+
+        std::copy(vertices.begin(), vertices.end(), polygon.begin());
+
+        for (std::size_t plane = 0; plane < 5 && polygonSize >= 3; plane++)
+        {
+            std::size_t clippedSize = 0;
+
+            for (std::size_t i = 0; i < polygonSize; i++)
+            {
+                const ClipVertex& current = polygon[i];
+                const ClipVertex& next    = polygon[(i + 1) % polygonSize];
+
+                float currentDistance = getClipDistances(current, viewport.guardBandScale)[plane];
+                float nextDistance    = getClipDistances(next, viewport.guardBandScale)[plane];
+
+                if (currentDistance >= 0.0f)
+                    clipped[clippedSize++] = current;
+
+                if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+                    clipped[clippedSize++] = lerp(current, next, currentDistance / (currentDistance - nextDistance));
+            }
+
+            polygon     = clipped;
+            polygonSize = clippedSize;
+        }
+
+        // Fan, keeps the winding of the original triangle
+        for (std::size_t i = 1; i + 1 < polygonSize; i++)
+            setupTriangle(triangles, viewport, drawCall, { polygon[0], polygon[i], polygon[i + 1] }, flatColor);
+    }
+
+
+
+    void setupTriangle(Vector<TriangleSetup>& triangles, const Viewport& viewport, const Cedar::Graphics::DrawCall& drawCall,
+                       std::array<ClipVertex, 3> vertices, Cedar::Graphics::Pixel flatColor)
+    {
+        std::array<float, 3>        inverseW;
+        std::array<std::int64_t, 3> fixedX;
+        std::array<std::int64_t, 3> fixedY;
+
+        // Project and snap to the subpixel grid
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            const Cedar::Vector4D<float>& position = vertices[i].position;
+
+            // Only possible for degenerate projections, clipping keeps w at least z
+            if (!(position.w > 0.0f))
+                return;
+
+            inverseW[i] = 1.0f / position.w;
+
+            float x = (position.x * inverseW[i] * 0.5f + 0.5f) * viewport.size.width;
+            float y = (0.5f - position.y * inverseW[i] * 0.5f) * viewport.size.height;
+
+            fixedX[i] = std::lrint(x * subpixelScale);
+            fixedY[i] = std::lrint(y * subpixelScale);
+        }
+
+        // Positive for clockwise triangles, y points down
+        std::int64_t area = (fixedX[1] - fixedX[0]) * (fixedY[2] - fixedY[0]) - (fixedX[2] - fixedX[0]) * (fixedY[1] - fixedY[0]);
+
+        if (area == 0 || (area > 0 && drawCall.cullMode == Cedar::Graphics::CullMode::Back))
+            return;
+
+        // Make every triangle clockwise so the inside of every edge is positive
+        if (area < 0)
+        {
+            std::swap(vertices[1], vertices[2]);
+            std::swap(inverseW[1], inverseW[2]);
+            std::swap(fixedX[1], fixedX[2]);
+            std::swap(fixedY[1], fixedY[2]);
+        }
+
+        TriangleSetup triangle;
+
+        triangle.minX = std::max(0, static_cast<int>((*std::min_element(fixedX.begin(), fixedX.end()) - subpixelScale / 2) >> subpixelBits));
+        triangle.minY = std::max(0, static_cast<int>((*std::min_element(fixedY.begin(), fixedY.end()) - subpixelScale / 2) >> subpixelBits));
+        triangle.maxX = std::min(viewport.size.width,
+                                 static_cast<int>((*std::max_element(fixedX.begin(), fixedX.end()) - subpixelScale / 2) >> subpixelBits) + 1);
+        triangle.maxY = std::min(viewport.size.height,
+                                 static_cast<int>((*std::max_element(fixedY.begin(), fixedY.end()) - subpixelScale / 2) >> subpixelBits) + 1);
+
+        if (triangle.minX >= triangle.maxX || triangle.minY >= triangle.maxY)
+            return;
+
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            std::size_t j = (i + 1) % 3;
+
+            std::int64_t a = fixedY[i] - fixedY[j];
+            std::int64_t b = fixedX[j] - fixedX[i];
+            std::int64_t c = -(a * fixedX[i] + b * fixedY[i]);
+
+            // Fill rule: a pixel center exactly on an edge is only covered for edges facing
+            // one way. The two triangles sharing an edge see it facing opposite ways, so
+            // exactly one of them covers the pixel.
+            std::int64_t bias = (a > 0 || (a == 0 && b > 0)) ? 0 : -1;
+
+            // Pixel centers are at half a pixel, in subpixels
+            triangle.edgeStepX[i]  = static_cast<std::int32_t>(a * subpixelScale);
+            triangle.edgeStepY[i]  = static_cast<std::int32_t>(b * subpixelScale);
+            triangle.edgeOffset[i] = c + (a + b) * (subpixelScale / 2) + bias;
+        }
+
+        std::array<float, 3> x;
+        std::array<float, 3> y;
+        std::array<float, 3> depth;
+
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            x[i]     = static_cast<float>(fixedX[i]) / subpixelScale;
+            y[i]     = static_cast<float>(fixedY[i]) / subpixelScale;
+            depth[i] = vertices[i].position.z * inverseW[i];
+        }
+
+        triangle.depth     = makePlane(depth, x, y);
+        triangle.flatColor = flatColor;
+        triangle.texture   = nullptr;
+
+        if (drawCall.shading == Cedar::Graphics::Shading::Textured)
+        {
+            auto overW = [&vertices, &inverseW](auto attribute) {
+                return std::array<float, 3>{ attribute(vertices[0]) * inverseW[0],
+                                             attribute(vertices[1]) * inverseW[1],
+                                             attribute(vertices[2]) * inverseW[2] };
+            };
+
+            triangle.inverseW   = makePlane(inverseW, x, y);
+            triangle.uOverW     = makePlane(overW([](const ClipVertex& vertex) { return vertex.texCoord.x; }), x, y);
+            triangle.vOverW     = makePlane(overW([](const ClipVertex& vertex) { return vertex.texCoord.y; }), x, y);
+            triangle.redOverW   = makePlane(overW([](const ClipVertex& vertex) { return vertex.color.x; }), x, y);
+            triangle.greenOverW = makePlane(overW([](const ClipVertex& vertex) { return vertex.color.y; }), x, y);
+            triangle.blueOverW  = makePlane(overW([](const ClipVertex& vertex) { return vertex.color.z; }), x, y);
+            triangle.texture    = drawCall.texture;
+        }
+
+        triangles.push_back(triangle);
+    }
+
+
+
+    AttributePlane makePlane(const std::array<float, 3>& values, const std::array<float, 3>& x, const std::array<float, 3>& y)
+    {
+        double deltaX1     = x[1] - x[0];
+        double deltaY1     = y[1] - y[0];
+        double deltaX2     = x[2] - x[0];
+        double deltaY2     = y[2] - y[0];
+        double deltaValue1 = values[1] - values[0];
+        double deltaValue2 = values[2] - values[0];
+
+        double determinant = deltaX1 * deltaY2 - deltaX2 * deltaY1;
+        double stepX       = (deltaValue1 * deltaY2 - deltaValue2 * deltaY1) / determinant;
+        double stepY       = (deltaValue2 * deltaX1 - deltaValue1 * deltaX2) / determinant;
+        double offset      = values[0] + stepX * (0.5 - x[0]) + stepY * (0.5 - y[0]);
+
+        return { static_cast<float>(stepX), static_cast<float>(stepY), static_cast<float>(offset) };
+    }
+
+
+
+    // Same order of operations as the AVX2 version, which adds the row's part first, so
+    // both produce the same image
+    inline float evaluatePlane(const AttributePlane& plane, int x, int y) {
+        return plane.stepX * x + (plane.stepY * y + plane.offset);
+    }
+
+
+
+    inline std::int32_t clampEdge(std::int64_t value) {
+        return static_cast<std::int32_t>(std::clamp(value, -edgeClamp, edgeClamp));
+    }
+
+
+
+    inline Cedar::Graphics::Pixel sampleTexture(const Cedar::Graphics::Surface& texture, float u, float v)
+    {
+        int x = std::min(static_cast<int>((u - std::floor(u)) * texture.size.width), texture.size.width - 1);
+        int y = std::min(static_cast<int>((v - std::floor(v)) * texture.size.height), texture.size.height - 1);
+
+        return texture.getPixel({ x, y });
+    }
+
+
+
+#if defined(CEDAR_SIMD_AVX2)
+
+    void rasterizeTriangle(const TriangleSetup& triangle, const Cedar::Graphics::Surface& target, float* depthBuffer,
+                           int depthStride, int minX, int minY, int maxX, int maxY)
+    {
+        const __m256i laneIndices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256  laneOffsets = _mm256_cvtepi32_ps(laneIndices);
+
+        // Start at a multiple of 8 pixels from the tile's edge so rows are walked in
+        // aligned groups. Pixels left of minX are outside the triangle's bounds anyway.
+        int startX = minX - ((minX % Cedar::Graphics::Rasterizer::tileSize) & 7);
+
+        __m256i edgeLaneSteps[3];
+        __m256i edgeGroupSteps[3];
+
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            edgeLaneSteps[i]  = _mm256_mullo_epi32(laneIndices, _mm256_set1_epi32(triangle.edgeStepX[i]));
+            edgeGroupSteps[i] = _mm256_set1_epi32(triangle.edgeStepX[i] * 8);
+        }
+
+        const __m256i endX = _mm256_set1_epi32(maxX);
+        const bool    flat = (triangle.texture == nullptr);
+
+        const __m256i flatColor = _mm256_set1_epi32(static_cast<int>(triangle.flatColor));
+        const __m256i byteMask  = _mm256_set1_epi32(0xFF);
+        const __m256i alpha     = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+        const __m256  colorScale = _mm256_set1_ps(1.0f / 255.0f);
+        const __m256  one        = _mm256_set1_ps(1.0f);
+
+        for (int y = minY; y < maxY; y++)
+        {
+            __m256i edges[3];
+
+            for (std::size_t i = 0; i < 3; i++)
+            {
+                std::int64_t rowStart = triangle.edgeStepX[i] * std::int64_t(startX) + triangle.edgeStepY[i] * std::int64_t(y) +
+                                        triangle.edgeOffset[i];
+
+                edges[i] = _mm256_add_epi32(_mm256_set1_epi32(clampEdge(rowStart)), edgeLaneSteps[i]);
+            }
+
+            Cedar::Graphics::Pixel* colorRow = target.getRow(y);
+            float*                  depthRow = depthBuffer + static_cast<std::ptrdiff_t>(y) * depthStride;
+
+            for (int x = startX; x < maxX; x += 8)
+            {
+                __m256i xs      = _mm256_add_epi32(_mm256_set1_epi32(x), laneIndices);
+                __m256i signs   = _mm256_or_si256(edges[0], _mm256_or_si256(edges[1], edges[2]));
+                __m256i covered = _mm256_andnot_si256(_mm256_srai_epi32(signs, 31), _mm256_cmpgt_epi32(endX, xs));
+
+                for (std::size_t i = 0; i < 3; i++)
+                    edges[i] = _mm256_add_epi32(edges[i], edgeGroupSteps[i]);
+
+                if (_mm256_testz_si256(covered, covered))
+                    continue;
+
+                __m256 pixelX = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), laneOffsets);
+
+                auto evaluate = [&pixelX, y](const AttributePlane& plane) {
+                    return _mm256_add_ps(_mm256_mul_ps(pixelX, _mm256_set1_ps(plane.stepX)),
+                                         _mm256_set1_ps(plane.stepY * y + plane.offset));
+                };
+
+                __m256  depth    = evaluate(triangle.depth);
+                __m256  oldDepth = _mm256_loadu_ps(depthRow + x);
+                __m256i passed   = _mm256_and_si256(covered, _mm256_castps_si256(_mm256_cmp_ps(depth, oldDepth, _CMP_LT_OQ)));
+
+                if (_mm256_testz_si256(passed, passed))
+                    continue;
+
+                _mm256_storeu_ps(depthRow + x, _mm256_blendv_ps(oldDepth, depth, _mm256_castsi256_ps(passed)));
+
+                __m256i color = flatColor;
+
+                if (!flat)
+                {
+                    const Cedar::Graphics::Surface& texture = *triangle.texture;
+
+                    __m256 w = _mm256_div_ps(one, evaluate(triangle.inverseW));
+                    __m256 u = _mm256_mul_ps(evaluate(triangle.uOverW), w);
+                    __m256 v = _mm256_mul_ps(evaluate(triangle.vOverW), w);
+
+                    // Wrap to [0, 1), then to texels
+                    u = _mm256_mul_ps(_mm256_sub_ps(u, _mm256_floor_ps(u)), _mm256_set1_ps(static_cast<float>(texture.size.width)));
+                    v = _mm256_mul_ps(_mm256_sub_ps(v, _mm256_floor_ps(v)), _mm256_set1_ps(static_cast<float>(texture.size.height)));
+
+                    __m256i texelX = _mm256_min_epi32(_mm256_cvttps_epi32(u), _mm256_set1_epi32(texture.size.width - 1));
+                    __m256i texelY = _mm256_min_epi32(_mm256_cvttps_epi32(v), _mm256_set1_epi32(texture.size.height - 1));
+                    __m256i index  = _mm256_add_epi32(_mm256_mullo_epi32(texelY, _mm256_set1_epi32(texture.stride)), texelX);
+
+                    __m256i texel = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), reinterpret_cast<const int*>(texture.pixels),
+                                                                index, passed, 4);
+
+                    auto modulate = [&](int shift, const AttributePlane& plane) {
+                        __m256 channel = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texel, shift), byteMask));
+                        __m256 tint    = _mm256_mul_ps(_mm256_mul_ps(evaluate(plane), w), colorScale);
+
+                        // Interpolation error can push the product slightly past 255
+                        __m256 product = _mm256_min_ps(_mm256_mul_ps(channel, tint), _mm256_set1_ps(255.0f));
+
+                        return _mm256_slli_epi32(_mm256_cvttps_epi32(product), shift);
+                    };
+
+                    color = _mm256_or_si256(_mm256_or_si256(alpha, modulate(16, triangle.redOverW)),
+                                            _mm256_or_si256(modulate(8, triangle.greenOverW), modulate(0, triangle.blueOverW)));
+                }
+
+                // Masked so nothing past the end of the row is touched
+                _mm256_maskstore_epi32(reinterpret_cast<int*>(colorRow + x), passed, color);
+            }
+        }
+    }
+
+#else
+
+    void rasterizeTriangle(const TriangleSetup& triangle, const Cedar::Graphics::Surface& target, float* depthBuffer,
+                           int depthStride, int minX, int minY, int maxX, int maxY)
+    {
+        for (int y = minY; y < maxY; y++)
+        {
+            std::array<std::int32_t, 3> edges;
+
+            for (std::size_t i = 0; i < 3; i++)
+                edges[i] = clampEdge(triangle.edgeStepX[i] * std::int64_t(minX) + triangle.edgeStepY[i] * std::int64_t(y) +
+                                     triangle.edgeOffset[i]);
+
+            Cedar::Graphics::Pixel* colorRow = target.getRow(y);
+            float*                  depthRow = depthBuffer + static_cast<std::ptrdiff_t>(y) * depthStride;
+
+            for (int x = minX; x < maxX; x++)
+            {
+                bool covered = (edges[0] | edges[1] | edges[2]) >= 0;
+
+                for (std::size_t i = 0; i < 3; i++)
+                    edges[i] += triangle.edgeStepX[i];
+
+                if (!covered)
+                    continue;
+
+                float depth = evaluatePlane(triangle.depth, x, y);
+
+                if (!(depth < depthRow[x]))
+                    continue;
+
+                depthRow[x] = depth;
+
+                if (triangle.texture == nullptr)
+                {
+                    colorRow[x] = triangle.flatColor;
+                    continue;
+                }
+
+                float w = 1.0f / evaluatePlane(triangle.inverseW, x, y);
+
+                Cedar::Graphics::Pixel texel = sampleTexture(*triangle.texture, evaluatePlane(triangle.uOverW, x, y) * w,
+                                                             evaluatePlane(triangle.vOverW, x, y) * w);
+
+                // Interpolation error can push the product slightly past 255
+                auto modulate = [&](std::uint8_t channel, const AttributePlane& plane) {
+                    return static_cast<std::uint8_t>(std::min(channel * (evaluatePlane(plane, x, y) * w * (1.0f / 255.0f)), 255.0f));
+                };
+
+                colorRow[x] = Cedar::Graphics::makePixel(modulate(Cedar::Graphics::getRed(texel), triangle.redOverW),
+                                                         modulate(Cedar::Graphics::getGreen(texel), triangle.greenOverW),
+                                                         modulate(Cedar::Graphics::getBlue(texel), triangle.blueOverW));
+            }
+        }
+    }
+
+#endif
+}
+
+
+
+namespace Cedar::Graphics
+{
+    struct Rasterizer::Chunk
+    {
+        Vector<TriangleSetup> triangles;
+        Vector<std::uint32_t> binOffsets;   // Start of each tile's triangles in binTriangles, plus the end
+        Vector<std::uint32_t> binTriangles; // Indices into triangles, grouped by tile
+    };
+
+
+
+    Rasterizer::Rasterizer() {}
+
+    Rasterizer::~Rasterizer() {}
+
+
+
+    void Rasterizer::beginFrame(const Surface& target)
+    {
+        if (m_recording)
+            throw std::logic_error("Rasterizer frame already begun");
+
+        Size2D<int> tileCounts = { (target.size.width + tileSize - 1) / tileSize, (target.size.height + tileSize - 1) / tileSize };
+
+        if (tileCounts != m_tileCounts)
+        {
+            CEDAR_LOG(Cedar::Log::renderCategory, Debug, std::format("Rasterizer target is {}x{}, binned into {}x{} tiles",
+                                                                     target.size.width, target.size.height,
+                                                                     tileCounts.width, tileCounts.height));
+        }
+
+        m_target     = target;
+        m_tileCounts = tileCounts;
+
+        // Padded to whole tiles so rows can be read 8 pixels at a time past the target's
+        // right edge
+        m_depthStride = m_tileCounts.width * tileSize;
+        m_depthBuffer.resize(static_cast<std::size_t>(m_depthStride) * m_tileCounts.height * tileSize);
+
+        m_drawCalls.clear();
+        m_drawCallEnds.clear();
+
+        m_clearPending = false;
+        m_recording    = true;
+        m_stats        = Stats();
+    }
+
+
+
+    void Rasterizer::clear(Pixel color)
+    {
+        if (!m_recording)
+            throw std::logic_error("Rasterizer frame not begun");
+
+        // Everything drawn before is covered by the clear
+        m_drawCalls.clear();
+        m_drawCallEnds.clear();
+
+        m_clearPending = true;
+        m_clearColor   = color;
+    }
+
+
+
+    void Rasterizer::draw(const DrawCall& drawCall)
+    {
+        if (!m_recording)
+            throw std::logic_error("Rasterizer frame not begun");
+
+        if (drawCall.indices.size() % 3 != 0)
+            throw std::invalid_argument("Index count is not a multiple of 3");
+
+        if (drawCall.shading == Shading::Textured && (drawCall.texture == nullptr || drawCall.texture->isEmpty()))
+            throw std::invalid_argument("Textured draw call without a texture");
+
+        // Checked here so the binning jobs can't run into bad indices
+        for (std::uint32_t index : drawCall.indices)
+        {
+            if (index >= drawCall.vertices.size())
+                throw std::out_of_range("Vertex index out of range");
+        }
+
+        std::size_t triangleCount = drawCall.indices.size() / 3;
+
+        if (triangleCount == 0)
+            return;
+
+        m_drawCalls.push_back(drawCall);
+        m_drawCallEnds.push_back((m_drawCallEnds.empty() ? 0 : m_drawCallEnds.back()) + triangleCount);
+
+        m_stats.submittedTriangles += triangleCount;
+    }
+
+
+
+    void Rasterizer::endFrame()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        if (!m_recording)
+            throw std::logic_error("Rasterizer frame not begun");
+
+        m_recording = false;
+
+        if (m_target.isEmpty())
+            return;
+
+        std::size_t triangleCount = m_drawCallEnds.empty() ? 0 : m_drawCallEnds.back();
+        std::size_t tileCount     = static_cast<std::size_t>(m_tileCounts.width) * m_tileCounts.height;
+
+        m_chunkCount = (triangleCount + chunkTriangleCount - 1) / chunkTriangleCount;
+
+        if (m_chunks.size() < m_chunkCount)
+        {
+            CEDAR_LOG(Cedar::Log::renderCategory, Debug, std::format("Rasterizer grew to {} binning chunks for {} triangles",
+                                                                     m_chunkCount, triangleCount));
+
+            m_chunks.resize(m_chunkCount);
+        }
+
+        {
+            CEDAR_PROFILE_SCOPE("Rasterizer::bin");
+
+            Jobs::parallelFor(m_chunkCount, 1, [this](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; i++)
+                    binChunk(i);
+            });
+        }
+
+        {
+            CEDAR_PROFILE_SCOPE("Rasterizer::rasterize");
+
+            Jobs::parallelFor(tileCount, 1, [this](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; i++)
+                    rasterizeTile(i);
+            });
+        }
+
+        for (std::size_t i = 0; i < m_chunkCount; i++)
+        {
+            m_stats.rasterizedTriangles += m_chunks[i].triangles.size();
+            m_stats.binnedTriangles     += m_chunks[i].binTriangles.size();
+        }
+
+        m_clearPending = false;
+    }
+
+
+
+    void Rasterizer::binChunk(std::size_t chunkIndex)
+    {
+        Chunk& chunk = m_chunks[chunkIndex];
+
+        std::size_t begin = chunkIndex * chunkTriangleCount;
+        std::size_t end   = std::min(begin + chunkTriangleCount, m_drawCallEnds.back());
+
+        Viewport viewport;
+        viewport.size           = m_target.size;
+        viewport.guardBandScale = { guardBand / (m_target.size.width * 0.5f), guardBand / (m_target.size.height * 0.5f) };
+
+        chunk.triangles.clear();
+
+        std::size_t drawCallIndex = std::upper_bound(m_drawCallEnds.begin(), m_drawCallEnds.end(), begin) - m_drawCallEnds.begin();
+
+        for (std::size_t i = begin; i < end; i++)
+        {
+            while (i >= m_drawCallEnds[drawCallIndex])
+                drawCallIndex++;
+
+            const DrawCall& drawCall      = m_drawCalls[drawCallIndex];
+            std::size_t     triangleIndex = i - ((drawCallIndex == 0) ? 0 : m_drawCallEnds[drawCallIndex - 1]);
+
+            std::array<ClipVertex, 3> vertices;
+
+            for (std::size_t j = 0; j < 3; j++)
+                vertices[j] = toClipVertex(drawCall.vertices[drawCall.indices[triangleIndex * 3 + j]]);
+
+            clipTriangle(chunk.triangles, viewport, drawCall, vertices, drawCall.vertices[drawCall.indices[triangleIndex * 3]].color);
+        }
+
+        // Counting sort of the triangles by tile, first count them, then place them
+        std::size_t tileCount = static_cast<std::size_t>(m_tileCounts.width) * m_tileCounts.height;
+
+        chunk.binOffsets.assign(tileCount + 1, 0);
+
+        auto forEachTile = [this](const TriangleSetup& triangle, auto function) {
+            for (int tileY = triangle.minY / tileSize; tileY <= (triangle.maxY - 1) / tileSize; tileY++)
+            {
+                for (int tileX = triangle.minX / tileSize; tileX <= (triangle.maxX - 1) / tileSize; tileX++)
+                    function(static_cast<std::size_t>(tileY) * m_tileCounts.width + tileX);
+            }
+        };
+
+        for (const TriangleSetup& triangle : chunk.triangles)
+            forEachTile(triangle, [&chunk](std::size_t tile) { chunk.binOffsets[tile + 1]++; });
+
+        for (std::size_t tile = 0; tile < tileCount; tile++)
+            chunk.binOffsets[tile + 1] += chunk.binOffsets[tile];
+
+        chunk.binTriangles.resize(chunk.binOffsets[tileCount]);
+
+        // Filled from the back of each bin so the offsets end up back at each bin's start
+        for (std::size_t i = chunk.triangles.size(); i-- > 0;)
+        {
+            forEachTile(chunk.triangles[i], [&chunk, i](std::size_t tile) {
+                chunk.binTriangles[--chunk.binOffsets[tile + 1]] = static_cast<std::uint32_t>(i);
+            });
+        }
+
+        // Every bin's start was decremented into the next bin's end slot, shift them back
+        for (std::size_t tile = 0; tile < tileCount; tile++)
+            chunk.binOffsets[tile] = chunk.binOffsets[tile + 1];
+
+        chunk.binOffsets[tileCount] = static_cast<std::uint32_t>(chunk.binTriangles.size());
+    }
+
+
+
+    void Rasterizer::rasterizeTile(std::size_t tileIndex)
+    {
+        int minX = static_cast<int>(tileIndex % m_tileCounts.width) * tileSize;
+        int minY = static_cast<int>(tileIndex / m_tileCounts.width) * tileSize;
+        int maxX = std::min(minX + tileSize, m_target.size.width);
+        int maxY = std::min(minY + tileSize, m_target.size.height);
+
+        float* depthBuffer = m_depthBuffer.data();
+
+        // A local copy, the clear color could otherwise alias the pixels it's written to
+        // and be reloaded for every pixel
+        Pixel clearColor = m_clearColor;
+
+        for (int y = minY; y < maxY; y++)
+        {
+            float* depthRow = depthBuffer + static_cast<std::ptrdiff_t>(y) * m_depthStride;
+            std::fill(depthRow + minX, depthRow + maxX, farDepth);
+
+            if (m_clearPending)
+            {
+                Pixel* colorRow = m_target.getRow(y);
+                std::fill(colorRow + minX, colorRow + maxX, clearColor);
+            }
+        }
+
+        for (std::size_t chunkIndex = 0; chunkIndex < m_chunkCount; chunkIndex++)
+        {
+            const Chunk& chunk = m_chunks[chunkIndex];
+
+            for (std::uint32_t i = chunk.binOffsets[tileIndex]; i < chunk.binOffsets[tileIndex + 1]; i++)
+            {
+                const TriangleSetup& triangle = chunk.triangles[chunk.binTriangles[i]];
+
+                rasterizeTriangle(triangle, m_target, depthBuffer, m_depthStride,
+                                  std::max(triangle.minX, minX), std::max(triangle.minY, minY),
+                                  std::min(triangle.maxX, maxX), std::min(triangle.maxY, maxY));
+            }
+        }
+    }
+}
\ No newline at end of file
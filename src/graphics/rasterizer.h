@@ -0,0 +1,169 @@
+//
+// Multithreaded tile-based software rasterizer.
+//
+// Draw calls only record what to draw. endFrame then runs in two parallel passes on the
+// job system:
+// * Binning: triangles are clipped, set up (fixed point edge functions, attribute
+//   planes) and sorted into the 64x64 pixel screen tiles their bounding box touches.
+//   Triangles are processed in chunks that each bin into their own lists, so no locks
+//   are needed and draw order is kept.
+// * Rasterization: each tile is rasterized by a single thread, walking the bins of
+//   every chunk in order. Tiles never share pixels, so they need no synchronization
+//   either, and a tile's color and depth stay in cache while its triangles are drawn.
+//
+// Coverage is tested with integer edge functions on 28.4 fixed point vertices, 8 pixels
+// per iteration with AVX2 (see CEDAR_SIMD_AVX2 in core.h), one otherwise. Edges follow a
+// fill rule that gives pixels on an edge shared by two triangles to exactly one of them.
+//
+// Positions are homogeneous clip space coordinates: x and y in [-w, w] map to the
+// target from left to right and bottom to top, z in [0, w] maps to depth from near to
+// far. Triangles are clipped against the near plane and a guard band around the target.
+// Front faces are counterclockwise on screen.
+//
+// Shading is either flat (the color of each triangle's first vertex) or textured (the
+// texture sampled with nearest filtering and wrapping, multiplied by the vertex color).
+// Texture coordinates and colors are interpolated perspective-correctly. Depth is tested
+// with less-than and always written.
+//
+
+#ifndef CEDAR_GRAPHICS_RASTERIZER_H
+#define CEDAR_GRAPHICS_RASTERIZER_H
+
+#include "surface.h"
+#include "../math/size.h"
+#include "../math/vector.h"
+#include "../memory/memory_tracker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+
+namespace Cedar::Graphics
+{
+    struct Vertex;
+
+    struct DrawCall;
+
+    class Rasterizer;
+
+
+
+    enum class Shading {
+        Flat,
+        Textured
+    };
+
+    enum class CullMode {
+        None,
+        Back
+    };
+
+
+
+    struct Vertex
+    {
+        Vector4D<float> position; // Clip space
+        Vector2D<float> texCoord;
+        Pixel           color;
+    };
+
+
+
+    // The vertices, indices and texture must stay alive until the end of the frame.
+    struct DrawCall
+    {
+        std::span<const Vertex>        vertices;
+        std::span<const std::uint32_t> indices;  // Three per triangle
+        Shading                        shading  = Shading::Flat;
+        const Surface*                 texture  = nullptr; // Required by textured shading
+        CullMode                       cullMode = CullMode::Back;
+    };
+
+
+
+    class Rasterizer
+    {
+    public:
+
+        static constexpr int tileSize = 64;
+
+        struct Stats
+        {
+            std::size_t submittedTriangles  = 0;
+            std::size_t rasterizedTriangles = 0; // After culling and clipping
+            std::size_t binnedTriangles     = 0; // Sum of the triangles in every tile
+        };
+
+
+        Rasterizer();
+
+        ~Rasterizer();
+
+
+        Rasterizer(const Rasterizer&) = delete;
+
+        Rasterizer& operator=(const Rasterizer&) = delete;
+
+
+        // Starts recording a frame that will be drawn into the target (e.g. the surface
+        // returned by Window::lockFramebuffer). The depth buffer is reset.
+        void beginFrame(const Surface& target);
+
+        // Clears the target to the color when the frame is drawn.
+        void clear(Pixel color);
+
+        void draw(const DrawCall& drawCall);
+
+        // Draws everything recorded since beginFrame into the target.
+        void endFrame();
+
+
+        // Stats of the last frame drawn.
+        inline const Stats& getStats() const;
+
+    private:
+
+        struct Chunk;
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Render>>;
+
+
+        Surface     m_target;
+        Size2D<int> m_tileCounts = { 0, 0 };
+
+        Vector<float>       m_depthBuffer;
+        int                 m_depthStride = 0;
+        Vector<DrawCall>    m_drawCalls;
+        Vector<std::size_t> m_drawCallEnds; // Running total of triangles after each draw call
+        Vector<Chunk>       m_chunks;
+        std::size_t         m_chunkCount = 0; // Chunks used by the current frame
+
+        bool  m_clearPending = false;
+        Pixel m_clearColor   = 0;
+        bool  m_recording    = false;
+
+        Stats m_stats;
+
+
+        void binChunk(std::size_t chunkIndex);
+
+        void rasterizeTile(std::size_t tileIndex);
+    };
+
+
+
+    // vvv Rasterizer function definitions vvv
+
+    inline const Rasterizer::Stats& Rasterizer::getStats() const
+    {
+        return m_stats;
+    }
+
+    // ^^^ Rasterizer function definitions ^^^
+}
+
+#endif // CEDAR_GRAPHICS_RASTERIZER_H
\ No newline at end of file
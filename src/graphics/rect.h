@@ -0,0 +1,116 @@
+//
+// Integer pixel rectangles.
+//
+// A rectangle covers the pixels from its position (inclusive) to its position plus its
+// size (exclusive). Rectangles with a width or height of zero or less are empty.
+//
+
+#ifndef CEDAR_GRAPHICS_RECT_H
+#define CEDAR_GRAPHICS_RECT_H
+
+#include "../math/point.h"
+#include "../math/size.h"
+
+#include <algorithm>
+#include <cstdint>
+
+
+
+namespace Cedar::Graphics
+{
+    struct Rect;
+
+
+
+    struct Rect
+    {
+        Point2D<int> position;
+        Size2D<int>  size;
+
+        inline bool operator==(const Rect& other) const {
+            return position == other.position && size == other.size;
+        }
+
+        inline bool operator!=(const Rect& other) const {
+            return !operator==(other);
+        }
+    };
+
+
+
+    constexpr bool isEmpty(Rect rect);
+
+    constexpr std::int64_t getArea(Rect rect);
+
+    // Largest rectangle covered by both rectangles. Empty if they don't overlap.
+    constexpr Rect intersect(Rect first, Rect second);
+
+    // Smallest rectangle covering both rectangles. Empty rectangles are ignored.
+    constexpr Rect unite(Rect first, Rect second);
+
+    constexpr bool overlaps(Rect first, Rect second);
+
+    constexpr bool contains(Rect outer, Rect inner);
+
+
+
+    constexpr bool isEmpty(Rect rect) {
+        return rect.size.width <= 0 || rect.size.height <= 0;
+    }
+
+
+
+    constexpr std::int64_t getArea(Rect rect) {
+        return isEmpty(rect) ? 0 : static_cast<std::int64_t>(rect.size.width) * rect.size.height;
+    }
+
+
+
+    constexpr Rect intersect(Rect first, Rect second)
+    {
+        int left   = std::max(first.position.x, second.position.x);
+        int top    = std::max(first.position.y, second.position.y);
+        int right  = std::min(first.position.x + first.size.width, second.position.x + second.size.width);
+        int bottom = std::min(first.position.y + first.size.height, second.position.y + second.size.height);
+
+        if (right <= left || bottom <= top)
+            return { { left, top }, { 0, 0 } };
+
+        return { { left, top }, { right - left, bottom - top } };
+    }
+
+
+
+    constexpr Rect unite(Rect first, Rect second)
+    {
+        if (isEmpty(first))
+            return second;
+        else if (isEmpty(second))
+            return first;
+
+        int left   = std::min(first.position.x, second.position.x);
+        int top    = std::min(first.position.y, second.position.y);
+        int right  = std::max(first.position.x + first.size.width, second.position.x + second.size.width);
+        int bottom = std::max(first.position.y + first.size.height, second.position.y + second.size.height);
+
+        return { { left, top }, { right - left, bottom - top } };
+    }
+
+
+
+    constexpr bool overlaps(Rect first, Rect second) {
+        return !isEmpty(intersect(first, second));
+    }
+
+
+
+    constexpr bool contains(Rect outer, Rect inner)
+    {
+        return isEmpty(inner) ||
+               (inner.position.x >= outer.position.x && inner.position.y >= outer.position.y &&
+                inner.position.x + inner.size.width <= outer.position.x + outer.size.width &&
+                inner.position.y + inner.size.height <= outer.position.y + outer.size.height);
+    }
+}
+
+#endif // CEDAR_GRAPHICS_RECT_H
\ No newline at end of file
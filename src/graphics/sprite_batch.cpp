@@ -0,0 +1,330 @@
+#include "sprite_batch.h"
+
+#include "blend.h"
+#include "rect.h"
+#include "surface.h"
+#include "../debug/profiler.h"
+#include "../io/log.h"
+#include "../jobs/job_system.h"
+#include "../math/point.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <stdexcept>
+
+
+
+namespace
+{
+    constexpr int textureIdBits = 16;
+    constexpr int layerBits     = 16;
+}
+
+
+
+namespace Cedar::Graphics
+{
+    struct SpriteBatch::Command
+    {
+        Rect         destination; // Already clipped
+        const Pixel* source;      // Texel drawn at the destination's top left corner, nullptr for rectangles
+        int          sourceStride;
+        Pixel        color;
+    };
+
+
+
+    SpriteBatch::SpriteBatch() {}
+
+    SpriteBatch::~SpriteBatch() {}
+
+
+
+    void SpriteBatch::begin(const Surface& target)
+    {
+        if (m_recording)
+            throw std::logic_error("Sprite batch already begun");
+
+        m_target   = target;
+        m_clipRect = { { 0, 0 }, target.isEmpty() ? Size2D<int>{ 0, 0 } : target.size };
+
+        m_commands.clear();
+        m_sortKeys.clear();
+        m_textureIds.clear();
+        m_lastTexture = nullptr;
+
+        m_recording = true;
+        m_stats     = Stats();
+    }
+
+
+
+    void SpriteBatch::setClipRect(const Rect& clipRect)
+    {
+        if (!m_recording)
+            throw std::logic_error("Sprite batch not begun");
+
+        m_clipRect = intersect(clipRect, { { 0, 0 }, m_target.isEmpty() ? Size2D<int>{ 0, 0 } : m_target.size });
+    }
+
+
+
+    void SpriteBatch::resetClipRect()
+    {
+        if (!m_recording)
+            throw std::logic_error("Sprite batch not begun");
+
+        m_clipRect = { { 0, 0 }, m_target.isEmpty() ? Size2D<int>{ 0, 0 } : m_target.size };
+    }
+
+
+
+    void SpriteBatch::fillRect(const Rect& rect, Pixel color, int layer)
+    {
+        addCommand(rect, nullptr, 0, color, 0, layer);
+    }
+
+
+
+    void SpriteBatch::drawSprite(const Surface& texture, Point2D<int> position, int layer)
+    {
+        drawSprite(texture, { { 0, 0 }, texture.size }, position, layer);
+    }
+
+
+
+    void SpriteBatch::drawSprite(const Surface& texture, const Rect& source, Point2D<int> position, int layer)
+    {
+        if (texture.isEmpty())
+            throw std::invalid_argument("Sprite texture is empty");
+
+        if (!contains({ { 0, 0 }, texture.size }, source))
+            throw std::out_of_range("Sprite source rectangle is outside of the texture");
+
+        addCommand({ position, source.size }, &texture.getPixel(source.position), texture.stride, 0,
+                   getTextureId(texture.pixels), layer);
+    }
+
+
+
+    void SpriteBatch::end()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        if (!m_recording)
+            throw std::logic_error("Sprite batch not begun");
+
+        m_recording = false;
+
+        m_stats.textureCount = m_textureIds.size();
+
+        // The commands keep their memory from frame to frame, so this only shows up while
+        // the batch warms up or when a frame draws more than any before it
+        if (m_commands.capacity() > m_commandCapacity)
+        {
+            m_commandCapacity = m_commands.capacity();
+
+            CEDAR_LOG(Cedar::Log::renderCategory, Debug, std::format("Sprite batch grew to {} commands", m_commandCapacity));
+        }
+
+        if (m_target.isEmpty() || m_commands.empty())
+            return;
+
+        {
+            CEDAR_PROFILE_SCOPE("SpriteBatch::sort");
+
+            sortCommands();
+            binCommands();
+        }
+
+        {
+            CEDAR_PROFILE_SCOPE("SpriteBatch::draw");
+
+            std::size_t bandCount = m_bandOffsets.size() - 1;
+
+            Jobs::parallelFor(bandCount, 1, [this](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; i++)
+                    drawBand(i);
+            });
+        }
+    }
+
+
+
+    void SpriteBatch::addCommand(const Rect& destination, const Pixel* source, int sourceStride, Pixel color,
+                                 std::uint32_t textureId, int layer)
+    {
+        if (!m_recording)
+            throw std::logic_error("Sprite batch not begun");
+
+        if (layer < minLayer || layer > maxLayer)
+            throw std::out_of_range("Sprite batch layer out of range");
+
+        m_stats.submittedCommands++;
+
+        Rect clipped = intersect(destination, m_clipRect);
+
+        if (isEmpty(clipped) || (source == nullptr && color == 0))
+        {
+            m_stats.culledCommands++;
+            return;
+        }
+
+        if (m_commands.size() > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error("Too many sprite batch commands");
+
+        if (source != nullptr)
+        {
+            source += static_cast<std::ptrdiff_t>(clipped.position.y - destination.position.y) * sourceStride +
+                      (clipped.position.x - destination.position.x);
+        }
+
+        std::uint64_t sortKey = (static_cast<std::uint64_t>(layer - minLayer) << (64 - layerBits)) |
+                                (static_cast<std::uint64_t>(textureId) << 32) | m_commands.size();
+
+        m_commands.push_back({ clipped, source, sourceStride, color });
+        m_sortKeys.push_back(sortKey);
+    }
+
+
+
+    std::uint32_t SpriteBatch::getTextureId(const Pixel* pixels)
+    {
+        // Sprites usually come in runs using the same texture
+        if (pixels == m_lastTexture)
+            return m_lastTextureId;
+
+        // 0 is for rectangles, which have no texture
+        auto [iterator, inserted] = m_textureIds.try_emplace(pixels, static_cast<std::uint32_t>(m_textureIds.size() + 1));
+
+        if (inserted && iterator->second >= (std::uint32_t(1) << textureIdBits))
+        {
+            m_textureIds.erase(iterator);
+            throw std::length_error("Too many textures in a sprite batch");
+        }
+
+        m_lastTexture   = pixels;
+        m_lastTextureId = iterator->second;
+
+        return m_lastTextureId;
+    }
+
+
+
+    void SpriteBatch::sortCommands()
+    {
+        // LSD radix sort on the layer and texture bits, the command index in the low bits
+        // is already in order and keeps the sort stable. Most batches use few layers and
+        // textures, so digits that are the same for every command are skipped.
+        m_sortScratch.resize(m_sortKeys.size());
+
+        for (int shift = 32; shift < 64; shift += 8)
+        {
+            std::array<std::uint32_t, 256> counts = {};
+
+            for (std::uint64_t key : m_sortKeys)
+                counts[(key >> shift) & 0xFF]++;
+
+            if (counts[(m_sortKeys.front() >> shift) & 0xFF] == m_sortKeys.size())
+                continue;
+
+            std::uint32_t offset = 0;
+
+            for (std::uint32_t& count : counts)
+            {
+                std::uint32_t bucketSize = count;
+
+                count   = offset;
+                offset += bucketSize;
+            }
+
+            for (std::uint64_t key : m_sortKeys)
+                m_sortScratch[counts[(key >> shift) & 0xFF]++] = key;
+
+            m_sortKeys.swap(m_sortScratch);
+        }
+    }
+
+
+
+    void SpriteBatch::binCommands()
+    {
+        std::size_t bandCount = static_cast<std::size_t>((m_target.size.height + bandHeight - 1) / bandHeight);
+
+        m_bandOffsets.assign(bandCount + 1, 0);
+
+        auto forEachBand = [](const Command& command, auto&& function) {
+            int firstBand = command.destination.position.y / bandHeight;
+            int lastBand  = (command.destination.position.y + command.destination.size.height - 1) / bandHeight;
+
+            for (int band = firstBand; band <= lastBand; band++)
+                function(static_cast<std::size_t>(band));
+        };
+
+        for (std::uint64_t key : m_sortKeys)
+            forEachBand(m_commands[static_cast<std::uint32_t>(key)], [this](std::size_t band) { m_bandOffsets[band + 1]++; });
+
+        for (std::size_t i = 0; i < bandCount; i++)
+            m_bandOffsets[i + 1] += m_bandOffsets[i];
+
+        m_bandCommands.resize(m_bandOffsets.back());
+
+        // Walks the commands in sorted order, so each band's list ends up sorted too.
+        // m_bandOffsets is used as the insertion cursor and shifted back afterwards.
+        for (std::uint64_t key : m_sortKeys)
+        {
+            std::uint32_t commandIndex = static_cast<std::uint32_t>(key);
+
+            forEachBand(m_commands[commandIndex], [this, commandIndex](std::size_t band) {
+                m_bandCommands[m_bandOffsets[band]++] = commandIndex;
+            });
+        }
+
+        for (std::size_t i = bandCount; i > 0; i--)
+            m_bandOffsets[i] = m_bandOffsets[i - 1];
+
+        m_bandOffsets[0] = 0;
+    }
+
+
+
+    void SpriteBatch::drawBand(std::size_t bandIndex)
+    {
+        int bandTop    = static_cast<int>(bandIndex) * bandHeight;
+        int bandBottom = std::min(bandTop + bandHeight, m_target.size.height);
+
+        for (std::uint32_t i = m_bandOffsets[bandIndex]; i < m_bandOffsets[bandIndex + 1]; i++)
+        {
+            // A copy, the color could otherwise alias the pixels it's written to
+            Command command = m_commands[m_bandCommands[i]];
+
+            int left   = command.destination.position.x;
+            int width  = command.destination.size.width;
+            int top    = std::max(command.destination.position.y, bandTop);
+            int bottom = std::min(command.destination.position.y + command.destination.size.height, bandBottom);
+
+            if (command.source != nullptr)
+            {
+                const Pixel* sourceRow = command.source +
+                                         static_cast<std::ptrdiff_t>(top - command.destination.position.y) * command.sourceStride;
+
+                for (int y = top; y < bottom; y++, sourceRow += command.sourceStride)
+                    blendRow(m_target.getRow(y) + left, sourceRow, width);
+            }
+            else if (getAlpha(command.color) == 0xFF)
+            {
+                for (int y = top; y < bottom; y++)
+                    std::fill_n(m_target.getRow(y) + left, width, command.color);
+            }
+            else
+            {
+                for (int y = top; y < bottom; y++)
+                    blendSolidRow(m_target.getRow(y) + left, command.color, width);
+            }
+        }
+    }
+}
\ No newline at end of file
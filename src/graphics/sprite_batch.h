@@ -0,0 +1,145 @@
+//
+// Batched 2D sprite and rectangle renderer.
+//
+// Commands are only recorded while a batch is open. end sorts them by layer, then by
+// texture within a layer (keeping submission order among commands with the same layer
+// and texture), and draws them in parallel on the job system: the target is split into
+// bands of rows that each draw every command touching them, in sorted order, so bands
+// never share pixels.
+//
+// Commands are clipped to the target and the current clip rectangle when they're
+// recorded. Colors and texels are premultiplied alpha (see premultiply in surface.h) and
+// are blended over the target with the functions in blend.h.
+//
+
+#ifndef CEDAR_GRAPHICS_SPRITE_BATCH_H
+#define CEDAR_GRAPHICS_SPRITE_BATCH_H
+
+#include "rect.h"
+#include "surface.h"
+#include "../math/point.h"
+#include "../memory/memory_tracker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace Cedar::Graphics
+{
+    class SpriteBatch;
+
+
+
+    class SpriteBatch
+    {
+    public:
+
+        static constexpr int minLayer   = -32768;
+        static constexpr int maxLayer   = 32767;
+        static constexpr int bandHeight = 32;
+
+        struct Stats
+        {
+            std::size_t submittedCommands = 0;
+            std::size_t culledCommands    = 0; // Clipped away entirely
+            std::size_t textureCount      = 0;
+        };
+
+
+        SpriteBatch();
+
+        ~SpriteBatch();
+
+
+        SpriteBatch(const SpriteBatch&) = delete;
+
+        SpriteBatch& operator=(const SpriteBatch&) = delete;
+
+
+        // Starts recording commands that will be drawn into the target. The clip
+        // rectangle is reset.
+        void begin(const Surface& target);
+
+        // Commands recorded from now on are clipped to the rectangle.
+        void setClipRect(const Rect& clipRect);
+
+        // Commands recorded from now on are only clipped to the target.
+        void resetClipRect();
+
+
+        void fillRect(const Rect& rect, Pixel color, int layer = 0);
+
+        // Draws the whole texture with its top left corner at the position.
+        void drawSprite(const Surface& texture, Point2D<int> position, int layer = 0);
+
+        // Draws the source rectangle of the texture with its top left corner at the
+        // position. Textures are told apart by their pixels and must stay alive until end.
+        void drawSprite(const Surface& texture, const Rect& source, Point2D<int> position, int layer = 0);
+
+        // Draws everything recorded since begin into the target.
+        void end();
+
+
+        // Stats of the last batch drawn.
+        inline const Stats& getStats() const;
+
+    private:
+
+        struct Command;
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Render>>;
+
+        template <typename TKey, typename TValue>
+        using Map = std::unordered_map<TKey, TValue, std::hash<TKey>, std::equal_to<TKey>,
+                                       Memory::TrackedAllocator<std::pair<const TKey, TValue>, Memory::Tag::Render>>;
+
+
+        Surface m_target;
+        Rect    m_clipRect = { { 0, 0 }, { 0, 0 } };
+
+        Vector<Command>       m_commands;
+        Vector<std::uint64_t> m_sortKeys;        // Layer, texture and command index
+        Vector<std::uint64_t> m_sortScratch;
+        Vector<std::uint32_t> m_bandOffsets;     // Start of each band's commands in m_bandCommands, plus the end
+        Vector<std::uint32_t> m_bandCommands;    // Indices into m_commands, grouped by band
+
+        Map<const Pixel*, std::uint32_t> m_textureIds;
+        const Pixel*                     m_lastTexture   = nullptr;
+        std::uint32_t                    m_lastTextureId = 0;
+
+        std::size_t m_commandCapacity = 0; // Reported when the commands outgrow it
+
+        bool  m_recording = false;
+        Stats m_stats;
+
+
+        void addCommand(const Rect& destination, const Pixel* source, int sourceStride, Pixel color, std::uint32_t textureId,
+                        int layer);
+
+        std::uint32_t getTextureId(const Pixel* pixels);
+
+        void sortCommands();
+
+        void binCommands();
+
+        void drawBand(std::size_t bandIndex);
+    };
+
+
+
+    // vvv SpriteBatch function definitions vvv
+
+    inline const SpriteBatch::Stats& SpriteBatch::getStats() const
+    {
+        return m_stats;
+    }
+
+    // ^^^ SpriteBatch function definitions ^^^
+}
+
+#endif // CEDAR_GRAPHICS_SPRITE_BATCH_H
\ No newline at end of file
@@ -0,0 +1,124 @@
+//
+// CPU pixel surfaces.
+//
+// Pixels are 32-bit 0xAARRGGBB values. In memory on little-endian machines that's the
+// B, G, R, A byte order, which is the native layout of both 32-bit X11 TrueColor images
+// and 32-bit Windows DIBs, so surfaces can be handed to the OS without conversion.
+//
+
+#ifndef CEDAR_GRAPHICS_SURFACE_H
+#define CEDAR_GRAPHICS_SURFACE_H
+
+#include "../math/point.h"
+#include "../math/size.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+
+namespace Cedar::Graphics
+{
+    typedef std::uint32_t Pixel;
+
+
+
+    struct Surface;
+
+
+
+    // Non-owning view of a block of pixels.
+    struct Surface
+    {
+        Pixel*      pixels = nullptr;
+        Size2D<int> size   = { 0, 0 };
+        int         stride = 0; // Distance between the starts of two rows, in pixels
+
+
+        inline bool isEmpty() const;
+
+        inline Pixel* getRow(int y) const;
+
+        inline Pixel& getPixel(Point2D<int> position) const;
+    };
+
+
+
+    constexpr Pixel makePixel(std::uint8_t red, std::uint8_t green, std::uint8_t blue, std::uint8_t alpha = 0xFF);
+
+    constexpr std::uint8_t getRed(Pixel pixel);
+
+    constexpr std::uint8_t getGreen(Pixel pixel);
+
+    constexpr std::uint8_t getBlue(Pixel pixel);
+
+    constexpr std::uint8_t getAlpha(Pixel pixel);
+
+    // Multiplies the color channels by alpha, the form blending functions expect.
+    constexpr Pixel premultiply(Pixel pixel);
+
+
+
+    inline bool Surface::isEmpty() const {
+        return pixels == nullptr || size.width <= 0 || size.height <= 0;
+    }
+
+
+
+    inline Pixel* Surface::getRow(int y) const {
+        return pixels + static_cast<std::ptrdiff_t>(y) * stride;
+    }
+
+
+
+    inline Pixel& Surface::getPixel(Point2D<int> position) const {
+        return getRow(position.y)[position.x];
+    }
+
+
+
+    constexpr Pixel makePixel(std::uint8_t red, std::uint8_t green, std::uint8_t blue, std::uint8_t alpha) {
+        return (Pixel(alpha) << 24) | (Pixel(red) << 16) | (Pixel(green) << 8) | Pixel(blue);
+    }
+
+
+
+    constexpr std::uint8_t getRed(Pixel pixel) {
+        return static_cast<std::uint8_t>(pixel >> 16);
+    }
+
+
+
+    constexpr std::uint8_t getGreen(Pixel pixel) {
+        return static_cast<std::uint8_t>(pixel >> 8);
+    }
+
+
+
+    constexpr std::uint8_t getBlue(Pixel pixel) {
+        return static_cast<std::uint8_t>(pixel);
+    }
+
+
+
+    constexpr std::uint8_t getAlpha(Pixel pixel) {
+        return static_cast<std::uint8_t>(pixel >> 24);
+    }
+
+
+
+    constexpr Pixel premultiply(Pixel pixel)
+    {
+        std::uint32_t alpha = getAlpha(pixel);
+
+        // Rounded division by 255
+        auto scale = [alpha](std::uint8_t channel) {
+            std::uint32_t product = channel * alpha + 128;
+            return static_cast<std::uint8_t>((product + (product >> 8)) >> 8);
+        };
+
+        return makePixel(scale(getRed(pixel)), scale(getGreen(pixel)), scale(getBlue(pixel)), static_cast<std::uint8_t>(alpha));
+    }
+}
+
+#endif // CEDAR_GRAPHICS_SURFACE_H
\ No newline at end of file
@@ -0,0 +1,418 @@
+#include "text_renderer.h"
+
+#include "blend.h"
+#include "font.h"
+#include "rect.h"
+#include "surface.h"
+#include "../io/log.h"
+#include "../math/point.h"
+#include "../math/size.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+
+
+
+namespace
+{
+    constexpr std::uint32_t noLayout = std::numeric_limits<std::uint32_t>::max();
+
+
+
+    char32_t decodeUtf8(std::string_view text, std::size_t& index);
+
+    // Calls function(line, lineIndex) for every line of the text.
+    template <typename TFunction>
+    void forEachLine(std::string_view text, TFunction&& function);
+}
+
+
+
+namespace
+{
+    // Decodes the code point starting at the index and moves the index past it. Invalid
+    // sequences decode to U+FFFD one byte at a time.
+    char32_t decodeUtf8(std::string_view text, std::size_t& index)
+    {
+        constexpr char32_t replacement = 0xFFFD;
+
+        unsigned char lead = static_cast<unsigned char>(text[index++]);
+
+        if (lead < 0x80)
+            return lead;
+
+        int      continuationCount;
+        char32_t codePoint;
+        char32_t minCodePoint; // Smaller code points are overlong encodings
+
+        if ((lead & 0xE0) == 0xC0)
+        {
+            continuationCount = 1;
+            codePoint         = lead & 0x1F;
+            minCodePoint      = 0x80;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            continuationCount = 2;
+            codePoint         = lead & 0x0F;
+            minCodePoint      = 0x800;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            continuationCount = 3;
+            codePoint         = lead & 0x07;
+            minCodePoint      = 0x10000;
+        }
+        else
+        {
+            return replacement;
+        }
+
+        for (int i = 0; i < continuationCount; i++)
+        {
+            if (index >= text.size() || (static_cast<unsigned char>(text[index]) & 0xC0) != 0x80)
+                return replacement;
+
+            codePoint = (codePoint << 6) | (static_cast<unsigned char>(text[index++]) & 0x3F);
+        }
+
+        if (codePoint < minCodePoint || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+            return replacement;
+
+        return codePoint;
+    }
+
+
+
+    template <typename TFunction>
+    void forEachLine(std::string_view text, TFunction&& function)
+    {
+        int lineIndex = 0;
+
+        while (true)
+        {
+            std::size_t lineEnd = text.find('\n');
+
+            function(text.substr(0, lineEnd), lineIndex);
+
+            if (lineEnd == std::string_view::npos)
+                return;
+
+            text.remove_prefix(lineEnd + 1);
+            lineIndex++;
+        }
+    }
+}
+
+
+
+namespace Cedar::Graphics
+{
+    struct TextRenderer::Glyph
+    {
+        int x;      // From the start of the line
+        int atlasX;
+    };
+
+
+
+    struct TextRenderer::Layout
+    {
+        std::size_t   hash = 0;
+        String        text;
+        Vector<Glyph> glyphs; // Ordered by x, blank glyphs left out
+        int           width = 0;
+
+        std::uint32_t previous = noLayout; // More recently used
+        std::uint32_t next     = noLayout; // Less recently used
+    };
+
+
+
+    TextRenderer::TextRenderer(const BitmapFont& font, int scale, std::size_t layoutCacheCapacity)
+    {
+        if (font.glyphSize.width < 1 || font.glyphSize.width > 8 || font.glyphSize.height < 1)
+            throw std::invalid_argument("Unsupported bitmap font glyph size");
+
+        if (font.glyphCount == 0 || font.rows.size() < font.glyphCount * font.glyphSize.height)
+            throw std::invalid_argument("Bitmap font rows missing");
+
+        if (font.fallbackCodePoint < font.firstCodePoint || font.fallbackCodePoint - font.firstCodePoint >= font.glyphCount)
+            throw std::invalid_argument("Bitmap font has no fallback glyph");
+
+        if (scale < 1)
+            throw std::invalid_argument("Text scale must be at least 1");
+
+        if (layoutCacheCapacity < 1 || layoutCacheCapacity >= noLayout)
+            throw std::invalid_argument("Invalid text layout cache capacity");
+
+        m_glyphSize      = { font.glyphSize.width * scale, font.glyphSize.height * scale };
+        m_firstCodePoint = font.firstCodePoint;
+        m_glyphCount     = font.glyphCount;
+        m_fallbackGlyph  = font.fallbackCodePoint - font.firstCodePoint;
+        m_layoutCapacity = layoutCacheCapacity;
+
+        m_atlasStride = static_cast<int>(m_glyphCount) * m_glyphSize.width;
+        m_atlas.resize(static_cast<std::size_t>(m_atlasStride) * m_glyphSize.height);
+        m_glyphIsBlank.resize(m_glyphCount);
+
+        for (std::size_t glyph = 0; glyph < m_glyphCount; glyph++)
+        {
+            const std::uint8_t* glyphRows = font.rows.data() + glyph * font.glyphSize.height;
+
+            m_glyphIsBlank[glyph] = std::all_of(glyphRows, glyphRows + font.glyphSize.height, [](std::uint8_t row) {
+                return row == 0;
+            });
+
+            for (int y = 0; y < m_glyphSize.height; y++)
+            {
+                std::uint8_t* atlasRow = m_atlas.data() + static_cast<std::size_t>(y) * m_atlasStride + glyph * m_glyphSize.width;
+
+                for (int x = 0; x < m_glyphSize.width; x++)
+                    atlasRow[x] = ((glyphRows[y / scale] >> (x / scale)) & 1) ? 0xFF : 0x00;
+            }
+        }
+
+        // Reserved up front, layouts are referenced by index and never move
+        m_layouts.reserve(m_layoutCapacity);
+    }
+
+
+
+    TextRenderer::~TextRenderer() {}
+
+
+
+    Size2D<int> TextRenderer::measureText(std::string_view text)
+    {
+        Size2D<int> size = { 0, 0 };
+
+        forEachLine(text, [this, &size](std::string_view line, int) {
+            size.width   = std::max(size.width, getLayout(line).width);
+            size.height += m_glyphSize.height;
+        });
+
+        return size;
+    }
+
+
+
+    void TextRenderer::drawText(const Surface& target, std::string_view text, Point2D<int> position, Pixel color)
+    {
+        drawText(target, text, position, color, { { 0, 0 }, target.size });
+    }
+
+
+
+    void TextRenderer::drawText(const Surface& target, std::string_view text, Point2D<int> position, Pixel color,
+                                const Rect& clipRect)
+    {
+        if (target.isEmpty())
+            return;
+
+        Rect clip = intersect(clipRect, { { 0, 0 }, target.size });
+
+        if (isEmpty(clip) || color == 0)
+            return;
+
+        forEachLine(text, [&](std::string_view line, int lineIndex) {
+            Point2D<int> linePosition = { position.x, position.y + lineIndex * m_glyphSize.height };
+
+            // Lines outside of the clip rectangle aren't laid out, so scrolled away text
+            // doesn't push visible text out of the cache
+            if (linePosition.y + m_glyphSize.height <= clip.position.y || linePosition.y >= clip.position.y + clip.size.height)
+                return;
+
+            drawLine(target, getLayout(line), linePosition, color, clip);
+        });
+    }
+
+
+
+    void TextRenderer::clearCache()
+    {
+        m_layouts.clear();
+        m_layoutIndices.clear();
+        m_cacheIsFull = false;
+    }
+
+
+
+    void TextRenderer::resetStats()
+    {
+        m_stats = Stats();
+    }
+
+
+
+    const TextRenderer::Layout& TextRenderer::getLayout(std::string_view line)
+    {
+        std::size_t   hash        = std::hash<std::string_view>()(line);
+        auto          iterator    = m_layoutIndices.find(hash);
+        std::uint32_t layoutIndex = noLayout;
+
+        if (iterator != m_layoutIndices.end())
+        {
+            layoutIndex = iterator->second;
+
+            if (m_layouts[layoutIndex].text == line)
+            {
+                m_stats.cacheHits++;
+                markUsed(layoutIndex);
+
+                return m_layouts[layoutIndex];
+            }
+
+            // A different line with the same hash, its slot is reused
+        }
+        else if (m_layouts.size() < m_layoutCapacity)
+        {
+            layoutIndex = static_cast<std::uint32_t>(m_layouts.size());
+
+            Layout& layout = m_layouts.emplace_back();
+
+            if (layoutIndex == 0)
+            {
+                m_leastRecentLayout = layoutIndex;
+            }
+            else
+            {
+                layout.next                             = m_mostRecentLayout;
+                m_layouts[m_mostRecentLayout].previous = layoutIndex;
+            }
+
+            m_mostRecentLayout = layoutIndex;
+        }
+        else
+        {
+            if (!m_cacheIsFull)
+            {
+                m_cacheIsFull = true;
+
+                CEDAR_LOG(Cedar::Log::renderCategory, Debug, std::format("Text layout cache is full at {} layouts, evicting "
+                                                                         "the least recently used", m_layoutCapacity));
+            }
+
+            layoutIndex = m_leastRecentLayout;
+            m_layoutIndices.erase(m_layouts[layoutIndex].hash);
+        }
+
+        m_stats.cacheMisses++;
+
+        Layout& layout = m_layouts[layoutIndex];
+        layout.hash = hash;
+        layout.text.assign(line);
+        layOut(line, layout);
+
+        m_layoutIndices[hash] = layoutIndex;
+        markUsed(layoutIndex);
+
+        return layout;
+    }
+
+
+
+    void TextRenderer::layOut(std::string_view line, Layout& layout) const
+    {
+        layout.glyphs.clear();
+
+        int         column = 0;
+        std::size_t index  = 0;
+
+        while (index < line.size())
+        {
+            char32_t codePoint = decodeUtf8(line, index);
+
+            if (codePoint == U'\t')
+            {
+                column = (column / tabWidth + 1) * tabWidth;
+                continue;
+            }
+            else if (codePoint == U'\r')
+            {
+                continue;
+            }
+
+            std::size_t glyph = (codePoint >= m_firstCodePoint && codePoint - m_firstCodePoint < m_glyphCount)
+                                    ? codePoint - m_firstCodePoint : m_fallbackGlyph;
+
+            if (!m_glyphIsBlank[glyph])
+                layout.glyphs.push_back({ column * m_glyphSize.width, static_cast<int>(glyph) * m_glyphSize.width });
+
+            column++;
+        }
+
+        layout.width = column * m_glyphSize.width;
+    }
+
+
+
+    void TextRenderer::markUsed(std::uint32_t layoutIndex)
+    {
+        if (layoutIndex == m_mostRecentLayout)
+            return;
+
+        Layout& layout = m_layouts[layoutIndex];
+
+        // Not the most recent, so it has a previous layout
+        m_layouts[layout.previous].next = layout.next;
+
+        if (layout.next != noLayout)
+            m_layouts[layout.next].previous = layout.previous;
+        else
+            m_leastRecentLayout = layout.previous;
+
+        layout.previous                        = noLayout;
+        layout.next                            = m_mostRecentLayout;
+        m_layouts[m_mostRecentLayout].previous = layoutIndex;
+        m_mostRecentLayout                     = layoutIndex;
+    }
+
+
+
+    void TextRenderer::drawLine(const Surface& target, const Layout& layout, Point2D<int> position, Pixel color,
+                                const Rect& clipRect)
+    {
+        int clipLeft  = clipRect.position.x;
+        int clipRight = clipRect.position.x + clipRect.size.width;
+        int top       = std::max(position.y, clipRect.position.y);
+        int bottom    = std::min(position.y + m_glyphSize.height, clipRect.position.y + clipRect.size.height);
+
+        // Glyphs are ordered by x, so the visible ones are a contiguous range
+        const Glyph* first = std::partition_point(layout.glyphs.data(), layout.glyphs.data() + layout.glyphs.size(),
+                                                  [&](const Glyph& glyph) {
+            return position.x + glyph.x + m_glyphSize.width <= clipLeft;
+        });
+
+        const Glyph* last = std::partition_point(first, layout.glyphs.data() + layout.glyphs.size(), [&](const Glyph& glyph) {
+            return position.x + glyph.x < clipRight;
+        });
+
+        if (first == last)
+            return;
+
+        // Row by row, so every glyph of a row blends into the same few cache lines
+        for (int y = top; y < bottom; y++)
+        {
+            Pixel*              targetRow = target.getRow(y);
+            const std::uint8_t* atlasRow  = m_atlas.data() + static_cast<std::size_t>(y - position.y) * m_atlasStride;
+
+            for (const Glyph* glyph = first; glyph != last; glyph++)
+            {
+                int glyphLeft = position.x + glyph->x;
+                int left      = std::max(glyphLeft, clipLeft);
+                int right     = std::min(glyphLeft + m_glyphSize.width, clipRight);
+
+                blendMaskRow(targetRow + left, atlasRow + glyph->atlasX + (left - glyphLeft), color, right - left);
+            }
+        }
+
+        m_stats.drawnGlyphs += last - first;
+    }
+}
\ No newline at end of file
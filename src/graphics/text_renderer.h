@@ -0,0 +1,163 @@
+//
+// Bitmap font text renderer.
+//
+// The font's glyphs are rasterized once, at construction, into an atlas of 8-bit coverage
+// masks scaled up by an integer factor. Text is UTF-8 and split into lines at '\n'. Each
+// line is laid out (decoded, mapped to glyphs, tabs expanded, blanks dropped) the first
+// time it's drawn or measured, and the layout is cached under the line's hash, so text
+// that stays the same from frame to frame, like most UI and log lines, is only laid out
+// once. The cache holds a fixed number of layouts and evicts the least recently used.
+//
+// Lines are drawn row by row, blending each glyph's coverage row with the text color
+// (premultiplied alpha, see blend.h).
+//
+// A renderer must only be used by one thread at a time.
+//
+
+#ifndef CEDAR_GRAPHICS_TEXT_RENDERER_H
+#define CEDAR_GRAPHICS_TEXT_RENDERER_H
+
+#include "font.h"
+#include "rect.h"
+#include "surface.h"
+#include "../math/point.h"
+#include "../math/size.h"
+#include "../memory/memory_tracker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace Cedar::Graphics
+{
+    class TextRenderer;
+
+
+
+    class TextRenderer
+    {
+    public:
+
+        static constexpr int tabWidth = 4; // In glyphs
+
+        struct Stats
+        {
+            std::size_t cacheHits   = 0;
+            std::size_t cacheMisses = 0;
+            std::size_t drawnGlyphs = 0;
+        };
+
+
+        explicit TextRenderer(const BitmapFont& font = getDefaultFont(), int scale = 1, std::size_t layoutCacheCapacity = 4096);
+
+        ~TextRenderer();
+
+
+        TextRenderer(const TextRenderer&) = delete;
+
+        TextRenderer& operator=(const TextRenderer&) = delete;
+
+
+        // Size of a glyph once scaled, which is also the advance between glyphs.
+        inline Size2D<int> getGlyphSize() const;
+
+        inline int getLineHeight() const;
+
+        // Width of the longest line and height of all lines.
+        Size2D<int> measureText(std::string_view text);
+
+
+        // Draws the text with its top left corner at the position.
+        void drawText(const Surface& target, std::string_view text, Point2D<int> position, Pixel color);
+
+        // Draws the text with its top left corner at the position, clipped to the
+        // rectangle.
+        void drawText(const Surface& target, std::string_view text, Point2D<int> position, Pixel color, const Rect& clipRect);
+
+
+        void clearCache();
+
+
+        // Stats since construction or the last reset.
+        inline const Stats& getStats() const;
+
+        void resetStats();
+
+    private:
+
+        struct Glyph;
+
+        struct Layout;
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Render>>;
+
+        using String = std::basic_string<char, std::char_traits<char>, Memory::TrackedAllocator<char, Memory::Tag::Render>>;
+
+        using Map = std::unordered_map<std::size_t, std::uint32_t, std::hash<std::size_t>, std::equal_to<std::size_t>,
+                                       Memory::TrackedAllocator<std::pair<const std::size_t, std::uint32_t>, Memory::Tag::Render>>;
+
+
+        Size2D<int> m_glyphSize;
+        char32_t    m_firstCodePoint;
+        std::size_t m_glyphCount;
+        std::size_t m_fallbackGlyph;
+
+        Vector<std::uint8_t> m_atlas;       // Every glyph side by side, in code point order
+        int                  m_atlasStride; // In pixels
+        Vector<bool>         m_glyphIsBlank;
+
+        // Layouts are kept in a fixed number of slots, linked from most to least
+        // recently used. Evicted slots keep their memory for the next layout.
+        Vector<Layout> m_layouts;
+        std::size_t    m_layoutCapacity;
+        std::uint32_t  m_mostRecentLayout  = 0;
+        std::uint32_t  m_leastRecentLayout = 0;
+        Map            m_layoutIndices;     // By hash of the line
+        bool           m_cacheIsFull = false; // Reported once, when the first layout is evicted
+
+        Stats m_stats;
+
+
+        const Layout& getLayout(std::string_view line);
+
+        void layOut(std::string_view line, Layout& layout) const;
+
+        void markUsed(std::uint32_t layoutIndex);
+
+        void drawLine(const Surface& target, const Layout& layout, Point2D<int> position, Pixel color, const Rect& clipRect);
+    };
+
+
+
+    // vvv TextRenderer function definitions vvv
+
+    inline Size2D<int> TextRenderer::getGlyphSize() const
+    {
+        return m_glyphSize;
+    }
+
+
+
+    inline int TextRenderer::getLineHeight() const
+    {
+        return m_glyphSize.height;
+    }
+
+
+
+    inline const TextRenderer::Stats& TextRenderer::getStats() const
+    {
+        return m_stats;
+    }
+
+    // ^^^ TextRenderer function definitions ^^^
+}
+
+#endif // CEDAR_GRAPHICS_TEXT_RENDERER_H
\ No newline at end of file
@@ -5,6 +5,8 @@
 #ifndef CEDAR_IO_H
 #define CEDAR_IO_H
 
+#include "io/file_io.h"
+#include "io/file_watcher.h"
 #include "io/log.h"
 #include "io/terminal.h"
 
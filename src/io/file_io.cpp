@@ -0,0 +1,1078 @@
+#include "file_io.h"
+
+#include "../core.h"
+#include "../debug/profiler.h"
+#include "../memory/memory_tracker.h"
+#include "log.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <mutex>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+
+namespace Cedar::FileIO
+{
+    // Gives the I/O code access to the internals of requests
+    struct RequestAccess
+    {
+        static Request::State& getState(Request& request)
+        {
+            return request.m_state;
+        }
+
+        static Result& getResult(Request& request)
+        {
+            return request.m_result;
+        }
+
+        static std::atomic<Status>& getStatus(Request& request)
+        {
+            return request.m_status;
+        }
+    };
+}
+
+
+
+namespace
+{
+    using Cedar::FileIO::Backend;
+    using Cedar::FileIO::Priority;
+    using Cedar::FileIO::Request;
+    using Cedar::FileIO::RequestAccess;
+    using Cedar::FileIO::Result;
+    using Cedar::FileIO::Status;
+
+    struct Completion;
+
+    struct FileIOData;
+
+    template <typename T>
+    using Deque = std::deque<T, Cedar::Memory::TrackedAllocator<T, Cedar::Memory::Tag::General>>;
+
+    template <typename T>
+    using Vector = std::vector<T, Cedar::Memory::TrackedAllocator<T, Cedar::Memory::Tag::General>>;
+
+
+
+    constexpr std::size_t priorityCount   = 3;
+    constexpr std::size_t poolThreadCount = 2;
+
+
+
+    // Where a pending request is, guarded by the module mutex
+    enum Stage : int {
+        Stage_Idle,
+        Stage_Queued,    // In one of the priority queues
+        Stage_Submitted, // Being transferred by the backend
+        Stage_Cancelling // Submitted, and asked to cancel
+    };
+
+
+
+    struct Completion
+    {
+        Cedar::FileIO::CompletionFunc function;
+        void*                         data;
+        Result                        result;
+    };
+
+
+
+    struct FileIOData
+    {
+        std::mutex              mutex;
+        std::condition_variable workCondition; // Signaled when a request is queued, for the pool
+        std::condition_variable doneCondition; // Signaled when a request is done
+        bool                    stopping = false;
+
+        std::array<Deque<Request*>, priorityCount> queues; // By priority
+        Vector<Request*>                           cancellations;   // For the ring, to cancel in flight
+        Vector<Completion>                         completions;     // Callbacks waiting for dispatch
+        Vector<Completion>                         dispatching;     // Only touched by dispatchCompletions
+
+        std::once_flag           startFlag;
+        Backend                  backend = Backend::Thread_Pool;
+        std::vector<std::thread> threads;
+    };
+
+
+
+    void startBackend();
+
+    void queueRequest(Request& request, const Cedar::FileIO::File& file, std::uint64_t offset, std::byte* buffer,
+                      std::size_t size, bool isWrite, Priority priority, Cedar::FileIO::CompletionFunc function, void* data);
+
+    // Takes the oldest request of the highest priority and marks it submitted. The mutex
+    // must be held.
+    Request* takeRequest();
+
+    // Publishes the result and queues the callback. The mutex must be held, and the
+    // request may not be touched afterwards since its owner may reuse it right away.
+    void finishRequest(Request& request, Status status, std::size_t bytes, std::error_code error);
+
+    void poolThreadMain(std::size_t threadIndex);
+
+
+    // OS-specific, implemented at the end of the file
+
+    // Starts the io_uring thread. Returns false if io_uring isn't available.
+    bool startRing();
+
+    // Wakes the io_uring thread to submit new requests or cancellations.
+    void wakeRing();
+
+    // Transfers the whole request with blocking calls. Returns the error, if any, and
+    // sets transferred.
+    std::error_code transferBlocking(Request::State& state);
+}
+
+
+
+// Nifty counter internal details
+namespace
+{
+    static typename std::aligned_storage<sizeof(FileIOData), alignof(FileIOData)>::type g_fileIODataBuffer;
+
+    FileIOData& g_fileIOData = reinterpret_cast<FileIOData&>(g_fileIODataBuffer);
+}
+
+
+
+namespace Cedar::FileIO
+{
+    std::size_t FileIOInitializer::s_counter = 0;
+
+
+
+    FileIOInitializer::FileIOInitializer()
+    {
+        if (s_counter == 0)
+            new (&g_fileIOData)FileIOData();
+
+        s_counter++;
+    }
+
+
+
+    FileIOInitializer::~FileIOInitializer()
+    {
+        s_counter--;
+
+        if (s_counter == 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(g_fileIOData.mutex);
+                g_fileIOData.stopping = true;
+
+                // The threads finish what they started, queued requests are cancelled
+                while (Request* request = takeRequest())
+                    finishRequest(*request, Status::Cancelled, 0, std::error_code());
+            }
+
+            g_fileIOData.workCondition.notify_all();
+
+            if (g_fileIOData.backend == Backend::Io_Uring)
+                wakeRing();
+
+            for (std::thread& thread : g_fileIOData.threads)
+                thread.join();
+
+            g_fileIOData.~FileIOData();
+        }
+    }
+}
+// Nifty counter internal details
+
+
+
+// OS-agnostic implementation
+namespace
+{
+    void startBackend()
+    {
+        std::call_once(g_fileIOData.startFlag, []() {
+            if (startRing())
+            {
+                g_fileIOData.backend = Backend::Io_Uring;
+                CEDAR_LOG(Cedar::Log::ioCategory, Debug, "File I/O uses io_uring");
+                return;
+            }
+
+            g_fileIOData.backend = Backend::Thread_Pool;
+            g_fileIOData.threads.reserve(poolThreadCount);
+
+            for (std::size_t i = 0; i < poolThreadCount; i++)
+                g_fileIOData.threads.emplace_back(poolThreadMain, i);
+
+            CEDAR_LOG(Cedar::Log::ioCategory, Debug, std::format("File I/O uses {} thread(s)", poolThreadCount));
+        });
+    }
+
+
+
+    void queueRequest(Request& request, const Cedar::FileIO::File& file, std::uint64_t offset, std::byte* buffer,
+                      std::size_t size, bool isWrite, Priority priority, Cedar::FileIO::CompletionFunc function, void* data)
+    {
+        if (!file.isOpen())
+            throw std::logic_error("File isn't open");
+
+        if (request.getStatus() == Status::Pending)
+            throw std::logic_error("Request is already pending");
+
+        startBackend();
+
+        Request::State& state = RequestAccess::getState(request);
+
+        state.file        = file.getNativeHandle();
+        state.offset      = offset;
+        state.buffer      = buffer;
+        state.size        = size;
+        state.transferred = 0;
+        state.isWrite     = isWrite;
+        state.priority    = priority;
+        state.function    = function;
+        state.data        = data;
+        state.generation++;
+
+        RequestAccess::getResult(request) = Result();
+
+        bool wasEmpty;
+
+        {
+            std::lock_guard<std::mutex> lock(g_fileIOData.mutex);
+
+            if (g_fileIOData.stopping)
+            {
+                state.stage = Stage_Submitted;
+                finishRequest(request, Status::Cancelled, 0, std::error_code());
+                return;
+            }
+
+            wasEmpty = std::all_of(g_fileIOData.queues.begin(), g_fileIOData.queues.end(), [](const Deque<Request*>& queue) {
+                return queue.empty();
+            });
+
+            state.stage = Stage_Queued;
+            RequestAccess::getStatus(request).store(Status::Pending, std::memory_order_relaxed);
+            g_fileIOData.queues[static_cast<std::size_t>(priority)].push_back(&request);
+        }
+
+        if (g_fileIOData.backend == Backend::Thread_Pool)
+            g_fileIOData.workCondition.notify_one();
+        else if (wasEmpty)
+        {
+            // If the queues weren't empty the ring has queued requests it couldn't submit
+            // yet, and it takes more as soon as some of its requests complete
+            wakeRing();
+        }
+    }
+
+
+
+    Request* takeRequest()
+    {
+        for (std::size_t i = priorityCount; i-- > 0;)
+        {
+            Deque<Request*>& queue = g_fileIOData.queues[i];
+
+            if (!queue.empty())
+            {
+                Request* request = queue.front();
+                queue.pop_front();
+
+                RequestAccess::getState(*request).stage = Stage_Submitted;
+
+                return request;
+            }
+        }
+
+        return nullptr;
+    }
+
+
+
+    void finishRequest(Request& request, Status status, std::size_t bytes, std::error_code error)
+    {
+        Request::State& state = RequestAccess::getState(request);
+
+        if (state.stage == Stage_Cancelling)
+            std::erase(g_fileIOData.cancellations, &request);
+
+        state.stage = Stage_Idle;
+
+        Result& result = RequestAccess::getResult(request);
+        result.status = status;
+        result.bytes  = bytes;
+        result.error  = error;
+
+        if (state.function != nullptr)
+            g_fileIOData.completions.push_back({ state.function, state.data, result });
+
+        RequestAccess::getStatus(request).store(status, std::memory_order_release);
+
+        g_fileIOData.doneCondition.notify_all();
+    }
+
+
+
+
+
+
+    void poolThreadMain(std::size_t threadIndex)
+    {
+        std::string threadName = std::format("File I/O {}", threadIndex);
+        Cedar::Profiler::setThreadName(threadName.c_str());
+
+        std::unique_lock<std::mutex> lock(g_fileIOData.mutex);
+
+        while (!g_fileIOData.stopping)
+        {
+            Request* request = takeRequest();
+
+            if (request == nullptr)
+            {
+                g_fileIOData.workCondition.wait(lock);
+                continue;
+            }
+
+            lock.unlock();
+
+            Request::State& state = RequestAccess::getState(*request);
+            std::error_code error;
+
+            {
+                CEDAR_PROFILE_SCOPE(state.isWrite ? "File write" : "File read");
+                error = transferBlocking(state);
+            }
+
+            lock.lock();
+
+            finishRequest(*request, error ? Status::Failed : Status::Completed, state.transferred, error);
+        }
+    }
+}
+
+
+
+namespace Cedar::FileIO
+{
+    Backend getBackend()
+    {
+        startBackend();
+        return g_fileIOData.backend;
+    }
+
+
+
+    void read(const File& file, std::uint64_t offset, std::span<std::byte> buffer, Request& request, Priority priority,
+              CompletionFunc function, void* data)
+    {
+        queueRequest(request, file, offset, buffer.data(), buffer.size(), false, priority, function, data);
+    }
+
+
+
+    void write(const File& file, std::uint64_t offset, std::span<const std::byte> buffer, Request& request, Priority priority,
+               CompletionFunc function, void* data)
+    {
+        // Writes only ever read from the buffer
+        queueRequest(request, file, offset, const_cast<std::byte*>(buffer.data()), buffer.size(), true, priority, function, data);
+    }
+
+
+
+    bool cancel(Request& request)
+    {
+        Request::State& state = RequestAccess::getState(request);
+
+        {
+            std::lock_guard<std::mutex> lock(g_fileIOData.mutex);
+
+            if (request.getStatus() != Status::Pending)
+                return false;
+
+            if (state.stage == Stage_Queued)
+            {
+                std::erase(g_fileIOData.queues[static_cast<std::size_t>(state.priority)], &request);
+                finishRequest(request, Status::Cancelled, 0, std::error_code());
+
+                return true;
+            }
+
+            // The pool can't interrupt a blocking call
+            if (state.stage != Stage_Submitted || g_fileIOData.backend != Backend::Io_Uring)
+                return false;
+
+            state.stage = Stage_Cancelling;
+            g_fileIOData.cancellations.push_back(&request);
+        }
+
+        wakeRing();
+
+        return false;
+    }
+
+
+
+    void wait(const Request& request)
+    {
+        std::unique_lock<std::mutex> lock(g_fileIOData.mutex);
+
+        g_fileIOData.doneCondition.wait(lock, [&request]() {
+            return request.getStatus() != Status::Pending;
+        });
+    }
+
+
+
+    std::size_t dispatchCompletions()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        {
+            std::lock_guard<std::mutex> lock(g_fileIOData.mutex);
+
+            if (g_fileIOData.completions.empty())
+                return 0;
+
+            // Swapping keeps the capacity of both, so dispatching doesn't allocate
+            g_fileIOData.completions.swap(g_fileIOData.dispatching);
+        }
+
+        for (const Completion& completion : g_fileIOData.dispatching)
+            completion.function(completion.data, completion.result);
+
+        std::size_t count = g_fileIOData.dispatching.size();
+        g_fileIOData.dispatching.clear();
+
+        return count;
+    }
+
+
+
+    File::File() = default;
+
+
+
+    File::File(const std::filesystem::path& path, OpenMode mode)
+    {
+        open(path, mode);
+    }
+
+
+
+    File::~File()
+    {
+        close();
+    }
+}
+// OS-agnostic implementation
+
+
+
+// OS-specific implementation
+#if defined(CEDAR_OS_WINDOWS) // vvv Windows vvv
+
+#include "../platform/windows.h"
+
+
+
+namespace
+{
+    bool startRing()
+    {
+        return false;
+    }
+
+
+
+    void wakeRing() {}
+
+
+
+    std::error_code transferBlocking(Request::State& state)
+    {
+        HANDLE file = reinterpret_cast<HANDLE>(state.file);
+
+        while (state.transferred < state.size)
+        {
+            std::uint64_t offset = state.offset + state.transferred;
+            DWORD         size   = static_cast<DWORD>(std::min<std::size_t>(state.size - state.transferred, 1 << 30));
+            DWORD         done   = 0;
+
+            // Synchronous handles still take the position from the OVERLAPPED
+            OVERLAPPED overlapped = {};
+            overlapped.Offset     = static_cast<DWORD>(offset);
+            overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+            BOOL succeeded = state.isWrite ? WriteFile(file, state.buffer + state.transferred, size, &done, &overlapped)
+                                           : ReadFile(file, state.buffer + state.transferred, size, &done, &overlapped);
+
+            if (!succeeded)
+            {
+                DWORD error = GetLastError();
+
+                if (error == ERROR_HANDLE_EOF)
+                    break;
+
+                return std::error_code(static_cast<int>(error), std::system_category());
+            }
+
+            if (done == 0)
+                break;
+
+            state.transferred += done;
+        }
+
+        return std::error_code();
+    }
+}
+
+
+
+namespace Cedar::FileIO
+{
+    void File::open(const std::filesystem::path& path, OpenMode mode)
+    {
+        close();
+
+        DWORD access      = GENERIC_READ;
+        DWORD disposition = OPEN_EXISTING;
+
+        if (mode == OpenMode::Write)
+        {
+            access      = GENERIC_WRITE;
+            disposition = CREATE_ALWAYS;
+        }
+        else if (mode == OpenMode::Read_Write)
+        {
+            access      = GENERIC_READ | GENERIC_WRITE;
+            disposition = OPEN_ALWAYS;
+        }
+
+        HANDLE file = CreateFileW(path.c_str(), access, FILE_SHARE_READ, NULL, disposition, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::system_error(GetLastError(), std::system_category(), "Failed to open " + path.string());
+
+        m_handle = reinterpret_cast<std::intptr_t>(file);
+    }
+
+
+
+    void File::close()
+    {
+        if (m_handle != -1)
+            (void)CloseHandle(reinterpret_cast<HANDLE>(m_handle));
+
+        m_handle = -1;
+    }
+
+
+
+    std::uint64_t File::getSize() const
+    {
+        LARGE_INTEGER size;
+
+        if (!GetFileSizeEx(reinterpret_cast<HANDLE>(m_handle), &size))
+            throw std::system_error(GetLastError(), std::system_category(), "Failed to get the file size");
+
+        return static_cast<std::uint64_t>(size.QuadPart);
+    }
+}
+
+#elif defined(CEDAR_OS_LINUX) // vvv Linux vvv // ^^^ Windows ^^^
+
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+
+namespace
+{
+    struct Ring;
+
+
+
+    constexpr unsigned    ringEntries     = 64;
+    constexpr std::size_t maxRingInFlight = 32; // Leaves the rest of the queue to the priority queues
+
+    // User data of the operations that aren't requests. Requests are at least 8 byte aligned
+    constexpr std::uint64_t wakeTag   = 1;
+    constexpr std::uint64_t cancelTag = 2;
+
+    // User space addresses fit in the low 48 bits, the request's generation goes above them
+    constexpr int           generationShift = 48;
+    constexpr std::uint64_t addressMask     = (std::uint64_t(1) << generationShift) - 1;
+
+
+
+    struct Ring
+    {
+        int fd = -1;
+
+        void*       sqMap     = nullptr;
+        std::size_t sqMapSize = 0;
+        void*       cqMap     = nullptr;
+        std::size_t cqMapSize = 0;
+
+        io_uring_sqe* sqes        = nullptr;
+        std::size_t   sqesSize    = 0;
+        unsigned      sqEntries   = 0;
+        unsigned      sqMask      = 0;
+        unsigned*     sqHead      = nullptr; // Advanced by the kernel
+        unsigned*     sqTail      = nullptr;
+        unsigned      sqLocalTail = 0;
+
+        io_uring_cqe* cqes   = nullptr;
+        unsigned      cqMask = 0;
+        unsigned*     cqHead = nullptr;
+        unsigned*     cqTail = nullptr; // Advanced by the kernel
+    };
+
+
+
+    // Written once before the ring thread starts
+    int g_wakeEventFd = -1;
+
+
+
+    void ringThreadMain(Ring ring);
+
+    void destroyRing(Ring& ring);
+
+    // Returns null if the submission queue is full.
+    io_uring_sqe* getSqe(Ring& ring);
+
+    void prepareTransfer(io_uring_sqe& sqe, Request& request);
+
+    // The user data of the request's transfers, its address tagged with the generation of
+    // its current use, so that cancelling it can't hit a later use of the same request.
+    inline std::uint64_t getUserData(Request& request);
+
+    inline Request* getRequest(std::uint64_t userData);
+}
+
+
+
+namespace
+{
+    bool startRing()
+    {
+        io_uring_params params = {};
+        int             fd     = static_cast<int>(::syscall(__NR_io_uring_setup, ringEntries, &params));
+
+        if (fd < 0)
+        {
+            CEDAR_LOG(Cedar::Log::ioCategory, Debug, std::format("io_uring isn't available: {}", std::generic_category().message(errno)));
+            return false;
+        }
+
+        Ring ring;
+        ring.fd = fd;
+
+        // Fast poll came with 5.7, which has every operation used here
+        if ((params.features & IORING_FEAT_FAST_POLL) == 0)
+        {
+            CEDAR_LOG(Cedar::Log::ioCategory, Debug, "io_uring is too old, it needs Linux 5.7");
+            destroyRing(ring);
+            return false;
+        }
+
+        ring.sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring.cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        ring.sqesSize  = params.sq_entries * sizeof(io_uring_sqe);
+
+        if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+            ring.sqMapSize = ring.cqMapSize = std::max(ring.sqMapSize, ring.cqMapSize);
+
+        ring.sqMap = ::mmap(nullptr, ring.sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        ring.sqMap = (ring.sqMap == MAP_FAILED) ? nullptr : ring.sqMap;
+
+        if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+            ring.cqMap = ring.sqMap;
+        else
+        {
+            ring.cqMap = ::mmap(nullptr, ring.cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            ring.cqMap = (ring.cqMap == MAP_FAILED) ? nullptr : ring.cqMap;
+        }
+
+        void* sqes = ::mmap(nullptr, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        ring.sqes  = (sqes == MAP_FAILED) ? nullptr : static_cast<io_uring_sqe*>(sqes);
+
+        g_wakeEventFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+        if (ring.sqMap == nullptr || ring.cqMap == nullptr || ring.sqes == nullptr || g_wakeEventFd == -1)
+        {
+            CEDAR_LOG(Cedar::Log::ioCategory, Debug, std::format("Failed to set up io_uring: {}", std::generic_category().message(errno)));
+            destroyRing(ring);
+            return false;
+        }
+
+        std::byte* sq = static_cast<std::byte*>(ring.sqMap);
+        std::byte* cq = static_cast<std::byte*>(ring.cqMap);
+
+        ring.sqEntries   = params.sq_entries;
+        ring.sqMask      = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        ring.sqHead      = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        ring.sqTail      = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        ring.sqLocalTail = *ring.sqTail;
+        ring.cqes        = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        ring.cqMask      = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        ring.cqHead      = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        ring.cqTail      = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+
+        // Every queue entry always uses the sqe of the same index
+        unsigned* sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        for (unsigned i = 0; i < ring.sqEntries; i++)
+            sqArray[i] = i;
+
+        g_fileIOData.threads.emplace_back(ringThreadMain, ring);
+
+        return true;
+    }
+
+
+
+    void wakeRing()
+    {
+        std::uint64_t value = 1;
+        (void)::write(g_wakeEventFd, &value, sizeof(value));
+    }
+
+
+
+    std::error_code transferBlocking(Request::State& state)
+    {
+        int file = static_cast<int>(state.file);
+
+        while (state.transferred < state.size)
+        {
+            std::uint64_t offset = state.offset + state.transferred;
+            std::size_t   size   = std::min<std::size_t>(state.size - state.transferred, 1 << 30);
+
+            ssize_t done = state.isWrite ? ::pwrite(file, state.buffer + state.transferred, size, static_cast<off_t>(offset))
+                                         : ::pread(file, state.buffer + state.transferred, size, static_cast<off_t>(offset));
+
+            if (done < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                return std::error_code(errno, std::generic_category());
+            }
+
+            // End of file
+            if (done == 0)
+                break;
+
+            state.transferred += static_cast<std::size_t>(done);
+        }
+
+        return std::error_code();
+    }
+
+
+
+    void ringThreadMain(Ring ring)
+    {
+        Cedar::Profiler::setThreadName("File I/O ring");
+
+        Vector<Request*> resubmissions; // Partial transfers to continue
+        std::size_t      inFlight  = 0;
+        bool             wakeArmed = false;
+
+        while (true)
+        {
+            // Continuations go first, they were already counted as in flight
+            while (!resubmissions.empty())
+            {
+                io_uring_sqe* sqe = getSqe(ring);
+
+                if (sqe == nullptr)
+                    break;
+
+                prepareTransfer(*sqe, *resubmissions.back());
+                resubmissions.pop_back();
+            }
+
+            if (!wakeArmed)
+            {
+                if (io_uring_sqe* sqe = getSqe(ring))
+                {
+                    sqe->opcode        = IORING_OP_POLL_ADD;
+                    sqe->fd            = g_wakeEventFd;
+                    sqe->poll32_events = POLLIN;
+                    sqe->user_data     = wakeTag;
+
+                    wakeArmed = true;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(g_fileIOData.mutex);
+
+                if (g_fileIOData.stopping && inFlight == 0)
+                    break;
+
+                std::size_t cancelled = 0;
+
+                for (Request* request : g_fileIOData.cancellations)
+                {
+                    io_uring_sqe* sqe = getSqe(ring);
+
+                    // The rest are submitted on the next pass. Cancelling is best effort,
+                    // the request completes either way
+                    if (sqe == nullptr)
+                        break;
+
+                    sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+                    sqe->fd        = -1;
+                    sqe->addr      = getUserData(*request);
+                    sqe->user_data = cancelTag;
+                    cancelled++;
+                }
+
+                g_fileIOData.cancellations.erase(g_fileIOData.cancellations.begin(), g_fileIOData.cancellations.begin() + cancelled);
+
+                while (!g_fileIOData.stopping && inFlight < maxRingInFlight)
+                {
+                    io_uring_sqe* sqe = getSqe(ring);
+
+                    if (sqe == nullptr)
+                        break;
+
+                    Request* request = takeRequest();
+
+                    if (request == nullptr)
+                    {
+                        // Give the entry back
+                        ring.sqLocalTail--;
+                        break;
+                    }
+
+                    prepareTransfer(*sqe, *request);
+                    inFlight++;
+                }
+            }
+
+            std::atomic_ref<unsigned>(*ring.sqTail).store(ring.sqLocalTail, std::memory_order_release);
+
+            unsigned toSubmit = ring.sqLocalTail - std::atomic_ref<unsigned>(*ring.sqHead).load(std::memory_order_acquire);
+
+            if (::syscall(__NR_io_uring_enter, ring.fd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0)
+            {
+                if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                    CEDAR_LOG(Cedar::Log::ioCategory, Error, std::format("io_uring_enter failed: {}", std::generic_category().message(errno)));
+
+                // Whatever wasn't submitted stays queued and goes with the next call
+                if (errno != EINTR)
+                    std::this_thread::yield();
+            }
+
+            unsigned head = *ring.cqHead;
+            unsigned tail = std::atomic_ref<unsigned>(*ring.cqTail).load(std::memory_order_acquire);
+
+            if (head == tail)
+                continue;
+
+            {
+                std::lock_guard<std::mutex> lock(g_fileIOData.mutex);
+
+                for (; head != tail; head++)
+                {
+                    const io_uring_cqe& cqe = ring.cqes[head & ring.cqMask];
+
+                    if (cqe.user_data == wakeTag)
+                    {
+                        std::uint64_t value;
+                        (void)::read(g_wakeEventFd, &value, sizeof(value));
+
+                        wakeArmed = false;
+                        continue;
+                    }
+
+                    if (cqe.user_data == cancelTag)
+                        continue;
+
+                    Request*        request = getRequest(cqe.user_data);
+                    Request::State& state   = RequestAccess::getState(*request);
+
+                    if (cqe.res < 0)
+                    {
+                        Status status = (cqe.res == -ECANCELED || cqe.res == -EINTR) ? Status::Cancelled : Status::Failed;
+
+                        finishRequest(*request, status, state.transferred, std::error_code(-cqe.res, std::generic_category()));
+                        inFlight--;
+                        continue;
+                    }
+
+                    state.transferred += static_cast<std::size_t>(cqe.res);
+
+                    // Short transfers happen for huge requests and signals, 0 is the end
+                    // of the file
+                    bool isShort = cqe.res > 0 && state.transferred < state.size;
+
+                    if (isShort && state.stage != Stage_Cancelling)
+                    {
+                        resubmissions.push_back(request);
+                        continue;
+                    }
+
+                    // Cut short by the cancellation rather than done
+                    Status status = (isShort && state.stage == Stage_Cancelling) ? Status::Cancelled : Status::Completed;
+
+                    finishRequest(*request, status, state.transferred, std::error_code());
+                    inFlight--;
+                }
+            }
+
+            std::atomic_ref<unsigned>(*ring.cqHead).store(head, std::memory_order_release);
+        }
+
+        destroyRing(ring);
+    }
+
+
+
+    void destroyRing(Ring& ring)
+    {
+        if (ring.sqes != nullptr)
+            (void)::munmap(ring.sqes, ring.sqesSize);
+
+        if (ring.cqMap != nullptr && ring.cqMap != ring.sqMap)
+            (void)::munmap(ring.cqMap, ring.cqMapSize);
+
+        if (ring.sqMap != nullptr)
+            (void)::munmap(ring.sqMap, ring.sqMapSize);
+
+        if (g_wakeEventFd != -1)
+            (void)::close(g_wakeEventFd);
+
+        (void)::close(ring.fd);
+
+        g_wakeEventFd = -1;
+    }
+
+
+
+    io_uring_sqe* getSqe(Ring& ring)
+    {
+        unsigned head = std::atomic_ref<unsigned>(*ring.sqHead).load(std::memory_order_acquire);
+
+        if (ring.sqLocalTail - head >= ring.sqEntries)
+            return nullptr;
+
+        io_uring_sqe* sqe = &ring.sqes[ring.sqLocalTail & ring.sqMask];
+        ring.sqLocalTail++;
+
+        std::memset(sqe, 0, sizeof(*sqe));
+
+        return sqe;
+    }
+
+
+
+    void prepareTransfer(io_uring_sqe& sqe, Request& request)
+    {
+        Request::State& state = RequestAccess::getState(request);
+
+        sqe.opcode    = state.isWrite ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe.fd        = static_cast<int>(state.file);
+        sqe.off       = state.offset + state.transferred;
+        sqe.addr      = reinterpret_cast<std::uint64_t>(state.buffer + state.transferred);
+        sqe.len       = static_cast<std::uint32_t>(std::min<std::size_t>(state.size - state.transferred, 1 << 30));
+        sqe.user_data = getUserData(request);
+    }
+
+
+
+    inline std::uint64_t getUserData(Request& request)
+    {
+        std::uint64_t address = reinterpret_cast<std::uint64_t>(&request);
+
+        return address | (static_cast<std::uint64_t>(RequestAccess::getState(request).generation) << generationShift);
+    }
+
+
+
+    inline Request* getRequest(std::uint64_t userData)
+    {
+        return reinterpret_cast<Request*>(userData & addressMask);
+    }
+}
+
+
+
+namespace Cedar::FileIO
+{
+    void File::open(const std::filesystem::path& path, OpenMode mode)
+    {
+        close();
+
+        int flags = O_RDONLY;
+
+        if (mode == OpenMode::Write)
+            flags = O_WRONLY | O_CREAT | O_TRUNC;
+        else if (mode == OpenMode::Read_Write)
+            flags = O_RDWR | O_CREAT;
+
+        int file = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+
+        if (file == -1)
+            throw std::system_error(errno, std::generic_category(), "Failed to open " + path.string());
+
+        m_handle = file;
+    }
+
+
+
+    void File::close()
+    {
+        if (m_handle != -1)
+            (void)::close(static_cast<int>(m_handle));
+
+        m_handle = -1;
+    }
+
+
+
+    std::uint64_t File::getSize() const
+    {
+        struct stat status;
+
+        if (::fstat(static_cast<int>(m_handle), &status) == -1)
+            throw std::system_error(errno, std::generic_category(), "Failed to get the file size");
+
+        return static_cast<std::uint64_t>(status.st_size);
+    }
+}
+
+#endif // ^^^ Linux ^^^
+// OS-specific implementation
\ No newline at end of file
@@ -0,0 +1,347 @@
+//
+// Asynchronous file I/O.
+//
+// Reads and writes are queued as requests and return right away. On Linux they're
+// submitted in batches to an io_uring by a dedicated thread: every request queued since
+// the last submission goes to the kernel with a single system call, and the thread
+// sleeps in the same call until something completes or more requests arrive. Where
+// io_uring isn't available (old kernels, sandboxes that block it, and Windows) a small
+// pool of I/O threads performs the transfers with blocking positional reads and
+// writes. Blocking I/O stays off the job system's workers either way.
+//
+// Requests are taken in priority order, oldest first within a priority. A request that
+// hasn't been started yet can always be cancelled; io_uring also tries to cancel one
+// that's in progress.
+//
+// A request is owned by the caller, who polls it, waits for it, or gets a callback.
+// Callbacks aren't run on the I/O threads but by dispatchCompletions, which the main
+// loop calls once per frame, so they may touch whatever the main thread owns.
+//
+
+#ifndef CEDAR_IO_FILE_IO_H
+#define CEDAR_IO_FILE_IO_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+
+
+namespace Cedar::FileIO
+{
+    // Nifty counter. For internal use only
+    class FileIOInitializer
+    {
+    public:
+
+        FileIOInitializer();
+
+        ~FileIOInitializer();
+
+    private:
+
+        static std::size_t s_counter;
+    };
+
+
+
+    // Nifty counter. For internal use only
+    static FileIOInitializer fileIOInitializer;
+
+
+
+    enum class Backend;
+
+    enum class OpenMode;
+
+    enum class Priority;
+
+    enum class Status;
+
+    struct Result;
+
+    class File;
+
+    class Request;
+
+
+
+    typedef void (*CompletionFunc)(void* data, const Result& result);
+
+
+
+    enum class Backend {
+        Io_Uring,
+        Thread_Pool
+    };
+
+
+
+    enum class OpenMode {
+        Read,
+        Write,     // Creates the file, or empties it if it exists
+        Read_Write // Creates the file if it doesn't exist
+    };
+
+
+
+    enum class Priority {
+        Low,
+        Normal,
+        High
+    };
+
+
+
+    enum class Status {
+        Idle,      // Never queued
+        Pending,   // Queued or in progress
+        Completed,
+        Failed,
+        Cancelled
+    };
+
+
+
+    struct Result
+    {
+        Status          status = Status::Idle;
+        std::size_t     bytes  = 0;  // Transferred, fewer than asked for if a read hit the end of the file
+        std::error_code error;       // Set if the request failed
+    };
+
+
+
+    // A file opened for asynchronous I/O. It must stay open while requests on it are
+    // pending.
+    class File
+    {
+    public:
+
+        File();
+
+        // Opens the file, see open.
+        File(const std::filesystem::path& path, OpenMode mode);
+
+        ~File();
+
+
+        File(const File&) = delete;
+
+        File& operator=(const File&) = delete;
+
+
+        // Closes the file that was open. Throws std::system_error if the file can't be
+        // opened.
+        void open(const std::filesystem::path& path, OpenMode mode);
+
+        void close();
+
+        inline bool isOpen() const;
+
+
+        // Throws std::system_error if the size can't be queried.
+        std::uint64_t getSize() const;
+
+
+        // For internal use only. A file descriptor on Linux, a HANDLE on Windows.
+        inline std::intptr_t getNativeHandle() const;
+
+    private:
+
+        std::intptr_t m_handle = -1;
+    };
+
+
+
+    // A read or write. It must stay alive and untouched while it's pending, and may be
+    // reused once it's done.
+    class Request
+    {
+    public:
+
+        inline Request() {}
+
+
+        Request(const Request&) = delete;
+
+        Request& operator=(const Request&) = delete;
+
+
+        inline Status getStatus() const;
+
+        // Completed, failed or cancelled.
+        inline bool isDone() const;
+
+        // Only meaningful once the request is done.
+        inline const Result& getResult() const;
+
+
+        // For internal use only. Owned by the I/O threads while the request is pending.
+        struct State
+        {
+            std::intptr_t  file        = -1;
+            std::uint64_t  offset      = 0;
+            std::byte*     buffer      = nullptr;
+            std::size_t    size        = 0;
+            std::size_t    transferred = 0;
+            bool           isWrite     = false;
+            Priority       priority    = Priority::Normal;
+            CompletionFunc function    = nullptr;
+            void*          data        = nullptr;
+            int            stage       = 0;
+            std::uint16_t  generation  = 0; // Counts the uses of the request, to tell their submissions apart
+        };
+
+    private:
+
+        friend struct RequestAccess;
+
+
+        State  m_state;
+        Result m_result; // Written before the status is published
+
+        std::atomic<Status> m_status = Status::Idle;
+    };
+
+
+
+    // Which backend the requests are going to, starting it if needed.
+    Backend getBackend();
+
+
+    // Queues a read of buffer.size() bytes at the offset into the buffer. The buffer must
+    // stay alive until the request is done. Throws std::logic_error if the file isn't
+    // open or the request is pending.
+    void read(const File& file, std::uint64_t offset, std::span<std::byte> buffer, Request& request,
+              Priority priority = Priority::Normal, CompletionFunc function = nullptr, void* data = nullptr);
+
+    // Queues a read that calls a copy of any callable taking a const Result& from
+    // dispatchCompletions once it's done.
+    template <typename TFunction>
+    void read(const File& file, std::uint64_t offset, std::span<std::byte> buffer, Request& request, Priority priority,
+              TFunction&& function);
+
+    // Like read, but writes the buffer to the file.
+    void write(const File& file, std::uint64_t offset, std::span<const std::byte> buffer, Request& request,
+               Priority priority = Priority::Normal, CompletionFunc function = nullptr, void* data = nullptr);
+
+    template <typename TFunction>
+    void write(const File& file, std::uint64_t offset, std::span<const std::byte> buffer, Request& request, Priority priority,
+               TFunction&& function);
+
+
+    // Returns true if the request hadn't been started yet and is now cancelled. A request
+    // in progress finishes as usual, unless io_uring manages to cancel it; its status
+    // tells either way.
+    bool cancel(Request& request);
+
+    // Returns once the request is done. Blocks the calling thread, meant for loading
+    // screens and shutdown rather than the frame loop.
+    void wait(const Request& request);
+
+    // Runs the callbacks of the requests that are done since the last call, on the
+    // calling thread. Returns how many ran.
+    std::size_t dispatchCompletions();
+
+
+
+    // vvv File function definitions vvv
+
+    inline bool File::isOpen() const
+    {
+        return m_handle != -1;
+    }
+
+
+
+    inline std::intptr_t File::getNativeHandle() const
+    {
+        return m_handle;
+    }
+
+    // ^^^ File function definitions ^^^
+
+
+
+    // vvv Request function definitions vvv
+
+    inline Status Request::getStatus() const
+    {
+        return m_status.load(std::memory_order_acquire);
+    }
+
+
+
+    inline bool Request::isDone() const
+    {
+        Status status = getStatus();
+        return status != Status::Idle && status != Status::Pending;
+    }
+
+
+
+    inline const Result& Request::getResult() const
+    {
+        return m_result;
+    }
+
+    // ^^^ Request function definitions ^^^
+
+
+
+    template <typename TFunction>
+    void read(const File& file, std::uint64_t offset, std::span<std::byte> buffer, Request& request, Priority priority,
+              TFunction&& function)
+    {
+        typedef std::decay_t<TFunction> Function;
+
+        Function* copy = new Function(std::forward<TFunction>(function));
+
+        try
+        {
+            read(file, offset, buffer, request, priority, [](void* data, const Result& result) {
+                Function* function = static_cast<Function*>(data);
+
+                (*function)(result);
+                delete function;
+            }, copy);
+        }
+        catch (...) {
+            delete copy;
+            throw;
+        }
+    }
+
+
+
+    template <typename TFunction>
+    void write(const File& file, std::uint64_t offset, std::span<const std::byte> buffer, Request& request, Priority priority,
+               TFunction&& function)
+    {
+        typedef std::decay_t<TFunction> Function;
+
+        Function* copy = new Function(std::forward<TFunction>(function));
+
+        try
+        {
+            write(file, offset, buffer, request, priority, [](void* data, const Result& result) {
+                Function* function = static_cast<Function*>(data);
+
+                (*function)(result);
+                delete function;
+            }, copy);
+        }
+        catch (...) {
+            delete copy;
+            throw;
+        }
+    }
+}
+
+#endif // CEDAR_IO_FILE_IO_H
\ No newline at end of file
@@ -0,0 +1,447 @@
+#include "file_watcher.h"
+
+#include "../core.h"
+#include "../debug/profiler.h"
+#include "log.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+
+// OS-specific definition of FileWatcher::PlatformData
+#if defined(CEDAR_OS_WINDOWS) // vvv Windows vvv
+
+#include "../platform/windows.h"
+
+#include <algorithm>
+#include <format>
+#include <string_view>
+
+
+
+namespace Cedar::FileIO
+{
+    // The OS-specific handles, and the watching thread's loop
+    struct FileWatcher::PlatformData
+    {
+    public:
+
+        // Throws std::system_error if the directory can't be watched.
+        explicit PlatformData(const std::filesystem::path& directory);
+
+        ~PlatformData();
+
+
+        // Runs until stop is called.
+        void run(FileWatcher& watcher);
+
+        void stop();
+
+    private:
+
+        HANDLE     m_directoryHandle = INVALID_HANDLE_VALUE;
+        HANDLE     m_stopEvent       = NULL;
+        OVERLAPPED m_overlapped      = {};
+
+        alignas(DWORD) std::array<std::byte, 64 * 1024> m_buffer;
+    };
+}
+
+#elif defined(CEDAR_OS_LINUX) // vvv Linux vvv // ^^^ Windows ^^^
+
+#include <cerrno>
+#include <format>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+
+
+namespace Cedar::FileIO
+{
+    // The OS-specific handles, and the watching thread's loop
+    struct FileWatcher::PlatformData
+    {
+    public:
+
+        // Throws std::system_error if the directory can't be watched.
+        explicit PlatformData(const std::filesystem::path& directory);
+
+        ~PlatformData();
+
+
+        // Runs until stop is called.
+        void run(FileWatcher& watcher);
+
+        void stop();
+
+    private:
+
+        std::filesystem::path                m_directory;
+        int                                  m_inotifyFd = -1;
+        int                                  m_stopFd    = -1;
+        std::unordered_map<int, std::string> m_watchedDirectories; // By watch descriptor
+
+
+        // Watches the directory, relative to the root, and the ones below it. Throws
+        // std::system_error if the root can't be watched.
+        void addWatches(const std::string& relativePath);
+    };
+}
+
+#endif // ^^^ Linux ^^^
+// OS-specific definition of FileWatcher::PlatformData
+
+
+
+// OS-agnostic implementation
+namespace Cedar::FileIO
+{
+    FileWatcher::FileWatcher(const std::filesystem::path& directory, std::uint64_t debounceTime) :
+        m_directory(directory),
+        m_debounceTime(debounceTime),
+        m_platform(std::make_unique<PlatformData>(directory))
+    {
+        m_thread = std::thread([this]() {
+            Cedar::Profiler::setThreadName("File watcher");
+            m_platform->run(*this);
+        });
+    }
+
+
+
+    FileWatcher::~FileWatcher()
+    {
+        m_platform->stop();
+        m_thread.join();
+    }
+
+
+
+    std::size_t FileWatcher::takeChanges(std::vector<std::string>& paths)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Read the time under the lock so no recorded change can be newer than it
+        std::uint64_t now   = Cedar::Profiler::getTimestamp();
+        std::size_t   count = 0;
+
+        for (auto it = m_changes.begin(); it != m_changes.end();)
+        {
+            if (now - it->second < m_debounceTime)
+            {
+                ++it;
+                continue;
+            }
+
+            paths.push_back(it->first);
+            it = m_changes.erase(it);
+            count++;
+        }
+
+        return count;
+    }
+
+
+
+    void FileWatcher::recordChange(std::string path)
+    {
+        std::uint64_t now = Cedar::Profiler::getTimestamp();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_changes.insert_or_assign(std::move(path), now);
+    }
+}
+// OS-agnostic implementation
+
+
+
+// OS-specific implementation
+#if defined(CEDAR_OS_WINDOWS) // vvv Windows vvv
+
+namespace
+{
+    constexpr DWORD notifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                                   FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+}
+
+
+
+namespace Cedar::FileIO
+{
+    FileWatcher::PlatformData::PlatformData(const std::filesystem::path& directory)
+    {
+        m_directoryHandle = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                        NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+
+        if (m_directoryHandle == INVALID_HANDLE_VALUE)
+            throw std::system_error(GetLastError(), std::system_category(), "Failed to watch " + directory.string());
+
+        m_stopEvent         = CreateEventW(NULL, TRUE, FALSE, NULL);
+        m_overlapped.hEvent  = CreateEventW(NULL, TRUE, FALSE, NULL);
+
+        if (m_stopEvent == NULL || m_overlapped.hEvent == NULL)
+        {
+            DWORD error = GetLastError();
+
+            if (m_overlapped.hEvent != NULL)
+                (void)CloseHandle(m_overlapped.hEvent);
+
+            if (m_stopEvent != NULL)
+                (void)CloseHandle(m_stopEvent);
+
+            (void)CloseHandle(m_directoryHandle);
+            throw std::system_error(error, std::system_category(), "Failed to create file watcher events");
+        }
+    }
+
+
+
+    FileWatcher::PlatformData::~PlatformData()
+    {
+        if (m_overlapped.hEvent != NULL)
+            (void)CloseHandle(m_overlapped.hEvent);
+
+        if (m_stopEvent != NULL)
+            (void)CloseHandle(m_stopEvent);
+
+        (void)CloseHandle(m_directoryHandle);
+    }
+
+
+
+    void FileWatcher::PlatformData::run(FileWatcher& watcher)
+    {
+        while (true)
+        {
+            (void)ResetEvent(m_overlapped.hEvent);
+
+            if (!ReadDirectoryChangesW(m_directoryHandle, m_buffer.data(), static_cast<DWORD>(m_buffer.size()), TRUE, notifyFilter,
+                                       NULL, &m_overlapped, NULL))
+            {
+                CEDAR_LOG(Cedar::Log::ioCategory, Error, std::format("File watcher stopped: {}", std::system_category().message(GetLastError())));
+                return;
+            }
+
+            HANDLE handles[] = { m_overlapped.hEvent, m_stopEvent };
+            DWORD  waited    = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            DWORD  size      = 0;
+
+            if (waited != WAIT_OBJECT_0)
+            {
+                // The buffer has to outlive the read
+                (void)CancelIoEx(m_directoryHandle, &m_overlapped);
+                (void)GetOverlappedResult(m_directoryHandle, &m_overlapped, &size, TRUE);
+                return;
+            }
+
+            if (!GetOverlappedResult(m_directoryHandle, &m_overlapped, &size, FALSE))
+            {
+                CEDAR_LOG(Cedar::Log::ioCategory, Error, std::format("File watcher stopped: {}", std::system_category().message(GetLastError())));
+                return;
+            }
+
+            // The buffer overflowed and the changes are lost
+            if (size == 0)
+            {
+                CEDAR_LOG(Cedar::Log::ioCategory, Warning, "File watcher missed changes, too many happened at once");
+                continue;
+            }
+
+            for (std::size_t offset = 0;;)
+            {
+                const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(m_buffer.data() + offset);
+
+                std::wstring_view name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                std::string       path;
+
+                if (Cedar::Platform::Windows::tryWideStringToString(name, path))
+                {
+                    std::replace(path.begin(), path.end(), '\\', '/');
+                    watcher.recordChange(std::move(path));
+                }
+
+                if (info->NextEntryOffset == 0)
+                    break;
+
+                offset += info->NextEntryOffset;
+            }
+        }
+    }
+
+
+
+    void FileWatcher::PlatformData::stop()
+    {
+        (void)SetEvent(m_stopEvent);
+    }
+}
+
+#elif defined(CEDAR_OS_LINUX) // vvv Linux vvv // ^^^ Windows ^^^
+
+namespace
+{
+    // Written, created, renamed or deleted, and modifications so bursts of writes keep
+    // pushing the debounce back
+    constexpr std::uint32_t watchMask = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                        IN_ONLYDIR;
+}
+
+
+
+namespace Cedar::FileIO
+{
+    FileWatcher::PlatformData::PlatformData(const std::filesystem::path& directory) : m_directory(directory)
+    {
+        m_inotifyFd = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+
+        if (m_inotifyFd == -1)
+            throw std::system_error(errno, std::generic_category(), "Failed to create inotify instance");
+
+        m_stopFd = ::eventfd(0, EFD_CLOEXEC);
+
+        if (m_stopFd == -1)
+        {
+            int error = errno;
+            (void)::close(m_inotifyFd);
+            throw std::system_error(error, std::generic_category(), "Failed to create file watcher event");
+        }
+
+        try
+        {
+            addWatches(std::string());
+        }
+        catch (...) {
+            (void)::close(m_stopFd);
+            (void)::close(m_inotifyFd);
+            throw;
+        }
+    }
+
+
+
+    FileWatcher::PlatformData::~PlatformData()
+    {
+        (void)::close(m_stopFd);
+        (void)::close(m_inotifyFd);
+    }
+
+
+
+    void FileWatcher::PlatformData::run(FileWatcher& watcher)
+    {
+        alignas(inotify_event) std::array<char, 16 * 1024> buffer;
+
+        while (true)
+        {
+            pollfd fds[] = { { m_inotifyFd, POLLIN, 0 }, { m_stopFd, POLLIN, 0 } };
+
+            if (::poll(fds, 2, -1) == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                CEDAR_LOG(Cedar::Log::ioCategory, Error, std::format("File watcher stopped: {}", std::generic_category().message(errno)));
+                return;
+            }
+
+            if (fds[1].revents != 0)
+                return;
+
+            ssize_t size;
+
+            while ((size = ::read(m_inotifyFd, buffer.data(), buffer.size())) > 0)
+            {
+                for (ssize_t offset = 0; offset < size;)
+                {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+                    offset += sizeof(inotify_event) + event->len;
+
+                    if ((event->mask & IN_Q_OVERFLOW) != 0)
+                    {
+                        CEDAR_LOG(Cedar::Log::ioCategory, Warning, "File watcher missed changes, too many happened at once");
+                        continue;
+                    }
+
+                    // The directory is gone
+                    if ((event->mask & IN_IGNORED) != 0)
+                    {
+                        m_watchedDirectories.erase(event->wd);
+                        continue;
+                    }
+
+                    auto it = m_watchedDirectories.find(event->wd);
+
+                    if (it == m_watchedDirectories.end() || event->len == 0)
+                        continue;
+
+                    std::string path = it->second.empty() ? std::string(event->name) : it->second + '/' + event->name;
+
+                    if ((event->mask & IN_ISDIR) != 0)
+                    {
+                        if ((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0)
+                            addWatches(path);
+
+                        continue;
+                    }
+
+                    watcher.recordChange(std::move(path));
+                }
+            }
+        }
+    }
+
+
+
+    void FileWatcher::PlatformData::stop()
+    {
+        std::uint64_t value = 1;
+        (void)::write(m_stopFd, &value, sizeof(value));
+    }
+
+
+
+    void FileWatcher::PlatformData::addWatches(const std::string& relativePath)
+    {
+        std::filesystem::path path = relativePath.empty() ? m_directory : m_directory / relativePath;
+        int                   wd   = ::inotify_add_watch(m_inotifyFd, path.c_str(), watchMask);
+
+        if (wd == -1)
+        {
+            if (relativePath.empty())
+                throw std::system_error(errno, std::generic_category(), "Failed to watch " + path.string());
+
+            // Subdirectories can disappear before they're watched
+            return;
+        }
+
+        m_watchedDirectories[wd] = relativePath;
+
+        std::error_code                     error;
+        std::filesystem::directory_iterator it(path, error);
+
+        for (; !error && it != std::filesystem::directory_iterator(); it.increment(error))
+        {
+            if (it->is_directory(error) && !it->is_symlink(error))
+            {
+                std::string name = it->path().filename().string();
+                addWatches(relativePath.empty() ? name : relativePath + '/' + name);
+            }
+        }
+    }
+}
+
+#endif // ^^^ Linux ^^^
+// OS-specific implementation
\ No newline at end of file
@@ -0,0 +1,88 @@
+//
+// File change watching.
+//
+// Watches a directory and everything below it for files that are written, created,
+// renamed or deleted, with inotify on Linux and ReadDirectoryChangesW on Windows, from
+// a background thread. Editors and exporters tend to touch a file several times in a
+// burst, so a change is only handed out once the file has been left alone for the
+// debounce time, and then only once no matter how many events it took.
+//
+
+#ifndef CEDAR_IO_FILE_WATCHER_H
+#define CEDAR_IO_FILE_WATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace Cedar::FileIO
+{
+    class FileWatcher;
+
+
+
+    constexpr std::uint64_t defaultDebounceTime = 100'000'000; // 100 ms, in nanoseconds
+
+
+
+    class FileWatcher
+    {
+    public:
+
+        // Starts watching. Throws std::system_error if the directory can't be watched.
+        explicit FileWatcher(const std::filesystem::path& directory, std::uint64_t debounceTime = defaultDebounceTime);
+
+        ~FileWatcher();
+
+
+        FileWatcher(const FileWatcher&) = delete;
+
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+
+        inline const std::filesystem::path& getDirectory() const;
+
+        // Appends the files whose changes have settled, relative to the directory with '/'
+        // separators, and forgets them. Returns how many were appended.
+        std::size_t takeChanges(std::vector<std::string>& paths);
+
+    private:
+
+        struct PlatformData;
+
+
+        std::filesystem::path m_directory;
+        std::uint64_t         m_debounceTime;
+
+        std::mutex                                     m_mutex;
+        std::unordered_map<std::string, std::uint64_t> m_changes; // Time of each file's latest event
+
+        std::unique_ptr<PlatformData> m_platform;
+        std::thread                   m_thread;
+
+
+        // Called from the watching thread.
+        void recordChange(std::string path);
+    };
+
+
+
+    // vvv FileWatcher function definitions vvv
+
+    inline const std::filesystem::path& FileWatcher::getDirectory() const
+    {
+        return m_directory;
+    }
+
+    // ^^^ FileWatcher function definitions ^^^
+}
+
+#endif // CEDAR_IO_FILE_WATCHER_H
\ No newline at end of file
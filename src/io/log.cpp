@@ -2,30 +2,103 @@
 
 #include "terminal.h"
 #include "../core.h"
+#include "../debug/profiler.h"
+#include "../string_id.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <format>
+#include <mutex>
 #include <new>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <vector>
 
 
 
 namespace
 {
+    constexpr std::size_t maxRecordLength = Cedar::Log::historyTextCapacity / 16;
+    constexpr std::size_t repeatSlotCount = 256;
+
+
+
+    struct HistoryEntry;
+
+    struct RepeatSlot;
+
+    struct DroppedRepeats;
+
     struct LogData;
 
 
 
+    struct HistoryEntry
+    {
+        std::uint64_t     sequence;
+        Cedar::Log::Level level;
+        std::uint32_t     textOffset;
+        std::uint32_t     textLength;
+    };
+
+
+
+    struct RepeatSlot
+    {
+        const Cedar::Log::Category* category = nullptr; // Null if the slot is free
+        Cedar::Log::Level           level;
+        std::uint64_t               hash;               // Of the category, level and text
+        std::string                 text;               // To report the drops with
+        std::uint64_t               windowStart;
+        std::uint64_t               interval;
+        std::size_t                 count;              // Let through since windowStart
+        std::size_t                 dropped;            // Since windowStart
+    };
+
+
+
+    // Drops taken from a slot, reported once the repeat lock is released.
+    struct DroppedRepeats
+    {
+        const Cedar::Log::Category* category;
+        Cedar::Log::Level           level;
+        std::string                 text;
+        std::size_t                 count;
+    };
+
+
+
     struct LogData
     {
-    #if defined(CEDAR_DEBUG)
-        Cedar::Log::Level minLevel = Cedar::Log::Level::Trace;
-    #else
-        Cedar::Log::Level minLevel = Cedar::Log::Level::Info;
-    #endif
+        std::atomic<Cedar::Log::Level> minLevel = Cedar::Log::defaultMinLevel;
+
+        std::mutex            categoryMutex;
+        Cedar::Log::Category* firstCategory = nullptr;
+
+        // Repeats of messages in rate limited categories are tracked per slot, picked by
+        // the message's hash. A message taking a slot over from another resets its count,
+        // which only makes the limit more lenient, and reports the other one's drops.
+        std::mutex                              repeatMutex;
+        std::array<RepeatSlot, repeatSlotCount> repeatSlots;
+        std::uint64_t                           nextRepeatSweep = 0;
+
+        // Entries are a ring from firstEntry. Their text is written one after the other
+        // into historyText, wrapping to the start when a record doesn't fit before the
+        // end, so each record's text is contiguous and the oldest records are always the
+        // next ones to be overwritten.
+        std::mutex                                                  historyMutex;
+        std::array<HistoryEntry, Cedar::Log::historyCapacity>       historyEntries;
+        std::array<char, Cedar::Log::historyTextCapacity>           historyText;
+        std::size_t                                                 firstEntry   = 0;
+        std::size_t                                                 entryCount   = 0;
+        std::size_t                                                 textPosition = 0;
+        std::uint64_t                                               nextSequence = 0;
 
 
         inline LogData() {}
@@ -35,17 +108,38 @@ namespace
 
 
 
-    std::string getPrefix(Cedar::Log::Level level);
+    std::string getPrefix(Cedar::Log::Level level, const Cedar::Log::Category* category);
 
     std::string getTimestamp();
 
     std::string getLevelName(Cedar::Log::Level level);
 
+    // Copies the record into the history ring, evicting the oldest records to make room.
+    // Expects the history to be locked.
+    void addToHistory(LogData& logData, Cedar::Log::Level level, std::string_view prefix, std::string_view msg);
+
+    // Returns whether the message is let through. Drops that are done being counted, of
+    // this message or of others, are added to droppedRepeats for the caller to report.
+    bool checkRepeats(LogData& logData, const Cedar::Log::Category& category, Cedar::Log::Level level, std::string_view msg,
+                      std::vector<DroppedRepeats>& droppedRepeats);
+
+    // Expects the repeats to be locked.
+    void takeDroppedRepeats(RepeatSlot& slot, std::vector<DroppedRepeats>& droppedRepeats);
 
+    void writeMessage(LogData& logData, const Cedar::Log::Category* category, Cedar::Log::Level level, std::string_view msg);
 
-    std::string getPrefix(Cedar::Log::Level level)
+    void writeRecord(LogData& logData, const Cedar::Log::Category* category, Cedar::Log::Level level, std::string_view msg);
+
+
+
+    std::string getPrefix(Cedar::Log::Level level, const Cedar::Log::Category* category)
     {
-        return '[' + getTimestamp() + " UTC][" + getLevelName(level) + "]: ";
+        std::string prefix = '[' + getTimestamp() + " UTC][" + getLevelName(level) + ']';
+
+        if (category != nullptr)
+            prefix += '[' + std::string(category->getName()) + ']';
+
+        return prefix + ": ";
     }
 
 
@@ -82,6 +176,189 @@ namespace
                 return "LEVEL";
         }
     }
+
+
+
+    void addToHistory(LogData& logData, Cedar::Log::Level level, std::string_view prefix, std::string_view msg)
+    {
+        std::size_t prefixLength = std::min(prefix.size(), maxRecordLength);
+        std::size_t msgLength    = std::min(msg.size(), maxRecordLength - prefixLength);
+        std::size_t length       = prefixLength + msgLength;
+
+        auto evictOldest = [&logData]() {
+            logData.firstEntry = (logData.firstEntry + 1) % logData.historyEntries.size();
+            logData.entryCount--;
+        };
+
+        auto oldest = [&logData]() -> const HistoryEntry& {
+            return logData.historyEntries[logData.firstEntry];
+        };
+
+        // Doesn't fit before the end, the records left between the position and the end
+        // are the oldest ones and go first
+        if (logData.textPosition + length > logData.historyText.size())
+        {
+            while (logData.entryCount > 0 && oldest().textOffset >= logData.textPosition)
+                evictOldest();
+
+            logData.textPosition = 0;
+        }
+
+        while (logData.entryCount > 0 && oldest().textOffset >= logData.textPosition &&
+               oldest().textOffset < logData.textPosition + length)
+        {
+            evictOldest();
+        }
+
+        if (logData.entryCount == logData.historyEntries.size())
+            evictOldest();
+
+        char* text = logData.historyText.data() + logData.textPosition;
+        std::memcpy(text, prefix.data(), prefixLength);
+        std::memcpy(text + prefixLength, msg.data(), msgLength);
+
+        std::size_t entryIndex = (logData.firstEntry + logData.entryCount) % logData.historyEntries.size();
+
+        logData.historyEntries[entryIndex] = {
+            logData.nextSequence++,
+            level,
+            static_cast<std::uint32_t>(logData.textPosition),
+            static_cast<std::uint32_t>(length)
+        };
+
+        logData.entryCount++;
+        logData.textPosition += length;
+    }
+
+
+
+    bool checkRepeats(LogData& logData, const Cedar::Log::Category& category, Cedar::Log::Level level, std::string_view msg,
+                      std::vector<DroppedRepeats>& droppedRepeats)
+    {
+        std::uint64_t hash = Cedar::hashString(msg);
+        hash = hash * 31 + category.getId().getHash();
+        hash = hash * 31 + static_cast<std::uint64_t>(level);
+
+        std::lock_guard lock(logData.repeatMutex);
+
+        std::uint64_t now = Cedar::Profiler::getTimestamp();
+
+        // Messages that stopped repeating would otherwise only have their drops reported
+        // when their slot is taken over
+        if (now >= logData.nextRepeatSweep)
+        {
+            for (RepeatSlot& slot : logData.repeatSlots)
+            {
+                if (slot.category != nullptr && now - slot.windowStart >= slot.interval)
+                    takeDroppedRepeats(slot, droppedRepeats);
+            }
+
+            logData.nextRepeatSweep = now + Cedar::Log::defaultRepeatInterval;
+        }
+
+        RepeatSlot& slot = logData.repeatSlots[hash % repeatSlotCount];
+
+        if (slot.category == nullptr || slot.hash != hash || now - slot.windowStart >= slot.interval)
+        {
+            takeDroppedRepeats(slot, droppedRepeats);
+
+            slot.category    = &category;
+            slot.level       = level;
+            slot.hash        = hash;
+            slot.windowStart = now;
+            slot.interval    = category.getRepeatInterval();
+            slot.count       = 1;
+            slot.dropped     = 0;
+            slot.text.assign(msg);
+
+            return true;
+        }
+
+        if (slot.count < category.getRepeatLimit())
+        {
+            slot.count++;
+
+            return true;
+        }
+
+        slot.dropped++;
+
+        return false;
+    }
+
+
+
+    void takeDroppedRepeats(RepeatSlot& slot, std::vector<DroppedRepeats>& droppedRepeats)
+    {
+        if (slot.category == nullptr || slot.dropped == 0)
+            return;
+
+        droppedRepeats.push_back({ slot.category, slot.level, slot.text, slot.dropped });
+        slot.dropped = 0;
+    }
+
+
+
+    void writeMessage(LogData& logData, const Cedar::Log::Category* category, Cedar::Log::Level level, std::string_view msg)
+    {
+        CEDAR_PROFILE_SCOPE("Log::message");
+
+        // Errors and above are never dropped. The limit is checked first so categories
+        // without one never take the repeat lock
+        if (category != nullptr && level < Cedar::Log::Level::Error && category->getRepeatLimit() != 0)
+        {
+            std::vector<DroppedRepeats> droppedRepeats;
+
+            bool letThrough = checkRepeats(logData, *category, level, msg, droppedRepeats);
+
+            for (const DroppedRepeats& dropped : droppedRepeats)
+                writeRecord(logData, dropped.category, dropped.level, std::format("Dropped {} repeat(s) of: {}", dropped.count, dropped.text));
+
+            if (!letThrough)
+                return;
+        }
+
+        writeRecord(logData, category, level, msg);
+    }
+
+
+
+    void writeRecord(LogData& logData, const Cedar::Log::Category* category, Cedar::Log::Level level, std::string_view msg)
+    {
+        using Cedar::Log::Level;
+        using Cedar::Terminal::Color;
+
+        Color foregroundColor = Color::Use_Default;
+        Color backgroundColor = Color::Use_Default;
+        
+        switch (level) {
+            case Level::Trace:
+                foregroundColor = Color::White; break;
+            case Level::Debug:
+                foregroundColor = Color::Bright_Magenta; break;
+            case Level::Info:
+                foregroundColor = Color::Green; break;
+            case Level::Warning:
+                foregroundColor = Color::Bright_Yellow; break;
+            case Level::Error:
+                foregroundColor = Color::Red; break;
+            default: { // Level::Critical and Level::Fatal
+                foregroundColor = Color::White;
+                backgroundColor = Color::Red;
+                break;
+            }
+        }
+
+        std::string prefix = getPrefix(level, category);
+
+        {
+            std::lock_guard lock(logData.historyMutex);
+            addToHistory(logData, level, prefix, msg);
+        }
+
+        Cedar::Terminal::write(prefix, foregroundColor, backgroundColor);
+        Cedar::Terminal::writeLine(msg, foregroundColor, backgroundColor);
+    }
 }
 
 
@@ -126,16 +403,127 @@ namespace Cedar::Log
 
 namespace Cedar::Log
 {
+    constinit CompiledCategory<static_cast<Level>(CEDAR_LOG_WINDOW_MIN_LEVEL)> windowCategory("Window");
+    constinit CompiledCategory<static_cast<Level>(CEDAR_LOG_RENDER_MIN_LEVEL)> renderCategory("Render");
+    constinit CompiledCategory<static_cast<Level>(CEDAR_LOG_ASSET_MIN_LEVEL)>  assetCategory("Asset");
+    constinit CompiledCategory<static_cast<Level>(CEDAR_LOG_IO_MIN_LEVEL)>     ioCategory("IO");
+
+    static CategoryRegistrar windowCategoryRegistrar(windowCategory);
+    static CategoryRegistrar renderCategoryRegistrar(renderCategory);
+    static CategoryRegistrar assetCategoryRegistrar(assetCategory);
+    static CategoryRegistrar ioCategoryRegistrar(ioCategory);
+
+
+
+    void Category::setLevel(Level level)
+    {
+        std::lock_guard lock(g_logData.categoryMutex);
+
+        m_overridden = true;
+        m_level.store(level, std::memory_order_relaxed);
+    }
+
+
+
+    void Category::resetLevel()
+    {
+        std::lock_guard lock(g_logData.categoryMutex);
+
+        m_overridden = false;
+        m_level.store(g_logData.minLevel.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+
+
+    void Category::setRepeatLimit(std::size_t limit, std::uint64_t interval)
+    {
+        // Slots already counting keep the interval they started with
+        m_repeatInterval.store(interval, std::memory_order_relaxed);
+        m_repeatLimit.store(limit, std::memory_order_relaxed);
+    }
+
+
+
+    CategoryRegistrar::CategoryRegistrar(Category& category) : m_category(category)
+    {
+        std::lock_guard lock(g_logData.categoryMutex);
+
+        if (g_logData.firstCategory != nullptr)
+            g_logData.firstCategory->m_previous = &category;
+
+        category.m_next         = g_logData.firstCategory;
+        g_logData.firstCategory = &category;
+
+        // setMinLevel() may have been called before the category was registered
+        if (!category.m_overridden)
+            category.m_level.store(g_logData.minLevel.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+
+
+    CategoryRegistrar::~CategoryRegistrar()
+    {
+        std::lock_guard lock(g_logData.categoryMutex);
+
+        if (m_category.m_previous != nullptr)
+            m_category.m_previous->m_next = m_category.m_next;
+        else
+            g_logData.firstCategory = m_category.m_next;
+
+        if (m_category.m_next != nullptr)
+            m_category.m_next->m_previous = m_category.m_previous;
+
+        m_category.m_previous = nullptr;
+        m_category.m_next     = nullptr;
+
+        // The slots can't point to the category any more. Their drops go unreported, this
+        // usually happens during static destruction, when logging may not be safe
+        std::lock_guard repeatLock(g_logData.repeatMutex);
+
+        for (RepeatSlot& slot : g_logData.repeatSlots)
+        {
+            if (slot.category == &m_category)
+                slot.category = nullptr;
+        }
+    }
+
+
+
     Level getMinLevel()
     {
-        return g_logData.minLevel;
+        return g_logData.minLevel.load(std::memory_order_relaxed);
     }
 
 
 
     void setMinLevel(Level level)
     {
-        g_logData.minLevel = level;
+        std::lock_guard lock(g_logData.categoryMutex);
+
+        g_logData.minLevel.store(level, std::memory_order_relaxed);
+
+        for (Category* category = g_logData.firstCategory; category != nullptr; category = category->m_next)
+        {
+            if (!category->m_overridden)
+                category->m_level.store(level, std::memory_order_relaxed);
+        }
+    }
+
+
+
+    Category* findCategory(std::string_view name)
+    {
+        StringId id(name);
+
+        std::lock_guard lock(g_logData.categoryMutex);
+
+        for (Category* category = g_logData.firstCategory; category != nullptr; category = category->m_next)
+        {
+            if (category->getId() == id)
+                return category;
+        }
+
+        return nullptr;
     }
 
 
@@ -145,28 +533,46 @@ namespace Cedar::Log
         if (level < getMinLevel())
             return;
 
-        Terminal::Color foregroundColor = Terminal::Color::Use_Default;
-        Terminal::Color backgroundColor = Terminal::Color::Use_Default;
-        
-        switch (level) {
-            case Level::Trace:
-                foregroundColor = Terminal::Color::White; break;
-            case Level::Debug:
-                foregroundColor = Terminal::Color::Bright_Magenta; break;
-            case Level::Info:
-                foregroundColor = Terminal::Color::Green; break;
-            case Level::Warning:
-                foregroundColor = Terminal::Color::Bright_Yellow; break;
-            case Level::Error:
-                foregroundColor = Terminal::Color::Red; break;
-            default: { // Level::Critical and Level::Fatal
-                foregroundColor = Terminal::Color::White;
-                backgroundColor = Terminal::Color::Red;
-                break;
-            }
-        }
+        writeMessage(g_logData, nullptr, level, msg);
+    }
+
+
+
+    void message(const Category& category, Level level, std::string_view msg)
+    {
+        if (!category.isEnabled(level))
+            return;
+
+        writeMessage(g_logData, &category, level, msg);
+    }
+
+
 
-        Terminal::write(getPrefix(level), foregroundColor, backgroundColor);
-        Terminal::writeLine(msg, foregroundColor, backgroundColor);
+    std::uint64_t getNextSequence()
+    {
+        std::lock_guard lock(g_logData.historyMutex);
+
+        return g_logData.nextSequence;
+    }
+
+
+
+    void visitHistory(RecordFunc function, void* data)
+    {
+        std::lock_guard lock(g_logData.historyMutex);
+
+        for (std::size_t i = g_logData.entryCount; i > 0; i--)
+        {
+            const HistoryEntry& entry = g_logData.historyEntries[(g_logData.firstEntry + i - 1) % g_logData.historyEntries.size()];
+
+            Record record = {
+                entry.sequence,
+                entry.level,
+                std::string_view(g_logData.historyText.data() + entry.textOffset, entry.textLength)
+            };
+
+            if (!function(data, record))
+                return;
+        }
     }
 }
\ No newline at end of file
@@ -1,5 +1,12 @@
 //
 // Logging utilities for writing messages to the terminal (if one is visible).
+//
+// The most recent records are also kept in memory, in a fixed-size ring that can be read
+// back (e.g. by an in-window console, see debug/log_console.h) without copying them.
+//
+// Messages can be grouped into categories (see Log::Category), each with its own runtime
+// level and its own compile-time minimum level. Categories can also drop messages repeated
+// too often, see Category::setRepeatLimit().
 // 
 // Support for logging to a file is planned.
 //
@@ -8,9 +15,13 @@
 #define CEDAR_IO_LOG_H
 
 #include "../core.h"
+#include "../string_id.h"
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <string_view>
+#include <type_traits>
 
 #define CEDAR_LOG_LEVEL_TRACE    0
 #define CEDAR_LOG_LEVEL_DEBUG    1
@@ -24,6 +35,25 @@
     #define CEDAR_LOG_MIN_LEVEL CEDAR_LOG_LEVEL_TRACE
 #endif
 
+// Compile-time minimum levels of the built-in categories. Lowering one below
+// CEDAR_LOG_MIN_LEVEL keeps that category's detailed messages in an otherwise stripped
+// build.
+#if !defined(CEDAR_LOG_WINDOW_MIN_LEVEL)
+    #define CEDAR_LOG_WINDOW_MIN_LEVEL CEDAR_LOG_MIN_LEVEL
+#endif
+
+#if !defined(CEDAR_LOG_RENDER_MIN_LEVEL)
+    #define CEDAR_LOG_RENDER_MIN_LEVEL CEDAR_LOG_MIN_LEVEL
+#endif
+
+#if !defined(CEDAR_LOG_ASSET_MIN_LEVEL)
+    #define CEDAR_LOG_ASSET_MIN_LEVEL CEDAR_LOG_MIN_LEVEL
+#endif
+
+#if !defined(CEDAR_LOG_IO_MIN_LEVEL)
+    #define CEDAR_LOG_IO_MIN_LEVEL CEDAR_LOG_MIN_LEVEL
+#endif
+
 
 
 namespace Cedar::Log
@@ -49,6 +79,15 @@ namespace Cedar::Log
 
 
 
+    // Limits of the record history. Records are dropped oldest first once either one is
+    // reached.
+    constexpr std::size_t historyCapacity     = 4096;       // Records
+    constexpr std::size_t historyTextCapacity = 256 * 1024; // Bytes, records longer than 1/16 of it are truncated
+
+    constexpr std::uint64_t defaultRepeatInterval = 1'000'000'000; // 1 s, in nanoseconds
+
+
+
     enum class Level {
         Trace    = CEDAR_LOG_LEVEL_TRACE,
         Debug    = CEDAR_LOG_LEVEL_DEBUG,
@@ -61,13 +100,167 @@ namespace Cedar::Log
 
 
 
+#if defined(CEDAR_DEBUG)
+    constexpr Level defaultMinLevel = Level::Trace;
+#else
+    constexpr Level defaultMinLevel = Level::Info;
+#endif
+
+
+
+    struct Record;
+
+    class Category;
+
+    template <Level TMinLevel>
+    class CompiledCategory;
+
+    class CategoryRegistrar;
+
+
+
+    // Views into the history, only valid while it's being visited.
+    struct Record
+    {
+        std::uint64_t    sequence; // Counts up from 0 for every record logged
+        Level            level;
+        std::string_view text;     // The whole line, prefix included
+    };
+
+
+
+    // A named group of messages, usually a subsystem's, with its own minimum level so that
+    // e.g. tracing can be turned on for just that subsystem. Categories follow setMinLevel()
+    // until they're given a level of their own.
+    //
+    // Categories are declared with CEDAR_LOG_DECLARE_CATEGORY, defined with
+    // CEDAR_LOG_DEFINE_CATEGORY and logged to with CEDAR_LOG, which checks the level with
+    // a single atomic load before the message is even evaluated.
+    class Category
+    {
+    public:
+
+        // The name must outlive the category.
+        constexpr explicit Category(std::string_view name);
+
+
+        Category(const Category&) = delete;
+
+        Category& operator=(const Category&) = delete;
+
+
+        inline std::string_view getName() const;
+
+        constexpr StringId getId() const;
+
+
+        inline Level getLevel() const;
+
+        // Overrides the level set by setMinLevel(), until resetLevel() is called.
+        void setLevel(Level level);
+
+        void resetLevel();
+
+
+        inline bool isEnabled(Level level) const;
+
+
+        // Messages below Level::Error repeated (same level and text) more than limit times
+        // within the interval (in nanoseconds) are dropped until it has passed. How many
+        // were dropped is written as a record of its own once the interval is over (noticed
+        // by the next message logged to a rate limited category) or when another message
+        // takes over the repeat's tracking. A limit of 0, the default, turns this off.
+        void setRepeatLimit(std::size_t limit, std::uint64_t interval = defaultRepeatInterval);
+
+        inline std::size_t getRepeatLimit() const;
+
+        inline std::uint64_t getRepeatInterval() const;
+
+    private:
+
+        friend class CategoryRegistrar;
+
+        friend void setMinLevel(Level level);
+
+        friend Category* findCategory(std::string_view name);
+
+
+        std::string_view           m_name;
+        StringId                   m_id;
+        std::atomic<Level>         m_level          = defaultMinLevel;
+        std::atomic<std::size_t>   m_repeatLimit    = 0;
+        std::atomic<std::uint64_t> m_repeatInterval = defaultRepeatInterval;
+        bool                       m_overridden     = false;   // Guarded by the category list's lock
+        Category*                  m_previous       = nullptr; // Registered categories are a list
+        Category*                  m_next           = nullptr;
+    };
+
+
+
+    // A category whose messages below TMinLevel are stripped from the build by CEDAR_LOG.
+    template <Level TMinLevel>
+    class CompiledCategory : public Category
+    {
+    public:
+
+        static constexpr Level compiledMinLevel = TMinLevel;
+
+
+        using Category::Category;
+    };
+
+
+
+    // Registers a category for setMinLevel() and findCategory(). For internal use only,
+    // see CEDAR_LOG_DEFINE_CATEGORY
+    class CategoryRegistrar
+    {
+    public:
+
+        explicit CategoryRegistrar(Category& category);
+
+        ~CategoryRegistrar();
+
+
+        CategoryRegistrar(const CategoryRegistrar&) = delete;
+
+        CategoryRegistrar& operator=(const CategoryRegistrar&) = delete;
+
+    private:
+
+        Category& m_category;
+    };
+
+
+
+    typedef bool (*RecordFunc)(void* data, const Record& record);
+
+
+
+    // The built-in categories. There's no terminal category: every message is written to
+    // the terminal, so the terminal code can't log through Log without recursing into
+    // itself.
+    extern constinit CompiledCategory<static_cast<Level>(CEDAR_LOG_WINDOW_MIN_LEVEL)> windowCategory;
+    extern constinit CompiledCategory<static_cast<Level>(CEDAR_LOG_RENDER_MIN_LEVEL)> renderCategory;
+    extern constinit CompiledCategory<static_cast<Level>(CEDAR_LOG_ASSET_MIN_LEVEL)>  assetCategory;
+    extern constinit CompiledCategory<static_cast<Level>(CEDAR_LOG_IO_MIN_LEVEL)>     ioCategory;
+
+
+
     Level getMinLevel();
 
+    // Also sets the level of every category that doesn't have one of its own.
     void setMinLevel(Level level);
 
+    // The registered category with the name, or nullptr if there isn't one.
+    Category* findCategory(std::string_view name);
+
 
     void message(Level level, std::string_view msg);
 
+    // Written only if the category is enabled for the level.
+    void message(const Category& category, Level level, std::string_view msg);
+
     CEDAR_FORCE_INLINE void trace(std::string_view msg);
 
     CEDAR_FORCE_INLINE void debug(std::string_view msg);
@@ -83,6 +276,69 @@ namespace Cedar::Log
     CEDAR_FORCE_INLINE void fatal(std::string_view msg);
 
 
+    // Sequence number the next record will get, so a change means records were added.
+    std::uint64_t getNextSequence();
+
+    // Calls function(data, record) for the records in the history from newest to oldest,
+    // until it returns false. The history is locked meanwhile, so the function must not
+    // log.
+    void visitHistory(RecordFunc function, void* data);
+
+    // Calls function(record) the same way.
+    template <typename TFunction>
+    void visitHistory(TFunction&& function);
+
+
+
+    // vvv Category function definitions vvv
+
+    constexpr Category::Category(std::string_view name) : m_name(name), m_id(name) {}
+
+
+
+    inline std::string_view Category::getName() const
+    {
+        return m_name;
+    }
+
+
+
+    constexpr StringId Category::getId() const
+    {
+        return m_id;
+    }
+
+
+
+    inline Level Category::getLevel() const
+    {
+        return m_level.load(std::memory_order_relaxed);
+    }
+
+
+
+    inline bool Category::isEnabled(Level level) const
+    {
+        return level >= m_level.load(std::memory_order_relaxed);
+    }
+
+
+
+    inline std::size_t Category::getRepeatLimit() const
+    {
+        return m_repeatLimit.load(std::memory_order_relaxed);
+    }
+
+
+
+    inline std::uint64_t Category::getRepeatInterval() const
+    {
+        return m_repeatInterval.load(std::memory_order_relaxed);
+    }
+
+    // ^^^ Category function definitions ^^^
+
+
 
     CEDAR_FORCE_INLINE void trace(std::string_view msg) {
         message(Level::Trace, msg);
@@ -123,10 +379,43 @@ namespace Cedar::Log
     CEDAR_FORCE_INLINE void fatal(std::string_view msg) {
         message(Level::Fatal, msg);
     }
+
+
+
+    template <typename TFunction>
+    void visitHistory(TFunction&& function)
+    {
+        typedef std::remove_reference_t<TFunction> Function;
+
+        visitHistory([](void* data, const Record& record) -> bool {
+            return (*static_cast<Function*>(data))(record);
+        }, const_cast<void*>(static_cast<const void*>(&function)));
+    }
 }
 
 
 
+// Declares a category, e.g. CEDAR_LOG_DECLARE_CATEGORY(audioCategory, CEDAR_LOG_LEVEL_DEBUG).
+#define CEDAR_LOG_DECLARE_CATEGORY(name, minLevel)                                               \
+    extern constinit Cedar::Log::CompiledCategory<static_cast<Cedar::Log::Level>(minLevel)> name
+
+// Defines and registers a declared category, e.g. CEDAR_LOG_DEFINE_CATEGORY(audioCategory, "Audio").
+// Must be used at namespace scope, in the namespace the category was declared in.
+#define CEDAR_LOG_DEFINE_CATEGORY(name, displayName)                               \
+    constinit decltype(name) name(displayName);                                    \
+    static Cedar::Log::CategoryRegistrar CEDAR_CONCAT_MACRO(name, Registrar)(name)
+
+// Logs to a category, e.g. CEDAR_LOG(Cedar::Log::windowCategory, Trace, "Resized").
+// The message is only evaluated if the category is enabled for the level.
+#define CEDAR_LOG(category, level, msg)                                                                      \
+    do {                                                                                                     \
+        if constexpr (Cedar::Log::Level::level >= std::remove_cvref_t<decltype(category)>::compiledMinLevel) \
+        {                                                                                                    \
+            if ((category).isEnabled(Cedar::Log::Level::level))                                              \
+                Cedar::Log::message((category), Cedar::Log::Level::level, msg);                              \
+        }                                                                                                    \
+    } while (false)
+
 #if CEDAR_LOG_MIN_LEVEL <= CEDAR_LOG_LEVEL_TRACE
     #define CEDAR_LOG_TRACE(msg) Cedar::Log::trace(msg)
 #else
@@ -0,0 +1,10 @@
+//
+// A collection of header files located in the "jobs" directory.
+//
+
+#ifndef CEDAR_JOBS_H
+#define CEDAR_JOBS_H
+
+#include "jobs/job_system.h"
+
+#endif // CEDAR_JOBS_H
\ No newline at end of file
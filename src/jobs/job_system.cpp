@@ -0,0 +1,314 @@
+#include "job_system.h"
+
+#include "../debug/profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <format>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+
+namespace
+{
+    struct Job;
+
+    struct ParallelForData;
+
+    struct JobSystemData;
+
+
+
+    struct Job
+    {
+        Cedar::Jobs::JobFunc  function;
+        void*                 data;
+        Cedar::Jobs::Counter* counter;
+    };
+
+
+
+    struct ParallelForData
+    {
+        Cedar::Jobs::RangeFunc function;
+        void*                  data;
+        std::size_t            count;
+        std::size_t            grainSize;
+
+        std::atomic<std::size_t> nextBegin = 0;
+    };
+
+
+
+    struct JobSystemData
+    {
+        std::mutex              mutex;
+        std::condition_variable condition; // Signaled when a job is queued or a counter is done
+        std::deque<Job>         queue;
+        bool                    stopping = false;
+
+        std::once_flag           startFlag;
+        std::vector<std::thread> workers;
+    };
+
+
+
+    thread_local std::size_t t_threadIndex = 0;
+
+
+
+    void startWorkers();
+
+    void workerMain(std::size_t threadIndex);
+
+    void executeJob(const Job& job);
+
+    void runParallelForChunks(ParallelForData& parallelFor);
+}
+
+
+
+// Nifty counter internal details
+namespace
+{
+    static typename std::aligned_storage<sizeof(JobSystemData), alignof(JobSystemData)>::type g_jobSystemDataBuffer;
+
+    JobSystemData& g_jobSystemData = reinterpret_cast<JobSystemData&>(g_jobSystemDataBuffer);
+}
+
+
+
+namespace Cedar::Jobs
+{
+    std::size_t JobSystemInitializer::s_counter = 0;
+
+
+
+    JobSystemInitializer::JobSystemInitializer()
+    {
+        if (s_counter == 0)
+            new (&g_jobSystemData)JobSystemData();
+
+        s_counter++;
+    }
+
+
+
+    JobSystemInitializer::~JobSystemInitializer()
+    {
+        s_counter--;
+
+        if (s_counter == 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(g_jobSystemData.mutex);
+                g_jobSystemData.stopping = true;
+            }
+
+            g_jobSystemData.condition.notify_all();
+
+            for (std::thread& worker : g_jobSystemData.workers)
+                worker.join();
+
+            g_jobSystemData.~JobSystemData();
+        }
+    }
+}
+// Nifty counter internal details
+
+
+
+namespace
+{
+    void startWorkers()
+    {
+        std::call_once(g_jobSystemData.startFlag, []() {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            std::size_t  workerCount     = (hardwareThreads > 1) ? hardwareThreads - 1 : 0;
+
+            g_jobSystemData.workers.reserve(workerCount);
+
+            for (std::size_t i = 0; i < workerCount; i++)
+                g_jobSystemData.workers.emplace_back(workerMain, i + 1);
+        });
+    }
+
+
+
+    void workerMain(std::size_t threadIndex)
+    {
+        t_threadIndex = threadIndex;
+
+        std::string threadName = std::format("Job worker {}", threadIndex);
+        Cedar::Profiler::setThreadName(threadName.c_str());
+
+        while (true)
+        {
+            Job job;
+
+            {
+                std::unique_lock<std::mutex> lock(g_jobSystemData.mutex);
+
+                g_jobSystemData.condition.wait(lock, []() {
+                    return g_jobSystemData.stopping || !g_jobSystemData.queue.empty();
+                });
+
+                // Jobs still queued at shutdown are dropped, nothing can be waiting on
+                // them anymore
+                if (g_jobSystemData.stopping)
+                    return;
+
+                job = g_jobSystemData.queue.front();
+                g_jobSystemData.queue.pop_front();
+            }
+
+            executeJob(job);
+        }
+    }
+
+
+
+    void executeJob(const Job& job)
+    {
+        job.function(job.data);
+
+        if (job.counter != nullptr && job.counter->finish())
+        {
+            // Taking the lock makes sure a waiter can't miss the notification between
+            // checking the counter and going to sleep
+            std::lock_guard<std::mutex> lock(g_jobSystemData.mutex);
+            g_jobSystemData.condition.notify_all();
+        }
+    }
+
+
+
+    void runParallelForChunks(ParallelForData& parallelFor)
+    {
+        while (true)
+        {
+            std::size_t begin = parallelFor.nextBegin.fetch_add(parallelFor.grainSize, std::memory_order_relaxed);
+
+            if (begin >= parallelFor.count)
+                return;
+
+            parallelFor.function(parallelFor.data, begin, std::min(begin + parallelFor.grainSize, parallelFor.count));
+        }
+    }
+}
+
+
+
+namespace Cedar::Jobs
+{
+    std::size_t getWorkerCount()
+    {
+        startWorkers();
+        return g_jobSystemData.workers.size();
+    }
+
+
+
+    std::size_t getThreadIndex()
+    {
+        return t_threadIndex;
+    }
+
+
+
+    void run(JobFunc function, void* data, Counter* counter)
+    {
+        startWorkers();
+
+        if (counter != nullptr)
+            counter->add();
+
+        // Without workers the job has to run right away, nothing else would run it
+        if (g_jobSystemData.workers.empty())
+        {
+            executeJob({ function, data, counter });
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(g_jobSystemData.mutex);
+            g_jobSystemData.queue.push_back({ function, data, counter });
+        }
+
+        g_jobSystemData.condition.notify_all();
+    }
+
+
+
+    void wait(const Counter& counter)
+    {
+        while (!counter.isDone())
+        {
+            Job job;
+
+            {
+                std::unique_lock<std::mutex> lock(g_jobSystemData.mutex);
+
+                g_jobSystemData.condition.wait(lock, [&counter]() {
+                    return counter.isDone() || !g_jobSystemData.queue.empty();
+                });
+
+                if (counter.isDone())
+                    return;
+
+                job = g_jobSystemData.queue.front();
+                g_jobSystemData.queue.pop_front();
+            }
+
+            executeJob(job);
+        }
+    }
+
+
+
+    void parallelFor(std::size_t count, std::size_t grainSize, RangeFunc function, void* data)
+    {
+        if (count == 0)
+            return;
+
+        grainSize = std::max<std::size_t>(grainSize, 1);
+
+        std::size_t chunkCount  = (count + grainSize - 1) / grainSize;
+        std::size_t helperCount = std::min(getWorkerCount(), chunkCount - 1);
+
+        // A single chunk isn't worth waking anyone up for
+        if (helperCount == 0)
+        {
+            function(data, 0, count);
+            return;
+        }
+
+        ParallelForData parallelFor;
+        parallelFor.function  = function;
+        parallelFor.data      = data;
+        parallelFor.count     = count;
+        parallelFor.grainSize = grainSize;
+
+        Counter counter;
+
+        for (std::size_t i = 0; i < helperCount; i++)
+        {
+            run([](void* data) {
+                runParallelForChunks(*static_cast<ParallelForData*>(data));
+            }, &parallelFor, &counter);
+        }
+
+        runParallelForChunks(parallelFor);
+
+        // Helpers that start after every chunk was taken return right away
+        wait(counter);
+    }
+}
\ No newline at end of file
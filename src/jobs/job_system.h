@@ -0,0 +1,173 @@
+//
+// Job system.
+//
+// A fixed pool of worker threads (one less than the number of hardware threads, the
+// calling thread makes up the difference) runs jobs from a shared queue. Jobs are fire
+// and forget unless they're given a counter, which tracks how many of the jobs
+// attached to it haven't finished yet. Waiting on a counter runs queued jobs on the
+// waiting thread instead of blocking it, so jobs may wait on other jobs.
+//
+// parallelFor splits an index range into chunks that the calling thread and the workers
+// take from a shared atomic cursor, so a loop costs at most one queued job per worker no
+// matter how many chunks it has.
+//
+// Jobs must not throw. Workers are started on first use and joined at static
+// destruction.
+//
+
+#ifndef CEDAR_JOBS_JOB_SYSTEM_H
+#define CEDAR_JOBS_JOB_SYSTEM_H
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+
+
+namespace Cedar::Jobs
+{
+    // Nifty counter. For internal use only
+    class JobSystemInitializer
+    {
+    public:
+
+        JobSystemInitializer();
+
+        ~JobSystemInitializer();
+
+    private:
+
+        static std::size_t s_counter;
+    };
+
+
+
+    // Nifty counter. For internal use only
+    static JobSystemInitializer jobSystemInitializer;
+
+
+
+    class Counter;
+
+
+
+    typedef void (*JobFunc)(void* data);
+    typedef void (*RangeFunc)(void* data, std::size_t begin, std::size_t end);
+
+
+
+    class Counter
+    {
+    public:
+
+        inline Counter() {}
+
+
+        Counter(const Counter&) = delete;
+
+        Counter& operator=(const Counter&) = delete;
+
+
+        inline bool isDone() const;
+
+
+        // For internal use only.
+        inline void add();
+
+        // For internal use only. Returns true if this finished the last pending job.
+        inline bool finish();
+
+    private:
+
+        std::atomic<std::size_t> m_pending = 0;
+    };
+
+
+
+    // Number of worker threads, not counting the threads that wait on counters.
+    std::size_t getWorkerCount();
+
+    // 0 on threads that aren't workers, 1 to getWorkerCount() on workers. Meant for
+    // indexing per-thread scratch data, which needs getWorkerCount() + 1 slots.
+    std::size_t getThreadIndex();
+
+
+    // Queues a job. If a counter is given, it's incremented now and decremented once the
+    // job has run.
+    void run(JobFunc function, void* data, Counter* counter = nullptr);
+
+    // Queues a copy of any callable taking no arguments.
+    template <typename TFunction>
+    void run(TFunction&& function, Counter* counter = nullptr);
+
+    // Returns once every job attached to the counter has run. Runs queued jobs in the
+    // meantime.
+    void wait(const Counter& counter);
+
+
+    // Calls function(data, begin, end) for consecutive chunks of at most grainSize
+    // indices covering [0, count), in parallel, and returns once all of them are done.
+    void parallelFor(std::size_t count, std::size_t grainSize, RangeFunc function, void* data);
+
+    // Calls function(begin, end) the same way.
+    template <typename TFunction>
+    void parallelFor(std::size_t count, std::size_t grainSize, TFunction&& function);
+
+
+
+    // vvv Counter function definitions vvv
+
+    inline bool Counter::isDone() const
+    {
+        return m_pending.load(std::memory_order_acquire) == 0;
+    }
+
+
+
+    inline void Counter::add()
+    {
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+
+
+    inline bool Counter::finish()
+    {
+        // Release so everything the job wrote is visible to whoever sees the counter done
+        return m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    // ^^^ Counter function definitions ^^^
+
+
+
+    template <typename TFunction>
+    void run(TFunction&& function, Counter* counter)
+    {
+        typedef std::decay_t<TFunction> Function;
+
+        Function* copy = new Function(std::forward<TFunction>(function));
+
+        run([](void* data) {
+            Function* function = static_cast<Function*>(data);
+
+            (*function)();
+            delete function;
+        }, copy, counter);
+    }
+
+
+
+    template <typename TFunction>
+    void parallelFor(std::size_t count, std::size_t grainSize, TFunction&& function)
+    {
+        typedef std::remove_reference_t<TFunction> Function;
+
+        parallelFor(count, grainSize, [](void* data, std::size_t begin, std::size_t end) {
+            (*static_cast<Function*>(data))(begin, end);
+        }, const_cast<void*>(static_cast<const void*>(&function)));
+    }
+}
+
+#endif // CEDAR_JOBS_JOB_SYSTEM_H
\ No newline at end of file
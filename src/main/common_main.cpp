@@ -1,9 +1,16 @@
 #include "common_main.h"
 
+#include "../debug/frame_stats.h"
+#include "../debug/log_console.h"
+#include "../debug/profiler.h"
+#include "../graphics/surface.h"
+#include "../io/file_io.h"
 #include "../io/log.h"
 #include "../io/terminal.h"
+#include "../memory/memory_tracker.h"
 #include "../window.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <exception>
 
@@ -40,6 +47,35 @@ void visibilityChangedCallback()
 
 
 
+void keyPressedCallback(Cedar::Key key)
+{
+    Cedar::LogConsole::handleKey(key);
+}
+
+
+
+// Redraws the frame while the log console is shown, and once more to clear it away after
+// it's hidden.
+void drawFrame(bool& consoleWasVisible)
+{
+    bool consoleVisible = Cedar::LogConsole::isVisible();
+
+    if (!consoleVisible && !consoleWasVisible)
+        return;
+
+    Cedar::Graphics::Surface framebuffer = Cedar::Window::lockFramebuffer(Cedar::Window::FramebufferContents::Discard);
+
+    for (int y = 0; y < framebuffer.size.height; y++)
+        std::fill_n(framebuffer.getRow(y), framebuffer.size.width, Cedar::Graphics::makePixel(0, 0, 0));
+
+    Cedar::LogConsole::draw(framebuffer);
+    Cedar::Window::presentFramebuffer();
+
+    consoleWasVisible = consoleVisible;
+}
+
+
+
 int commonMain(int argc, char* argv[])
 {
     int exitStatus = EXIT_FAILURE;
@@ -64,16 +100,30 @@ int commonMain(int argc, char* argv[])
         Cedar::Window::setClosingCallback(windowClosingCallback);
         Cedar::Window::setResizedCallback(windowResizedCallback);
         Cedar::Window::setVisibilityChangedCallback(visibilityChangedCallback);
+        Cedar::Window::setKeyPressedCallback(keyPressedCallback);
 
         Cedar::Window::open(Cedar::Window::OpenArgs().sizeLimits(200, 200, -1, -1).title("Cedar Engine").visibility(Cedar::Window::Visibility::Maximize));
 
+        bool consoleWasVisible = false;
+
         while (Cedar::Window::isOpen())
         {
             //Cedar::Log::trace("Polling events");
             Cedar::Window::getVisibility();
             Cedar::Window::pollEvents();
+            Cedar::FileIO::dispatchCompletions();
+
+            if (Cedar::Window::isOpen())
+                drawFrame(consoleWasVisible);
+
+            Cedar::FrameStats::markFrame();
+            Cedar::Memory::endFrame();
+            CEDAR_PROFILE_END_FRAME();
         }
 
+        Cedar::FrameStats::logSummary();
+        Cedar::Memory::logStats();
+
         Cedar::Log::trace("Program terminating");
     }
     catch (const std::exception& e) {
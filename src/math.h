@@ -5,7 +5,9 @@
 #ifndef CEDAR_MATH_H
 #define CEDAR_MATH_H
 
+#include "math/aabb.h"
 #include "math/math_common.h"
+#include "math/matrix.h"
 #include "math/point.h"
 #include "math/size.h"
 #include "math/vector.h"
@@ -0,0 +1,216 @@
+//
+// Axis-aligned bounding box data structures.
+//
+// AABB structs must adhere to the following format and rules:
+// * Structs must be named "AABBXD" where "X" is the number of dimensions the struct
+//   represents.
+// * Must be a template that takes a generic type T, where T is the type of the corners'
+//   members.
+// * The corners are vectors named "min" and "max". A box contains the points that are
+//   at least min and at most max on every axis, so its faces are inside it.
+// * The equality and inequality operators must be defined to compare both corners.
+// * No methods are allowed aside from equality operators and default members; boxes
+//   should be strictly POD. Operations on them are free functions in this file.
+//
+
+#ifndef CEDAR_MATH_AABB_H
+#define CEDAR_MATH_AABB_H
+
+#include "vector.h"
+
+namespace Cedar
+{
+    template <typename T>
+    struct AABB2D;
+
+    template <typename T>
+    struct AABB3D;
+
+
+
+    template <typename T>
+    struct AABB2D
+    {
+        Vector2D<T> min;
+        Vector2D<T> max;
+
+        inline bool operator==(const AABB2D<T>& other) const {
+            return min == other.min && max == other.max;
+        }
+
+        inline bool operator!=(const AABB2D<T>& other) const {
+            return !operator==(other);
+        }
+    };
+
+
+
+    template <typename T>
+    struct AABB3D
+    {
+        Vector3D<T> min;
+        Vector3D<T> max;
+
+        inline bool operator==(const AABB3D<T>& other) const {
+            return min == other.min && max == other.max;
+        }
+
+        inline bool operator!=(const AABB3D<T>& other) const {
+            return !operator==(other);
+        }
+    };
+
+
+
+    // True if the boxes share at least one point, touching counts.
+    template <typename T>
+    constexpr bool overlaps(const AABB2D<T>& a, const AABB2D<T>& b)
+    {
+        return a.min.x <= b.max.x && b.min.x <= a.max.x &&
+               a.min.y <= b.max.y && b.min.y <= a.max.y;
+    }
+
+
+
+    // True if the boxes share at least one point, touching counts.
+    template <typename T>
+    constexpr bool overlaps(const AABB3D<T>& a, const AABB3D<T>& b)
+    {
+        return a.min.x <= b.max.x && b.min.x <= a.max.x &&
+               a.min.y <= b.max.y && b.min.y <= a.max.y &&
+               a.min.z <= b.max.z && b.min.z <= a.max.z;
+    }
+
+
+
+    template <typename T>
+    constexpr bool contains(const AABB2D<T>& box, const Vector2D<T>& point)
+    {
+        return point.x >= box.min.x && point.x <= box.max.x &&
+               point.y >= box.min.y && point.y <= box.max.y;
+    }
+
+
+
+    template <typename T>
+    constexpr bool contains(const AABB3D<T>& box, const Vector3D<T>& point)
+    {
+        return point.x >= box.min.x && point.x <= box.max.x &&
+               point.y >= box.min.y && point.y <= box.max.y &&
+               point.z >= box.min.z && point.z <= box.max.z;
+    }
+
+
+
+    // Squared distance from the point to the closest point of the box, 0 inside it.
+    template <typename T>
+    constexpr T squaredDistance(const AABB2D<T>& box, const Vector2D<T>& point)
+    {
+        T dx = (point.x < box.min.x) ? box.min.x - point.x : (point.x > box.max.x) ? point.x - box.max.x : T(0);
+        T dy = (point.y < box.min.y) ? box.min.y - point.y : (point.y > box.max.y) ? point.y - box.max.y : T(0);
+
+        return dx * dx + dy * dy;
+    }
+
+
+
+    // Squared distance from the point to the closest point of the box, 0 inside it.
+    template <typename T>
+    constexpr T squaredDistance(const AABB3D<T>& box, const Vector3D<T>& point)
+    {
+        T dx = (point.x < box.min.x) ? box.min.x - point.x : (point.x > box.max.x) ? point.x - box.max.x : T(0);
+        T dy = (point.y < box.min.y) ? box.min.y - point.y : (point.y > box.max.y) ? point.y - box.max.y : T(0);
+        T dz = (point.z < box.min.z) ? box.min.z - point.z : (point.z > box.max.z) ? point.z - box.max.z : T(0);
+
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+
+
+    // Smallest box containing both.
+    template <typename T>
+    constexpr AABB2D<T> combine(const AABB2D<T>& a, const AABB2D<T>& b)
+    {
+        return {
+            { (a.min.x < b.min.x) ? a.min.x : b.min.x, (a.min.y < b.min.y) ? a.min.y : b.min.y },
+            { (a.max.x > b.max.x) ? a.max.x : b.max.x, (a.max.y > b.max.y) ? a.max.y : b.max.y }
+        };
+    }
+
+
+
+    // Smallest box containing both.
+    template <typename T>
+    constexpr AABB3D<T> combine(const AABB3D<T>& a, const AABB3D<T>& b)
+    {
+        return {
+            { (a.min.x < b.min.x) ? a.min.x : b.min.x, (a.min.y < b.min.y) ? a.min.y : b.min.y, (a.min.z < b.min.z) ? a.min.z : b.min.z },
+            { (a.max.x > b.max.x) ? a.max.x : b.max.x, (a.max.y > b.max.y) ? a.max.y : b.max.y, (a.max.z > b.max.z) ? a.max.z : b.max.z }
+        };
+    }
+
+
+
+    // Grows the box by the margin on every side.
+    template <typename T>
+    constexpr AABB2D<T> expand(const AABB2D<T>& box, T margin)
+    {
+        return { { box.min.x - margin, box.min.y - margin }, { box.max.x + margin, box.max.y + margin } };
+    }
+
+
+
+    // Grows the box by the margin on every side.
+    template <typename T>
+    constexpr AABB3D<T> expand(const AABB3D<T>& box, T margin)
+    {
+        return {
+            { box.min.x - margin, box.min.y - margin, box.min.z - margin },
+            { box.max.x + margin, box.max.y + margin, box.max.z + margin }
+        };
+    }
+
+
+
+    // True if inner is entirely inside outer.
+    template <typename T>
+    constexpr bool contains(const AABB2D<T>& outer, const AABB2D<T>& inner)
+    {
+        return inner.min.x >= outer.min.x && inner.max.x <= outer.max.x &&
+               inner.min.y >= outer.min.y && inner.max.y <= outer.max.y;
+    }
+
+
+
+    // True if inner is entirely inside outer.
+    template <typename T>
+    constexpr bool contains(const AABB3D<T>& outer, const AABB3D<T>& inner)
+    {
+        return inner.min.x >= outer.min.x && inner.max.x <= outer.max.x &&
+               inner.min.y >= outer.min.y && inner.max.y <= outer.max.y &&
+               inner.min.z >= outer.min.z && inner.max.z <= outer.max.z;
+    }
+
+
+
+    // The 2D counterpart of surfaceArea, for costing bounding volume hierarchies.
+    template <typename T>
+    constexpr T perimeter(const AABB2D<T>& box)
+    {
+        return T(2) * ((box.max.x - box.min.x) + (box.max.y - box.min.y));
+    }
+
+
+
+    template <typename T>
+    constexpr T surfaceArea(const AABB3D<T>& box)
+    {
+        T x = box.max.x - box.min.x;
+        T y = box.max.y - box.min.y;
+        T z = box.max.z - box.min.z;
+
+        return T(2) * (x * y + y * z + z * x);
+    }
+}
+
+#endif // CEDAR_MATH_AABB_H
\ No newline at end of file
@@ -0,0 +1,190 @@
+//
+// Matrix data structures.
+//
+// Matrix structs must adhere to the following format and rules:
+// * Structs must be named "MatrixRxC" where "R" and "C" are the number of rows and
+//   columns the struct represents.
+// * Must be a template that takes a generic type T, where T is the type of the elements.
+// * Elements are stored row by row in a single member array named "m", so m[r][c] is the
+//   element in row r and column c. Points and directions are column vectors multiplied
+//   on the right, so a transform's translation is in its last column.
+// * The equality and inequality operators must be defined to compare each of the
+//   struct's elements.
+// * No methods are allowed aside from equality operators and default members; matrices
+//   should be strictly POD. Operations on them are free functions in this file.
+//
+// Rotations are unit quaternions stored in a Vector4D as (x, y, z, w).
+//
+
+#ifndef CEDAR_MATH_MATRIX_H
+#define CEDAR_MATH_MATRIX_H
+
+#include "vector.h"
+
+namespace Cedar
+{
+    template <typename T>
+    struct Matrix4x4;
+
+
+
+    template <typename T>
+    struct Matrix4x4
+    {
+        T m[4][4];
+
+        inline bool operator==(const Matrix4x4<T>& other) const {
+            for (int r = 0; r < 4; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    if (m[r][c] != other.m[r][c])
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        inline bool operator!=(const Matrix4x4<T>& other) const {
+            return !operator==(other);
+        }
+    };
+
+
+
+    template <typename T>
+    constexpr Matrix4x4<T> identityMatrix()
+    {
+        return { {
+            { T(1), T(0), T(0), T(0) },
+            { T(0), T(1), T(0), T(0) },
+            { T(0), T(0), T(1), T(0) },
+            { T(0), T(0), T(0), T(1) }
+        } };
+    }
+
+
+
+    template <typename T>
+    constexpr Matrix4x4<T> translationMatrix(const Vector3D<T>& translation)
+    {
+        return { {
+            { T(1), T(0), T(0), translation.x },
+            { T(0), T(1), T(0), translation.y },
+            { T(0), T(0), T(1), translation.z },
+            { T(0), T(0), T(0), T(1)          }
+        } };
+    }
+
+
+
+    template <typename T>
+    constexpr Matrix4x4<T> scaleMatrix(const Vector3D<T>& scale)
+    {
+        return { {
+            { scale.x, T(0),    T(0),    T(0) },
+            { T(0),    scale.y, T(0),    T(0) },
+            { T(0),    T(0),    scale.z, T(0) },
+            { T(0),    T(0),    T(0),    T(1) }
+        } };
+    }
+
+
+
+    // Scales, then rotates, then translates. The quaternion must be normalized.
+    template <typename T>
+    constexpr Matrix4x4<T> trsMatrix(const Vector3D<T>& translation, const Vector4D<T>& rotation, const Vector3D<T>& scale)
+    {
+        T x = rotation.x;
+        T y = rotation.y;
+        T z = rotation.z;
+        T w = rotation.w;
+
+        T xx = x * x, yy = y * y, zz = z * z;
+        T xy = x * y, xz = x * z, yz = y * z;
+        T wx = w * x, wy = w * y, wz = w * z;
+
+        return { {
+            { (T(1) - T(2) * (yy + zz)) * scale.x, T(2) * (xy - wz) * scale.y,          T(2) * (xz + wy) * scale.z,          translation.x },
+            { T(2) * (xy + wz) * scale.x,          (T(1) - T(2) * (xx + zz)) * scale.y, T(2) * (yz - wx) * scale.z,          translation.y },
+            { T(2) * (xz - wy) * scale.x,          T(2) * (yz + wx) * scale.y,          (T(1) - T(2) * (xx + yy)) * scale.z, translation.z },
+            { T(0),                                T(0),                                T(0),                                T(1)          }
+        } };
+    }
+
+
+
+    // The quaternion must be normalized.
+    template <typename T>
+    constexpr Matrix4x4<T> rotationMatrix(const Vector4D<T>& rotation)
+    {
+        return trsMatrix(Vector3D<T>{ T(0), T(0), T(0) }, rotation, Vector3D<T>{ T(1), T(1), T(1) });
+    }
+
+
+
+    template <typename T>
+    constexpr Matrix4x4<T> operator*(const Matrix4x4<T>& a, const Matrix4x4<T>& b)
+    {
+        Matrix4x4<T> result = {};
+
+        for (int r = 0; r < 4; r++)
+        {
+            for (int c = 0; c < 4; c++)
+                result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + a.m[r][3] * b.m[3][c];
+        }
+
+        return result;
+    }
+
+
+
+    // a * b for matrices whose last row is (0, 0, 0, 1), such as any combination of
+    // translations, rotations and scales. Skips the work the last row would cost.
+    template <typename T>
+    constexpr Matrix4x4<T> multiplyAffine(const Matrix4x4<T>& a, const Matrix4x4<T>& b)
+    {
+        Matrix4x4<T> result = {};
+
+        for (int r = 0; r < 3; r++)
+        {
+            for (int c = 0; c < 3; c++)
+                result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c];
+
+            result.m[r][3] = a.m[r][0] * b.m[0][3] + a.m[r][1] * b.m[1][3] + a.m[r][2] * b.m[2][3] + a.m[r][3];
+        }
+
+        result.m[3][3] = T(1);
+
+        return result;
+    }
+
+
+
+    // Transforms a point, ignoring the last row.
+    template <typename T>
+    constexpr Vector3D<T> transformPoint(const Matrix4x4<T>& matrix, const Vector3D<T>& point)
+    {
+        return {
+            matrix.m[0][0] * point.x + matrix.m[0][1] * point.y + matrix.m[0][2] * point.z + matrix.m[0][3],
+            matrix.m[1][0] * point.x + matrix.m[1][1] * point.y + matrix.m[1][2] * point.z + matrix.m[1][3],
+            matrix.m[2][0] * point.x + matrix.m[2][1] * point.y + matrix.m[2][2] * point.z + matrix.m[2][3]
+        };
+    }
+
+
+
+    // Transforms a direction, which isn't affected by translation.
+    template <typename T>
+    constexpr Vector3D<T> transformDirection(const Matrix4x4<T>& matrix, const Vector3D<T>& direction)
+    {
+        return {
+            matrix.m[0][0] * direction.x + matrix.m[0][1] * direction.y + matrix.m[0][2] * direction.z,
+            matrix.m[1][0] * direction.x + matrix.m[1][1] * direction.y + matrix.m[1][2] * direction.z,
+            matrix.m[2][0] * direction.x + matrix.m[2][1] * direction.y + matrix.m[2][2] * direction.z
+        };
+    }
+}
+
+#endif // CEDAR_MATH_MATRIX_H
\ No newline at end of file
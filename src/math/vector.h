@@ -25,6 +25,9 @@ namespace Cedar
     template <typename T>
     struct Vector3D;
 
+    template <typename T>
+    struct Vector4D;
+
 
 
     template <typename T>
@@ -59,6 +62,25 @@ namespace Cedar
             return !operator==(other);
         }
     };
+
+
+
+    template <typename T>
+    struct Vector4D
+    {
+        T x;
+        T y;
+        T z;
+        T w;
+
+        inline bool operator==(const Vector4D<T>& other) const {
+            return x == other.x && y == other.y && z == other.z && w == other.w;
+        }
+
+        inline bool operator!=(const Vector4D<T>& other) const {
+            return !operator==(other);
+        }
+    };
 }
 
 #endif // CEDAR_MATH_VECTOR_H
\ No newline at end of file
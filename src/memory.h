@@ -0,0 +1,11 @@
+//
+// A collection of header files located in the "memory" directory.
+//
+
+#ifndef CEDAR_MEMORY_H
+#define CEDAR_MEMORY_H
+
+#include "memory/memory_tracker.h"
+#include "memory/pool_allocator.h"
+
+#endif // CEDAR_MEMORY_H
\ No newline at end of file
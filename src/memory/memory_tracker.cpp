@@ -0,0 +1,275 @@
+#include "memory_tracker.h"
+
+#include "../core.h"
+#include "../io/log.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <format>
+#include <string>
+#include <string_view>
+
+
+
+namespace Cedar::Memory
+{
+    std::string_view getTagName(Tag tag)
+    {
+        switch (tag) {
+            case Tag::General:
+                return "General";
+            case Tag::Pool:
+                return "Pool";
+            case Tag::Window:
+                return "Window";
+            case Tag::Log:
+                return "Log";
+            case Tag::Terminal:
+                return "Terminal";
+            case Tag::Render:
+                return "Render";
+            case Tag::Asset:
+                return "Asset";
+            case Tag::Physics:
+                return "Physics";
+            case Tag::Scene:
+                return "Scene";
+            case Tag::User:
+                return "User";
+            default: // Should never be hit but this shuts the compiler up
+                return "Tag";
+        }
+    }
+}
+
+
+
+#if defined(CEDAR_MEMORY_TRACKING)
+
+namespace
+{
+    constexpr std::size_t tagCount = static_cast<std::size_t>(Cedar::Memory::Tag::Count);
+
+
+
+    struct TagCounters;
+
+
+
+    // Every member is constant initialized, so the counters are usable before any
+    // dynamic initialization takes place and don't need a nifty counter.
+    struct TagCounters
+    {
+        std::atomic<std::size_t> currentBytes      = 0;
+        std::atomic<std::size_t> peakBytes         = 0;
+        std::atomic<std::size_t> allocationCount   = 0;
+        std::atomic<std::size_t> deallocationCount = 0;
+
+        std::atomic<std::size_t> frameAllocationCount = 0;
+        std::atomic<std::size_t> frameAllocatedBytes  = 0;
+
+        std::array<std::atomic<std::size_t>, Cedar::Memory::sizeHistogramBucketCount> sizeHistogram = {};
+
+        // Only touched by the thread calling endFrame
+        std::size_t lastFrameAllocationCount = 0;
+        std::size_t lastFrameAllocatedBytes  = 0;
+        std::size_t frameAllocationBudget    = 0;
+    };
+
+
+
+    std::array<TagCounters, tagCount> g_tagCounters;
+
+    std::size_t g_frameNumber = 0;
+
+
+
+    inline TagCounters& getCounters(Cedar::Memory::Tag tag);
+
+    inline std::size_t getHistogramBucket(std::size_t size);
+
+    std::string formatBytes(std::size_t bytes);
+
+
+
+    inline TagCounters& getCounters(Cedar::Memory::Tag tag) {
+        return g_tagCounters[static_cast<std::size_t>(tag)];
+    }
+
+
+
+    inline std::size_t getHistogramBucket(std::size_t size)
+    {
+        std::size_t bucket = (size == 0) ? 0 : std::bit_width(size) - 1;
+
+        return (bucket < Cedar::Memory::sizeHistogramBucketCount) ? bucket : Cedar::Memory::sizeHistogramBucketCount - 1;
+    }
+
+
+
+    std::string formatBytes(std::size_t bytes)
+    {
+        if (bytes >= 1024 * 1024)
+            return std::format("{:.2f} MiB", bytes / (1024.0 * 1024.0));
+        else if (bytes >= 1024)
+            return std::format("{:.2f} KiB", bytes / 1024.0);
+        else
+            return std::format("{} B", bytes);
+    }
+}
+
+
+
+namespace Cedar::Memory
+{
+    void recordAllocation(Tag tag, std::size_t size)
+    {
+        TagCounters& counters = getCounters(tag);
+
+        std::size_t currentBytes = counters.currentBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        std::size_t peakBytes    = counters.peakBytes.load(std::memory_order_relaxed);
+
+        while (currentBytes > peakBytes &&
+               !counters.peakBytes.compare_exchange_weak(peakBytes, currentBytes, std::memory_order_relaxed));
+
+        counters.allocationCount.fetch_add(1, std::memory_order_relaxed);
+        counters.frameAllocationCount.fetch_add(1, std::memory_order_relaxed);
+        counters.frameAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        counters.sizeHistogram[getHistogramBucket(size)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+
+
+    void recordDeallocation(Tag tag, std::size_t size)
+    {
+        TagCounters& counters = getCounters(tag);
+
+        counters.currentBytes.fetch_sub(size, std::memory_order_relaxed);
+        counters.deallocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+
+
+    TagStats getStats(Tag tag)
+    {
+        const TagCounters& counters = getCounters(tag);
+
+        TagStats stats;
+        stats.currentBytes         = counters.currentBytes.load(std::memory_order_relaxed);
+        stats.peakBytes            = counters.peakBytes.load(std::memory_order_relaxed);
+        stats.allocationCount      = counters.allocationCount.load(std::memory_order_relaxed);
+        stats.deallocationCount    = counters.deallocationCount.load(std::memory_order_relaxed);
+        stats.frameAllocationCount = counters.lastFrameAllocationCount;
+        stats.frameAllocatedBytes  = counters.lastFrameAllocatedBytes;
+
+        for (std::size_t i = 0; i < sizeHistogramBucketCount; i++)
+            stats.sizeHistogram[i] = counters.sizeHistogram[i].load(std::memory_order_relaxed);
+
+        return stats;
+    }
+
+
+
+    std::size_t getFrameAllocationBudget(Tag tag)
+    {
+        return getCounters(tag).frameAllocationBudget;
+    }
+
+
+
+    void setFrameAllocationBudget(Tag tag, std::size_t allocationCount)
+    {
+        getCounters(tag).frameAllocationBudget = allocationCount;
+    }
+
+
+
+    void endFrame()
+    {
+        for (std::size_t i = 0; i < tagCount; i++)
+        {
+            TagCounters& counters = g_tagCounters[i];
+
+            counters.lastFrameAllocationCount = counters.frameAllocationCount.exchange(0, std::memory_order_relaxed);
+            counters.lastFrameAllocatedBytes  = counters.frameAllocatedBytes.exchange(0, std::memory_order_relaxed);
+
+            if (counters.frameAllocationBudget != 0 && counters.lastFrameAllocationCount > counters.frameAllocationBudget)
+            {
+                Cedar::Log::warning(std::format("Frame {}: {} made {} allocations ({}), budget is {}",
+                                                g_frameNumber,
+                                                getTagName(static_cast<Tag>(i)),
+                                                counters.lastFrameAllocationCount,
+                                                formatBytes(counters.lastFrameAllocatedBytes),
+                                                counters.frameAllocationBudget));
+            }
+        }
+
+        g_frameNumber++;
+    }
+
+
+
+    void logFrameReport()
+    {
+        // The report is of the last completed frame
+        if (g_frameNumber == 0)
+        {
+            Cedar::Log::info("Memory frame report: no frame completed yet");
+            return;
+        }
+
+        std::string report = std::format("Memory frame report (frame {}):", g_frameNumber - 1);
+
+        for (std::size_t i = 0; i < tagCount; i++)
+        {
+            const TagCounters& counters = g_tagCounters[i];
+
+            if (counters.lastFrameAllocationCount == 0)
+                continue;
+
+            report += std::format("\n    {:<10} {:>8} allocs {:>12}",
+                                  getTagName(static_cast<Tag>(i)),
+                                  counters.lastFrameAllocationCount,
+                                  formatBytes(counters.lastFrameAllocatedBytes));
+        }
+
+        Cedar::Log::info(report);
+    }
+
+
+
+    void logStats()
+    {
+        std::string report = "Memory usage:";
+
+        for (std::size_t i = 0; i < tagCount; i++)
+        {
+            TagStats stats = getStats(static_cast<Tag>(i));
+
+            if (stats.allocationCount == 0)
+                continue;
+
+            report += std::format("\n    {:<10} current {:>12} peak {:>12} allocs {:>10} frees {:>10}",
+                                  getTagName(static_cast<Tag>(i)),
+                                  formatBytes(stats.currentBytes),
+                                  formatBytes(stats.peakBytes),
+                                  stats.allocationCount,
+                                  stats.deallocationCount);
+
+            report += "\n               sizes:";
+
+            for (std::size_t bucket = 0; bucket < sizeHistogramBucketCount; bucket++)
+            {
+                if (stats.sizeHistogram[bucket] != 0)
+                    report += std::format(" {}{}:{}", (bucket == sizeHistogramBucketCount - 1) ? ">=" : "",
+                                          formatBytes(std::size_t(1) << bucket), stats.sizeHistogram[bucket]);
+            }
+        }
+
+        Cedar::Log::info(report);
+    }
+}
+
+#endif // CEDAR_MEMORY_TRACKING
\ No newline at end of file
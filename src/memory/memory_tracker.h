@@ -0,0 +1,209 @@
+//
+// Tagged allocation tracking.
+//
+// Allocations are attributed to a subsystem tag. For every tag the tracker keeps the
+// number of bytes currently allocated, the peak, allocation and deallocation counts, the
+// number of allocations made during the current frame and a histogram of allocation
+// sizes. All counters are updated with relaxed atomics, so recording is safe from any
+// thread.
+//
+// Tracking is only compiled in when CEDAR_MEMORY_TRACKING is defined (see core.h). When
+// it isn't, every function in this file is an empty inline function and costs nothing.
+//
+
+#ifndef CEDAR_MEMORY_MEMORY_TRACKER_H
+#define CEDAR_MEMORY_MEMORY_TRACKER_H
+
+#include "../core.h"
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <string_view>
+
+
+
+namespace Cedar::Memory
+{
+    enum class Tag {
+        General,
+        Pool,
+        Window,
+        Log,
+        Terminal,
+        Render,
+        Asset,
+        Physics,
+        Scene,
+        User,
+
+        Count
+    };
+
+
+
+    // Bucket i counts allocations with a size in [2^i, 2^(i + 1)) bytes. The last bucket
+    // also counts everything larger.
+    constexpr std::size_t sizeHistogramBucketCount = 20;
+
+
+
+    struct TagStats;
+
+
+
+    struct TagStats
+    {
+        std::size_t currentBytes;
+        std::size_t peakBytes;
+        std::size_t allocationCount;
+        std::size_t deallocationCount;
+        std::size_t frameAllocationCount; // Allocations made during the last completed frame
+        std::size_t frameAllocatedBytes;  // Bytes allocated during the last completed frame
+
+        std::array<std::size_t, sizeHistogramBucketCount> sizeHistogram;
+    };
+
+
+
+    std::string_view getTagName(Tag tag);
+
+
+#if defined(CEDAR_MEMORY_TRACKING)
+
+    void recordAllocation(Tag tag, std::size_t size);
+
+    void recordDeallocation(Tag tag, std::size_t size);
+
+
+    TagStats getStats(Tag tag);
+
+
+    // Maximum number of allocations a tag may make in a single frame before endFrame
+    // logs a warning about it. 0 (the default) disables the check.
+    std::size_t getFrameAllocationBudget(Tag tag);
+
+    void setFrameAllocationBudget(Tag tag, std::size_t allocationCount);
+
+
+    // Closes the current frame's counters. Should be called once per iteration of the
+    // main loop.
+    void endFrame();
+
+    // Logs the allocations made by every tag during the last completed frame.
+    void logFrameReport();
+
+    // Logs the current state of every tag that has allocated memory.
+    void logStats();
+
+#else
+
+    inline void recordAllocation(Tag tag, std::size_t size) {}
+
+    inline void recordDeallocation(Tag tag, std::size_t size) {}
+
+
+    inline TagStats getStats(Tag tag) {
+        return TagStats();
+    }
+
+
+    inline std::size_t getFrameAllocationBudget(Tag tag) {
+        return 0;
+    }
+
+    inline void setFrameAllocationBudget(Tag tag, std::size_t allocationCount) {}
+
+
+    inline void endFrame() {}
+
+    inline void logFrameReport() {}
+
+    inline void logStats() {}
+
+#endif // CEDAR_MEMORY_TRACKING
+
+
+
+    inline void* allocate(Tag tag, std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+    inline void deallocate(Tag tag, void* pointer, std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+
+
+    // Standard library compatible allocator that records its allocations under TTag.
+    template <typename T, Tag TTag = Tag::General>
+    class TrackedAllocator
+    {
+    public:
+
+        typedef T value_type;
+
+        template <typename U>
+        struct rebind
+        {
+            typedef TrackedAllocator<U, TTag> other;
+        };
+
+
+        TrackedAllocator() noexcept = default;
+
+        template <typename U>
+        inline TrackedAllocator(const TrackedAllocator<U, TTag>&) noexcept {}
+
+
+        inline T* allocate(std::size_t count);
+
+        inline void deallocate(T* pointer, std::size_t count) noexcept;
+
+
+        template <typename U>
+        inline bool operator==(const TrackedAllocator<U, TTag>&) const noexcept { return true; }
+
+        template <typename U>
+        inline bool operator!=(const TrackedAllocator<U, TTag>&) const noexcept { return false; }
+    };
+
+
+
+    inline void* allocate(Tag tag, std::size_t size, std::size_t alignment)
+    {
+        void* pointer = ::operator new(size, std::align_val_t(alignment));
+        recordAllocation(tag, size);
+
+        return pointer;
+    }
+
+
+
+    inline void deallocate(Tag tag, void* pointer, std::size_t size, std::size_t alignment)
+    {
+        if (pointer == nullptr)
+            return;
+
+        recordDeallocation(tag, size);
+        ::operator delete(pointer, std::align_val_t(alignment));
+    }
+
+
+
+    // vvv TrackedAllocator function definitions vvv
+
+    template <typename T, Tag TTag>
+    inline T* TrackedAllocator<T, TTag>::allocate(std::size_t count)
+    {
+        return static_cast<T*>(Memory::allocate(TTag, count * sizeof(T), alignof(T)));
+    }
+
+
+
+    template <typename T, Tag TTag>
+    inline void TrackedAllocator<T, TTag>::deallocate(T* pointer, std::size_t count) noexcept
+    {
+        Memory::deallocate(TTag, pointer, count * sizeof(T), alignof(T));
+    }
+
+    // ^^^ TrackedAllocator function definitions ^^^
+}
+
+#endif // CEDAR_MEMORY_MEMORY_TRACKER_H
\ No newline at end of file
@@ -0,0 +1,538 @@
+//
+// Fixed-size block pool allocator.
+//
+// Blocks are carved out of large chunks and kept on intrusive free lists (a free block
+// stores the pointer to the next free block inside its own storage). Every thread keeps
+// a small magazine of free blocks so the common allocate and deallocate paths never
+// touch shared state; magazines are refilled from and flushed back to the shared pool in
+// batches under a lock.
+//
+// There is exactly one pool per block size and alignment, shared by every object type
+// that maps onto it. Threads that allocate from a pool must be joined before the program
+// exits, as the pool's memory is released during static destruction.
+//
+// In debug builds freed blocks are poisoned and checked for writes when they're handed
+// out again, and blocks that are still allocated when the pool is destroyed are reported
+// through Cedar::Log.
+//
+
+#ifndef CEDAR_MEMORY_POOL_ALLOCATOR_H
+#define CEDAR_MEMORY_POOL_ALLOCATOR_H
+
+#include "../core.h"
+#include "../io/log.h"
+#include "memory_tracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+
+namespace Cedar::Memory
+{
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment = alignof(std::max_align_t)>
+    class BlockPool;
+
+    template <typename T>
+    class ObjectPool;
+
+    template <typename T>
+    class PoolAllocator;
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    class BlockPool
+    {
+    public:
+
+        static constexpr std::size_t blockAlignment   = std::max(TBlockAlignment, alignof(void*));
+        static constexpr std::size_t blockSize        = (std::max(TBlockSize, sizeof(void*)) + blockAlignment - 1) / blockAlignment * blockAlignment;
+        static constexpr std::size_t chunkSize        = std::max<std::size_t>(64 * 1024, blockSize * 16);
+        static constexpr std::size_t blocksPerChunk   = chunkSize / blockSize;
+        static constexpr std::size_t magazineCapacity = 64;
+        static constexpr std::size_t transferCount    = magazineCapacity / 2;
+
+        static_assert((TBlockAlignment & (TBlockAlignment - 1)) == 0, "Block alignment must be a power of two");
+
+
+        BlockPool() = delete;
+
+
+        static void* allocate();
+
+        static void deallocate(void* block);
+
+
+        // Number of blocks handed out and not yet returned. Always 0 in release builds.
+        static std::size_t getLiveCount();
+
+        // Number of chunks the shared pool has allocated so far.
+        static std::size_t getChunkCount();
+
+    private:
+
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        class SharedPool;
+
+        class Magazine;
+
+
+        static constexpr unsigned char allocatedPoison = 0xCD;
+        static constexpr unsigned char freedPoison     = 0xDD;
+
+
+        static SharedPool& getSharedPool();
+
+        static Magazine& getMagazine();
+
+
+        static inline void poisonFreed(void* block);
+
+        static inline void checkAndPoisonAllocated(void* block);
+    };
+
+
+
+    // Typed wrapper around BlockPool for constructing and destroying single objects.
+    template <typename T>
+    class ObjectPool
+    {
+    public:
+
+        typedef BlockPool<sizeof(T), alignof(T)> Pool;
+
+
+        ObjectPool() = delete;
+
+
+        template <typename... TArgs>
+        static T* create(TArgs&&... args);
+
+        static void destroy(T* object);
+    };
+
+
+
+    // Standard library compatible allocator. Single element allocations (which is what
+    // node based containers such as std::list and std::map make) are served from the
+    // matching BlockPool, anything larger falls through to the global allocator.
+    template <typename T>
+    class PoolAllocator
+    {
+    public:
+
+        typedef T value_type;
+
+
+        PoolAllocator() noexcept = default;
+
+        template <typename U>
+        inline PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+
+        T* allocate(std::size_t count);
+
+        void deallocate(T* pointer, std::size_t count) noexcept;
+
+
+        template <typename U>
+        inline bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+
+        template <typename U>
+        inline bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+    };
+
+
+
+    // vvv BlockPool function definitions vvv
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    class BlockPool<TBlockSize, TBlockAlignment>::SharedPool
+    {
+    public:
+
+        inline SharedPool() {}
+
+        ~SharedPool();
+
+
+        // Moves up to count blocks onto the front of list. Returns the number moved.
+        std::size_t take(FreeBlock*& list, std::size_t count);
+
+        // Splices a list of count blocks ending at tail back into the shared free list.
+        void give(FreeBlock* head, FreeBlock* tail, std::size_t count);
+
+
+        inline std::size_t getChunkCount();
+
+    #if defined(CEDAR_DEBUG)
+        std::atomic<std::size_t> liveCount = 0;
+    #endif
+
+    private:
+
+        std::mutex         m_mutex;
+        FreeBlock*         m_freeList  = nullptr;
+        std::vector<void*> m_chunks;
+
+
+        void allocateChunk();
+    };
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    class BlockPool<TBlockSize, TBlockAlignment>::Magazine
+    {
+    public:
+
+        // Touching the shared pool here guarantees it's constructed before (and therefore
+        // destroyed after) every thread's magazine.
+        inline Magazine() : m_sharedPool(getSharedPool()) {}
+
+        ~Magazine();
+
+
+        inline void* pop();
+
+        inline void push(void* block);
+
+    private:
+
+        SharedPool& m_sharedPool;
+        FreeBlock*  m_head  = nullptr;
+        std::size_t m_count = 0;
+    };
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    BlockPool<TBlockSize, TBlockAlignment>::SharedPool::~SharedPool()
+    {
+    #if defined(CEDAR_DEBUG)
+        std::size_t leaked = liveCount.load(std::memory_order_relaxed);
+
+        if (leaked != 0)
+            Cedar::Log::warning("Block pool (" + std::to_string(blockSize) + " byte blocks) destroyed with " +
+                                std::to_string(leaked) + " block(s) still allocated");
+    #endif
+
+        for (void* chunk : m_chunks)
+            Memory::deallocate(Tag::Pool, chunk, chunkSize, blockAlignment);
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    std::size_t BlockPool<TBlockSize, TBlockAlignment>::SharedPool::take(FreeBlock*& list, std::size_t count)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_freeList == nullptr)
+            allocateChunk();
+
+        std::size_t taken = 0;
+
+        while (taken < count && m_freeList != nullptr)
+        {
+            FreeBlock* block = m_freeList;
+            m_freeList       = block->next;
+            block->next      = list;
+            list             = block;
+            taken++;
+        }
+
+        return taken;
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    void BlockPool<TBlockSize, TBlockAlignment>::SharedPool::give(FreeBlock* head, FreeBlock* tail, std::size_t count)
+    {
+        if (count == 0)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        tail->next = m_freeList;
+        m_freeList = head;
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    inline std::size_t BlockPool<TBlockSize, TBlockAlignment>::SharedPool::getChunkCount()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_chunks.size();
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    void BlockPool<TBlockSize, TBlockAlignment>::SharedPool::allocateChunk()
+    {
+        unsigned char* chunk = static_cast<unsigned char*>(Memory::allocate(Tag::Pool, chunkSize, blockAlignment));
+        m_chunks.push_back(chunk);
+
+        // Link the blocks in address order so fresh allocations walk memory linearly
+        for (std::size_t i = blocksPerChunk; i-- > 0;)
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * blockSize);
+            poisonFreed(block);
+            block->next = m_freeList;
+            m_freeList  = block;
+        }
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    BlockPool<TBlockSize, TBlockAlignment>::Magazine::~Magazine()
+    {
+        if (m_head == nullptr)
+            return;
+
+        FreeBlock* tail = m_head;
+
+        while (tail->next != nullptr)
+            tail = tail->next;
+
+        m_sharedPool.give(m_head, tail, m_count);
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    inline void* BlockPool<TBlockSize, TBlockAlignment>::Magazine::pop()
+    {
+        if (m_head == nullptr)
+        {
+            m_count = m_sharedPool.take(m_head, transferCount);
+
+            if (m_head == nullptr)
+                throw std::bad_alloc();
+        }
+
+        FreeBlock* block = m_head;
+        m_head = block->next;
+        m_count--;
+
+        return block;
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    inline void BlockPool<TBlockSize, TBlockAlignment>::Magazine::push(void* block)
+    {
+        FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+        freeBlock->next = m_head;
+        m_head = freeBlock;
+        m_count++;
+
+        if (m_count < magazineCapacity)
+            return;
+
+        // Magazine is full, hand the older half back to the shared pool. The most
+        // recently freed blocks stay local since they're the most likely to be in cache.
+        FreeBlock* keepTail = m_head;
+
+        for (std::size_t i = 1; i < magazineCapacity - transferCount; i++)
+            keepTail = keepTail->next;
+
+        FreeBlock* giveHead = keepTail->next;
+        FreeBlock* giveTail = giveHead;
+
+        while (giveTail->next != nullptr)
+            giveTail = giveTail->next;
+
+        keepTail->next = nullptr;
+        m_count -= transferCount;
+
+        m_sharedPool.give(giveHead, giveTail, transferCount);
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    void* BlockPool<TBlockSize, TBlockAlignment>::allocate()
+    {
+        void* block = getMagazine().pop();
+
+    #if defined(CEDAR_DEBUG)
+        checkAndPoisonAllocated(block);
+        getSharedPool().liveCount.fetch_add(1, std::memory_order_relaxed);
+    #endif
+
+        return block;
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    void BlockPool<TBlockSize, TBlockAlignment>::deallocate(void* block)
+    {
+        if (block == nullptr)
+            return;
+
+    #if defined(CEDAR_DEBUG)
+        poisonFreed(block);
+        getSharedPool().liveCount.fetch_sub(1, std::memory_order_relaxed);
+    #endif
+
+        getMagazine().push(block);
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    std::size_t BlockPool<TBlockSize, TBlockAlignment>::getLiveCount()
+    {
+    #if defined(CEDAR_DEBUG)
+        return getSharedPool().liveCount.load(std::memory_order_relaxed);
+    #else
+        return 0;
+    #endif
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    std::size_t BlockPool<TBlockSize, TBlockAlignment>::getChunkCount()
+    {
+        return getSharedPool().getChunkCount();
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    typename BlockPool<TBlockSize, TBlockAlignment>::SharedPool& BlockPool<TBlockSize, TBlockAlignment>::getSharedPool()
+    {
+        static SharedPool sharedPool;
+        return sharedPool;
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    typename BlockPool<TBlockSize, TBlockAlignment>::Magazine& BlockPool<TBlockSize, TBlockAlignment>::getMagazine()
+    {
+        static thread_local Magazine magazine;
+        return magazine;
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    inline void BlockPool<TBlockSize, TBlockAlignment>::poisonFreed(void* block)
+    {
+    #if defined(CEDAR_DEBUG)
+        // The first pointer-sized bytes hold the free list link and aren't poisoned
+        std::memset(static_cast<unsigned char*>(block) + sizeof(FreeBlock), freedPoison, blockSize - sizeof(FreeBlock));
+    #else
+        (void)block;
+    #endif
+    }
+
+
+
+    template <std::size_t TBlockSize, std::size_t TBlockAlignment>
+    inline void BlockPool<TBlockSize, TBlockAlignment>::checkAndPoisonAllocated(void* block)
+    {
+    #if defined(CEDAR_DEBUG)
+        const unsigned char* bytes = static_cast<const unsigned char*>(block);
+
+        for (std::size_t i = sizeof(FreeBlock); i < blockSize; i++)
+        {
+            if (bytes[i] != freedPoison)
+            {
+                Cedar::Log::error("Block pool (" + std::to_string(blockSize) +
+                                  " byte blocks) detected a write to a freed block");
+                break;
+            }
+        }
+
+        std::memset(block, allocatedPoison, blockSize);
+    #else
+        (void)block;
+    #endif
+    }
+
+    // ^^^ BlockPool function definitions ^^^
+
+
+
+    // vvv ObjectPool function definitions vvv
+
+    template <typename T>
+    template <typename... TArgs>
+    T* ObjectPool<T>::create(TArgs&&... args)
+    {
+        void* block = Pool::allocate();
+
+        try {
+            return new (block) T(std::forward<TArgs>(args)...);
+        }
+        catch (...) {
+            Pool::deallocate(block);
+            throw;
+        }
+    }
+
+
+
+    template <typename T>
+    void ObjectPool<T>::destroy(T* object)
+    {
+        if (object == nullptr)
+            return;
+
+        object->~T();
+        Pool::deallocate(object);
+    }
+
+    // ^^^ ObjectPool function definitions ^^^
+
+
+
+    // vvv PoolAllocator function definitions vvv
+
+    template <typename T>
+    T* PoolAllocator<T>::allocate(std::size_t count)
+    {
+        if (count == 1)
+            return static_cast<T*>(BlockPool<sizeof(T), alignof(T)>::allocate());
+        else
+            return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+
+
+    template <typename T>
+    void PoolAllocator<T>::deallocate(T* pointer, std::size_t count) noexcept
+    {
+        if (count == 1)
+            BlockPool<sizeof(T), alignof(T)>::deallocate(pointer);
+        else
+            ::operator delete(pointer, std::align_val_t(alignof(T)));
+    }
+
+    // ^^^ PoolAllocator function definitions ^^^
+}
+
+#endif // CEDAR_MEMORY_POOL_ALLOCATOR_H
\ No newline at end of file
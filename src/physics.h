@@ -0,0 +1,13 @@
+//
+// A collection of header files located in the "physics" directory.
+//
+
+#ifndef CEDAR_PHYSICS_H
+#define CEDAR_PHYSICS_H
+
+#include "physics/dynamic_aabb_tree.h"
+#include "physics/physics_world_2d.h"
+#include "physics/spatial_hash_grid.h"
+#include "physics/spatial_query.h"
+
+#endif // CEDAR_PHYSICS_H
\ No newline at end of file
@@ -0,0 +1,868 @@
+#include "dynamic_aabb_tree.h"
+
+#include "../core.h"
+#include "../debug/profiler.h"
+#include "../jobs/job_system.h"
+#include "../math/aabb.h"
+#include "../math/vector.h"
+#include "spatial_query.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+
+#if defined(CEDAR_SIMD_SSE2)
+    #include <emmintrin.h>
+#endif
+
+
+
+namespace Cedar::Physics
+{
+    namespace
+    {
+        // The tree's height is logarithmic, so a query pushes at most three lanes per level
+        // of the wide copy plus the root; this covers trees far larger than memory allows
+        constexpr std::size_t stackSize = 256;
+
+        // Queries per parallelFor chunk
+        constexpr std::size_t queryGrainSize = 16;
+
+        // Direction components closer to zero are nudged to this, so a ray starting on a
+        // box's face doesn't compute 0 * infinity
+        constexpr float minDirection = 1e-30f;
+
+
+        bool isValid(const AABB3D<float>& bounds);
+
+        Vector3D<float> getInverseDirection(const Vector3D<float>& direction);
+
+        // Returns the distance at which the ray enters the box, or a negative number if it
+        // misses the box within maxDistance.
+        float intersectRay(const AABB3D<float>& box, const Vector3D<float>& origin, const Vector3D<float>& inverseDirection, float maxDistance);
+
+        bool intersectFrustum(const AABB3D<float>& box, const Frustum& frustum);
+
+
+
+        bool isValid(const AABB3D<float>& bounds)
+        {
+            return std::isfinite(bounds.min.x) && std::isfinite(bounds.min.y) && std::isfinite(bounds.min.z) &&
+                   std::isfinite(bounds.max.x) && std::isfinite(bounds.max.y) && std::isfinite(bounds.max.z) &&
+                   bounds.min.x <= bounds.max.x && bounds.min.y <= bounds.max.y && bounds.min.z <= bounds.max.z;
+        }
+
+
+
+        Vector3D<float> getInverseDirection(const Vector3D<float>& direction)
+        {
+            auto inverse = [](float value) {
+                return 1.0f / ((std::fabs(value) < minDirection) ? std::copysign(minDirection, value) : value);
+            };
+
+            return { inverse(direction.x), inverse(direction.y), inverse(direction.z) };
+        }
+
+
+
+        float intersectRay(const AABB3D<float>& box, const Vector3D<float>& origin, const Vector3D<float>& inverseDirection, float maxDistance)
+        {
+            float x1 = (box.min.x - origin.x) * inverseDirection.x;
+            float x2 = (box.max.x - origin.x) * inverseDirection.x;
+            float y1 = (box.min.y - origin.y) * inverseDirection.y;
+            float y2 = (box.max.y - origin.y) * inverseDirection.y;
+            float z1 = (box.min.z - origin.z) * inverseDirection.z;
+            float z2 = (box.max.z - origin.z) * inverseDirection.z;
+
+            float enter = std::max({ std::min(x1, x2), std::min(y1, y2), std::min(z1, z2), 0.0f });
+            float exit  = std::min({ std::max(x1, x2), std::max(y1, y2), std::max(z1, z2), maxDistance });
+
+            return (enter <= exit) ? enter : -1.0f;
+        }
+
+
+
+        bool intersectFrustum(const AABB3D<float>& box, const Frustum& frustum)
+        {
+            // The box is outside if even its corner furthest along a plane's normal is
+            // behind the plane
+            for (const Vector4D<float>& plane : frustum.planes)
+            {
+                float x = (plane.x >= 0.0f) ? box.max.x : box.min.x;
+                float y = (plane.y >= 0.0f) ? box.max.y : box.min.y;
+                float z = (plane.z >= 0.0f) ? box.max.z : box.min.z;
+
+                if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+                    return false;
+            }
+
+            return true;
+        }
+    }
+
+
+
+    DynamicAABBTree::DynamicAABBTree(float margin)
+    {
+        if (!(margin >= 0.0f) || !std::isfinite(margin))
+            throw std::invalid_argument("Margin must be positive or zero and finite");
+
+        m_margin = margin;
+    }
+
+
+
+    ProxyId DynamicAABBTree::create(const AABB3D<float>& bounds)
+    {
+        if (!isValid(bounds))
+            throw std::invalid_argument("Proxy bounds must be finite with min at most max");
+
+        // Reserves the leaf's parent too, so insertLeaf can't throw halfway
+        if (m_nodes.size() + 2 > m_nodes.capacity())
+            m_nodes.reserve(std::max<std::size_t>(m_nodes.capacity() * 2, 64));
+
+        std::int32_t leaf = allocateNode();
+        Node&        node = m_nodes[leaf];
+
+        node.fatBounds = expand(bounds, m_margin);
+        node.bounds    = bounds;
+        node.height    = 0;
+
+        insertLeaf(leaf);
+
+        m_proxyCount++;
+        m_wideDirty = true;
+
+        return static_cast<ProxyId>(leaf);
+    }
+
+
+
+    void DynamicAABBTree::destroy(ProxyId id)
+    {
+        (void)getLeaf(id);
+
+        removeLeaf(static_cast<std::int32_t>(id));
+        freeNode(static_cast<std::int32_t>(id));
+
+        m_proxyCount--;
+        m_wideDirty = true;
+    }
+
+
+
+    bool DynamicAABBTree::move(ProxyId id, const AABB3D<float>& bounds)
+    {
+        (void)getLeaf(id);
+
+        if (!isValid(bounds))
+            throw std::invalid_argument("Proxy bounds must be finite with min at most max");
+
+        std::int32_t leaf = static_cast<std::int32_t>(id);
+        Node&        node = m_nodes[leaf];
+
+        node.bounds = bounds;
+
+        // The wide copy holds fat boxes, so it stays valid too
+        if (contains(node.fatBounds, bounds))
+            return false;
+
+        removeLeaf(leaf);
+
+        m_nodes[leaf].fatBounds = expand(bounds, m_margin);
+
+        insertLeaf(leaf);
+
+        m_wideDirty = true;
+
+        return true;
+    }
+
+
+
+    bool DynamicAABBTree::isAlive(ProxyId id) const
+    {
+        return id < m_nodes.size() && m_nodes[id].height == 0;
+    }
+
+
+
+    const AABB3D<float>& DynamicAABBTree::getBounds(ProxyId id) const
+    {
+        return getLeaf(id).bounds;
+    }
+
+
+
+    const AABB3D<float>& DynamicAABBTree::getFatBounds(ProxyId id) const
+    {
+        return getLeaf(id).fatBounds;
+    }
+
+
+
+    std::size_t DynamicAABBTree::getHeight() const
+    {
+        return (m_root != nullNode) ? static_cast<std::size_t>(m_nodes[m_root].height) + 1 : 0;
+    }
+
+
+
+    void DynamicAABBTree::query(const AABB3D<float>& box, ProxyFunc function, void* data)
+    {
+        prepareQueries();
+        queryWide(box, function, data);
+    }
+
+
+
+    void DynamicAABBTree::cull(const Frustum& frustum, ProxyFunc function, void* data)
+    {
+        prepareQueries();
+        cullWide(frustum, function, data);
+    }
+
+
+
+    RayHit DynamicAABBTree::raycast(const Ray& ray)
+    {
+        prepareQueries();
+        return raycastWide(ray, nullptr, nullptr);
+    }
+
+
+
+    RayHit DynamicAABBTree::raycast(const Ray& ray, RayFunc function, void* data)
+    {
+        prepareQueries();
+        return raycastWide(ray, function, data);
+    }
+
+
+
+    void DynamicAABBTree::queryBatch(std::span<const AABB3D<float>> boxes, SpatialQueryResults& results)
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        prepareQueries();
+
+        results.run(boxes.size(), queryGrainSize, [&](std::size_t index, ProxyVector& found) {
+            queryWide(boxes[index], [](void* data, ProxyId id) { static_cast<ProxyVector*>(data)->push_back(id); }, &found);
+        });
+    }
+
+
+
+    void DynamicAABBTree::cullBatch(std::span<const Frustum> frustums, SpatialQueryResults& results)
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        prepareQueries();
+
+        // Each frustum is a large query of its own, so they're spread one at a time
+        results.run(frustums.size(), 1, [&](std::size_t index, ProxyVector& found) {
+            cullWide(frustums[index], [](void* data, ProxyId id) { static_cast<ProxyVector*>(data)->push_back(id); }, &found);
+        });
+    }
+
+
+
+    void DynamicAABBTree::raycastBatch(std::span<const Ray> rays, std::span<RayHit> hits, RayFunc function, void* data)
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        if (rays.size() != hits.size())
+            throw std::invalid_argument("Raycasts need as many hits as rays");
+
+        prepareQueries();
+
+        auto run = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++)
+                hits[i] = raycastWide(rays[i], function, data);
+        };
+
+        if (rays.size() <= queryGrainSize)
+            run(0, rays.size());
+        else
+            Jobs::parallelFor(rays.size(), queryGrainSize, run);
+    }
+
+
+
+    const DynamicAABBTree::Node& DynamicAABBTree::getLeaf(ProxyId id) const
+    {
+        if (!isAlive(id))
+            throw std::invalid_argument("Proxy isn't alive");
+
+        return m_nodes[id];
+    }
+
+
+
+    std::int32_t DynamicAABBTree::allocateNode()
+    {
+        std::int32_t node;
+
+        if (m_freeNode != nullNode)
+        {
+            node       = m_freeNode;
+            m_freeNode = m_nodes[node].parent;
+        }
+        else
+        {
+            if (m_nodes.size() >= static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+                throw std::length_error("Too many tree nodes");
+
+            node = static_cast<std::int32_t>(m_nodes.size());
+            m_nodes.push_back(Node());
+        }
+
+        m_nodes[node].parent = nullNode;
+        m_nodes[node].child1 = nullNode;
+        m_nodes[node].child2 = nullNode;
+        m_nodes[node].height = 0;
+
+        return node;
+    }
+
+
+
+    void DynamicAABBTree::freeNode(std::int32_t node)
+    {
+        m_nodes[node].parent = m_freeNode;
+        m_nodes[node].height = -1;
+
+        m_freeNode = node;
+    }
+
+
+
+    void DynamicAABBTree::insertLeaf(std::int32_t leaf)
+    {
+        if (m_root == nullNode)
+        {
+            m_root                = leaf;
+            m_nodes[leaf].parent = nullNode;
+
+            return;
+        }
+
+        AABB3D<float> leafBounds = m_nodes[leaf].fatBounds;
+        std::int32_t  sibling    = m_root;
+
+        // Descends towards the sibling with the smallest increase in surface area, counting
+        // what every ancestor grows by on the way
+        while (m_nodes[sibling].child2 != nullNode)
+        {
+            const Node& node = m_nodes[sibling];
+
+            float area         = surfaceArea(node.fatBounds);
+            float combinedArea = surfaceArea(combine(node.fatBounds, leafBounds));
+
+            // Cost of pairing the leaf with this node, and of pushing it further down
+            float cost            = 2.0f * combinedArea;
+            float inheritanceCost = 2.0f * (combinedArea - area);
+
+            auto getCost = [&](std::int32_t child) {
+                const Node& childNode = m_nodes[child];
+                float       grown     = surfaceArea(combine(childNode.fatBounds, leafBounds));
+
+                return (childNode.child2 == nullNode) ? grown + inheritanceCost : grown - surfaceArea(childNode.fatBounds) + inheritanceCost;
+            };
+
+            float cost1 = getCost(node.child1);
+            float cost2 = getCost(node.child2);
+
+            if (cost < cost1 && cost < cost2)
+                break;
+
+            sibling = (cost1 < cost2) ? node.child1 : node.child2;
+        }
+
+        std::int32_t oldParent = m_nodes[sibling].parent;
+        std::int32_t newParent = allocateNode();
+
+        Node& parentNode = m_nodes[newParent];
+
+        parentNode.parent    = oldParent;
+        parentNode.fatBounds = combine(leafBounds, m_nodes[sibling].fatBounds);
+        parentNode.height    = m_nodes[sibling].height + 1;
+        parentNode.child1    = sibling;
+        parentNode.child2    = leaf;
+
+        if (oldParent != nullNode)
+        {
+            if (m_nodes[oldParent].child1 == sibling)
+                m_nodes[oldParent].child1 = newParent;
+            else
+                m_nodes[oldParent].child2 = newParent;
+        }
+        else
+        {
+            m_root = newParent;
+        }
+
+        m_nodes[sibling].parent = newParent;
+        m_nodes[leaf].parent    = newParent;
+
+        refitUpwards(newParent);
+    }
+
+
+
+    void DynamicAABBTree::removeLeaf(std::int32_t leaf)
+    {
+        if (leaf == m_root)
+        {
+            m_root = nullNode;
+            return;
+        }
+
+        std::int32_t parent      = m_nodes[leaf].parent;
+        std::int32_t grandParent = m_nodes[parent].parent;
+        std::int32_t sibling     = (m_nodes[parent].child1 == leaf) ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+        // The sibling takes the parent's place
+        if (grandParent != nullNode)
+        {
+            if (m_nodes[grandParent].child1 == parent)
+                m_nodes[grandParent].child1 = sibling;
+            else
+                m_nodes[grandParent].child2 = sibling;
+
+            m_nodes[sibling].parent = grandParent;
+            freeNode(parent);
+
+            refitUpwards(grandParent);
+        }
+        else
+        {
+            m_root                  = sibling;
+            m_nodes[sibling].parent = nullNode;
+
+            freeNode(parent);
+        }
+
+        m_nodes[leaf].parent = nullNode;
+    }
+
+
+
+    std::int32_t DynamicAABBTree::balance(std::int32_t a)
+    {
+        Node& nodeA = m_nodes[a];
+
+        if (nodeA.child2 == nullNode || nodeA.height < 2)
+            return a;
+
+        std::int32_t b = nodeA.child1;
+        std::int32_t c = nodeA.child2;
+
+        Node& nodeB = m_nodes[b];
+        Node& nodeC = m_nodes[c];
+
+        std::int32_t difference = nodeC.height - nodeB.height;
+
+        if (difference >= -1 && difference <= 1)
+            return a;
+
+        // The taller child (up) takes A's place, A takes the place of up's shorter child,
+        // and up's taller child stays with it
+        bool         rotateC   = difference > 1;
+        std::int32_t up        = rotateC ? c : b;
+        std::int32_t stay      = rotateC ? b : c;  // A's other child
+        Node&        nodeUp    = m_nodes[up];
+        Node&        nodeStay  = m_nodes[stay];
+        std::int32_t f         = nodeUp.child1;
+        std::int32_t g         = nodeUp.child2;
+        Node&        nodeF     = m_nodes[f];
+        Node&        nodeG     = m_nodes[g];
+
+        nodeUp.child1 = a;
+        nodeUp.parent = nodeA.parent;
+        nodeA.parent  = up;
+
+        if (nodeUp.parent != nullNode)
+        {
+            if (m_nodes[nodeUp.parent].child1 == a)
+                m_nodes[nodeUp.parent].child1 = up;
+            else
+                m_nodes[nodeUp.parent].child2 = up;
+        }
+        else
+        {
+            m_root = up;
+        }
+
+        std::int32_t taller  = (nodeF.height > nodeG.height) ? f : g;
+        std::int32_t shorter = (taller == f) ? g : f;
+
+        nodeUp.child2 = taller;
+
+        if (rotateC)
+            nodeA.child2 = shorter;
+        else
+            nodeA.child1 = shorter;
+
+        m_nodes[shorter].parent = a;
+
+        nodeA.fatBounds  = combine(nodeStay.fatBounds, m_nodes[shorter].fatBounds);
+        nodeUp.fatBounds = combine(nodeA.fatBounds, m_nodes[taller].fatBounds);
+
+        nodeA.height  = 1 + std::max(nodeStay.height, m_nodes[shorter].height);
+        nodeUp.height = 1 + std::max(nodeA.height, m_nodes[taller].height);
+
+        return up;
+    }
+
+
+
+    void DynamicAABBTree::refitUpwards(std::int32_t node)
+    {
+        while (node != nullNode)
+        {
+            node = balance(node);
+
+            Node&       current = m_nodes[node];
+            const Node& child1  = m_nodes[current.child1];
+            const Node& child2  = m_nodes[current.child2];
+
+            current.height    = 1 + std::max(child1.height, child2.height);
+            current.fatBounds = combine(child1.fatBounds, child2.fatBounds);
+
+            node = current.parent;
+        }
+    }
+
+
+
+    void DynamicAABBTree::prepareQueries()
+    {
+        if (!m_wideDirty)
+            return;
+
+        CEDAR_PROFILE_SCOPE("DynamicAABBTree wide rebuild");
+
+        m_wideNodes.clear();
+
+        // About one wide node per three binary ones
+        m_wideNodes.reserve(m_nodes.size() / 3 + 1);
+
+        if (m_root != nullNode)
+            (void)buildWide(m_root);
+
+        m_wideDirty = false;
+    }
+
+
+
+    std::int32_t DynamicAABBTree::buildWide(std::int32_t node)
+    {
+        std::int32_t lanes[4] = { node, nullNode, nullNode, nullNode };
+        std::int32_t count    = 1;
+
+        // Opens the largest internal lane until there are four, which keeps the boxes
+        // tested together about the same size
+        while (count < 4)
+        {
+            std::int32_t largest     = -1;
+            float        largestArea = -1.0f;
+
+            for (std::int32_t i = 0; i < count; i++)
+            {
+                const Node& lane = m_nodes[lanes[i]];
+
+                if (lane.child2 != nullNode && surfaceArea(lane.fatBounds) > largestArea)
+                {
+                    largest     = i;
+                    largestArea = surfaceArea(lane.fatBounds);
+                }
+            }
+
+            if (largest < 0)
+                break;
+
+            const Node& opened = m_nodes[lanes[largest]];
+
+            lanes[largest] = opened.child1;
+            lanes[count++] = opened.child2;
+        }
+
+        std::int32_t index = static_cast<std::int32_t>(m_wideNodes.size());
+        m_wideNodes.push_back(WideNode());
+
+        std::int32_t children[4] = {};
+
+        for (std::int32_t i = 0; i < count; i++)
+        {
+            const Node& lane = m_nodes[lanes[i]];
+            children[i] = (lane.child2 == nullNode) ? ~lanes[i] : buildWide(lanes[i]);
+        }
+
+        // Recursion may have moved the array
+        WideNode& wide = m_wideNodes[index];
+
+        for (std::int32_t i = 0; i < 4; i++)
+        {
+            AABB3D<float> box = (i < count) ? m_nodes[lanes[i]].fatBounds : AABB3D<float>{};
+
+            wide.minX[i]     = box.min.x;
+            wide.minY[i]     = box.min.y;
+            wide.minZ[i]     = box.min.z;
+            wide.maxX[i]     = box.max.x;
+            wide.maxY[i]     = box.max.y;
+            wide.maxZ[i]     = box.max.z;
+            wide.children[i] = children[i];
+        }
+
+        wide.count = count;
+
+        return index;
+    }
+
+
+
+    void DynamicAABBTree::queryWide(const AABB3D<float>& box, ProxyFunc function, void* data) const
+    {
+        if (m_wideNodes.empty())
+            return;
+
+        std::int32_t stack[stackSize];
+        std::size_t  size = 0;
+
+        stack[size++] = 0;
+
+#if defined(CEDAR_SIMD_SSE2)
+        const __m128 boxMinX = _mm_set1_ps(box.min.x);
+        const __m128 boxMinY = _mm_set1_ps(box.min.y);
+        const __m128 boxMinZ = _mm_set1_ps(box.min.z);
+        const __m128 boxMaxX = _mm_set1_ps(box.max.x);
+        const __m128 boxMaxY = _mm_set1_ps(box.max.y);
+        const __m128 boxMaxZ = _mm_set1_ps(box.max.z);
+#endif
+
+        while (size > 0)
+        {
+            const WideNode& node = m_wideNodes[stack[--size]];
+            int             mask = 0;
+
+#if defined(CEDAR_SIMD_SSE2)
+            __m128 hit = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.minX), boxMaxX), _mm_cmpge_ps(_mm_load_ps(node.maxX), boxMinX));
+            hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.minY), boxMaxY), _mm_cmpge_ps(_mm_load_ps(node.maxY), boxMinY)));
+            hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.minZ), boxMaxZ), _mm_cmpge_ps(_mm_load_ps(node.maxZ), boxMinZ)));
+
+            mask = _mm_movemask_ps(hit);
+#else
+            for (int i = 0; i < 4; i++)
+            {
+                bool hit = node.minX[i] <= box.max.x && node.maxX[i] >= box.min.x &&
+                           node.minY[i] <= box.max.y && node.maxY[i] >= box.min.y &&
+                           node.minZ[i] <= box.max.z && node.maxZ[i] >= box.min.z;
+
+                mask |= hit ? (1 << i) : 0;
+            }
+#endif
+
+            mask &= (1 << node.count) - 1;
+
+            for (int i = 0; i < 4; i++)
+            {
+                if ((mask & (1 << i)) == 0)
+                    continue;
+
+                std::int32_t child = node.children[i];
+
+                if (child >= 0)
+                    stack[size++] = child;
+                else if (overlaps(m_nodes[~child].bounds, box))
+                    function(data, static_cast<ProxyId>(~child));
+            }
+        }
+    }
+
+
+
+    void DynamicAABBTree::cullWide(const Frustum& frustum, ProxyFunc function, void* data) const
+    {
+        if (m_wideNodes.empty())
+            return;
+
+        std::int32_t stack[stackSize];
+        std::size_t  size = 0;
+
+        stack[size++] = 0;
+
+        while (size > 0)
+        {
+            const WideNode& node = m_wideNodes[stack[--size]];
+            int             mask = (1 << node.count) - 1;
+
+            // The corners furthest along each plane's normal, per lane, behind the plane
+            // mean the lane is outside
+            for (const Vector4D<float>& plane : frustum.planes)
+            {
+                const float* x = (plane.x >= 0.0f) ? node.maxX : node.minX;
+                const float* y = (plane.y >= 0.0f) ? node.maxY : node.minY;
+                const float* z = (plane.z >= 0.0f) ? node.maxZ : node.minZ;
+
+#if defined(CEDAR_SIMD_SSE2)
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(x), _mm_set1_ps(plane.x)), _mm_mul_ps(_mm_load_ps(y), _mm_set1_ps(plane.y))),
+                                             _mm_add_ps(_mm_mul_ps(_mm_load_ps(z), _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+
+                mask &= _mm_movemask_ps(_mm_cmpge_ps(distance, _mm_setzero_ps()));
+#else
+                for (int i = 0; i < 4; i++)
+                {
+                    if (x[i] * plane.x + y[i] * plane.y + z[i] * plane.z + plane.w < 0.0f)
+                        mask &= ~(1 << i);
+                }
+#endif
+            }
+
+            for (int i = 0; i < 4; i++)
+            {
+                if ((mask & (1 << i)) == 0)
+                    continue;
+
+                std::int32_t child = node.children[i];
+
+                if (child >= 0)
+                    stack[size++] = child;
+                else if (intersectFrustum(m_nodes[~child].bounds, frustum))
+                    function(data, static_cast<ProxyId>(~child));
+            }
+        }
+    }
+
+
+
+    RayHit DynamicAABBTree::raycastWide(const Ray& ray, RayFunc function, void* data) const
+    {
+        RayHit result;
+
+        if (m_wideNodes.empty() || !(ray.maxDistance >= 0.0f))
+            return result;
+
+        struct Entry
+        {
+            std::int32_t node;
+            float        distance;  // Where the ray enters the node's box
+        };
+
+        Vector3D<float> inverse = getInverseDirection(ray.direction);
+        float           closest = ray.maxDistance;
+
+        Entry       stack[stackSize];
+        std::size_t size = 0;
+
+        stack[size++] = { 0, 0.0f };
+
+#if defined(CEDAR_SIMD_SSE2)
+        const __m128 originX  = _mm_set1_ps(ray.origin.x);
+        const __m128 originY  = _mm_set1_ps(ray.origin.y);
+        const __m128 originZ  = _mm_set1_ps(ray.origin.z);
+        const __m128 inverseX = _mm_set1_ps(inverse.x);
+        const __m128 inverseY = _mm_set1_ps(inverse.y);
+        const __m128 inverseZ = _mm_set1_ps(inverse.z);
+#endif
+
+        while (size > 0)
+        {
+            Entry entry = stack[--size];
+
+            // Something closer was hit since the node was pushed
+            if (entry.distance > closest)
+                continue;
+
+            const WideNode& node = m_wideNodes[entry.node];
+
+            alignas(16) float enter[4];
+            int               mask = 0;
+
+#if defined(CEDAR_SIMD_SSE2)
+            __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), originX), inverseX);
+            __m128 x2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), originX), inverseX);
+            __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), originY), inverseY);
+            __m128 y2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), originY), inverseY);
+            __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), originZ), inverseZ);
+            __m128 z2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), originZ), inverseZ);
+
+            __m128 enters = _mm_max_ps(_mm_max_ps(_mm_min_ps(x1, x2), _mm_min_ps(y1, y2)), _mm_max_ps(_mm_min_ps(z1, z2), _mm_setzero_ps()));
+            __m128 exits  = _mm_min_ps(_mm_min_ps(_mm_max_ps(x1, x2), _mm_max_ps(y1, y2)), _mm_min_ps(_mm_max_ps(z1, z2), _mm_set1_ps(closest)));
+
+            _mm_store_ps(enter, enters);
+            mask = _mm_movemask_ps(_mm_cmple_ps(enters, exits));
+#else
+            for (int i = 0; i < 4; i++)
+            {
+                AABB3D<float> box = { { node.minX[i], node.minY[i], node.minZ[i] }, { node.maxX[i], node.maxY[i], node.maxZ[i] } };
+
+                enter[i] = intersectRay(box, ray.origin, inverse, closest);
+                mask    |= (enter[i] >= 0.0f) ? (1 << i) : 0;
+            }
+#endif
+
+            mask &= (1 << node.count) - 1;
+
+            // Sorts the lanes closest first
+            int order[4];
+            int count = 0;
+
+            for (int i = 0; i < 4; i++)
+            {
+                if ((mask & (1 << i)) == 0)
+                    continue;
+
+                int j = count++;
+
+                for (; j > 0 && enter[order[j - 1]] > enter[i]; j--)
+                    order[j] = order[j - 1];
+
+                order[j] = i;
+            }
+
+            // Leaves closest first, so a close hit spares the shape tests of further ones
+            for (int k = 0; k < count; k++)
+            {
+                std::int32_t child = node.children[order[k]];
+
+                if (child >= 0)
+                    continue;
+
+                ProxyId id       = static_cast<ProxyId>(~child);
+                float   distance = intersectRay(m_nodes[~child].bounds, ray.origin, inverse, closest);
+
+                if (distance < 0.0f)
+                    continue;
+
+                if (function != nullptr)
+                {
+                    distance = function(data, id, ray);
+
+                    if (distance < 0.0f || distance > closest)
+                        continue;
+                }
+
+                closest         = distance;
+                result.proxy    = id;
+                result.distance = distance;
+            }
+
+            // Nodes furthest first, so the closest is popped first
+            for (int k = count - 1; k >= 0; k--)
+            {
+                int          i     = order[k];
+                std::int32_t child = node.children[i];
+
+                if (child >= 0 && enter[i] <= closest)
+                    stack[size++] = { child, enter[i] };
+            }
+        }
+
+        return result;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,285 @@
+//
+// Dynamic bounding volume hierarchy.
+//
+// A binary tree of axis-aligned boxes whose leaves are proxies. Each leaf stores a fat
+// box, the proxy's bounds grown by a margin, so a proxy that moves a little stays inside
+// it and leaves the tree alone; only moves out of the fat box remove and reinsert the
+// leaf. Insertion picks the sibling that grows the tree's surface area the least, and the
+// tree is rebalanced with rotations on the way back up, so its height stays logarithmic
+// whatever order proxies come and go in.
+//
+// Queries don't walk the binary tree but a copy of it collapsed into nodes of four child
+// boxes stored as separate arrays per axis, which tests all four children at once with
+// SSE2 and halves the depth. The copy is rebuilt by the first query after the tree
+// changes, so queries aren't const; to query from several threads at once, use the batch
+// functions, which bring the copy up to date and then spread the queries over the job
+// system.
+//
+
+#ifndef CEDAR_PHYSICS_DYNAMIC_AABB_TREE_H
+#define CEDAR_PHYSICS_DYNAMIC_AABB_TREE_H
+
+#include "../math/aabb.h"
+#include "../math/vector.h"
+#include "../memory/memory_tracker.h"
+#include "spatial_query.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+
+
+namespace Cedar::Physics
+{
+    struct Ray;
+
+    struct RayHit;
+
+    struct Frustum;
+
+    class DynamicAABBTree;
+
+
+
+    struct Ray
+    {
+        Vector3D<float> origin;
+        Vector3D<float> direction;   // Distances are in multiples of its length
+        float           maxDistance;
+    };
+
+
+
+    struct RayHit
+    {
+        ProxyId proxy    = noProxy;  // noProxy if the ray hit nothing
+        float   distance = 0.0f;
+    };
+
+
+
+    // A point p is inside when dot(plane.xyz, p) + plane.w >= 0 for every plane, so the
+    // normals point inwards. The planes needn't be normalized.
+    struct Frustum
+    {
+        Vector4D<float> planes[6];
+    };
+
+
+
+    // Tests the ray against the proxy's actual shape. Returns the distance of the hit, or
+    // a negative number if the ray misses.
+    typedef float (*RayFunc)(void* data, ProxyId id, const Ray& ray);
+
+
+
+    class DynamicAABBTree
+    {
+    public:
+
+        static constexpr float defaultMargin = 0.1f;
+
+
+        // Throws std::invalid_argument if the margin is negative or not finite.
+        explicit DynamicAABBTree(float margin = defaultMargin);
+
+
+        inline float getMargin() const;
+
+
+        // Returns the new proxy's id. Ids are reused once the proxy is destroyed. Throws
+        // std::invalid_argument if the bounds aren't finite or min is above max.
+        ProxyId create(const AABB3D<float>& bounds);
+
+        // Throws std::invalid_argument if the proxy isn't alive.
+        void destroy(ProxyId id);
+
+        // Returns true if the proxy left its fat box and was reinserted. Throws
+        // std::invalid_argument if the proxy isn't alive, the bounds aren't finite or min
+        // is above max.
+        bool move(ProxyId id, const AABB3D<float>& bounds);
+
+        bool isAlive(ProxyId id) const;
+
+        // Throws std::invalid_argument if the proxy isn't alive.
+        const AABB3D<float>& getBounds(ProxyId id) const;
+
+        // Throws std::invalid_argument if the proxy isn't alive.
+        const AABB3D<float>& getFatBounds(ProxyId id) const;
+
+        inline std::size_t getProxyCount() const;
+
+        // Height of the binary tree, 0 when empty.
+        std::size_t getHeight() const;
+
+
+        // Calls function(data, id) for each proxy whose bounds overlap the box.
+        void query(const AABB3D<float>& box, ProxyFunc function, void* data);
+
+        // Calls function(id) the same way.
+        template <typename TFunction>
+        void query(const AABB3D<float>& box, TFunction&& function);
+
+        // Calls function(data, id) for each proxy whose bounds aren't entirely outside the
+        // frustum. Boxes near its corners may be reported while outside.
+        void cull(const Frustum& frustum, ProxyFunc function, void* data);
+
+        // Calls function(id) the same way.
+        template <typename TFunction>
+        void cull(const Frustum& frustum, TFunction&& function);
+
+        // Returns the closest proxy whose bounds the ray hits within its maximum distance.
+        RayHit raycast(const Ray& ray);
+
+        // Like raycast, but the proxies whose bounds the ray hits are tested further with
+        // the function, closest first.
+        RayHit raycast(const Ray& ray, RayFunc function, void* data);
+
+        // Calls function(id, ray) the same way.
+        template <typename TFunction>
+        RayHit raycast(const Ray& ray, TFunction&& function);
+
+
+        // Runs a box query for each box. Doesn't allocate once the results are large enough.
+        void queryBatch(std::span<const AABB3D<float>> boxes, SpatialQueryResults& results);
+
+        // Culls the proxies against each frustum.
+        void cullBatch(std::span<const Frustum> frustums, SpatialQueryResults& results);
+
+        // Casts each ray, putting the closest hits in hits, which must be as long. The
+        // function, if any, must be safe to call on several threads at once. Throws
+        // std::invalid_argument if there aren't as many hits as rays.
+        void raycastBatch(std::span<const Ray> rays, std::span<RayHit> hits, RayFunc function = nullptr, void* data = nullptr);
+
+    private:
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Physics>>;
+
+        static constexpr std::int32_t nullNode = -1;
+
+        struct Node
+        {
+            AABB3D<float> fatBounds;
+            AABB3D<float> bounds;    // The proxy's, for leaves
+            std::int32_t  parent;    // Next free node while free
+            std::int32_t  child1;
+            std::int32_t  child2;    // nullNode for leaves
+            std::int32_t  height;    // 0 for leaves, -1 while free
+        };
+
+        // Four child boxes, one lane each. A child is a wide node index, or the bitwise
+        // complement of a proxy id for leaves
+        struct alignas(16) WideNode
+        {
+            float        minX[4];
+            float        minY[4];
+            float        minZ[4];
+            float        maxX[4];
+            float        maxY[4];
+            float        maxZ[4];
+            std::int32_t children[4];
+            std::int32_t count;
+        };
+
+
+        float m_margin;
+
+        Vector<Node> m_nodes;            // A proxy's id is its leaf's index
+        std::int32_t m_root       = nullNode;
+        std::int32_t m_freeNode   = nullNode;
+        std::size_t  m_proxyCount = 0;
+
+        Vector<WideNode> m_wideNodes;    // Root first
+        bool             m_wideDirty = false;
+
+
+        // Throws std::invalid_argument if the proxy isn't alive.
+        const Node& getLeaf(ProxyId id) const;
+
+        std::int32_t allocateNode();
+
+        void freeNode(std::int32_t node);
+
+        void insertLeaf(std::int32_t leaf);
+
+        void removeLeaf(std::int32_t leaf);
+
+        // Rotates the subtree if its children's heights differ by more than one. Returns
+        // the subtree's new root.
+        std::int32_t balance(std::int32_t node);
+
+        // Refits the boxes and heights from the node up to the root, rebalancing on the way.
+        void refitUpwards(std::int32_t node);
+
+        // Brings the wide copy up to date with the tree.
+        void prepareQueries();
+
+        std::int32_t buildWide(std::int32_t node);
+
+        void queryWide(const AABB3D<float>& box, ProxyFunc function, void* data) const;
+
+        void cullWide(const Frustum& frustum, ProxyFunc function, void* data) const;
+
+        RayHit raycastWide(const Ray& ray, RayFunc function, void* data) const;
+    };
+
+
+
+    // vvv DynamicAABBTree function definitions vvv
+
+    inline float DynamicAABBTree::getMargin() const
+    {
+        return m_margin;
+    }
+
+
+
+    inline std::size_t DynamicAABBTree::getProxyCount() const
+    {
+        return m_proxyCount;
+    }
+
+
+
+    template <typename TFunction>
+    void DynamicAABBTree::query(const AABB3D<float>& box, TFunction&& function)
+    {
+        typedef std::remove_reference_t<TFunction> Function;
+
+        query(box, [](void* data, ProxyId id) {
+            (*static_cast<Function*>(data))(id);
+        }, const_cast<void*>(static_cast<const void*>(&function)));
+    }
+
+
+
+    template <typename TFunction>
+    void DynamicAABBTree::cull(const Frustum& frustum, TFunction&& function)
+    {
+        typedef std::remove_reference_t<TFunction> Function;
+
+        cull(frustum, [](void* data, ProxyId id) {
+            (*static_cast<Function*>(data))(id);
+        }, const_cast<void*>(static_cast<const void*>(&function)));
+    }
+
+
+
+    template <typename TFunction>
+    RayHit DynamicAABBTree::raycast(const Ray& ray, TFunction&& function)
+    {
+        typedef std::remove_reference_t<TFunction> Function;
+
+        return raycast(ray, [](void* data, ProxyId id, const Ray& ray) {
+            return (*static_cast<Function*>(data))(id, ray);
+        }, const_cast<void*>(static_cast<const void*>(&function)));
+    }
+
+    // ^^^ DynamicAABBTree function definitions ^^^
+}
+
+#endif // CEDAR_PHYSICS_DYNAMIC_AABB_TREE_H
\ No newline at end of file
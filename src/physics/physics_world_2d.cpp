@@ -0,0 +1,1403 @@
+#include "physics_world_2d.h"
+
+#include "../debug/profiler.h"
+#include "../jobs/job_system.h"
+#include "../math/aabb.h"
+#include "../math/vector.h"
+#include "spatial_hash_grid.h"
+#include "spatial_query.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+
+
+namespace Cedar::Physics
+{
+    namespace
+    {
+        // Overlap allowed to persist, so resting contacts don't jitter in and out of touch
+        constexpr float linearSlop = 0.005f;
+
+        // Contacts are made this far before the shapes touch, so the solver can stop them
+        // touching down with speed instead of correcting the overlap afterwards
+        constexpr float speculativeDistance = 4.0f * linearSlop;
+
+        // The bounds given to the grid are grown by this, and only updated once the body's
+        // bounds grown by half the speculative distance leave them
+        constexpr float proxyMargin = 0.1f;
+
+        // Fraction of the overlap corrected per step, and the speed the correction is capped to
+        constexpr float baumgarteFactor    = 0.2f;
+        constexpr float maxCorrectionSpeed = 4.0f;
+
+        // Slower impacts don't bounce, so resting bodies don't keep bouncing on gravity alone
+        constexpr float restitutionThreshold = 1.0f;
+
+        constexpr float sleepLinearSpeed  = 0.05f;
+        constexpr float sleepAngularSpeed = 0.05f;
+        constexpr float timeToSleep       = 0.5f;
+
+        // Colors a contact can take; contacts finding them all taken go in an extra color
+        // solved on the calling thread
+        constexpr std::uint32_t maxColors = 32;
+        constexpr std::uint32_t noColor   = 0xFFFF'FFFF;
+
+        constexpr std::size_t bodyGrainSize       = 1024;
+        constexpr std::size_t contactGrainSize    = 64;
+        constexpr std::size_t constraintGrainSize = 64;
+
+
+        // A box's frame in world space
+        struct OrientedBox
+        {
+            Vector2D<float> center;
+            Vector2D<float> axisX;
+            Vector2D<float> axisY;
+            Vector2D<float> halfExtents;
+        };
+
+        // The contact points between two shapes
+        struct Collision
+        {
+            Vector2D<float> normal     = { 0.0f, 0.0f }; // From the first shape to the second
+            std::uint32_t   pointCount = 0;
+            Vector2D<float> positions[2];
+            float           separations[2];
+            std::uint32_t   features[2];
+        };
+
+
+        Vector2D<float> operator+(const Vector2D<float>& a, const Vector2D<float>& b);
+
+        Vector2D<float> operator-(const Vector2D<float>& a, const Vector2D<float>& b);
+
+        Vector2D<float> operator-(const Vector2D<float>& vector);
+
+        Vector2D<float> operator*(float scale, const Vector2D<float>& vector);
+
+        float dot(const Vector2D<float>& a, const Vector2D<float>& b);
+
+        float cross(const Vector2D<float>& a, const Vector2D<float>& b);
+
+        // The velocity of a point at the offset on a body spinning at the angular velocity.
+        Vector2D<float> cross(float angularVelocity, const Vector2D<float>& offset);
+
+        bool isFinite(const Vector2D<float>& vector);
+
+        Vector2D<float> getVertex(const OrientedBox& box, std::uint32_t index);
+
+        // Normal of the edge from the vertex to the next one, counterclockwise.
+        Vector2D<float> getNormal(const OrientedBox& box, std::uint32_t index);
+
+        // Returns the largest separation of the second box from an edge of the first, and
+        // sets the edge.
+        float findMaxSeparation(const OrientedBox& a, const OrientedBox& b, std::uint32_t& edge);
+
+        // Clips the segment to the side of the plane where dot(normal, p) <= offset. Returns
+        // false if it's entirely on the other side.
+        bool clipSegment(Vector2D<float> (&points)[2], const Vector2D<float>& normal, float offset);
+
+        void collideCircles(const Vector2D<float>& centerA, float radiusA, const Vector2D<float>& centerB, float radiusB, Collision& collision);
+
+        void collideBoxCircle(const OrientedBox& box, const Vector2D<float>& center, float radius, Collision& collision);
+
+        void collideBoxes(const OrientedBox& a, const OrientedBox& b, Collision& collision);
+
+
+
+        Vector2D<float> operator+(const Vector2D<float>& a, const Vector2D<float>& b)
+        {
+            return { a.x + b.x, a.y + b.y };
+        }
+
+
+
+        Vector2D<float> operator-(const Vector2D<float>& a, const Vector2D<float>& b)
+        {
+            return { a.x - b.x, a.y - b.y };
+        }
+
+
+
+        Vector2D<float> operator-(const Vector2D<float>& vector)
+        {
+            return { -vector.x, -vector.y };
+        }
+
+
+
+        Vector2D<float> operator*(float scale, const Vector2D<float>& vector)
+        {
+            return { scale * vector.x, scale * vector.y };
+        }
+
+
+
+        float dot(const Vector2D<float>& a, const Vector2D<float>& b)
+        {
+            return a.x * b.x + a.y * b.y;
+        }
+
+
+
+        float cross(const Vector2D<float>& a, const Vector2D<float>& b)
+        {
+            return a.x * b.y - a.y * b.x;
+        }
+
+
+
+        Vector2D<float> cross(float angularVelocity, const Vector2D<float>& offset)
+        {
+            return { -angularVelocity * offset.y, angularVelocity * offset.x };
+        }
+
+
+
+        bool isFinite(const Vector2D<float>& vector)
+        {
+            return std::isfinite(vector.x) && std::isfinite(vector.y);
+        }
+
+
+
+        Vector2D<float> getVertex(const OrientedBox& box, std::uint32_t index)
+        {
+            // Counterclockwise from the bottom left corner
+            float x = (index == 1 || index == 2) ? box.halfExtents.x : -box.halfExtents.x;
+            float y = (index >= 2) ? box.halfExtents.y : -box.halfExtents.y;
+
+            return box.center + x * box.axisX + y * box.axisY;
+        }
+
+
+
+        Vector2D<float> getNormal(const OrientedBox& box, std::uint32_t index)
+        {
+            switch (index)
+            {
+            case 0:  return -box.axisY;
+            case 1:  return box.axisX;
+            case 2:  return box.axisY;
+            default: return -box.axisX;
+            }
+        }
+
+
+
+        float findMaxSeparation(const OrientedBox& a, const OrientedBox& b, std::uint32_t& edge)
+        {
+            float maxSeparation = -std::numeric_limits<float>::infinity();
+
+            for (std::uint32_t i = 0; i < 4; i++)
+            {
+                Vector2D<float> normal = getNormal(a, i);
+
+                // Distance of b's deepest corner along the normal from the edge
+                float separation = dot(normal, b.center - getVertex(a, i)) -
+                                   b.halfExtents.x * std::fabs(dot(normal, b.axisX)) -
+                                   b.halfExtents.y * std::fabs(dot(normal, b.axisY));
+
+                if (separation > maxSeparation)
+                {
+                    maxSeparation = separation;
+                    edge          = i;
+                }
+            }
+
+            return maxSeparation;
+        }
+
+
+
+        bool clipSegment(Vector2D<float> (&points)[2], const Vector2D<float>& normal, float offset)
+        {
+            float distance0 = dot(normal, points[0]) - offset;
+            float distance1 = dot(normal, points[1]) - offset;
+
+            if (distance0 > 0.0f && distance1 > 0.0f)
+                return false;
+
+            if (distance0 > 0.0f)
+                points[0] = points[0] + (distance0 / (distance0 - distance1)) * (points[1] - points[0]);
+            else if (distance1 > 0.0f)
+                points[1] = points[1] + (distance1 / (distance1 - distance0)) * (points[0] - points[1]);
+
+            return true;
+        }
+
+
+
+        void collideCircles(const Vector2D<float>& centerA, float radiusA, const Vector2D<float>& centerB, float radiusB, Collision& collision)
+        {
+            Vector2D<float> offset     = centerB - centerA;
+            float           distance   = std::sqrt(dot(offset, offset));
+            float           separation = distance - radiusA - radiusB;
+
+            if (separation > speculativeDistance)
+                return;
+
+            Vector2D<float> normal = (distance > 1e-6f) ? (1.0f / distance) * offset : Vector2D<float>{ 0.0f, 1.0f };
+
+            collision.normal         = normal;
+            collision.pointCount     = 1;
+            collision.positions[0]   = centerB - (radiusB + 0.5f * separation) * normal;
+            collision.separations[0] = separation;
+            collision.features[0]    = 0;
+        }
+
+
+
+        void collideBoxCircle(const OrientedBox& box, const Vector2D<float>& center, float radius, Collision& collision)
+        {
+            Vector2D<float> offset = center - box.center;
+            Vector2D<float> local  = { dot(offset, box.axisX), dot(offset, box.axisY) };
+
+            Vector2D<float> closest = { std::clamp(local.x, -box.halfExtents.x, box.halfExtents.x),
+                                        std::clamp(local.y, -box.halfExtents.y, box.halfExtents.y) };
+
+            Vector2D<float> normal;
+            float           separation;
+
+            if (closest != local)
+            {
+                Vector2D<float> outside  = local - closest;
+                float           distance = std::sqrt(dot(outside, outside));
+
+                separation = distance - radius;
+
+                if (separation > speculativeDistance)
+                    return;
+
+                normal = (outside.x / distance) * box.axisX + (outside.y / distance) * box.axisY;
+            }
+            else
+            {
+                // The center is inside the box, so push it out through the closest face
+                float depthX = box.halfExtents.x - std::fabs(local.x);
+                float depthY = box.halfExtents.y - std::fabs(local.y);
+
+                if (depthX < depthY)
+                {
+                    normal     = (local.x < 0.0f) ? -box.axisX : box.axisX;
+                    separation = -depthX - radius;
+                }
+                else
+                {
+                    normal     = (local.y < 0.0f) ? -box.axisY : box.axisY;
+                    separation = -depthY - radius;
+                }
+            }
+
+            collision.normal         = normal;
+            collision.pointCount     = 1;
+            collision.positions[0]   = center - (radius + 0.5f * separation) * normal;
+            collision.separations[0] = separation;
+            collision.features[0]    = 0;
+        }
+
+
+
+        void collideBoxes(const OrientedBox& a, const OrientedBox& b, Collision& collision)
+        {
+            std::uint32_t edgeA;
+            float         separationA = findMaxSeparation(a, b, edgeA);
+
+            if (separationA > speculativeDistance)
+                return;
+
+            std::uint32_t edgeB;
+            float         separationB = findMaxSeparation(b, a, edgeB);
+
+            if (separationB > speculativeDistance)
+                return;
+
+            // The edge the other box is clipped against. Prefers a's unless b's is clearly
+            // better, so the choice doesn't flicker between steps
+            const OrientedBox* reference = &a;
+            const OrientedBox* incident  = &b;
+            std::uint32_t      edge      = edgeA;
+            bool               flip      = false;
+
+            if (separationB > separationA + 0.1f * linearSlop)
+            {
+                reference = &b;
+                incident  = &a;
+                edge      = edgeB;
+                flip      = true;
+            }
+
+            Vector2D<float> normal  = getNormal(*reference, edge);
+            Vector2D<float> tangent = { -normal.y, normal.x };
+            Vector2D<float> start   = getVertex(*reference, edge);
+            Vector2D<float> end     = getVertex(*reference, (edge + 1) & 3);
+
+            // The incident edge faces the reference edge the most
+            std::uint32_t incidentEdge = 0;
+            float         minDot       = std::numeric_limits<float>::infinity();
+
+            for (std::uint32_t i = 0; i < 4; i++)
+            {
+                float facing = dot(getNormal(*incident, i), normal);
+
+                if (facing < minDot)
+                {
+                    minDot       = facing;
+                    incidentEdge = i;
+                }
+            }
+
+            Vector2D<float> points[2] = { getVertex(*incident, incidentEdge), getVertex(*incident, (incidentEdge + 1) & 3) };
+
+            if (!clipSegment(points, -tangent, -dot(tangent, start)) || !clipSegment(points, tangent, dot(tangent, end)))
+                return;
+
+            collision.normal = flip ? -normal : normal;
+
+            for (std::uint32_t i = 0; i < 2; i++)
+            {
+                float separation = dot(normal, points[i] - start);
+
+                if (separation > speculativeDistance)
+                    continue;
+
+                std::uint32_t point = collision.pointCount++;
+
+                collision.positions[point]   = points[i] - (0.5f * separation) * normal;
+                collision.separations[point] = separation;
+                collision.features[point]    = (static_cast<std::uint32_t>(flip) << 12) | (edge << 8) | (incidentEdge << 4) | i;
+            }
+        }
+    }
+
+
+
+    PhysicsWorld2D::PhysicsWorld2D(float timestep, float cellSize) : m_grid(cellSize)
+    {
+        if (!(timestep > 0.0f) || !std::isfinite(timestep))
+            throw std::invalid_argument("Timestep must be positive and finite");
+
+        m_timestep = timestep;
+    }
+
+
+
+    void PhysicsWorld2D::setIterations(std::size_t count)
+    {
+        if (count == 0)
+            throw std::invalid_argument("Iteration count must be positive");
+
+        m_iterations = count;
+    }
+
+
+
+    BodyId PhysicsWorld2D::createBody(const BodyDef& def)
+    {
+        bool validShape = (def.shape == ShapeType::Circle) ? (def.radius > 0.0f && std::isfinite(def.radius))
+                                                           : (def.halfExtents.x > 0.0f && def.halfExtents.y > 0.0f && isFinite(def.halfExtents));
+
+        if (!validShape)
+            throw std::invalid_argument("Body shape must have a positive and finite size");
+
+        if (!isFinite(def.position) || !std::isfinite(def.angle) || !isFinite(def.velocity) || !std::isfinite(def.angularVelocity))
+            throw std::invalid_argument("Body position and velocity must be finite");
+
+        if (!(def.density >= 0.0f) || !(def.friction >= 0.0f) || !(def.restitution >= 0.0f) ||
+            !std::isfinite(def.density) || !std::isfinite(def.friction) || !std::isfinite(def.restitution))
+            throw std::invalid_argument("Body density, friction and restitution must be positive or zero and finite");
+
+        if (m_ids.size() >= std::numeric_limits<std::uint32_t>::max() - 1)
+            throw std::length_error("Too many bodies");
+
+        // Reserves everything first, so nothing below throws once the grid has the proxy
+        if (m_ids.size() == m_ids.capacity())
+        {
+            std::size_t capacity = std::max<std::size_t>(m_ids.capacity() * 2, 64);
+
+            m_ids.reserve(capacity);
+            m_shapes.reserve(capacity);
+            m_extents.reserve(capacity);
+            m_positions.reserve(capacity);
+            m_angles.reserve(capacity);
+            m_rotations.reserve(capacity);
+            m_velocities.reserve(capacity);
+            m_angularVelocities.reserve(capacity);
+            m_inverseMasses.reserve(capacity);
+            m_inverseInertias.reserve(capacity);
+            m_frictions.reserve(capacity);
+            m_restitutions.reserve(capacity);
+            m_proxies.reserve(capacity);
+            m_bounds.reserve(capacity);
+            m_sleepTimes.reserve(capacity);
+            m_asleep.reserve(capacity);
+        }
+
+        if (m_freeIds.empty() && m_indices.size() == m_indices.capacity())
+        {
+            m_indices.reserve(std::max<std::size_t>(m_indices.capacity() * 2, 64));
+            m_freeIds.reserve(m_indices.capacity());
+        }
+
+        // The grid reuses proxy ids before handing out new ones, so the new id is at most
+        // the proxy count
+        if (m_grid.getProxyCount() + 1 > m_proxyBodies.capacity())
+            m_proxyBodies.reserve(std::max<std::size_t>(m_proxyBodies.capacity() * 2, 64));
+
+        Vector2D<float> extents = (def.shape == ShapeType::Circle) ? Vector2D<float>{ def.radius, def.radius } : def.halfExtents;
+        Vector2D<float> rotation = { std::cos(def.angle), std::sin(def.angle) };
+
+        m_ids.push_back(noBody);
+        m_shapes.push_back(def.shape);
+        m_extents.push_back(extents);
+        m_positions.push_back(def.position);
+        m_angles.push_back(def.angle);
+        m_rotations.push_back(rotation);
+
+        std::uint32_t index  = static_cast<std::uint32_t>(m_ids.size() - 1);
+        AABB2D<float> bounds = expand(computeBounds(index), proxyMargin);
+        ProxyId       proxy;
+
+        try
+        {
+            proxy = m_grid.create(bounds);
+        }
+        catch (...)
+        {
+            m_ids.pop_back();
+            m_shapes.pop_back();
+            m_extents.pop_back();
+            m_positions.pop_back();
+            m_angles.pop_back();
+            m_rotations.pop_back();
+            throw;
+        }
+
+        BodyId id;
+
+        if (!m_freeIds.empty())
+        {
+            id = m_freeIds.back();
+            m_freeIds.pop_back();
+        }
+        else
+        {
+            id = static_cast<BodyId>(m_indices.size());
+            m_indices.push_back(noIndex);
+        }
+
+        float           inverseMass     = 0.0f;
+        float           inverseInertia  = 0.0f;
+        Vector2D<float> velocity        = { 0.0f, 0.0f };
+        float           angularVelocity = 0.0f;
+
+        if (def.density > 0.0f)
+        {
+            float mass;
+            float inertia;
+
+            if (def.shape == ShapeType::Circle)
+            {
+                mass    = def.density * 3.14159265f * def.radius * def.radius;
+                inertia = 0.5f * mass * def.radius * def.radius;
+            }
+            else
+            {
+                mass    = def.density * 4.0f * def.halfExtents.x * def.halfExtents.y;
+                inertia = mass * (def.halfExtents.x * def.halfExtents.x + def.halfExtents.y * def.halfExtents.y) / 3.0f;
+            }
+
+            inverseMass     = 1.0f / mass;
+            inverseInertia  = 1.0f / inertia;
+            velocity        = def.velocity;
+            angularVelocity = def.angularVelocity;
+        }
+
+        m_ids[index] = id;
+        m_velocities.push_back(velocity);
+        m_angularVelocities.push_back(angularVelocity);
+        m_inverseMasses.push_back(inverseMass);
+        m_inverseInertias.push_back(inverseInertia);
+        m_frictions.push_back(def.friction);
+        m_restitutions.push_back(def.restitution);
+        m_proxies.push_back(proxy);
+        m_bounds.push_back(bounds);
+        m_sleepTimes.push_back(0.0f);
+        m_asleep.push_back(0);
+
+        m_indices[id] = index;
+
+        if (proxy >= m_proxyBodies.size())
+            m_proxyBodies.resize(proxy + 1, noBody);
+
+        m_proxyBodies[proxy] = id;
+
+        return id;
+    }
+
+
+
+    void PhysicsWorld2D::destroyBody(BodyId id)
+    {
+        std::uint32_t index = getIndex(id);
+
+        // The bodies it held up have to notice it's gone
+        std::erase_if(m_manifolds, [this, id](const Manifold& manifold) {
+            BodyId first  = static_cast<BodyId>(manifold.key >> 32);
+            BodyId second = static_cast<BodyId>(manifold.key);
+
+            if (first != id && second != id)
+                return false;
+
+            wake(m_indices[(first == id) ? second : first]);
+            return true;
+        });
+
+        m_grid.destroy(m_proxies[index]);
+        m_proxyBodies[m_proxies[index]] = noBody;
+
+        // Moves the last body into the hole
+        std::uint32_t last = static_cast<std::uint32_t>(m_ids.size() - 1);
+
+        auto remove = [index, last](auto& array) {
+            array[index] = array[last];
+            array.pop_back();
+        };
+
+        remove(m_ids);
+        remove(m_shapes);
+        remove(m_extents);
+        remove(m_positions);
+        remove(m_angles);
+        remove(m_rotations);
+        remove(m_velocities);
+        remove(m_angularVelocities);
+        remove(m_inverseMasses);
+        remove(m_inverseInertias);
+        remove(m_frictions);
+        remove(m_restitutions);
+        remove(m_proxies);
+        remove(m_bounds);
+        remove(m_sleepTimes);
+        remove(m_asleep);
+
+        if (index != last)
+            m_indices[m_ids[index]] = index;
+
+        m_indices[id] = noIndex;
+        m_freeIds.push_back(id);
+    }
+
+
+
+    bool PhysicsWorld2D::isAlive(BodyId id) const
+    {
+        return id < m_indices.size() && m_indices[id] != noIndex;
+    }
+
+
+
+    Vector2D<float> PhysicsWorld2D::getPosition(BodyId id) const
+    {
+        return m_positions[getIndex(id)];
+    }
+
+
+
+    float PhysicsWorld2D::getAngle(BodyId id) const
+    {
+        return m_angles[getIndex(id)];
+    }
+
+
+
+    Vector2D<float> PhysicsWorld2D::getVelocity(BodyId id) const
+    {
+        return m_velocities[getIndex(id)];
+    }
+
+
+
+    float PhysicsWorld2D::getAngularVelocity(BodyId id) const
+    {
+        return m_angularVelocities[getIndex(id)];
+    }
+
+
+
+    bool PhysicsWorld2D::isStatic(BodyId id) const
+    {
+        return m_inverseMasses[getIndex(id)] == 0.0f;
+    }
+
+
+
+    bool PhysicsWorld2D::isAwake(BodyId id) const
+    {
+        std::uint32_t index = getIndex(id);
+        return m_inverseMasses[index] > 0.0f && !m_asleep[index];
+    }
+
+
+
+    void PhysicsWorld2D::setTransform(BodyId id, const Vector2D<float>& position, float angle)
+    {
+        std::uint32_t index = getIndex(id);
+
+        if (!isFinite(position) || !std::isfinite(angle))
+            throw std::invalid_argument("Body position must be finite");
+
+        m_positions[index] = position;
+        m_angles[index]    = angle;
+        m_rotations[index] = { std::cos(angle), std::sin(angle) };
+        m_bounds[index]    = expand(computeBounds(index), proxyMargin);
+
+        m_grid.move(m_proxies[index], m_bounds[index]);
+        wake(index);
+    }
+
+
+
+    void PhysicsWorld2D::setVelocity(BodyId id, const Vector2D<float>& velocity, float angularVelocity)
+    {
+        std::uint32_t index = getIndex(id);
+
+        if (!isFinite(velocity) || !std::isfinite(angularVelocity))
+            throw std::invalid_argument("Body velocity must be finite");
+
+        if (m_inverseMasses[index] == 0.0f)
+            return;
+
+        m_velocities[index]        = velocity;
+        m_angularVelocities[index] = angularVelocity;
+
+        wake(index);
+    }
+
+
+
+    void PhysicsWorld2D::applyImpulse(BodyId id, const Vector2D<float>& impulse, const Vector2D<float>& point)
+    {
+        std::uint32_t index = getIndex(id);
+
+        if (!isFinite(impulse) || !isFinite(point))
+            throw std::invalid_argument("Impulse and point must be finite");
+
+        m_velocities[index]         = m_velocities[index] + m_inverseMasses[index] * impulse;
+        m_angularVelocities[index] += m_inverseInertias[index] * cross(point - m_positions[index], impulse);
+
+        wake(index);
+    }
+
+
+
+    void PhysicsWorld2D::step()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        findContacts();
+        buildIslands();
+        integrateVelocities();
+        prepareConstraints();
+        solveConstraints();
+        integratePositions();
+        synchronizeProxies();
+    }
+
+
+
+    std::size_t PhysicsWorld2D::advance(float elapsed)
+    {
+        if (!(elapsed >= 0.0f) || !std::isfinite(elapsed))
+            throw std::invalid_argument("Elapsed time must be positive or zero and finite");
+
+        m_accumulator += elapsed;
+
+        std::size_t steps = 0;
+
+        while (m_accumulator >= m_timestep)
+        {
+            if (steps == maxStepsPerAdvance)
+            {
+                m_accumulator = std::fmod(m_accumulator, m_timestep);
+                break;
+            }
+
+            step();
+
+            m_accumulator -= m_timestep;
+            steps++;
+        }
+
+        return steps;
+    }
+
+
+
+    std::uint32_t PhysicsWorld2D::getIndex(BodyId id) const
+    {
+        if (!isAlive(id))
+            throw std::invalid_argument("Body isn't alive");
+
+        return m_indices[id];
+    }
+
+
+
+    void PhysicsWorld2D::wake(std::uint32_t index)
+    {
+        m_asleep[index]     = 0;
+        m_sleepTimes[index] = 0.0f;
+    }
+
+
+
+    AABB2D<float> PhysicsWorld2D::computeBounds(std::uint32_t index) const
+    {
+        const Vector2D<float>& position = m_positions[index];
+        const Vector2D<float>& extents  = m_extents[index];
+
+        Vector2D<float> reach = extents;
+
+        if (m_shapes[index] == ShapeType::Box)
+        {
+            float cosine = std::fabs(m_rotations[index].x);
+            float sine   = std::fabs(m_rotations[index].y);
+
+            reach = { extents.x * cosine + extents.y * sine, extents.x * sine + extents.y * cosine };
+        }
+
+        return { position - reach, position + reach };
+    }
+
+
+
+    void PhysicsWorld2D::findContacts()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        m_grid.findPairs(m_pairs);
+
+        // Sorting by body ids makes the step independent of the grid's order, and the
+        // manifolds come out sorted for the next step to search
+        m_pairKeys.clear();
+
+        for (const ProxyPair& pair : m_pairs)
+        {
+            BodyId first  = m_proxyBodies[pair.first];
+            BodyId second = m_proxyBodies[pair.second];
+
+            if (m_inverseMasses[m_indices[first]] == 0.0f && m_inverseMasses[m_indices[second]] == 0.0f)
+                continue;
+
+            if (first > second)
+                std::swap(first, second);
+
+            m_pairKeys.push_back((static_cast<std::uint64_t>(first) << 32) | second);
+        }
+
+        std::sort(m_pairKeys.begin(), m_pairKeys.end());
+
+        m_newManifolds.resize(m_pairKeys.size());
+
+        Jobs::parallelFor(m_pairKeys.size(), contactGrainSize, [this](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                Manifold& manifold = m_newManifolds[i];
+
+                manifold.key        = m_pairKeys[i];
+                manifold.bodyA      = m_indices[static_cast<BodyId>(manifold.key >> 32)];
+                manifold.bodyB      = m_indices[static_cast<BodyId>(manifold.key)];
+                manifold.pointCount = 0;
+
+                auto old = std::lower_bound(m_manifolds.begin(), m_manifolds.end(), manifold.key, [](const Manifold& existing, std::uint64_t key) {
+                    return existing.key < key;
+                });
+
+                bool found = (old != m_manifolds.end() && old->key == manifold.key);
+
+                // Bodies at rest haven't moved since the old manifold was made
+                auto isResting = [this](std::uint32_t index) {
+                    return m_inverseMasses[index] == 0.0f || m_asleep[index];
+                };
+
+                if (found && isResting(manifold.bodyA) && isResting(manifold.bodyB))
+                {
+                    manifold.normal     = old->normal;
+                    manifold.pointCount = old->pointCount;
+                    std::copy_n(old->points, old->pointCount, manifold.points);
+                    continue;
+                }
+
+                collide(manifold);
+
+                if (!found)
+                    continue;
+
+                for (std::uint32_t j = 0; j < manifold.pointCount; j++)
+                {
+                    ContactPoint& point = manifold.points[j];
+
+                    for (std::uint32_t k = 0; k < old->pointCount; k++)
+                    {
+                        if (old->points[k].feature == point.feature)
+                        {
+                            point.normalImpulse  = old->points[k].normalImpulse;
+                            point.tangentImpulse = old->points[k].tangentImpulse;
+                            break;
+                        }
+                    }
+                }
+            }
+        });
+
+        std::erase_if(m_newManifolds, [](const Manifold& manifold) {
+            return manifold.pointCount == 0;
+        });
+
+        std::swap(m_manifolds, m_newManifolds);
+    }
+
+
+
+    void PhysicsWorld2D::collide(Manifold& manifold) const
+    {
+        std::uint32_t a = manifold.bodyA;
+        std::uint32_t b = manifold.bodyB;
+
+        auto getBox = [this](std::uint32_t index) {
+            const Vector2D<float>& rotation = m_rotations[index];
+            return OrientedBox{ m_positions[index], rotation, { -rotation.y, rotation.x }, m_extents[index] };
+        };
+
+        Collision collision;
+
+        if (m_shapes[a] == ShapeType::Box && m_shapes[b] == ShapeType::Box)
+        {
+            collideBoxes(getBox(a), getBox(b), collision);
+        }
+        else if (m_shapes[a] == ShapeType::Box)
+        {
+            collideBoxCircle(getBox(a), m_positions[b], m_extents[b].x, collision);
+        }
+        else if (m_shapes[b] == ShapeType::Box)
+        {
+            collideBoxCircle(getBox(b), m_positions[a], m_extents[a].x, collision);
+            collision.normal = -collision.normal;
+        }
+        else
+        {
+            collideCircles(m_positions[a], m_extents[a].x, m_positions[b], m_extents[b].x, collision);
+        }
+
+        manifold.normal     = collision.normal;
+        manifold.pointCount = collision.pointCount;
+
+        for (std::uint32_t i = 0; i < collision.pointCount; i++)
+            manifold.points[i] = { collision.positions[i], collision.separations[i], collision.features[i], 0.0f, 0.0f };
+    }
+
+
+
+    void PhysicsWorld2D::buildIslands()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        std::size_t count = m_ids.size();
+
+        m_islandParents.resize(count);
+        std::iota(m_islandParents.begin(), m_islandParents.end(), 0);
+
+        // Static bodies don't join islands, or everything on the ground would be one
+        for (const Manifold& manifold : m_manifolds)
+        {
+            if (m_inverseMasses[manifold.bodyA] == 0.0f || m_inverseMasses[manifold.bodyB] == 0.0f)
+                continue;
+
+            std::uint32_t rootA = findIsland(manifold.bodyA);
+            std::uint32_t rootB = findIsland(manifold.bodyB);
+
+            if (rootA != rootB)
+                m_islandParents[std::max(rootA, rootB)] = std::min(rootA, rootB);
+        }
+
+        // An island stays awake while any of its bodies is moving
+        m_islandAwake.assign(count, 0);
+        m_islandCount = 0;
+
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            if (m_inverseMasses[i] == 0.0f)
+                continue;
+
+            std::uint32_t root = findIsland(i);
+
+            if (root == i)
+                m_islandCount++;
+
+            if (m_sleepTimes[i] < timeToSleep)
+                m_islandAwake[root] = 1;
+        }
+
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            if (m_inverseMasses[i] == 0.0f)
+                continue;
+
+            bool asleep = !m_islandAwake[findIsland(i)];
+
+            if (asleep && !m_asleep[i])
+            {
+                m_velocities[i]        = { 0.0f, 0.0f };
+                m_angularVelocities[i] = 0.0f;
+            }
+
+            m_asleep[i] = asleep;
+        }
+    }
+
+
+
+    std::uint32_t PhysicsWorld2D::findIsland(std::uint32_t index)
+    {
+        // Path halving
+        while (m_islandParents[index] != index)
+        {
+            m_islandParents[index] = m_islandParents[m_islandParents[index]];
+            index                  = m_islandParents[index];
+        }
+
+        return index;
+    }
+
+
+
+    void PhysicsWorld2D::integrateVelocities()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        Vector2D<float> change = m_timestep * m_gravity;
+
+        Jobs::parallelFor(m_ids.size(), bodyGrainSize, [this, change](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                if (m_inverseMasses[i] > 0.0f && !m_asleep[i])
+                    m_velocities[i] = m_velocities[i] + change;
+            }
+        });
+    }
+
+
+
+    void PhysicsWorld2D::prepareConstraints()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        // Greedy coloring: each contact takes the lowest color neither of its moving bodies
+        // has yet. Static bodies are only read, so any number of contacts of a color may
+        // share one
+        m_colorMasks.assign(m_ids.size(), 0);
+        m_colors.resize(m_manifolds.size());
+
+        std::uint32_t colorCounts[maxColors + 1] = {};
+
+        for (std::size_t i = 0; i < m_manifolds.size(); i++)
+        {
+            std::uint32_t a = m_manifolds[i].bodyA;
+            std::uint32_t b = m_manifolds[i].bodyB;
+
+            bool movingA = m_inverseMasses[a] > 0.0f && !m_asleep[a];
+            bool movingB = m_inverseMasses[b] > 0.0f && !m_asleep[b];
+
+            if (!movingA && !movingB)
+            {
+                m_colors[i] = noColor;
+                continue;
+            }
+
+            std::uint32_t taken = (movingA ? m_colorMasks[a] : 0) | (movingB ? m_colorMasks[b] : 0);
+            std::uint32_t color = static_cast<std::uint32_t>(std::countr_zero(~taken)); // maxColors if all are taken
+
+            if (color < maxColors)
+            {
+                if (movingA)
+                    m_colorMasks[a] |= 1u << color;
+
+                if (movingB)
+                    m_colorMasks[b] |= 1u << color;
+            }
+
+            m_colors[i] = color;
+            colorCounts[color]++;
+        }
+
+        m_colorStarts.resize(maxColors + 2);
+        m_colorStarts[0] = 0;
+        m_colorCount     = 0;
+
+        for (std::uint32_t color = 0; color <= maxColors; color++)
+        {
+            m_colorStarts[color + 1] = m_colorStarts[color] + colorCounts[color];
+
+            if (colorCounts[color] > 0)
+                m_colorCount++;
+        }
+
+        m_constraints.resize(m_colorStarts[maxColors + 1]);
+
+        std::copy_n(m_colorStarts.begin(), maxColors + 1, colorCounts);
+
+        for (std::size_t i = 0; i < m_manifolds.size(); i++)
+        {
+            if (m_colors[i] != noColor)
+                m_constraints[colorCounts[m_colors[i]]++].manifold = static_cast<std::uint32_t>(i);
+        }
+
+        float inverseTimestep = 1.0f / m_timestep;
+
+        Jobs::parallelFor(m_constraints.size(), constraintGrainSize, [this, inverseTimestep](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                Constraint&     constraint = m_constraints[i];
+                const Manifold& manifold   = m_manifolds[constraint.manifold];
+
+                std::uint32_t a = manifold.bodyA;
+                std::uint32_t b = manifold.bodyB;
+
+                constraint.bodyA      = a;
+                constraint.bodyB      = b;
+                constraint.pointCount = manifold.pointCount;
+                constraint.normal     = manifold.normal;
+                constraint.friction   = std::sqrt(m_frictions[a] * m_frictions[b]);
+
+                float restitution = std::max(m_restitutions[a], m_restitutions[b]);
+
+                float massA    = m_inverseMasses[a];
+                float massB    = m_inverseMasses[b];
+                float inertiaA = m_inverseInertias[a];
+                float inertiaB = m_inverseInertias[b];
+
+                Vector2D<float> normal  = manifold.normal;
+                Vector2D<float> tangent = { normal.y, -normal.x };
+
+                for (std::uint32_t j = 0; j < manifold.pointCount; j++)
+                {
+                    const ContactPoint& contact = manifold.points[j];
+                    ConstraintPoint&    point   = constraint.points[j];
+
+                    point.anchorA        = contact.position - m_positions[a];
+                    point.anchorB        = contact.position - m_positions[b];
+                    point.normalImpulse  = contact.normalImpulse;
+                    point.tangentImpulse = contact.tangentImpulse;
+
+                    float normalA  = cross(point.anchorA, normal);
+                    float normalB  = cross(point.anchorB, normal);
+                    float tangentA = cross(point.anchorA, tangent);
+                    float tangentB = cross(point.anchorB, tangent);
+
+                    float normalK  = massA + massB + inertiaA * normalA * normalA + inertiaB * normalB * normalB;
+                    float tangentK = massA + massB + inertiaA * tangentA * tangentA + inertiaB * tangentB * tangentB;
+
+                    point.normalMass  = (normalK > 0.0f) ? 1.0f / normalK : 0.0f;
+                    point.tangentMass = (tangentK > 0.0f) ? 1.0f / tangentK : 0.0f;
+
+                    // A gap may close within the step but no further; an overlap beyond the
+                    // slop is pushed apart a fraction at a time
+                    if (contact.separation > 0.0f)
+                        point.targetVelocity = -contact.separation * inverseTimestep;
+                    else
+                        point.targetVelocity = std::min(baumgarteFactor * inverseTimestep * std::max(-contact.separation - linearSlop, 0.0f), maxCorrectionSpeed);
+
+                    Vector2D<float> relative = m_velocities[b] + cross(m_angularVelocities[b], point.anchorB) -
+                                               m_velocities[a] - cross(m_angularVelocities[a], point.anchorA);
+
+                    float normalVelocity = dot(relative, normal);
+
+                    if (normalVelocity < -restitutionThreshold)
+                        point.targetVelocity = std::max(point.targetVelocity, -restitution * normalVelocity);
+                }
+
+                // Two points are solved together so neither takes the whole load first and
+                // tips the body, unless they're so close they're effectively one
+                if (constraint.pointCount == 2)
+                {
+                    const ConstraintPoint& point1 = constraint.points[0];
+                    const ConstraintPoint& point2 = constraint.points[1];
+
+                    float normal1A = cross(point1.anchorA, normal);
+                    float normal1B = cross(point1.anchorB, normal);
+                    float normal2A = cross(point2.anchorA, normal);
+                    float normal2B = cross(point2.anchorB, normal);
+
+                    float k11 = massA + massB + inertiaA * normal1A * normal1A + inertiaB * normal1B * normal1B;
+                    float k22 = massA + massB + inertiaA * normal2A * normal2A + inertiaB * normal2B * normal2B;
+                    float k12 = massA + massB + inertiaA * normal1A * normal2A + inertiaB * normal1B * normal2B;
+
+                    float determinant = k11 * k22 - k12 * k12;
+
+                    if (k11 * k11 < 1000.0f * determinant)
+                    {
+                        constraint.matrix[0]        = k11;
+                        constraint.matrix[1]        = k12;
+                        constraint.matrix[2]        = k22;
+                        constraint.inverseMatrix[0] = k22 / determinant;
+                        constraint.inverseMatrix[1] = -k12 / determinant;
+                        constraint.inverseMatrix[2] = k11 / determinant;
+                    }
+                    else
+                    {
+                        constraint.pointCount = 1;
+                    }
+                }
+            }
+        });
+    }
+
+
+
+    void PhysicsWorld2D::solveConstraints()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        // Runs the function over the constraints color by color. Within a color no two
+        // constraints write the same body, so they can run in any order on any thread
+        auto forEachColor = [this](auto&& function) {
+            for (std::uint32_t color = 0; color <= maxColors; color++)
+            {
+                std::size_t begin = m_colorStarts[color];
+                std::size_t count = m_colorStarts[color + 1] - begin;
+
+                if (count < parallelThreshold || color == maxColors)
+                {
+                    for (std::size_t i = begin; i < begin + count; i++)
+                        function(m_constraints[i]);
+                }
+                else
+                {
+                    Jobs::parallelFor(count, constraintGrainSize, [this, begin, &function](std::size_t first, std::size_t last) {
+                        for (std::size_t i = begin + first; i < begin + last; i++)
+                            function(m_constraints[i]);
+                    });
+                }
+            }
+        };
+
+        // Static bodies have no mass, so their velocities never change and aren't written
+        // back; they're shared between constraints of the same color
+        auto applyImpulses = [this](const Constraint& constraint, auto&& computeImpulses) {
+            std::uint32_t a = constraint.bodyA;
+            std::uint32_t b = constraint.bodyB;
+
+            float massA    = m_inverseMasses[a];
+            float massB    = m_inverseMasses[b];
+            float inertiaA = m_inverseInertias[a];
+            float inertiaB = m_inverseInertias[b];
+
+            Vector2D<float> velocityA        = m_velocities[a];
+            Vector2D<float> velocityB        = m_velocities[b];
+            float           angularVelocityA = m_angularVelocities[a];
+            float           angularVelocityB = m_angularVelocities[b];
+
+            auto apply = [&](const ConstraintPoint& point, const Vector2D<float>& impulse) {
+                velocityA         = velocityA - massA * impulse;
+                angularVelocityA -= inertiaA * cross(point.anchorA, impulse);
+                velocityB         = velocityB + massB * impulse;
+                angularVelocityB += inertiaB * cross(point.anchorB, impulse);
+            };
+
+            auto getRelativeVelocity = [&](const ConstraintPoint& point) {
+                return velocityB + cross(angularVelocityB, point.anchorB) - velocityA - cross(angularVelocityA, point.anchorA);
+            };
+
+            computeImpulses(apply, getRelativeVelocity);
+
+            if (massA > 0.0f)
+            {
+                m_velocities[a]        = velocityA;
+                m_angularVelocities[a] = angularVelocityA;
+            }
+
+            if (massB > 0.0f)
+            {
+                m_velocities[b]        = velocityB;
+                m_angularVelocities[b] = angularVelocityB;
+            }
+        };
+
+        // Warm start with the impulses carried over from the previous step
+        forEachColor([&applyImpulses](Constraint& constraint) {
+            applyImpulses(constraint, [&constraint](auto&& apply, auto&&) {
+                Vector2D<float> normal  = constraint.normal;
+                Vector2D<float> tangent = { normal.y, -normal.x };
+
+                for (std::uint32_t j = 0; j < constraint.pointCount; j++)
+                {
+                    const ConstraintPoint& point = constraint.points[j];
+                    apply(point, point.normalImpulse * normal + point.tangentImpulse * tangent);
+                }
+            });
+        });
+
+        for (std::size_t iteration = 0; iteration < m_iterations; iteration++)
+        {
+            forEachColor([&applyImpulses](Constraint& constraint) {
+                applyImpulses(constraint, [&constraint](auto&& apply, auto&& getRelativeVelocity) {
+                    Vector2D<float> normal  = constraint.normal;
+                    Vector2D<float> tangent = { normal.y, -normal.x };
+
+                    // Friction first, as keeping the bodies apart matters more
+                    for (std::uint32_t j = 0; j < constraint.pointCount; j++)
+                    {
+                        ConstraintPoint& point = constraint.points[j];
+
+                        float limit    = constraint.friction * point.normalImpulse;
+                        float impulse  = -point.tangentMass * dot(getRelativeVelocity(point), tangent);
+                        float combined = std::clamp(point.tangentImpulse + impulse, -limit, limit);
+
+                        impulse              = combined - point.tangentImpulse;
+                        point.tangentImpulse = combined;
+
+                        apply(point, impulse * tangent);
+                    }
+
+                    if (constraint.pointCount == 1)
+                    {
+                        ConstraintPoint& point = constraint.points[0];
+
+                        float impulse  = point.normalMass * (point.targetVelocity - dot(getRelativeVelocity(point), normal));
+                        float combined = std::max(point.normalImpulse + impulse, 0.0f);
+
+                        impulse             = combined - point.normalImpulse;
+                        point.normalImpulse = combined;
+
+                        apply(point, impulse * normal);
+                        return;
+                    }
+
+                    // The impulses x of both points solve the linear complementarity problem
+                    // x >= 0, K x + b >= 0 and x . (K x + b) = 0, whose solution is one of
+                    // four cases depending on which points are pushing
+                    ConstraintPoint& point1 = constraint.points[0];
+                    ConstraintPoint& point2 = constraint.points[1];
+
+                    const float* k        = constraint.matrix;
+                    const float* inverseK = constraint.inverseMatrix;
+
+                    float old1 = point1.normalImpulse;
+                    float old2 = point2.normalImpulse;
+
+                    float b1 = dot(getRelativeVelocity(point1), normal) - point1.targetVelocity - (k[0] * old1 + k[1] * old2);
+                    float b2 = dot(getRelativeVelocity(point2), normal) - point2.targetVelocity - (k[1] * old1 + k[2] * old2);
+
+                    float x1 = -(inverseK[0] * b1 + inverseK[1] * b2);
+                    float x2 = -(inverseK[1] * b1 + inverseK[2] * b2);
+
+                    if (x1 < 0.0f || x2 < 0.0f)
+                    {
+                        x1 = -point1.normalMass * b1;
+                        x2 = 0.0f;
+
+                        if (x1 < 0.0f || k[1] * x1 + b2 < 0.0f)
+                        {
+                            x1 = 0.0f;
+                            x2 = -point2.normalMass * b2;
+
+                            if (x2 < 0.0f || k[1] * x2 + b1 < 0.0f)
+                            {
+                                // Neither point pushing is the last case left, and the
+                                // best answer even if the velocities don't fit it
+                                x1 = 0.0f;
+                                x2 = 0.0f;
+                            }
+                        }
+                    }
+
+                    point1.normalImpulse = x1;
+                    point2.normalImpulse = x2;
+
+                    apply(point1, (x1 - old1) * normal);
+                    apply(point2, (x2 - old2) * normal);
+                });
+            });
+        }
+
+        // Keep the impulses for the next step's warm start
+        Jobs::parallelFor(m_constraints.size(), constraintGrainSize, [this](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                const Constraint& constraint = m_constraints[i];
+                Manifold&         manifold   = m_manifolds[constraint.manifold];
+
+                for (std::uint32_t j = 0; j < constraint.pointCount; j++)
+                {
+                    manifold.points[j].normalImpulse  = constraint.points[j].normalImpulse;
+                    manifold.points[j].tangentImpulse = constraint.points[j].tangentImpulse;
+                }
+            }
+        });
+    }
+
+
+
+    void PhysicsWorld2D::integratePositions()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        float timestep = m_timestep;
+
+        Jobs::parallelFor(m_ids.size(), bodyGrainSize, [this, timestep](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                if (m_inverseMasses[i] == 0.0f || m_asleep[i])
+                    continue;
+
+                const Vector2D<float>& velocity        = m_velocities[i];
+                float                  angularVelocity = m_angularVelocities[i];
+
+                m_positions[i] = m_positions[i] + timestep * velocity;
+
+                if (angularVelocity != 0.0f)
+                {
+                    m_angles[i]   += timestep * angularVelocity;
+                    m_rotations[i] = { std::cos(m_angles[i]), std::sin(m_angles[i]) };
+                }
+
+                bool still = dot(velocity, velocity) < sleepLinearSpeed * sleepLinearSpeed &&
+                             std::fabs(angularVelocity) < sleepAngularSpeed;
+
+                m_sleepTimes[i] = still ? m_sleepTimes[i] + timestep : 0.0f;
+            }
+        });
+    }
+
+
+
+    void PhysicsWorld2D::synchronizeProxies()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        // The grid isn't safe to change from several threads, but most bodies stay inside
+        // their grown bounds and are skipped
+        for (std::uint32_t i = 0; i < m_ids.size(); i++)
+        {
+            if (m_inverseMasses[i] == 0.0f || m_asleep[i])
+                continue;
+
+            AABB2D<float> bounds = computeBounds(i);
+
+            if (contains(m_bounds[i], expand(bounds, 0.5f * speculativeDistance)))
+                continue;
+
+            m_bounds[i] = expand(bounds, proxyMargin);
+            m_grid.move(m_proxies[i], m_bounds[i]);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,373 @@
+//
+// 2D rigid body physics.
+//
+// Bodies are circles and boxes, kept in flat arrays with one array per property (position,
+// velocity, mass and so on) packed at the front with no holes, so each stage of a step is
+// a linear pass over only the properties it needs. Body ids map to array indices through
+// a table, and destroying a body moves the last one into its place.
+//
+// A step finds the pairs of bodies whose boxes overlap with a spatial hash grid, turns
+// them into contact manifolds in parallel, and groups the bodies touching each other into
+// islands with a union-find pass. Islands whose bodies have all been still for a while
+// fall asleep and cost nothing until something touches them. The contacts of the awake
+// islands are solved with sequential impulses: they're colored so that no two contacts of
+// the same color share a moving body, and the contacts of each color are solved in
+// parallel since they can't write the same velocities. Impulses are carried over from the
+// previous step's matching contacts (warm starting), so stacks settle in a few
+// iterations.
+//
+// step advances the world by one timestep. advance accumulates real elapsed time and runs
+// as many whole steps as fit, so the simulation runs at the same fixed rate however fast
+// frames come; the leftover fraction of a step is returned by getInterpolation for
+// drawing bodies between their last two states.
+//
+// Distances are meant to be in meters, with bodies around 0.1 to 10 meters across.
+//
+
+#ifndef CEDAR_PHYSICS_PHYSICS_WORLD_2D_H
+#define CEDAR_PHYSICS_PHYSICS_WORLD_2D_H
+
+#include "../math/aabb.h"
+#include "../math/vector.h"
+#include "../memory/memory_tracker.h"
+#include "spatial_hash_grid.h"
+#include "spatial_query.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+
+namespace Cedar::Physics
+{
+    enum class ShapeType : std::uint8_t;
+
+    struct BodyDef;
+
+    class PhysicsWorld2D;
+
+
+
+    typedef std::uint32_t BodyId;
+
+    constexpr BodyId noBody = 0xFFFF'FFFF;
+
+
+
+    enum class ShapeType : std::uint8_t
+    {
+        Circle,
+        Box
+    };
+
+
+
+    struct BodyDef
+    {
+        ShapeType       shape           = ShapeType::Box;
+        float           radius          = 0.5f;             // Circles
+        Vector2D<float> halfExtents     = { 0.5f, 0.5f };   // Boxes
+
+        Vector2D<float> position        = { 0.0f, 0.0f };
+        float           angle           = 0.0f;             // Radians, counterclockwise
+        Vector2D<float> velocity        = { 0.0f, 0.0f };
+        float           angularVelocity = 0.0f;
+
+        float           density         = 1.0f;             // 0 for static bodies
+        float           friction        = 0.5f;
+        float           restitution     = 0.0f;
+    };
+
+
+
+    class PhysicsWorld2D
+    {
+    public:
+
+        static constexpr float       defaultTimestep   = 1.0f / 60.0f;
+        static constexpr float       defaultCellSize   = 1.0f;
+        static constexpr std::size_t defaultIterations = 8;
+
+        // advance drops the time it's behind by beyond this many steps, so a slow frame
+        // doesn't make the next one slower still.
+        static constexpr std::size_t maxStepsPerAdvance = 8;
+
+        // Colors with fewer contacts than this are solved on the calling thread.
+        static constexpr std::size_t parallelThreshold = 256;
+
+
+        // The cell size of the broadphase grid should be about the size of a typical body.
+        // Throws std::invalid_argument if the timestep or the cell size isn't positive and
+        // finite.
+        explicit PhysicsWorld2D(float timestep = defaultTimestep, float cellSize = defaultCellSize);
+
+
+        inline float getTimestep() const;
+
+        inline const Vector2D<float>& getGravity() const;
+
+        inline void setGravity(const Vector2D<float>& gravity);
+
+        inline std::size_t getIterations() const;
+
+        // Throws std::invalid_argument if the count is 0.
+        void setIterations(std::size_t count);
+
+
+        // Returns the new body's id. Ids are reused once the body is destroyed. Throws
+        // std::invalid_argument if a value isn't finite, the shape's size isn't positive,
+        // or the density, friction or restitution is negative.
+        BodyId createBody(const BodyDef& def);
+
+        // Wakes the bodies touching it. Throws std::invalid_argument if the body isn't
+        // alive.
+        void destroyBody(BodyId id);
+
+        bool isAlive(BodyId id) const;
+
+        inline std::size_t getBodyCount() const;
+
+
+        // Throw std::invalid_argument if the body isn't alive.
+        Vector2D<float> getPosition(BodyId id) const;
+
+        float getAngle(BodyId id) const;
+
+        Vector2D<float> getVelocity(BodyId id) const;
+
+        float getAngularVelocity(BodyId id) const;
+
+        bool isStatic(BodyId id) const;
+
+        bool isAwake(BodyId id) const;
+
+        // Teleports the body and wakes it.
+        void setTransform(BodyId id, const Vector2D<float>& position, float angle);
+
+        // Wakes the body. Static bodies don't move whatever their velocity.
+        void setVelocity(BodyId id, const Vector2D<float>& velocity, float angularVelocity);
+
+        // Applies the impulse at a point in world space and wakes the body.
+        void applyImpulse(BodyId id, const Vector2D<float>& impulse, const Vector2D<float>& point);
+
+
+        // Advances the world by one timestep.
+        void step();
+
+        // Runs as many steps as the time elapsed since the last call, plus what was left
+        // over then, covers, up to maxStepsPerAdvance. Returns how many ran. Throws
+        // std::invalid_argument if the time is negative or not finite.
+        std::size_t advance(float elapsed);
+
+        // The fraction of a step left over by the last advance, from 0 up to 1.
+        inline float getInterpolation() const;
+
+
+        // Statistics of the last step.
+
+        // Pairs of bodies touching or about to.
+        inline std::size_t getContactCount() const;
+
+        // Groups of moving bodies touching each other, awake or asleep.
+        inline std::size_t getIslandCount() const;
+
+        // Colors the awake contacts were split into.
+        inline std::size_t getColorCount() const;
+
+    private:
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Physics>>;
+
+        static constexpr std::uint32_t noIndex = 0xFFFF'FFFF;
+
+        struct ContactPoint
+        {
+            Vector2D<float> position;       // World space, midway between the surfaces
+            float           separation;     // Negative while overlapping
+            std::uint32_t   feature;        // Which features of the shapes touch, to match points between steps
+            float           normalImpulse;
+            float           tangentImpulse;
+        };
+
+        struct Manifold
+        {
+            std::uint64_t   key;            // Lower body id in the high half
+            std::uint32_t   bodyA;          // Indices as of the step that found it
+            std::uint32_t   bodyB;
+            Vector2D<float> normal;         // From A to B
+            std::uint32_t   pointCount;
+            ContactPoint    points[2];
+        };
+
+        struct ConstraintPoint
+        {
+            Vector2D<float> anchorA;        // From the bodies' centers
+            Vector2D<float> anchorB;
+            float           normalMass;
+            float           tangentMass;
+            float           targetVelocity; // Normal velocity the point is pushed towards
+            float           normalImpulse;
+            float           tangentImpulse;
+        };
+
+        struct Constraint
+        {
+            std::uint32_t   bodyA;
+            std::uint32_t   bodyB;
+            std::uint32_t   manifold;
+            std::uint32_t   pointCount;
+            Vector2D<float> normal;
+            float           friction;
+            ConstraintPoint points[2];
+            float           matrix[3];      // Normal effective mass of two points solved together, xx, xy and yy
+            float           inverseMatrix[3];
+        };
+
+
+        float           m_timestep;
+        Vector2D<float> m_gravity     = { 0.0f, -10.0f };
+        std::size_t     m_iterations  = defaultIterations;
+        float           m_accumulator = 0.0f;
+
+        SpatialHashGrid2D m_grid;
+        Vector<BodyId>    m_proxyBodies;        // Indexed by proxy id
+
+        Vector<std::uint32_t> m_indices;        // Indexed by body id, noIndex while the id is free
+        Vector<BodyId>        m_freeIds;
+
+        // Indexed by body, [0, body count)
+        Vector<BodyId>          m_ids;
+        Vector<ShapeType>       m_shapes;
+        Vector<Vector2D<float>> m_extents;      // Half extents, or the radius in x
+        Vector<Vector2D<float>> m_positions;
+        Vector<float>           m_angles;
+        Vector<Vector2D<float>> m_rotations;    // Cosine and sine of the angle
+        Vector<Vector2D<float>> m_velocities;
+        Vector<float>           m_angularVelocities;
+        Vector<float>           m_inverseMasses;   // 0 for static bodies
+        Vector<float>           m_inverseInertias;
+        Vector<float>           m_frictions;
+        Vector<float>           m_restitutions;
+        Vector<ProxyId>         m_proxies;
+        Vector<AABB2D<float>>   m_bounds;       // As last given to the grid
+        Vector<float>           m_sleepTimes;   // How long the body has been still
+        Vector<std::uint8_t>    m_asleep;
+
+        // Kept between steps to reuse their memory
+        std::vector<ProxyPair>  m_pairs;
+        Vector<std::uint64_t>   m_pairKeys;
+        Vector<Manifold>        m_manifolds;    // Sorted by key, the previous step's while finding contacts
+        Vector<Manifold>        m_newManifolds;
+        Vector<std::uint32_t>   m_islandParents;
+        Vector<std::uint8_t>    m_islandAwake;
+        Vector<std::uint32_t>   m_colorMasks;
+        Vector<std::uint32_t>   m_colors;       // Indexed by manifold
+        Vector<std::uint32_t>   m_colorStarts;
+        Vector<Constraint>      m_constraints;  // Grouped by color
+
+        std::size_t m_islandCount = 0;
+        std::size_t m_colorCount  = 0;
+
+
+        // Throws std::invalid_argument if the body isn't alive.
+        std::uint32_t getIndex(BodyId id) const;
+
+        void wake(std::uint32_t index);
+
+        AABB2D<float> computeBounds(std::uint32_t index) const;
+
+        // Replaces the manifolds with the current contacts, carrying impulses over from the
+        // matching old ones.
+        void findContacts();
+
+        void collide(Manifold& manifold) const;
+
+        // Groups bodies into islands, putting to sleep those that have been still long
+        // enough and waking those touching awake bodies.
+        void buildIslands();
+
+        std::uint32_t findIsland(std::uint32_t index);
+
+        void integrateVelocities();
+
+        // Colors the awake contacts and turns them into constraints.
+        void prepareConstraints();
+
+        void solveConstraints();
+
+        void integratePositions();
+
+        void synchronizeProxies();
+    };
+
+
+
+    // vvv PhysicsWorld2D function definitions vvv
+
+    inline float PhysicsWorld2D::getTimestep() const
+    {
+        return m_timestep;
+    }
+
+
+
+    inline const Vector2D<float>& PhysicsWorld2D::getGravity() const
+    {
+        return m_gravity;
+    }
+
+
+
+    inline void PhysicsWorld2D::setGravity(const Vector2D<float>& gravity)
+    {
+        m_gravity = gravity;
+    }
+
+
+
+    inline std::size_t PhysicsWorld2D::getIterations() const
+    {
+        return m_iterations;
+    }
+
+
+
+    inline std::size_t PhysicsWorld2D::getBodyCount() const
+    {
+        return m_ids.size();
+    }
+
+
+
+    inline float PhysicsWorld2D::getInterpolation() const
+    {
+        return m_accumulator / m_timestep;
+    }
+
+
+
+    inline std::size_t PhysicsWorld2D::getContactCount() const
+    {
+        return m_manifolds.size();
+    }
+
+
+
+    inline std::size_t PhysicsWorld2D::getIslandCount() const
+    {
+        return m_islandCount;
+    }
+
+
+
+    inline std::size_t PhysicsWorld2D::getColorCount() const
+    {
+        return m_colorCount;
+    }
+
+    // ^^^ PhysicsWorld2D function definitions ^^^
+}
+
+#endif // CEDAR_PHYSICS_PHYSICS_WORLD_2D_H
\ No newline at end of file
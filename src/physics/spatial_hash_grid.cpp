@@ -0,0 +1,541 @@
+#include "spatial_hash_grid.h"
+
+#include "../debug/profiler.h"
+#include "../math/aabb.h"
+#include "../math/point.h"
+#include "../math/vector.h"
+#include "spatial_query.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+
+
+namespace Cedar::Physics
+{
+    namespace
+    {
+        // Keeps cell coordinates far enough from the integer limits that loops over a
+        // range of cells can't overflow
+        constexpr float maxCellCoord = 1 << 30;
+
+        // Queries per parallelFor chunk
+        constexpr std::size_t queryGrainSize = 64;
+
+
+        std::size_t hashCell(const Point3D<std::int32_t>& coord);
+
+        bool isValid(const AABB3D<float>& bounds);
+
+        bool isInRange(const Point3D<std::int32_t>& coord, const Point3D<std::int32_t>& min, const Point3D<std::int32_t>& max);
+
+        template <typename TFunction>
+        void forEachCell(const Point3D<std::int32_t>& min, const Point3D<std::int32_t>& max, TFunction&& function);
+
+
+
+        std::size_t hashCell(const Point3D<std::int32_t>& coord)
+        {
+            std::uint64_t hash = static_cast<std::uint32_t>(coord.x) * 0x9E37'79B9'7F4A'7C15ull ^
+                                 static_cast<std::uint32_t>(coord.y) * 0xC2B2'AE3D'27D4'EB4Full ^
+                                 static_cast<std::uint32_t>(coord.z) * 0x1656'67B1'9E37'79F9ull;
+
+            return static_cast<std::size_t>(hash ^ (hash >> 32));
+        }
+
+
+
+        bool isValid(const AABB3D<float>& bounds)
+        {
+            return std::isfinite(bounds.min.x) && std::isfinite(bounds.min.y) && std::isfinite(bounds.min.z) &&
+                   std::isfinite(bounds.max.x) && std::isfinite(bounds.max.y) && std::isfinite(bounds.max.z) &&
+                   bounds.min.x <= bounds.max.x && bounds.min.y <= bounds.max.y && bounds.min.z <= bounds.max.z;
+        }
+
+
+
+        bool isInRange(const Point3D<std::int32_t>& coord, const Point3D<std::int32_t>& min, const Point3D<std::int32_t>& max)
+        {
+            return coord.x >= min.x && coord.x <= max.x &&
+                   coord.y >= min.y && coord.y <= max.y &&
+                   coord.z >= min.z && coord.z <= max.z;
+        }
+
+
+
+        template <typename TFunction>
+        void forEachCell(const Point3D<std::int32_t>& min, const Point3D<std::int32_t>& max, TFunction&& function)
+        {
+            for (std::int32_t z = min.z; z <= max.z; z++)
+            {
+                for (std::int32_t y = min.y; y <= max.y; y++)
+                {
+                    for (std::int32_t x = min.x; x <= max.x; x++)
+                        function(Point3D<std::int32_t>{ x, y, z });
+                }
+            }
+        }
+    }
+
+
+
+    SpatialHashGrid3D::SpatialHashGrid3D(float cellSize)
+    {
+        if (!(cellSize > 0.0f) || !std::isfinite(cellSize))
+            throw std::invalid_argument("Cell size must be positive and finite");
+
+        m_cellSize        = cellSize;
+        m_inverseCellSize = 1.0f / cellSize;
+    }
+
+
+
+    ProxyId SpatialHashGrid3D::create(const AABB3D<float>& bounds)
+    {
+        if (!isValid(bounds))
+            throw std::invalid_argument("Proxy bounds must be finite with min at most max");
+
+        ProxyId id;
+
+        if (!m_freeProxies.empty())
+        {
+            id = m_freeProxies.back();
+            m_freeProxies.pop_back();
+        }
+        else
+        {
+            if (m_proxies.size() >= noProxy)
+                throw std::length_error("Too many proxies");
+
+            id = static_cast<ProxyId>(m_proxies.size());
+            m_proxies.push_back(Proxy());
+        }
+
+        Proxy& proxy = m_proxies[id];
+
+        proxy.bounds  = bounds;
+        proxy.minCell = toCell(bounds.min);
+        proxy.maxCell = toCell(bounds.max);
+        proxy.alive   = true;
+
+        forEachCell(proxy.minCell, proxy.maxCell, [&](const CellCoord& coord) { insert(id, coord); });
+
+        m_proxyCount++;
+
+        return id;
+    }
+
+
+
+    void SpatialHashGrid3D::destroy(ProxyId id)
+    {
+        const Proxy& proxy = getProxy(id);
+
+        forEachCell(proxy.minCell, proxy.maxCell, [&](const CellCoord& coord) { erase(id, coord); });
+
+        m_proxies[id].alive = false;
+        m_freeProxies.push_back(id);
+        m_proxyCount--;
+    }
+
+
+
+    void SpatialHashGrid3D::move(ProxyId id, const AABB3D<float>& bounds)
+    {
+        (void)getProxy(id);
+
+        if (!isValid(bounds))
+            throw std::invalid_argument("Proxy bounds must be finite with min at most max");
+
+        Proxy&    proxy   = m_proxies[id];
+        CellCoord minCell = toCell(bounds.min);
+        CellCoord maxCell = toCell(bounds.max);
+
+        proxy.bounds = bounds;
+
+        // Most moves stay within the same cells
+        if (minCell == proxy.minCell && maxCell == proxy.maxCell)
+            return;
+
+        forEachCell(proxy.minCell, proxy.maxCell, [&](const CellCoord& coord) {
+            if (!isInRange(coord, minCell, maxCell))
+                erase(id, coord);
+        });
+
+        forEachCell(minCell, maxCell, [&](const CellCoord& coord) {
+            if (!isInRange(coord, proxy.minCell, proxy.maxCell))
+                insert(id, coord);
+        });
+
+        proxy.minCell = minCell;
+        proxy.maxCell = maxCell;
+    }
+
+
+
+    bool SpatialHashGrid3D::isAlive(ProxyId id) const
+    {
+        return id < m_proxies.size() && m_proxies[id].alive;
+    }
+
+
+
+    const AABB3D<float>& SpatialHashGrid3D::getBounds(ProxyId id) const
+    {
+        return getProxy(id).bounds;
+    }
+
+
+
+    void SpatialHashGrid3D::clear()
+    {
+        m_proxies.clear();
+        m_freeProxies.clear();
+        m_freeCells.clear();
+
+        for (std::size_t i = 0; i < m_cells.size(); i++)
+        {
+            m_cells[i].proxies.clear();
+            m_freeCells.push_back(static_cast<std::uint32_t>(i));
+        }
+
+        for (Slot& slot : m_slots)
+            slot.cell = noCell;
+
+        m_proxyCount = 0;
+        m_cellCount  = 0;
+    }
+
+
+
+    void SpatialHashGrid3D::query(const AABB3D<float>& box, ProxyFunc function, void* data) const
+    {
+        queryCells(box, Vector3D<float>{ 0.0f, 0.0f, 0.0f }, -1.0f, function, data);
+    }
+
+
+
+    void SpatialHashGrid3D::queryRadius(const Vector3D<float>& center, float radius, ProxyFunc function, void* data) const
+    {
+        if (!(radius >= 0.0f))
+            throw std::invalid_argument("Query radius must not be negative");
+
+        AABB3D<float> box = {
+            { center.x - radius, center.y - radius, center.z - radius },
+            { center.x + radius, center.y + radius, center.z + radius }
+        };
+
+        queryCells(box, center, radius, function, data);
+    }
+
+
+
+    void SpatialHashGrid3D::queryBatch(std::span<const AABB3D<float>> boxes, SpatialQueryResults& results) const
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        results.run(boxes.size(), queryGrainSize, [&](std::size_t index, ProxyVector& found) {
+            query(boxes[index], [&](ProxyId id) { found.push_back(id); });
+        });
+    }
+
+
+
+    void SpatialHashGrid3D::queryRadiusBatch(std::span<const Vector3D<float>> centers, std::span<const float> radii, SpatialQueryResults& results) const
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        if (centers.size() != radii.size())
+            throw std::invalid_argument("Radius queries need as many radii as centers");
+
+        for (float radius : radii)
+        {
+            if (!(radius >= 0.0f))
+                throw std::invalid_argument("Query radius must not be negative");
+        }
+
+        results.run(centers.size(), queryGrainSize, [&](std::size_t index, ProxyVector& found) {
+            queryRadius(centers[index], radii[index], [&](ProxyId id) { found.push_back(id); });
+        });
+    }
+
+
+
+    void SpatialHashGrid3D::findPairs(std::vector<ProxyPair>& pairs) const
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        pairs.clear();
+
+        for (const Cell& cell : m_cells)
+        {
+            const ProxyId* proxies = cell.proxies.data();
+            std::size_t    count   = cell.proxies.size();
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                const Proxy& a = m_proxies[proxies[i]];
+
+                for (std::size_t j = i + 1; j < count; j++)
+                {
+                    const Proxy& b = m_proxies[proxies[j]];
+
+                    if (!overlaps(a.bounds, b.bounds))
+                        continue;
+
+                    // Both are listed in every cell of the overlap of their cell ranges,
+                    // only its lowest corner reports them
+                    if (cell.coord.x != std::max(a.minCell.x, b.minCell.x) ||
+                        cell.coord.y != std::max(a.minCell.y, b.minCell.y) ||
+                        cell.coord.z != std::max(a.minCell.z, b.minCell.z))
+                    {
+                        continue;
+                    }
+
+                    pairs.push_back({ std::min(proxies[i], proxies[j]), std::max(proxies[i], proxies[j]) });
+                }
+            }
+        }
+    }
+
+
+
+    const SpatialHashGrid3D::Proxy& SpatialHashGrid3D::getProxy(ProxyId id) const
+    {
+        if (!isAlive(id))
+            throw std::invalid_argument("Proxy isn't alive");
+
+        return m_proxies[id];
+    }
+
+
+
+    SpatialHashGrid3D::CellCoord SpatialHashGrid3D::toCell(const Vector3D<float>& position) const
+    {
+        return {
+            static_cast<std::int32_t>(std::clamp(std::floor(position.x * m_inverseCellSize), -maxCellCoord, maxCellCoord)),
+            static_cast<std::int32_t>(std::clamp(std::floor(position.y * m_inverseCellSize), -maxCellCoord, maxCellCoord)),
+            static_cast<std::int32_t>(std::clamp(std::floor(position.z * m_inverseCellSize), -maxCellCoord, maxCellCoord))
+        };
+    }
+
+
+
+    std::uint32_t SpatialHashGrid3D::findCell(const CellCoord& coord) const
+    {
+        if (m_slots.empty())
+            return noCell;
+
+        std::size_t mask = m_slots.size() - 1;
+
+        for (std::size_t i = hashCell(coord) & mask;; i = (i + 1) & mask)
+        {
+            const Slot& slot = m_slots[i];
+
+            if (slot.cell == noCell || slot.coord == coord)
+                return slot.cell;
+        }
+    }
+
+
+
+    void SpatialHashGrid3D::insert(ProxyId id, const CellCoord& coord)
+    {
+        std::uint32_t cell = findCell(coord);
+
+        if (cell == noCell)
+            cell = createCell(coord);
+
+        m_cells[cell].proxies.push_back(id);
+    }
+
+
+
+    void SpatialHashGrid3D::erase(ProxyId id, const CellCoord& coord)
+    {
+        std::uint32_t    cell    = findCell(coord);
+        Vector<ProxyId>& proxies = m_cells[cell].proxies;
+
+        *std::find(proxies.begin(), proxies.end(), id) = proxies.back();
+        proxies.pop_back();
+
+        if (proxies.empty())
+            destroyCell(cell);
+    }
+
+
+
+    std::uint32_t SpatialHashGrid3D::createCell(const CellCoord& coord)
+    {
+        if ((m_cellCount + 1) * 2 > m_slots.size())
+            growSlots();
+
+        std::uint32_t cell;
+
+        // Free cells still have the memory of the proxy list they had
+        if (!m_freeCells.empty())
+        {
+            cell = m_freeCells.back();
+            m_freeCells.pop_back();
+        }
+        else
+        {
+            cell = static_cast<std::uint32_t>(m_cells.size());
+            m_cells.push_back(Cell());
+        }
+
+        m_cells[cell].coord = coord;
+
+        std::size_t mask = m_slots.size() - 1;
+        std::size_t i    = hashCell(coord) & mask;
+
+        while (m_slots[i].cell != noCell)
+            i = (i + 1) & mask;
+
+        m_slots[i] = { coord, cell };
+        m_cellCount++;
+
+        return cell;
+    }
+
+
+
+    void SpatialHashGrid3D::destroyCell(std::uint32_t cell)
+    {
+        std::size_t mask = m_slots.size() - 1;
+        std::size_t hole = hashCell(m_cells[cell].coord) & mask;
+
+        while (m_slots[hole].cell != cell)
+            hole = (hole + 1) & mask;
+
+        // Shifts the following slots back into the hole where their probe allows it, so
+        // lookups never need tombstones
+        for (std::size_t i = (hole + 1) & mask; m_slots[i].cell != noCell; i = (i + 1) & mask)
+        {
+            std::size_t home = hashCell(m_slots[i].coord) & mask;
+
+            // The slot can move back if its home isn't cyclically in (hole, i]
+            bool between = (hole <= i) ? (home > hole && home <= i) : (home > hole || home <= i);
+
+            if (!between)
+            {
+                m_slots[hole] = m_slots[i];
+                hole          = i;
+            }
+        }
+
+        m_slots[hole].cell = noCell;
+
+        m_freeCells.push_back(cell);
+        m_cellCount--;
+    }
+
+
+
+    void SpatialHashGrid3D::growSlots()
+    {
+        Vector<Slot> slots(std::max<std::size_t>(m_slots.size() * 2, 64), Slot{ {}, noCell });
+        std::size_t  mask = slots.size() - 1;
+
+        for (const Slot& slot : m_slots)
+        {
+            if (slot.cell == noCell)
+                continue;
+
+            std::size_t i = hashCell(slot.coord) & mask;
+
+            while (slots[i].cell != noCell)
+                i = (i + 1) & mask;
+
+            slots[i] = slot;
+        }
+
+        m_slots.swap(slots);
+    }
+
+
+
+    void SpatialHashGrid3D::queryCells(const AABB3D<float>& box, const Vector3D<float>& center, float radius, ProxyFunc function, void* data) const
+    {
+        // Also false for NaN, which has no cell
+        if (!(box.min.x <= box.max.x && box.min.y <= box.max.y && box.min.z <= box.max.z))
+            return;
+
+        CellCoord minCell = toCell(box.min);
+        CellCoord maxCell = toCell(box.max);
+
+        auto visit = [&](const Cell& cell) {
+            for (ProxyId id : cell.proxies)
+            {
+                const Proxy& proxy = m_proxies[id];
+
+                // Only the lowest corner of the overlap of the proxy's and the query's cell
+                // ranges reports the proxy
+                if (cell.coord.x != std::max(proxy.minCell.x, minCell.x) ||
+                    cell.coord.y != std::max(proxy.minCell.y, minCell.y) ||
+                    cell.coord.z != std::max(proxy.minCell.z, minCell.z))
+                {
+                    continue;
+                }
+
+                if (!overlaps(proxy.bounds, box))
+                    continue;
+
+                if (radius >= 0.0f && squaredDistance(proxy.bounds, center) > radius * radius)
+                    continue;
+
+                function(data, id);
+            }
+        };
+
+        double rangeCells = (double(maxCell.x) - minCell.x + 1) * (double(maxCell.y) - minCell.y + 1) * (double(maxCell.z) - minCell.z + 1);
+
+        // A query covering more cells than exist is cheaper as a walk over the cells
+        if (rangeCells > double(m_cellCount))
+        {
+            for (const Cell& cell : m_cells)
+            {
+                if (!cell.proxies.empty() && isInRange(cell.coord, minCell, maxCell))
+                    visit(cell);
+            }
+
+            return;
+        }
+
+        forEachCell(minCell, maxCell, [&](const CellCoord& coord) {
+            std::uint32_t cell = findCell(coord);
+
+            if (cell != noCell)
+                visit(m_cells[cell]);
+        });
+    }
+
+
+
+    void SpatialHashGrid2D::queryBatch(std::span<const AABB2D<float>> boxes, SpatialQueryResults& results)
+    {
+        m_boxScratch.resize(boxes.size());
+
+        for (std::size_t i = 0; i < boxes.size(); i++)
+            m_boxScratch[i] = toBox3D(boxes[i]);
+
+        m_grid.queryBatch(m_boxScratch, results);
+    }
+
+
+
+    void SpatialHashGrid2D::queryRadiusBatch(std::span<const Vector2D<float>> centers, std::span<const float> radii, SpatialQueryResults& results)
+    {
+        m_centerScratch.resize(centers.size());
+
+        for (std::size_t i = 0; i < centers.size(); i++)
+            m_centerScratch[i] = { centers[i].x, centers[i].y, 0.0f };
+
+        m_grid.queryRadiusBatch(m_centerScratch, radii, results);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,388 @@
+//
+// Uniform spatial hash grids.
+//
+// Space is cut into cubic cells of a fixed size, and each proxy (an object's bounding
+// box) is listed in every cell its box overlaps. Only the cells that hold proxies exist,
+// found through an open addressing hash table keyed on their integer coordinates, so the
+// grid is unbounded and costs memory in proportion to what's in it. Queries and pair
+// finding only test the proxies that share a cell, which makes them close to linear in
+// the number of proxies as long as the cell size is about the size of a typical proxy;
+// much larger proxies are listed in many cells and much smaller ones crowd few cells.
+//
+// Moving a proxy only touches the cells it enters and leaves, and nothing at all while it
+// stays within the same cells. Cells keep their memory when they empty out and are
+// reused, so a grid whose proxies move around stops allocating once it's warm.
+//
+// A proxy listed in several cells is met once per cell; queries and pair finding report
+// it only from the cell holding the lowest corner of the overlap, so nothing is reported
+// twice and no visited set is needed.
+//
+// SpatialHashGrid2D is the 3D grid with every box flat on z = 0.
+//
+
+#ifndef CEDAR_PHYSICS_SPATIAL_HASH_GRID_H
+#define CEDAR_PHYSICS_SPATIAL_HASH_GRID_H
+
+#include "../math/aabb.h"
+#include "../math/point.h"
+#include "../math/vector.h"
+#include "../memory/memory_tracker.h"
+#include "spatial_query.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+
+namespace Cedar::Physics
+{
+    class SpatialHashGrid3D;
+
+    class SpatialHashGrid2D;
+
+
+
+    class SpatialHashGrid3D
+    {
+    public:
+
+        // Throws std::invalid_argument if the cell size isn't positive and finite.
+        explicit SpatialHashGrid3D(float cellSize);
+
+
+        inline float getCellSize() const;
+
+
+        // Returns the new proxy's id. Ids are reused once the proxy is destroyed. Throws
+        // std::invalid_argument if the bounds aren't finite or min is above max.
+        ProxyId create(const AABB3D<float>& bounds);
+
+        // Throws std::invalid_argument if the proxy isn't alive.
+        void destroy(ProxyId id);
+
+        // Throws std::invalid_argument if the proxy isn't alive, the bounds aren't finite or
+        // min is above max.
+        void move(ProxyId id, const AABB3D<float>& bounds);
+
+        bool isAlive(ProxyId id) const;
+
+        // Throws std::invalid_argument if the proxy isn't alive.
+        const AABB3D<float>& getBounds(ProxyId id) const;
+
+        inline std::size_t getProxyCount() const;
+
+        // Number of cells that hold at least one proxy.
+        inline std::size_t getCellCount() const;
+
+        // Destroys every proxy. Keeps the memory.
+        void clear();
+
+
+        // Calls function(data, id) once for each proxy whose bounds overlap the box.
+        void query(const AABB3D<float>& box, ProxyFunc function, void* data) const;
+
+        // Calls function(id) the same way.
+        template <typename TFunction>
+        void query(const AABB3D<float>& box, TFunction&& function) const;
+
+        // Calls function(data, id) once for each proxy whose bounds are within the radius
+        // of the center. Throws std::invalid_argument if the radius is negative.
+        void queryRadius(const Vector3D<float>& center, float radius, ProxyFunc function, void* data) const;
+
+        // Calls function(id) the same way.
+        template <typename TFunction>
+        void queryRadius(const Vector3D<float>& center, float radius, TFunction&& function) const;
+
+
+        // Runs a box query for each box, spread over the job system for large batches.
+        // Doesn't allocate once the results are large enough.
+        void queryBatch(std::span<const AABB3D<float>> boxes, SpatialQueryResults& results) const;
+
+        // Runs a radius query for each center and radius. Throws std::invalid_argument if
+        // there aren't as many radii as centers or one is negative.
+        void queryRadiusBatch(std::span<const Vector3D<float>> centers, std::span<const float> radii, SpatialQueryResults& results) const;
+
+
+        // Replaces the pairs with every pair of proxies whose bounds overlap, each once and
+        // in no particular order. Doesn't allocate once the vector is large enough.
+        void findPairs(std::vector<ProxyPair>& pairs) const;
+
+    private:
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Physics>>;
+
+        typedef Point3D<std::int32_t> CellCoord;
+
+        static constexpr std::uint32_t noCell = 0xFFFF'FFFF;
+
+        struct Proxy
+        {
+            AABB3D<float> bounds;
+            CellCoord     minCell;
+            CellCoord     maxCell;
+            bool          alive;
+        };
+
+        struct Cell
+        {
+            CellCoord       coord;
+            Vector<ProxyId> proxies; // Empty while the cell is free
+        };
+
+        struct Slot
+        {
+            CellCoord     coord;
+            std::uint32_t cell;   // noCell if the slot is empty
+        };
+
+
+        float m_cellSize;
+        float m_inverseCellSize;
+
+        Vector<Proxy>         m_proxies;
+        Vector<ProxyId>       m_freeProxies;
+        std::size_t           m_proxyCount = 0;
+
+        Vector<Cell>          m_cells;
+        Vector<std::uint32_t> m_freeCells;
+        Vector<Slot>          m_slots;          // Power of two sized, at most half full
+        std::size_t           m_cellCount = 0;
+
+
+        // Throws std::invalid_argument if the proxy isn't alive.
+        const Proxy& getProxy(ProxyId id) const;
+
+        CellCoord toCell(const Vector3D<float>& position) const;
+
+        std::uint32_t findCell(const CellCoord& coord) const;
+
+        void insert(ProxyId id, const CellCoord& coord);
+
+        void erase(ProxyId id, const CellCoord& coord);
+
+        std::uint32_t createCell(const CellCoord& coord);
+
+        void destroyCell(std::uint32_t cell);
+
+        void growSlots();
+
+        // Calls function(data, id) for each proxy overlapping the box and the sphere, or
+        // just the box if the radius is negative.
+        void queryCells(const AABB3D<float>& box, const Vector3D<float>& center, float radius, ProxyFunc function, void* data) const;
+    };
+
+
+
+    // The 3D grid with every box flat on z = 0.
+    class SpatialHashGrid2D
+    {
+    public:
+
+        // Throws std::invalid_argument if the cell size isn't positive and finite.
+        inline explicit SpatialHashGrid2D(float cellSize);
+
+
+        inline float getCellSize() const;
+
+
+        inline ProxyId create(const AABB2D<float>& bounds);
+
+        inline void destroy(ProxyId id);
+
+        inline void move(ProxyId id, const AABB2D<float>& bounds);
+
+        inline bool isAlive(ProxyId id) const;
+
+        inline AABB2D<float> getBounds(ProxyId id) const;
+
+        inline std::size_t getProxyCount() const;
+
+        inline std::size_t getCellCount() const;
+
+        inline void clear();
+
+
+        template <typename TFunction>
+        void query(const AABB2D<float>& box, TFunction&& function) const;
+
+        template <typename TFunction>
+        void queryRadius(const Vector2D<float>& center, float radius, TFunction&& function) const;
+
+
+        // Converts the boxes into a scratch array kept between batches.
+        void queryBatch(std::span<const AABB2D<float>> boxes, SpatialQueryResults& results);
+
+        void queryRadiusBatch(std::span<const Vector2D<float>> centers, std::span<const float> radii, SpatialQueryResults& results);
+
+
+        inline void findPairs(std::vector<ProxyPair>& pairs) const;
+
+    private:
+
+        SpatialHashGrid3D m_grid;
+
+        std::vector<AABB3D<float>, Memory::TrackedAllocator<AABB3D<float>, Memory::Tag::Physics>>     m_boxScratch;
+        std::vector<Vector3D<float>, Memory::TrackedAllocator<Vector3D<float>, Memory::Tag::Physics>> m_centerScratch;
+
+
+        static inline AABB3D<float> toBox3D(const AABB2D<float>& box);
+    };
+
+
+
+    // vvv SpatialHashGrid3D function definitions vvv
+
+    inline float SpatialHashGrid3D::getCellSize() const
+    {
+        return m_cellSize;
+    }
+
+
+
+    inline std::size_t SpatialHashGrid3D::getProxyCount() const
+    {
+        return m_proxyCount;
+    }
+
+
+
+    inline std::size_t SpatialHashGrid3D::getCellCount() const
+    {
+        return m_cellCount;
+    }
+
+
+
+    template <typename TFunction>
+    void SpatialHashGrid3D::query(const AABB3D<float>& box, TFunction&& function) const
+    {
+        typedef std::remove_reference_t<TFunction> Function;
+
+        query(box, [](void* data, ProxyId id) {
+            (*static_cast<Function*>(data))(id);
+        }, const_cast<void*>(static_cast<const void*>(&function)));
+    }
+
+
+
+    template <typename TFunction>
+    void SpatialHashGrid3D::queryRadius(const Vector3D<float>& center, float radius, TFunction&& function) const
+    {
+        typedef std::remove_reference_t<TFunction> Function;
+
+        queryRadius(center, radius, [](void* data, ProxyId id) {
+            (*static_cast<Function*>(data))(id);
+        }, const_cast<void*>(static_cast<const void*>(&function)));
+    }
+
+    // ^^^ SpatialHashGrid3D function definitions ^^^
+
+
+
+    // vvv SpatialHashGrid2D function definitions vvv
+
+    inline SpatialHashGrid2D::SpatialHashGrid2D(float cellSize) : m_grid(cellSize) {}
+
+
+
+    inline float SpatialHashGrid2D::getCellSize() const
+    {
+        return m_grid.getCellSize();
+    }
+
+
+
+    inline ProxyId SpatialHashGrid2D::create(const AABB2D<float>& bounds)
+    {
+        return m_grid.create(toBox3D(bounds));
+    }
+
+
+
+    inline void SpatialHashGrid2D::destroy(ProxyId id)
+    {
+        m_grid.destroy(id);
+    }
+
+
+
+    inline void SpatialHashGrid2D::move(ProxyId id, const AABB2D<float>& bounds)
+    {
+        m_grid.move(id, toBox3D(bounds));
+    }
+
+
+
+    inline bool SpatialHashGrid2D::isAlive(ProxyId id) const
+    {
+        return m_grid.isAlive(id);
+    }
+
+
+
+    inline AABB2D<float> SpatialHashGrid2D::getBounds(ProxyId id) const
+    {
+        const AABB3D<float>& bounds = m_grid.getBounds(id);
+        return { { bounds.min.x, bounds.min.y }, { bounds.max.x, bounds.max.y } };
+    }
+
+
+
+    inline std::size_t SpatialHashGrid2D::getProxyCount() const
+    {
+        return m_grid.getProxyCount();
+    }
+
+
+
+    inline std::size_t SpatialHashGrid2D::getCellCount() const
+    {
+        return m_grid.getCellCount();
+    }
+
+
+
+    inline void SpatialHashGrid2D::clear()
+    {
+        m_grid.clear();
+    }
+
+
+
+    template <typename TFunction>
+    void SpatialHashGrid2D::query(const AABB2D<float>& box, TFunction&& function) const
+    {
+        m_grid.query(toBox3D(box), std::forward<TFunction>(function));
+    }
+
+
+
+    template <typename TFunction>
+    void SpatialHashGrid2D::queryRadius(const Vector2D<float>& center, float radius, TFunction&& function) const
+    {
+        m_grid.queryRadius({ center.x, center.y, 0.0f }, radius, std::forward<TFunction>(function));
+    }
+
+
+
+    inline void SpatialHashGrid2D::findPairs(std::vector<ProxyPair>& pairs) const
+    {
+        m_grid.findPairs(pairs);
+    }
+
+
+
+    inline AABB3D<float> SpatialHashGrid2D::toBox3D(const AABB2D<float>& box)
+    {
+        return { { box.min.x, box.min.y, 0.0f }, { box.max.x, box.max.y, 0.0f } };
+    }
+
+    // ^^^ SpatialHashGrid2D function definitions ^^^
+}
+
+#endif // CEDAR_PHYSICS_SPATIAL_HASH_GRID_H
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "spatial_query.h"
+
+#include "../jobs/job_system.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+
+namespace Cedar::Physics
+{
+    SpatialQueryResults::SpatialQueryResults() {}
+
+
+
+    std::size_t SpatialQueryResults::getProxyCount() const
+    {
+        std::size_t count = 0;
+
+        for (const Range& range : m_ranges)
+            count += range.count;
+
+        return count;
+    }
+
+
+
+    void SpatialQueryResults::run(std::size_t count, std::size_t grainSize, BatchQueryFunc function, void* data)
+    {
+        m_buffers.resize(Jobs::getWorkerCount() + 1);
+        m_ranges.resize(count);
+
+        for (ProxyVector& buffer : m_buffers)
+            buffer.clear();
+
+        auto runRange = [&](std::size_t begin, std::size_t end) {
+            std::uint32_t index  = static_cast<std::uint32_t>(Jobs::getThreadIndex());
+            ProxyVector&  buffer = m_buffers[index];
+
+            for (std::size_t i = begin; i < end; i++)
+            {
+                std::size_t first = buffer.size();
+
+                function(data, i, buffer);
+
+                m_ranges[i] = { index, static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(buffer.size() - first) };
+            }
+        };
+
+        if (count <= grainSize)
+            runRange(0, count);
+        else
+            Jobs::parallelFor(count, grainSize, runRange);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+//
+// Types shared by the spatial query structures.
+//
+// Proxies are the bounding boxes a structure holds, named by ids it hands out. Batched
+// queries collect what each query found in SpatialQueryResults, which the structures
+// fill on several threads at once through run.
+//
+
+#ifndef CEDAR_PHYSICS_SPATIAL_QUERY_H
+#define CEDAR_PHYSICS_SPATIAL_QUERY_H
+
+#include "../memory/memory_tracker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+
+
+namespace Cedar::Physics
+{
+    struct ProxyPair;
+
+    class SpatialQueryResults;
+
+
+
+    typedef std::uint32_t ProxyId;
+
+    constexpr ProxyId noProxy = 0xFFFF'FFFF;
+
+    typedef void (*ProxyFunc)(void* data, ProxyId id);
+
+    typedef std::vector<ProxyId, Memory::TrackedAllocator<ProxyId, Memory::Tag::Physics>> ProxyVector;
+
+    typedef void (*BatchQueryFunc)(void* data, std::size_t query, ProxyVector& found);
+
+
+
+    // first < second.
+    struct ProxyPair
+    {
+        ProxyId first;
+        ProxyId second;
+
+        inline bool operator==(const ProxyPair& other) const = default;
+    };
+
+
+
+    // The results of a batch of queries, the proxies each query found. Reusing the same
+    // results for every batch avoids allocating once they've grown large enough.
+    class SpatialQueryResults
+    {
+    public:
+
+        SpatialQueryResults();
+
+
+        inline std::size_t getQueryCount() const;
+
+        // The proxies the query found, in no particular order. Valid until the results are
+        // used for another batch.
+        inline std::span<const ProxyId> get(std::size_t query) const;
+
+        // Total across every query.
+        std::size_t getProxyCount() const;
+
+
+        // For internal use only. Replaces the results with those of count queries, calling
+        // function(data, query, found) for each to push what it finds. Batches of more than
+        // grainSize queries are spread over the job system, so the function must be safe
+        // to call on several threads at once.
+        void run(std::size_t count, std::size_t grainSize, BatchQueryFunc function, void* data);
+
+        // For internal use only. Calls function(query, found) the same way.
+        template <typename TFunction>
+        void run(std::size_t count, std::size_t grainSize, TFunction&& function);
+
+    private:
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Physics>>;
+
+        struct Range
+        {
+            std::uint32_t buffer;
+            std::uint32_t begin;
+            std::uint32_t count;
+        };
+
+
+        Vector<ProxyVector> m_buffers; // One per thread, so queries can run in parallel
+        Vector<Range>       m_ranges;  // Indexed by query
+    };
+
+
+
+    // vvv SpatialQueryResults function definitions vvv
+
+    inline std::size_t SpatialQueryResults::getQueryCount() const
+    {
+        return m_ranges.size();
+    }
+
+
+
+    inline std::span<const ProxyId> SpatialQueryResults::get(std::size_t query) const
+    {
+        const Range& range = m_ranges[query];
+        return std::span<const ProxyId>(m_buffers[range.buffer].data() + range.begin, range.count);
+    }
+
+
+
+    template <typename TFunction>
+    void SpatialQueryResults::run(std::size_t count, std::size_t grainSize, TFunction&& function)
+    {
+        typedef std::remove_reference_t<TFunction> Function;
+
+        run(count, grainSize, [](void* data, std::size_t query, ProxyVector& found) {
+            (*static_cast<Function*>(data))(query, found);
+        }, const_cast<void*>(static_cast<const void*>(&function)));
+    }
+
+    // ^^^ SpatialQueryResults function definitions ^^^
+}
+
+#endif // CEDAR_PHYSICS_SPATIAL_QUERY_H
\ No newline at end of file
@@ -0,0 +1,14 @@
+//
+// A collection of header files located in the "scene" directory.
+//
+
+#ifndef CEDAR_SCENE_H
+#define CEDAR_SCENE_H
+
+#include "scene/command_buffer.h"
+#include "scene/component.h"
+#include "scene/system_scheduler.h"
+#include "scene/transform_hierarchy.h"
+#include "scene/world.h"
+
+#endif // CEDAR_SCENE_H
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "command_buffer.h"
+
+#include "../debug/profiler.h"
+#include "../memory/memory_tracker.h"
+#include "component.h"
+#include "world.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+
+
+namespace Cedar::Scene
+{
+    CommandBuffer::CommandBuffer() {}
+
+
+
+    CommandBuffer::~CommandBuffer()
+    {
+        clear();
+
+        for (const Block& block : m_blocks)
+            Memory::deallocate(Memory::Tag::Scene, block.memory, block.size, blockAlignment);
+    }
+
+
+
+    Entity CommandBuffer::create()
+    {
+        reserveCommand();
+
+        Entity entity = { m_createdCount++, pendingGeneration };
+        m_commands.push_back({ CommandType::Create, 0, entity, nullptr });
+
+        return entity;
+    }
+
+
+
+    void CommandBuffer::destroy(Entity entity)
+    {
+        reserveCommand();
+        m_commands.push_back({ CommandType::Destroy, 0, entity, nullptr });
+    }
+
+
+
+    void CommandBuffer::playback(World& world)
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        try
+        {
+            m_created.assign(m_createdCount, Entity());
+
+            for (std::size_t i = 0; i < m_commands.size(); i++)
+            {
+                Command& command = m_commands[i];
+
+                switch (command.type)
+                {
+                    case CommandType::Create:
+                    {
+                        // The additions right after go straight into the entity's archetype
+                        // instead of moving it once per component
+                        ComponentMask mask = 0;
+                        std::size_t   end  = i + 1;
+
+                        while (end < m_commands.size() && m_commands[end].type == CommandType::Add &&
+                               m_commands[end].entity == command.entity && (mask & (ComponentMask(1) << m_commands[end].component)) == 0)
+                        {
+                            mask |= ComponentMask(1) << m_commands[end].component;
+                            end++;
+                        }
+
+                        Entity entity = world.createUninitialized(mask);
+                        m_created[command.entity.index] = entity;
+
+                        for (i++; i < end; i++)
+                        {
+                            Command& add = m_commands[i];
+
+                            getComponentInfo(add.component).relocate(world.getComponent(entity, add.component), add.payload);
+                            add.payload = nullptr;
+                        }
+
+                        i--;
+                        break;
+                    }
+
+                    case CommandType::Destroy:
+                    {
+                        Entity entity = resolve(command.entity);
+
+                        if (world.isAlive(entity))
+                            world.destroy(entity);
+
+                        break;
+                    }
+
+                    case CommandType::Add:
+                    {
+                        Entity entity = resolve(command.entity);
+
+                        if (world.isAlive(entity))
+                        {
+                            getComponentInfo(command.component).relocate(world.addUninitialized(entity, command.component), command.payload);
+                            command.payload = nullptr;
+                        }
+
+                        break;
+                    }
+
+                    case CommandType::Remove:
+                    {
+                        Entity entity = resolve(command.entity);
+
+                        if (world.isAlive(entity))
+                            world.removeComponent(entity, command.component);
+
+                        break;
+                    }
+                }
+            }
+        }
+        catch (...) {
+            clear();
+            throw;
+        }
+
+        clear();
+    }
+
+
+
+    void CommandBuffer::clear()
+    {
+        for (const Command& command : m_commands)
+        {
+            if (command.payload == nullptr)
+                continue;
+
+            const ComponentInfo& info = getComponentInfo(command.component);
+
+            if (info.destroy != nullptr)
+                info.destroy(command.payload);
+        }
+
+        m_commands.clear();
+        m_created.clear();
+
+        m_block        = 0;
+        m_blockUsed    = 0;
+        m_createdCount = 0;
+    }
+
+
+
+    void CommandBuffer::reserveCommand()
+    {
+        if (m_commands.size() == m_commands.capacity())
+            m_commands.reserve(std::max<std::size_t>(m_commands.capacity() * 2, 64));
+    }
+
+
+
+    void* CommandBuffer::allocatePayload(std::size_t size, std::size_t alignment)
+    {
+        // The blocks are kept between playbacks, so a buffer that's reused every frame
+        // stops allocating once it has seen its busiest frame
+        while (m_block < m_blocks.size())
+        {
+            const Block& block  = m_blocks[m_block];
+            std::size_t  offset = (m_blockUsed + alignment - 1) / alignment * alignment;
+
+            if (offset + size <= block.size)
+            {
+                m_blockUsed = offset + size;
+                return block.memory + offset;
+            }
+
+            m_block++;
+            m_blockUsed = 0;
+        }
+
+        std::size_t blockBytes = std::max(size, blockSize);
+
+        if (m_blocks.size() == m_blocks.capacity())
+            m_blocks.reserve(std::max<std::size_t>(m_blocks.capacity() * 2, 4));
+
+        m_blocks.push_back({ static_cast<std::byte*>(Memory::allocate(Memory::Tag::Scene, blockBytes, blockAlignment)), blockBytes });
+
+        m_block     = m_blocks.size() - 1;
+        m_blockUsed = size;
+
+        return m_blocks.back().memory;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+//
+// Deferred structural changes.
+//
+// A command buffer records entity creation and destruction and component additions and
+// removals, and applies them to a world later, in the order they were recorded, when no
+// query is running over it. Components are moved into the buffer when they're added and
+// moved into the world on playback.
+//
+// A command buffer isn't thread-safe; code running on several threads at once gives
+// each thread its own.
+//
+
+#ifndef CEDAR_SCENE_COMMAND_BUFFER_H
+#define CEDAR_SCENE_COMMAND_BUFFER_H
+
+#include "../memory/memory_tracker.h"
+#include "component.h"
+#include "world.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+
+namespace Cedar::Scene
+{
+    class CommandBuffer;
+
+
+
+    class CommandBuffer
+    {
+    public:
+
+        static constexpr std::size_t blockSize      = 16 * 1024;
+        static constexpr std::size_t blockAlignment = 64;
+
+
+        CommandBuffer();
+
+        // Destroys the components that were never played back.
+        ~CommandBuffer();
+
+
+        CommandBuffer(const CommandBuffer&) = delete;
+
+        CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+
+        // Returns a placeholder that stands for the new entity in this buffer's later
+        // commands. It isn't alive in the world, and is replaced by the real entity on
+        // playback.
+        Entity create();
+
+        void destroy(Entity entity);
+
+        template <typename T, typename... TArgs>
+        void add(Entity entity, TArgs&&... args);
+
+        template <typename T>
+        void remove(Entity entity);
+
+
+        inline bool isEmpty() const;
+
+        inline std::size_t getCommandCount() const;
+
+
+        // Applies the commands in order and clears the buffer. Commands for entities that
+        // aren't alive by then are skipped.
+        void playback(World& world);
+
+        // Drops the commands without applying them.
+        void clear();
+
+    private:
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Scene>>;
+
+        enum class CommandType {
+            Create,
+            Destroy,
+            Add,
+            Remove
+        };
+
+        struct Command
+        {
+            CommandType type;
+            ComponentId component;
+            Entity      entity;
+            void*       payload;   // The component to add, nullptr once it's moved out
+        };
+
+        struct Block
+        {
+            std::byte*  memory;
+            std::size_t size;
+        };
+
+
+        Vector<Command> m_commands;
+        Vector<Block>   m_blocks;
+        std::size_t     m_block        = 0; // Current block
+        std::size_t     m_blockUsed    = 0;
+        std::uint32_t   m_createdCount = 0;
+        Vector<Entity>  m_created;          // Real entities for the placeholders, during playback
+
+
+        // Makes sure the next command can be pushed without throwing.
+        void reserveCommand();
+
+        void* allocatePayload(std::size_t size, std::size_t alignment);
+
+        inline Entity resolve(Entity entity) const;
+    };
+
+
+
+    // vvv CommandBuffer function definitions vvv
+
+    template <typename T, typename... TArgs>
+    void CommandBuffer::add(Entity entity, TArgs&&... args)
+    {
+        static_assert(alignof(T) <= blockAlignment, "Component alignment is too large for command buffers");
+
+        reserveCommand();
+
+        void* payload = ::new (allocatePayload(sizeof(T), alignof(T))) T(std::forward<TArgs>(args)...);
+
+        m_commands.push_back({ CommandType::Add, getComponentId<T>(), entity, payload });
+    }
+
+
+
+    template <typename T>
+    void CommandBuffer::remove(Entity entity)
+    {
+        reserveCommand();
+        m_commands.push_back({ CommandType::Remove, getComponentId<T>(), entity, nullptr });
+    }
+
+
+
+    inline bool CommandBuffer::isEmpty() const
+    {
+        return m_commands.empty();
+    }
+
+
+
+    inline std::size_t CommandBuffer::getCommandCount() const
+    {
+        return m_commands.size();
+    }
+
+
+
+    inline Entity CommandBuffer::resolve(Entity entity) const
+    {
+        return (entity.generation == pendingGeneration) ? m_created[entity.index] : entity;
+    }
+
+    // ^^^ CommandBuffer function definitions ^^^
+}
+
+#endif // CEDAR_SCENE_COMMAND_BUFFER_H
\ No newline at end of file
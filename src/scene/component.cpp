@@ -0,0 +1,40 @@
+#include "component.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+
+
+
+namespace
+{
+    std::array<Cedar::Scene::ComponentInfo, Cedar::Scene::maxComponentTypes> g_components     = {};
+    std::atomic<std::size_t>                                                  g_componentCount = 0;
+}
+
+
+
+namespace Cedar::Scene
+{
+    ComponentId registerComponent(const ComponentInfo& info)
+    {
+        // Only called from getComponentId's static initializer, which publishes the id
+        // to other threads after the info is written
+        std::size_t id = g_componentCount.fetch_add(1, std::memory_order_relaxed);
+
+        if (id >= maxComponentTypes)
+            throw std::length_error("Too many component types");
+
+        g_components[id] = info;
+
+        return static_cast<ComponentId>(id);
+    }
+
+
+
+    const ComponentInfo& getComponentInfo(ComponentId id)
+    {
+        return g_components[id];
+    }
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+//
+// Component type registry.
+//
+// Components are plain types stored by value in the world's chunks. Each type gets a
+// small id the first time it's used, which indexes the bit masks that describe which
+// components an archetype or a query has, so at most maxComponentTypes types can be
+// used in one program. Components must be nothrow move constructible, as they're
+// relocated between chunks when entities change archetype.
+//
+
+#ifndef CEDAR_SCENE_COMPONENT_H
+#define CEDAR_SCENE_COMPONENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+
+namespace Cedar::Scene
+{
+    struct ComponentInfo;
+
+
+
+    typedef std::uint32_t ComponentId;
+    typedef std::uint64_t ComponentMask; // Bit n set for component id n
+
+    constexpr std::size_t maxComponentTypes = 64;
+
+
+
+    // Move constructs into destination and destroys the source.
+    typedef void (*ComponentRelocateFunc)(void* destination, void* source);
+    typedef void (*ComponentDestroyFunc)(void* component);
+
+
+
+    struct ComponentInfo
+    {
+        std::size_t           size;
+        std::size_t           alignment;
+        ComponentRelocateFunc relocate;
+        ComponentDestroyFunc  destroy;  // nullptr for trivially destructible types
+    };
+
+
+
+    // For internal use only. Throws std::length_error if every id is taken.
+    ComponentId registerComponent(const ComponentInfo& info);
+
+    // The id must have been returned by getComponentId.
+    const ComponentInfo& getComponentInfo(ComponentId id);
+
+
+    // Registers the type on first use. Thread-safe.
+    template <typename T>
+    ComponentId getComponentId();
+
+    template <typename... T>
+    ComponentMask getComponentMask();
+
+
+
+    template <typename T>
+    ComponentId getComponentId()
+    {
+        static_assert(std::is_same_v<T, std::remove_cvref_t<T>>, "Component types can't be references or cv-qualified");
+        static_assert(std::is_nothrow_move_constructible_v<T>, "Components must be nothrow move constructible");
+
+        static const ComponentId id = registerComponent(ComponentInfo{
+            sizeof(T),
+            alignof(T),
+            [](void* destination, void* source) {
+                T* component = static_cast<T*>(source);
+
+                ::new (destination) T(std::move(*component));
+                component->~T();
+            },
+            std::is_trivially_destructible_v<T> ? nullptr : static_cast<ComponentDestroyFunc>([](void* component) {
+                static_cast<T*>(component)->~T();
+            })
+        });
+
+        return id;
+    }
+
+
+
+    template <typename... T>
+    ComponentMask getComponentMask()
+    {
+        return (ComponentMask(0) | ... | (ComponentMask(1) << getComponentId<std::remove_const_t<T>>()));
+    }
+}
+
+#endif // CEDAR_SCENE_COMPONENT_H
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "system_scheduler.h"
+
+#include "../debug/profiler.h"
+#include "../io/log.h"
+#include "../jobs/job_system.h"
+#include "command_buffer.h"
+#include "world.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+
+
+
+namespace Cedar::Scene
+{
+    SystemScheduler::SystemScheduler() {}
+
+
+
+    SystemScheduler::~SystemScheduler()
+    {
+        for (const std::unique_ptr<System>& system : m_systems)
+        {
+            if (system->deleter != nullptr)
+                system->deleter(system->data);
+        }
+    }
+
+
+
+    void SystemScheduler::add(std::string_view name, ComponentMask reads, ComponentMask writes, SystemFunc function, void* data)
+    {
+        addSystem(name, reads, writes, function, data, nullptr);
+    }
+
+
+
+    void SystemScheduler::run(World& world)
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        for (std::size_t stage = 0; stage < m_stageCount; stage++)
+        {
+            Jobs::Counter counter;
+            System*       local = nullptr;
+
+            // The calling thread runs one of the stage's systems itself
+            for (const std::unique_ptr<System>& system : m_systems)
+            {
+                if (system->stage != stage)
+                    continue;
+
+                system->world = &world;
+
+                if (local == nullptr)
+                {
+                    local = system.get();
+                    continue;
+                }
+
+                Jobs::run([](void* data) {
+                    System& system = *static_cast<System*>(data);
+
+                    CEDAR_PROFILE_SCOPE(system.name.c_str());
+                    system.function(system.data, *system.world, system.commands);
+                }, system.get(), &counter);
+            }
+
+            if (local != nullptr)
+            {
+                CEDAR_PROFILE_SCOPE(local->name.c_str());
+                local->function(local->data, world, local->commands);
+            }
+
+            Jobs::wait(counter);
+        }
+
+        for (const std::unique_ptr<System>& system : m_systems)
+            system->commands.playback(world);
+    }
+
+
+
+    void SystemScheduler::logSchedule() const
+    {
+        for (std::size_t stage = 0; stage < m_stageCount; stage++)
+        {
+            std::string names;
+
+            for (const std::unique_ptr<System>& system : m_systems)
+            {
+                if (system->stage != stage)
+                    continue;
+
+                if (!names.empty())
+                    names += ", ";
+
+                names += system->name;
+            }
+
+            Cedar::Log::info(std::format("Stage {}: {}", stage, names));
+        }
+    }
+
+
+
+    void SystemScheduler::addSystem(std::string_view name, ComponentMask reads, ComponentMask writes, SystemFunc function, void* data,
+                                    DeleteFunc deleter)
+    {
+        // Writes imply reads
+        reads |= writes;
+
+        std::size_t stage = 0;
+
+        for (const std::unique_ptr<System>& other : m_systems)
+        {
+            bool conflicts = (writes & other->reads) != 0 || (other->writes & reads) != 0;
+
+            if (conflicts)
+                stage = std::max(stage, other->stage + 1);
+        }
+
+        m_systems.push_back(std::make_unique<System>(std::string(name), reads, writes, function, data, deleter, stage, nullptr));
+        m_stageCount = std::max(m_stageCount, stage + 1);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+//
+// System scheduling.
+//
+// Systems are functions over a world that declare which components they read and write.
+// The scheduler keeps the order systems were added in, but groups them into stages: a
+// system goes in the stage after the last one holding a system it conflicts with (one
+// writes what the other reads or writes), so systems that don't conflict run at the same
+// time on the job system while the ones that do still see each other's results in order.
+//
+// Systems must not make structural changes to the world directly. Each one gets its own
+// command buffer, and the buffers are played back in the order the systems were added
+// once every stage has run.
+//
+// The declared access isn't checked against what a system actually touches. Systems
+// must not throw, they run as jobs.
+//
+
+#ifndef CEDAR_SCENE_SYSTEM_SCHEDULER_H
+#define CEDAR_SCENE_SYSTEM_SCHEDULER_H
+
+#include "../memory/memory_tracker.h"
+#include "command_buffer.h"
+#include "component.h"
+#include "world.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+
+namespace Cedar::Scene
+{
+    template <typename T>
+    struct Read;
+
+    template <typename T>
+    struct Write;
+
+    class SystemScheduler;
+
+
+
+    typedef void (*SystemFunc)(void* data, World& world, CommandBuffer& commands);
+
+
+
+    // Declares that a system reads the component.
+    template <typename T>
+    struct Read
+    {
+        static inline ComponentMask getReads() { return getComponentMask<T>(); }
+
+        static inline ComponentMask getWrites() { return 0; }
+    };
+
+
+
+    // Declares that a system reads and writes the component.
+    template <typename T>
+    struct Write
+    {
+        static inline ComponentMask getReads() { return getComponentMask<T>(); }
+
+        static inline ComponentMask getWrites() { return getComponentMask<T>(); }
+    };
+
+
+
+    class SystemScheduler
+    {
+    public:
+
+        SystemScheduler();
+
+        ~SystemScheduler();
+
+
+        SystemScheduler(const SystemScheduler&) = delete;
+
+        SystemScheduler& operator=(const SystemScheduler&) = delete;
+
+
+        // Adds a system accessing the components in the masks. The data must stay valid
+        // for as long as the scheduler.
+        void add(std::string_view name, ComponentMask reads, ComponentMask writes, SystemFunc function, void* data);
+
+        // Adds a copy of any callable taking (World&, CommandBuffer&) that accesses the
+        // components named by TAccess, which are Read and Write.
+        template <typename... TAccess, typename TFunction>
+        void add(std::string_view name, TFunction&& function);
+
+
+        // Runs every system, then plays back their command buffers.
+        void run(World& world);
+
+
+        inline std::size_t getSystemCount() const;
+
+        inline std::size_t getStageCount() const;
+
+        // Logs the systems of each stage.
+        void logSchedule() const;
+
+    private:
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Scene>>;
+
+        typedef void (*DeleteFunc)(void* data);
+
+        struct System
+        {
+            std::string   name;
+            ComponentMask reads;
+            ComponentMask writes;
+            SystemFunc    function;
+            void*         data;
+            DeleteFunc    deleter;  // Destroys data, nullptr if the scheduler doesn't own it
+            std::size_t   stage;
+            World*        world;    // Set while running
+            CommandBuffer commands;
+        };
+
+
+        Vector<std::unique_ptr<System>> m_systems;
+        std::size_t                     m_stageCount = 0;
+
+
+        void addSystem(std::string_view name, ComponentMask reads, ComponentMask writes, SystemFunc function, void* data, DeleteFunc deleter);
+    };
+
+
+
+    // vvv SystemScheduler function definitions vvv
+
+    template <typename... TAccess, typename TFunction>
+    void SystemScheduler::add(std::string_view name, TFunction&& function)
+    {
+        typedef std::decay_t<TFunction> Function;
+
+        ComponentMask reads  = (ComponentMask(0) | ... | TAccess::getReads());
+        ComponentMask writes = (ComponentMask(0) | ... | TAccess::getWrites());
+
+        std::unique_ptr<Function> copy = std::make_unique<Function>(std::forward<TFunction>(function));
+
+        addSystem(name, reads, writes, [](void* data, World& world, CommandBuffer& commands) {
+            (*static_cast<Function*>(data))(world, commands);
+        }, copy.get(), [](void* data) {
+            delete static_cast<Function*>(data);
+        });
+
+        (void)copy.release();
+    }
+
+
+
+    inline std::size_t SystemScheduler::getSystemCount() const
+    {
+        return m_systems.size();
+    }
+
+
+
+    inline std::size_t SystemScheduler::getStageCount() const
+    {
+        return m_stageCount;
+    }
+
+    // ^^^ SystemScheduler function definitions ^^^
+}
+
+#endif // CEDAR_SCENE_SYSTEM_SCHEDULER_H
\ No newline at end of file
@@ -0,0 +1,385 @@
+#include "transform_hierarchy.h"
+
+#include "../debug/profiler.h"
+#include "../jobs/job_system.h"
+#include "../math/matrix.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+
+
+namespace Cedar::Scene
+{
+    TransformHierarchy::TransformHierarchy() {}
+
+
+
+    TransformId TransformHierarchy::create(TransformId parent, const Transform& local)
+    {
+        if (parent != noTransform)
+            (void)getNode(parent);
+
+        if (m_locals.size() >= std::numeric_limits<std::uint32_t>::max() - 1)
+            throw std::length_error("Too many transforms");
+
+        TransformId id;
+
+        if (!m_freeIds.empty())
+        {
+            id = m_freeIds.back();
+            m_freeIds.pop_back();
+        }
+        else
+        {
+            id = static_cast<TransformId>(m_nodes.size());
+            m_nodes.push_back(Node());
+        }
+
+        std::uint32_t slot = static_cast<std::uint32_t>(m_locals.size());
+
+        m_nodes[id] = { noTransform, noTransform, noTransform, noTransform, slot };
+        link(id, parent);
+
+        // Appended out of depth order, sort puts it in its place
+        m_locals.push_back(local);
+        m_worlds.push_back(identityMatrix<float>());
+        m_parentSlots.push_back((parent != noTransform) ? m_nodes[parent].slot : noSlot);
+        m_dirty.push_back(0);
+
+        markDirty(slot);
+
+        m_sorted = false;
+        m_count++;
+
+        return id;
+    }
+
+
+
+    void TransformHierarchy::destroy(TransformId id)
+    {
+        (void)getNode(id);
+
+        unlink(id);
+
+        // Walks the subtree through the links, the slot arrays may be out of order
+        TransformId current = id;
+
+        while (current != noTransform)
+        {
+            Node& node = m_nodes[current];
+
+            if (node.firstChild != noTransform)
+            {
+                TransformId child = node.firstChild;
+                node.firstChild = m_nodes[child].nextSibling;
+
+                m_nodes[child].nextSibling = noTransform;
+                current = child;
+
+                continue;
+            }
+
+            TransformId parent = (current != id) ? node.parent : noTransform;
+
+            node.slot = noSlot;
+            m_freeIds.push_back(current);
+            m_count--;
+
+            current = parent;
+        }
+
+        m_sorted = false;
+    }
+
+
+
+    bool TransformHierarchy::isAlive(TransformId id) const
+    {
+        return id < m_nodes.size() && m_nodes[id].slot != noSlot;
+    }
+
+
+
+    void TransformHierarchy::setParent(TransformId id, TransformId parent)
+    {
+        (void)getNode(id);
+
+        if (parent != noTransform)
+        {
+            (void)getNode(parent);
+
+            for (TransformId ancestor = parent; ancestor != noTransform; ancestor = m_nodes[ancestor].parent)
+            {
+                if (ancestor == id)
+                    throw std::invalid_argument("Transform can't be parented to itself or its descendant");
+            }
+        }
+
+        if (m_nodes[id].parent == parent)
+            return;
+
+        unlink(id);
+        link(id, parent);
+
+        markDirty(m_nodes[id].slot);
+        m_sorted = false;
+    }
+
+
+
+    TransformId TransformHierarchy::getParent(TransformId id) const
+    {
+        return getNode(id).parent;
+    }
+
+
+
+    const Transform& TransformHierarchy::getLocal(TransformId id) const
+    {
+        return m_locals[getNode(id).slot];
+    }
+
+
+
+    void TransformHierarchy::setLocal(TransformId id, const Transform& local)
+    {
+        std::uint32_t slot = getNode(id).slot;
+
+        m_locals[slot] = local;
+        markDirty(slot);
+    }
+
+
+
+    void TransformHierarchy::setPosition(TransformId id, const Vector3D<float>& position)
+    {
+        std::uint32_t slot = getNode(id).slot;
+
+        m_locals[slot].position = position;
+        markDirty(slot);
+    }
+
+
+
+    void TransformHierarchy::setRotation(TransformId id, const Vector4D<float>& rotation)
+    {
+        std::uint32_t slot = getNode(id).slot;
+
+        m_locals[slot].rotation = rotation;
+        markDirty(slot);
+    }
+
+
+
+    void TransformHierarchy::setScale(TransformId id, const Vector3D<float>& scale)
+    {
+        std::uint32_t slot = getNode(id).slot;
+
+        m_locals[slot].scale = scale;
+        markDirty(slot);
+    }
+
+
+
+    const Matrix4x4<float>& TransformHierarchy::getWorldMatrix(TransformId id) const
+    {
+        return m_worlds[getNode(id).slot];
+    }
+
+
+
+    std::size_t TransformHierarchy::update()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        if (!m_sorted)
+            sort();
+
+        if (m_firstDirtySlot == noSlot)
+            return 0;
+
+        // Depths above the first dirty node have nothing to do
+        std::size_t depth = std::upper_bound(m_depthStarts.begin(), m_depthStarts.end(), m_firstDirtySlot) - m_depthStarts.begin() - 1;
+        std::size_t count = 0;
+
+        for (; depth + 1 < m_depthStarts.size(); depth++)
+        {
+            std::size_t begin = std::max<std::size_t>(m_depthStarts[depth], m_firstDirtySlot);
+            std::size_t end   = m_depthStarts[depth + 1];
+
+            if (end - begin < parallelThreshold)
+            {
+                count += updateRange(begin, end);
+                continue;
+            }
+
+            std::atomic<std::size_t> updated = 0;
+
+            Jobs::parallelFor(end - begin, parallelThreshold / 4, [&](std::size_t rangeBegin, std::size_t rangeEnd) {
+                updated.fetch_add(updateRange(begin + rangeBegin, begin + rangeEnd), std::memory_order_relaxed);
+            });
+
+            count += updated.load(std::memory_order_relaxed);
+        }
+
+        std::fill(m_dirty.begin() + m_firstDirtySlot, m_dirty.end(), std::uint8_t(0));
+        m_firstDirtySlot = noSlot;
+
+        return count;
+    }
+
+
+
+    const TransformHierarchy::Node& TransformHierarchy::getNode(TransformId id) const
+    {
+        if (!isAlive(id))
+            throw std::invalid_argument("Transform isn't alive");
+
+        return m_nodes[id];
+    }
+
+
+
+    void TransformHierarchy::markDirty(std::uint32_t slot)
+    {
+        m_dirty[slot]    = 1;
+        m_firstDirtySlot = std::min(m_firstDirtySlot, slot);
+    }
+
+
+
+    void TransformHierarchy::link(TransformId id, TransformId parent)
+    {
+        TransformId& first = (parent != noTransform) ? m_nodes[parent].firstChild : m_firstRoot;
+        Node&        node  = m_nodes[id];
+
+        node.parent          = parent;
+        node.previousSibling = noTransform;
+        node.nextSibling     = first;
+
+        if (first != noTransform)
+            m_nodes[first].previousSibling = id;
+
+        first = id;
+    }
+
+
+
+    void TransformHierarchy::unlink(TransformId id)
+    {
+        Node& node = m_nodes[id];
+
+        if (node.previousSibling != noTransform)
+            m_nodes[node.previousSibling].nextSibling = node.nextSibling;
+        else if (node.parent != noTransform)
+            m_nodes[node.parent].firstChild = node.nextSibling;
+        else
+            m_firstRoot = node.nextSibling;
+
+        if (node.nextSibling != noTransform)
+            m_nodes[node.nextSibling].previousSibling = node.previousSibling;
+
+        node.parent          = noTransform;
+        node.previousSibling = noTransform;
+        node.nextSibling     = noTransform;
+    }
+
+
+
+    void TransformHierarchy::sort()
+    {
+        CEDAR_PROFILE_FUNCTION();
+
+        // Breadth first from the roots gives every depth in one contiguous range
+        Vector<TransformId> order;
+        order.reserve(m_count);
+
+        for (TransformId id = m_firstRoot; id != noTransform; id = m_nodes[id].nextSibling)
+            order.push_back(id);
+
+        m_depthStarts.clear();
+
+        for (std::size_t begin = 0; begin < order.size();)
+        {
+            std::size_t end = order.size();
+            m_depthStarts.push_back(begin);
+
+            for (std::size_t i = begin; i < end; i++)
+            {
+                for (TransformId child = m_nodes[order[i]].firstChild; child != noTransform; child = m_nodes[child].nextSibling)
+                    order.push_back(child);
+            }
+
+            begin = end;
+        }
+
+        m_depthStarts.push_back(order.size());
+
+        Vector<Transform>        locals(order.size());
+        Vector<Matrix4x4<float>> worlds(order.size());
+        Vector<std::uint32_t>    parentSlots(order.size());
+        Vector<std::uint8_t>     dirty(order.size());
+
+        for (std::size_t i = 0; i < order.size(); i++)
+        {
+            std::uint32_t slot = m_nodes[order[i]].slot;
+
+            locals[i] = m_locals[slot];
+            worlds[i] = m_worlds[slot];
+            dirty[i]  = m_dirty[slot];
+        }
+
+        for (std::size_t i = 0; i < order.size(); i++)
+            m_nodes[order[i]].slot = static_cast<std::uint32_t>(i);
+
+        m_firstDirtySlot = noSlot;
+
+        for (std::size_t i = 0; i < order.size(); i++)
+        {
+            TransformId parent = m_nodes[order[i]].parent;
+            parentSlots[i] = (parent != noTransform) ? m_nodes[parent].slot : noSlot;
+
+            if (dirty[i] != 0 && m_firstDirtySlot == noSlot)
+                m_firstDirtySlot = static_cast<std::uint32_t>(i);
+        }
+
+        m_locals.swap(locals);
+        m_worlds.swap(worlds);
+        m_parentSlots.swap(parentSlots);
+        m_dirty.swap(dirty);
+
+        m_sorted = true;
+    }
+
+
+
+    std::size_t TransformHierarchy::updateRange(std::size_t begin, std::size_t end)
+    {
+        std::size_t count = 0;
+
+        for (std::size_t slot = begin; slot < end; slot++)
+        {
+            std::uint32_t parent = m_parentSlots[slot];
+
+            // A node is recomputed if it changed or its parent was recomputed
+            if (m_dirty[slot] == 0 && (parent == noSlot || m_dirty[parent] == 0))
+                continue;
+
+            const Transform& local  = m_locals[slot];
+            Matrix4x4<float> matrix = trsMatrix(local.position, local.rotation, local.scale);
+
+            m_worlds[slot] = (parent != noSlot) ? multiplyAffine(m_worlds[parent], matrix) : matrix;
+            m_dirty[slot]  = 1;
+
+            count++;
+        }
+
+        return count;
+    }
+}
\ No newline at end of file
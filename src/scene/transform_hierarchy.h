@@ -0,0 +1,169 @@
+//
+// Transform hierarchy.
+//
+// Nodes have a local transform relative to their parent, and update turns those into
+// world matrices. The hot data (local transforms, world matrices, parent links and dirty
+// flags) lives in flat arrays sorted by depth, roots first, so update is one linear
+// pass in which every parent is computed before its children. Only nodes that changed,
+// or whose ancestors did, are recomputed, and depths with enough nodes are split over
+// the job system since nodes at the same depth don't depend on each other.
+//
+// Creating, destroying and reparenting nodes only updates the tree links; the arrays are
+// sorted again by the next update. World matrices are as of the last update.
+//
+// Node ids are reused after the node is destroyed.
+//
+
+#ifndef CEDAR_SCENE_TRANSFORM_HIERARCHY_H
+#define CEDAR_SCENE_TRANSFORM_HIERARCHY_H
+
+#include "../math/matrix.h"
+#include "../math/vector.h"
+#include "../memory/memory_tracker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+
+namespace Cedar::Scene
+{
+    struct Transform;
+
+    class TransformHierarchy;
+
+
+
+    typedef std::uint32_t TransformId;
+
+    constexpr TransformId noTransform = 0xFFFF'FFFF;
+
+
+
+    struct Transform
+    {
+        Vector3D<float> position = { 0.0f, 0.0f, 0.0f };
+        Vector4D<float> rotation = { 0.0f, 0.0f, 0.0f, 1.0f }; // Normalized quaternion
+        Vector3D<float> scale    = { 1.0f, 1.0f, 1.0f };
+    };
+
+
+
+    class TransformHierarchy
+    {
+    public:
+
+        // Depths with fewer nodes than this are updated on the calling thread.
+        static constexpr std::size_t parallelThreshold = 4096;
+
+
+        TransformHierarchy();
+
+
+        // Creates a node under the parent, or a root. Throws std::invalid_argument if the
+        // parent isn't alive.
+        TransformId create(TransformId parent = noTransform, const Transform& local = Transform());
+
+        // Destroys the node and all of its descendants. Throws std::invalid_argument if the
+        // node isn't alive.
+        void destroy(TransformId id);
+
+        bool isAlive(TransformId id) const;
+
+        inline std::size_t getCount() const;
+
+
+        // noTransform makes the node a root. Throws std::invalid_argument if either node
+        // isn't alive or the parent is the node or one of its descendants.
+        void setParent(TransformId id, TransformId parent);
+
+        // Throws std::invalid_argument if the node isn't alive.
+        TransformId getParent(TransformId id) const;
+
+
+        // Throws std::invalid_argument if the node isn't alive.
+        const Transform& getLocal(TransformId id) const;
+
+        // Throws std::invalid_argument if the node isn't alive.
+        void setLocal(TransformId id, const Transform& local);
+
+        void setPosition(TransformId id, const Vector3D<float>& position);
+
+        void setRotation(TransformId id, const Vector4D<float>& rotation);
+
+        void setScale(TransformId id, const Vector3D<float>& scale);
+
+
+        // As of the last update. Throws std::invalid_argument if the node isn't alive.
+        const Matrix4x4<float>& getWorldMatrix(TransformId id) const;
+
+
+        // Recomputes the world matrices of the nodes that changed since the last update
+        // and of their descendants. Returns how many were recomputed.
+        std::size_t update();
+
+    private:
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Scene>>;
+
+        static constexpr std::uint32_t noSlot = 0xFFFF'FFFF;
+
+        // Tree links, indexed by id
+        struct Node
+        {
+            TransformId   parent;
+            TransformId   firstChild;
+            TransformId   nextSibling;
+            TransformId   previousSibling;
+            std::uint32_t slot;         // noSlot while the id is free
+        };
+
+
+        Vector<Node>        m_nodes;
+        Vector<TransformId> m_freeIds;
+        TransformId         m_firstRoot = noTransform;
+        std::size_t         m_count     = 0;
+
+        // Sorted by depth, indexed by slot
+        Vector<Transform>        m_locals;
+        Vector<Matrix4x4<float>> m_worlds;
+        Vector<std::uint32_t>    m_parentSlots;
+        Vector<std::uint8_t>     m_dirty;       // Set when the local transform changed
+        Vector<std::size_t>      m_depthStarts; // First slot of each depth, plus the end
+
+        bool          m_sorted         = true;
+        std::uint32_t m_firstDirtySlot = noSlot;
+
+
+        // Throws std::invalid_argument if the node isn't alive.
+        const Node& getNode(TransformId id) const;
+
+        void markDirty(std::uint32_t slot);
+
+        void link(TransformId id, TransformId parent);
+
+        void unlink(TransformId id);
+
+        // Rebuilds the slot arrays in depth order from the tree links.
+        void sort();
+
+        // Recomputes the dirty nodes of the slot range, which is all at one depth.
+        // Returns how many were recomputed.
+        std::size_t updateRange(std::size_t begin, std::size_t end);
+    };
+
+
+
+    // vvv TransformHierarchy function definitions vvv
+
+    inline std::size_t TransformHierarchy::getCount() const
+    {
+        return m_count;
+    }
+
+    // ^^^ TransformHierarchy function definitions ^^^
+}
+
+#endif // CEDAR_SCENE_TRANSFORM_HIERARCHY_H
\ No newline at end of file
@@ -0,0 +1,362 @@
+#include "world.h"
+
+#include "../memory/memory_tracker.h"
+#include "component.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+
+
+namespace Cedar::Scene
+{
+    Archetype::Archetype(ComponentMask mask) : m_mask(mask), m_chunkAlignment(std::max<std::size_t>(64, alignof(Entity)))
+    {
+        std::size_t rowSize = sizeof(Entity);
+
+        for (ComponentMask bits = mask; bits != 0; bits &= bits - 1)
+        {
+            ComponentId          id   = static_cast<ComponentId>(std::countr_zero(bits));
+            const ComponentInfo& info = getComponentInfo(id);
+
+            m_components.push_back(id);
+
+            rowSize          += info.size;
+            m_chunkAlignment  = std::max(m_chunkAlignment, info.alignment);
+        }
+
+        m_chunkCapacity = std::max<std::size_t>(chunkSize / rowSize, 1);
+
+        // Padding between the arrays can push the last one past the end of the chunk
+        while (true)
+        {
+            std::size_t offset = sizeof(Entity) * m_chunkCapacity;
+
+            for (ComponentId id : m_components)
+            {
+                const ComponentInfo& info = getComponentInfo(id);
+
+                offset        = (offset + info.alignment - 1) / info.alignment * info.alignment;
+                m_offsets[id] = static_cast<std::uint32_t>(offset);
+                offset       += info.size * m_chunkCapacity;
+            }
+
+            // A single row of huge components gets a bigger chunk
+            if (offset <= chunkSize || m_chunkCapacity == 1)
+            {
+                m_chunkBytes = std::max(offset, chunkSize);
+                break;
+            }
+
+            m_chunkCapacity--;
+        }
+    }
+
+
+
+    Archetype::~Archetype()
+    {
+        for (std::size_t row = 0; row < m_size; row++)
+            destroyRow(row);
+
+        for (std::byte* chunk : m_chunks)
+            Memory::deallocate(Memory::Tag::Scene, chunk, m_chunkBytes, m_chunkAlignment);
+    }
+
+
+
+    std::size_t Archetype::pushRow(Entity entity)
+    {
+        if (m_size == m_chunks.size() * m_chunkCapacity)
+        {
+            // Made room for first so the chunk can't leak
+            if (m_chunks.size() == m_chunks.capacity())
+                m_chunks.reserve(std::max<std::size_t>(m_chunks.capacity() * 2, 8));
+
+            m_chunks.push_back(static_cast<std::byte*>(Memory::allocate(Memory::Tag::Scene, m_chunkBytes, m_chunkAlignment)));
+        }
+
+        std::size_t row = m_size++;
+        getEntities(row / m_chunkCapacity)[row % m_chunkCapacity] = entity;
+
+        return row;
+    }
+
+
+
+    Entity Archetype::removeRow(std::size_t row)
+    {
+        std::size_t last  = m_size - 1;
+        Entity      moved = {};
+
+        if (row != last)
+        {
+            for (ComponentId id : m_components)
+                getComponentInfo(id).relocate(getComponent(row, id), getComponent(last, id));
+
+            moved = getEntity(last);
+            getEntities(row / m_chunkCapacity)[row % m_chunkCapacity] = moved;
+        }
+
+        m_size--;
+
+        // One empty chunk is kept for the next row, so an entity moving back and forth
+        // at a chunk boundary doesn't allocate every time
+        while (m_chunks.size() * m_chunkCapacity >= m_size + 2 * m_chunkCapacity)
+        {
+            Memory::deallocate(Memory::Tag::Scene, m_chunks.back(), m_chunkBytes, m_chunkAlignment);
+            m_chunks.pop_back();
+        }
+
+        return moved;
+    }
+
+
+
+    void Archetype::destroyRow(std::size_t row)
+    {
+        for (ComponentId id : m_components)
+        {
+            const ComponentInfo& info = getComponentInfo(id);
+
+            if (info.destroy != nullptr)
+                info.destroy(getComponent(row, id));
+        }
+    }
+
+
+
+    World::World()
+    {
+        // Entities without components
+        (void)getArchetype(0);
+    }
+
+
+
+    World::~World() {}
+
+
+
+    Entity World::create()
+    {
+        return createUninitialized(0);
+    }
+
+
+
+    void World::destroy(Entity entity)
+    {
+        (void)getRecord(entity);
+
+        // The only step that can throw, done before anything changes
+        m_freeIndices.push_back(entity.index);
+
+        EntityRecord& record    = m_records[entity.index];
+        Archetype&    archetype = *record.archetype;
+
+        archetype.destroyRow(record.row);
+
+        Entity moved = archetype.removeRow(record.row);
+
+        if (!moved.isNull())
+            m_records[moved.index].row = record.row;
+
+        // Generations skip 0, which is the null entity's, and pendingGeneration
+        record.archetype = nullptr;
+        record.generation++;
+
+        if (record.generation == 0 || record.generation == pendingGeneration)
+            record.generation = 1;
+
+        m_entityCount--;
+    }
+
+
+
+    bool World::isAlive(Entity entity) const
+    {
+        return entity.index < m_records.size() &&
+               m_records[entity.index].generation == entity.generation &&
+               m_records[entity.index].archetype != nullptr;
+    }
+
+
+
+    Entity World::createUninitialized(ComponentMask mask)
+    {
+        return allocateEntity(getArchetype(mask));
+    }
+
+
+
+    void* World::addUninitialized(Entity entity, ComponentId id)
+    {
+        (void)getRecord(entity);
+
+        EntityRecord& record = m_records[entity.index];
+        Archetype&    source = *record.archetype;
+
+        if (source.has(id))
+        {
+            const ComponentInfo& info      = getComponentInfo(id);
+            void*                component = source.getComponent(record.row, id);
+
+            if (info.destroy != nullptr)
+                info.destroy(component);
+
+            return component;
+        }
+
+        Archetype* destination = source.m_addEdges[id];
+
+        if (destination == nullptr)
+        {
+            destination = &getArchetype(source.m_mask | (ComponentMask(1) << id));
+
+            source.m_addEdges[id]          = destination;
+            destination->m_removeEdges[id] = &source;
+        }
+
+        moveEntity(entity, *destination);
+
+        return destination->getComponent(record.row, id);
+    }
+
+
+
+    void World::removeComponent(Entity entity, ComponentId id)
+    {
+        (void)getRecord(entity);
+
+        EntityRecord& record = m_records[entity.index];
+        Archetype&    source = *record.archetype;
+
+        if (!source.has(id))
+            return;
+
+        Archetype* destination = source.m_removeEdges[id];
+
+        if (destination == nullptr)
+        {
+            destination = &getArchetype(source.m_mask & ~(ComponentMask(1) << id));
+
+            source.m_removeEdges[id]    = destination;
+            destination->m_addEdges[id] = &source;
+        }
+
+        moveEntity(entity, *destination);
+    }
+
+
+
+    void* World::getComponent(Entity entity, ComponentId id) const
+    {
+        const EntityRecord& record = getRecord(entity);
+
+        if (!record.archetype->has(id))
+            return nullptr;
+
+        return record.archetype->getComponent(record.row, id);
+    }
+
+
+
+    const World::EntityRecord& World::getRecord(Entity entity) const
+    {
+        if (!isAlive(entity))
+            throw std::invalid_argument("Entity isn't alive");
+
+        return m_records[entity.index];
+    }
+
+
+
+    Archetype& World::getArchetype(ComponentMask mask)
+    {
+        auto it = m_archetypeMap.find(mask);
+
+        if (it != m_archetypeMap.end())
+            return *it->second;
+
+        if (m_archetypes.size() == m_archetypes.capacity())
+            m_archetypes.reserve(std::max<std::size_t>(m_archetypes.capacity() * 2, 16));
+
+        std::unique_ptr<Archetype> archetype = std::make_unique<Archetype>(mask);
+        m_archetypeMap.emplace(mask, archetype.get());
+        m_archetypes.push_back(std::move(archetype));
+
+        return *m_archetypes.back();
+    }
+
+
+
+    Entity World::allocateEntity(Archetype& archetype)
+    {
+        Entity entity;
+
+        if (!m_freeIndices.empty())
+        {
+            entity.index      = m_freeIndices.back();
+            entity.generation = m_records[entity.index].generation;
+        }
+        else
+        {
+            if (m_records.size() == std::numeric_limits<std::uint32_t>::max())
+                throw std::length_error("Too many entities");
+
+            entity.index      = static_cast<std::uint32_t>(m_records.size());
+            entity.generation = 1;
+
+            // Made room for first, so nothing can throw once the row exists
+            if (m_records.size() == m_records.capacity())
+                m_records.reserve(std::max<std::size_t>(m_records.capacity() * 2, 1024));
+        }
+
+        std::size_t row = archetype.pushRow(entity);
+
+        if (!m_freeIndices.empty())
+            m_freeIndices.pop_back();
+        else
+            m_records.push_back(EntityRecord());
+
+        m_records[entity.index] = { &archetype, row, entity.generation };
+        m_entityCount++;
+
+        return entity;
+    }
+
+
+
+    void World::moveEntity(Entity entity, Archetype& destination)
+    {
+        EntityRecord& record = m_records[entity.index];
+        Archetype&    source = *record.archetype;
+
+        std::size_t row = destination.pushRow(entity);
+
+        for (ComponentId id : source.m_components)
+        {
+            const ComponentInfo& info      = getComponentInfo(id);
+            void*                component = source.getComponent(record.row, id);
+
+            if (destination.has(id))
+                info.relocate(destination.getComponent(row, id), component);
+            else if (info.destroy != nullptr)
+                info.destroy(component);
+        }
+
+        Entity moved = source.removeRow(record.row);
+
+        if (!moved.isNull())
+            m_records[moved.index].row = record.row;
+
+        record.archetype = &destination;
+        record.row       = row;
+    }
+}
\ No newline at end of file
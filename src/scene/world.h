@@ -0,0 +1,540 @@
+//
+// Archetype based entity component system.
+//
+// Entities with the same set of components share an archetype, which stores them in
+// fixed-size chunks as one array per component (and one for the entities themselves),
+// rows packed from the front. Queries walk the archetypes whose component set includes
+// theirs and run over each chunk's arrays linearly, so iterating a million entities
+// touches nothing but the components asked for.
+//
+// Adding or removing a component moves the entity to another archetype, and destroying
+// one moves the archetype's last row into the hole, so these structural changes must
+// not happen while a query is running over the world. Code running inside queries or
+// systems records them in a CommandBuffer instead and plays it back afterwards.
+//
+// Entities are an index and a generation; destroying an entity bumps the generation, so
+// stale handles are detected rather than aliasing a new entity.
+//
+
+#ifndef CEDAR_SCENE_WORLD_H
+#define CEDAR_SCENE_WORLD_H
+
+#include "../jobs/job_system.h"
+#include "../memory/memory_tracker.h"
+#include "component.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+
+namespace Cedar::Scene
+{
+    struct Entity;
+
+    class Archetype;
+
+    class World;
+
+
+
+    // For internal use only. Never a live entity's generation, marks the placeholders
+    // CommandBuffer hands out for entities it will create.
+    constexpr std::uint32_t pendingGeneration = 0xFFFF'FFFF;
+
+
+
+    struct Entity
+    {
+        std::uint32_t index      = 0;
+        std::uint32_t generation = 0; // 0 only for the null entity
+
+
+        inline bool isNull() const;
+
+        inline bool operator==(const Entity& other) const = default;
+    };
+
+
+
+    // For internal use only.
+    class Archetype
+    {
+    public:
+
+        static constexpr std::size_t chunkSize = 64 * 1024;
+
+
+        explicit Archetype(ComponentMask mask);
+
+        // Destroys every component left.
+        ~Archetype();
+
+
+        Archetype(const Archetype&) = delete;
+
+        Archetype& operator=(const Archetype&) = delete;
+
+
+        inline ComponentMask getMask() const;
+
+        inline bool has(ComponentId id) const;
+
+        // Number of entities.
+        inline std::size_t getSize() const;
+
+        inline std::size_t getChunkCount() const;
+
+        inline std::size_t getChunkCapacity() const;
+
+        // Number of entities in the chunk.
+        inline std::size_t getChunkSize(std::size_t chunk) const;
+
+        inline Entity* getEntities(std::size_t chunk) const;
+
+        // The component must be in the archetype.
+        inline void* getColumn(std::size_t chunk, ComponentId id) const;
+
+        template <typename T>
+        inline T* getColumn(std::size_t chunk) const;
+
+        inline Entity getEntity(std::size_t row) const;
+
+        // The component must be in the archetype.
+        inline void* getComponent(std::size_t row, ComponentId id) const;
+
+
+        // Appends a row with uninitialized components and returns its index.
+        std::size_t pushRow(Entity entity);
+
+        // Moves the last row into the row, whose components must already have been
+        // destroyed or moved out. Returns the entity that moved, or the null entity if the
+        // row was the last one.
+        Entity removeRow(std::size_t row);
+
+        // Destroys the row's components.
+        void destroyRow(std::size_t row);
+
+    private:
+
+        friend class World;
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Scene>>;
+
+
+        ComponentMask       m_mask;
+        Vector<ComponentId> m_components;
+        std::size_t         m_size          = 0;
+        std::size_t         m_chunkCapacity = 0;
+        std::size_t         m_chunkBytes    = 0;
+        std::size_t         m_chunkAlignment;
+        Vector<std::byte*>  m_chunks;
+
+        // Byte offset of each component's array in a chunk, the entities are at 0
+        std::array<std::uint32_t, maxComponentTypes> m_offsets = {};
+
+        // Archetypes with one component more or less, found on first use
+        std::array<Archetype*, maxComponentTypes> m_addEdges    = {};
+        std::array<Archetype*, maxComponentTypes> m_removeEdges = {};
+    };
+
+
+
+    class World
+    {
+    public:
+
+        World();
+
+        ~World();
+
+
+        World(const World&) = delete;
+
+        World& operator=(const World&) = delete;
+
+
+        // Creates an entity without components.
+        Entity create();
+
+        // Creates an entity with the components, straight in its archetype. Throws
+        // std::invalid_argument if a component type is repeated.
+        template <typename... T>
+        Entity create(T&&... components);
+
+        // Throws std::invalid_argument if the entity isn't alive.
+        void destroy(Entity entity);
+
+        bool isAlive(Entity entity) const;
+
+        inline std::size_t getEntityCount() const;
+
+        inline std::size_t getArchetypeCount() const;
+
+
+        // Adds the component, or replaces it if the entity already has one. Throws
+        // std::invalid_argument if the entity isn't alive.
+        template <typename T, typename... TArgs>
+        T& add(Entity entity, TArgs&&... args);
+
+        // Does nothing if the entity doesn't have the component. Throws
+        // std::invalid_argument if the entity isn't alive.
+        template <typename T>
+        void remove(Entity entity);
+
+        // Throws std::invalid_argument if the entity isn't alive.
+        template <typename T>
+        bool has(Entity entity) const;
+
+        // nullptr if the entity doesn't have the component. The pointer is invalidated by
+        // the next structural change. Throws std::invalid_argument if the entity isn't
+        // alive.
+        template <typename T>
+        T* tryGet(Entity entity) const;
+
+        // Throws std::invalid_argument if the entity isn't alive or doesn't have the
+        // component.
+        template <typename T>
+        T& get(Entity entity) const;
+
+
+        // Calls function(T&...) or function(Entity, T&...) for every entity that has all
+        // of the components. Const components are only read, which is what systems
+        // declare with Read.
+        template <typename... T, typename TFunction>
+        void each(TFunction&& function);
+
+        // Like each, but spreads the chunks over the job system. The function is called
+        // concurrently and must not throw.
+        template <typename... T, typename TFunction>
+        void parallelEach(TFunction&& function);
+
+        // Number of entities that have all of the components.
+        template <typename... T>
+        std::size_t count() const;
+
+
+        // For internal use only. Creates an entity in the archetype for the mask with
+        // uninitialized components, which the caller must construct.
+        Entity createUninitialized(ComponentMask mask);
+
+        // For internal use only. Moves the entity to an archetype with the component and
+        // returns its uninitialized storage, destroying the old component if it had one.
+        void* addUninitialized(Entity entity, ComponentId id);
+
+        // For internal use only.
+        void removeComponent(Entity entity, ComponentId id);
+
+        // For internal use only. nullptr if the entity doesn't have the component.
+        void* getComponent(Entity entity, ComponentId id) const;
+
+    private:
+
+        template <typename T>
+        using Vector = std::vector<T, Memory::TrackedAllocator<T, Memory::Tag::Scene>>;
+
+        struct EntityRecord
+        {
+            Archetype*    archetype;  // nullptr while the index is free
+            std::size_t   row;
+            std::uint32_t generation;
+        };
+
+        using ArchetypeMap = std::unordered_map<ComponentMask, Archetype*, std::hash<ComponentMask>, std::equal_to<>,
+                                                Memory::TrackedAllocator<std::pair<const ComponentMask, Archetype*>, Memory::Tag::Scene>>;
+
+
+        Vector<std::unique_ptr<Archetype>> m_archetypes;
+        ArchetypeMap                       m_archetypeMap;
+        Vector<EntityRecord>               m_records;
+        Vector<std::uint32_t>              m_freeIndices;
+        std::size_t                        m_entityCount = 0;
+
+
+        // Throws std::invalid_argument if the entity isn't alive.
+        const EntityRecord& getRecord(Entity entity) const;
+
+        Archetype& getArchetype(ComponentMask mask);
+
+        Entity allocateEntity(Archetype& archetype);
+
+        // Moves the entity's row to the other archetype, destroying the components it
+        // doesn't have. The new components are left uninitialized.
+        void moveEntity(Entity entity, Archetype& destination);
+
+        template <typename... T, typename TFunction>
+        static void eachInChunk(const Archetype& archetype, std::size_t chunk, TFunction& function);
+    };
+
+
+
+    // vvv Entity function definitions vvv
+
+    inline bool Entity::isNull() const
+    {
+        return generation == 0;
+    }
+
+    // ^^^ Entity function definitions ^^^
+
+
+
+    // vvv Archetype function definitions vvv
+
+    inline ComponentMask Archetype::getMask() const
+    {
+        return m_mask;
+    }
+
+
+
+    inline bool Archetype::has(ComponentId id) const
+    {
+        return (m_mask & (ComponentMask(1) << id)) != 0;
+    }
+
+
+
+    inline std::size_t Archetype::getSize() const
+    {
+        return m_size;
+    }
+
+
+
+    inline std::size_t Archetype::getChunkCount() const
+    {
+        return (m_size + m_chunkCapacity - 1) / m_chunkCapacity;
+    }
+
+
+
+    inline std::size_t Archetype::getChunkCapacity() const
+    {
+        return m_chunkCapacity;
+    }
+
+
+
+    inline std::size_t Archetype::getChunkSize(std::size_t chunk) const
+    {
+        return std::min(m_size - chunk * m_chunkCapacity, m_chunkCapacity);
+    }
+
+
+
+    inline Entity* Archetype::getEntities(std::size_t chunk) const
+    {
+        return reinterpret_cast<Entity*>(m_chunks[chunk]);
+    }
+
+
+
+    inline void* Archetype::getColumn(std::size_t chunk, ComponentId id) const
+    {
+        return m_chunks[chunk] + m_offsets[id];
+    }
+
+
+
+    template <typename T>
+    inline T* Archetype::getColumn(std::size_t chunk) const
+    {
+        return std::launder(reinterpret_cast<T*>(getColumn(chunk, getComponentId<std::remove_const_t<T>>())));
+    }
+
+
+
+    inline Entity Archetype::getEntity(std::size_t row) const
+    {
+        return getEntities(row / m_chunkCapacity)[row % m_chunkCapacity];
+    }
+
+
+
+    inline void* Archetype::getComponent(std::size_t row, ComponentId id) const
+    {
+        const ComponentInfo& info = getComponentInfo(id);
+        return m_chunks[row / m_chunkCapacity] + m_offsets[id] + row % m_chunkCapacity * info.size;
+    }
+
+    // ^^^ Archetype function definitions ^^^
+
+
+
+    // vvv World function definitions vvv
+
+    inline std::size_t World::getEntityCount() const
+    {
+        return m_entityCount;
+    }
+
+
+
+    inline std::size_t World::getArchetypeCount() const
+    {
+        return m_archetypes.size();
+    }
+
+
+
+    template <typename... T>
+    Entity World::create(T&&... components)
+    {
+        ComponentMask mask = getComponentMask<std::remove_cvref_t<T>...>();
+
+        if (static_cast<std::size_t>(std::popcount(mask)) != sizeof...(T))
+            throw std::invalid_argument("Entity created with the same component twice");
+
+        // Copies can throw, so they're made before the entity exists
+        std::tuple<std::remove_cvref_t<T>...> values(std::forward<T>(components)...);
+
+        Entity entity = createUninitialized(mask);
+
+        std::apply([&](auto&... value) {
+            (::new (getComponent(entity, getComponentId<std::remove_cvref_t<decltype(value)>>()))
+                std::remove_cvref_t<decltype(value)>(std::move(value)), ...);
+        }, values);
+
+        return entity;
+    }
+
+
+
+    template <typename T, typename... TArgs>
+    T& World::add(Entity entity, TArgs&&... args)
+    {
+        (void)getRecord(entity);
+
+        T value(std::forward<TArgs>(args)...);
+
+        return *::new (addUninitialized(entity, getComponentId<T>())) T(std::move(value));
+    }
+
+
+
+    template <typename T>
+    void World::remove(Entity entity)
+    {
+        removeComponent(entity, getComponentId<T>());
+    }
+
+
+
+    template <typename T>
+    bool World::has(Entity entity) const
+    {
+        return getRecord(entity).archetype->has(getComponentId<T>());
+    }
+
+
+
+    template <typename T>
+    T* World::tryGet(Entity entity) const
+    {
+        return std::launder(static_cast<T*>(getComponent(entity, getComponentId<T>())));
+    }
+
+
+
+    template <typename T>
+    T& World::get(Entity entity) const
+    {
+        T* component = tryGet<T>(entity);
+
+        if (component == nullptr)
+            throw std::invalid_argument("Entity doesn't have the component");
+
+        return *component;
+    }
+
+
+
+    template <typename... T, typename TFunction>
+    void World::each(TFunction&& function)
+    {
+        ComponentMask mask = getComponentMask<T...>();
+
+        for (const std::unique_ptr<Archetype>& archetype : m_archetypes)
+        {
+            if ((archetype->m_mask & mask) != mask)
+                continue;
+
+            for (std::size_t chunk = 0, count = archetype->getChunkCount(); chunk < count; chunk++)
+                eachInChunk<T...>(*archetype, chunk, function);
+        }
+    }
+
+
+
+    template <typename... T, typename TFunction>
+    void World::parallelEach(TFunction&& function)
+    {
+        ComponentMask mask = getComponentMask<T...>();
+
+        for (const std::unique_ptr<Archetype>& archetype : m_archetypes)
+        {
+            if ((archetype->m_mask & mask) != mask || archetype->m_size == 0)
+                continue;
+
+            const Archetype& chunks = *archetype;
+
+            Jobs::parallelFor(chunks.getChunkCount(), 1, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t chunk = begin; chunk < end; chunk++)
+                    eachInChunk<T...>(chunks, chunk, function);
+            });
+        }
+    }
+
+
+
+    template <typename... T>
+    std::size_t World::count() const
+    {
+        ComponentMask mask  = getComponentMask<T...>();
+        std::size_t   total = 0;
+
+        for (const std::unique_ptr<Archetype>& archetype : m_archetypes)
+        {
+            if ((archetype->m_mask & mask) == mask)
+                total += archetype->m_size;
+        }
+
+        return total;
+    }
+
+
+
+    template <typename... T, typename TFunction>
+    void World::eachInChunk(const Archetype& archetype, std::size_t chunk, TFunction& function)
+    {
+        std::size_t   size     = archetype.getChunkSize(chunk);
+        const Entity* entities = archetype.getEntities(chunk);
+
+        [&](T*... columns) {
+            for (std::size_t i = 0; i < size; i++)
+            {
+                if constexpr (std::is_invocable_v<TFunction&, Entity, T&...>)
+                    function(entities[i], columns[i]...);
+                else
+                    function(columns[i]...);
+            }
+        }(archetype.getColumn<T>(chunk)...);
+    }
+
+    // ^^^ World function definitions ^^^
+}
+
+#endif // CEDAR_SCENE_WORLD_H
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "string_id.h"
+
+#include "containers/flat_hash_map.h"
+#include "memory/memory_tracker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+
+
+namespace
+{
+    constexpr std::size_t stringBlockSize = 16 * 1024;
+
+
+
+    struct StringBlock;
+
+    class InternTable;
+
+
+
+    struct StringBlock
+    {
+        char*       data;
+        std::size_t size;
+    };
+
+
+
+    // Interned strings are copied into blocks that are never moved or freed before the
+    // table is, so the views handed out stay valid.
+    class InternTable
+    {
+    public:
+
+        InternTable() = default;
+
+        ~InternTable();
+
+
+        InternTable(const InternTable&) = delete;
+
+        InternTable& operator=(const InternTable&) = delete;
+
+
+        void intern(std::uint64_t hash, std::string_view string);
+
+        // An empty view with a null data pointer if the hash isn't interned.
+        std::string_view find(std::uint64_t hash);
+
+    private:
+
+        // Expects the table to be locked exclusively.
+        std::string_view store(std::string_view string);
+
+
+        template <typename T>
+        using Vector = std::vector<T, Cedar::Memory::TrackedAllocator<T>>;
+
+
+        std::shared_mutex                                   m_mutex;
+        Cedar::FlatHashMap<std::uint64_t, std::string_view> m_strings;
+        Vector<StringBlock>                                 m_blocks;
+        char*                                               m_block     = nullptr; // The one being filled
+        std::size_t                                         m_blockUsed = stringBlockSize;
+    };
+
+
+
+    InternTable::~InternTable()
+    {
+        for (const StringBlock& block : m_blocks)
+            Cedar::Memory::deallocate(Cedar::Memory::Tag::General, block.data, block.size, 1);
+    }
+
+
+
+    void InternTable::intern(std::uint64_t hash, std::string_view string)
+    {
+        std::string_view found = find(hash);
+
+        // Checked again under the exclusive lock, another thread may have interned it
+        // meanwhile
+        if (found.data() == nullptr)
+        {
+            std::unique_lock lock(m_mutex);
+
+            auto iterator = m_strings.find(hash);
+
+            // Stored before it's added, so a throwing store leaves no null view behind
+            if (iterator == m_strings.end())
+                iterator = m_strings.tryEmplace(hash, store(string)).first;
+
+            found = iterator->second;
+        }
+
+    #if defined(CEDAR_DEBUG)
+        if (found != string)
+        {
+            throw std::logic_error("StringId collision: \"" + std::string(found) + "\" and \"" + std::string(string) +
+                                   "\" have the same hash");
+        }
+    #endif
+    }
+
+
+
+    std::string_view InternTable::find(std::uint64_t hash)
+    {
+        std::shared_lock lock(m_mutex);
+
+        auto iterator = m_strings.find(hash);
+
+        return iterator != m_strings.end() ? iterator->second : std::string_view();
+    }
+
+
+
+    std::string_view InternTable::store(std::string_view string)
+    {
+        // Empty strings get a non-null view, so they can be told from missing ones
+        if (string.empty())
+            return std::string_view("", 0);
+
+        // Long strings get a block of their own, so they don't waste the rest of the
+        // current one
+        if (string.size() > stringBlockSize / 4)
+        {
+            char* data = static_cast<char*>(Cedar::Memory::allocate(Cedar::Memory::Tag::General, string.size(), 1));
+            m_blocks.push_back({ data, string.size() });
+            std::memcpy(data, string.data(), string.size());
+
+            return std::string_view(data, string.size());
+        }
+
+        if (m_blockUsed + string.size() > stringBlockSize)
+        {
+            m_block = static_cast<char*>(Cedar::Memory::allocate(Cedar::Memory::Tag::General, stringBlockSize, 1));
+            m_blocks.push_back({ m_block, stringBlockSize });
+            m_blockUsed = 0;
+        }
+
+        char* data = m_block + m_blockUsed;
+        std::memcpy(data, string.data(), string.size());
+        m_blockUsed += string.size();
+
+        return std::string_view(data, string.size());
+    }
+}
+
+
+
+// Nifty counter internal details
+namespace
+{
+    static typename std::aligned_storage<sizeof(InternTable), alignof(InternTable)>::type g_internTableBuffer;
+
+    InternTable& g_internTable = reinterpret_cast<InternTable&>(g_internTableBuffer);
+}
+
+
+
+namespace Cedar
+{
+    std::size_t StringIdInitializer::s_counter = 0;
+
+
+
+    StringIdInitializer::StringIdInitializer()
+    {
+        if (s_counter == 0)
+            new (&g_internTable)InternTable();
+
+        s_counter++;
+    }
+
+
+
+    StringIdInitializer::~StringIdInitializer()
+    {
+        s_counter--;
+
+        if (s_counter == 0)
+            g_internTable.~InternTable();
+    }
+}
+// Nifty counter internal details
+
+
+
+namespace Cedar
+{
+    StringId StringId::intern(std::string_view string)
+    {
+        StringId id;
+        id.m_hash = hashString(string);
+
+        internHashed(id.m_hash, string);
+
+        return id;
+    }
+
+
+
+    std::string_view StringId::getString() const
+    {
+        return g_internTable.find(m_hash);
+    }
+
+
+
+    void StringId::internHashed(std::uint64_t hash, std::string_view string)
+    {
+        g_internTable.intern(hash, string);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+//
+// Hashed string identifiers, for names that are compared and looked up far more often than
+// they're read (asset names, event names, profiler zones, log categories...).
+//
+// A StringId is the 64-bit FNV-1a hash of its string, the same hash asset packs use for
+// asset names. Ids of literals are hashed at compile time, so comparing or looking up an
+// id is an integer compare. StringId::intern() also records the string in a global table,
+// so it can be read back with getString() (e.g. for logging or a debug UI). In debug
+// builds every id made at runtime is interned, and interning two different strings that
+// hash to the same id throws std::logic_error.
+//
+
+#ifndef CEDAR_STRING_ID_H
+#define CEDAR_STRING_ID_H
+
+#include "core.h"
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+
+
+
+namespace Cedar
+{
+    class StringId;
+
+
+
+    // Nifty counter. For internal use only
+    class StringIdInitializer
+    {
+    public:
+
+        StringIdInitializer();
+
+        ~StringIdInitializer();
+
+    private:
+
+        static std::size_t s_counter;
+    };
+
+
+
+    // Nifty counter. For internal use only
+    static StringIdInitializer stringIdInitializer;
+
+
+
+    // 64-bit FNV-1a.
+    constexpr std::uint64_t hashString(std::string_view string);
+
+
+
+    class StringId
+    {
+    public:
+
+        // The id of the empty string.
+        constexpr StringId() = default;
+
+        // Hashed at compile time when the string is a constant expression.
+        constexpr explicit StringId(std::string_view string);
+
+        // Hashes the string and records it in the intern table. May be called from any
+        // thread.
+        static StringId intern(std::string_view string);
+
+
+        constexpr std::uint64_t getHash() const;
+
+        // The interned string, or an empty view if the id was never interned. The view
+        // stays valid for the rest of the program.
+        std::string_view getString() const;
+
+
+        constexpr bool operator==(const StringId&) const = default;
+
+        constexpr std::strong_ordering operator<=>(const StringId&) const = default;
+
+    private:
+
+        static void internHashed(std::uint64_t hash, std::string_view string);
+
+
+        std::uint64_t m_hash = hashString({});
+    };
+
+
+
+    namespace StringIdLiterals
+    {
+        // "name"_sid, always hashed at compile time.
+        consteval StringId operator""_sid(const char* string, std::size_t length);
+    }
+
+
+
+    constexpr std::uint64_t hashString(std::string_view string)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+
+        for (char c : string)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+
+
+    // vvv StringId function definitions vvv
+
+    constexpr StringId::StringId(std::string_view string) : m_hash(hashString(string))
+    {
+    #if defined(CEDAR_DEBUG)
+        if (!std::is_constant_evaluated())
+            internHashed(m_hash, string);
+    #endif
+    }
+
+
+
+    constexpr std::uint64_t StringId::getHash() const
+    {
+        return m_hash;
+    }
+
+    // ^^^ StringId function definitions ^^^
+
+
+
+    consteval StringId StringIdLiterals::operator""_sid(const char* string, std::size_t length)
+    {
+        return StringId(std::string_view(string, length));
+    }
+}
+
+
+
+template <>
+struct std::hash<Cedar::StringId>
+{
+    inline std::size_t operator()(Cedar::StringId id) const noexcept
+    {
+        return static_cast<std::size_t>(id.getHash());
+    }
+};
+
+#endif // CEDAR_STRING_ID_H
\ No newline at end of file
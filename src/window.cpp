@@ -2,9 +2,14 @@
 
 #include "callback.h"
 #include "core.h"
+#include "debug/profiler.h"
+#include "graphics/dirty_region.h"
+#include "graphics/rect.h"
+#include "graphics/surface.h"
 #include "io/log.h"
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <new>
 #include <stdexcept>
@@ -30,6 +35,10 @@ namespace
 {
     struct WindowStyles;
 
+    struct FramebufferBuffer;
+
+    struct Framebuffer;
+
 
 
     struct WindowStyles
@@ -40,13 +49,35 @@ namespace
 
 
 
+    struct FramebufferBuffer
+    {
+        HBITMAP                  bitmap = NULL;
+        Cedar::Graphics::Pixel*  pixels = nullptr;
+        Cedar::Size2D<int>       size   = { 0, 0 };
+    };
+
+
+
+    struct Framebuffer
+    {
+        HDC memoryDC = NULL;
+
+        std::array<FramebufferBuffer, 2> buffers;
+        std::size_t                      backBuffer = 0;
+        bool                             locked     = false;
+
+        Cedar::Graphics::DirtyRegion presentedRegion; // What the last present changed
+    };
+
+
+
     struct WindowData
     {
         struct Callbacks
         {
             Cedar::Callback<Cedar::Window::ClosedFunc>            closed;
             Cedar::Callback<Cedar::Window::ClosingFunc>           closing;
-            Cedar::Callback<Cedar::Window::KeyPressedFunc>        keyPressed; // TODO: Call this.
+            Cedar::Callback<Cedar::Window::KeyPressedFunc>        keyPressed;
             Cedar::Callback<Cedar::Window::ResizedFunc>           resized;
             Cedar::Callback<Cedar::Window::VisibilityChangedFunc> visibilityChanged; // TODO: Call this.
         } callback;
@@ -57,6 +88,8 @@ namespace
         Cedar::Window::SizeLimits sizeLimits = { { -1, -1 }, { -1, -1 } };
         WindowStyles              styles     = { 0, 0 };
 
+        Framebuffer framebuffer;
+
 
         inline WindowData() {}
 
@@ -66,11 +99,92 @@ namespace
 
 #elif defined(CEDAR_OS_LINUX) // vvv Linux vvv // ^^^ Windows ^^^
 
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XShm.h>
+
+
+
 namespace
 {
+    struct Atoms;
+
+    struct FramebufferBuffer;
+
+    struct Framebuffer;
+
+
+
+    struct Atoms
+    {
+        Atom wmProtocols;
+        Atom wmDeleteWindow;
+        Atom wmState;
+        Atom netWmName;
+        Atom netWmState;
+        Atom netWmStateHidden;
+        Atom netWmStateFullscreen;
+        Atom netWmStateMaximizedVert;
+        Atom netWmStateMaximizedHorz;
+        Atom utf8String;
+    };
+
+
+
+    struct FramebufferBuffer
+    {
+        XImage*            image              = nullptr;
+        XShmSegmentInfo    shmInfo            = {};
+        bool               shared             = false; // Image lives in shared memory (MIT-SHM)
+        int                pendingCompletions = 0;     // Presents the X server hasn't finished reading yet
+        Cedar::Size2D<int> size               = { 0, 0 };
+    };
+
+
+
+    struct Framebuffer
+    {
+        GC   gc                 = nullptr;
+        bool shmAvailable       = false;
+        int  shmCompletionEvent = 0;
+
+        std::array<FramebufferBuffer, 2> buffers;
+        std::size_t                      backBuffer = 0;
+        bool                             locked     = false;
+
+        Cedar::Graphics::DirtyRegion presentedRegion; // What the last present changed
+    };
+
+
+
     struct WindowData
     {
-        // TODO: Add necessary members.
+        struct Callbacks
+        {
+            Cedar::Callback<Cedar::Window::ClosedFunc>            closed;
+            Cedar::Callback<Cedar::Window::ClosingFunc>           closing;
+            Cedar::Callback<Cedar::Window::KeyPressedFunc>        keyPressed;
+            Cedar::Callback<Cedar::Window::ResizedFunc>           resized;
+            Cedar::Callback<Cedar::Window::VisibilityChangedFunc> visibilityChanged;
+        } callback;
+
+        Display* display = nullptr;
+        ::Window window  = 0;
+        Atoms    atoms   = {};
+
+        Cedar::Window::SizeLimits sizeLimits     = { { -1, -1 }, { -1, -1 } };
+        Cedar::Size2D<int>        size           = { 0, 0 };  // Updated from ConfigureNotify events
+        Cedar::Window::Visibility visibility     = Cedar::Window::Visibility::Hide;
+        bool                      closeRequested = false;
+
+        Framebuffer framebuffer;
+
+
+        inline WindowData() {}
+
+        inline ~WindowData() {}
     };
 }
 
@@ -195,7 +309,7 @@ namespace Cedar::Window
         else
         {
             m_size = clampSizeBetweenLimits(windowSize, m_sizeLimits);
-            Cedar::Log::warning("Window size exceeded the size limits and was clamped");
+            CEDAR_LOG(Cedar::Log::windowCategory, Warning, "Window size exceeded the size limits and was clamped");
         }
 
         return *this;
@@ -286,17 +400,36 @@ namespace
 
     LRESULT wmSize(HWND hWnd, WPARAM wParam, LPARAM lParam);
 
+    LRESULT wmPaint(HWND hWnd);
+
     LRESULT wmClose(HWND hWnd);
 
     LRESULT wmDestroy(HWND hWnd);
 
+    LRESULT wmKeyDown(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+
+    // Returns false for keys Cedar::Key has no value for.
+    bool virtualKeyToKey(WPARAM virtualKey, Cedar::Key& key);
+
+
+
+    void createFramebufferBuffer(FramebufferBuffer& buffer, Cedar::Size2D<int> size);
+
+    void destroyFramebufferBuffer(FramebufferBuffer& buffer);
+
+    void destroyFramebuffer();
+
+    Cedar::Graphics::Surface getFramebufferSurface(const FramebufferBuffer& buffer);
+
+    void blitFramebufferRect(HDC hDC, const FramebufferBuffer& buffer, Cedar::Graphics::Rect rect);
+
 
 
     void registerWindowClass()
     {
         if (g_windowData.windowClass != 0)
         {
-            CEDAR_LOG_TRACE("Window class already registered");
+            CEDAR_LOG(Cedar::Log::windowCategory, Trace, "Window class already registered");
             return;
         }
 
@@ -314,7 +447,7 @@ namespace
             throw std::system_error(GetLastError(), std::system_category(),
                                     "Failed to register window class");
 
-        CEDAR_LOG_DEBUG("Registered window class");
+        CEDAR_LOG(Cedar::Log::windowCategory, Debug, "Registered window class");
     }
 
 
@@ -354,10 +487,15 @@ namespace
                 return wmGetMinMaxInfo(hWnd, lParam);
             case WM_SIZE:
                 return wmSize(hWnd, wParam, lParam);
+            case WM_PAINT:
+                return wmPaint(hWnd);
             case WM_CLOSE:
                 return wmClose(hWnd);
             case WM_DESTROY:
                 return wmDestroy(hWnd);
+            case WM_KEYDOWN:
+            case WM_SYSKEYDOWN:
+                return wmKeyDown(hWnd, uMsg, wParam, lParam);
             default:
                 return DefWindowProcW(hWnd, uMsg, wParam, lParam);
         }
@@ -400,6 +538,24 @@ namespace
 
 
 
+    LRESULT wmPaint(HWND hWnd)
+    {
+        PAINTSTRUCT paint;
+        HDC hDC = BeginPaint(hWnd, &paint);
+
+        // Repaint the invalidated area with the last presented frame, if there is one
+        const Framebuffer& framebuffer = g_windowData.framebuffer;
+        blitFramebufferRect(hDC, framebuffer.buffers[framebuffer.backBuffer ^ 1],
+                            { { paint.rcPaint.left, paint.rcPaint.top },
+                              { paint.rcPaint.right - paint.rcPaint.left, paint.rcPaint.bottom - paint.rcPaint.top } });
+
+        EndPaint(hWnd, &paint);
+
+        return 0;
+    }
+
+
+
     LRESULT wmClose(HWND hWnd)
     {
         bool close = true;
@@ -419,11 +575,189 @@ namespace
     {
         (void)g_windowData.callback.closed.tryCall();
 
+        destroyFramebuffer();
+
         g_windowData.hWnd = NULL;
         PostQuitMessage(0);
 
         return 0;
     }
+
+
+
+    LRESULT wmKeyDown(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+    {
+        Cedar::Key key;
+
+        // Held keys repeat
+        if (virtualKeyToKey(wParam, key))
+            (void)g_windowData.callback.keyPressed.tryCall(key);
+
+        // System keys still need the default handling, e.g. for Alt+F4
+        if (uMsg == WM_SYSKEYDOWN)
+            return DefWindowProcW(hWnd, uMsg, wParam, lParam);
+
+        return 0;
+    }
+
+
+
+    bool virtualKeyToKey(WPARAM virtualKey, Cedar::Key& key)
+    {
+        auto offset = [&key](Cedar::Key first, WPARAM index) {
+            key = static_cast<Cedar::Key>(static_cast<int>(first) + static_cast<int>(index));
+            return true;
+        };
+
+        if (virtualKey >= '0' && virtualKey <= '9')
+            return offset(Cedar::Key::D0, virtualKey - '0');
+        if (virtualKey >= 'A' && virtualKey <= 'Z')
+            return offset(Cedar::Key::A, virtualKey - 'A');
+        if (virtualKey >= VK_NUMPAD0 && virtualKey <= VK_DIVIDE)
+            return offset(Cedar::Key::Numpad_0, virtualKey - VK_NUMPAD0);
+        if (virtualKey >= VK_F1 && virtualKey <= VK_F24)
+            return offset(Cedar::Key::F1, virtualKey - VK_F1);
+        if (virtualKey >= VK_LSHIFT && virtualKey <= VK_RMENU)
+            return offset(Cedar::Key::Left_Shift, virtualKey - VK_LSHIFT);
+        if (virtualKey >= VK_VOLUME_MUTE && virtualKey <= VK_VOLUME_UP)
+            return offset(Cedar::Key::Volume_Mute, virtualKey - VK_VOLUME_MUTE);
+
+        switch (virtualKey) {
+            case VK_BACK:       key = Cedar::Key::Backspace;     return true;
+            case VK_TAB:        key = Cedar::Key::Tab;           return true;
+            case VK_RETURN:     key = Cedar::Key::Enter;         return true;
+            case VK_SHIFT:      key = Cedar::Key::Shift;         return true;
+            case VK_CONTROL:    key = Cedar::Key::Control;       return true;
+            case VK_MENU:       key = Cedar::Key::Alt;           return true;
+            case VK_PAUSE:      key = Cedar::Key::Pause;         return true;
+            case VK_CAPITAL:    key = Cedar::Key::Caps_Lock;     return true;
+            case VK_ESCAPE:     key = Cedar::Key::Escape;        return true;
+            case VK_SPACE:      key = Cedar::Key::Space;         return true;
+            case VK_PRIOR:      key = Cedar::Key::Page_Up;       return true;
+            case VK_NEXT:       key = Cedar::Key::Page_Down;     return true;
+            case VK_END:        key = Cedar::Key::End;           return true;
+            case VK_HOME:       key = Cedar::Key::Home;          return true;
+            case VK_LEFT:       key = Cedar::Key::Left_Arrow;    return true;
+            case VK_UP:         key = Cedar::Key::Up_Arrow;      return true;
+            case VK_RIGHT:      key = Cedar::Key::Right_Arrow;   return true;
+            case VK_DOWN:       key = Cedar::Key::Down_Arrow;    return true;
+            case VK_SELECT:     key = Cedar::Key::Select;        return true;
+            case VK_PRINT:      key = Cedar::Key::Print;         return true;
+            case VK_EXECUTE:    key = Cedar::Key::Execute;       return true;
+            case VK_SNAPSHOT:   key = Cedar::Key::Print_Screen;  return true;
+            case VK_INSERT:     key = Cedar::Key::Insert;        return true;
+            case VK_DELETE:     key = Cedar::Key::Delete;        return true;
+            case VK_HELP:       key = Cedar::Key::Help;          return true;
+            case VK_LWIN:       key = Cedar::Key::Left_Windows;  return true;
+            case VK_RWIN:       key = Cedar::Key::Right_Windows; return true;
+            case VK_APPS:       key = Cedar::Key::Applications;  return true;
+            case VK_SLEEP:      key = Cedar::Key::Sleep;         return true;
+            case VK_NUMLOCK:    key = Cedar::Key::Num_Lock;      return true;
+            case VK_SCROLL:     key = Cedar::Key::Scroll_Lock;   return true;
+            case VK_OEM_1:      key = Cedar::Key::Semicolon;     return true;
+            case VK_OEM_PLUS:   key = Cedar::Key::Equal;         return true;
+            case VK_OEM_COMMA:  key = Cedar::Key::Comma;         return true;
+            case VK_OEM_MINUS:  key = Cedar::Key::Minus;         return true;
+            case VK_OEM_PERIOD: key = Cedar::Key::Period;        return true;
+            case VK_OEM_2:      key = Cedar::Key::Slash;         return true;
+            case VK_OEM_3:      key = Cedar::Key::Grave_Accent;  return true;
+            case VK_OEM_4:      key = Cedar::Key::Open_Bracket;  return true;
+            case VK_OEM_5:      key = Cedar::Key::Backslash;     return true;
+            case VK_OEM_6:      key = Cedar::Key::Close_Bracket; return true;
+            case VK_OEM_7:      key = Cedar::Key::Apostrophe;    return true;
+            default:
+                return false;
+        }
+    }
+
+
+
+    void createFramebufferBuffer(FramebufferBuffer& buffer, Cedar::Size2D<int> size)
+    {
+        destroyFramebufferBuffer(buffer);
+
+        // Nothing to allocate while the window has no client area (e.g. minimized)
+        if (size.width <= 0 || size.height <= 0)
+            return;
+
+        if (g_windowData.framebuffer.memoryDC == NULL)
+        {
+            g_windowData.framebuffer.memoryDC = CreateCompatibleDC(NULL);
+
+            if (g_windowData.framebuffer.memoryDC == NULL)
+                throw std::system_error(GetLastError(), std::system_category(),
+                                        "Failed to create framebuffer device context");
+        }
+
+        BITMAPINFO bitmapInfo;
+        ZeroMemory(&bitmapInfo, sizeof(BITMAPINFO));
+        bitmapInfo.bmiHeader.biSize        = sizeof(BITMAPINFOHEADER);
+        bitmapInfo.bmiHeader.biWidth       = size.width;
+        bitmapInfo.bmiHeader.biHeight      = -size.height; // Negative height for a top-down DIB
+        bitmapInfo.bmiHeader.biPlanes      = 1;
+        bitmapInfo.bmiHeader.biBitCount    = 32;
+        bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+        void* pixels = nullptr;
+        buffer.bitmap = CreateDIBSection(NULL, &bitmapInfo, DIB_RGB_COLORS, &pixels, NULL, 0);
+
+        if (buffer.bitmap == NULL)
+            throw std::system_error(GetLastError(), std::system_category(),
+                                    "Failed to create framebuffer DIB section");
+
+        buffer.pixels = static_cast<Cedar::Graphics::Pixel*>(pixels);
+        buffer.size   = size;
+    }
+
+
+
+    void destroyFramebufferBuffer(FramebufferBuffer& buffer)
+    {
+        if (buffer.bitmap != NULL)
+            (void)DeleteObject(buffer.bitmap);
+
+        buffer = FramebufferBuffer();
+    }
+
+
+
+    void destroyFramebuffer()
+    {
+        Framebuffer& framebuffer = g_windowData.framebuffer;
+
+        for (FramebufferBuffer& buffer : framebuffer.buffers)
+            destroyFramebufferBuffer(buffer);
+
+        if (framebuffer.memoryDC != NULL)
+            (void)DeleteDC(framebuffer.memoryDC);
+
+        framebuffer = Framebuffer();
+    }
+
+
+
+    Cedar::Graphics::Surface getFramebufferSurface(const FramebufferBuffer& buffer)
+    {
+        return { buffer.pixels, buffer.size, buffer.size.width };
+    }
+
+
+
+    void blitFramebufferRect(HDC hDC, const FramebufferBuffer& buffer, Cedar::Graphics::Rect rect)
+    {
+        rect = Cedar::Graphics::intersect(rect, { { 0, 0 }, buffer.size });
+
+        if (buffer.bitmap == NULL || Cedar::Graphics::isEmpty(rect))
+            return;
+
+        HDC     memoryDC       = g_windowData.framebuffer.memoryDC;
+        HGDIOBJ previousBitmap = SelectObject(memoryDC, buffer.bitmap);
+
+        (void)BitBlt(hDC, rect.position.x, rect.position.y, rect.size.width, rect.size.height,
+                     memoryDC, rect.position.x, rect.position.y, SRCCOPY);
+
+        (void)SelectObject(memoryDC, previousBitmap);
+    }
 }
 
 
@@ -500,6 +834,8 @@ namespace Cedar::Window
 
     void pollEvents()
     {
+        CEDAR_PROFILE_SCOPE("Window::pollEvents");
+
         MSG msg;
 
         while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE))
@@ -696,11 +1032,1135 @@ namespace Cedar::Window
 
         (void)ShowWindow(g_windowData.hWnd, cmdShow);
     }
+
+
+
+    Graphics::Surface lockFramebuffer(FramebufferContents contents)
+    {
+        if (!isOpen())
+            throw nullWindowException;
+
+        Framebuffer& framebuffer = g_windowData.framebuffer;
+
+        if (framebuffer.locked)
+            throw std::logic_error("Framebuffer is already locked");
+
+        FramebufferBuffer&       buffer      = framebuffer.buffers[framebuffer.backBuffer];
+        const FramebufferBuffer& frontBuffer = framebuffer.buffers[framebuffer.backBuffer ^ 1];
+        Size2D<int>              size        = getSize();
+        bool                     reallocated = (buffer.size != size);
+
+        if (reallocated)
+            createFramebufferBuffer(buffer, size);
+        else
+        {
+            // GDI batches calls, make sure it's done reading the buffer before it's
+            // written to again
+            (void)GdiFlush();
+        }
+
+        // The back buffer holds the frame before the last one, catch up by copying what
+        // the last present changed. A fresh buffer has to copy everything.
+        if (contents == FramebufferContents::Preserve && frontBuffer.size == buffer.size)
+        {
+            Graphics::DirtyRegion region = framebuffer.presentedRegion;
+
+            if (reallocated)
+            {
+                region.setBounds(buffer.size);
+                region.addAll();
+            }
+
+            Graphics::copyRegion(getFramebufferSurface(frontBuffer), getFramebufferSurface(buffer), region);
+        }
+
+        framebuffer.locked = true;
+
+        return getFramebufferSurface(buffer);
+    }
+
+
+
+    void presentFramebuffer()
+    {
+        Graphics::DirtyRegion dirtyRegion(g_windowData.framebuffer.buffers[g_windowData.framebuffer.backBuffer].size);
+        dirtyRegion.addAll();
+
+        presentFramebuffer(dirtyRegion);
+    }
+
+
+
+    void presentFramebuffer(const Graphics::DirtyRegion& dirtyRegion)
+    {
+        Framebuffer& framebuffer = g_windowData.framebuffer;
+
+        if (!framebuffer.locked)
+            throw std::logic_error("Framebuffer is not locked");
+
+        framebuffer.locked = false;
+
+        const FramebufferBuffer& buffer = framebuffer.buffers[framebuffer.backBuffer];
+
+        // Re-adding clips the rectangles to the buffer in case the region's bounds differ
+        framebuffer.presentedRegion.setBounds(buffer.size);
+
+        for (Graphics::Rect rect : dirtyRegion.getRects())
+            framebuffer.presentedRegion.add(rect);
+
+        HDC hDC = GetDC(g_windowData.hWnd);
+
+        for (Graphics::Rect rect : framebuffer.presentedRegion.getRects())
+            blitFramebufferRect(hDC, buffer, rect);
+
+        (void)ReleaseDC(g_windowData.hWnd, hDC);
+
+        framebuffer.backBuffer ^= 1;
+    }
 }
 
 #elif defined(CEDAR_OS_LINUX) // vvv Linux vvv // ^^^ Windows ^^^
 
-// URGENT: Implement Linux version.
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <climits>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+
+
+namespace
+{
+    // Used when the requested window size is the default
+    constexpr Cedar::Size2D<int> defaultWindowSize = { 800, 600 };
+
+    const std::logic_error nullWindowException = std::logic_error("Window is not open");
+
+    // Set by trapXError while an X error handler is temporarily installed
+    bool g_xErrorTrapped = false;
+
+
+
+    void internAtoms();
+
+    void setWindowTitle(std::string_view title);
+
+    void setSizeHints(Cedar::Window::SizeLimits sizeLimits, bool positionSpecified);
+
+    void changeNetWmState(bool add, Atom first, Atom second);
+
+    Cedar::Window::Visibility queryVisibility();
+
+    void updateVisibility();
+
+    void handleEvent(XEvent& event);
+
+    // Returns false for keys Cedar::Key has no value for.
+    bool keysymToKey(KeySym keysym, Cedar::Key& key);
+
+    void requestClose();
+
+    void destroyWindow();
+
+
+
+    int trapXError(Display* display, XErrorEvent* errorEvent);
+
+    Bool isShmCompletionEvent(Display* display, XEvent* event, XPointer arg);
+
+    void handleShmCompletion(const XEvent& event);
+
+    void createFramebufferBuffer(FramebufferBuffer& buffer, Cedar::Size2D<int> size);
+
+    bool attachSharedImage(FramebufferBuffer& buffer, Visual* visual, int depth, Cedar::Size2D<int> size);
+
+    void destroyFramebufferBuffer(FramebufferBuffer& buffer);
+
+    void destroyFramebuffer();
+
+    void waitForFramebufferBuffer(FramebufferBuffer& buffer);
+
+    Cedar::Graphics::Surface getFramebufferSurface(const FramebufferBuffer& buffer);
+
+    void putFramebufferRect(FramebufferBuffer& buffer, Cedar::Graphics::Rect rect);
+
+
+
+    void internAtoms()
+    {
+        Display* display = g_windowData.display;
+        Atoms&   atoms   = g_windowData.atoms;
+
+        atoms.wmProtocols             = XInternAtom(display, "WM_PROTOCOLS", False);
+        atoms.wmDeleteWindow          = XInternAtom(display, "WM_DELETE_WINDOW", False);
+        atoms.wmState                 = XInternAtom(display, "WM_STATE", False);
+        atoms.netWmName               = XInternAtom(display, "_NET_WM_NAME", False);
+        atoms.netWmState              = XInternAtom(display, "_NET_WM_STATE", False);
+        atoms.netWmStateHidden        = XInternAtom(display, "_NET_WM_STATE_HIDDEN", False);
+        atoms.netWmStateFullscreen    = XInternAtom(display, "_NET_WM_STATE_FULLSCREEN", False);
+        atoms.netWmStateMaximizedVert = XInternAtom(display, "_NET_WM_STATE_MAXIMIZED_VERT", False);
+        atoms.netWmStateMaximizedHorz = XInternAtom(display, "_NET_WM_STATE_MAXIMIZED_HORZ", False);
+        atoms.utf8String              = XInternAtom(display, "UTF8_STRING", False);
+    }
+
+
+
+    void setWindowTitle(std::string_view title)
+    {
+        std::string titleString(title);
+
+        // WM_NAME for old window managers, _NET_WM_NAME for UTF-8 aware ones
+        (void)XStoreName(g_windowData.display, g_windowData.window, titleString.c_str());
+        (void)XChangeProperty(g_windowData.display, g_windowData.window,
+                              g_windowData.atoms.netWmName, g_windowData.atoms.utf8String, 8, PropModeReplace,
+                              reinterpret_cast<const unsigned char*>(titleString.data()),
+                              static_cast<int>(titleString.length()));
+    }
+
+
+
+    void setSizeHints(Cedar::Window::SizeLimits sizeLimits, bool positionSpecified)
+    {
+        XSizeHints* sizeHints = XAllocSizeHints();
+
+        if (sizeHints == nullptr)
+            throw std::bad_alloc();
+
+        if (positionSpecified)
+            sizeHints->flags |= USPosition;
+
+        if (isLimitSet(sizeLimits.minSize.width) || isLimitSet(sizeLimits.minSize.height))
+        {
+            sizeHints->flags     |= PMinSize;
+            sizeHints->min_width  = std::max(sizeLimits.minSize.width, 1);
+            sizeHints->min_height = std::max(sizeLimits.minSize.height, 1);
+        }
+
+        if (isLimitSet(sizeLimits.maxSize.width) || isLimitSet(sizeLimits.maxSize.height))
+        {
+            sizeHints->flags     |= PMaxSize;
+            sizeHints->max_width  = isLimitSet(sizeLimits.maxSize.width) ? sizeLimits.maxSize.width : INT_MAX;
+            sizeHints->max_height = isLimitSet(sizeLimits.maxSize.height) ? sizeLimits.maxSize.height : INT_MAX;
+        }
+
+        XSetWMNormalHints(g_windowData.display, g_windowData.window, sizeHints);
+        (void)XFree(sizeHints);
+    }
+
+
+
+    void changeNetWmState(bool add, Atom first, Atom second)
+    {
+        // Mapped windows have their state changed by asking the window manager
+        // (EWMH _NET_WM_STATE client message)
+        XEvent event = {};
+        event.xclient.type         = ClientMessage;
+        event.xclient.window       = g_windowData.window;
+        event.xclient.message_type = g_windowData.atoms.netWmState;
+        event.xclient.format       = 32;
+        event.xclient.data.l[0]    = add ? 1 : 0; // _NET_WM_STATE_ADD : _NET_WM_STATE_REMOVE
+        event.xclient.data.l[1]    = static_cast<long>(first);
+        event.xclient.data.l[2]    = static_cast<long>(second);
+        event.xclient.data.l[3]    = 1; // Normal application
+
+        (void)XSendEvent(g_windowData.display, DefaultRootWindow(g_windowData.display), False,
+                         SubstructureRedirectMask | SubstructureNotifyMask, &event);
+    }
+
+
+
+    Cedar::Window::Visibility queryVisibility()
+    {
+        Display*      display = g_windowData.display;
+        const Atoms&  atoms   = g_windowData.atoms;
+
+        bool hidden         = false;
+        bool maximizedVert  = false;
+        bool maximizedHorz  = false;
+        bool iconic         = false;
+
+        Atom           type;
+        int            format;
+        unsigned long  itemCount;
+        unsigned long  bytesAfter;
+        unsigned char* data = nullptr;
+
+        if (XGetWindowProperty(display, g_windowData.window, atoms.netWmState, 0, 1024, False, XA_ATOM,
+                               &type, &format, &itemCount, &bytesAfter, &data) == Success && data != nullptr)
+        {
+            const Atom* states = reinterpret_cast<const Atom*>(data);
+
+            for (unsigned long i = 0; i < itemCount; i++)
+            {
+                hidden        |= (states[i] == atoms.netWmStateHidden);
+                maximizedVert |= (states[i] == atoms.netWmStateMaximizedVert);
+                maximizedHorz |= (states[i] == atoms.netWmStateMaximizedHorz);
+            }
+
+            (void)XFree(data);
+            data = nullptr;
+        }
+
+        if (XGetWindowProperty(display, g_windowData.window, atoms.wmState, 0, 2, False, atoms.wmState,
+                               &type, &format, &itemCount, &bytesAfter, &data) == Success && data != nullptr)
+        {
+            iconic = (itemCount > 0 && reinterpret_cast<const long*>(data)[0] == IconicState);
+            (void)XFree(data);
+        }
+
+        XWindowAttributes attributes;
+        (void)XGetWindowAttributes(display, g_windowData.window, &attributes);
+
+        if (hidden || iconic)
+            return Cedar::Window::Visibility::Minimize;
+        else if (attributes.map_state == IsUnmapped)
+            return Cedar::Window::Visibility::Hide;
+        else if (maximizedVert && maximizedHorz)
+            return Cedar::Window::Visibility::Maximize;
+        else
+            return Cedar::Window::Visibility::Show;
+    }
+
+
+
+    void updateVisibility()
+    {
+        Cedar::Window::Visibility visibility = queryVisibility();
+
+        if (visibility != g_windowData.visibility)
+        {
+            g_windowData.visibility = visibility;
+            (void)g_windowData.callback.visibilityChanged.tryCall();
+        }
+    }
+
+
+
+    void handleEvent(XEvent& event)
+    {
+        switch (event.type) {
+            case ClientMessage:
+            {
+                if (event.xclient.message_type == g_windowData.atoms.wmProtocols &&
+                    static_cast<Atom>(event.xclient.data.l[0]) == g_windowData.atoms.wmDeleteWindow)
+                    requestClose();
+
+                break;
+            }
+            case ConfigureNotify:
+            {
+                // Only the latest size is kept, the framebuffer picks it up on its next lock
+                Cedar::Size2D<int> size = { event.xconfigure.width, event.xconfigure.height };
+
+                if (size != g_windowData.size)
+                {
+                    g_windowData.size = size;
+                    (void)g_windowData.callback.resized.tryCall();
+                }
+
+                break;
+            }
+            case KeyPress:
+            {
+                // Level 0, so letters are the same with or without Shift. Held keys repeat
+                Cedar::Key key;
+
+                if (keysymToKey(XLookupKeysym(&event.xkey, 0), key))
+                    (void)g_windowData.callback.keyPressed.tryCall(key);
+
+                break;
+            }
+            case MapNotify:
+            case UnmapNotify:
+                updateVisibility(); break;
+            case PropertyNotify:
+            {
+                if (event.xproperty.atom == g_windowData.atoms.netWmState || event.xproperty.atom == g_windowData.atoms.wmState)
+                    updateVisibility();
+
+                break;
+            }
+            case Expose:
+            {
+                // Repaint the exposed area with the last presented frame, if there is one
+                Framebuffer& framebuffer = g_windowData.framebuffer;
+
+                putFramebufferRect(framebuffer.buffers[framebuffer.backBuffer ^ 1],
+                                   { { event.xexpose.x, event.xexpose.y }, { event.xexpose.width, event.xexpose.height } });
+                (void)XFlush(g_windowData.display);
+
+                break;
+            }
+            default:
+            {
+                if (event.type == g_windowData.framebuffer.shmCompletionEvent && g_windowData.framebuffer.shmAvailable)
+                    handleShmCompletion(event);
+
+                break;
+            }
+        }
+    }
+
+
+
+    bool keysymToKey(KeySym keysym, Cedar::Key& key)
+    {
+        auto offset = [&key](Cedar::Key first, KeySym index) {
+            key = static_cast<Cedar::Key>(static_cast<int>(first) + static_cast<int>(index));
+            return true;
+        };
+
+        if (keysym >= XK_0 && keysym <= XK_9)
+            return offset(Cedar::Key::D0, keysym - XK_0);
+        if (keysym >= XK_a && keysym <= XK_z)
+            return offset(Cedar::Key::A, keysym - XK_a);
+        if (keysym >= XK_KP_0 && keysym <= XK_KP_9)
+            return offset(Cedar::Key::Numpad_0, keysym - XK_KP_0);
+        if (keysym >= XK_F1 && keysym <= XK_F24)
+            return offset(Cedar::Key::F1, keysym - XK_F1);
+
+        switch (keysym) {
+            case XK_BackSpace:    key = Cedar::Key::Backspace;     return true;
+            case XK_Tab:          key = Cedar::Key::Tab;           return true;
+            case XK_Return:       key = Cedar::Key::Enter;         return true;
+            case XK_KP_Enter:     key = Cedar::Key::Enter;         return true;
+            case XK_Pause:        key = Cedar::Key::Pause;         return true;
+            case XK_Caps_Lock:    key = Cedar::Key::Caps_Lock;     return true;
+            case XK_Escape:       key = Cedar::Key::Escape;        return true;
+            case XK_space:        key = Cedar::Key::Space;         return true;
+            case XK_Prior:        key = Cedar::Key::Page_Up;       return true;
+            case XK_Next:         key = Cedar::Key::Page_Down;     return true;
+            case XK_End:          key = Cedar::Key::End;           return true;
+            case XK_Home:         key = Cedar::Key::Home;          return true;
+            case XK_Left:         key = Cedar::Key::Left_Arrow;    return true;
+            case XK_Up:           key = Cedar::Key::Up_Arrow;      return true;
+            case XK_Right:        key = Cedar::Key::Right_Arrow;   return true;
+            case XK_Down:         key = Cedar::Key::Down_Arrow;    return true;
+            case XK_Select:       key = Cedar::Key::Select;        return true;
+            case XK_Print:        key = Cedar::Key::Print_Screen;  return true;
+            case XK_Execute:      key = Cedar::Key::Execute;       return true;
+            case XK_Insert:       key = Cedar::Key::Insert;        return true;
+            case XK_Delete:       key = Cedar::Key::Delete;        return true;
+            case XK_Help:         key = Cedar::Key::Help;          return true;
+            case XK_Super_L:      key = Cedar::Key::Left_Windows;  return true;
+            case XK_Super_R:      key = Cedar::Key::Right_Windows; return true;
+            case XK_Menu:         key = Cedar::Key::Applications;  return true;
+            case XK_KP_Multiply:  key = Cedar::Key::Multiply;      return true;
+            case XK_KP_Add:       key = Cedar::Key::Add;           return true;
+            case XK_KP_Separator: key = Cedar::Key::Separator;     return true;
+            case XK_KP_Subtract:  key = Cedar::Key::Subtract;      return true;
+            case XK_KP_Decimal:   key = Cedar::Key::Decimal;       return true;
+            case XK_KP_Divide:    key = Cedar::Key::Divide;        return true;
+            case XK_Num_Lock:     key = Cedar::Key::Num_Lock;      return true;
+            case XK_Scroll_Lock:  key = Cedar::Key::Scroll_Lock;   return true;
+            case XK_Shift_L:      key = Cedar::Key::Left_Shift;    return true;
+            case XK_Shift_R:      key = Cedar::Key::Right_Shift;   return true;
+            case XK_Control_L:    key = Cedar::Key::Left_Control;  return true;
+            case XK_Control_R:    key = Cedar::Key::Right_Control; return true;
+            case XK_Alt_L:        key = Cedar::Key::Left_Alt;      return true;
+            case XK_Alt_R:        key = Cedar::Key::Right_Alt;     return true;
+            case XK_semicolon:    key = Cedar::Key::Semicolon;     return true;
+            case XK_equal:        key = Cedar::Key::Equal;         return true;
+            case XK_comma:        key = Cedar::Key::Comma;         return true;
+            case XK_minus:        key = Cedar::Key::Minus;         return true;
+            case XK_period:       key = Cedar::Key::Period;        return true;
+            case XK_slash:        key = Cedar::Key::Slash;         return true;
+            case XK_grave:        key = Cedar::Key::Grave_Accent;  return true;
+            case XK_bracketleft:  key = Cedar::Key::Open_Bracket;  return true;
+            case XK_backslash:    key = Cedar::Key::Backslash;     return true;
+            case XK_bracketright: key = Cedar::Key::Close_Bracket; return true;
+            case XK_apostrophe:   key = Cedar::Key::Apostrophe;    return true;
+            default:
+                return false;
+        }
+    }
+
+
+
+    void requestClose()
+    {
+        bool close = true;
+
+        if (g_windowData.callback.closing.canCall())
+            close = g_windowData.callback.closing.call();
+
+        if (close)
+            destroyWindow();
+    }
+
+
+
+    void destroyWindow()
+    {
+        (void)g_windowData.callback.closed.tryCall();
+
+        destroyFramebuffer();
+
+        (void)XDestroyWindow(g_windowData.display, g_windowData.window);
+        (void)XCloseDisplay(g_windowData.display);
+
+        g_windowData.display        = nullptr;
+        g_windowData.window         = 0;
+        g_windowData.size           = { 0, 0 };
+        g_windowData.visibility     = Cedar::Window::Visibility::Hide;
+        g_windowData.closeRequested = false;
+    }
+
+
+
+    int trapXError(Display* display, XErrorEvent* errorEvent)
+    {
+        g_xErrorTrapped = true;
+        return 0;
+    }
+
+
+
+    Bool isShmCompletionEvent(Display* display, XEvent* event, XPointer arg)
+    {
+        return (event->type == g_windowData.framebuffer.shmCompletionEvent) ? True : False;
+    }
+
+
+
+    void handleShmCompletion(const XEvent& event)
+    {
+        const XShmCompletionEvent& completionEvent = reinterpret_cast<const XShmCompletionEvent&>(event);
+
+        for (FramebufferBuffer& buffer : g_windowData.framebuffer.buffers)
+        {
+            if (buffer.shared && buffer.shmInfo.shmseg == completionEvent.shmseg && buffer.pendingCompletions > 0)
+                buffer.pendingCompletions--;
+        }
+    }
+
+
+
+    void createFramebufferBuffer(FramebufferBuffer& buffer, Cedar::Size2D<int> size)
+    {
+        destroyFramebufferBuffer(buffer);
+
+        // Nothing to allocate while the window has no area
+        if (size.width <= 0 || size.height <= 0)
+            return;
+
+        Display* display = g_windowData.display;
+        int      screen  = DefaultScreen(display);
+        Visual*  visual  = DefaultVisual(display, screen);
+        int      depth   = DefaultDepth(display, screen);
+
+        if (visual->c_class != TrueColor || (depth != 24 && depth != 32) ||
+            visual->red_mask != 0xFF0000 || visual->green_mask != 0x00FF00 || visual->blue_mask != 0x0000FF)
+            throw std::runtime_error("The X server's default visual isn't 32-bit BGRA, which the framebuffer requires");
+
+        if (g_windowData.framebuffer.shmAvailable && !attachSharedImage(buffer, visual, depth, size))
+        {
+            g_windowData.framebuffer.shmAvailable = false;
+            CEDAR_LOG(Cedar::Log::windowCategory, Warning, "MIT-SHM unavailable, framebuffer presents will be copied through the X connection");
+        }
+
+        if (!buffer.shared)
+        {
+            // XDestroyImage releases the pixels with free, so they have to come from malloc
+            char* pixels = static_cast<char*>(std::malloc(static_cast<std::size_t>(size.width) * size.height * sizeof(Cedar::Graphics::Pixel)));
+
+            if (pixels == nullptr)
+                throw std::bad_alloc();
+
+            buffer.image = XCreateImage(display, visual, depth, ZPixmap, 0, pixels, size.width, size.height, 32, 0);
+
+            if (buffer.image == nullptr)
+            {
+                std::free(pixels);
+                throw std::runtime_error("Failed to create framebuffer image");
+            }
+        }
+
+        buffer.size = size;
+    }
+
+
+
+    bool attachSharedImage(FramebufferBuffer& buffer, Visual* visual, int depth, Cedar::Size2D<int> size)
+    {
+        Display* display = g_windowData.display;
+
+        buffer.image = XShmCreateImage(display, visual, depth, ZPixmap, nullptr, &buffer.shmInfo, size.width, size.height);
+
+        if (buffer.image == nullptr)
+            return false;
+
+        buffer.shmInfo.shmid   = shmget(IPC_PRIVATE, static_cast<std::size_t>(buffer.image->bytes_per_line) * buffer.image->height, IPC_CREAT | 0600);
+        buffer.shmInfo.shmaddr = reinterpret_cast<char*>(-1);
+
+        if (buffer.shmInfo.shmid >= 0)
+        {
+            buffer.shmInfo.shmaddr  = static_cast<char*>(shmat(buffer.shmInfo.shmid, nullptr, 0));
+            buffer.shmInfo.readOnly = False;
+
+            if (buffer.shmInfo.shmaddr != reinterpret_cast<char*>(-1))
+            {
+                buffer.image->data = buffer.shmInfo.shmaddr;
+
+                // Attaching fails asynchronously on connections that can't share memory
+                // with the server (e.g. remote displays), which would be fatal with the
+                // default error handler
+                g_xErrorTrapped = false;
+                XErrorHandler previousHandler = XSetErrorHandler(trapXError);
+
+                (void)XShmAttach(display, &buffer.shmInfo);
+                (void)XSync(display, False);
+
+                (void)XSetErrorHandler(previousHandler);
+
+                buffer.shared = !g_xErrorTrapped;
+            }
+
+            // Marking the segment for removal right away means it's released as soon as
+            // both this process and the X server have detached, even after a crash
+            (void)shmctl(buffer.shmInfo.shmid, IPC_RMID, nullptr);
+        }
+
+        if (!buffer.shared)
+        {
+            if (buffer.shmInfo.shmaddr != reinterpret_cast<char*>(-1))
+                (void)shmdt(buffer.shmInfo.shmaddr);
+
+            buffer.image->data = nullptr;
+            (void)XDestroyImage(buffer.image);
+
+            buffer.image   = nullptr;
+            buffer.shmInfo = {};
+        }
+
+        return buffer.shared;
+    }
+
+
+
+    void destroyFramebufferBuffer(FramebufferBuffer& buffer)
+    {
+        if (buffer.image == nullptr)
+            return;
+
+        if (buffer.shared)
+        {
+            waitForFramebufferBuffer(buffer);
+
+            (void)XShmDetach(g_windowData.display, &buffer.shmInfo);
+            (void)XSync(g_windowData.display, False);
+            (void)shmdt(buffer.shmInfo.shmaddr);
+
+            // The pixels belong to the shared memory segment, not malloc
+            buffer.image->data = nullptr;
+        }
+
+        (void)XDestroyImage(buffer.image);
+
+        buffer = FramebufferBuffer();
+    }
+
+
+
+    void destroyFramebuffer()
+    {
+        Framebuffer& framebuffer = g_windowData.framebuffer;
+
+        for (FramebufferBuffer& buffer : framebuffer.buffers)
+            destroyFramebufferBuffer(buffer);
+
+        if (framebuffer.gc != nullptr)
+            (void)XFreeGC(g_windowData.display, framebuffer.gc);
+
+        framebuffer = Framebuffer();
+    }
+
+
+
+    void waitForFramebufferBuffer(FramebufferBuffer& buffer)
+    {
+        // Only takes completion events out of the queue, everything else is left for
+        // pollEvents
+        while (buffer.pendingCompletions > 0)
+        {
+            XEvent event;
+            (void)XIfEvent(g_windowData.display, &event, isShmCompletionEvent, nullptr);
+            handleShmCompletion(event);
+        }
+    }
+
+
+
+    Cedar::Graphics::Surface getFramebufferSurface(const FramebufferBuffer& buffer)
+    {
+        if (buffer.image == nullptr)
+            return Cedar::Graphics::Surface();
+
+        return { reinterpret_cast<Cedar::Graphics::Pixel*>(buffer.image->data), buffer.size,
+                 buffer.image->bytes_per_line / static_cast<int>(sizeof(Cedar::Graphics::Pixel)) };
+    }
+
+
+
+    void putFramebufferRect(FramebufferBuffer& buffer, Cedar::Graphics::Rect rect)
+    {
+        rect = Cedar::Graphics::intersect(rect, { { 0, 0 }, buffer.size });
+
+        if (buffer.image == nullptr || Cedar::Graphics::isEmpty(rect))
+            return;
+
+        if (buffer.shared)
+        {
+            // The server reads the pixels straight out of shared memory and sends a
+            // completion event once it's done with them
+            (void)XShmPutImage(g_windowData.display, g_windowData.window, g_windowData.framebuffer.gc, buffer.image,
+                               rect.position.x, rect.position.y, rect.position.x, rect.position.y,
+                               rect.size.width, rect.size.height, True);
+            buffer.pendingCompletions++;
+        }
+        else
+        {
+            (void)XPutImage(g_windowData.display, g_windowData.window, g_windowData.framebuffer.gc, buffer.image,
+                            rect.position.x, rect.position.y, rect.position.x, rect.position.y,
+                            rect.size.width, rect.size.height);
+        }
+    }
+}
+
+
+
+namespace Cedar::Window
+{
+    bool isOpen()
+    {
+        return g_windowData.window != 0;
+    }
+
+
+
+    void open(const OpenArgs& openArgs)
+    {
+        if (isOpen())
+            throw std::logic_error("Window is already open");
+
+        g_windowData.display = XOpenDisplay(nullptr);
+
+        if (g_windowData.display == nullptr)
+            throw std::runtime_error("Failed to connect to the X server");
+
+        internAtoms();
+
+        Display* display = g_windowData.display;
+        int      screen  = DefaultScreen(display);
+
+        bool         positionSpecified = (openArgs.getPosition() != OpenArgs::defaultPosition);
+        Point2D<int> pos               = positionSpecified ? openArgs.getPosition() : Point2D<int>{ 0, 0 };
+        Size2D<int>  size              = (openArgs.getSize() == OpenArgs::defaultSize) ?
+                                         clampSizeBetweenLimits(defaultWindowSize, openArgs.getSizeLimits()) :
+                                         openArgs.getSize();
+
+        XSetWindowAttributes attributes = {};
+        attributes.background_pixel = BlackPixel(display, screen);
+        attributes.event_mask       = StructureNotifyMask | ExposureMask | PropertyChangeMask | KeyPressMask;
+
+        g_windowData.window = XCreateWindow(display, RootWindow(display, screen),
+                                            pos.x, pos.y,
+                                            static_cast<unsigned int>(size.width), static_cast<unsigned int>(size.height),
+                                            0, CopyFromParent, InputOutput, CopyFromParent,
+                                            CWBackPixel | CWEventMask, &attributes);
+
+        if (g_windowData.window == 0)
+        {
+            (void)XCloseDisplay(display);
+            g_windowData.display = nullptr;
+
+            throw std::runtime_error("Failed to create window");
+        }
+
+        (void)XSetWMProtocols(display, g_windowData.window, &g_windowData.atoms.wmDeleteWindow, 1);
+
+        setWindowTitle(openArgs.getTitle());
+        setSizeHints(openArgs.getSizeLimits(), positionSpecified);
+
+        g_windowData.sizeLimits = openArgs.getSizeLimits();
+        g_windowData.size       = size;
+        g_windowData.visibility = Visibility::Hide;
+
+        int shmMajorOpcode;
+        int shmFirstEvent;
+        int shmFirstError;
+
+        Framebuffer& framebuffer = g_windowData.framebuffer;
+        framebuffer.gc           = XCreateGC(display, g_windowData.window, 0, nullptr);
+        framebuffer.shmAvailable = XQueryExtension(display, "MIT-SHM", &shmMajorOpcode, &shmFirstEvent, &shmFirstError) &&
+                                   XShmQueryExtension(display);
+
+        if (framebuffer.shmAvailable)
+            framebuffer.shmCompletionEvent = XShmGetEventBase(display) + ShmCompletion;
+
+        setVisibility(openArgs.getVisibility());
+    }
+
+
+
+    void close()
+    {
+        // Handled by the next pollEvents call, like the close message posted on Windows
+        g_windowData.closeRequested = true;
+    }
+
+
+
+    void pollEvents()
+    {
+        CEDAR_PROFILE_SCOPE("Window::pollEvents");
+
+        if (!isOpen())
+            return;
+
+        if (g_windowData.closeRequested)
+        {
+            g_windowData.closeRequested = false;
+            requestClose();
+        }
+
+        // Handling an event can close the window
+        while (isOpen() && XPending(g_windowData.display) > 0)
+        {
+            XEvent event;
+            (void)XNextEvent(g_windowData.display, &event);
+
+            handleEvent(event);
+        }
+    }
+
+
+
+    Callback<ClosedFunc> getClosedCallback()
+    {
+        return g_windowData.callback.closed;
+    }
+
+
+
+    Callback<ClosingFunc> getClosingCallback()
+    {
+        return g_windowData.callback.closing;
+    }
+
+
+
+    Callback<KeyPressedFunc> getKeyPressedCallback()
+    {
+        return g_windowData.callback.keyPressed;
+    }
+
+
+
+    Callback<ResizedFunc> getResizedCallback()
+    {
+        return g_windowData.callback.resized;
+    }
+
+
+
+    Callback<VisibilityChangedFunc> getVisibilityChangedCallback()
+    {
+        return g_windowData.callback.visibilityChanged;
+    }
+
+
+
+    void setClosedCallback(Callback<ClosedFunc> closedCallback)
+    {
+        g_windowData.callback.closed = closedCallback;
+    }
+
+
+
+    void setClosingCallback(Callback<ClosingFunc> closingCallback)
+    {
+        g_windowData.callback.closing = closingCallback;
+    }
+
+
+
+    void setKeyPressedCallback(Callback<KeyPressedFunc> keyPressedCallback)
+    {
+        g_windowData.callback.keyPressed = keyPressedCallback;
+    }
+
+
+
+    void setResizedCallback(Callback<ResizedFunc> resizedCallback)
+    {
+        g_windowData.callback.resized = resizedCallback;
+    }
+
+
+
+    void setVisibilityChangedCallback(Callback<VisibilityChangedFunc> visibilityChangedCallback)
+    {
+        g_windowData.callback.visibilityChanged = visibilityChangedCallback;
+    }
+
+
+
+    std::string getTitle()
+    {
+        if (!isOpen())
+            throw nullWindowException;
+
+        Atom           type;
+        int            format;
+        unsigned long  itemCount;
+        unsigned long  bytesAfter;
+        unsigned char* data = nullptr;
+
+        std::string title;
+
+        if (XGetWindowProperty(g_windowData.display, g_windowData.window, g_windowData.atoms.netWmName, 0, LONG_MAX / 4,
+                               False, g_windowData.atoms.utf8String, &type, &format, &itemCount, &bytesAfter, &data) == Success &&
+            data != nullptr)
+        {
+            title.assign(reinterpret_cast<const char*>(data), itemCount);
+            (void)XFree(data);
+        }
+
+        return title;
+    }
+
+
+
+    Point2D<int> getPosition()
+    {
+        if (!isOpen())
+            throw nullWindowException;
+
+        int      x;
+        int      y;
+        ::Window child;
+
+        (void)XTranslateCoordinates(g_windowData.display, g_windowData.window, DefaultRootWindow(g_windowData.display),
+                                    0, 0, &x, &y, &child);
+
+        return { x, y };
+    }
+
+
+
+    Size2D<int> getSize()
+    {
+        if (!isOpen())
+            throw nullWindowException;
+
+        return g_windowData.size;
+    }
+
+
+
+    SizeLimits getSizeLimits()
+    {
+        if (!isOpen())
+            throw nullWindowException;
+
+        return g_windowData.sizeLimits;
+    }
+
+
+
+    Mode getMode()
+    {
+        if (!isOpen())
+            throw nullWindowException;
+
+        // Window managers fullscreen a window by covering the monitor with it undecorated,
+        // without changing the video mode, which is what borderless fullscreen is
+        Atom           type;
+        int            format;
+        unsigned long  itemCount;
+        unsigned long  bytesAfter;
+        unsigned char* data       = nullptr;
+        bool           fullscreen = false;
+
+        if (XGetWindowProperty(g_windowData.display, g_windowData.window, g_windowData.atoms.netWmState, 0, 1024, False,
+                               XA_ATOM, &type, &format, &itemCount, &bytesAfter, &data) == Success && data != nullptr)
+        {
+            const Atom* states = reinterpret_cast<const Atom*>(data);
+
+            fullscreen = std::find(states, states + itemCount, g_windowData.atoms.netWmStateFullscreen) != states + itemCount;
+
+            (void)XFree(data);
+        }
+
+        return fullscreen ? Mode::Fullscreen_borderless : Mode::Windowed;
+    }
+
+
+
+    Visibility getVisibility()
+    {
+        if (!isOpen())
+            throw nullWindowException;
+
+        // Kept up to date by pollEvents, querying the X server here would cost a round
+        // trip on every call
+        return g_windowData.visibility;
+    }
+
+
+
+    void setVisibility(Visibility visibility)
+    {
+        if (!isOpen())
+            throw nullWindowException;
+
+        Display*     display = g_windowData.display;
+        ::Window     window  = g_windowData.window;
+        const Atoms& atoms   = g_windowData.atoms;
+        bool         mapped  = (g_windowData.visibility != Visibility::Hide);
+
+        switch (visibility) {
+            case Visibility::Show:
+            {
+                if (g_windowData.visibility == Visibility::Maximize)
+                    changeNetWmState(false, atoms.netWmStateMaximizedVert, atoms.netWmStateMaximizedHorz);
+
+                (void)XMapRaised(display, window);
+                break;
+            }
+            case Visibility::Hide:
+                (void)XWithdrawWindow(display, window, DefaultScreen(display)); break;
+            case Visibility::Minimize:
+            {
+                if (mapped)
+                    (void)XIconifyWindow(display, window, DefaultScreen(display));
+                else
+                {
+                    // Unmapped windows can't be iconified, ask for them to start iconic
+                    XWMHints* hints = XAllocWMHints();
+
+                    if (hints == nullptr)
+                        throw std::bad_alloc();
+
+                    hints->flags         = StateHint;
+                    hints->initial_state = IconicState;
+                    (void)XSetWMHints(display, window, hints);
+                    (void)XFree(hints);
+
+                    (void)XMapWindow(display, window);
+                }
+
+                break;
+            }
+            case Visibility::Maximize:
+            {
+                if (mapped)
+                    changeNetWmState(true, atoms.netWmStateMaximizedVert, atoms.netWmStateMaximizedHorz);
+                else
+                {
+                    // Unmapped windows set their initial state through the property
+                    // directly, the window manager reads it when the window is mapped
+                    Atom states[] = { atoms.netWmStateMaximizedVert, atoms.netWmStateMaximizedHorz };
+
+                    (void)XChangeProperty(display, window, atoms.netWmState, XA_ATOM, 32, PropModeReplace,
+                                          reinterpret_cast<const unsigned char*>(states), 2);
+                }
+
+                (void)XMapRaised(display, window);
+                break;
+            }
+            default:
+                break;
+        }
+
+        (void)XFlush(display);
+
+        // The window manager applies the change asynchronously, the events it sends back
+        // will correct this if the request wasn't honored
+        g_windowData.visibility = visibility;
+    }
+
+
+
+    Graphics::Surface lockFramebuffer(FramebufferContents contents)
+    {
+        if (!isOpen())
+            throw nullWindowException;
+
+        Framebuffer& framebuffer = g_windowData.framebuffer;
+
+        if (framebuffer.locked)
+            throw std::logic_error("Framebuffer is already locked");
+
+        FramebufferBuffer&       buffer      = framebuffer.buffers[framebuffer.backBuffer];
+        const FramebufferBuffer& frontBuffer = framebuffer.buffers[framebuffer.backBuffer ^ 1];
+        bool                     reallocated = (buffer.size != g_windowData.size);
+
+        if (reallocated)
+            createFramebufferBuffer(buffer, g_windowData.size);
+        else
+            waitForFramebufferBuffer(buffer);
+
+        // The back buffer holds the frame before the last one, catch up by copying what
+        // the last present changed. A fresh buffer has to copy everything.
+        if (contents == FramebufferContents::Preserve && frontBuffer.size == buffer.size)
+        {
+            Graphics::DirtyRegion region = framebuffer.presentedRegion;
+
+            if (reallocated)
+            {
+                region.setBounds(buffer.size);
+                region.addAll();
+            }
+
+            Graphics::copyRegion(getFramebufferSurface(frontBuffer), getFramebufferSurface(buffer), region);
+        }
+
+        framebuffer.locked = true;
+
+        return getFramebufferSurface(buffer);
+    }
+
+
+
+    void presentFramebuffer()
+    {
+        Graphics::DirtyRegion dirtyRegion(g_windowData.framebuffer.buffers[g_windowData.framebuffer.backBuffer].size);
+        dirtyRegion.addAll();
+
+        presentFramebuffer(dirtyRegion);
+    }
+
+
+
+    void presentFramebuffer(const Graphics::DirtyRegion& dirtyRegion)
+    {
+        Framebuffer& framebuffer = g_windowData.framebuffer;
+
+        if (!framebuffer.locked)
+            throw std::logic_error("Framebuffer is not locked");
+
+        framebuffer.locked = false;
+
+        FramebufferBuffer& buffer = framebuffer.buffers[framebuffer.backBuffer];
+
+        // Re-adding clips the rectangles to the buffer in case the region's bounds differ
+        framebuffer.presentedRegion.setBounds(buffer.size);
+
+        for (Graphics::Rect rect : dirtyRegion.getRects())
+            framebuffer.presentedRegion.add(rect);
+
+        for (Graphics::Rect rect : framebuffer.presentedRegion.getRects())
+            putFramebufferRect(buffer, rect);
+
+        (void)XFlush(g_windowData.display);
+
+        framebuffer.backBuffer ^= 1;
+    }
+}
 
 #endif // ^^^ Linux ^^^
 // OS-specific implementation
\ No newline at end of file
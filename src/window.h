@@ -6,6 +6,8 @@
 #define CEDAR_WINDOW_H
 
 #include "callback.h"
+#include "graphics/dirty_region.h"
+#include "graphics/surface.h"
 #include "input.h"
 #include "math.h"
 
@@ -52,6 +54,11 @@ namespace Cedar::Window
         Maximize
     };
 
+    enum class FramebufferContents {
+        Preserve, // The back buffer holds the last presented frame
+        Discard   // The back buffer's contents are undefined, the whole frame will be redrawn
+    };
+
 
 
     typedef void (*ClosedFunc)();
@@ -214,6 +221,34 @@ namespace Cedar::Window
     void setVisibility(Visibility visibility);
 
 
+    // The framebuffer is a pair of CPU pixel buffers shared with the OS (MIT-SHM images on
+    // Linux, DIB sections on Windows), so presenting never copies the pixels through the
+    // display server connection. One buffer is drawn into while the other is presented.
+    //
+    // Returns the back buffer to draw the next frame into, sized to the window's client
+    // area. Buffers are only reallocated here, when the window size no longer matches, so
+    // any number of resize events between two frames costs a single reallocation.
+    //
+    // With FramebufferContents::Preserve the back buffer is brought up to date with the
+    // last presented frame by copying over what that present changed, so only what
+    // changes in this frame has to be redrawn. The contents are still undefined on the
+    // first lock after the window size changed. Discard skips the copy, for frames that
+    // are redrawn entirely, and has to be followed by a full present.
+    //
+    // Throws std::logic_error if the window is not open or the framebuffer is already
+    // locked.
+    Graphics::Surface lockFramebuffer(FramebufferContents contents = FramebufferContents::Preserve);
+
+    // Presents the whole locked back buffer and swaps the buffers. Throws
+    // std::logic_error if the framebuffer isn't locked.
+    void presentFramebuffer();
+
+    // Presents only the damaged rectangles of the locked back buffer and swaps the
+    // buffers. The rest of the window keeps showing the previous frame. Throws
+    // std::logic_error if the framebuffer isn't locked.
+    void presentFramebuffer(const Graphics::DirtyRegion& dirtyRegion);
+
+
 
     // vvv OpenArgs function definitions vvv
 
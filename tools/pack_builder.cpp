@@ -0,0 +1,103 @@
+//
+// Entry point of the asset pack builder.
+//
+// Usage: cedar-pack [--alignment <bytes>] <output> <input>...
+//
+// Files are added under their file name and the files in directories under their path
+// relative to the directory, with '/' separators, so "textures/stone.png" names the same
+// asset on every platform. Assets are added in name order, so the same inputs always
+// make the same pack.
+//
+
+#include "../src/asset/asset_pack.h"
+#include "../src/io/log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        std::size_t                        alignment = Cedar::Asset::defaultPackAlignment;
+        std::vector<std::filesystem::path> paths;
+
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view arg = argv[i];
+
+            if (arg == "--alignment")
+            {
+                if (i + 1 >= argc)
+                {
+                    std::fprintf(stderr, "Missing value for argument \"%s\"\n", argv[i]);
+                    return EXIT_FAILURE;
+                }
+
+                alignment = std::stoull(argv[++i]);
+            }
+            else
+                paths.emplace_back(arg);
+        }
+
+        if (paths.size() < 2)
+        {
+            std::fprintf(stderr, "Usage: %s [--alignment <bytes>] <output> <input>...\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        // Name and path of every input file
+        std::vector<std::pair<std::string, std::filesystem::path>> files;
+
+        for (std::size_t i = 1; i < paths.size(); i++)
+        {
+            const std::filesystem::path& input = paths[i];
+
+            if (!std::filesystem::is_directory(input))
+            {
+                files.emplace_back(input.filename().generic_string(), input);
+                continue;
+            }
+
+            for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(input))
+            {
+                if (entry.is_regular_file())
+                    files.emplace_back(entry.path().lexically_relative(input).generic_string(), entry.path());
+            }
+        }
+
+        std::sort(files.begin(), files.end());
+
+        Cedar::Asset::AssetPackBuilder builder;
+        std::uintmax_t                 totalSize = 0;
+
+        for (const auto& [name, path] : files)
+        {
+            builder.addFile(name, path);
+            totalSize += std::filesystem::file_size(path);
+        }
+
+        builder.write(paths[0], alignment);
+
+        Cedar::Log::info(std::format("Packed {} asset(s), {} byte(s), into \"{}\" ({} bytes)", builder.getAssetCount(),
+                                     totalSize, paths[0].string(), std::filesystem::file_size(paths[0])));
+    }
+    catch (const std::exception& e) {
+        Cedar::Log::fatal(e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file